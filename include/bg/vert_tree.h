@@ -118,6 +118,25 @@ BG_EXPORT extern size_t bg_vert_tree_add_w_norm(struct bg_vert_tree *tree,
  */
 BG_EXPORT extern void bg_vert_tree_clean(struct bg_vert_tree *tree);
 
+/**
+ *@brief
+ *	Merge the vertices in verts (nverts xyz triples) that are within
+ *	tolerance of each other.
+ *
+ *	Vertices are considered in order.  A vertex is kept unless an
+ *	earlier kept vertex lies within sqrt(local_tol_sq) of it, in which
+ *	case it is merged into the first such vertex.  On return, map[i]
+ *	holds the index of the kept vertex that vertex i was merged into,
+ *	or i if it was kept.  map must have room for nverts entries.
+ *
+ *	The search uses a hash grid and runs in parallel; the result is
+ *	the same as a serial scan.  Returns the number of kept vertices.
+ */
+BG_EXPORT extern size_t bg_vert_weld(size_t *map,
+				     const fastf_t *verts,
+				     size_t nverts,
+				     fastf_t local_tol_sq);
+
 
 __END_DECLS
 
@@ -59,6 +59,11 @@ ON_Brep_CDT_Tol_Set(struct ON_Brep_CDT_State *s, const struct bg_tess_tol *t);
 extern BREP_EXPORT void
 ON_Brep_CDT_Tol_Get(struct bg_tess_tol *t, const struct ON_Brep_CDT_State *s);
 
+/* Set the number of threads used to tessellate, 0 (the default) to use
+ * all available.  The tessellation does not depend on this setting. */
+extern BREP_EXPORT void
+ON_Brep_CDT_Ncpus_Set(struct ON_Brep_CDT_State *s, int ncpus);
+
 /* Return the ON_Brep associated with state s. */
 extern BREP_EXPORT void *
 ON_Brep_CDT_Brep(struct ON_Brep_CDT_State *s);
@@ -159,9 +159,13 @@ BU_EXPORT extern void *bu_heap_get(size_t sz);
  * counterpart to bu_heap_get() for releasing fast heap-based memory
  * allocations.
  *
- * the implementation may do nothing, relying on free-on-exit, or may
- * mark deallocations for reuse.  pass a NULL pointer and zero size to
- * force compaction of any unused memory.
+ * released memory is kept on per-thread free lists for reuse by
+ * subsequent bu_heap_get() calls of the same size.  threads that
+ * accumulate more free memory than they reuse (e.g., when memory is
+ * allocated in one thread and released in another) return it in
+ * batches to a shared pool available to all threads.  memory is
+ * never returned to the system.  pass a NULL pointer to hand all of
+ * the calling thread's free memory over to the shared pool.
  */
 BU_EXPORT extern void bu_heap_put(void *ptr, size_t sz);
 
@@ -185,18 +189,76 @@ BU_EXPORT extern bu_heap_func_t bu_heap_log(bu_heap_func_t log);
 /**
  * Memory pools. To be used when you need to dynamically allocate
  * lots of small elements which will all be freed at the same time.
+ *
+ * Memory is handed out from a list of chunks of at least block_size
+ * bytes each.  Chunks are never moved, so pointers returned by
+ * bu_pool_alloc() remain valid until the pool is rewound, reset, or
+ * deleted.  Every allocation is aligned to BU_POOL_ALIGN bytes.
+ *
+ * Pools do no locking.  Threads should either use a pool of their
+ * own (e.g., one per bu_parallel_id()) or protect a shared pool.
  */
+#define BU_POOL_ALIGN 16
+
+struct bu_pool_chunk;
+
 struct bu_pool
 {
-    size_t block_size;
-    size_t block_pos, alloc_size;
-    uint8_t *block;
+    size_t block_size;		/**< minimum size of each chunk */
+    size_t block_pos, alloc_size;	/**< bytes used and available in current chunk */
+    uint8_t *block;		/**< current chunk memory */
+    struct bu_pool_chunk *chunk;	/**< current chunk, linked to earlier chunks */
+    size_t used;		/**< bytes used in all earlier chunks */
+};
+
+/**
+ * A position within a pool recorded by bu_pool_save().
+ */
+struct bu_pool_mark
+{
+    struct bu_pool_chunk *chunk;
+    size_t block_pos;
 };
 
 BU_EXPORT extern struct bu_pool *bu_pool_create(size_t block_size);
 
+/**
+ * Allocate nelem*elsize bytes from the pool.  The memory is not
+ * initialized.
+ */
 BU_EXPORT extern void *bu_pool_alloc(struct bu_pool *pool, size_t nelem, size_t elsize);
 
+/**
+ * Record the current allocation position of a pool.
+ */
+BU_EXPORT extern void bu_pool_save(const struct bu_pool *pool, struct bu_pool_mark *mark);
+
+/**
+ * Release everything allocated from the pool since 'mark' was
+ * recorded with bu_pool_save().  Marks recorded after 'mark' become
+ * invalid.
+ */
+BU_EXPORT extern void bu_pool_rewind(struct bu_pool *pool, const struct bu_pool_mark *mark);
+
+/**
+ * Release everything allocated from the pool.  The first chunk is
+ * kept for reuse.
+ */
+BU_EXPORT extern void bu_pool_reset(struct bu_pool *pool);
+
+/**
+ * Returns the number of bytes bu_pool_copy() will write, i.e., the
+ * size of all allocations in order including alignment padding.  The
+ * value before an allocation is that allocation's offset in the copy.
+ */
+BU_EXPORT extern size_t bu_pool_used(const struct bu_pool *pool);
+
+/**
+ * Copy all allocations into the contiguous buffer 'dest' of at least
+ * bu_pool_used() bytes, preserving their offsets.
+ */
+BU_EXPORT extern void bu_pool_copy(const struct bu_pool *pool, void *dest);
+
 BU_EXPORT extern void bu_pool_delete(struct bu_pool *pool);
 
 
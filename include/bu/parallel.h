@@ -145,6 +145,13 @@ BU_EXPORT extern size_t bu_avail_cpus(void);
  * This function will not return control until all invocations of the
  * subroutine are finished.
  *
+ * Where supported, the threads come from a persistent pool that is
+ * created on first use and grown as needed, so repeated calls do not
+ * pay for thread creation.  Every invocation still gets a thread of
+ * its own, including in nested calls.  Setting the environment
+ * variable LIBBU_THREAD_POOL=0 creates and joins fresh threads on
+ * every call instead.
+ *
  * In following is a working stand-alone example demonstrating how to
  * call the bu_parallel() interface.
  *
@@ -184,6 +191,40 @@ BU_EXPORT extern size_t bu_avail_cpus(void);
 BU_EXPORT extern void bu_parallel(void (*func)(int func_cpu_id, void *func_data), size_t ncpu, void *data);
 
 
+/**
+ * Opaque handle for a set of tasks run on the bu_parallel() thread
+ * pool.
+ */
+struct bu_task_group;
+
+/**
+ * Create an empty task group.  Release with bu_task_group_destroy().
+ */
+BU_EXPORT extern struct bu_task_group *bu_task_group_create(void);
+
+/**
+ * Queue 'func' to be called with 'data' on a pooled thread.  The
+ * callback receives its bu_parallel_id() number just like a
+ * bu_parallel() callback.  Tasks from all groups share at most
+ * bu_avail_cpus() threads, so unlike bu_parallel() a task must not
+ * wait on another task to make progress.  Tasks may themselves call
+ * bu_parallel() or submit and wait on other groups.
+ */
+BU_EXPORT extern void bu_task_submit(struct bu_task_group *group, void (*func)(int func_cpu_id, void *func_data), void *data);
+
+/**
+ * Wait until every task submitted to 'group' has finished.  The
+ * calling thread runs queued tasks of the group itself while it
+ * waits.  The group may be reused afterwards.
+ */
+BU_EXPORT extern void bu_task_wait(struct bu_task_group *group);
+
+/**
+ * Wait for any outstanding tasks, then release the group.
+ */
+BU_EXPORT extern void bu_task_group_destroy(struct bu_task_group *group);
+
+
 /**
  * @brief
  * semaphore implementation
@@ -114,6 +114,24 @@ bv_mesh_lod_clear_cache(struct bv_mesh_lod_context *c, unsigned long long key);
 BV_EXPORT unsigned long long
 bv_mesh_lod_cache(struct bv_mesh_lod_context *c, const point_t *v, size_t vcnt, const vect_t *vn, int *f, size_t fcnt, unsigned long long user_key, fastf_t fratio);
 
+/**
+ * Background version of bv_mesh_lod_cache.  Rather than generating the LoD
+ * data immediately, queue the work on the context's worker threads.  Work
+ * with a higher priority is done first.  When the data is ready, the resulting
+ * key is associated with name (as with bv_mesh_lod_key_put) and done is
+ * called with the key (zero if the LoD data could not be generated) and
+ * cb_data.  The input arrays must remain valid until done is called, which
+ * is where the caller should release them.
+ *
+ * done is called from a worker thread, or from bv_mesh_lod_context_destroy
+ * with a zero key if the context is destroyed before the work is done.
+ *
+ * Returns 1 if the work was queued, 0 if work for name is already queued (in
+ * which case done will NOT be called for this request) and -1 on error.
+ */
+BV_EXPORT int
+bv_mesh_lod_cache_bg(struct bv_mesh_lod_context *c, const char *name, const point_t *v, size_t vcnt, const vect_t *vn, int *f, size_t fcnt, fastf_t fratio, int priority, void (*done)(unsigned long long, void *), void *cb_data);
+
 
 /**
  * Given a name, see if the context has a key associated with that name.
@@ -184,11 +202,28 @@ bv_mesh_lod_memshrink(struct bv_scene_obj *s);
  * Set reset == 1 if the caller wants to undo a memshrink operation even if the
  * level isn't changed by the current view settings.
  *
- * Returns the level selected.  If v == NULL, return current level of l.  If
- * there is an error or l == NULL, return -1; */
+ * The level is normally loaded immediately.  Once the object has been drawn
+ * (see bv_mesh_lod_sync), if a ready callback has been set with
+ * bv_mesh_lod_ready_clbk and the view calls for a finer level than is
+ * currently loaded, the data is instead read in by the context's worker
+ * threads and the current level is kept until it is ready.
+ *
+ * Returns the level currently loaded.  If there is an error or l == NULL,
+ * return -1; */
 BV_EXPORT int
 bv_mesh_lod_view(struct bv_scene_obj *s, struct bview *v, int reset);
 
+/**
+ * Given a scene object with mesh LoD data stored in s->draw_data, switch to
+ * any level data a worker thread has finished reading in for it since the
+ * last bv_mesh_lod_view call.  Drawing code should call this before drawing
+ * the object.
+ *
+ * Returns 1 if the data changed (the object's display list is marked stale),
+ * 0 if it did not, and -1 on error. */
+BV_EXPORT int
+bv_mesh_lod_sync(struct bv_scene_obj *s);
+
 /**
  * Given a scene object with mesh LoD data stored in s->draw_data and a detail
  * level, load the appropriate data.  This is not normally used by client codes
@@ -221,6 +256,15 @@ bv_mesh_lod_detail_clear_clbk(struct bv_mesh_lod *lod, int (*clbk)(struct bv_mes
 BV_EXPORT void
 bv_mesh_lod_detail_free_clbk(struct bv_mesh_lod *lod, int (*clbk)(struct bv_mesh_lod *, void *));
 
+/* Set a function to be called when level data a worker thread was reading in
+ * for the LoD is ready, so the application can schedule a redraw (which will
+ * pick the data up via bv_mesh_lod_sync).  The callback is run from the
+ * worker thread and must not call back into the LoD routines.  Finer levels
+ * are only read in the background while a callback is set - pass a NULL
+ * clbk to go back to loading them immediately. */
+BV_EXPORT void
+bv_mesh_lod_ready_clbk(struct bv_mesh_lod *lod, void (*clbk)(struct bv_mesh_lod *, void *), void *cb_data);
+
 __END_DECLS
 
 #endif  /* BV_LOD_H */
@@ -494,6 +494,31 @@ RT_EXPORT extern int db_get_external(struct bu_external *ep,
 				     const struct directory *dp,
 				     const struct db_i *dbip);
 
+/**
+ * Like db_get_external(), but when the database is a memory-mapped
+ * read-only file 'ep' is set up as a view directly into the mapping
+ * rather than as a copy.  Otherwise the object is copied as
+ * db_get_external() does.
+ *
+ * The view must not be modified and is only valid while 'dbip' is
+ * open.  Either way, the caller releases it with
+ * db_free_external_view(), never bu_free_external().
+ *
+ * Returns -
+ * -1 error
+ * 0 success
+ */
+RT_EXPORT extern int db_get_external_view(struct bu_external *ep,
+					  const struct directory *dp,
+					  const struct db_i *dbip);
+
+/**
+ * Release an external obtained with db_get_external_view(), freeing
+ * it only if it is a copy.
+ */
+RT_EXPORT extern void db_free_external_view(struct bu_external *ep,
+					    const struct db_i *dbip);
+
 /**
  * Given that caller already has an external representation of the
  * database object, update it to have a new name (taken from
@@ -65,6 +65,42 @@ RT_EXPORT extern int re_prep_solids(struct rt_i *rtip,
 				    char **solid_names,
 				    struct resource *resp);
 
+/**
+ * Opaque record of the database changes made since a prepped rt_i was
+ * last brought up to date.
+ */
+struct rt_reprep_tracker;
+
+/**
+ * Start recording changes to rtip's database, using the
+ * db_add_changed_clbk() mechanism.  topobjs must name the objects
+ * that were originally passed to rt_gettrees() for rtip.  Returns
+ * NULL on error.  Release with rt_reprep_untrack().
+ */
+RT_EXPORT extern struct rt_reprep_tracker *rt_reprep_track(struct rt_i *rtip,
+							   size_t ntopobjs,
+							   const char **topobjs);
+
+/**
+ * Bring the prepped rt_i up to date with the changes recorded by trk,
+ * then clear them.  Modified primitives are unprepped and re-prepped
+ * in place with rt_unprep()/rt_reprep(), which only touches their
+ * soltabs and the space partition cells holding them.  Changes that
+ * cannot be handled this way (an edited or removed combination used by
+ * the model, a removed primitive that is prepped, or an edited object
+ * referenced by a primitive such as a sketch) are not applied.
+ *
+ * Returns 0 when rtip is current, 1 when the caller must rt_clean()
+ * and prep again from scratch.
+ */
+RT_EXPORT extern int rt_reprep_changed(struct rt_reprep_tracker *trk,
+				       struct resource *resp);
+
+/**
+ * Stop recording changes and release trk.
+ */
+RT_EXPORT extern void rt_reprep_untrack(struct rt_reprep_tracker *trk);
+
 
 __END_DECLS
 
@@ -111,6 +111,12 @@ struct rt_i {
     size_t              rti_ncut_by_type[CUT_MAXIMUM+1];        /**< @brief  number of cuts by type */
     size_t              rti_cut_totobj; /**< @brief  # objs in all bins, total */
     size_t              rti_cut_maxdepth; /**< @brief  max depth of cut tree */
+    struct bvh_flat_node *rti_bvh_nodes;  /**< @brief  flattened HLBVH over finite solids (RT_PART_HLBVH) */
+    struct soltab **    rti_bvh_solids; /**< @brief  finite solids, in HLBVH leaf order */
+    size_t              rti_bvh_nsolids; /**< @brief  # solids in rti_bvh_solids */
+    size_t              rti_bvh_nnodes; /**< @brief  # nodes in rti_bvh_nodes */
+    size_t              rti_bvh_nrefit; /**< @brief  # solids put in freed HLBVH slots since the last build */
+    struct rt_inst_tbl *rti_inst_tbl;   /**< @brief  preps shared by transformed instances */
     struct soltab **    rti_sol_by_type[ID_MAX_SOLID+1];
     size_t              rti_nsol_by_type[ID_MAX_SOLID+1];
     size_t              rti_maxsol_by_type;
@@ -142,6 +142,29 @@ RT_EXPORT extern struct partition *rt_shootray_simple(struct application *ap,
  */
 RT_EXPORT extern int rt_shootray_bundle(struct application *ap, struct xray *rays, int nrays);
 
+/**
+ * PRIVATE: this is new API and should be considered private for the
+ * time being.
+ *
+ * Shoot a batch of rays, one per element of the 'ap' array, calling
+ * each application's a_hit() or a_miss() routine in array order just
+ * as rt_shootray() would.  Instead of walking the space partitioning
+ * tree ray by ray, the tree is walked once for each packet of
+ * neighboring rays, and each primitive type is then intersected with
+ * all of the packet's rays passing through its solids' bounding boxes
+ * at once, using the type's vectorized ft_vshot routine where
+ * available.  This suits coherent rays, such as those of a grid, shot
+ * many at a time.
+ *
+ * All applications of a batch must share the same a_rt_i and
+ * a_resource.  As with rt_shootray(), solids lying entirely beyond
+ * a_ray_length are not intersected.  Solids using "pieces" are
+ * intersected whole.
+ *
+ * Returns the number of rays that hit.
+ */
+RT_EXPORT extern int rt_vshootray(struct application *ap, size_t nrays);
+
 /**
  * To be called only in non-parallel mode, to tally up the statistics
  * from the resource structure(s) into the rt instance structure.
@@ -166,6 +189,11 @@ RT_EXPORT extern void rt_res_pieces_clean(struct resource *resp,
  */
 RT_EXPORT extern void rt_res_pieces_init(struct resource *resp,
 					 struct rt_i *rtip);
+/**
+ * Generic ft_vshot implementation calling the scalar ft_shot routine
+ * of each ray/solid pair.  Only the first segment of each pair is
+ * returned.
+ */
 RT_EXPORT extern void rt_vstub(struct soltab *stp[],
 			       struct xray *rp[],
 			       struct seg segp[],
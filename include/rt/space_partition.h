@@ -35,6 +35,7 @@
 __BEGIN_DECLS
 
 struct rt_piecelist;  /* forward declaration */
+struct bvh_flat_node; /* forward declaration, private to librt */
 
 /**
  * Structures for space subdivision.
@@ -128,6 +129,20 @@ RT_EXPORT extern const union cutter *rt_cell_n_on_ray(struct application *ap,
  */
 RT_EXPORT extern void rt_cut_clean(struct rt_i *rtip);
 
+/**
+ * (Re)build the scene-level HLBVH used by the RT_PART_HLBVH space
+ * partitioning method over all finite, successfully prepped solids.
+ * Any previously built hierarchy is released first.  This is a no-op
+ * for other partitioning methods.
+ */
+RT_EXPORT extern void rt_cut_bvh(struct rt_i *rtip);
+
+/**
+ * Release the scene-level HLBVH, if any.  Rays fall back to shooting
+ * every solid in rti_CutHead until rt_cut_bvh() is called again.
+ */
+RT_EXPORT extern void rt_cut_bvh_free(struct rt_i *rtip);
+
 
 #ifdef USE_OPENCL
 struct clt_bvh_bounds {
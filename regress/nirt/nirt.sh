@@ -575,6 +575,50 @@ EOF
 run cmp nirt.ref nirt.out
 STATUS=$?
 
+log "*** Test 12 - batch command ***"
+rm -f nirt_batch.rays nirt_batch.ref nirt_batch.out nirt_batch.1 nirt_batch.4 nirt_batch.u
+cat > nirt_batch.rays <<EOF
+# x y z dx dy dz
+5 0 0 -1 0 0
+0 0 5 0 0 -1
+
+0 5 0 0 1 0
+-5 0.5 0.5 1 0 0
+EOF
+cat > nirt_batch.ref <<EOF
+0 1003 2.0000 4.0000 0.0000 0.0000 1 right_cube.r
+0 1000 4.0000 6.0000 0.0000 0.0000 1 center_cube.r
+0 1002 6.0000 8.0000 0.0000 0.0000 1 left_cube.r
+1 1000 4.0000 6.0000 0.0000 0.0000 1 center_cube.r
+3 1002 2.0000 4.0000 0.0000 0.0000 1 left_cube.r
+3 1000 4.0000 6.0000 0.0000 0.0000 1 center_cube.r
+3 1003 6.0000 8.0000 0.0000 0.0000 1 right_cube.r
+EOF
+run $NIRT -H 0 -e "batch -P 2 -o nirt_batch.out nirt_batch.rays;q" nirt.g left_cube.r center_cube.r right_cube.r
+awk '{printf "%s %s %.4f %.4f %.4f %.4f %s %s\n", $1, $2, $3, $4, $5, $6, $7, $8}' nirt_batch.out > nirt_batch.1
+run cmp nirt_batch.ref nirt_batch.1
+
+# enough rays for every thread to get several chunks, the results
+# must not depend on the number of threads or on -u
+awk 'BEGIN {
+    for (i = 0; i < 40; i++)
+	for (j = 0; j < 40; j++) {
+	    printf "-5 %g %g 1 0 0\n", -1.5 + 0.075 * i + 0.01, -1.5 + 0.075 * j + 0.01
+	    printf "%g 5 %g -0.3 -1 0.2\n", -3.5 + 0.175 * i + 0.01, -1.5 + 0.075 * j + 0.01
+	}
+}' > nirt_batch.rays
+run $NIRT -H 0 -e "batch -P 1 -o nirt_batch.1 nirt_batch.rays;q" nirt.g left_cube.r center_cube.r right_cube.r
+run $NIRT -H 0 -e "batch -P 4 -o nirt_batch.4 nirt_batch.rays;q" nirt.g left_cube.r center_cube.r right_cube.r
+run $NIRT -H 0 -e "batch -P 4 -u -o nirt_batch.out nirt_batch.rays;q" nirt.g left_cube.r center_cube.r right_cube.r
+sort -s -n -k1,1 nirt_batch.out > nirt_batch.u
+run cmp nirt_batch.1 nirt_batch.4
+run cmp nirt_batch.1 nirt_batch.u
+if test ! -s nirt_batch.1 ; then
+    log "batch found no hits"
+    STATUS="`expr $STATUS + 1`"
+fi
+rm -f nirt_batch.rays nirt_batch.ref nirt_batch.out nirt_batch.1 nirt_batch.4 nirt_batch.u
+
 if [ X$STATUS = X0 ] ; then
     log "-> nirt.sh succeeded"
 else
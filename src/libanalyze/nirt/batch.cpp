@@ -0,0 +1,546 @@
+/*                       B A T C H . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file batch.cpp
+ *
+ * Implementation of Natalie's Interactive Ray-Tracer (NIRT)
+ * functionality specific to the batch subcommand.
+ *
+ */
+
+/* BRL-CAD includes */
+#include "common.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+
+#include "bu/cmd.h"
+#include "bu/cv.h"
+#include "bu/opt.h"
+#include "bu/parallel.h"
+
+#include "./nirt.h"
+
+
+/**
+ * The batch command shoots a list of rays read from a file (or stdin)
+ * across all available cores.  Each input line holds a ray origin and
+ * direction, "x y z dx dy dz", in the current local units.  Blank lines
+ * and lines starting with '#' are ignored.
+ *
+ * Unlike the "s" command, batch does not go through the fmt machinery:
+ * every thread has its own application and resource, and encodes its
+ * hits straight into a private buffer with a fixed layout.  By default
+ * the buffers are written in input order after each block of rays;
+ * with -u each thread writes its rays as soon as they are done.
+ *
+ * Text output is one line per partition:
+ *
+ *    ray reg_id d_in d_out obliq_in obliq_out claimants reg_name
+ *
+ * where ray is the zero based index of the input ray, distances are
+ * measured along the ray from its input origin in local units and
+ * obliquities are in degrees.  Misses produce no lines.
+ *
+ * Binary output (-b, requires -o) is big-endian throughout:
+ *
+ *    header:     "NIRTBIN1", double base2local, uint32 nregions,
+ *                then for each region (indexed by reg_bit):
+ *                int32 reg_id, uint32 name length, name bytes
+ *    per ray:    uint64 ray, uint32 npartitions
+ *    per part:   uint32 reg_bit, uint32 claimants,
+ *                double d_in, d_out, obliq_in, obliq_out
+ *
+ * Misses are written with npartitions set to zero so that every input
+ * ray has a record.
+ */
+
+#define NIRT_BATCH_MAGIC "NIRTBIN1"
+#define NIRT_BATCH_BLOCK 16384	/* rays read and shot per pass */
+#define NIRT_BATCH_CHUNK 64	/* rays claimed by a thread at a time */
+
+
+struct nirt_batch_ray {
+    point_t pt;
+    vect_t dir;
+};
+
+
+struct nirt_batch_state;
+
+struct nirt_batch_thread {
+    struct nirt_batch_state *bs;
+    struct application ap;
+    size_t ray;		/* index of the ray in the current block */
+    fastf_t bov;	/* backout applied to the current ray */
+    std::vector<unsigned char> buf;
+};
+
+
+struct nirt_batch_state {
+    struct nirt_state *nss;
+    struct rt_i *rtip;
+    struct resource *res;
+    int binary;
+    int unordered;
+    FILE *fp;
+    int sem_write;
+
+    size_t nthreads;
+    struct nirt_batch_thread *threads;
+
+    /* current block */
+    std::vector<struct nirt_batch_ray> rays;
+    size_t first;	/* input index of rays[0] */
+    size_t next;	/* next ray to be claimed */
+    size_t slots;	/* thread slots claimed */
+
+    /* where each ray's record ended up, for ordered output */
+    std::vector<size_t> owner;
+    std::vector<size_t> off;
+    std::vector<size_t> len;
+};
+
+
+static void
+_nirt_batch_put_u32(std::vector<unsigned char> &b, uint32_t v)
+{
+    b.push_back((unsigned char)(v >> 24));
+    b.push_back((unsigned char)(v >> 16));
+    b.push_back((unsigned char)(v >> 8));
+    b.push_back((unsigned char)v);
+}
+
+
+static void
+_nirt_batch_put_u64(std::vector<unsigned char> &b, uint64_t v)
+{
+    _nirt_batch_put_u32(b, (uint32_t)(v >> 32));
+    _nirt_batch_put_u32(b, (uint32_t)v);
+}
+
+
+static void
+_nirt_batch_put_dbl(std::vector<unsigned char> &b, double v)
+{
+    unsigned char net[8];
+    bu_cv_htond(net, (const unsigned char *)&v, 1);
+    b.insert(b.end(), net, net + 8);
+}
+
+
+static void
+_nirt_batch_put_str(std::vector<unsigned char> &b, const char *s)
+{
+    b.insert(b.end(), (const unsigned char *)s, (const unsigned char *)s + strlen(s));
+}
+
+
+static void
+_nirt_batch_write(struct nirt_batch_state *bs, const unsigned char *data, size_t len)
+{
+    if (!len)
+	return;
+
+    if (bs->fp) {
+	if (fwrite(data, 1, len, bs->fp) != len)
+	    nerr(bs->nss, "Error: batch output write failed\n");
+	return;
+    }
+
+    nout(bs->nss, "%.*s", (int)len, (const char *)data);
+}
+
+
+static int
+_nirt_batch_hit(struct application *ap, struct partition *part_head, struct seg *UNUSED(finished_segs))
+{
+    struct nirt_batch_thread *t = (struct nirt_batch_thread *)ap->a_uptr;
+    struct nirt_batch_state *bs = t->bs;
+    struct nirt_state *nss = bs->nss;
+    double b2l = nss->i->base2local;
+    size_t ray = bs->first + t->ray;
+    struct partition *part;
+    uint32_t npart = 0;
+    char line[256];
+
+    if (nss->i->overlap_claims == NIRT_OVLP_REBUILD_FASTGEN) {
+	rt_rebuild_overlaps(part_head, ap, 1);
+    } else if (nss->i->overlap_claims == NIRT_OVLP_REBUILD_ALL) {
+	rt_rebuild_overlaps(part_head, ap, 0);
+    }
+
+    if (bs->binary) {
+	for (part = part_head->pt_forw; part != part_head; part = part->pt_forw)
+	    npart++;
+	_nirt_batch_put_u64(t->buf, (uint64_t)ray);
+	_nirt_batch_put_u32(t->buf, npart);
+    }
+
+    for (part = part_head->pt_forw; part != part_head; part = part->pt_forw) {
+	vect_t nm_in, nm_out;
+	uint32_t claimants = 1;
+
+	RT_HIT_NORMAL(nm_in, part->pt_inhit, part->pt_inseg->seg_stp,
+		&ap->a_ray, part->pt_inflip);
+	RT_HIT_NORMAL(nm_out, part->pt_outhit, part->pt_outseg->seg_stp,
+		&ap->a_ray, part->pt_outflip);
+
+	if (part->pt_overlap_reg) {
+	    struct region **rpp;
+	    claimants = 0;
+	    for (rpp = part->pt_overlap_reg; *rpp != REGION_NULL; ++rpp)
+		claimants++;
+	}
+
+	double d_in = (part->pt_inhit->hit_dist - t->bov) * b2l;
+	double d_out = (part->pt_outhit->hit_dist - t->bov) * b2l;
+	double obliq_in = _nirt_get_obliq(ap->a_ray.r_dir, nm_in);
+	double obliq_out = _nirt_get_obliq(ap->a_ray.r_dir, nm_out);
+
+	if (bs->binary) {
+	    _nirt_batch_put_u32(t->buf, (uint32_t)part->pt_regionp->reg_bit);
+	    _nirt_batch_put_u32(t->buf, claimants);
+	    _nirt_batch_put_dbl(t->buf, d_in);
+	    _nirt_batch_put_dbl(t->buf, d_out);
+	    _nirt_batch_put_dbl(t->buf, obliq_in);
+	    _nirt_batch_put_dbl(t->buf, obliq_out);
+	} else {
+	    snprintf(line, sizeof(line), "%zu %d %.17g %.17g %.17g %.17g %u ",
+		    ray, part->pt_regionp->reg_regionid, d_in, d_out,
+		    obliq_in, obliq_out, (unsigned int)claimants);
+	    _nirt_batch_put_str(t->buf, line);
+	    _nirt_batch_put_str(t->buf, part->pt_regionp->reg_name);
+	    t->buf.push_back('\n');
+	}
+    }
+
+    return 1;
+}
+
+
+static int
+_nirt_batch_miss(struct application *ap)
+{
+    struct nirt_batch_thread *t = (struct nirt_batch_thread *)ap->a_uptr;
+    struct nirt_batch_state *bs = t->bs;
+
+    if (bs->binary) {
+	_nirt_batch_put_u64(t->buf, (uint64_t)(bs->first + t->ray));
+	_nirt_batch_put_u32(t->buf, 0);
+    }
+
+    return 0;
+}
+
+
+static void
+_nirt_batch_worker(int UNUSED(cpu), void *data)
+{
+    struct nirt_batch_state *bs = (struct nirt_batch_state *)data;
+    struct nirt_batch_thread *t;
+    size_t slot, start, end, i;
+
+    /* bu_parallel() ids are not guaranteed to be dense, so claim a slot */
+    bu_semaphore_acquire(BU_SEM_GENERAL);
+    slot = bs->slots++;
+    bu_semaphore_release(BU_SEM_GENERAL);
+    if (slot >= bs->nthreads)
+	return;
+    t = &bs->threads[slot];
+
+    while (1) {
+	bu_semaphore_acquire(BU_SEM_GENERAL);
+	start = bs->next;
+	end = start + NIRT_BATCH_CHUNK;
+	if (end > bs->rays.size())
+	    end = bs->rays.size();
+	bs->next = end;
+	bu_semaphore_release(BU_SEM_GENERAL);
+
+	if (start >= end)
+	    break;
+
+	for (i = start; i < end; i++) {
+	    struct nirt_batch_ray *r = &bs->rays[i];
+	    size_t off = t->buf.size();
+
+	    t->ray = i;
+	    t->bov = 0.0;
+	    if (bs->nss->i->backout)
+		t->bov = _nirt_backout_dist(bs->rtip, r->pt, r->dir);
+	    VJOIN1(t->ap.a_ray.r_pt, r->pt, -t->bov, r->dir);
+	    VMOVE(t->ap.a_ray.r_dir, r->dir);
+
+	    (void)rt_shootray(&t->ap);
+
+	    if (!bs->unordered) {
+		bs->owner[i] = slot;
+		bs->off[i] = off;
+		bs->len[i] = t->buf.size() - off;
+	    }
+	}
+
+	if (bs->unordered) {
+	    bu_semaphore_acquire(bs->sem_write);
+	    _nirt_batch_write(bs, t->buf.data(), t->buf.size());
+	    bu_semaphore_release(bs->sem_write);
+	    t->buf.clear();
+	}
+    }
+}
+
+
+/* Read up to NIRT_BATCH_BLOCK rays, returns the number read */
+static size_t
+_nirt_batch_read(struct nirt_batch_state *bs, FILE *in, size_t *lineno)
+{
+    char line[1024];
+
+    bs->rays.clear();
+    while (bs->rays.size() < NIRT_BATCH_BLOCK && bu_fgets(line, sizeof(line), in)) {
+	struct nirt_batch_ray r;
+	double v[6];
+	char *p = line;
+	char *endp = NULL;
+	int i;
+
+	(*lineno)++;
+	while (*p == ' ' || *p == '\t')
+	    p++;
+	if (*p == '#' || *p == '\n' || *p == '\r' || *p == '\0')
+	    continue;
+
+	for (i = 0; i < 6; i++) {
+	    errno = 0;
+	    v[i] = strtod(p, &endp);
+	    if (endp == p || errno)
+		break;
+	    p = endp;
+	}
+	if (i < 6) {
+	    nerr(bs->nss, "batch: skipping malformed ray on line %zu\n", *lineno);
+	    continue;
+	}
+
+	VSET(r.pt, v[0], v[1], v[2]);
+	VSCALE(r.pt, r.pt, bs->nss->i->local2base);
+	VSET(r.dir, v[3], v[4], v[5]);
+	if (MAGSQ(r.dir) < SMALL_FASTF) {
+	    nerr(bs->nss, "batch: skipping ray with zero direction on line %zu\n", *lineno);
+	    continue;
+	}
+	VUNITIZE(r.dir);
+
+	bs->rays.push_back(r);
+    }
+
+    return bs->rays.size();
+}
+
+
+static void
+_nirt_batch_header(struct nirt_batch_state *bs)
+{
+    std::vector<unsigned char> h;
+    size_t i;
+
+    if (!bs->binary) {
+	const char *hdr = "# ray reg_id d_in d_out obliq_in obliq_out claimants reg_name\n";
+	_nirt_batch_write(bs, (const unsigned char *)hdr, strlen(hdr));
+	return;
+    }
+
+    _nirt_batch_put_str(h, NIRT_BATCH_MAGIC);
+    _nirt_batch_put_dbl(h, bs->nss->i->base2local);
+    _nirt_batch_put_u32(h, (uint32_t)bs->rtip->nregions);
+    for (i = 0; i < bs->rtip->nregions; i++) {
+	struct region *regp = bs->rtip->Regions[i];
+	const char *name = (regp && regp->reg_name) ? regp->reg_name : "";
+	_nirt_batch_put_u32(h, (uint32_t)(regp ? regp->reg_regionid : 0));
+	_nirt_batch_put_u32(h, (uint32_t)strlen(name));
+	_nirt_batch_put_str(h, name);
+    }
+    _nirt_batch_write(bs, h.data(), h.size());
+}
+
+
+extern "C" int
+_nirt_cmd_batch(void *ns, int argc, const char *argv[])
+{
+    struct nirt_state *nss = (struct nirt_state *)ns;
+    if (!ns || !nss->i->ap) return -1;
+
+    int ac = 0;
+    int print_help = 0;
+    int binary = 0;
+    int unordered = 0;
+    int ncpu = 0;
+    struct bu_vls ofile = BU_VLS_INIT_ZERO;
+    struct bu_vls optparse_msg = BU_VLS_INIT_ZERO;
+    struct bu_opt_desc d[6];
+    BU_OPT(d[0],  "h", "help",      "",     NULL,        &print_help, "print help and exit");
+    BU_OPT(d[1],  "o", "output",    "file", &bu_opt_vls, &ofile,      "write results to file instead of the nirt output");
+    BU_OPT(d[2],  "b", "binary",    "",     NULL,        &binary,     "write binary records (requires -o)");
+    BU_OPT(d[3],  "u", "unordered", "",     NULL,        &unordered,  "write rays as they complete rather than in input order");
+    BU_OPT(d[4],  "P", "ncpu",      "#",    &bu_opt_int, &ncpu,       "number of threads to use (default all)");
+    BU_OPT_NULL(d[5]);
+    const char *ustr = "Usage: batch [opts] rayfile|-\nShoots the rays listed in rayfile (or read from stdin), one \"x y z dx dy dz\" per line.\nOptions:";
+
+    argv++; argc--;
+
+    if ((ac = bu_opt_parse(&optparse_msg, argc, (const char **)argv, d)) == -1) {
+	char *help = bu_opt_describe(d, NULL);
+	nerr(nss, "Error: bu_opt value read failure: %s\n\n%s\n%s\n", bu_vls_cstr(&optparse_msg), ustr, help);
+	if (help) bu_free(help, "help str");
+	bu_vls_free(&optparse_msg);
+	bu_vls_free(&ofile);
+	return -1;
+    }
+    bu_vls_free(&optparse_msg);
+
+    if (print_help || ac != 1 || (binary && !bu_vls_strlen(&ofile))) {
+	char *help = bu_opt_describe(d, NULL);
+	nerr(nss, "%s\n%s", ustr, help);
+	if (help) bu_free(help, "help str");
+	bu_vls_free(&ofile);
+	return -1;
+    }
+
+    /* If we have no active rtip, there is nothing to shoot at */
+    if (!_nirt_get_rtip(nss)) {
+	bu_vls_free(&ofile);
+	return 0;
+    }
+    if (nss->i->need_reprep) {
+	if (_nirt_raytrace_prep(nss)) {
+	    nerr(nss, "Error: raytrace prep failed!\n");
+	    bu_vls_free(&ofile);
+	    return -1;
+	}
+    }
+
+    FILE *in = stdin;
+    if (!BU_STR_EQUAL(argv[0], "-")) {
+	in = fopen(argv[0], "rb");
+	if (!in) {
+	    nerr(nss, "Error: unable to open ray file %s\n", argv[0]);
+	    bu_vls_free(&ofile);
+	    return -1;
+	}
+    }
+
+    struct nirt_batch_state bs;
+    bs.nss = nss;
+    bs.rtip = _nirt_get_rtip(nss);
+    bs.binary = binary;
+    bs.unordered = unordered;
+    bs.fp = NULL;
+    bs.sem_write = bu_semaphore_register("nirt_batch_sem_write");
+    bs.first = 0;
+
+    if (bu_vls_strlen(&ofile)) {
+	bs.fp = fopen(bu_vls_cstr(&ofile), binary ? "wb" : "w");
+	if (!bs.fp) {
+	    nerr(nss, "Error: unable to open output file %s\n", bu_vls_cstr(&ofile));
+	    if (in != stdin) fclose(in);
+	    bu_vls_free(&ofile);
+	    return -1;
+	}
+    }
+    bu_vls_free(&ofile);
+
+    /* Slot 0 of the rtip's resources belongs to the interactive shots */
+    bs.nthreads = (ncpu > 0) ? (size_t)ncpu : bu_avail_cpus();
+    if (bs.nthreads > MAX_PSW - 1)
+	bs.nthreads = MAX_PSW - 1;
+    bs.res = (struct resource *)bu_calloc(bs.nthreads, sizeof(struct resource), "batch resources");
+    bs.threads = new struct nirt_batch_thread[bs.nthreads];
+    for (size_t i = 0; i < bs.nthreads; i++) {
+	struct nirt_batch_thread *t = &bs.threads[i];
+	rt_init_resource(&bs.res[i], (int)i + 1, bs.rtip);
+	t->bs = &bs;
+	RT_APPLICATION_INIT(&t->ap);
+	t->ap.a_rt_i = bs.rtip;
+	t->ap.a_resource = &bs.res[i];
+	t->ap.a_hit = _nirt_batch_hit;
+	t->ap.a_miss = _nirt_batch_miss;
+	t->ap.a_logoverlap = rt_silent_logoverlap;
+	t->ap.a_onehit = 0;
+	t->ap.a_purpose = "NIRT batch ray";
+	t->ap.a_uptr = (void *)t;
+    }
+
+    _nirt_batch_header(&bs);
+
+    std::vector<unsigned char> block;
+    size_t lineno = 0;
+    size_t nrays;
+    while ((nrays = _nirt_batch_read(&bs, in, &lineno)) > 0) {
+	bs.next = 0;
+	bs.slots = 0;
+	if (!bs.unordered) {
+	    bs.owner.resize(nrays);
+	    bs.off.resize(nrays);
+	    bs.len.resize(nrays);
+	}
+
+	bu_parallel(_nirt_batch_worker, bs.nthreads, &bs);
+
+	if (!bs.unordered) {
+	    /* stitch the per-thread records back into input order */
+	    block.clear();
+	    for (size_t i = 0; i < nrays; i++) {
+		const unsigned char *rec = bs.threads[bs.owner[i]].buf.data() + bs.off[i];
+		block.insert(block.end(), rec, rec + bs.len[i]);
+	    }
+	    _nirt_batch_write(&bs, block.data(), block.size());
+	    for (size_t i = 0; i < bs.nthreads; i++)
+		bs.threads[i].buf.clear();
+	}
+
+	bs.first += nrays;
+    }
+
+    for (size_t i = 0; i < bs.nthreads; i++) {
+	rt_clean_resource_basic(bs.rtip, &bs.res[i]);
+	BU_PTBL_SET(&bs.rtip->rti_resources, i + 1, NULL);
+    }
+    delete[] bs.threads;
+    bu_free(bs.res, "batch resources");
+
+    if (bs.fp)
+	fclose(bs.fp);
+    if (in != stdin)
+	fclose(in);
+
+    return 0;
+}
+
+
+// Local Variables:
+// tab-width: 8
+// mode: C++
+// c-basic-offset: 4
+// indent-tabs-mode: t
+// c-file-style: "stroustrup"
+// End:
+// ex: shiftwidth=4 tabstop=8
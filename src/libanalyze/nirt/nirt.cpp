@@ -360,19 +360,14 @@ static void _nirt_ae2dir(struct nirt_state *nss)
 }
 
 
-static double _nirt_backout(struct nirt_state *nss)
+/* Distance to back the ray at pt along dir out of the model's bounding sphere */
+double
+_nirt_backout_dist(struct rt_i *rtip, const point_t pt, const vect_t dir)
 {
-    double bov;
-    point_t ray_point;
-    vect_t diag, dvec, ray_dir, center_bsphere;
+    vect_t diag, dvec, center_bsphere;
     fastf_t bsphere_diameter, dist_to_target, delta;
 
-    if (!nss || !nss->i->backout) return 0.0;
-
-    VMOVE(ray_point, nss->i->vals->orig);
-    VMOVE(ray_dir, nss->i->vals->dir);
-
-    VSUB2(diag, nss->i->ap->a_rt_i->mdl_max, nss->i->ap->a_rt_i->mdl_min);
+    VSUB2(diag, rtip->mdl_max, rtip->mdl_min);
     bsphere_diameter = MAGNITUDE(diag);
 
     /*
@@ -380,25 +375,31 @@ static double _nirt_backout(struct nirt_state *nss)
      * through the center of the bounding sphere and a plane normal to
      * the ray direction through the aim point.
      */
-    VADD2SCALE(center_bsphere, nss->i->ap->a_rt_i->mdl_max, nss->i->ap->a_rt_i->mdl_min, 0.5);
+    VADD2SCALE(center_bsphere, rtip->mdl_max, rtip->mdl_min, 0.5);
 
-    dist_to_target = DIST_PNT_PNT(center_bsphere, ray_point);
+    dist_to_target = DIST_PNT_PNT(center_bsphere, pt);
 
-    VSUB2(dvec, ray_point, center_bsphere);
+    VSUB2(dvec, pt, center_bsphere);
     VUNITIZE(dvec);
-    delta = dist_to_target*VDOT(ray_dir, dvec);
+    delta = dist_to_target*VDOT(dir, dvec);
 
     /*
      * this should put us about a bounding sphere radius in front of
      * the bounding sphere
      */
-    bov = bsphere_diameter + delta;
+    return bsphere_diameter + delta;
+}
 
-    return bov;
+
+static double _nirt_backout(struct nirt_state *nss)
+{
+    if (!nss || !nss->i->backout) return 0.0;
+
+    return _nirt_backout_dist(nss->i->ap->a_rt_i, nss->i->vals->orig, nss->i->vals->dir);
 }
 
 
-static fastf_t
+fastf_t
 _nirt_get_obliq(fastf_t *ray, fastf_t *normal)
 {
     fastf_t cos_obl;
@@ -1549,6 +1550,7 @@ static const struct nirt_cmd_desc nirt_descs[] = {
     { "hv",             "set/query gridplane coordinates",               "horz vert [dist]" },
     { "xyz",            "set/query target coordinates",                  "X Y Z" },
     { "s",              "shoot a ray at the target",                     NULL },
+    { "batch",          "shoot a file of rays in parallel",              "[-b] [-u] [-P ncpu] [-o file] rayfile|-" },
     { "backout",        "back out of model",                             NULL },
     { "useair",         "set/query use of air",                          "<0|1|2|...>" },
     { "units",          "set/query local units",                         "<mm|cm|m|in|ft>" },
@@ -2601,6 +2603,7 @@ const struct bu_cmdtab _libanalyze_nirt_cmds[] = {
     { "ae",             _nirt_cmd_az_el},
     { "attr",           _nirt_cmd_attr},
     { "backout",        _nirt_cmd_backout},
+    { "batch",          _nirt_cmd_batch},
     { "center",         _nirt_cmd_target_coor},
     { "color",          _nirt_cmd_color_plot},
     { "debug",          _nirt_cmd_debug},
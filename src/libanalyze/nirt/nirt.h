@@ -411,6 +411,8 @@ struct rt_i * _nirt_get_rtip(struct nirt_state *nss);
 struct resource * _nirt_get_resource(struct nirt_state *nss);
 void _nirt_init_ovlp(struct nirt_state *nss);
 int _nirt_raytrace_prep(struct nirt_state *nss);
+double _nirt_backout_dist(struct rt_i *rtip, const point_t pt, const vect_t dir);
+fastf_t _nirt_get_obliq(fastf_t *ray, fastf_t *normal);
 
 
 void _nirt_diff_create(struct nirt_state *nss);
@@ -418,6 +420,8 @@ void _nirt_diff_destroy(struct nirt_state *nss);
 void _nirt_diff_add_seg(struct nirt_state *nss, nirt_seg *nseg);
 extern "C" int _nirt_cmd_diff(void *ns, int argc, const char *argv[]);
 
+extern "C" int _nirt_cmd_batch(void *ns, int argc, const char *argv[]);
+
 
 // Local Variables:
 // tab-width: 8
@@ -0,0 +1,138 @@
+/*                      V E R T _ W E L D . C
+ *
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file vert_weld.c
+ *
+ * Compare bg_vert_weld() against a brute force first-fit merge.
+ *
+ */
+
+#include "common.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "bu.h"
+#include "vmath.h"
+#include "bg.h"
+#include "bg/vert_tree.h"
+
+
+static size_t
+brute_weld(size_t *map, const fastf_t *verts, size_t nverts, fastf_t tol_sq)
+{
+    size_t nkept = 0;
+    for (size_t i = 0; i < nverts; i++) {
+	map[i] = i;
+	for (size_t j = 0; j < i; j++) {
+	    if (map[j] != j)
+		continue;
+	    if (DIST_PNT_PNT_SQ(&verts[3*i], &verts[3*j]) <= tol_sq) {
+		map[i] = j;
+		break;
+	    }
+	}
+	if (map[i] == i)
+	    nkept++;
+    }
+    return nkept;
+}
+
+
+static int
+check_weld(const fastf_t *verts, size_t nverts, fastf_t tol_sq)
+{
+    size_t *map = (size_t *)bu_calloc(nverts, sizeof(size_t), "map");
+    size_t *ref = (size_t *)bu_calloc(nverts, sizeof(size_t), "ref");
+    size_t nkept = bg_vert_weld(map, verts, nverts, tol_sq);
+    size_t nref = brute_weld(ref, verts, nverts, tol_sq);
+    int ret = 0;
+
+    if (nkept != nref) {
+	bu_log("kept %zu vertices, expected %zu\n", nkept, nref);
+	ret = 1;
+    }
+    for (size_t i = 0; i < nverts && !ret; i++) {
+	if (map[i] != ref[i]) {
+	    bu_log("vertex %zu mapped to %zu, expected %zu\n", i, map[i], ref[i]);
+	    ret = 1;
+	}
+    }
+
+    bu_free(map, "map");
+    bu_free(ref, "ref");
+    return ret;
+}
+
+
+int
+main(int UNUSED(argc), const char **argv)
+{
+    /* two triangles sharing an edge, one copy slightly perturbed */
+    fastf_t tris[18] = {
+	0, 0, 0,  1, 0, 0,  0, 1, 0,
+	1, 0, 0.0001,  0, 1, 0,  1, 1, 0
+    };
+    size_t map[6];
+    fastf_t *verts;
+    size_t nverts = 20000;
+    int ret = 0;
+
+    bu_setprogname(argv[0]);
+
+    if (bg_vert_weld(map, tris, 6, 0.001 * 0.001) != 4 || map[3] != 1 || map[4] != 2) {
+	bu_log("shared edge not welded\n");
+	ret = 1;
+    }
+    if (bg_vert_weld(map, tris, 6, 0.0) != 5 || map[3] != 3 || map[4] != 2) {
+	bu_log("zero tolerance weld merged distinct vertices\n");
+	ret = 1;
+    }
+
+    /* points on a coarse lattice with some jitter, so that many are
+     * within tolerance of more than one other */
+    verts = (fastf_t *)bu_malloc(nverts * 3 * sizeof(fastf_t), "verts");
+    srand(5);
+    for (size_t i = 0; i < nverts * 3; i++) {
+	verts[i] = (rand() % 40) * 0.25;
+	if (rand() % 4 == 0)
+	    verts[i] += (rand() % 100) * 0.001;
+    }
+    ret |= check_weld(verts, nverts, 0.0);
+    ret |= check_weld(verts, nverts, 0.05 * 0.05);
+    ret |= check_weld(verts, nverts, 0.3 * 0.3);
+    bu_free(verts, "verts");
+
+    if (!ret)
+	bu_log("bg_vert_weld [PASS]\n");
+
+    return ret;
+}
+
+
+/*
+ * Local Variables:
+ * mode: C
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -0,0 +1,275 @@
+/*                     V E R T _ W E L D . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @addtogroup vtree */
+/** @{ */
+/** @file libbg/vert_weld.c
+ *
+ * @brief
+ * Merge coincident vertices of a triangle soup using a hash grid.
+ *
+ * Vertices are binned into cubic cells one tolerance wide, so any
+ * vertex within tolerance of another is in the same or an adjacent
+ * cell.  The neighbor searches, which are the expensive part, only
+ * read the grid and are done in parallel.  Deciding which vertices are
+ * kept is then a cheap serial pass in input order, so the result does
+ * not depend on the number of threads.
+ *
+ * Importers weld millions of vertices at once, so the grid is kept
+ * small: hash slots hold only the index of the first vertex of their
+ * cell, whose cell coordinates are recomputed when probing, and cells
+ * chain their vertices through a single next index per vertex.  Apart
+ * from the caller's map, that is 25 to 41 bytes per vertex.
+ *
+ */
+
+#include "common.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "vmath.h"
+#include "bu/malloc.h"
+#include "bu/parallel.h"
+#include "bg/vert_tree.h"
+
+
+/* vertices handed to a thread at a time */
+#define WELD_CHUNK 4096
+
+/* grid cell coordinates are clamped to this magnitude */
+#define WELD_CELL_MAX 4.0e18
+
+#define WELD_NONE ((size_t)-1)
+
+
+struct weld_state {
+    const fastf_t *verts;
+    size_t nverts;
+    fastf_t tol;
+    fastf_t tol_sq;
+    size_t *next;	/* next vertex in the same cell, in increasing order */
+    size_t *link;	/* first earlier vertex within tolerance, the caller's map */
+    size_t *slots;	/* first vertex in the cell, WELD_NONE if unused */
+    size_t mask;
+    int sem;
+    size_t curr;
+};
+
+
+static size_t
+weld_hash(const int64_t c[3])
+{
+    uint64_t h = (uint64_t)c[X] * 73856093ULL;
+    h ^= (uint64_t)c[Y] * 19349663ULL;
+    h ^= (uint64_t)c[Z] * 83492791ULL;
+    h ^= h >> 29;
+    return (size_t)h;
+}
+
+
+static int64_t
+weld_coord(const struct weld_state *s, fastf_t v)
+{
+    double d;
+    int64_t c;
+
+    if (s->tol > 0.0) {
+	d = floor(v / s->tol);
+	if (!(d > -WELD_CELL_MAX))
+	    d = (d < 0.0) ? -WELD_CELL_MAX : 0.0; /* also catches NaN */
+	if (d > WELD_CELL_MAX)
+	    d = WELD_CELL_MAX;
+	return (int64_t)d;
+    }
+
+    /* zero tolerance, only identical vertices merge */
+    d = v + 0.0; /* -0.0 becomes 0.0 */
+    memcpy(&c, &d, sizeof(int64_t));
+    return c;
+}
+
+
+static void
+weld_cell(const struct weld_state *s, size_t i, int64_t c[3])
+{
+    c[X] = weld_coord(s, s->verts[3*i+X]);
+    c[Y] = weld_coord(s, s->verts[3*i+Y]);
+    c[Z] = weld_coord(s, s->verts[3*i+Z]);
+}
+
+
+/* Find the slot of cell c, or the empty slot it would go in */
+static size_t
+weld_slot(const struct weld_state *s, const int64_t c[3])
+{
+    size_t i = weld_hash(c) & s->mask;
+    while (s->slots[i] != WELD_NONE) {
+	int64_t hc[3];
+	weld_cell(s, s->slots[i], hc);
+	if (hc[X] == c[X] && hc[Y] == c[Y] && hc[Z] == c[Z])
+	    return i;
+	i = (i + 1) & s->mask;
+    }
+    return i;
+}
+
+
+/* Find the first vertex before i that is within tolerance, looking
+ * through the neighboring cells.  If kept is non-NULL only vertices
+ * flagged there are considered.
+ */
+static size_t
+weld_search(const struct weld_state *s, size_t i, const char *kept)
+{
+    const fastf_t *v = &s->verts[3*i];
+    int r = (s->tol > 0.0) ? 1 : 0;
+    size_t found = i;
+    int64_t ci[3], c[3];
+    int dx, dy, dz;
+
+    weld_cell(s, i, ci);
+
+    for (dx = -r; dx <= r; dx++) {
+	for (dy = -r; dy <= r; dy++) {
+	    for (dz = -r; dz <= r; dz++) {
+		size_t slot, j;
+		c[X] = ci[X] + dx;
+		c[Y] = ci[Y] + dy;
+		c[Z] = ci[Z] + dz;
+		slot = weld_slot(s, c);
+		for (j = s->slots[slot]; j != WELD_NONE && j < found; j = s->next[j]) {
+		    vect_t d;
+		    if (kept && !kept[j])
+			continue;
+		    VSUB2(d, v, &s->verts[3*j]);
+		    if (MAGSQ(d) <= s->tol_sq) {
+			found = j;
+			break;
+		    }
+		}
+	    }
+	}
+    }
+
+    return found;
+}
+
+
+static void
+weld_link_worker(int UNUSED(cpu), void *data)
+{
+    struct weld_state *s = (struct weld_state *)data;
+
+    while (1) {
+	size_t start, end, i;
+
+	bu_semaphore_acquire(s->sem);
+	start = s->curr;
+	s->curr += WELD_CHUNK;
+	bu_semaphore_release(s->sem);
+	if (start >= s->nverts)
+	    return;
+
+	end = (start + WELD_CHUNK < s->nverts) ? start + WELD_CHUNK : s->nverts;
+	for (i = start; i < end; i++)
+	    s->link[i] = weld_search(s, i, NULL);
+    }
+}
+
+
+size_t
+bg_vert_weld(size_t *map, const fastf_t *verts, size_t nverts, fastf_t local_tol_sq)
+{
+    struct weld_state s;
+    size_t nslots = 1;
+    size_t nkept = 0;
+    char *kept;
+    size_t i;
+
+    if (!map || !verts || !nverts)
+	return 0;
+
+    memset(&s, 0, sizeof(struct weld_state));
+    s.verts = verts;
+    s.nverts = nverts;
+    s.tol_sq = (local_tol_sq > 0.0) ? local_tol_sq : 0.0;
+    s.tol = sqrt(s.tol_sq);
+    s.sem = bu_semaphore_register("BG_VERT_WELD_SEM");
+
+    s.next = (size_t *)bu_malloc(nverts * sizeof(size_t), "weld next");
+    s.link = map;
+
+    /* build the grid, inserting in reverse so each cell lists its
+     * vertices in increasing order */
+    while (nslots < 2 * nverts)
+	nslots <<= 1;
+    s.mask = nslots - 1;
+    s.slots = (size_t *)bu_malloc(nslots * sizeof(size_t), "weld slots");
+    for (i = 0; i < nslots; i++)
+	s.slots[i] = WELD_NONE;
+    for (i = nverts; i-- > 0;) {
+	int64_t c[3];
+	size_t slot;
+
+	weld_cell(&s, i, c);
+	slot = weld_slot(&s, c);
+	s.next[i] = s.slots[slot];
+	s.slots[slot] = i;
+    }
+
+    s.curr = 0;
+    bu_parallel(weld_link_worker, 0, &s);
+
+    /* A vertex is kept unless an earlier kept vertex is within
+     * tolerance, in which case it maps to the first such vertex.  The
+     * first earlier vertex within tolerance of any kind is almost
+     * always kept itself, so searching again is rarely needed.  Links
+     * were left in map, and map[i] only depends on kept[] below i.
+     */
+    kept = (char *)bu_calloc(nverts, sizeof(char), "weld kept");
+    for (i = 0; i < nverts; i++) {
+	size_t j = s.link[i];
+	if (j != i && !kept[j])
+	    j = weld_search(&s, i, kept);
+	if (j == i) {
+	    kept[i] = 1;
+	    nkept++;
+	}
+	map[i] = j;
+    }
+
+    bu_free(kept, "weld kept");
+    bu_free(s.slots, "weld slots");
+    bu_free(s.next, "weld next");
+
+    return nkept;
+}
+
+/** @} */
+
+/*
+ * Local Variables:
+ * mode: C
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -128,12 +128,15 @@ loop_edges(cdt_mesh_t *fmesh, cpolygon_t *loop)
     }
 }
 
-static bool
-do_triangulation(struct ON_Brep_CDT_State *s_cdt, int fi)
+// Document the min and max segment lengths - used to guide surface sampling
+// - and make sure the face's containers exist, so the per-face triangulation
+// only has to look them up.  Done serially, before faces are triangulated in
+// parallel.
+static void
+face_prep(struct ON_Brep_CDT_State *s_cdt, int fi)
 {
     ON_BrepFace &face = s_cdt->brep->m_F[fi];
 
-    // Document the min and max segment lengths - used to guide surface sampling
     int loop_cnt = face.LoopCount();
     double min_edge_seg_len = DBL_MAX;
     double max_edge_seg_len = 0;
@@ -159,6 +162,21 @@ do_triangulation(struct ON_Brep_CDT_State *s_cdt, int fi)
     (*s_cdt->min_edge_seg_len)[face.m_face_index] = min_edge_seg_len;
     (*s_cdt->max_edge_seg_len)[face.m_face_index] = max_edge_seg_len;
 
+    (void)s_cdt->fmeshes[fi];
+    (void)s_cdt->face_rtrees_2d[fi];
+    (void)s_cdt->face_rtrees_3d[fi];
+    (void)s_cdt->strim_pnts[fi];
+    (void)s_cdt->strim_norms[fi];
+}
+
+// Triangulate one face.  Apart from the CDT_Add3D* audit records, which are
+// semaphore protected, this only modifies the face's own containers and may
+// be run in parallel for different faces once face_prep has been called.
+static bool
+do_triangulation(struct ON_Brep_CDT_State *s_cdt, int fi)
+{
+    ON_BrepFace &face = s_cdt->brep->m_F[fi];
+
     // Sample the surface, independent of the trimming curves, to get points that
     // will tie the mesh to the interior surface.
     GetInteriorPoints(s_cdt, face.m_face_index);
@@ -197,6 +215,27 @@ do_triangulation(struct ON_Brep_CDT_State *s_cdt, int fi)
     return refine_triangulation(s_cdt, fmesh, 0, 0);
 }
 
+struct cdt_face_job {
+    struct ON_Brep_CDT_State *s_cdt;
+    std::vector<int> *faces;
+    std::vector<int> *ok;
+    size_t next;
+};
+
+static void
+do_triangulation_worker(int UNUSED(cpu), void *data)
+{
+    struct cdt_face_job *job = (struct cdt_face_job *)data;
+    while (1) {
+	bu_semaphore_acquire(job->s_cdt->sem);
+	size_t i = job->next++;
+	bu_semaphore_release(job->s_cdt->sem);
+	if (i >= job->faces->size())
+	    return;
+	(*job->ok)[i] = (do_triangulation(job->s_cdt, (*job->faces)[i])) ? 1 : 0;
+    }
+}
+
 ON_3dVector
 calc_trim_vnorm(ON_BrepVertex& v, ON_BrepTrim *trim)
 {
@@ -522,11 +561,32 @@ ON_Brep_CDT_Tessellate(struct ON_Brep_CDT_State *s_cdt, int face_cnt, int *faces
     // Keep track of failures and successes.
     int face_failures = 0;
     int face_successes = 0;
+
+    // Each face is triangulated independently of the others, so they are
+    // processed in parallel.  Which thread handles a face has no effect on
+    // its mesh, so the results are the same as a serial run.
     int fc = ((face_cnt == 0) || !faces) ? s_cdt->brep->m_F.Count() : face_cnt;
+    std::vector<int> tfaces;
+    std::map<int, size_t> tface_ind;
+    for (int i = 0; i < fc; i++) {
+	int fi = ((face_cnt == 0) || !faces) ? i : faces[i];
+	if (fi < s_cdt->brep->m_F.Count() && tface_ind.find(fi) == tface_ind.end()) {
+	    face_prep(s_cdt, fi);
+	    tface_ind[fi] = tfaces.size();
+	    tfaces.push_back(fi);
+	}
+    }
+    std::vector<int> tface_ok(tfaces.size(), 0);
+    struct cdt_face_job job;
+    job.s_cdt = s_cdt;
+    job.faces = &tfaces;
+    job.ok = &tface_ok;
+    job.next = 0;
+    bu_parallel(do_triangulation_worker, s_cdt->ncpus, &job);
     for (int i = 0; i < fc; i++) {
 	int fi = ((face_cnt == 0) || !faces) ? i : faces[i];
 	if (fi < s_cdt->brep->m_F.Count()) {
-	    if (do_triangulation(s_cdt, fi)) {
+	    if (tface_ok[tface_ind[fi]]) {
 		face_successes++;
 	    } else {
 		face_failures++;
@@ -604,9 +664,14 @@ ON_Brep_CDT_Mesh(
 
     /* We know now the final triangle set.  We need to build up the set of
      * unique points and normals to generate a mesh containing only the
-     * information actually used by the final triangle set. */
-    std::set<ON_3dPoint *> vfpnts;
-    std::set<ON_3dPoint *> vfnormals;
+     * information actually used by the final triangle set.  Points and
+     * normals are indexed in the order the triangles first use them rather
+     * than by address, so the output doesn't depend on allocation order
+     * (which differs from run to run when faces are meshed in parallel). */
+    std::vector<ON_3dPoint *> vfpnts;
+    std::vector<ON_3dPoint *> vfnormals;
+    std::map<ON_3dPoint *, int> on_pnt_to_bot_pnt;
+    std::map<ON_3dPoint *, int> on_norm_to_bot_norm;
     std::set<ON_3dPoint *> flip_normals;
     for (size_t fi = 0; fi < active_faces.size(); fi++) {
 	cdt_mesh_t *fmesh = &s_cdt->fmeshes[(int)fi];
@@ -619,7 +684,10 @@ ON_Brep_CDT_Mesh(
 	    tri = fmesh->tris_vect[t_ind];
 	    for (size_t j = 0; j < 3; j++) {
 		ON_3dPoint *p3d = fmesh->pnts[tri.v[j]];
-		vfpnts.insert(p3d);
+		if (on_pnt_to_bot_pnt.find(p3d) == on_pnt_to_bot_pnt.end()) {
+		    on_pnt_to_bot_pnt[p3d] = (int)vfpnts.size();
+		    vfpnts.push_back(p3d);
+		}
 		ON_3dPoint *onorm = NULL;
 		if (s_cdt->singular_vert_to_norms->find(p3d) != s_cdt->singular_vert_to_norms->end()) {
 		    // Use calculated normal for singularity points
@@ -628,7 +696,10 @@ ON_Brep_CDT_Mesh(
 		    onorm = fmesh->normals[fmesh->nmap[tri.v[j]]];
 		}
 		if (onorm) {
-		    vfnormals.insert(onorm);
+		    if (on_norm_to_bot_norm.find(onorm) == on_norm_to_bot_norm.end()) {
+			on_norm_to_bot_norm[onorm] = (int)vfnormals.size();
+			vfnormals.push_back(onorm);
+		    }
 		    if (fmesh->m_bRev) {
 			flip_normals.insert(onorm);
 		    }
@@ -654,22 +725,20 @@ ON_Brep_CDT_Mesh(
     }
 
     // Populate the arrays and map the ON containers to their corresponding BoT array entries
-    std::set<ON_3dPoint *>::iterator p_it;
+    std::vector<ON_3dPoint *>::iterator p_it;
 
-    // Index vertex points and assign them to the BoT array
-    std::map<ON_3dPoint *, int> on_pnt_to_bot_pnt;
+    // Assign vertex points to the BoT array
     int pnt_ind = 0;
     for (p_it = vfpnts.begin(); p_it != vfpnts.end(); p_it++) {
 	ON_3dPoint *vp = *p_it;
 	(*vertices)[pnt_ind*3] = vp->x;
 	(*vertices)[pnt_ind*3+1] = vp->y;
 	(*vertices)[pnt_ind*3+2] = vp->z;
-	on_pnt_to_bot_pnt[vp] = pnt_ind;
 	(*s_cdt->bot_pnt_to_on_pnt)[pnt_ind] = vp;
 	pnt_ind++;
     }
 
-    // Index vertex normal vectors and assign them to the BoT array.  Normal
+    // Assign vertex normal vectors to the BoT array.  Normal
     // vectors are not always uniquely mapped to vertices (consider, for
     // example, the triangles joining at a sharp edge of a box), but what we
     // are doing here is establishing unique integer identifiers for all normal
@@ -678,7 +747,6 @@ ON_Brep_CDT_Mesh(
     //
     // The mapping of 2D triangle point to its associated normal is the
     // responsibility of the  p2t_to_on3_norm_map container
-    std::map<ON_3dPoint *, int> on_norm_to_bot_norm;
     size_t norm_ind = 0;
     if (normals) {
 	for (p_it = vfnormals.begin(); p_it != vfnormals.end(); p_it++) {
@@ -690,7 +758,6 @@ ON_Brep_CDT_Mesh(
 	    (*normals)[norm_ind*3] = vnf.x;
 	    (*normals)[norm_ind*3+1] = vnf.y;
 	    (*normals)[norm_ind*3+2] = vnf.z;
-	    on_norm_to_bot_norm[vn] = (int)norm_ind;
 	    norm_ind++;
 	}
     }
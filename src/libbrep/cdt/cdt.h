@@ -45,6 +45,7 @@
 #include "bu/color.h"
 #include "bu/cv.h"
 #include "bu/opt.h"
+#include "bu/parallel.h"
 #include "bu/time.h"
 #include "bn/mat.h"
 #include "bg/plane.h"
@@ -106,6 +107,9 @@ struct ON_Brep_CDT_State {
     fastf_t cos_within_ang;
     fastf_t ovlp_max_len;
 
+    /* Threads used to tessellate, 0 for all available */
+    int ncpus;
+
     /* 3D data */
     std::vector<ON_3dPoint *> *w3dpnts;
     std::vector<ON_3dPoint *> *w3dnorms;
@@ -130,6 +134,10 @@ struct ON_Brep_CDT_State {
     std::map<int, ON_3dPoint *> *bot_pnt_to_on_pnt;
     std::map<ON_3dPoint *, struct cdt_audit_info *> *pnt_audit_info;
 
+    /* Protects the shared containers above when faces are processed in
+     * parallel */
+    int sem;
+
     /* Face specific data */
     std::map<int, cdt_mesh_t> fmeshes;
     std::map<int, RTree<void *, double, 2>> face_rtrees_2d;
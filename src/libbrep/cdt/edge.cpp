@@ -455,7 +455,7 @@ trim_normal(ON_BrepTrim *trim, ON_2dPoint &cp)
 }
 
 static ON_2dPoint
-get_trim_midpt(fastf_t *t, struct ON_Brep_CDT_State *s_cdt, cpolyedge_t *pe, ON_3dPoint &edge_mid_3d, double elen, double brep_edge_tol)
+get_trim_midpt(fastf_t *t, struct ON_Brep_CDT_State *s_cdt, int trim_ind, double trim_start, double trim_end, ON_3dPoint &edge_mid_3d, double elen, double brep_edge_tol)
 {
     int verbose = 1;
     double tol;
@@ -464,8 +464,8 @@ get_trim_midpt(fastf_t *t, struct ON_Brep_CDT_State *s_cdt, cpolyedge_t *pe, ON_
     } else {
 	tol = (elen < BN_TOL_DIST) ? 0.01*elen : 0.1*BN_TOL_DIST;
     }
-    ON_BrepTrim& trim = s_cdt->brep->m_T[pe->trim_ind];
-    ON_Interval domain(pe->trim_start, pe->trim_end);
+    ON_BrepTrim& trim = s_cdt->brep->m_T[trim_ind];
+    ON_Interval domain(trim_start, trim_end);
     double tparam;
     ON_2dPoint trim_mid_2d;
     bool cpoint = ON_TrimCurve_GetClosestPoint(&tparam, &trim, edge_mid_3d, 0, &domain);
@@ -473,7 +473,7 @@ get_trim_midpt(fastf_t *t, struct ON_Brep_CDT_State *s_cdt, cpolyedge_t *pe, ON_
 	bu_log("Warning - could not find suitable trim point\n");
     }
     if (!cpoint) {
-	tparam = (pe->trim_start + pe->trim_end) / 2.0;
+	tparam = (trim_start + trim_end) / 2.0;
     }
     trim_mid_2d = trim.PointAt(tparam);
     if (verbose && !cpoint) {
@@ -494,10 +494,171 @@ get_trim_midpt(fastf_t *t, struct ON_Brep_CDT_State *s_cdt, cpolyedge_t *pe, ON_
     return trim_mid_2d;
 }
 
+// The new points, parameters and normals needed to split a bedge_seg_t at
+// its midpoint.
+struct bseg_mid_t {
+    fastf_t emid;
+    ON_3dPoint mid_3d;
+    ON_3dVector mid_tan;
+    fastf_t t1mid;
+    fastf_t t2mid;
+    ON_2dPoint trim1_mid_2d;
+    ON_2dPoint trim2_mid_2d;
+    ON_3dVector norm1;
+    ON_3dVector norm2;
+};
+
+// Everything the tolerance test needs to know about an edge segment.  This
+// describes either an existing bedge_seg_t or one that splitting it would
+// produce - in the latter case points that don't exist yet have NULL
+// pointers, and the segment's constant properties come from b.  Nothing in
+// here refers to containers that a split modifies, so splits of many segments
+// can be evaluated in parallel and applied afterwards.
+struct bseg_plan_t {
+    bedge_seg_t *b;
+    int f_id[2];	// faces of tseg1 and tseg2
+    int ef_id[2];	// faces of edge trims 0 and 1
+    bool rev[2];	// m_bRev3d of the tseg1 and tseg2 trims
+    fastf_t edge_start;
+    fastf_t edge_end;
+    ON_3dPoint *e_start;
+    ON_3dPoint *e_end;
+    ON_3dPoint p_start;
+    ON_3dPoint p_end;
+    ON_3dPoint *e_root_start;
+    ON_3dPoint *e_root_end;
+    ON_3dVector tan_start;
+    ON_3dVector tan_end;
+    fastf_t trim_start[2];
+    fastf_t trim_end[2];
+    ON_3dVector n_start[2];	// normals from the ef_id faces
+    ON_3dVector n_end[2];
+
+    // Filled in if the tolerances call for a split
+    bool split;
+    struct bseg_mid_t mid;
+    struct bseg_plan_t *sub[2];
+};
+
+// Look up the normal a face mesh has recorded for p without inserting into
+// its maps (so concurrent readers are safe.)  Missing entries resolve to
+// index 0, as operator[] lookups would.
+static ON_3dVector
+fmesh_pnt_norm(cdt_mesh_t *fmesh, ON_3dPoint *p)
+{
+    std::map<ON_3dPoint *, long>::iterator p_it = fmesh->p2ind.find(p);
+    long pind = (p_it != fmesh->p2ind.end()) ? p_it->second : 0;
+    std::map<long, long>::iterator n_it = fmesh->nmap.find(pind);
+    long nind = (n_it != fmesh->nmap.end()) ? n_it->second : 0;
+    if (nind < 0 || (size_t)nind >= fmesh->normals.size()) {
+	return ON_3dVector::UnsetVector;
+    }
+    return ON_3dVector(*fmesh->normals[nind]);
+}
+
+static void
+bseg_plan_init(struct ON_Brep_CDT_State *s_cdt, struct bseg_plan_t *p, bedge_seg_t *bseg)
+{
+    ON_BrepEdge& edge = s_cdt->brep->m_E[bseg->edge_ind];
+    ON_BrepTrim *trim1 = &s_cdt->brep->m_T[bseg->tseg1->trim_ind];
+    ON_BrepTrim *trim2 = &s_cdt->brep->m_T[bseg->tseg2->trim_ind];
+    p->b = bseg;
+    p->f_id[0] = trim1->Face()->m_face_index;
+    p->f_id[1] = trim2->Face()->m_face_index;
+    p->ef_id[0] = edge.Trim(0)->Face()->m_face_index;
+    p->ef_id[1] = edge.Trim(1)->Face()->m_face_index;
+    p->rev[0] = trim1->m_bRev3d;
+    p->rev[1] = trim2->m_bRev3d;
+    p->edge_start = bseg->edge_start;
+    p->edge_end = bseg->edge_end;
+    p->e_start = bseg->e_start;
+    p->e_end = bseg->e_end;
+    p->p_start = *bseg->e_start;
+    p->p_end = *bseg->e_end;
+    p->e_root_start = bseg->e_root_start;
+    p->e_root_end = bseg->e_root_end;
+    p->tan_start = bseg->tan_start;
+    p->tan_end = bseg->tan_end;
+    p->trim_start[0] = bseg->tseg1->trim_start;
+    p->trim_end[0] = bseg->tseg1->trim_end;
+    p->trim_start[1] = bseg->tseg2->trim_start;
+    p->trim_end[1] = bseg->tseg2->trim_end;
+    for (int i = 0; i < 2; i++) {
+	cdt_mesh_t *fmesh = &s_cdt->fmeshes[p->ef_id[i]];
+	p->n_start[i] = fmesh_pnt_norm(fmesh, bseg->e_start);
+	p->n_end[i] = fmesh_pnt_norm(fmesh, bseg->e_end);
+    }
+    p->split = false;
+    p->sub[0] = NULL;
+    p->sub[1] = NULL;
+}
+
+static void
+bseg_plan_free(struct bseg_plan_t *p)
+{
+    if (!p) return;
+    bseg_plan_free(p->sub[0]);
+    bseg_plan_free(p->sub[1]);
+    delete p;
+}
+
+// Describe the two segments that splitting p at p->mid will produce, mirroring
+// what bseg_split does to the real containers.
+static void
+bseg_plan_subdivide(struct bseg_plan_t *p)
+{
+    struct bseg_mid_t *m = &p->mid;
+    fastf_t tmid[2] = {m->t1mid, m->t2mid};
+
+    // A face mesh holding the new point has the normal of the trim on that
+    // face - the tseg2 normal wins if both trims are on the same face, since
+    // it is added last.
+    ON_3dVector mid_norm[2];
+    for (int i = 0; i < 2; i++) {
+	mid_norm[i] = (p->ef_id[i] == p->f_id[0] && p->f_id[0] != p->f_id[1]) ? m->norm1 : m->norm2;
+    }
+
+    for (int i = 0; i < 2; i++) {
+	struct bseg_plan_t *s = new struct bseg_plan_t;
+	*s = *p;
+	s->e_root_start = NULL;
+	s->e_root_end = NULL;
+	s->split = false;
+	s->sub[0] = NULL;
+	s->sub[1] = NULL;
+	if (!i) {
+	    s->edge_end = m->emid;
+	    s->e_end = NULL;
+	    s->p_end = m->mid_3d;
+	    s->tan_end = m->mid_tan;
+	    s->n_end[0] = mid_norm[0];
+	    s->n_end[1] = mid_norm[1];
+	} else {
+	    s->edge_start = m->emid;
+	    s->e_start = NULL;
+	    s->p_start = m->mid_3d;
+	    s->tan_start = m->mid_tan;
+	    s->n_start[0] = mid_norm[0];
+	    s->n_start[1] = mid_norm[1];
+	}
+	// The first half of the edge gets the first half of each trim's
+	// domain, unless the trim runs opposite to the edge
+	for (int j = 0; j < 2; j++) {
+	    if ((!i) != p->rev[j]) {
+		s->trim_end[j] = tmid[j];
+	    } else {
+		s->trim_start[j] = tmid[j];
+	    }
+	}
+	p->sub[i] = s;
+    }
+}
+
 static bool
-tol_need_split(struct ON_Brep_CDT_State *s_cdt, bedge_seg_t *bseg, ON_3dPoint &edge_mid_3d)
+tol_need_split(struct ON_Brep_CDT_State *s_cdt, struct bseg_plan_t *p, ON_3dPoint &edge_mid_3d)
 {
-    ON_Line line3d(*(bseg->e_start), *(bseg->e_end));
+    bedge_seg_t *bseg = p->b;
+    ON_Line line3d(p->p_start, p->p_end);
     double seg_len = line3d.Length();
 
     double max_allowed = (s_cdt->tol.absmax > ON_ZERO_TOLERANCE) ? s_cdt->tol.absmax : 1.1*bseg->cp_len;
@@ -510,6 +671,10 @@ tol_need_split(struct ON_Brep_CDT_State *s_cdt, bedge_seg_t *bseg, ON_3dPoint &e
     double len_1 = -1;
     double len_2 = -1;
     double s_len;
+    std::map<int, double>::iterator l_it;
+    std::map<ON_3dPoint *, double>::iterator v_it;
+    bool at_root_start = (p->e_root_start && (p->e_start == p->e_root_start || p->e_end == p->e_root_start));
+    bool at_root_end = (p->e_root_end && (p->e_start == p->e_root_end || p->e_end == p->e_root_end));
 
     switch (bseg->edge_type) {
 	case 0:
@@ -522,8 +687,14 @@ tol_need_split(struct ON_Brep_CDT_State *s_cdt, bedge_seg_t *bseg, ON_3dPoint &e
 	case 2:
 	    // Linear edge on non-planar surface - use the median segment lengths
 	    // from the trims from non-planar faces associated with this edge
-	    len_1 = (!s1->IsPlanar(NULL, BN_TOL_DIST)) ? s_cdt->l_median_len[l1->m_loop_index] : -1;
-	    len_2 = (!s2->IsPlanar(NULL, BN_TOL_DIST)) ? s_cdt->l_median_len[l2->m_loop_index] : -1;
+	    if (!s1->IsPlanar(NULL, BN_TOL_DIST)) {
+		l_it = s_cdt->l_median_len.find(l1->m_loop_index);
+		len_1 = (l_it != s_cdt->l_median_len.end()) ? l_it->second : 0.0;
+	    }
+	    if (!s2->IsPlanar(NULL, BN_TOL_DIST)) {
+		l_it = s_cdt->l_median_len.find(l2->m_loop_index);
+		len_2 = (l_it != s_cdt->l_median_len.end()) ? l_it->second : 0.0;
+	    }
 	    if (len_1 < 0 && len_2 < 0) {
 		bu_log("Error - both loops report invalid median lengths\n");
 		return false;
@@ -537,13 +708,15 @@ tol_need_split(struct ON_Brep_CDT_State *s_cdt, bedge_seg_t *bseg, ON_3dPoint &e
 	    // Linear edge connected to one or more non-linear edges.  If the start or end points
 	    // are the same as the root start or end points, use the median edge length of the
 	    // connected edge per the vert lookup.
-	    if (bseg->e_start == bseg->e_root_start || bseg->e_end == bseg->e_root_start) {
-		len_1 = s_cdt->v_min_seg_len[bseg->e_root_start];
+	    if (at_root_start) {
+		v_it = s_cdt->v_min_seg_len.find(p->e_root_start);
+		len_1 = (v_it != s_cdt->v_min_seg_len.end()) ? v_it->second : 0.0;
 	    }
-	    if (bseg->e_start == bseg->e_root_end || bseg->e_end == bseg->e_root_end) {
-		len_2 = s_cdt->v_min_seg_len[bseg->e_root_end];
+	    if (at_root_end) {
+		v_it = s_cdt->v_min_seg_len.find(p->e_root_end);
+		len_2 = (v_it != s_cdt->v_min_seg_len.end()) ? v_it->second : 0.0;
 	    }
-	    if (bseg->e_start == bseg->e_root_start || bseg->e_end == bseg->e_root_start) {
+	    if (at_root_start) {
 		if (len_1 < 0 && len_2 < 0) {
 		    bu_log("Error - verts report invalid lengths on type 3 line segment\n");
 		    return false;
@@ -576,87 +749,89 @@ tol_need_split(struct ON_Brep_CDT_State *s_cdt, bedge_seg_t *bseg, ON_3dPoint &e
 
     if (dist3d > max_edgept_dist_from_edge) return true;
 
-    if ((bseg->tan_start * bseg->tan_end) < s_cdt->cos_within_ang) return true;
+    if ((p->tan_start * p->tan_end) < s_cdt->cos_within_ang) return true;
 
-    ON_3dPoint *n1, *n2;
+    for (int i = 0; i < 2; i++) {
+	ON_3dVector n1 = p->n_start[i];
+	ON_3dVector n2 = p->n_end[i];
+	if (n1 != ON_3dVector::UnsetVector && n2 != ON_3dVector::UnsetVector) {
+	    if ((n1 * n2) < s_cdt->cos_within_ang - VUNITIZE_TOL) return true;
+	}
+    }
 
-    ON_BrepEdge& edge = s_cdt->brep->m_E[bseg->edge_ind];
-    ON_BrepTrim *trim1 = edge.Trim(0);
-    ON_BrepFace *face1 = trim1->Face();
-    cdt_mesh_t *fmesh1 = &s_cdt->fmeshes[face1->m_face_index];
-    n1 = fmesh1->normals[fmesh1->nmap[fmesh1->p2ind[bseg->e_start]]];
-    n2 = fmesh1->normals[fmesh1->nmap[fmesh1->p2ind[bseg->e_end]]];
+    return false;
+}
 
-    if (ON_3dVector(*n1) != ON_3dVector::UnsetVector && ON_3dVector(*n2) != ON_3dVector::UnsetVector) {
-	if ((ON_3dVector(*n1) * ON_3dVector(*n2)) < s_cdt->cos_within_ang - VUNITIZE_TOL) return true;
-    }
+// Find the midpoint of the edge segment p describes (at *t, if supplied) and,
+// unless force is set, check whether the tolerances call for splitting it
+// there.  If they do, evaluate the rest of the split data into p->mid and
+// return true.  Only reads the CDT state.
+static bool
+bseg_mid_eval(struct ON_Brep_CDT_State *s_cdt, struct bseg_plan_t *p, int force, double *t)
+{
+    bedge_seg_t *bseg = p->b;
+    struct bseg_mid_t *m = &p->mid;
 
-    ON_BrepTrim *trim2 = edge.Trim(1);
-    ON_BrepFace *face2 = trim2->Face();
-    cdt_mesh_t *fmesh2 = &s_cdt->fmeshes[face2->m_face_index];
-    n1 = fmesh2->normals[fmesh2->nmap[fmesh2->p2ind[bseg->e_start]]];
-    n2 = fmesh2->normals[fmesh2->nmap[fmesh2->p2ind[bseg->e_end]]];
+    // Get the 3D midpoint (and tangent, if we can) from the edge curve
+    m->mid_3d = ON_3dPoint::UnsetPoint;
+    m->mid_tan = ON_3dVector::UnsetVector;
+    m->emid = (t) ? *t : (p->edge_start + p->edge_end) / 2.0;
+    bool evtangent_status = bseg->nc->EvTangent(m->emid, m->mid_3d, m->mid_tan);
+    if (!evtangent_status) {
+	// EvTangent call failed, get 3d point
+	m->mid_3d = bseg->nc->PointAt(m->emid);
+	m->mid_tan = ON_3dVector::UnsetVector;
+    }
 
-    if (ON_3dVector(*n1) != ON_3dVector::UnsetVector && ON_3dVector(*n2) != ON_3dVector::UnsetVector) {
-	if ((ON_3dVector(*n1) * ON_3dVector(*n2)) < s_cdt->cos_within_ang - VUNITIZE_TOL) return true;
+    // Unless we're forcing a split this is the point at which we do tolerance
+    // based testing to determine whether to proceed with the split or halt.
+    if (!force && !tol_need_split(s_cdt, p, m->mid_3d)) {
+	return false;
     }
 
-    return false;
+    // Find the 2D points
+    ON_BrepEdge& edge = s_cdt->brep->m_E[bseg->edge_ind];
+    double elen1 = (bseg->nc->PointAt(p->edge_start)).DistanceTo(bseg->nc->PointAt(m->emid));
+    double elen2 = (bseg->nc->PointAt(m->emid)).DistanceTo(bseg->nc->PointAt(p->edge_end));
+    double elen = (elen1 + elen2) * 0.5;
+    m->trim1_mid_2d = get_trim_midpt(&m->t1mid, s_cdt, bseg->tseg1->trim_ind, p->trim_start[0], p->trim_end[0], m->mid_3d, elen, edge.m_tolerance);
+    m->trim2_mid_2d = get_trim_midpt(&m->t2mid, s_cdt, bseg->tseg2->trim_ind, p->trim_start[1], p->trim_end[1], m->mid_3d, elen, edge.m_tolerance);
+
+    // Trims get their own normals
+    m->norm1 = trim_normal(&s_cdt->brep->m_T[bseg->tseg1->trim_ind], m->trim1_mid_2d);
+    m->norm2 = trim_normal(&s_cdt->brep->m_T[bseg->tseg2->trim_ind], m->trim2_mid_2d);
+
+    p->split = true;
+    return true;
 }
 
-std::set<bedge_seg_t *>
-split_edge_seg(struct ON_Brep_CDT_State *s_cdt, bedge_seg_t *bseg, int force, double *t, int update_rtrees)
+// Split bseg at the previously evaluated midpoint m, updating the CDT
+// containers.  If nsegs is supplied it receives the new segments covering the
+// start and end halves of bseg, in that order.
+static std::set<bedge_seg_t *>
+bseg_split(struct ON_Brep_CDT_State *s_cdt, bedge_seg_t *bseg, struct bseg_mid_t *m, int update_rtrees, bedge_seg_t **nsegs)
 {
     std::set<bedge_seg_t *> nedges;
 
-    // If we don't have associated segments, we can't do anything
-    if (!bseg->tseg1 || !bseg->tseg2 || !bseg->nc) return nedges;
-
     ON_BrepEdge& edge = s_cdt->brep->m_E[bseg->edge_ind];
     ON_BrepTrim *trim1 = &s_cdt->brep->m_T[bseg->tseg1->trim_ind];
     ON_BrepTrim *trim2 = &s_cdt->brep->m_T[bseg->tseg2->trim_ind];
-
-    // If we don't have associated trims, we can't do anything
-    if (!trim1 || !trim2) return nedges;
-
     ON_BrepFace *face1 = trim1->Face();
     ON_BrepFace *face2 = trim2->Face();
     cdt_mesh_t *fmesh1 = &s_cdt->fmeshes[face1->m_face_index];
     cdt_mesh_t *fmesh2 = &s_cdt->fmeshes[face2->m_face_index];
-
-
-    // Get the 3D midpoint (and tangent, if we can) from the edge curve
-    ON_3dPoint edge_mid_3d = ON_3dPoint::UnsetPoint;
-    ON_3dVector edge_mid_tan = ON_3dVector::UnsetVector;
-    fastf_t emid = (t) ? *t : (bseg->edge_start + bseg->edge_end) / 2.0;
-    bool evtangent_status = bseg->nc->EvTangent(emid, edge_mid_3d, edge_mid_tan);
-    if (!evtangent_status) {
-	// EvTangent call failed, get 3d point
-	edge_mid_3d = bseg->nc->PointAt(emid);
-	edge_mid_tan = ON_3dVector::UnsetVector;
-    }
-
-    // Unless we're forcing a split this is the point at which we do tolerance
-    // based testing to determine whether to proceed with the split or halt.
-    if (!force && !tol_need_split(s_cdt, bseg, edge_mid_3d)) {
-	return nedges;
-    }
+    fastf_t emid = m->emid;
+    fastf_t t1mid = m->t1mid;
+    fastf_t t2mid = m->t2mid;
+    ON_2dPoint trim1_mid_2d = m->trim1_mid_2d;
+    ON_2dPoint trim2_mid_2d = m->trim2_mid_2d;
 
     // edge_mid_3d is a new point in the cdt and the fmesh, as well as a new
     // edge point - add it to the appropriate containers
-    ON_3dPoint *mid_3d = new ON_3dPoint(edge_mid_3d);
+    ON_3dPoint *mid_3d = new ON_3dPoint(m->mid_3d);
     CDT_Add3DPnt(s_cdt, mid_3d, -1, -1, -1, edge.m_edge_index, 0, 0);
     s_cdt->edge_pnts->insert(mid_3d);
 
-    // Find the 2D points
-    double elen1 = (bseg->nc->PointAt(bseg->edge_start)).DistanceTo(bseg->nc->PointAt(emid));
-    double elen2 = (bseg->nc->PointAt(emid)).DistanceTo(bseg->nc->PointAt(bseg->edge_end));
-    double elen = (elen1 + elen2) * 0.5;
-    fastf_t t1mid, t2mid;
-    ON_2dPoint trim1_mid_2d, trim2_mid_2d;
-    trim1_mid_2d = get_trim_midpt(&t1mid, s_cdt, bseg->tseg1, edge_mid_3d, elen, edge.m_tolerance);
-    trim2_mid_2d = get_trim_midpt(&t2mid, s_cdt, bseg->tseg2, edge_mid_3d, elen, edge.m_tolerance);
-
     // Update the 2D and 2D->3D info in the fmeshes
     long f1_ind2d = fmesh1->add_point(trim1_mid_2d);
     long f1_ind3d = fmesh1->add_point(mid_3d);
@@ -672,13 +847,11 @@ split_edge_seg(struct ON_Brep_CDT_State *s_cdt, bedge_seg_t *bseg, int force, do
     fmesh2->p2d3d[f2_ind2d] = f2_ind3d;
 
     // Trims get their own normals
-    ON_3dVector norm1 = trim_normal(trim1, trim1_mid_2d);
-    fmesh1->normals.push_back(new ON_3dPoint(norm1));
+    fmesh1->normals.push_back(new ON_3dPoint(m->norm1));
     CDT_Add3DNorm(s_cdt, fmesh1->normals[fmesh1->normals.size()-1], mid_3d, fmesh1->f_id, -1, trim1->m_trim_index, bseg->edge_ind, trim1_mid_2d.x, trim1_mid_2d.y);
     long f1_nind = fmesh1->normals.size() - 1;
     fmesh1->nmap[f1_ind3d] = f1_nind;
-    ON_3dVector norm2 = trim_normal(trim2, trim2_mid_2d);
-    fmesh2->normals.push_back(new ON_3dPoint(norm2));
+    fmesh2->normals.push_back(new ON_3dPoint(m->norm2));
     CDT_Add3DNorm(s_cdt, fmesh2->normals[fmesh2->normals.size()-1], mid_3d, fmesh2->f_id, -1, trim2->m_trim_index, bseg->edge_ind, trim2_mid_2d.x, trim2_mid_2d.y);
     long f2_nind = fmesh2->normals.size() - 1;
     fmesh2->nmap[f2_ind3d] = f2_nind;
@@ -690,14 +863,14 @@ split_edge_seg(struct ON_Brep_CDT_State *s_cdt, bedge_seg_t *bseg, int force, do
     bseg1->e_start = bseg->e_start;
     bseg1->e_end = mid_3d;
     bseg1->tan_start = bseg->tan_start;
-    bseg1->tan_end = edge_mid_tan;
+    bseg1->tan_end = m->mid_tan;
 
     bedge_seg_t *bseg2 = new bedge_seg_t(bseg);
     bseg2->edge_start = emid;
     bseg2->edge_end = bseg->edge_end;
     bseg2->e_start = mid_3d;
     bseg2->e_end = bseg->e_end;
-    bseg2->tan_start = edge_mid_tan;
+    bseg2->tan_start = m->mid_tan;
     bseg2->tan_end = bseg->tan_end;
 
     // Remove the old segments from their respective rtrees
@@ -802,10 +975,36 @@ split_edge_seg(struct ON_Brep_CDT_State *s_cdt, bedge_seg_t *bseg, int force, do
     s_cdt->e2polysegs[edge.m_edge_index].insert(bseg1);
     s_cdt->e2polysegs[edge.m_edge_index].insert(bseg2);
 
+    if (nsegs) {
+	nsegs[0] = bseg1;
+	nsegs[1] = bseg2;
+    }
+
     delete bseg;
     return nedges;
 }
 
+std::set<bedge_seg_t *>
+split_edge_seg(struct ON_Brep_CDT_State *s_cdt, bedge_seg_t *bseg, int force, double *t, int update_rtrees)
+{
+    std::set<bedge_seg_t *> nedges;
+
+    // If we don't have associated segments, we can't do anything
+    if (!bseg->tseg1 || !bseg->tseg2 || !bseg->nc) return nedges;
+
+    // If we don't have associated trims, we can't do anything
+    if (bseg->tseg1->trim_ind < 0 || bseg->tseg2->trim_ind < 0) return nedges;
+
+    struct bseg_plan_t p;
+    bseg_plan_init(s_cdt, &p, bseg);
+    if (!bseg_mid_eval(s_cdt, &p, force, t)) {
+	return nedges;
+    }
+
+    return bseg_split(s_cdt, bseg, &p.mid, update_rtrees, NULL);
+}
+
+
 std::set<cpolyedge_t *>
 split_singular_seg(struct ON_Brep_CDT_State *s_cdt, cpolyedge_t *ce, int update_rtrees)
 {
@@ -1235,46 +1434,127 @@ initialize_loop_polygons(struct ON_Brep_CDT_State *s_cdt)
     return true;
 }
 
+struct tol_split_job {
+    struct ON_Brep_CDT_State *s_cdt;
+    std::vector<struct bseg_plan_t *> *plans;
+    size_t next;
+};
+
+static void
+tol_split_plan_worker(int UNUSED(cpu), void *data)
+{
+    struct tol_split_job *job = (struct tol_split_job *)data;
+    while (1) {
+	bu_semaphore_acquire(job->s_cdt->sem);
+	size_t i = job->next++;
+	bu_semaphore_release(job->s_cdt->sem);
+	if (i >= job->plans->size())
+	    return;
+
+	// Work out the full subdivision of this segment
+	std::queue<struct bseg_plan_t *> pq;
+	pq.push((*job->plans)[i]);
+	while (!pq.empty()) {
+	    struct bseg_plan_t *p = pq.front();
+	    pq.pop();
+	    if (!bseg_mid_eval(job->s_cdt, p, 0, NULL)) {
+		continue;
+	    }
+	    bseg_plan_subdivide(p);
+	    pq.push(p->sub[0]);
+	    pq.push(p->sub[1]);
+	}
+    }
+}
+
+// Split the segments of the specified edges per tolerance settings.  Whether a
+// segment needs splitting depends only on the segment itself, so the
+// subdivision of every segment (including the expensive curve and trim
+// evaluations) is worked out in parallel first.  The splits are then applied
+// in the same order the serial edge-by-edge loop used, so the result is the
+// same.
+static void
+tol_edges_split(struct ON_Brep_CDT_State *s_cdt, std::vector<int> &edges)
+{
+    std::map<bedge_seg_t *, struct bseg_plan_t *> pmap;
+    std::vector<struct bseg_plan_t *> plans;
+    for (size_t i = 0; i < edges.size(); i++) {
+	std::set<bedge_seg_t *> &epsegs = s_cdt->e2polysegs[edges[i]];
+	std::set<bedge_seg_t *>::iterator e_it;
+	for (e_it = epsegs.begin(); e_it != epsegs.end(); e_it++) {
+	    bedge_seg_t *b = *e_it;
+	    if (!b->tseg1 || !b->tseg2 || !b->nc) continue;
+	    struct bseg_plan_t *p = new struct bseg_plan_t;
+	    bseg_plan_init(s_cdt, p, b);
+	    plans.push_back(p);
+	    pmap[b] = p;
+	}
+    }
+
+    struct tol_split_job job;
+    job.s_cdt = s_cdt;
+    job.plans = &plans;
+    job.next = 0;
+    bu_parallel(tol_split_plan_worker, s_cdt->ncpus, &job);
+
+    for (size_t i = 0; i < edges.size(); i++) {
+	std::set<bedge_seg_t *> &epsegs = s_cdt->e2polysegs[edges[i]];
+	std::set<bedge_seg_t *>::iterator e_it;
+	std::set<bedge_seg_t *> new_segs;
+	std::set<bedge_seg_t *> ws1, ws2;
+	std::set<bedge_seg_t *> *ws = &ws1;
+	std::set<bedge_seg_t *> *ns = &ws2;
+	for (e_it = epsegs.begin(); e_it != epsegs.end(); e_it++) {
+	    bedge_seg_t *b = *e_it;
+	    ws->insert(b);
+	}
+	while (ws->size()) {
+	    bedge_seg_t *b = *ws->begin();
+	    ws->erase(ws->begin());
+	    std::map<bedge_seg_t *, struct bseg_plan_t *>::iterator p_it = pmap.find(b);
+	    struct bseg_plan_t *p = (p_it != pmap.end()) ? p_it->second : NULL;
+	    if (p && p->split) {
+		bedge_seg_t *nsegs[2];
+		pmap.erase(p_it);
+		bseg_split(s_cdt, b, &p->mid, 0, nsegs);
+		pmap[nsegs[0]] = p->sub[0];
+		pmap[nsegs[1]] = p->sub[1];
+		ns->insert(nsegs[0]);
+		ns->insert(nsegs[1]);
+	    } else {
+		new_segs.insert(b);
+	    }
+	    if (!ws->size() && ns->size()) {
+		std::set<bedge_seg_t *> *tmp = ws;
+		ws = ns;
+		ns = tmp;
+	    }
+	}
+	s_cdt->e2polysegs[edges[i]].clear();
+	s_cdt->e2polysegs[edges[i]] = new_segs;
+    }
+
+    for (size_t i = 0; i < plans.size(); i++) {
+	bseg_plan_free(plans[i]);
+    }
+}
+
 // Split curved edges per tolerance settings
 void
 tol_curved_edges_split(struct ON_Brep_CDT_State *s_cdt)
 {
     ON_Brep* brep = s_cdt->brep;
+    std::vector<int> edges;
     for (int index = 0; index < brep->m_E.Count(); index++) {
 	ON_BrepEdge& edge = brep->m_E[index];
 	const ON_Curve* crv = edge.EdgeCurveOf();
 	// TODO - BN_TOL_DIST will be too large for very small trims - need to do
 	// something similar to the ptol calculation for these edge curves...
 	if (crv && !crv->IsLinear(BN_TOL_DIST)) {
-	    std::set<bedge_seg_t *> &epsegs = s_cdt->e2polysegs[edge.m_edge_index];
-	    std::set<bedge_seg_t *>::iterator e_it;
-	    std::set<bedge_seg_t *> new_segs;
-	    std::set<bedge_seg_t *> ws1, ws2;
-	    std::set<bedge_seg_t *> *ws = &ws1;
-	    std::set<bedge_seg_t *> *ns = &ws2;
-	    for (e_it = epsegs.begin(); e_it != epsegs.end(); e_it++) {
-		bedge_seg_t *b = *e_it;
-		ws->insert(b);
-	    }
-	    while (ws->size()) {
-		bedge_seg_t *b = *ws->begin();
-		ws->erase(ws->begin());
-		std::set<bedge_seg_t *> esegs_split = split_edge_seg(s_cdt, b, 0, NULL, 0);
-		if (esegs_split.size()) {
-		    ns->insert(esegs_split.begin(), esegs_split.end());
-		} else {
-		    new_segs.insert(b);
-		}
-		if (!ws->size() && ns->size()) {
-		    std::set<bedge_seg_t *> *tmp = ws;
-		    ws = ns;
-		    ns = tmp;
-		}
-	    }
-	    s_cdt->e2polysegs[edge.m_edge_index].clear();
-	    s_cdt->e2polysegs[edge.m_edge_index] = new_segs;
+	    edges.push_back(edge.m_edge_index);
 	}
     }
+    tol_edges_split(s_cdt, edges);
 }
 
 // Calculate for each vertex involved with curved edges the minimum individual bedge_seg
@@ -1434,40 +1714,92 @@ tol_linear_edges_split(struct ON_Brep_CDT_State *s_cdt)
     // Calculate loop median segment lengths contributed from the curved edges
     update_loop_median_curved_edge_seg_lengths(s_cdt);
 
+    std::vector<int> edges;
     for (int index = 0; index < brep->m_E.Count(); index++) {
 	ON_BrepEdge& edge = brep->m_E[index];
 	const ON_Curve* crv = edge.EdgeCurveOf();
 	if (crv && crv->IsLinear(BN_TOL_DIST)) {
-	    std::set<bedge_seg_t *> &epsegs = s_cdt->e2polysegs[edge.m_edge_index];
-	    std::set<bedge_seg_t *>::iterator e_it;
-	    std::set<bedge_seg_t *> new_segs;
-	    std::set<bedge_seg_t *> ws1, ws2;
-	    std::set<bedge_seg_t *> *ws = &ws1;
-	    std::set<bedge_seg_t *> *ns = &ws2;
-	    for (e_it = epsegs.begin(); e_it != epsegs.end(); e_it++) {
-		bedge_seg_t *b = *e_it;
-		ws->insert(b);
-	    }
-	    while (ws->size()) {
-		bedge_seg_t *b = *ws->begin();
-		ws->erase(ws->begin());
-		std::set<bedge_seg_t *> esegs_split = split_edge_seg(s_cdt, b, 0, NULL, 0);
-		if (esegs_split.size()) {
-		    ns->insert(esegs_split.begin(), esegs_split.end());
-		} else {
-		    new_segs.insert(b);
-		}
-		if (!ws->size() && ns->size()) {
-		    std::set<bedge_seg_t *> *tmp = ws;
-		    ws = ns;
-		    ns = tmp;
-		}
-	    }
-	    s_cdt->e2polysegs[edge.m_edge_index].clear();
-	    s_cdt->e2polysegs[edge.m_edge_index] = new_segs;
+	    edges.push_back(edge.m_edge_index);
 	}
     }
+    tol_edges_split(s_cdt, edges);
+}
+
+// Below this many segments, checking a face's segments for close neighbors
+// isn't worth starting threads for.
+#define CLOSE_EDGES_PARALLEL_MIN 512
+#define CLOSE_EDGES_CHUNK 64
 
+// Search the face's 2D rtree for segments close to tseg.  The result is
+// recorded in tseg->split_status - nothing else is modified, so different
+// segments may be checked in parallel.
+static void
+close_edge_check(struct ON_Brep_CDT_State *s_cdt, RTree<void *, double, 2> *rtree, cpolyedge_t *tseg)
+{
+    ON_2dPoint p2d1(tseg->polygon->pnts_2d[tseg->v2d[0]].first, tseg->polygon->pnts_2d[tseg->v2d[0]].second);
+    ON_2dPoint p2d2(tseg->polygon->pnts_2d[tseg->v2d[1]].first, tseg->polygon->pnts_2d[tseg->v2d[1]].second);
+
+    // Trim 2D bbox
+    ON_Line line(p2d1, p2d2);
+    ON_BoundingBox bb = line.BoundingBox();
+    bb.m_max.x = bb.m_max.x + ON_ZERO_TOLERANCE;
+    bb.m_max.y = bb.m_max.y + ON_ZERO_TOLERANCE;
+    bb.m_min.x = bb.m_min.x - ON_ZERO_TOLERANCE;
+    bb.m_min.y = bb.m_min.y - ON_ZERO_TOLERANCE;
+    double dist = p2d1.DistanceTo(p2d2);
+    double bdist = 0.5*dist;
+    double xdist = bb.m_max.x - bb.m_min.x;
+    double ydist = bb.m_max.y - bb.m_min.y;
+    if (xdist < bdist) {
+	bb.m_min.x = bb.m_min.x - 0.51*bdist;
+	bb.m_max.x = bb.m_max.x + 0.51*bdist;
+    }
+    if (ydist < bdist) {
+	bb.m_min.y = bb.m_min.y - 0.51*bdist;
+	bb.m_max.y = bb.m_max.y + 0.51*bdist;
+    }
+
+    double tMin[2];
+    tMin[0] = bb.Min().x;
+    tMin[1] = bb.Min().y;
+    double tMax[2];
+    tMax[0] = bb.Max().x;
+    tMax[1] = bb.Max().y;
+
+    //plot_ce_bbox(s_cdt, tseg, "c.p3");
+
+    // Edge context info
+    struct rtree_minsplit_context a_context;
+    a_context.s_cdt = s_cdt;
+    a_context.cseg = tseg;
+
+    // Do the search
+    rtree->Search(tMin, tMax, MinSplit2dCallback, (void *)&a_context);
+}
+
+struct close_edges_job {
+    struct ON_Brep_CDT_State *s_cdt;
+    RTree<void *, double, 2> *rtree;
+    std::vector<cpolyedge_t *> *ws;
+    size_t next;
+};
+
+static void
+close_edges_worker(int UNUSED(cpu), void *data)
+{
+    struct close_edges_job *job = (struct close_edges_job *)data;
+    while (1) {
+	bu_semaphore_acquire(job->s_cdt->sem);
+	size_t start = job->next;
+	job->next += CLOSE_EDGES_CHUNK;
+	bu_semaphore_release(job->s_cdt->sem);
+	if (start >= job->ws->size())
+	    return;
+	size_t end = (start + CLOSE_EDGES_CHUNK < job->ws->size()) ? start + CLOSE_EDGES_CHUNK : job->ws->size();
+	for (size_t i = start; i < end; i++) {
+	    close_edge_check(job->s_cdt, job->rtree, (*job->ws)[i]);
+	}
+    }
 }
 
 void
@@ -1490,52 +1822,22 @@ refine_close_edges(struct ON_Brep_CDT_State *s_cdt)
 
 	    bool split_check = false;
 
-	    // TODO - with the status determination being recorded in the cpolyedge_t structure
-	    // itself, this loop should be (in principle) suitable for bu_parallel - we're not
-	    // doing any splitting at this point - searching is a read only activity once
-	    // the initial data containers are set up
-	    std::vector<cpolyedge_t *>::iterator w_it;
-	    for (w_it = ws.begin(); w_it != ws.end(); w_it++) {
-		cpolyedge_t *tseg = *w_it;
-		ON_2dPoint p2d1(tseg->polygon->pnts_2d[tseg->v2d[0]].first, tseg->polygon->pnts_2d[tseg->v2d[0]].second);
-		ON_2dPoint p2d2(tseg->polygon->pnts_2d[tseg->v2d[1]].first, tseg->polygon->pnts_2d[tseg->v2d[1]].second);
-
-		// Trim 2D bbox
-		ON_Line line(p2d1, p2d2);
-		ON_BoundingBox bb = line.BoundingBox();
-		bb.m_max.x = bb.m_max.x + ON_ZERO_TOLERANCE;
-		bb.m_max.y = bb.m_max.y + ON_ZERO_TOLERANCE;
-		bb.m_min.x = bb.m_min.x - ON_ZERO_TOLERANCE;
-		bb.m_min.y = bb.m_min.y - ON_ZERO_TOLERANCE;
-		double dist = p2d1.DistanceTo(p2d2);
-		double bdist = 0.5*dist;
-		double xdist = bb.m_max.x - bb.m_min.x;
-		double ydist = bb.m_max.y - bb.m_min.y;
-		if (xdist < bdist) {
-		    bb.m_min.x = bb.m_min.x - 0.51*bdist;
-		    bb.m_max.x = bb.m_max.x + 0.51*bdist;
+	    // The status determination is recorded in the cpolyedge_t structure
+	    // itself and we're not doing any splitting at this point - searching
+	    // is a read only activity once the initial data containers are set
+	    // up - so large segment sets are checked in parallel.
+	    RTree<void *, double, 2> *rtree = &s_cdt->face_rtrees_2d[face.m_face_index];
+	    if (ws.size() < CLOSE_EDGES_PARALLEL_MIN) {
+		for (size_t i = 0; i < ws.size(); i++) {
+		    close_edge_check(s_cdt, rtree, ws[i]);
 		}
-		if (ydist < bdist) {
-		    bb.m_min.y = bb.m_min.y - 0.51*bdist;
-		    bb.m_max.y = bb.m_max.y + 0.51*bdist;
-		}
-
-		double tMin[2];
-		tMin[0] = bb.Min().x;
-		tMin[1] = bb.Min().y;
-		double tMax[2];
-		tMax[0] = bb.Max().x;
-		tMax[1] = bb.Max().y;
-
-		//plot_ce_bbox(s_cdt, tseg, "c.p3");
-
-		// Edge context info
-		struct rtree_minsplit_context a_context;
-		a_context.s_cdt = s_cdt;
-		a_context.cseg = tseg;
-
-		// Do the search
-		s_cdt->face_rtrees_2d[face.m_face_index].Search(tMin, tMax, MinSplit2dCallback, (void *)&a_context);
+	    } else {
+		struct close_edges_job job;
+		job.s_cdt = s_cdt;
+		job.rtree = rtree;
+		job.ws = &ws;
+		job.next = 0;
+		bu_parallel(close_edges_worker, s_cdt->ncpus, &job);
 	    }
 
 	    // If we need to split, do so.  We need to process as a set,
@@ -1594,6 +1896,7 @@ refine_close_edges(struct ON_Brep_CDT_State *s_cdt)
 
 	    if (split_check) {
 		ws = current_trims;
+		std::vector<cpolyedge_t *>::iterator w_it;
 		for (w_it = ws.begin(); w_it != ws.end(); w_it++) {
 		    // We don't want to zero this status information if this is
 		    // our last iteration before bailing and we've still got
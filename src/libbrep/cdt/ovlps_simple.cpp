@@ -134,6 +134,53 @@ triangle_uedges(std::set<uedge_t> &uedges, std::set<uedge_t> &uskip, triangle_t
     uskip.insert(ue);
 }
 
+struct ovlp_pairs_job {
+    std::vector<std::pair<cdt_mesh_t *, cdt_mesh_t *>> *pairs;
+    std::vector<std::vector<std::pair<cdt_mesh_t *, long>>> *tris;
+    int mode;
+    int sem;
+    size_t next;
+};
+
+// Find the intersecting triangles of a pair of faces from different
+// breps.  Only reads the meshes - results go into the pair's own slot in
+// job->tris.
+static void
+ovlp_pairs_worker(int UNUSED(cpu), void *data)
+{
+    struct ovlp_pairs_job *job = (struct ovlp_pairs_job *)data;
+    while (1) {
+	bu_semaphore_acquire(job->sem);
+	size_t i = job->next++;
+	bu_semaphore_release(job->sem);
+	if (i >= job->pairs->size())
+	    return;
+
+	cdt_mesh_t *fmesh1 = (*job->pairs)[i].first;
+	cdt_mesh_t *fmesh2 = (*job->pairs)[i].second;
+	struct ON_Brep_CDT_State *s_cdt1 = (struct ON_Brep_CDT_State *)fmesh1->p_cdt;
+	struct ON_Brep_CDT_State *s_cdt2 = (struct ON_Brep_CDT_State *)fmesh2->p_cdt;
+	if (s_cdt1 == s_cdt2)
+	    continue;
+
+	std::vector<std::pair<cdt_mesh_t *, long>> &ptris = (*job->tris)[i];
+	std::set<std::pair<size_t, size_t>> tris_prelim;
+	size_t ovlp_cnt = fmesh1->tris_tree.Overlaps(fmesh2->tris_tree, &tris_prelim);
+	if (!ovlp_cnt)
+	    continue;
+	std::set<std::pair<size_t, size_t>>::iterator tb_it;
+	for (tb_it = tris_prelim.begin(); tb_it != tris_prelim.end(); tb_it++) {
+	    triangle_t t1 = fmesh1->tris_vect[tb_it->first];
+	    triangle_t t2 = fmesh2->tris_vect[tb_it->second];
+	    int isect = tri_isect(t1, t2, job->mode);
+	    if (isect) {
+		ptris.push_back(std::make_pair(t1.m, t1.ind));
+		ptris.push_back(std::make_pair(t2.m, t2.ind));
+	    }
+	}
+    }
+}
+
 int
 mesh_ovlps(
 	std::map<cdt_mesh_t *, std::set<uedge_t>> *iedges,
@@ -152,45 +199,23 @@ mesh_ovlps(
     std::set<cdt_mesh_t *>::iterator a_it;
 
     // Intersect first the triangle RTrees, then any potentially
-    // overlapping triangles found within the leaves.
+    // overlapping triangles found within the leaves.  The meshes are not
+    // modified here, so the face pairs are checked in parallel and the
+    // results merged afterwards.
+    std::vector<std::pair<cdt_mesh_t *, cdt_mesh_t *>> pairs(check_pairs.begin(), check_pairs.end());
+    std::vector<std::vector<std::pair<cdt_mesh_t *, long>>> pair_tris(pairs.size());
+    struct ovlp_pairs_job job;
+    job.pairs = &pairs;
+    job.tris = &pair_tris;
+    job.mode = mode;
+    job.sem = bu_semaphore_register("BREP_CDT_SEM");
+    job.next = 0;
+    bu_parallel(ovlp_pairs_worker, 0, &job);
+
     std::map<cdt_mesh_t *, std::set<long>> itris;
-    std::set<std::pair<cdt_mesh_t *, cdt_mesh_t *>>::iterator cp_it;
-    for (cp_it = check_pairs.begin(); cp_it != check_pairs.end(); cp_it++) {
-	cdt_mesh_t *fmesh1 = cp_it->first;
-	cdt_mesh_t *fmesh2 = cp_it->second;
-	struct ON_Brep_CDT_State *s_cdt1 = (struct ON_Brep_CDT_State *)fmesh1->p_cdt;
-	struct ON_Brep_CDT_State *s_cdt2 = (struct ON_Brep_CDT_State *)fmesh2->p_cdt;
-	//fmesh1->tris_rtree_plot("tree1.plot3");
-	//fmesh2->tris_rtree_plot("tree2.plot3");
-	if (s_cdt1 != s_cdt2) {
-	    std::set<std::pair<size_t, size_t>> tris_prelim;
-	    size_t ovlp_cnt = fmesh1->tris_tree.Overlaps(fmesh2->tris_tree, &tris_prelim);
-	    if (ovlp_cnt) {
-		std::set<std::pair<size_t, size_t>>::iterator tb_it;
-#if 0
-		std::set<size_t> tris_p1, tris_p2;
-		for (tb_it = tris_prelim.begin(); tb_it != tris_prelim.end(); tb_it++) {
-		    tris_p1.insert(tb_it->first);
-		    tris_p2.insert(tb_it->second);
-		}
-		fmesh1->tris_set_plot(tris_p1,"tp1.plot3");
-		fmesh2->tris_set_plot(tris_p2,"tp2.plot3");
-		std::set<size_t> tris_i1, tris_i2;
-#endif
-		for (tb_it = tris_prelim.begin(); tb_it != tris_prelim.end(); tb_it++) {
-		    triangle_t t1 = fmesh1->tris_vect[tb_it->first];
-		    triangle_t t2 = fmesh2->tris_vect[tb_it->second];
-		    int isect = tri_isect(t1, t2, mode);
-		    if (isect) {
-			itris[t1.m].insert(t1.ind);
-			itris[t2.m].insert(t2.ind);
-			//tris_i1.insert(t1.ind);
-			//tris_i2.insert(t2.ind);
-		    }
-		}
-		//fmesh1->tris_set_plot(tris_i1,"ti1.plot3");
-		//fmesh2->tris_set_plot(tris_i2,"ti2.plot3");
-	    }
+    for (size_t i = 0; i < pair_tris.size(); i++) {
+	for (size_t j = 0; j < pair_tris[i].size(); j++) {
+	    itris[pair_tris[i][j].first].insert(pair_tris[i][j].second);
 	}
     }
 
@@ -454,15 +454,21 @@ cdt_ainfo(int fid, int vid, int tid, int eid, fastf_t x2d, fastf_t y2d, fastf_t
 void
 CDT_Add3DPnt(struct ON_Brep_CDT_State *s, ON_3dPoint *p, int fid, int vid, int tid, int eid, fastf_t x2d, fastf_t y2d)
 {
+    struct cdt_audit_info *ainfo = cdt_ainfo(fid, vid, tid, eid, x2d, y2d, 0.0, 0.0, 0.0);
+    bu_semaphore_acquire(s->sem);
     s->w3dpnts->push_back(p);
-    (*s->pnt_audit_info)[p] = cdt_ainfo(fid, vid, tid, eid, x2d, y2d, 0.0, 0.0, 0.0);
+    (*s->pnt_audit_info)[p] = ainfo;
+    bu_semaphore_release(s->sem);
 }
 
 void
 CDT_Add3DNorm(struct ON_Brep_CDT_State *s, ON_3dPoint *normal, ON_3dPoint *vert, int fid, int vid, int tid, int eid, fastf_t x2d, fastf_t y2d)
 {
+    struct cdt_audit_info *ainfo = cdt_ainfo(fid, vid, tid, eid, x2d, y2d, vert->x, vert->y, vert->z);
+    bu_semaphore_acquire(s->sem);
     s->w3dnorms->push_back(normal);
-    (*s->pnt_audit_info)[normal] = cdt_ainfo(fid, vid, tid, eid, x2d, y2d, vert->x, vert->y, vert->z);
+    (*s->pnt_audit_info)[normal] = ainfo;
+    bu_semaphore_release(s->sem);
 }
 
 // Digest tessellation tolerances...
@@ -519,6 +525,8 @@ ON_Brep_CDT_Create(void *bv, const char *objname)
     cdt->tol.rel_lmax = -1;
     cdt->tol.rel_lmin = -1;
 
+    cdt->ncpus = 0;
+
     cdt->w3dpnts = new std::vector<ON_3dPoint *>;
     cdt->w3dnorms = new std::vector<ON_3dPoint *>;
 
@@ -535,6 +543,8 @@ ON_Brep_CDT_Create(void *bv, const char *objname)
 
     cdt->bot_pnt_to_on_pnt = new std::map<int, ON_3dPoint *>;
 
+    cdt->sem = bu_semaphore_register("BREP_CDT_SEM");
+
     return cdt;
 }
 
@@ -702,6 +712,16 @@ ON_Brep_CDT_Tol_Set(struct ON_Brep_CDT_State *s, const struct bg_tess_tol *t)
     }
 }
 
+void
+ON_Brep_CDT_Ncpus_Set(struct ON_Brep_CDT_State *s, int ncpus)
+{
+    if (!s) {
+	return;
+    }
+
+    s->ncpus = (ncpus > 0) ? ncpus : 0;
+}
+
 void
 ON_Brep_CDT_Tol_Get(struct bg_tess_tol *t, const struct ON_Brep_CDT_State *s)
 {
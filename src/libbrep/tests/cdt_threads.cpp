@@ -0,0 +1,168 @@
+/*                 C D T _ T H R E A D S . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file cdt_threads.cpp
+ *
+ * Check that tessellating a brep with one thread and with several
+ * produces exactly the same mesh.
+ *
+ */
+
+#include "common.h"
+
+#include <string.h>
+
+#include "bu/app.h"
+#include "bu/log.h"
+#include "bu/malloc.h"
+#include "bu/parallel.h"
+#include "brep.h"
+
+
+struct cdt_mesh_out {
+    int *faces;
+    int fcnt;
+    fastf_t *vertices;
+    int vcnt;
+    int *face_normals;
+    int fncnt;
+    fastf_t *normals;
+    int ncnt;
+};
+
+
+static int
+tessellate(struct cdt_mesh_out *m, ON_Brep *brep, const char *name, int ncpus)
+{
+    struct bg_tess_tol ttol = BG_TESS_TOL_INIT_ZERO;
+    ttol.rel = 0.005;
+    ttol.norm = 0.1;
+
+    memset(m, 0, sizeof(struct cdt_mesh_out));
+
+    struct ON_Brep_CDT_State *s_cdt = ON_Brep_CDT_Create((void *)brep, name);
+    ON_Brep_CDT_Tol_Set(s_cdt, &ttol);
+    ON_Brep_CDT_Ncpus_Set(s_cdt, ncpus);
+    if (ON_Brep_CDT_Tessellate(s_cdt, 0, NULL)) {
+	bu_log("%s: tessellation with %d thread(s) failed\n", name, ncpus);
+	ON_Brep_CDT_Destroy(s_cdt);
+	return -1;
+    }
+    ON_Brep_CDT_Mesh(&m->faces, &m->fcnt, &m->vertices, &m->vcnt, &m->face_normals, &m->fncnt, &m->normals, &m->ncnt, s_cdt, 0, NULL);
+    ON_Brep_CDT_Destroy(s_cdt);
+
+    return 0;
+}
+
+
+static void
+mesh_free(struct cdt_mesh_out *m)
+{
+    if (m->faces)
+	bu_free(m->faces, "faces");
+    if (m->vertices)
+	bu_free(m->vertices, "vertices");
+    if (m->face_normals)
+	bu_free(m->face_normals, "face_normals");
+    if (m->normals)
+	bu_free(m->normals, "normals");
+}
+
+
+/* Returns 0 if the serial and parallel meshes are identical */
+static int
+compare(ON_Brep *brep, const char *name, int ncpus)
+{
+    struct cdt_mesh_out s, p;
+    int ret = 0;
+
+    if (tessellate(&s, brep, name, 1) || tessellate(&p, brep, name, ncpus)) {
+	mesh_free(&s);
+	mesh_free(&p);
+	return 1;
+    }
+
+    if (!s.fcnt) {
+	bu_log("%s: empty mesh\n", name);
+	ret = 1;
+    } else if (s.fcnt != p.fcnt || s.vcnt != p.vcnt || s.fncnt != p.fncnt || s.ncnt != p.ncnt) {
+	bu_log("%s: 1 thread gave %d faces, %d vertices, %d normals; %d threads gave %d faces, %d vertices, %d normals\n",
+	       name, s.fcnt, s.vcnt, s.ncnt, ncpus, p.fcnt, p.vcnt, p.ncnt);
+	ret = 1;
+    } else if (memcmp(s.faces, p.faces, s.fcnt * 3 * sizeof(int))
+	       || memcmp(s.vertices, p.vertices, s.vcnt * 3 * sizeof(fastf_t))
+	       || (s.fncnt && memcmp(s.face_normals, p.face_normals, s.fncnt * 3 * sizeof(int)))
+	       || (s.ncnt && memcmp(s.normals, p.normals, s.ncnt * 3 * sizeof(fastf_t)))) {
+	bu_log("%s: 1 and %d thread meshes differ\n", name, ncpus);
+	ret = 1;
+    } else {
+	bu_log("%s: %d faces, %d vertices match\n", name, s.fcnt, s.vcnt);
+    }
+
+    mesh_free(&s);
+    mesh_free(&p);
+    return ret;
+}
+
+
+int
+main(int UNUSED(argc), const char *argv[])
+{
+    int ret = 0;
+
+    bu_setprogname(argv[0]);
+
+    // Use several threads even on a single processor machine, the
+    // point is to interleave the work differently
+    int ncpus = bu_avail_cpus();
+    if (ncpus < 4)
+	ncpus = 4;
+
+    ON_Sphere sph(ON_3dPoint(0, 0, 0), 10.0);
+    ON_Brep *sph_brep = ON_BrepSphere(sph);
+    ret += compare(sph_brep, "sphere", ncpus);
+    delete sph_brep;
+
+    ON_Cylinder cyl(ON_Circle(ON_Plane::World_xy, 5.0), 20.0);
+    ON_Brep *cyl_brep = ON_BrepCylinder(cyl, true, true);
+    ret += compare(cyl_brep, "cylinder", ncpus);
+    delete cyl_brep;
+
+    ON_Torus tor(ON_Plane::World_xy, 10.0, 3.0);
+    ON_Brep *tor_brep = ON_BrepTorus(tor);
+    ret += compare(tor_brep, "torus", ncpus);
+    delete tor_brep;
+
+    if (ret) {
+	bu_log("brep CDT thread comparison [FAIL]\n");
+	return 1;
+    }
+
+    bu_log("brep CDT thread comparison [PASS]\n");
+    return 0;
+}
+
+// Local Variables:
+// tab-width: 8
+// mode: C++
+// c-basic-offset: 4
+// indent-tabs-mode: t
+// c-file-style: "stroustrup"
+// End:
+// ex: shiftwidth=4 tabstop=8
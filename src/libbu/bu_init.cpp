@@ -49,6 +49,7 @@ int BU_SEM_MAPPEDFILE;
 /* These ARE NOT exported outside LIBBU */
 extern "C" int BU_SEM_DATETIME;
 extern "C" int BU_SEM_DIR;
+extern "C" int BU_SEM_HEAP;
 extern "C" int BU_SEM_MALLOC;
 extern "C" int BU_SEM_THREAD;
 
@@ -66,6 +67,7 @@ libbu_init(void)
     BU_SEMAPHORE_DEFINE(BU_SEM_MALLOC);
     BU_SEMAPHORE_DEFINE(BU_SEM_DATETIME);
     BU_SEMAPHORE_DEFINE(BU_SEM_DIR);
+    BU_SEMAPHORE_DEFINE(BU_SEM_HEAP);
 
     bu_getiwd(iwd, MAXPATHLEN);
 }
@@ -21,6 +21,7 @@
 #include "common.h"
 
 #include <stdlib.h> /* for getenv, atoi, and atexit */
+#include <string.h> /* for memcpy and memset */
 
 #include "bu/debug.h"
 #include "bu/log.h"
@@ -58,6 +59,21 @@
 #define HEAP_PAGESIZE (HEAP_BINS * 256)
 
 
+/**
+ * Number of freed blocks moved between a thread's free list and the
+ * shared depot at a time.  A thread holds on to at most twice this
+ * many free blocks of any one size before giving a batch back.
+ */
+#define HEAP_BATCH 64
+
+/**
+ * Freed blocks are kept on singly-linked lists threaded through
+ * their own first bytes, so every block must be able to hold a
+ * pointer.
+ */
+#define HEAP_BLOCKSIZE(_sz) (((_sz) < sizeof(char *)) ? sizeof(char *) : (_sz))
+
+
 struct heap {
     /**
      * pages is an array of memory pages.  they are allocated one at a
@@ -76,6 +92,14 @@ struct heap {
      * allocated to callers.  not a counter to avoid a multiply.
      */
     size_t given;
+
+    /** blocks released with bu_heap_put(), ready for reuse */
+    char *freelist;
+    size_t nfree;
+
+    /** statistics */
+    size_t puts;
+    size_t reused;
 };
 
 struct cpus {
@@ -90,7 +114,91 @@ struct cpus {
  * store data in a cpu-specific structure so we can avoid the need for
  * mutex locking entirely.  relies on static zero-initialization.
  */
-static struct cpus per_cpu[MAX_PSW] = {{{{0, 0, 0}}, 0}};
+static struct cpus per_cpu[MAX_PSW];
+
+/**
+ * Free blocks shared between threads, protected by BU_SEM_HEAP.
+ * Threads hand over batches of blocks when they have freed more than
+ * they are likely to reuse (e.g., memory allocated by one thread and
+ * released by another) and take batches back before carving new
+ * memory out of their pages.
+ */
+struct depot {
+    char *blocks;
+    size_t count;
+};
+
+static struct depot depot[HEAP_BINS];
+
+int BU_SEM_HEAP;
+
+
+static inline char *
+heap_next(const char *block)
+{
+    char *next;
+    memcpy(&next, block, sizeof(char *));
+    return next;
+}
+
+
+static inline void
+heap_link(char *block, char *next)
+{
+    memcpy(block, &next, sizeof(char *));
+}
+
+
+/* move up to n blocks from the front of a thread's free list to the depot */
+static void
+heap_flush(struct heap *heap, size_t bin, size_t n)
+{
+    char *first = heap->freelist;
+    char *last = first;
+    size_t i;
+
+    if (!first || !n)
+	return;
+
+    for (i = 1; i < n && heap_next(last); i++)
+	last = heap_next(last);
+
+    heap->freelist = heap_next(last);
+    heap->nfree -= i;
+
+    bu_semaphore_acquire(BU_SEM_HEAP);
+    heap_link(last, depot[bin].blocks);
+    depot[bin].blocks = first;
+    depot[bin].count += i;
+    bu_semaphore_release(BU_SEM_HEAP);
+}
+
+
+/* take a batch of blocks from the depot onto an empty thread free list */
+static void
+heap_refill(struct heap *heap, size_t bin)
+{
+    char *first;
+    char *last;
+    size_t i;
+
+    bu_semaphore_acquire(BU_SEM_HEAP);
+    first = last = depot[bin].blocks;
+    if (!first) {
+	bu_semaphore_release(BU_SEM_HEAP);
+	return;
+    }
+    for (i = 1; i < HEAP_BATCH && heap_next(last); i++)
+	last = heap_next(last);
+    depot[bin].blocks = heap_next(last);
+    depot[bin].count -= i;
+    bu_semaphore_release(BU_SEM_HEAP);
+
+    heap_link(last, heap->freelist);
+    heap->freelist = first;
+    heap->nfree += i;
+}
+
 
 /* Need a function signature that matches bu_heap_func_t, so wrap bu_log in
  * order to allow it to act as the default bu_heap_log function. */
@@ -129,9 +237,11 @@ heap_print(void)
     size_t h, i;
     size_t allocs = 0;
     size_t misses = 0;
-    size_t got = 0;
+    size_t puts = 0;
+    size_t reused = 0;
+    size_t cached = 0;
+    size_t cached_bytes = 0;
     size_t total_pages = 0;
-    size_t ncpu = bu_avail_cpus();
 
     bu_heap_func_t log = bu_heap_log(NULL);
 
@@ -148,36 +258,61 @@ heap_print(void)
 	"Memory Heap Information\n"
 	"-----------------------\n", NULL);
 
-    for (h=0; h < ncpu; h++) {
-	for (i=0; i < HEAP_BINS; i++) {
-
-	    /* capacity across all pages */
-	    got = per_cpu[h].heap[i].count * (HEAP_PAGESIZE/(i+1));
-
-	    if (got > 0) {
-		/* last page is partial */
-		got -= (HEAP_PAGESIZE - per_cpu[h].heap[i].given)/(i+1);
-		bu_vls_sprintf(&str, "%04zu [%02zu] => %zu\n", i, per_cpu[h].heap[i].count, got);
-		log(bu_vls_addr(&str), NULL);
-		allocs += got;
+    for (i=0; i < HEAP_BINS; i++) {
+	size_t bsz = HEAP_BLOCKSIZE(i+1);
+	size_t pages = 0;
+	size_t got = 0;
+	size_t bin_puts = 0;
+	size_t bin_reused = 0;
+	size_t bin_free = depot[i].count;
+
+	for (h=0; h < MAX_PSW; h++) {
+	    const struct heap *heap = &per_cpu[h].heap[i];
+
+	    if (heap->count > 0) {
+		/* capacity across all pages, last page is partial */
+		got += heap->count * (HEAP_PAGESIZE/bsz);
+		got -= (HEAP_PAGESIZE - heap->given)/bsz;
 	    }
-	    total_pages += per_cpu[h].heap[i].count;
+	    pages += heap->count;
+	    bin_puts += heap->puts;
+	    bin_reused += heap->reused;
+	    bin_free += heap->nfree;
 	}
-	misses += per_cpu[h].misses;
+
+	if (got > 0 || bin_reused > 0) {
+	    bu_vls_sprintf(&str, "%04zu [%02zu] => %zu (%zu reused, %zu put, %zu free)\n", i+1, pages, got + bin_reused, bin_reused, bin_puts, bin_free);
+	    log(bu_vls_addr(&str), NULL);
+	}
+
+	allocs += got + bin_reused;
+	puts += bin_puts;
+	reused += bin_reused;
+	cached += bin_free;
+	cached_bytes += bin_free * bsz;
+	total_pages += pages;
     }
+    for (h=0; h < MAX_PSW; h++)
+	misses += per_cpu[h].misses;
+
     bu_vls_sprintf(&str, "-----------------------\n"
 		   "size [pages] => count\n"
 		   "Heap range: 1-%d bytes\n"
 		   "Page size: %d bytes\n"
 		   "Pages: %zu (%.2lfMB)\n"
 		   "%zu allocs, %zu misses\n"
+		   "%zu puts, %zu reused, %zu free (%.2lfMB)\n"
 		   "=======================\n",
 		   HEAP_BINS,
 		   HEAP_PAGESIZE,
 		   total_pages,
 		   (double)(total_pages * HEAP_PAGESIZE) / (1024.0*1024.0),
 		   allocs,
-		   misses);
+		   misses,
+		   puts,
+		   reused,
+		   cached,
+		   (double)cached_bytes / (1024.0*1024.0));
     log(bu_vls_addr(&str), NULL);
     bu_vls_free(&str);
 }
@@ -190,15 +325,26 @@ bu_heap_get(size_t sz)
     register size_t smo = sz-1;
     static int registered = 0;
     int oncpu;
+    size_t bsz;
     struct heap *heap;
 
+    if (UNLIKELY(registered == 0)) {
+	if (registered++ == 0) {
+	    ret = getenv("BU_HEAP_PRINT");
+	    if (ret && atoi(ret) > 0) {
+		atexit(heap_print);
+	    }
+	}
+    }
+
     /* what thread are we? */
     oncpu = bu_parallel_id();
 
-#ifdef DEBUG
-    if (sz > HEAP_BINS || sz == 0) {
-	per_cpu[oncpu].misses++;
+    if (UNLIKELY(sz > HEAP_BINS || sz == 0)) {
+	if (oncpu < MAX_PSW)
+	    per_cpu[oncpu].misses++;
 
+#ifdef DEBUG
 	if (bu_debug) {
 	    bu_log("DEBUG: heap size %zd out of range\n", sz);
 
@@ -206,22 +352,34 @@ bu_heap_get(size_t sz)
 		bu_bomb("Intentionally bombing due to BU_DEBUG_COREDUMP\n");
 	    }
 	}
+#endif
 	return bu_calloc(1, sz, "heap calloc");
     }
-#endif
+
+    bsz = HEAP_BLOCKSIZE(sz);
+
+    /* nested bu_parallel() IDs can exceed our per-cpu table.  a
+     * block of the right size is all bu_heap_put() needs.
+     */
+    if (UNLIKELY(oncpu >= MAX_PSW))
+	return bu_calloc(1, bsz, "heap calloc");
 
     heap = &per_cpu[oncpu].heap[smo];
 
+    /* reuse */
+    if (!heap->freelist && depot[smo].blocks)
+	heap_refill(heap, smo);
+    if (heap->freelist) {
+	ret = heap->freelist;
+	heap->freelist = heap_next(ret);
+	heap->nfree--;
+	heap->reused++;
+	memset(ret, 0, bsz);
+	return (void *)ret;
+    }
+
     /* init */
     if (heap->count == 0) {
-
-	if (registered++ == 0) {
-	    ret = getenv("BU_HEAP_PRINT");
-	    if ((++registered == 2) && (ret && atoi(ret) > 0)) {
-		atexit(heap_print);
-	    }
-	}
-
 	heap->count++;
 	heap->pages = (char **)bu_malloc(1 * sizeof(char *), "heap malloc pages[]");
 	heap->pages[0] = (char *)bu_calloc(1, HEAP_PAGESIZE, "heap calloc pages[][0]");
@@ -229,7 +387,7 @@ bu_heap_get(size_t sz)
     }
 
     /* grow */
-    if (heap->given+sz > HEAP_PAGESIZE) {
+    if (heap->given+bsz > HEAP_PAGESIZE) {
 	heap->count++;
 	heap->pages = (char **)bu_realloc(heap->pages, heap->count * sizeof(char *), "heap realloc pages[]");
 	heap->pages[heap->count-1] = (char *)bu_calloc(1, HEAP_PAGESIZE, "heap calloc pages[][]");
@@ -238,7 +396,7 @@ bu_heap_get(size_t sz)
 
     /* give */
     ret = &(heap->pages[heap->count-1][heap->given]);
-    heap->given += sz;
+    heap->given += bsz;
 
     return (void *)ret;
 }
@@ -247,14 +405,48 @@ bu_heap_get(size_t sz)
 void
 bu_heap_put(void *ptr, size_t sz)
 {
+    int oncpu;
+    size_t smo = sz-1;
+    struct heap *heap;
+
+    oncpu = bu_parallel_id();
+
+    if (!ptr) {
+	/* compaction request, hand all of our free blocks to the
+	 * other threads.
+	 */
+	size_t i;
+	if (oncpu >= MAX_PSW)
+	    return;
+	for (i = 0; i < HEAP_BINS; i++)
+	    heap_flush(&per_cpu[oncpu].heap[i], i, per_cpu[oncpu].heap[i].nfree);
+	return;
+    }
+
     if (sz > HEAP_BINS || sz == 0) {
 	bu_free(ptr, "heap free");
 	return;
     }
 
-    /* TODO: actually do something useful :) */
+    if (UNLIKELY(oncpu >= MAX_PSW)) {
+	bu_semaphore_acquire(BU_SEM_HEAP);
+	heap_link((char *)ptr, depot[smo].blocks);
+	depot[smo].blocks = (char *)ptr;
+	depot[smo].count++;
+	bu_semaphore_release(BU_SEM_HEAP);
+	return;
+    }
+
+    heap = &per_cpu[oncpu].heap[smo];
+
+    heap_link((char *)ptr, heap->freelist);
+    heap->freelist = (char *)ptr;
+    heap->nfree++;
+    heap->puts++;
 
-    return;
+    /* we're holding on to more than we're likely to need again */
+    if (UNLIKELY(heap->nfree >= 2*HEAP_BATCH))
+	heap_flush(heap, smo, HEAP_BATCH);
 }
 
 
@@ -357,28 +357,64 @@ bu_shmget(int *shmid, char **shared_memory, int key, size_t size)
 }
 
 
+/**
+ * Pool memory chunks, each header immediately followed by the chunk
+ * memory.  used is only kept up to date once a chunk is no longer
+ * current.
+ */
+struct bu_pool_chunk {
+    struct bu_pool_chunk *prev;
+    size_t size;
+    size_t used;
+};
+
+#define POOL_ROUNDUP(_n) (((_n) + (BU_POOL_ALIGN-1)) & ~((size_t)BU_POOL_ALIGN-1))
+#define POOL_HDRSIZE POOL_ROUNDUP(sizeof(struct bu_pool_chunk))
+#define POOL_DATA(_c) ((uint8_t *)(_c) + POOL_HDRSIZE)
+
+
+static void
+pool_set_chunk(struct bu_pool *pool, struct bu_pool_chunk *chunk, size_t pos)
+{
+    pool->chunk = chunk;
+    pool->block = chunk ? POOL_DATA(chunk) : NULL;
+    pool->alloc_size = chunk ? chunk->size : 0;
+    pool->block_pos = pos;
+}
+
+
 struct bu_pool *
 bu_pool_create(size_t block_size)
 {
     struct bu_pool *pool;
 
     pool = (struct bu_pool*)bu_malloc(sizeof(struct bu_pool), "bu_pool_create");
-    pool->block_size = block_size;
-    pool->block_pos = 0;
-    pool->alloc_size = 0;
-    pool->block = NULL;
+    pool->block_size = POOL_ROUNDUP(block_size ? block_size : 1);
+    pool->used = 0;
+    pool_set_chunk(pool, NULL, 0);
     return pool;
 }
 
+
 void *
 bu_pool_alloc(struct bu_pool *pool, size_t nelem, size_t elsize)
 {
-    const size_t n_bytes = nelem * elsize;
+    const size_t n_bytes = POOL_ROUNDUP(nelem * elsize);
     void *ret;
 
-    if (pool->block_pos + n_bytes > pool->alloc_size) {
-	pool->alloc_size += (n_bytes < pool->block_size ? pool->block_size : n_bytes);
-	pool->block = (uint8_t*)bu_realloc(pool->block, pool->alloc_size, "bu_pool_alloc");
+    if (UNLIKELY(pool->block_pos + n_bytes > pool->alloc_size)) {
+	struct bu_pool_chunk *chunk;
+	size_t size = (n_bytes < pool->block_size ? pool->block_size : n_bytes);
+
+	chunk = (struct bu_pool_chunk *)bu_malloc(POOL_HDRSIZE + size, "bu_pool_alloc");
+	chunk->prev = pool->chunk;
+	chunk->size = size;
+	chunk->used = 0;
+	if (pool->chunk) {
+	    pool->chunk->used = pool->block_pos;
+	    pool->used += pool->block_pos;
+	}
+	pool_set_chunk(pool, chunk, 0);
     }
 
     ret = pool->block + pool->block_pos;
@@ -386,10 +422,85 @@ bu_pool_alloc(struct bu_pool *pool, size_t nelem, size_t elsize)
     return ret;
 }
 
+
+void
+bu_pool_save(const struct bu_pool *pool, struct bu_pool_mark *mark)
+{
+    mark->chunk = pool->chunk;
+    mark->block_pos = pool->block_pos;
+}
+
+
+void
+bu_pool_rewind(struct bu_pool *pool, const struct bu_pool_mark *mark)
+{
+    while (pool->chunk != mark->chunk) {
+	struct bu_pool_chunk *prev;
+
+	if (!pool->chunk)
+	    bu_bomb("bu_pool_rewind: mark does not belong to this pool\n");
+
+	prev = pool->chunk->prev;
+	bu_free(pool->chunk, "bu_pool_rewind");
+	if (prev)
+	    pool->used -= prev->used;
+	pool_set_chunk(pool, prev, prev ? prev->used : 0);
+    }
+    pool->block_pos = mark->block_pos;
+}
+
+
+void
+bu_pool_reset(struct bu_pool *pool)
+{
+    struct bu_pool_mark first = {NULL, 0};
+
+    if (!pool->chunk)
+	return;
+
+    first.chunk = pool->chunk;
+    while (first.chunk->prev)
+	first.chunk = first.chunk->prev;
+
+    bu_pool_rewind(pool, &first);
+    pool->block_pos = 0;
+}
+
+
+size_t
+bu_pool_used(const struct bu_pool *pool)
+{
+    return pool->used + pool->block_pos;
+}
+
+
+void
+bu_pool_copy(const struct bu_pool *pool, void *dest)
+{
+    const struct bu_pool_chunk *chunk;
+    size_t offset = pool->used;
+
+    if (!pool->chunk)
+	return;
+
+    memcpy((uint8_t *)dest + offset, pool->block, pool->block_pos);
+    for (chunk = pool->chunk->prev; chunk; chunk = chunk->prev) {
+	offset -= chunk->used;
+	memcpy((uint8_t *)dest + offset, POOL_DATA(chunk), chunk->used);
+    }
+}
+
+
 void
 bu_pool_delete(struct bu_pool *pool)
 {
-    bu_free(pool->block, "bu_pool_delete");
+    struct bu_pool_chunk *chunk = pool->chunk;
+
+    while (chunk) {
+	struct bu_pool_chunk *prev = chunk->prev;
+	bu_free(chunk, "bu_pool_delete");
+	chunk = prev;
+    }
     bu_free(pool, "bu_pool_delete");
 }
 
@@ -118,6 +118,11 @@
 
 /* #define CPP11THREAD */
 
+/* persistent thread pool, see parallel_pool_run() */
+#if defined(PARALLEL) && defined(HAVE_PTHREAD_H) && !(defined(HAVE_THREAD_LOCAL) && defined(CPP11THREAD))
+#  define PARALLEL_POOL 1
+#endif
+
 
 #if defined(HAVE_SYSCALL) && !defined(HAVE_DECL_SYSCALL) && !defined(syscall)
 long syscall(long number, ...);
@@ -155,6 +160,22 @@ struct thread_data {
 };
 
 
+/* a queued bu_parallel() invocation or task group task */
+struct pool_job {
+    struct pool_job *next;
+    struct thread_data td;
+    struct bu_task_group *group;	/* NULL for bu_parallel() jobs */
+    size_t *remaining;			/* bu_parallel() jobs left to finish */
+};
+
+
+struct bu_task_group {
+    struct pool_job *head;	/* queued tasks, when not using the pool */
+    struct pool_job *tail;
+    size_t remaining;		/* tasks submitted but not yet finished */
+};
+
+
 int
 bu_thread_id(void)
 {
@@ -495,6 +516,220 @@ parallel_interface_arg_stub(struct thread_data *user_thread_data)
 #endif /* PARALLEL */
 
 
+#ifdef PARALLEL_POOL
+
+/* Persistent thread pool behind bu_parallel() and the task group
+ * API.  Threads are created lazily and never exit; idle threads wait
+ * on pool.work.
+ *
+ * bu_parallel() jobs each need a thread of their own right away, as
+ * the callbacks may depend on each other (e.g., nested calls), so the
+ * pool grows until every queued job has a free thread.  Task group
+ * jobs queue up behind those and use at most bu_avail_cpus() threads.
+ */
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t work;	/* signaled when a job is queued */
+    pthread_cond_t done;	/* broadcast when a job finishes */
+    struct pool_job *par_head;	/* bu_parallel() jobs */
+    struct pool_job *par_tail;
+    struct pool_job *task_head;	/* task group jobs */
+    struct pool_job *task_tail;
+    size_t npar_queued;
+    size_t nthreads;
+    size_t nbusy;
+    size_t ntasks_running;
+    size_t task_limit;
+    int atfork;
+} pool = {
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER,
+    NULL, NULL, NULL, NULL, 0, 0, 0, 0, 0, 0
+};
+
+/* parallel_info for task jobs, so their started/finished counts don't
+ * throttle anybody's ncpu=0 bu_parallel() calls.
+ */
+static struct parallel_info task_scope = {0, 0, 0, 0, 0};
+
+
+static int
+parallel_pool_enabled(void)
+{
+    static int enabled = -1;
+
+    if (enabled < 0) {
+	const char *libbu_thread_pool = getenv("LIBBU_THREAD_POOL");
+	enabled = (libbu_thread_pool && libbu_thread_pool[0] == '0') ? 0 : 1;
+    }
+    return enabled;
+}
+
+
+/**
+ * Only the forking thread survives in a child process, so start over
+ * with an empty pool there.
+ */
+static void
+pool_atfork_child(void)
+{
+    pthread_mutex_init(&pool.lock, NULL);
+    pthread_cond_init(&pool.work, NULL);
+    pthread_cond_init(&pool.done, NULL);
+    pool.par_head = pool.par_tail = NULL;
+    pool.task_head = pool.task_tail = NULL;
+    pool.npar_queued = pool.nthreads = pool.nbusy = pool.ntasks_running = 0;
+}
+
+
+static void
+pool_run_job(struct pool_job *job)
+{
+    int saved_cpu = thread_get_cpu();
+
+    if (job->group) {
+	/* tasks get their parallel ID when they start running */
+	struct parallel_info *next = parallel_mapping(PARALLEL_GET, -1, 0);
+	job->td.cpu_id = next->id;
+    }
+
+    parallel_interface_arg(&job->td);
+
+    thread_set_cpu(saved_cpu);
+}
+
+
+static void *
+pool_thread(void *UNUSED(arg))
+{
+    pthread_mutex_lock(&pool.lock);
+
+    while (1) {
+	struct pool_job *job = pool.par_head;
+	struct bu_task_group *group = NULL;
+
+	if (job) {
+	    pool.par_head = job->next;
+	    if (!pool.par_head)
+		pool.par_tail = NULL;
+	    pool.npar_queued--;
+	} else if (pool.task_head && pool.ntasks_running < pool.task_limit) {
+	    job = pool.task_head;
+	    pool.task_head = job->next;
+	    if (!pool.task_head)
+		pool.task_tail = NULL;
+	    pool.ntasks_running++;
+	} else {
+	    pthread_cond_wait(&pool.work, &pool.lock);
+	    continue;
+	}
+	pool.nbusy++;
+	pthread_mutex_unlock(&pool.lock);
+
+	pool_run_job(job);
+
+	group = job->group;
+	if (group)
+	    bu_free(job, "task job");
+
+	pthread_mutex_lock(&pool.lock);
+	pool.nbusy--;
+	if (group) {
+	    pool.ntasks_running--;
+	    group->remaining--;
+	} else {
+	    (*job->remaining)--;
+	}
+	pthread_cond_broadcast(&pool.done);
+    }
+
+    /* NOTREACHED */
+    return NULL;
+}
+
+
+/* call with pool.lock held */
+static int
+pool_spawn(void)
+{
+    pthread_t thread;
+    pthread_attr_t attrs;
+    int ret;
+
+    if (!pool.atfork) {
+	pthread_atfork(NULL, NULL, pool_atfork_child);
+	pool.atfork = 1;
+    }
+
+    pthread_attr_init(&attrs);
+    pthread_attr_setstacksize(&attrs, 10*1024*1024);
+    pthread_attr_setdetachstate(&attrs, PTHREAD_CREATE_DETACHED);
+    ret = pthread_create(&thread, &attrs, pool_thread, NULL);
+    pthread_attr_destroy(&attrs);
+
+    if (ret)
+	return ret;
+
+    pool.nthreads++;
+    return 0;
+}
+
+
+/**
+ * Run each of the ncpu bu_parallel() invocations in thread_context
+ * on a pooled thread and wait for all of them to finish.
+ */
+static void
+parallel_pool_run(struct thread_data *thread_context, size_t ncpu, int throttle, struct parallel_info *parent)
+{
+    struct pool_job *jobs = (struct pool_job *)bu_calloc(ncpu, sizeof(struct pool_job), "pool jobs");
+    size_t remaining = 0;
+    size_t failed = 0;
+    size_t x;
+
+    for (x = 0; x < ncpu; x++) {
+	int ret = 0;
+
+	parallel_wait_for_slot(throttle, parent, ncpu);
+
+	jobs[x].td = thread_context[x];
+	jobs[x].remaining = &remaining;
+
+	pthread_mutex_lock(&pool.lock);
+	remaining++;
+	if (pool.par_tail)
+	    pool.par_tail->next = &jobs[x];
+	else
+	    pool.par_head = &jobs[x];
+	pool.par_tail = &jobs[x];
+	pool.npar_queued++;
+	while (pool.nthreads - pool.nbusy < pool.npar_queued) {
+	    if ((ret = pool_spawn()) != 0)
+		break;
+	}
+	pthread_cond_signal(&pool.work);
+	pthread_mutex_unlock(&pool.lock);
+
+	if (ret)
+	    failed++;
+    }
+
+    if (UNLIKELY(failed))
+	bu_log("WARNING: bu_parallel(): unable to create %zu pool threads, some of %zu invocations will be delayed\n", failed, ncpu);
+
+    if (UNLIKELY(bu_debug & BU_DEBUG_PARALLEL))
+	bu_log("bu_parallel(): dispatched %zu invocations to pool of %zu threads\n", ncpu, pool.nthreads);
+
+    pthread_mutex_lock(&pool.lock);
+    while (remaining > 0)
+	pthread_cond_wait(&pool.done, &pool.lock);
+    pthread_mutex_unlock(&pool.lock);
+
+    bu_free(jobs, "pool jobs");
+}
+
+#endif /* PARALLEL_POOL */
+
+
 void
 bu_parallel(void (*func)(int, void *), size_t ncpu, void *arg)
 {
@@ -699,70 +934,74 @@ bu_parallel(void (*func)(int, void *), size_t ncpu, void *arg)
 
 #  if defined(HAVE_PTHREAD_H)
 
-    /* Create the posix threads.
-     *
-     * Start at 1 so we can treat the parent as thread 0.
-     */
-    nthreadc = 0;
-    for (x = 0; x < ncpu; x++) {
-	pthread_attr_t attrs;
-	pthread_attr_init(&attrs);
-	pthread_attr_setstacksize(&attrs, 10*1024*1024);
+    if (parallel_pool_enabled()) {
+	parallel_pool_run(thread_context, ncpu, throttle, parent);
+    } else {
+	/* Create the posix threads.
+	 *
+	 * Start at 1 so we can treat the parent as thread 0.
+	 */
+	nthreadc = 0;
+	for (x = 0; x < ncpu; x++) {
+	    pthread_attr_t attrs;
+	    pthread_attr_init(&attrs);
+	    pthread_attr_setstacksize(&attrs, 10*1024*1024);
 
-	parallel_wait_for_slot(throttle, parent, ncpu);
+	    parallel_wait_for_slot(throttle, parent, ncpu);
 
-	if (pthread_create(&thread, &attrs, parallel_interface_arg, &thread_context[x])) {
-	    bu_log("ERROR: bu_parallel: pthread_create(0x0, 0x0, 0x%lx, 0x0, 0, %p) failed for processor thread # %zu\n",
-		   (unsigned long int)parallel_interface_arg, (void *)&thread, x);
+	    if (pthread_create(&thread, &attrs, parallel_interface_arg, &thread_context[x])) {
+		bu_log("ERROR: bu_parallel: pthread_create(0x0, 0x0, 0x%lx, 0x0, 0, %p) failed for processor thread # %zu\n",
+		       (unsigned long int)parallel_interface_arg, (void *)&thread, x);
 
-	} else {
-	    if (UNLIKELY(bu_debug & BU_DEBUG_PARALLEL)) {
-		bu_log("bu_parallel(): created thread: (thread: %p) (loop: %zu) (nthreadc: %zu)\n",
-		       (void*)thread, x, nthreadc);
+	    } else {
+		if (UNLIKELY(bu_debug & BU_DEBUG_PARALLEL)) {
+		    bu_log("bu_parallel(): created thread: (thread: %p) (loop: %zu) (nthreadc: %zu)\n",
+			   (void*)thread, x, nthreadc);
+		}
+		thread_tbl[nthreadc] = thread;
+		nthreadc++;
 	    }
-	    thread_tbl[nthreadc] = thread;
-	    nthreadc++;
-	}
 
-	/* done with the attributes after create */
-	pthread_attr_destroy(&attrs);
-    }
+	    /* done with the attributes after create */
+	    pthread_attr_destroy(&attrs);
+	}
 
-    if (UNLIKELY(bu_debug & BU_DEBUG_PARALLEL)) {
-	for (i = 0; i < nthreadc; i++) {
-	    bu_log("bu_parallel(): thread_tbl[%zu] = %p\n", i, (void *)thread_tbl[i]);
+	if (UNLIKELY(bu_debug & BU_DEBUG_PARALLEL)) {
+	    for (i = 0; i < nthreadc; i++) {
+		bu_log("bu_parallel(): thread_tbl[%zu] = %p\n", i, (void *)thread_tbl[i]);
+	    }
 	}
-    }
 
-    /*
-     * Wait for completion of all threads.
-     * Wait for them in order.
-     */
-    nthreade = 0;
-    for (x = 0; x < nthreadc; x++) {
-	int ret;
+	/*
+	 * Wait for completion of all threads.
+	 * Wait for them in order.
+	 */
+	nthreade = 0;
+	for (x = 0; x < nthreadc; x++) {
+	    int ret;
 
-	if (UNLIKELY(bu_debug & BU_DEBUG_PARALLEL))
-	    bu_log("bu_parallel(): waiting for thread %p to complete:\t(loop:%zu) (nthreadc:%zu) (nthreade:%zu)\n",
-		   (void *)thread_tbl[x], x, nthreadc, nthreade);
+	    if (UNLIKELY(bu_debug & BU_DEBUG_PARALLEL))
+		bu_log("bu_parallel(): waiting for thread %p to complete:\t(loop:%zu) (nthreadc:%zu) (nthreade:%zu)\n",
+		       (void *)thread_tbl[x], x, nthreadc, nthreade);
 
-	if ((ret = pthread_join(thread_tbl[x], NULL)) != 0) {
-	    /* badness happened */
-	    bu_log("pthread_join(thread_tbl[%zu]=%p) ret=%d\n", x, (void *)thread_tbl[x], ret);
-	}
+	    if ((ret = pthread_join(thread_tbl[x], NULL)) != 0) {
+		/* badness happened */
+		bu_log("pthread_join(thread_tbl[%zu]=%p) ret=%d\n", x, (void *)thread_tbl[x], ret);
+	    }
 
-	nthreade++;
-	thread = thread_tbl[x];
-	thread_tbl[x] = (rt_thread_t)-1;
+	    nthreade++;
+	    thread = thread_tbl[x];
+	    thread_tbl[x] = (rt_thread_t)-1;
 
-	if (UNLIKELY(bu_debug & BU_DEBUG_PARALLEL))
-	    bu_log("bu_parallel(): thread completed: (thread: %p)\t(loop:%zu) (nthreadc:%zu) (nthreade:%zu)\n",
-		   (void *)thread, x, nthreadc, nthreade);
+	    if (UNLIKELY(bu_debug & BU_DEBUG_PARALLEL))
+		bu_log("bu_parallel(): thread completed: (thread: %p)\t(loop:%zu) (nthreadc:%zu) (nthreade:%zu)\n",
+		       (void *)thread, x, nthreadc, nthreade);
 
-    }
+	}
 
-    if (UNLIKELY(bu_debug & BU_DEBUG_PARALLEL))
-	bu_log("bu_parallel(): %zu threads created.  %zu threads exited.\n", nthreadc, nthreade);
+	if (UNLIKELY(bu_debug & BU_DEBUG_PARALLEL))
+	    bu_log("bu_parallel(): %zu threads created.  %zu threads exited.\n", nthreadc, nthreade);
+    }
 
 #  endif /* end if posix threads */
 
@@ -825,6 +1064,156 @@ bu_parallel(void (*func)(int, void *), size_t ncpu, void *arg)
 }
 
 
+
+struct bu_task_group *
+bu_task_group_create(void)
+{
+    struct bu_task_group *group;
+    BU_GET(group, struct bu_task_group);
+    group->head = group->tail = NULL;
+    group->remaining = 0;
+    return group;
+}
+
+
+void
+bu_task_submit(struct bu_task_group *group, void (*func)(int, void *), void *data)
+{
+    struct pool_job *job;
+
+    if (!group || !func)
+	return;
+
+    job = (struct pool_job *)bu_calloc(1, sizeof(struct pool_job), "task job");
+    job->group = group;
+    job->td.user_func = func;
+    job->td.user_arg = data;
+    job->td.cpu_id = 0;
+
+#ifdef PARALLEL_POOL
+    job->td.parent = &task_scope;
+
+    pthread_mutex_lock(&pool.lock);
+    if (!pool.task_limit)
+	pool.task_limit = bu_avail_cpus();
+    group->remaining++;
+    if (pool.task_tail)
+	pool.task_tail->next = job;
+    else
+	pool.task_head = job;
+    pool.task_tail = job;
+    if (pool.nthreads - pool.nbusy <= pool.npar_queued && pool.ntasks_running < pool.task_limit)
+	(void)pool_spawn(); /* on failure, bu_task_wait() will run it */
+    pthread_cond_signal(&pool.work);
+    pthread_mutex_unlock(&pool.lock);
+#else
+    bu_semaphore_acquire(BU_SEM_THREAD);
+    group->remaining++;
+    if (group->tail)
+	group->tail->next = job;
+    else
+	group->head = job;
+    group->tail = job;
+    bu_semaphore_release(BU_SEM_THREAD);
+#endif
+}
+
+
+#ifndef PARALLEL_POOL
+/* self-dispatching bu_parallel() callback that drains a task group */
+static void
+task_group_drain(int cpu, void *data)
+{
+    struct bu_task_group *group = (struct bu_task_group *)data;
+
+    while (1) {
+	struct pool_job *job;
+
+	bu_semaphore_acquire(BU_SEM_THREAD);
+	job = group->head;
+	if (job) {
+	    group->head = job->next;
+	    if (!group->head)
+		group->tail = NULL;
+	}
+	bu_semaphore_release(BU_SEM_THREAD);
+
+	if (!job)
+	    return;
+
+	job->td.user_func(cpu, job->td.user_arg);
+	bu_free(job, "task job");
+
+	bu_semaphore_acquire(BU_SEM_THREAD);
+	group->remaining--;
+	bu_semaphore_release(BU_SEM_THREAD);
+    }
+}
+#endif
+
+
+void
+bu_task_wait(struct bu_task_group *group)
+{
+    if (!group)
+	return;
+
+#ifdef PARALLEL_POOL
+    pthread_mutex_lock(&pool.lock);
+    while (group->remaining > 0) {
+	struct pool_job *prev = NULL;
+	struct pool_job *job;
+
+	/* rather than sit idle, run one of our own queued tasks */
+	for (job = pool.task_head; job; prev = job, job = job->next) {
+	    if (job->group == group)
+		break;
+	}
+	if (!job) {
+	    pthread_cond_wait(&pool.done, &pool.lock);
+	    continue;
+	}
+
+	if (prev)
+	    prev->next = job->next;
+	else
+	    pool.task_head = job->next;
+	if (pool.task_tail == job)
+	    pool.task_tail = prev;
+	pthread_mutex_unlock(&pool.lock);
+
+	pool_run_job(job);
+	bu_free(job, "task job");
+
+	pthread_mutex_lock(&pool.lock);
+	group->remaining--;
+	pthread_cond_broadcast(&pool.done);
+    }
+    pthread_mutex_unlock(&pool.lock);
+#else
+    if (group->remaining > 0) {
+	size_t ncpu = bu_avail_cpus();
+	if (ncpu > group->remaining)
+	    ncpu = group->remaining;
+	if (ncpu > MAX_PSW)
+	    ncpu = MAX_PSW;
+	bu_parallel(task_group_drain, ncpu, group);
+    }
+#endif
+}
+
+
+void
+bu_task_group_destroy(struct bu_task_group *group)
+{
+    if (!group)
+	return;
+
+    bu_task_wait(group);
+    BU_PUT(group, struct bu_task_group);
+}
+
+
 /*
  * Local Variables:
  * mode: C
@@ -58,6 +58,26 @@ main(int ac, char *av[])
 	return 1;
     }
 
+    /* released memory should come back, cleared */
+    ptr = bu_heap_get(32);
+    memset(ptr, 0xff, 32);
+    bu_heap_put(ptr, 32);
+    {
+	unsigned char *again = (unsigned char *)bu_heap_get(32);
+	if (again != ptr) {
+	    bu_log("bu_heap_get reuse [FAIL] (got %p, expected %p)\n", (void *)again, ptr);
+	    return 1;
+	}
+	for (i = 0; i < 32; i++) {
+	    if (again[i] != 0) {
+		bu_log("bu_heap_get reuse zeroed [FAIL] (byte %d is %d)\n", i, again[i]);
+		return 1;
+	    }
+	}
+	bu_heap_put(again, 32);
+    }
+    bu_log("bu_heap_get reuse [PASS]\n");
+
     srand(time(0));
 
     for (i=0; i<1024*1024*10; i++) {
@@ -77,6 +77,34 @@ recursive_callback(int UNUSED(cpu), void *d)
 }
 
 
+/* task group tests */
+static size_t task_count = 0;
+
+
+static void
+task_callback(int UNUSED(cpu), void *d)
+{
+    size_t *inc = (size_t *)d;
+
+    bu_semaphore_acquire(BU_SEM_GENERAL);
+    task_count += *inc;
+    bu_semaphore_release(BU_SEM_GENERAL);
+}
+
+
+static void
+nested_task_callback(int UNUSED(cpu), void *d)
+{
+    size_t i;
+    struct bu_task_group *group = bu_task_group_create();
+
+    for (i = 0; i < 8; i++)
+	bu_task_submit(group, task_callback, d);
+    bu_task_wait(group);
+    bu_task_group_destroy(group);
+}
+
+
 static size_t
 tally(size_t ncpu)
 {
@@ -208,6 +236,44 @@ main(int argc, char *argv[])
     }
     bu_log("bu_parallel recursive callback, many iterations [PASS]\n");
 
+    /* test repeated calls, reusing pooled threads */
+    memset(counter, 0, sizeof(counter));
+    data.iterations = 10;
+    for (c = 0; c < 100; c++)
+	bu_parallel(callback, ncpu, &data);
+    if (tally(MAX_PSW) != 100*ncpu*data.iterations) {
+	bu_log("bu_parallel repeated callback [FAIL] (got %zd, expected %zd)\n", tally(MAX_PSW), 100*ncpu*data.iterations);
+	return 1;
+    }
+    bu_log("bu_parallel repeated callback [PASS]\n");
+
+    /* test a task group */
+    {
+	size_t one = 1;
+	struct bu_task_group *group = bu_task_group_create();
+
+	task_count = 0;
+	for (c = 0; c < 1000; c++)
+	    bu_task_submit(group, task_callback, &one);
+	bu_task_wait(group);
+	if (task_count != 1000) {
+	    bu_log("bu_task_submit simple tasks [FAIL] (got %zd, expected %d)\n", task_count, 1000);
+	    return 1;
+	}
+	bu_log("bu_task_submit simple tasks [PASS]\n");
+
+	/* reuse the group for tasks that wait on their own groups */
+	task_count = 0;
+	for (c = 0; c < 64; c++)
+	    bu_task_submit(group, nested_task_callback, &one);
+	bu_task_group_destroy(group);
+	if (task_count != 64*8) {
+	    bu_log("bu_task_submit nested tasks [FAIL] (got %zd, expected %d)\n", task_count, 64*8);
+	    return 1;
+	}
+	bu_log("bu_task_submit nested tasks [PASS]\n");
+    }
+
     return 0;
 }
 
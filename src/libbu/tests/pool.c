@@ -0,0 +1,128 @@
+/*                        P O O L . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+
+#include "common.h"
+
+#include <string.h>
+
+#include "bu.h"
+
+
+#define NALLOCS 10000
+
+
+int
+main(int ac, char *av[])
+{
+    struct bu_pool *pool;
+    struct bu_pool_mark mark;
+    unsigned char *ptrs[NALLOCS];
+    size_t offsets[NALLOCS];
+    unsigned char *flat;
+    size_t used;
+    int i;
+
+    // Normally this file is part of bu_test, so only set this if it
+    // looks like the program name is still unset.
+    if (bu_getprogname()[0] == '\0')
+	bu_setprogname(av[0]);
+
+    if (ac > 1) {
+	fprintf(stderr, "Usage: %s\n", av[0]);
+	return 1;
+    }
+
+    /* a small chunk size forces lots of chunks, and a few
+     * allocations larger than a chunk.
+     */
+    pool = bu_pool_create(256);
+    for (i = 0; i < NALLOCS; i++) {
+	size_t sz = (i % 300) + 1;
+	offsets[i] = bu_pool_used(pool);
+	ptrs[i] = (unsigned char *)bu_pool_alloc(pool, 1, sz);
+	if ((size_t)ptrs[i] % BU_POOL_ALIGN) {
+	    bu_log("bu_pool_alloc alignment [FAIL] (%p)\n", (void *)ptrs[i]);
+	    return 1;
+	}
+	memset(ptrs[i], i & 0xff, sz);
+    }
+
+    /* earlier allocations must not have moved or been overwritten */
+    for (i = 0; i < NALLOCS; i++) {
+	size_t sz = (i % 300) + 1;
+	size_t j;
+	for (j = 0; j < sz; j++) {
+	    if (ptrs[i][j] != (i & 0xff)) {
+		bu_log("bu_pool_alloc stable addresses [FAIL] (allocation %d)\n", i);
+		return 1;
+	    }
+	}
+    }
+    bu_log("bu_pool_alloc stable addresses [PASS]\n");
+
+    /* contiguous copy preserves offsets */
+    used = bu_pool_used(pool);
+    flat = (unsigned char *)bu_malloc(used, "flat");
+    bu_pool_copy(pool, flat);
+    for (i = 0; i < NALLOCS; i++) {
+	size_t sz = (i % 300) + 1;
+	if (memcmp(flat + offsets[i], ptrs[i], sz) != 0) {
+	    bu_log("bu_pool_copy [FAIL] (allocation %d)\n", i);
+	    return 1;
+	}
+    }
+    bu_free(flat, "flat");
+    bu_log("bu_pool_copy [PASS]\n");
+
+    /* rewinding hands the same memory out again */
+    bu_pool_save(pool, &mark);
+    ptrs[0] = (unsigned char *)bu_pool_alloc(pool, 1, 16);
+    for (i = 0; i < 100; i++)
+	(void)bu_pool_alloc(pool, 1, 200);
+    bu_pool_rewind(pool, &mark);
+    if (bu_pool_used(pool) != used || bu_pool_alloc(pool, 1, 16) != ptrs[0]) {
+	bu_log("bu_pool_rewind [FAIL]\n");
+	return 1;
+    }
+    bu_log("bu_pool_rewind [PASS]\n");
+
+    bu_pool_reset(pool);
+    if (bu_pool_used(pool) != 0) {
+	bu_log("bu_pool_reset [FAIL] (%zu bytes used)\n", bu_pool_used(pool));
+	return 1;
+    }
+    (void)bu_pool_alloc(pool, 10, 10);
+    bu_log("bu_pool_reset [PASS]\n");
+
+    bu_pool_delete(pool);
+
+    return 0;
+}
+
+
+/*
+ * Local Variables:
+ * mode: C
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
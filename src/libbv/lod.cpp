@@ -52,12 +52,30 @@
  * What we do is generate a hash value of the data on initialization, when we
  * need the full data set to perform the initial LoD setup.  We then provide
  * that value back to the caller for them to manage at a higher level.
+ *
+ * Notes on threading:
+ *
+ * Generating the cache for a large mesh and reading in the finer POP levels
+ * are both too slow to do on an application's drawing thread when many large
+ * meshes are in play.  Each context has a small pool of worker threads (started
+ * on first use) that process those jobs in priority order, with view visible
+ * objects going first.  The coarse level 0 data is always loaded immediately,
+ * so something can be drawn right away - finer levels are read in by the
+ * workers and swapped in on the drawing thread once they are ready.  All LMDB
+ * access uses short-lived per-operation transactions, so the cache may be read
+ * from any thread.
  */
 
 #include "common.h"
 #include <cstring>
 #include <stdlib.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
 #include <set>
 #include <thread>
 #include <vector>
@@ -594,18 +612,97 @@ _obj_visible(struct bv_scene_obj *s, struct bview *v)
     return 0;
 }
 
-struct bv_mesh_lod_context_internal {
-    MDB_env *lod_env;
-    MDB_txn *lod_txn;
-    MDB_dbi lod_dbi;
+// Background work item.  The function is called with cancel set if the
+// context is destroyed before the job gets to run, so it can clean up.
+struct lod_job {
+    int priority;
+    size_t seq;
+    std::function<void(bool)> f;
+};
 
-    MDB_env *name_env;
-    MDB_txn *name_txn;
-    MDB_dbi name_dbi;
+// Highest priority first, and first come first served within a priority
+struct lod_job_cmp {
+    bool operator()(const lod_job &a, const lod_job &b) const {
+	if (a.priority != b.priority)
+	    return a.priority < b.priority;
+	return a.seq > b.seq;
+    }
+};
 
-    struct bu_vls *fname;
+struct bv_mesh_lod_context_internal {
+    MDB_env *lod_env = NULL;
+    MDB_dbi lod_dbi = 0;
+
+    MDB_env *name_env = NULL;
+    MDB_dbi name_dbi = 0;
+
+    struct bu_vls *fname = NULL;
+
+    // Background worker threads
+    std::mutex jobs_lock;
+    std::condition_variable jobs_cv;
+    std::priority_queue<lod_job, std::vector<lod_job>, lod_job_cmp> jobs;
+    std::vector<std::thread> workers;
+    std::set<std::string> building;
+    size_t job_seq = 0;
+    bool shutdown = false;
 };
 
+static void
+lod_worker(struct bv_mesh_lod_context_internal *i)
+{
+    while (1) {
+	lod_job j;
+	{
+	    std::unique_lock<std::mutex> lk(i->jobs_lock);
+	    i->jobs_cv.wait(lk, [i]{ return i->shutdown || !i->jobs.empty(); });
+	    if (i->shutdown)
+		return;
+	    j = i->jobs.top();
+	    i->jobs.pop();
+	}
+	j.f(false);
+    }
+}
+
+static void
+lod_job_add(struct bv_mesh_lod_context *c, int priority, std::function<void(bool)> f)
+{
+    struct bv_mesh_lod_context_internal *i = c->i;
+    std::lock_guard<std::mutex> lk(i->jobs_lock);
+
+    // Start the workers the first time they are needed.  Leave a core for
+    // the application - the whole point is to keep it responsive.
+    if (!i->workers.size()) {
+	int ncpus = bu_avail_cpus();
+	size_t nworkers = (ncpus > 2) ? (size_t)ncpus - 1 : 1;
+	for (size_t n = 0; n < nworkers; n++)
+	    i->workers.push_back(std::thread(lod_worker, i));
+    }
+
+    lod_job j;
+    j.priority = priority;
+    j.seq = i->job_seq++;
+    j.f = f;
+    i->jobs.push(j);
+    i->jobs_cv.notify_one();
+}
+
+// The dbi handles are opened once up front - mdb_dbi_open may not be called
+// from concurrent transactions, and the workers need to be able to read.
+static int
+lod_dbi_open(MDB_env *env, MDB_dbi *dbi)
+{
+    MDB_txn *txn;
+    if (mdb_txn_begin(env, NULL, 0, &txn))
+	return -1;
+    if (mdb_dbi_open(txn, NULL, 0, dbi)) {
+	mdb_txn_abort(txn);
+	return -1;
+    }
+    return (mdb_txn_commit(txn)) ? -1 : 0;
+}
+
 struct bv_mesh_lod_context *
 bv_mesh_lod_context_create(const char *name)
 {
@@ -633,7 +730,7 @@ bv_mesh_lod_context_create(const char *name)
     // Create the context
     struct bv_mesh_lod_context *c;
     BU_GET(c, struct bv_mesh_lod_context);
-    BU_GET(c->i, struct bv_mesh_lod_context_internal);
+    c->i = new bv_mesh_lod_context_internal;
     struct bv_mesh_lod_context_internal *i = c->i;
     BU_GET(i->fname, struct bu_vls);
     bu_vls_init(i->fname);
@@ -702,6 +799,8 @@ bv_mesh_lod_context_create(const char *name)
     // Need to call mdb_env_sync() at appropriate points.
     if (mdb_env_open(i->lod_env, dir, MDB_NOSYNC, 0664))
 	goto lod_context_close_lod_fail;
+    if (lod_dbi_open(i->lod_env, &i->lod_dbi))
+	goto lod_context_close_lod_fail;
 
     // Create the specific name/key LMDB mapping dir, if not already present
     bu_vls_printf(&fname, "_namekey");
@@ -712,6 +811,8 @@ bv_mesh_lod_context_create(const char *name)
     // Need to call mdb_env_sync() at appropriate points.
     if (mdb_env_open(i->name_env, dir, MDB_NOSYNC, 0664))
 	goto lod_context_close_name_fail;
+    if (lod_dbi_open(i->name_env, &i->name_dbi))
+	goto lod_context_close_name_fail;
 
     // Success - return the context
     bu_vls_free(&fname);
@@ -724,7 +825,7 @@ lod_context_close_lod_fail:
     mdb_env_close(i->lod_env);
 lod_context_fail:
     bu_vls_free(&fname);
-    BU_PUT(c->i, struct bv_mesh_lod_context_internal);
+    delete c->i;
     BU_PUT(c, struct bv_mesh_lod_context);
     return NULL;
 }
@@ -734,11 +835,27 @@ bv_mesh_lod_context_destroy(struct bv_mesh_lod_context *c)
 {
     if (!c)
 	return;
+
+    // Stop the workers.  Anything still queued is cancelled rather than
+    // run, so callers waiting on cache generation can release their data.
+    {
+	std::lock_guard<std::mutex> lk(c->i->jobs_lock);
+	c->i->shutdown = true;
+    }
+    c->i->jobs_cv.notify_all();
+    for (size_t j = 0; j < c->i->workers.size(); j++)
+	c->i->workers[j].join();
+    while (!c->i->jobs.empty()) {
+	lod_job j = c->i->jobs.top();
+	c->i->jobs.pop();
+	j.f(true);
+    }
+
     mdb_env_close(c->i->name_env);
     mdb_env_close(c->i->lod_env);
     bu_vls_free(c->i->fname);
     BU_PUT(c->i->fname, struct bu_vls);
-    BU_PUT(c->i, struct bv_mesh_lod_context_internal);
+    delete c->i;
     BU_PUT(c, struct bv_mesh_lod_context);
 }
 
@@ -762,18 +879,22 @@ bv_mesh_lod_key_get(struct bv_mesh_lod_context *c, const char *name)
     unsigned long long hash = bu_data_hash(bu_vls_cstr(&keystr), bu_vls_strlen(&keystr)*sizeof(char));
     bu_vls_sprintf(&keystr, "%llu", hash);
 
-    mdb_txn_begin(c->i->name_env, NULL, 0, &c->i->name_txn);
-    mdb_dbi_open(c->i->name_txn, NULL, 0, &c->i->name_dbi);
+    MDB_txn *txn;
+    if (mdb_txn_begin(c->i->name_env, NULL, MDB_RDONLY, &txn)) {
+	bu_vls_free(&keystr);
+	return 0;
+    }
     mdb_key.mv_size = bu_vls_strlen(&keystr)*sizeof(char);
     mdb_key.mv_data = (void *)bu_vls_cstr(&keystr);
-    int rc = mdb_get(c->i->name_txn, c->i->name_dbi, &mdb_key, &mdb_data);
+    int rc = mdb_get(txn, c->i->name_dbi, &mdb_key, &mdb_data);
     if (rc) {
-	mdb_txn_commit(c->i->name_txn);
+	mdb_txn_abort(txn);
+	bu_vls_free(&keystr);
 	return 0;
     }
     unsigned long long *fkeyp = (unsigned long long *)mdb_data.mv_data;
     unsigned long long fkey = *fkeyp;
-    mdb_txn_commit(c->i->name_txn);
+    mdb_txn_abort(txn);
 
     bu_vls_free(&keystr);
     //bu_log("GOT %s: %llu\n", name, fkey);
@@ -800,16 +921,23 @@ bv_mesh_lod_key_put(struct bv_mesh_lod_context *c, const char *name, unsigned lo
 
     MDB_val mdb_key;
     MDB_val mdb_data[2];
-    mdb_txn_begin(c->i->name_env, NULL, 0, &c->i->name_txn);
-    mdb_dbi_open(c->i->name_txn, NULL, 0, &c->i->name_dbi);
+    MDB_txn *txn;
+    if (mdb_txn_begin(c->i->name_env, NULL, 0, &txn)) {
+	bu_vls_free(&keystr);
+	return -1;
+    }
     mdb_key.mv_size = bu_vls_strlen(&keystr)*sizeof(char);
     mdb_key.mv_data = (void *)bu_vls_cstr(&keystr);
     mdb_data[0].mv_size = sizeof(key);
     mdb_data[0].mv_data = (void *)&key;
     mdb_data[1].mv_size = 0;
     mdb_data[1].mv_data = NULL;
-    int rc = mdb_put(c->i->name_txn, c->i->name_dbi, &mdb_key, mdb_data, 0);
-    mdb_txn_commit(c->i->name_txn);
+    int rc = mdb_put(txn, c->i->name_dbi, &mdb_key, mdb_data, 0);
+    if (rc) {
+	mdb_txn_abort(txn);
+    } else {
+	rc = mdb_txn_commit(txn);
+    }
 
     bu_vls_free(&keystr);
     //bu_log("PUT %s: %llu\n", name, key);
@@ -828,6 +956,29 @@ struct bv_mesh_lod_internal {
     POPState *s;
 };
 
+// Shared between a POPState and its background jobs.  A job holds lock while
+// it is using the POPState, and the POPState clears alive when it goes away so
+// any jobs still in the queue know to skip their work.
+class POPGuard {
+    public:
+	std::mutex lock;
+	bool alive = true;
+};
+
+// Level data read in by a background worker
+class POPLoad {
+    public:
+	std::atomic<bool> cancelled{false};
+	std::atomic<bool> done{false};
+	bool valid = false;
+	int level = -1;
+
+	std::vector<int> tris;
+	std::vector<fastf_t> pnts;
+	std::vector<fastf_t> pnts_snapped;
+	std::vector<fastf_t> norms;
+};
+
 class POPState {
     public:
 
@@ -846,6 +997,15 @@ class POPState {
 	// Load/unload data level
 	void set_level(int level);
 
+	// Read in the data for a finer POP level on a background worker
+	// rather than immediately.  load_sync swaps in the result once it
+	// is ready, returning true if the active data changed.
+	void load_async(int level, int priority);
+	bool load_sync();
+	void load_cancel();
+	std::shared_ptr<POPLoad> pending;
+	std::shared_ptr<POPGuard> guard;
+
 	// Shrink memory usage (level set routines will have to do more work
 	// after this is run, but the POPState is still viable).  Used after a
 	// client code has done all that is needed with the level data, such as
@@ -893,6 +1053,15 @@ class POPState {
 	full_detail_clbk_t full_detail_free_clbk = NULL;
 	void *detail_clbk_data = NULL;
 
+	// Called from the worker thread when load_async data is ready
+	void (*ready_clbk)(struct bv_mesh_lod *, void *) = NULL;
+	void *ready_clbk_data = NULL;
+
+	// Set once drawing code has picked up data with bv_mesh_lod_sync.
+	// Until then nothing is on screen yet, so there is no point in
+	// showing a coarse level while the finer one loads.
+	bool drawn = false;
+
 	// Bounding box of original mesh
 	point_t bbmin, bbmax;
 
@@ -927,13 +1096,15 @@ class POPState {
 	void cache();
 	bool cache_tri();
 	bool cache_write(const char *component, std::stringstream &s);
-	size_t cache_get(void **data, const char *component);
-	void cache_done();
-	void cache_del(const char *component);
-	MDB_val mdb_key, mdb_data[2];
+	size_t cache_get(MDB_txn **txn, void **data, const char *component);
+	void cache_done(MDB_txn *txn);
 
-	// Specific loading and unloading methods
+	// Specific loading and unloading methods.  tri_pop_read and
+	// tri_pop_snap only read the cache and the (fixed) level
+	// parameters, so they are safe to run on a worker thread.
 	void tri_pop_load(int start_level, int level);
+	bool tri_pop_read(std::vector<fastf_t> &pnts, std::vector<int> &tris, std::vector<fastf_t> &norms, int start_level, int level);
+	void tri_pop_snap(std::vector<fastf_t> &snapped, const std::vector<fastf_t> &pnts, int level);
 	void tri_pop_trim(int level);
 	size_t level_vcnt[POP_MAXLEVEL+1] = {0};
 	size_t level_tricnt[POP_MAXLEVEL+1] = {0};
@@ -1095,15 +1266,16 @@ POPState::POPState(struct bv_mesh_lod_context *ctx, const point_t *v, size_t vcn
     // data.  The hash is set, which is all we really need - loading data from
     // the cache is handled elsewhere.
     void *cdata = NULL;
-    size_t csize = cache_get(&cdata, CACHE_POP_MAX_LEVEL);
+    MDB_txn *txn = NULL;
+    size_t csize = cache_get(&txn, &cdata, CACHE_POP_MAX_LEVEL);
     if (csize && cdata) {
-	cache_done();
+	cache_done(txn);
 	is_valid = true;
 	return;
     }
 
     // Cache isn't already populated - go to work.
-    cache_done();
+    cache_done(txn);
 
     curr_level = POP_MAXLEVEL - 1;
 
@@ -1183,27 +1355,29 @@ POPState::POPState(struct bv_mesh_lod_context *ctx, unsigned long long key)
     // Find the maximum POP level
     {
 	const char *b = NULL;
-	size_t bsize = cache_get((void **)&b, CACHE_POP_MAX_LEVEL);
+	MDB_txn *txn = NULL;
+	size_t bsize = cache_get(&txn, (void **)&b, CACHE_POP_MAX_LEVEL);
 	if (!bsize) {
-	    cache_done();
+	    cache_done(txn);
 	    return;
 	}
 	if (bsize != sizeof(max_pop_threshold_level)) {
 	    bu_log("Incorrect data size found loading max LoD POP threshold\n");
-	    cache_done();
+	    cache_done(txn);
 	    return;
 	}
 	memcpy(&max_pop_threshold_level, b, sizeof(max_pop_threshold_level));
-	cache_done();
+	cache_done(txn);
     }
 
     // Load the POP level where we switch from POP to full
     {
 	const char *b = NULL;
-	size_t bsize = cache_get((void **)&b, CACHE_POP_SWITCH_LEVEL);
+	MDB_txn *txn = NULL;
+	size_t bsize = cache_get(&txn, (void **)&b, CACHE_POP_SWITCH_LEVEL);
 	if (bsize && bsize != sizeof(max_face_ratio)) {
 	    bu_log("Incorrect data size found loading LoD POP switch threshold\n");
-	    cache_done();
+	    cache_done(txn);
 	    return;
 	}
 	if (bsize) {
@@ -1211,41 +1385,44 @@ POPState::POPState(struct bv_mesh_lod_context *ctx, unsigned long long key)
 	} else {
 	    max_face_ratio = 0.66;
 	}
-	cache_done();
+	cache_done(txn);
     }
 
     // Load level counts for vectors and tris
     {
 	const char *b = NULL;
-	size_t bsize = cache_get((void **)&b, CACHE_VERTEX_COUNT);
+	MDB_txn *txn = NULL;
+	size_t bsize = cache_get(&txn, (void **)&b, CACHE_VERTEX_COUNT);
 	if (bsize != sizeof(level_vcnt)) {
 	    bu_log("Incorrect data size found loading level vertex counts\n");
-	    cache_done();
+	    cache_done(txn);
 	    return;
 	}
 	memcpy(&level_vcnt, b, sizeof(level_vcnt));
-	cache_done();
+	cache_done(txn);
     }
     {
 	const char *b = NULL;
-	size_t bsize = cache_get((void **)&b, CACHE_TRI_COUNT);
+	MDB_txn *txn = NULL;
+	size_t bsize = cache_get(&txn, (void **)&b, CACHE_TRI_COUNT);
 	if (bsize != sizeof(level_tricnt)) {
 	    bu_log("Incorrect data size found loading level triangle counts\n");
-	    cache_done();
+	    cache_done(txn);
 	    return;
 	}
 	memcpy(&level_tricnt, b, sizeof(level_tricnt));
-	cache_done();
+	cache_done(txn);
     }
 
     // Read in min/max bounds
     {
 	float minmax[6];
 	const char *b = NULL;
-	size_t bsize = cache_get((void **)&b, CACHE_OBJ_BOUNDS);
+	MDB_txn *txn = NULL;
+	size_t bsize = cache_get(&txn, (void **)&b, CACHE_OBJ_BOUNDS);
 	if (bsize != (sizeof(bbmin) + sizeof(bbmax) + sizeof(minmax))) {
 	    bu_log("Incorrect data size found loading cached bounds data\n");
-	    cache_done();
+	    cache_done(txn);
 	    return;
 	}
 	memcpy(&bbmin, b, sizeof(bbmin));
@@ -1260,7 +1437,7 @@ POPState::POPState(struct bv_mesh_lod_context *ctx, unsigned long long key)
 	maxx = minmax[3];
 	maxy = minmax[4];
 	maxz = minmax[5];
-	cache_done();
+	cache_done(txn);
     }
 
     // Read in the zero level vertices, vertex normals (if defined) and triangles
@@ -1272,14 +1449,21 @@ POPState::POPState(struct bv_mesh_lod_context *ctx, unsigned long long key)
 
 POPState::~POPState()
 {
+    // Make sure no background job is (or will be) using this state
+    load_cancel();
+    if (guard) {
+	std::lock_guard<std::mutex> lk(guard->lock);
+	guard->alive = false;
+    }
+
     if (full_detail_free_clbk) {
 	(*full_detail_free_clbk)(lod, detail_clbk_data);
 	detail_clbk_data = NULL;
     }
 }
 
-void
-POPState::tri_pop_load(int start_level, int level)
+bool
+POPState::tri_pop_read(std::vector<fastf_t> &pnts, std::vector<int> &tris, std::vector<fastf_t> &norms, int start_level, int level)
 {
     struct bu_vls kbuf = BU_VLS_INIT_ZERO;
 
@@ -1289,24 +1473,16 @@ POPState::tri_pop_load(int start_level, int level)
 	    continue;
 	bu_vls_sprintf(&kbuf, "%s%d", CACHE_VERT_LEVEL, i);
 	fastf_t *b = NULL;
-	size_t bsize = cache_get((void **)&b, bu_vls_cstr(&kbuf));
+	MDB_txn *txn = NULL;
+	size_t bsize = cache_get(&txn, (void **)&b, bu_vls_cstr(&kbuf));
 	if (bsize != level_vcnt[i]*sizeof(point_t)) {
 	    bu_log("Incorrect data size found loading level %d point data\n", i);
-	    return;
-	}
-	lod_tri_pnts.insert(lod_tri_pnts.end(), &b[0], &b[level_vcnt[i]*3]);
-	cache_done();
-    }
-    // Re-snap all vertices currently loaded at the new level
-    lod_tri_pnts_snapped.clear();
-    lod_tri_pnts_snapped.reserve(lod_tri_pnts.size());
-    for (size_t i = 0; i < lod_tri_pnts.size()/3; i++) {
-	point_t p, sp;
-	VSET(p, lod_tri_pnts[3*i+0], lod_tri_pnts[3*i+1], lod_tri_pnts[3*i+2]);
-	level_pnt(&sp, &p, level);
-	for (int k = 0; k < 3; k++) {
-	    lod_tri_pnts_snapped.push_back(sp[k]);
+	    cache_done(txn);
+	    bu_vls_free(&kbuf);
+	    return false;
 	}
+	pnts.insert(pnts.end(), &b[0], &b[level_vcnt[i]*3]);
+	cache_done(txn);
     }
 
     // Read in the level triangles
@@ -1315,13 +1491,16 @@ POPState::tri_pop_load(int start_level, int level)
 	    continue;
 	bu_vls_sprintf(&kbuf, "%s%d", CACHE_TRI_LEVEL, i);
 	int *b = NULL;
-	size_t bsize = cache_get((void **)&b, bu_vls_cstr(&kbuf));
+	MDB_txn *txn = NULL;
+	size_t bsize = cache_get(&txn, (void **)&b, bu_vls_cstr(&kbuf));
 	if (bsize != level_tricnt[i]*3*sizeof(int)) {
 	    bu_log("Incorrect data size found loading level %d tri data\n", i);
-	    return;
+	    cache_done(txn);
+	    bu_vls_free(&kbuf);
+	    return false;
 	}
-	lod_tris.insert(lod_tris.end(), &b[0], &b[level_tricnt[i]*3]);
-	cache_done();
+	tris.insert(tris.end(), &b[0], &b[level_tricnt[i]*3]);
+	cache_done(txn);
     }
 
     // Read in the vertex normals, if we have them
@@ -1330,16 +1509,114 @@ POPState::tri_pop_load(int start_level, int level)
 	    continue;
 	bu_vls_sprintf(&kbuf, "%s%d", CACHE_VERTNORM_LEVEL, i);
 	fastf_t *b = NULL;
-	size_t bsize = cache_get((void **)&b, bu_vls_cstr(&kbuf));
+	MDB_txn *txn = NULL;
+	size_t bsize = cache_get(&txn, (void **)&b, bu_vls_cstr(&kbuf));
 	if (bsize > 0 && bsize != level_tricnt[i]*sizeof(vect_t)*3) {
 	    bu_log("Incorrect data size found loading level %d normal data\n", i);
-	    return;
+	    cache_done(txn);
+	    bu_vls_free(&kbuf);
+	    return false;
 	}
 	if (bsize) {
-	    lod_tri_norms.insert(lod_tri_norms.end(), &b[0], &b[level_tricnt[i]*3*3]);
+	    norms.insert(norms.end(), &b[0], &b[level_tricnt[i]*3*3]);
 	}
-	cache_done();
+	cache_done(txn);
     }
+
+    bu_vls_free(&kbuf);
+    return true;
+}
+
+void
+POPState::tri_pop_snap(std::vector<fastf_t> &snapped, const std::vector<fastf_t> &pnts, int level)
+{
+    snapped.clear();
+    snapped.reserve(pnts.size());
+    for (size_t i = 0; i < pnts.size()/3; i++) {
+	point_t p, sp;
+	VSET(p, pnts[3*i+0], pnts[3*i+1], pnts[3*i+2]);
+	level_pnt(&sp, &p, level);
+	for (int k = 0; k < 3; k++) {
+	    snapped.push_back(sp[k]);
+	}
+    }
+}
+
+void
+POPState::tri_pop_load(int start_level, int level)
+{
+    tri_pop_read(lod_tri_pnts, lod_tris, lod_tri_norms, start_level, level);
+
+    // Re-snap all vertices currently loaded at the new level
+    tri_pop_snap(lod_tri_pnts_snapped, lod_tri_pnts, level);
+}
+
+void
+POPState::load_async(int level, int priority)
+{
+    // Already on the way?
+    if (pending && pending->level == level)
+	return;
+    load_cancel();
+
+    if (!guard)
+	guard = std::make_shared<POPGuard>();
+
+    // The job reads levels 0 through level from scratch, rather than adding
+    // to what is currently loaded - the active containers belong to the
+    // drawing thread and may change before the job runs.
+    std::shared_ptr<POPLoad> pl = std::make_shared<POPLoad>();
+    std::shared_ptr<POPGuard> g = guard;
+    pl->level = level;
+    pending = pl;
+    POPState *p = this;
+    struct bv_mesh_lod *l = lod;
+    void (*rclbk)(struct bv_mesh_lod *, void *) = ready_clbk;
+    void *rdata = ready_clbk_data;
+    lod_job_add(c, priority, [p, g, pl, l, rclbk, rdata](bool cancel) {
+	    if (cancel || pl->cancelled)
+		return;
+	    std::lock_guard<std::mutex> lk(g->lock);
+	    if (!g->alive || pl->cancelled)
+		return;
+	    pl->valid = p->tri_pop_read(pl->pnts, pl->tris, pl->norms, -1, pl->level);
+	    if (pl->valid)
+		p->tri_pop_snap(pl->pnts_snapped, pl->pnts, pl->level);
+	    pl->done = true;
+	    // Let the application know it has something new to draw
+	    if (pl->valid && rclbk)
+		(*rclbk)(l, rdata);
+	    });
+}
+
+bool
+POPState::load_sync()
+{
+    if (!pending || !pending->done)
+	return false;
+
+    std::shared_ptr<POPLoad> pl = pending;
+    pending.reset();
+    if (!pl->valid)
+	return false;
+
+    lod_tris.swap(pl->tris);
+    lod_tri_pnts.swap(pl->pnts);
+    lod_tri_pnts_snapped.swap(pl->pnts_snapped);
+    lod_tri_norms.swap(pl->norms);
+    force_update = false;
+    curr_level = pl->level;
+
+    return true;
+}
+
+void
+POPState::load_cancel()
+{
+    if (!pending)
+	return;
+    pending->cancelled = true;
+    pending.reset();
 }
 
 void
@@ -1376,16 +1653,7 @@ POPState::tri_pop_trim(int level)
     lod_tris.shrink_to_fit();
 
     // Re-snap all vertices loaded at the new level
-    lod_tri_pnts_snapped.clear();
-    lod_tri_pnts_snapped.reserve(lod_tri_pnts.size());
-    for (size_t i = 0; i < lod_tri_pnts.size()/3; i++) {
-	point_t p, sp;
-	VSET(p, lod_tri_pnts[3*i+0], lod_tri_pnts[3*i+1], lod_tri_pnts[3*i+2]);
-	level_pnt(&sp, &p, level);
-	for (int k = 0; k < 3; k++) {
-	    lod_tri_pnts_snapped.push_back(sp[k]);
-	}
-    }
+    tri_pop_snap(lod_tri_pnts_snapped, lod_tri_pnts, level);
 }
 
 int
@@ -1544,57 +1812,70 @@ POPState::cache_write(const char *component, std::stringstream &s)
     char *keycstr = bu_strdup(keystr.c_str());
     void *bdata = bu_calloc(buffer.length()+1, sizeof(char), "bdata");
     memcpy(bdata, buffer.data(), buffer.length()*sizeof(char));
-    mdb_txn_begin(c->i->lod_env, NULL, 0, &c->i->lod_txn);
-    mdb_dbi_open(c->i->lod_txn, NULL, 0, &c->i->lod_dbi);
-    mdb_key.mv_size = keystr.length()*sizeof(char);
-    mdb_key.mv_data = (void *)keycstr;
-    mdb_data[0].mv_size = buffer.length()*sizeof(char);
-    mdb_data[0].mv_data = bdata;
-    mdb_data[1].mv_size = 0;
-    mdb_data[1].mv_data = NULL;
-    int rc = mdb_put(c->i->lod_txn, c->i->lod_dbi, &mdb_key, mdb_data, 0);
-    mdb_txn_commit(c->i->lod_txn);
+    MDB_val mdb_key, mdb_data[2];
+    MDB_txn *txn;
+    int rc = mdb_txn_begin(c->i->lod_env, NULL, 0, &txn);
+    if (!rc) {
+	mdb_key.mv_size = keystr.length()*sizeof(char);
+	mdb_key.mv_data = (void *)keycstr;
+	mdb_data[0].mv_size = buffer.length()*sizeof(char);
+	mdb_data[0].mv_data = bdata;
+	mdb_data[1].mv_size = 0;
+	mdb_data[1].mv_data = NULL;
+	rc = mdb_put(txn, c->i->lod_dbi, &mdb_key, mdb_data, 0);
+	if (rc) {
+	    mdb_txn_abort(txn);
+	} else {
+	    rc = mdb_txn_commit(txn);
+	}
+    }
     bu_free(keycstr, "keycstr");
     bu_free(bdata, "buffer data");
 
     return (!rc) ? true : false;
 }
 
-// This pulls the data, but doesn't close the transaction because the
-// calling code will want to manipulate the data.  After that process
-// is complete, cache_done() should be called to prepare for subsequent
-// operations.
+// This pulls the data, but doesn't close the (read only) transaction because
+// the calling code will want to manipulate the data.  After that process is
+// complete, cache_done() should be called with the returned txn to release
+// it.  txn is set to NULL if there is no data, but passing a NULL txn to
+// cache_done() is harmless.
 size_t
-POPState::cache_get(void **data, const char *component)
+POPState::cache_get(MDB_txn **txn, void **data, const char *component)
 {
     // Construct lookup key
     std::string keystr = std::to_string(hash) + std::string(":") + std::string(component);
 
+    (*txn) = NULL;
+    (*data) = NULL;
+
     // As implemented this shouldn't be necessary, since all our keys are below
     // the default size limit (511)
     //if (keystr.length()*sizeof(char) > mdb_env_get_maxkeysize(c->i->lod_env))
     //	return 0;
-    char *keycstr = bu_strdup(keystr.c_str());
-    mdb_txn_begin(c->i->lod_env, NULL, 0, &c->i->lod_txn);
-    mdb_dbi_open(c->i->lod_txn, NULL, 0, &c->i->lod_dbi);
+    MDB_val mdb_key, mdb_data;
+    if (mdb_txn_begin(c->i->lod_env, NULL, MDB_RDONLY, txn)) {
+	(*txn) = NULL;
+	return 0;
+    }
     mdb_key.mv_size = keystr.length()*sizeof(char);
-    mdb_key.mv_data = (void *)keycstr;
-    int rc = mdb_get(c->i->lod_txn, c->i->lod_dbi, &mdb_key, &mdb_data[0]);
+    mdb_key.mv_data = (void *)keystr.c_str();
+    int rc = mdb_get(*txn, c->i->lod_dbi, &mdb_key, &mdb_data);
     if (rc) {
-	bu_free(keycstr, "keycstr");
-	(*data) = NULL;
+	mdb_txn_abort(*txn);
+	(*txn) = NULL;
 	return 0;
     }
-    bu_free(keycstr, "keycstr");
-    (*data) = mdb_data[0].mv_data;
+    (*data) = mdb_data.mv_data;
 
-    return mdb_data[0].mv_size;
+    return mdb_data.mv_size;
 }
 
 void
-POPState::cache_done()
+POPState::cache_done(MDB_txn *txn)
 {
-    mdb_txn_commit(c->i->lod_txn);
+    if (txn)
+	mdb_txn_abort(txn);
 }
 
 bool
@@ -1912,6 +2193,41 @@ bv_mesh_lod_cache(struct bv_mesh_lod_context *c, const point_t *v, size_t vcnt,
     return key;
 }
 
+extern "C" int
+bv_mesh_lod_cache_bg(struct bv_mesh_lod_context *c, const char *name, const point_t *v, size_t vcnt, const vect_t *vn, int *faces, size_t fcnt, fastf_t fratio, int priority, void (*done)(unsigned long long, void *), void *cb_data)
+{
+    if (!c || !name || !v || !vcnt || !faces || !fcnt)
+	return -1;
+
+    // Only one build per name at a time
+    std::string oname(name);
+    {
+	std::lock_guard<std::mutex> lk(c->i->jobs_lock);
+	if (c->i->building.find(oname) != c->i->building.end())
+	    return 0;
+	c->i->building.insert(oname);
+    }
+
+    lod_job_add(c, priority, [c, oname, v, vcnt, vn, faces, fcnt, fratio, done, cb_data](bool cancel) {
+	    unsigned long long key = 0;
+	    if (!cancel) {
+		POPState p(c, v, vcnt, vn, faces, fcnt, 0, fratio);
+		if (p.is_valid) {
+		    key = p.hash;
+		    bv_mesh_lod_key_put(c, oname.c_str(), key);
+		}
+	    }
+	    if (!cancel) {
+		std::lock_guard<std::mutex> lk(c->i->jobs_lock);
+		c->i->building.erase(oname);
+	    }
+	    if (done)
+		(*done)(key, cb_data);
+	    });
+
+    return 1;
+}
+
 extern "C" struct bv_mesh_lod *
 bv_mesh_lod_create(struct bv_mesh_lod_context *c, unsigned long long key)
 {
@@ -1969,25 +2285,10 @@ dlist_stale(struct bv_scene_obj *s)
     s->s_dlist_stale = 1;
 }
 
-extern "C" int
-bv_mesh_lod_level(struct bv_scene_obj *s, int level, int reset)
+// Point the drawing info at the current POP data
+static void
+lod_pop_pointers(struct bv_mesh_lod *l, POPState *sp)
 {
-    if (!s)
-	return -1;
-
-    struct bv_mesh_lod *l = (struct bv_mesh_lod *)s->draw_data;
-    if (!l)
-	return -1;
-    struct bv_mesh_lod_internal *i = (struct bv_mesh_lod_internal *)l->i;
-    POPState *sp = i->s;
-    if (level < 0)
-	return sp->curr_level;
-
-    int old_level = sp->curr_level;
-
-    sp->force_update = (reset) ? true : false;
-    sp->set_level(level);
-
     // If we're in POP territory use the local arrays - otherwise, they
     // were already set by the full detail callback.
     if (sp->curr_level <= sp->max_pop_threshold_level) {
@@ -2010,6 +2311,31 @@ bv_mesh_lod_level(struct bv_scene_obj *s, int level, int reset)
 	l->points = (const point_t *)sp->lod_tri_pnts_snapped.data();
 	l->pcnt = (int)sp->lod_tri_pnts_snapped.size();
     }
+}
+
+extern "C" int
+bv_mesh_lod_level(struct bv_scene_obj *s, int level, int reset)
+{
+    if (!s)
+	return -1;
+
+    struct bv_mesh_lod *l = (struct bv_mesh_lod *)s->draw_data;
+    if (!l)
+	return -1;
+    struct bv_mesh_lod_internal *i = (struct bv_mesh_lod_internal *)l->i;
+    POPState *sp = i->s;
+    if (level < 0)
+	return sp->curr_level;
+
+    // An explicit level supersedes any background load in progress
+    sp->load_cancel();
+
+    int old_level = sp->curr_level;
+
+    sp->force_update = (reset) ? true : false;
+    sp->set_level(level);
+
+    lod_pop_pointers(l, sp);
 
     bv_log(2, "bv_mesh_lod_level %s[%d](%d): %d", bu_vls_cstr(&s->s_name), level, reset, l->fcnt);
 
@@ -2042,10 +2368,50 @@ bv_mesh_lod_view(struct bv_scene_obj *s, struct bview *v, int reset)
 
     // If the object is not visible in the scene, don't change the data
     //bu_log("min: %f %f %f max: %f %f %f\n", V3ARGS(s->bmin), V3ARGS(s->bmax));
-    if (_obj_visible(s, v))
-	ret = bv_mesh_lod_level(s, vscale, reset);
+    if (!_obj_visible(s, v))
+	return ret;
+
+    // Pick up anything the workers have finished
+    if (bv_mesh_lod_sync(s) == 1)
+	ret = sp->curr_level;
+
+    // Reading in finer POP levels is the expensive case - once the object
+    // has been drawn, and if the application has a ready callback to
+    // schedule a redraw with, hand that off to the workers and keep drawing
+    // what we have until the data is ready.  Bigger jumps in detail go to
+    // the front of the line.  Without the callback nothing would redraw
+    // when the data arrives, so the load is done now.  Everything else (the
+    // first draw, coarsening, memshrink recovery and switching to the full
+    // detail callbacks) is cheap or needs the calling thread, and is also
+    // done now.
+    if (!reset && sp->drawn && sp->ready_clbk && sp->curr_level >= 0 && vscale > sp->curr_level && vscale <= sp->max_pop_threshold_level) {
+	sp->load_async(vscale, 1 + vscale - sp->curr_level);
+	return ret;
+    }
+
+    return bv_mesh_lod_level(s, vscale, reset);
+}
 
-    return ret;
+extern "C" int
+bv_mesh_lod_sync(struct bv_scene_obj *s)
+{
+    if (!s)
+	return -1;
+    struct bv_mesh_lod *l = (struct bv_mesh_lod *)s->draw_data;
+    if (!l)
+	return -1;
+
+    struct bv_mesh_lod_internal *i = (struct bv_mesh_lod_internal *)l->i;
+    POPState *sp = i->s;
+    sp->drawn = true;
+    if (!sp->load_sync())
+	return 0;
+
+    lod_pop_pointers(l, sp);
+    bv_log(2, "bv_mesh_lod_sync %s: %d", bu_vls_cstr(&s->s_name), sp->curr_level);
+    dlist_stale(s);
+
+    return 1;
 }
 
 extern "C" void
@@ -2070,12 +2436,13 @@ cache_del(struct bv_mesh_lod_context *c, unsigned long long hash, const char *co
     MDB_val mdb_key;
     std::string keystr = std::to_string(hash) + std::string(":") + std::string(component);
 
-    mdb_txn_begin(c->i->lod_env, NULL, 0, &c->i->lod_txn);
-    mdb_dbi_open(c->i->lod_txn, NULL, 0, &c->i->lod_dbi);
+    MDB_txn *txn;
+    if (mdb_txn_begin(c->i->lod_env, NULL, 0, &txn))
+	return;
     mdb_key.mv_size = keystr.length()*sizeof(char);
     mdb_key.mv_data = (void *)keystr.c_str();
-    mdb_del(c->i->lod_txn, c->i->lod_dbi, &mdb_key, NULL);
-    mdb_txn_commit(c->i->lod_txn);
+    mdb_del(txn, c->i->lod_dbi, &mdb_key, NULL);
+    mdb_txn_commit(txn);
 }
 
 
@@ -2100,19 +2467,20 @@ bv_mesh_lod_clear_cache(struct bv_mesh_lod_context *c, unsigned long long key)
 	// Iterate over the name/key mapper, removing anything with a value
 	// of key
 	MDB_val mdb_key, mdb_data;
+	MDB_txn *txn;
 	unsigned long long *fkeyp = NULL;
 	unsigned long long fkey = 0;
-	mdb_txn_begin(c->i->name_env, NULL, 0, &c->i->name_txn);
-	mdb_dbi_open(c->i->name_txn, NULL, 0, &c->i->name_dbi);
+	if (mdb_txn_begin(c->i->name_env, NULL, 0, &txn))
+	    return;
 	MDB_cursor *cursor;
-	int rc = mdb_cursor_open(c->i->name_txn, c->i->name_dbi, &cursor);
+	int rc = mdb_cursor_open(txn, c->i->name_dbi, &cursor);
 	if (rc) {
-	    mdb_txn_commit(c->i->name_txn);
+	    mdb_txn_commit(txn);
 	    return;
 	}
 	rc = mdb_cursor_get(cursor, &mdb_key, &mdb_data, MDB_FIRST);
 	if (rc) {
-	    mdb_txn_commit(c->i->name_txn);
+	    mdb_txn_commit(txn);
 	    return;
 	}
 	fkeyp = (unsigned long long *)mdb_data.mv_data;
@@ -2125,52 +2493,53 @@ bv_mesh_lod_clear_cache(struct bv_mesh_lod_context *c, unsigned long long key)
 	    if (fkey == key)
 		mdb_cursor_del(cursor, 0);
 	}
-	mdb_txn_commit(c->i->name_txn);
+	mdb_txn_commit(txn);
 	return;
     }
 
     if (c && !key) {
 
 	MDB_val mdb_key, mdb_data;
+	MDB_txn *txn;
 	MDB_cursor *cursor;
 	int rc;
 
 	// Clear the actual LoD data
-	mdb_txn_begin(c->i->lod_env, NULL, 0, &c->i->lod_txn);
-	mdb_dbi_open(c->i->lod_txn, NULL, 0, &c->i->lod_dbi);
-	rc = mdb_cursor_open(c->i->lod_txn, c->i->lod_dbi, &cursor);
+	if (mdb_txn_begin(c->i->lod_env, NULL, 0, &txn))
+	    return;
+	rc = mdb_cursor_open(txn, c->i->lod_dbi, &cursor);
 	if (rc) {
-	    mdb_txn_commit(c->i->lod_txn);
+	    mdb_txn_commit(txn);
 	    return;
 	}
 	rc = mdb_cursor_get(cursor, &mdb_key, &mdb_data, MDB_FIRST);
 	if (rc) {
-	    mdb_txn_commit(c->i->lod_txn);
+	    mdb_txn_commit(txn);
 	    return;
 	}
 	mdb_cursor_del(cursor, 0);
 	while (!mdb_cursor_get(cursor, &mdb_key, &mdb_data, MDB_NEXT))
 	    mdb_cursor_del(cursor, 0);
-	mdb_txn_commit(c->i->lod_txn);
+	mdb_txn_commit(txn);
 
 	// Iterate over the name/key mapper, removing anything with a value
 	// of key
-	mdb_txn_begin(c->i->name_env, NULL, 0, &c->i->name_txn);
-	mdb_dbi_open(c->i->name_txn, NULL, 0, &c->i->name_dbi);
-	rc = mdb_cursor_open(c->i->name_txn, c->i->name_dbi, &cursor);
+	if (mdb_txn_begin(c->i->name_env, NULL, 0, &txn))
+	    return;
+	rc = mdb_cursor_open(txn, c->i->name_dbi, &cursor);
 	if (rc) {
-	    mdb_txn_commit(c->i->name_txn);
+	    mdb_txn_commit(txn);
 	    return;
 	}
 	rc = mdb_cursor_get(cursor, &mdb_key, &mdb_data, MDB_FIRST);
 	if (rc) {
-	    mdb_txn_commit(c->i->name_txn);
+	    mdb_txn_commit(txn);
 	    return;
 	}
 	mdb_cursor_del(cursor, 0);
 	while (!mdb_cursor_get(cursor, &mdb_key, &mdb_data, MDB_NEXT))
 	    mdb_cursor_del(cursor, 0);
-	mdb_txn_commit(c->i->name_txn);
+	mdb_txn_commit(txn);
 
 	return;
     }
@@ -2224,6 +2593,22 @@ bv_mesh_lod_detail_free_clbk(
     s->full_detail_free_clbk = clbk;
 }
 
+extern "C" void
+bv_mesh_lod_ready_clbk(
+	struct bv_mesh_lod *lod,
+	void (*clbk)(struct bv_mesh_lod *, void *),
+	void *clbk_data
+	)
+{
+    if (!lod)
+	return;
+
+    struct bv_mesh_lod_internal *i = (struct bv_mesh_lod_internal *)lod->i;
+    POPState *s = i->s;
+    s->ready_clbk = clbk;
+    s->ready_clbk_data = clbk_data;
+}
+
 void
 bv_mesh_lod_free(struct bv_scene_obj *s)
 {
@@ -0,0 +1,280 @@
+/*                           L O D . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file lod.c
+ *
+ * Check that mesh LoD view updates made before an object is first drawn
+ * load the requested level right away, and that finer levels requested
+ * after that are read in the background and reported through the ready
+ * callback.
+ *
+ */
+
+#include "common.h"
+
+#include <string.h>
+
+#include "bu/app.h"
+#include "bu/env.h"
+#include "bu/file.h"
+#include "bu/log.h"
+#include "bu/parallel.h"
+#include "bu/ptbl.h"
+#include "bu/snooze.h"
+#include "bu/time.h"
+#include "bu/vls.h"
+#include "vmath.h"
+#include "bv.h"
+#include "bv/lod.h"
+
+
+#define LOD_CACHE_DIR "bview_lod_cache"
+
+/* sphere tessellation */
+#define NLAT 64
+#define NLON 128
+
+#define NVERTS (2 + (NLAT - 1) * NLON)
+#define NFACES (2 * NLON * (NLAT - 1))
+
+/* how long to wait for a background load, in seconds */
+#define LOD_WAIT 60
+
+
+static int ready_cnt = 0;
+
+static void
+lod_ready(struct bv_mesh_lod *UNUSED(lod), void *data)
+{
+    int *cnt = (int *)data;
+    bu_semaphore_acquire(BU_SEM_GENERAL);
+    (*cnt)++;
+    bu_semaphore_release(BU_SEM_GENERAL);
+}
+
+
+static int
+ready_get(void)
+{
+    int cnt;
+    bu_semaphore_acquire(BU_SEM_GENERAL);
+    cnt = ready_cnt;
+    bu_semaphore_release(BU_SEM_GENERAL);
+    return cnt;
+}
+
+
+static void
+mk_sphere(point_t *verts, int *faces, fastf_t r)
+{
+    int nf = 0;
+    int i, j;
+
+    VSET(verts[0], 0.0, 0.0, r);
+    for (i = 1; i < NLAT; i++) {
+	fastf_t phi = M_PI * i / NLAT;
+	for (j = 0; j < NLON; j++) {
+	    fastf_t theta = M_2PI * j / NLON;
+	    VSET(verts[1 + (i - 1) * NLON + j], r * sin(phi) * cos(theta), r * sin(phi) * sin(theta), r * cos(phi));
+	}
+    }
+    VSET(verts[NVERTS - 1], 0.0, 0.0, -r);
+
+#define RING(_i, _j) (1 + ((_i) - 1) * NLON + ((_j) % NLON))
+    for (j = 0; j < NLON; j++) {
+	VSET(&faces[3 * nf], 0, RING(1, j), RING(1, j + 1));
+	nf++;
+	VSET(&faces[3 * nf], NVERTS - 1, RING(NLAT - 1, j + 1), RING(NLAT - 1, j));
+	nf++;
+    }
+    for (i = 1; i < NLAT - 1; i++) {
+	for (j = 0; j < NLON; j++) {
+	    VSET(&faces[3 * nf], RING(i, j), RING(i + 1, j), RING(i + 1, j + 1));
+	    nf++;
+	    VSET(&faces[3 * nf], RING(i, j), RING(i + 1, j + 1), RING(i, j + 1));
+	    nf++;
+	}
+    }
+#undef RING
+}
+
+
+/* Zoom the view to size and update the LoD for it */
+static int
+view_update(struct bv_scene_obj *s, struct bview *v, fastf_t size)
+{
+    v->gv_size = size;
+    v->gv_scale = 0.5 * size;
+    v->gv_isize = 1.0 / size;
+    return bv_mesh_lod_view(s, v, 0);
+}
+
+
+int
+main(int UNUSED(argc), const char *argv[])
+{
+    point_t *verts;
+    int *faces;
+    struct bv_mesh_lod_context *c;
+    struct bv_mesh_lod *lod;
+    struct bview v;
+    struct bv_scene_obj s;
+    unsigned long long key;
+    int l0, l1, l2, l3, lz;
+    int64_t start;
+    int ret = 0;
+
+    bu_setprogname(argv[0]);
+
+    /* Keep the cache out of the user's home directory */
+    if (!bu_file_exists(LOD_CACHE_DIR, NULL))
+	bu_mkdir(LOD_CACHE_DIR);
+    bu_setenv("BU_DIR_CACHE", LOD_CACHE_DIR, 1);
+
+    verts = (point_t *)bu_calloc(NVERTS, sizeof(point_t), "verts");
+    faces = (int *)bu_calloc(NFACES * 3, sizeof(int), "faces");
+    mk_sphere(verts, faces, 10.0);
+
+    c = bv_mesh_lod_context_create("bview_lod_sphere");
+    if (!c)
+	bu_exit(1, "unable to create LoD context\n");
+    key = bv_mesh_lod_cache(c, (const point_t *)verts, NVERTS, NULL, faces, NFACES, 0, 1);
+    if (!key)
+	bu_exit(1, "unable to cache LoD data\n");
+    lod = bv_mesh_lod_create(c, key);
+    if (!lod)
+	bu_exit(1, "unable to create LoD\n");
+
+    /* A view looking at the whole sphere, with no view set so only this
+     * view drives the level selection */
+    memset(&v, 0, sizeof(struct bview));
+    bv_init(&v, NULL);
+    bu_vls_sprintf(&v.gv_name, "V0");
+    VSETALL(v.obb_center, 0.0);
+    VSET(v.obb_extent1, 1000.0, 0.0, 0.0);
+    VSET(v.obb_extent2, 0.0, 1000.0, 0.0);
+    VSET(v.obb_extent3, 0.0, 0.0, 1000.0);
+
+    memset(&s, 0, sizeof(struct bv_scene_obj));
+    BU_PTBL_INIT(&s.children);
+    bu_vls_init(&s.s_name);
+    bu_vls_sprintf(&s.s_name, "sphere");
+    s.s_v = &v;
+    s.draw_data = (void *)lod;
+    VMOVE(s.bmin, lod->bmin);
+    VMOVE(s.bmax, lod->bmax);
+    lod->s = &s;
+
+    bv_mesh_lod_ready_clbk(lod, &lod_ready, (void *)&ready_cnt);
+
+    /* Before the first draw, view changes must load right away - there is
+     * no later draw to pick up background work */
+    l0 = view_update(&s, &v, 2000.0);
+    l1 = view_update(&s, &v, 200.0);
+    if (l0 < 0 || l1 <= l0 || bv_mesh_lod_level(&s, -1, 0) != l1 || !lod->fcnt) {
+	bu_log("initial view updates: levels %d -> %d, loaded %d with %d faces\n", l0, l1, bv_mesh_lod_level(&s, -1, 0), lod->fcnt);
+	ret = 1;
+    }
+    if (ready_get()) {
+	bu_log("ready callback fired for an immediate load\n");
+	ret = 1;
+    }
+
+    /* First draw */
+    if (bv_mesh_lod_sync(&s) != 0) {
+	bu_log("first sync reported new data\n");
+	ret = 1;
+    }
+    s.s_dlist_stale = 0;
+
+    /* Without a ready callback nothing would redraw when background data
+     * arrived, so zooming in after the first draw must still load the
+     * finer level right away */
+    bv_mesh_lod_ready_clbk(lod, NULL, NULL);
+    lz = view_update(&s, &v, 20.0);
+    if (lz <= l1 || bv_mesh_lod_level(&s, -1, 0) != lz) {
+	bu_log("view update with no ready callback: levels %d -> %d, loaded %d\n", l1, lz, bv_mesh_lod_level(&s, -1, 0));
+	ret = 1;
+    }
+    if (view_update(&s, &v, 200.0) != l1) {
+	bu_log("zooming back out did not return to level %d\n", l1);
+	ret = 1;
+    }
+    (void)bv_mesh_lod_sync(&s);
+    s.s_dlist_stale = 0;
+    bv_mesh_lod_ready_clbk(lod, &lod_ready, (void *)&ready_cnt);
+
+    /* Once drawn, and with a ready callback to prompt a redraw, a finer
+     * level is read in the background and the old level stays in place
+     * until it is synced */
+    l2 = view_update(&s, &v, 20.0);
+    if (l2 != l1) {
+	bu_log("view update after the first draw changed the level immediately: %d -> %d\n", l1, l2);
+	ret = 1;
+    }
+
+    start = bu_gettime();
+    while (!ready_get() && bu_gettime() - start < LOD_WAIT * 1000000LL)
+	bu_snooze(BU_SEC2USEC(0.01));
+    if (!ready_get()) {
+	bu_log("ready callback not called within %d seconds\n", LOD_WAIT);
+	ret = 1;
+    } else {
+	if (bv_mesh_lod_sync(&s) != 1) {
+	    bu_log("sync after ready callback did not pick up new data\n");
+	    ret = 1;
+	}
+	l3 = bv_mesh_lod_level(&s, -1, 0);
+	if (l3 <= l1) {
+	    bu_log("background load left level at %d (was %d)\n", l3, l1);
+	    ret = 1;
+	}
+	if (!s.s_dlist_stale) {
+	    bu_log("background load did not mark the display list stale\n");
+	    ret = 1;
+	}
+    }
+
+    bv_mesh_lod_destroy(lod);
+    bv_mesh_lod_context_destroy(c);
+    bu_ptbl_free(&s.children);
+    bu_vls_free(&s.s_name);
+    bv_free(&v);
+    bu_free(verts, "verts");
+    bu_free(faces, "faces");
+
+    if (ret) {
+	bu_log("mesh LoD view loading [FAIL]\n");
+	return 1;
+    }
+
+    bu_log("mesh LoD view loading [PASS]\n");
+    return 0;
+}
+
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
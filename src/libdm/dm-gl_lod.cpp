@@ -66,6 +66,9 @@ dlist_free_callback(struct bv_scene_obj *s)
 static int
 gl_draw_tri(struct dm *dmp, struct bv_mesh_lod *lod)
 {
+    // Pick up any finer level data read in since the last view update
+    bv_mesh_lod_sync(lod->s);
+
     int fcnt = lod->fcnt;
     int pcnt = lod->pcnt;
     const int *faces = lod->faces;
@@ -55,6 +55,7 @@
 #include "bu/sort.h"
 #include "bu/units.h"
 #include "bv/plot3.h"
+#include "bg/vert_tree.h"
 #include "obj_parser.h"
 #include "tri_face.h"
 
@@ -1911,8 +1912,8 @@ populate_fuse_map(struct ga_t *ga,
     size_t idx1 = 0;
     size_t idx2 = 0;
     size_t fuse_count = 0;
-    fastf_t tmp_v1[3];
-    fastf_t tmp_v2[3];
+    fastf_t *verts = (fastf_t *)NULL;
+    size_t *weld_map = (size_t *)NULL;
     fastf_t distance_between_vertices = 0.0;
     size_t *fuse_map = (size_t *)NULL;
     short int *fuse_flag = (short int *)NULL;
@@ -1928,41 +1929,43 @@ populate_fuse_map(struct ga_t *ga,
 	fuse_offset = gfi->vertex_fuse_offset;
     }
 
-    /* the loop below is the expensive part of the fusing operation. */
+    if (!num_unique_index_list)
+	return 0;
+
+    verts = (fastf_t *)bu_malloc(num_unique_index_list * 3 * sizeof(fastf_t), "verts");
+    for (idx1 = 0 ; idx1 < num_unique_index_list ; idx1++) {
+	VSCALE(&verts[3*idx1], ga->vert_list[unique_index_list[idx1]], conv_factor);
+    }
+
+    /* each vertex is fused into the first earlier, not already fused,
+     * vertex within tolerance.  VEQUAL is within SMALL_FASTF, so a zero
+     * tolerance weld is used for it.
+     */
+    weld_map = (size_t *)bu_malloc(num_unique_index_list * sizeof(size_t), "weld_map");
+    (void)bg_vert_weld(weld_map, verts, num_unique_index_list,
+		       (compare_type == FUSE_EQUAL) ? 0.0 : tol->dist_sq);
 
     /* only set the flag for duplicates */
-    idx1 = 0;
-    while (idx1 < num_unique_index_list) {
-	if (fuse_flag[unique_index_list[idx1] - fuse_offset] == 0) {
-	    /* true if current vertex has not already been identified as a duplicate */
-	    idx2 = idx1 + 1;
-	    VMOVE(tmp_v1, ga->vert_list[unique_index_list[idx1]]);
-	    VSCALE(tmp_v1, tmp_v1, conv_factor);
-	    fuse_map[unique_index_list[idx1] - fuse_offset] = unique_index_list[idx1];
-	    while (idx2 < num_unique_index_list) {
-		if (fuse_flag[unique_index_list[idx2] - fuse_offset] == 0) {
-		    VMOVE(tmp_v2, ga->vert_list[unique_index_list[idx2]]);
-		    VSCALE(tmp_v2, tmp_v2, conv_factor);
-		    if ((compare_type == FUSE_EQUAL) ? VEQUAL(tmp_v1, tmp_v2) :
-			bg_pnt3_pnt3_equal(tmp_v1, tmp_v2, tol)) {
-			if (ga->gcv_options->debug_mode) {
-			    distance_between_vertices = DIST_PNT_PNT(tmp_v1, tmp_v2);
-			    bu_log("found equal i1=(%zu)vi1=(%zu)v1=(%f)(%f)(%f), i2=(%zu)vi2=(%zu)v2=(%f)(%f)(%f), dist = (%lu mm)\n",
-				   idx1, unique_index_list[idx1], tmp_v1[0], tmp_v1[1], tmp_v1[2],
-				   idx2, unique_index_list[idx2], tmp_v2[0], tmp_v2[1], tmp_v2[2],
-				   (unsigned long)distance_between_vertices);
-			}
-			fuse_map[unique_index_list[idx2] - fuse_offset] = unique_index_list[idx1];
-			fuse_flag[unique_index_list[idx2] - fuse_offset] = 1;
-			fuse_count++;
-		    }
-		}
-		idx2++;
-	    }
+    for (idx2 = 0 ; idx2 < num_unique_index_list ; idx2++) {
+	idx1 = weld_map[idx2];
+	fuse_map[unique_index_list[idx2] - fuse_offset] = unique_index_list[idx1];
+	if (idx1 == idx2)
+	    continue;
+
+	if (ga->gcv_options->debug_mode) {
+	    distance_between_vertices = DIST_PNT_PNT(&verts[3*idx1], &verts[3*idx2]);
+	    bu_log("found equal i1=(%zu)vi1=(%zu)v1=(%f)(%f)(%f), i2=(%zu)vi2=(%zu)v2=(%f)(%f)(%f), dist = (%lu mm)\n",
+		   idx1, unique_index_list[idx1], V3ARGS(&verts[3*idx1]),
+		   idx2, unique_index_list[idx2], V3ARGS(&verts[3*idx2]),
+		   (unsigned long)distance_between_vertices);
 	}
-	idx1++;
+	fuse_flag[unique_index_list[idx2] - fuse_offset] = 1;
+	fuse_count++;
     }
 
+    bu_free(weld_map, "weld_map");
+    bu_free(verts, "verts");
+
     if (ga->gcv_options->debug_mode) {
 	for (idx1 = 0 ; idx1 < num_unique_index_list ; idx1++) {
 	    bu_log("fused unique_index_list = (%zu)->(%zu)\n", unique_index_list[idx1],
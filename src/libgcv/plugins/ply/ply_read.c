@@ -31,6 +31,7 @@
 #include "bu/getopt.h"
 #include "gcv/api.h"
 #include "bu/malloc.h"
+#include "bg/vert_tree.h"
 #include "wdb.h"
 #include "rply.h"
 
@@ -39,6 +40,7 @@ struct ply_read_options
 {
     int verbose;                        /* verbose output flag */
     int debug;                          /* debug output flag */
+    int weld;                           /* merge coincident vertices flag */
 };
 
 struct conversion_state
@@ -51,6 +53,8 @@ struct conversion_state
     struct rt_wdb *fd_out;	        /* Resulting BRL-CAD file */
 
     struct rt_bot_internal* bot;        /* converted bot */    
+    size_t face_cnt;                    /* triangles read so far */
+    size_t face_max;                    /* triangles bot->faces has room for */
     struct wmember wm;                  /* handle for in-memory combinations */
 };
 
@@ -137,11 +141,10 @@ color_cb(p_ply_argument argument)
 static int
 face_cb(p_ply_argument argument)
 {
-    static int cur_face = -1;
-    
     long list_len, vert_index;
-    struct rt_bot_internal bot;
-    struct rt_bot_internal *pbot = &bot;
+    struct conversion_state *pstate = NULL;
+    struct rt_bot_internal *pbot;
+    int *face;
     int botval;
     if (!ply_get_argument_property(argument, NULL, &list_len, &vert_index)) {
 	bu_bomb("Unable to import face lists");
@@ -150,28 +153,35 @@ face_cb(p_ply_argument argument)
 	bu_log("ignoring face with %ld vertices\n", list_len);
 	return 1;
     }
-    ply_get_argument_user_data(argument, (void **)&pbot, NULL);
+    ply_get_argument_user_data(argument, (void **)&pstate, NULL);
+    pbot = pstate->bot;
     botval = ply_get_argument_value(argument);
 
+    /* The header only gives the number of polygons, so the faces array
+     * starts with room for one triangle each and grows as quads turn
+     * up, rather than reserving room for every face to be a quad */
+    if (vert_index == 0 && pstate->face_cnt + 2 > pstate->face_max) {
+	pstate->face_max += pstate->face_max / 4 + 2;
+	pbot->faces = (int *)bu_realloc(pbot->faces, pstate->face_max * 3 * sizeof(int), "bot faces");
+    }
+    face = &pbot->faces[pstate->face_cnt*3];
+
     switch (vert_index) {
 	case 0:
-	    cur_face++;
-	    pbot->faces[cur_face*3] = botval;
-	    break;
 	case 1:
-	    pbot->faces[cur_face*3+1] = botval;
+	    face[vert_index] = botval;
 	    break;
 	case 2:
-	    pbot->faces[cur_face*3+2] = botval;
+	    face[2] = botval;
+	    if (list_len == 3)
+		pstate->face_cnt++;
 	    break;
 	case 3:
 	    /* need to break this into two BOT faces */
-	    pbot->num_faces++;
-	    pbot->faces = (int *)bu_realloc(pbot->faces, pbot->num_faces * 3 * sizeof(int), "bot_faces");
-	    pbot->faces[cur_face*3+3] = botval;
-	    pbot->faces[cur_face*3+4] = pbot->faces[cur_face*3];
-	    pbot->faces[cur_face*3+5] = pbot->faces[cur_face*3+2];
-	    cur_face++;
+	    face[3] = botval;
+	    face[4] = face[0];
+	    face[5] = face[2];
+	    pstate->face_cnt += 2;
 	    break;
 	default:
 	    /* will never execute because lists of length > 4 are not allowed */
@@ -180,6 +190,68 @@ face_cb(p_ply_argument argument)
     return 1;
 }
 
+/* weld_bot
+ *
+ * merge vertices within the calculational tolerance, which PLY files
+ * from scanners often repeat per face, and drop the faces that collapse
+ */
+static void
+weld_bot(struct conversion_state* pstate)
+{
+    struct rt_bot_internal *bot = pstate->bot;
+    size_t *map = (size_t *)bu_malloc(bot->num_vertices * sizeof(size_t), "weld map");
+    size_t nverts = 0;
+    size_t nfaces = 0;
+    size_t i;
+
+    (void)bg_vert_weld(map, bot->vertices, bot->num_vertices, pstate->gcv_options->calculational_tolerance.dist_sq);
+
+    /* compact the kept vertices, which stay in their original order,
+     * renumbering them in the weld map as we go.  A merged vertex maps
+     * to an earlier kept one that has already been renumbered. */
+    for (i = 0; i < bot->num_vertices; i++) {
+	if (map[i] != i) {
+	    map[i] = map[map[i]];
+	    continue;
+	}
+	map[i] = nverts;
+	VMOVE(&bot->vertices[nverts*3], &bot->vertices[i*3]);
+	nverts++;
+    }
+
+    for (i = 0; i < bot->num_faces; i++) {
+	int *face = &bot->faces[i*3];
+	int *out = &bot->faces[nfaces*3];
+	int j;
+
+	for (j = 0; j < 3; j++) {
+	    if (face[j] < 0 || (size_t)face[j] >= bot->num_vertices)
+		break;
+	}
+	if (j < 3) {
+	    bu_log("ignoring face with invalid vertex index\n");
+	    continue;
+	}
+
+	out[0] = (int)map[face[0]];
+	out[1] = (int)map[face[1]];
+	out[2] = (int)map[face[2]];
+	if (out[0] == out[1] || out[0] == out[2] || out[1] == out[2])
+	    continue;
+	nfaces++;
+    }
+
+    if (pstate->ply_read_options->verbose || pstate->gcv_options->verbosity_level) {
+	bu_log("Welded %zu vertices into %zu, dropped %zu degenerate faces\n",
+	       bot->num_vertices, nverts, bot->num_faces - nfaces);
+    }
+
+    bot->num_vertices = nverts;
+    bot->num_faces = nfaces;
+
+    bu_free(map, "weld map");
+}
+
 static void
 convert_input(struct conversion_state* pstate)
 {
@@ -219,13 +291,15 @@ convert_input(struct conversion_state* pstate)
     ply_set_read_cb(ply_fp, "face", "red", color_cb, &irgb, 0);
     ply_set_read_cb(ply_fp, "face", "green", color_cb, &irgb, 1);
     ply_set_read_cb(ply_fp, "face", "blue", color_cb, &irgb, 2);
-    pstate->bot->num_faces = ply_set_read_cb(ply_fp, "face", "vertex_indices", face_cb, pstate->bot, 0);
+    pstate->bot->num_faces = ply_set_read_cb(ply_fp, "face", "vertex_indices", face_cb, pstate, 0);
 
     if (pstate->bot->num_faces < 1 || pstate->bot->num_vertices < 1) {
 	bu_log("This PLY file appears to contain no geometry!\n");
 	goto free_bot;
     }
-    pstate->bot->faces = (int *)bu_calloc(pstate->bot->num_faces * 3, sizeof(int), "bot faces");
+    pstate->face_cnt = 0;
+    pstate->face_max = pstate->bot->num_faces;
+    pstate->bot->faces = (int *)bu_calloc(pstate->face_max * 3, sizeof(int), "bot faces");
     pstate->bot->vertices = (fastf_t *)bu_calloc(pstate->bot->num_vertices * 3, sizeof(fastf_t), "bot vertices");
 
     if (!ply_read(ply_fp)) {
@@ -235,6 +309,20 @@ convert_input(struct conversion_state* pstate)
 
     ply_close(ply_fp);
 
+    pstate->bot->num_faces = pstate->face_cnt;
+    if (pstate->bot->num_faces < 1) {
+	bu_log("This PLY file contains no usable faces!\n");
+	goto free_bot;
+    }
+
+    if (pstate->ply_read_options->weld) {
+	weld_bot(pstate);
+	if (pstate->bot->num_faces < 1) {
+	    bu_log("This PLY file contains only degenerate faces!\n");
+	    goto free_bot;
+	}
+    }
+
     /* convert to .g
      * generate object name by striping input file of slashes and .ply */
     periodpos = strrchr(striped_input, '.');
@@ -317,16 +405,18 @@ ply_read_create_opts(struct bu_opt_desc** options_desc, void** dest_options_data
 
     BU_ALLOC(options_data, struct ply_read_options);
     *dest_options_data = options_data;
-    *options_desc = (struct bu_opt_desc *)bu_malloc(4 * sizeof(struct bu_opt_desc), "options_desc");
+    *options_desc = (struct bu_opt_desc *)bu_malloc(5 * sizeof(struct bu_opt_desc), "options_desc");
 
     scale_factor = 1000.0;                      /* default units are meters */
     options_data->verbose = 0;                  /* default flag = off */
     options_data->debug = 0;                    /* default flag = off */
+    options_data->weld = 0;                     /* default flag = off */
 
     BU_OPT((*options_desc)[0], "s", "scale_factor", "float", bu_opt_fastf_t, &scale_factor, "specify the scale factor");
     BU_OPT((*options_desc)[1], "v", "verbose",      "",      NULL,           &options_data->verbose,      "specify to run with verbose output");
     BU_OPT((*options_desc)[2], "d", "debug",        "",      NULL,           &options_data->debug,        "specify specify to run with debug output");
-    BU_OPT_NULL((*options_desc)[3]);
+    BU_OPT((*options_desc)[3], "w", "weld",         "",      NULL,           &options_data->weld,         "merge vertices closer than the calculational tolerance and drop the faces that collapse");
+    BU_OPT_NULL((*options_desc)[4]);
 }
 
 static void
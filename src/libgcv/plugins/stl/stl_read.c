@@ -40,11 +40,14 @@
 
 #include "bu/cv.h"
 #include "bu/getopt.h"
+#include "bu/mapped_file.h"
+#include "bu/parallel.h"
 #include "bu/path.h"
 #include "bu/units.h"
 #include "bu/vls.h"
 #include "gcv/api.h"
 #include "vmath.h"
+#include "bg/vert_tree.h"
 #include "nmg.h"
 #include "rt/geom.h"
 #include "raytrace.h"
@@ -70,35 +73,114 @@ struct conversion_state
     struct rt_wdb *fd_out;	/* Resulting BRL-CAD file */
 
     struct wmember all_head;
-    struct bg_vert_tree *tree;
-    int *bot_faces;	        /* array of ints (indices into tree->the_array array) three per face */
+    fastf_t *facets;		/* vertices of the current part, nine per facet as read */
+    size_t facet_cnt;		/* number of facets in the facets array */
+    size_t facet_max;		/* current capacity of the facets array */
 
     int id_no;	            	/* Ident numbers */
-    int bot_fsize;		/* current size of the bot_faces array */
-    int bot_fcurr;		/* current bot face */
 };
 
 
-/* Size of blocks of faces to malloc */
-#define BOT_FBLOCK 128
+/* Initial number of facets to malloc */
+#define FACET_BLOCK 1024
+
+/* Binary facets decoded by a thread at a time */
+#define FACET_CHUNK 16384
+
+/* Binary header and facet count preceding the facet records */
+#define STL_BINARY_HEADER_SIZE 84
 
 #define MAX_LINE_SIZE 512
 
 
 static void
-Add_face(struct conversion_state *pstate, int face[3])
+Add_facet(struct conversion_state *pstate, const fastf_t verts[9])
 {
-    if (!pstate->bot_faces) {
-	pstate->bot_faces = (int *)bu_malloc(3 * BOT_FBLOCK * sizeof(int), "bot_faces");
-	pstate->bot_fsize = BOT_FBLOCK;
-	pstate->bot_fcurr = 0;
-    } else if (pstate->bot_fcurr >= pstate->bot_fsize) {
-	pstate->bot_fsize += BOT_FBLOCK;
-	pstate->bot_faces = (int *)bu_realloc((void *)pstate->bot_faces, 3 * pstate->bot_fsize * sizeof(int), "bot_faces increase");
+    if (pstate->facet_cnt >= pstate->facet_max) {
+	pstate->facet_max = (pstate->facet_max) ? pstate->facet_max * 2 : FACET_BLOCK;
+	if (pstate->facets)
+	    pstate->facets = (fastf_t *)bu_realloc(pstate->facets, 9 * pstate->facet_max * sizeof(fastf_t), "facets increase");
+	else
+	    pstate->facets = (fastf_t *)bu_malloc(9 * pstate->facet_max * sizeof(fastf_t), "facets");
     }
 
-    VMOVE(&pstate->bot_faces[3*pstate->bot_fcurr], face);
-    pstate->bot_fcurr++;
+    memcpy(&pstate->facets[9*pstate->facet_cnt], verts, 9 * sizeof(fastf_t));
+    pstate->facet_cnt++;
+}
+
+
+/* Weld the vertices of the facets read for the current part and write
+ * them out as a BoT.  Facets that collapse when welded are counted in
+ * degenerate_count.  Returns the number of faces written.
+ *
+ * Binary parts can run to tens of millions of facets, so the kept
+ * vertices are renumbered in the weld map and packed into the front of
+ * the facets array in place rather than copied out.
+ */
+static int
+Make_bot(struct conversion_state *pstate, const char *solid_name, int *degenerate_count)
+{
+    size_t nverts = 3 * pstate->facet_cnt;
+    size_t *map;
+    fastf_t *verts = pstate->facets;
+    int *faces;
+    size_t nkept, i;
+    size_t face_count = 0;
+
+    if (!nverts)
+	return 0;
+
+    map = (size_t *)bu_malloc(nverts * sizeof(size_t), "weld map");
+    (void)bg_vert_weld(map, pstate->facets, nverts, pstate->gcv_options->calculational_tolerance.dist_sq);
+
+    /* Kept vertices are numbered in the order they were first seen.
+     * A merged vertex maps to an earlier kept one, which has already
+     * been renumbered by the time it is reached, and a kept vertex
+     * never moves up, so both can be done in place.
+     */
+    nkept = 0;
+    for (i = 0; i < nverts; i++) {
+	if (map[i] != i) {
+	    map[i] = map[map[i]];
+	    continue;
+	}
+	map[i] = nkept;
+	VMOVE(&verts[3*nkept], &pstate->facets[3*i]);
+	nkept++;
+    }
+
+    faces = (int *)bu_malloc(3 * pstate->facet_cnt * sizeof(int), "bot faces");
+    for (i = 0; i < pstate->facet_cnt; i++) {
+	int *face = &faces[3*face_count];
+	face[0] = (int)map[3*i];
+	face[1] = (int)map[3*i+1];
+	face[2] = (int)map[3*i+2];
+
+	/* check for degenerate faces */
+	if (face[0] == face[1] || face[0] == face[2] || face[1] == face[2]) {
+	    (*degenerate_count)++;
+	    continue;
+	}
+
+	if (pstate->gcv_options->debug_mode) {
+	    int n;
+
+	    bu_log("Making Face:\n");
+	    for (n=0; n<3; n++)
+		bu_log("\tvertex #%d: (%g %g %g)\n", face[n], V3ARGS(&verts[3*face[n]]));
+	}
+
+	face_count++;
+    }
+    bu_free(map, "weld map");
+
+    if (face_count)
+	mk_bot(pstate->fd_out, solid_name, RT_BOT_SOLID, RT_BOT_UNORIENTED, 0, nkept, face_count, verts, faces, NULL, NULL);
+
+    bu_free(faces, "bot faces");
+    pstate->facet_cnt = 0;
+
+    return (int)face_count;
 }
 
 static int
@@ -238,7 +320,7 @@ Convert_part_ascii(struct conversion_state *pstate, char line[MAX_LINE_SIZE])
 	} else if (!bu_strncmp(&line1[start], "outer loop", 10) || !bu_strncmp(&line1[start], "OUTER LOOP", 10)) {
 	    int endloop=0;
 	    int vert_no=0;
-	    int tmp_face[3] = {0, 0, 0};
+	    fastf_t facet[9];
 
 	    while (!endloop) {
 		if (bu_fgets(line1, MAX_LINE_SIZE, pstate->fd_in) == NULL)
@@ -259,49 +341,35 @@ Convert_part_ascii(struct conversion_state *pstate, char line[MAX_LINE_SIZE])
 
 			bu_log("Non-triangular loop:\n");
 			for (n=0; n<3; n++)
-			    bu_log("\t(%g %g %g)\n", V3ARGS(&pstate->tree->the_array[tmp_face[n]]));
+			    bu_log("\t(%g %g %g)\n", V3ARGS(&facet[3*n]));
 
 			bu_log("\t(%g %g %g)\n", x, y, z);
+			continue;
 		    }
 		    x *= pstate->gcv_options->scale_factor;
 		    y *= pstate->gcv_options->scale_factor;
 		    z *= pstate->gcv_options->scale_factor;
-		    tmp_face[vert_no++] = bg_vert_tree_add( pstate->tree,x, y, z, pstate->gcv_options->calculational_tolerance.dist_sq);
+		    VSET(&facet[3*vert_no], x, y, z);
+		    vert_no++;
 		} else {
 		    bu_log("Unrecognized line: %s\n", line1);
 		}
 	    }
 
-	    /* check for degenerate faces */
-	    if (tmp_face[0] == tmp_face[1]) {
+	    if (vert_no < 3) {
 		degenerate_count++;
 		continue;
 	    }
 
-	    if (tmp_face[0] == tmp_face[2]) {
-		degenerate_count++;
-		continue;
-	    }
-
-	    if (tmp_face[1] == tmp_face[2]) {
-		degenerate_count++;
-		continue;
-	    }
-
-	    if (pstate->gcv_options->debug_mode) {
-		int n;
+	    if (pstate->gcv_options->debug_mode)
+		VPRINT("Facet normal", normal);
 
-		bu_log("Making Face:\n");
-		for (n=0; n<3; n++)
-		    bu_log("\tvertex #%d: (%g %g %g)\n", tmp_face[n], V3ARGS(&pstate->tree->the_array[3*tmp_face[n]]));
-		VPRINT(" normal", normal);
-	    }
-
-	    Add_face(pstate, tmp_face);
-	    face_count++;
+	    Add_facet(pstate, facet);
 	}
     }
 
+    face_count = Make_bot(pstate, bu_vls_cstr(&solid_name), &degenerate_count);
+
     /* Check if this part has any solid parts */
     if (face_count == 0) {
 	bu_log("\t%s has no solid parts, ignoring\n", bu_vls_cstr(&region_name));
@@ -316,10 +384,6 @@ Convert_part_ascii(struct conversion_state *pstate, char line[MAX_LINE_SIZE])
 	    bu_log("\t%d faces were degenerate\n", degenerate_count);
     }
 
-    mk_bot(pstate->fd_out, bu_vls_cstr(&solid_name), RT_BOT_SOLID, RT_BOT_UNORIENTED, 0, pstate->tree->curr_vert, pstate->bot_fcurr,
-	   pstate->tree->the_array, pstate->bot_faces, NULL, NULL);
-    bg_vert_tree_clean(pstate->tree);
-
     if (db5_update_attribute(bu_vls_cstr(&solid_name), "importer", "gcv-stl", pstate->fd_out->dbip))
         bu_bomb("db5_update_attribute() failed");
 
@@ -359,19 +423,71 @@ static void stl_read_lswap(unsigned int *v)
 	| ((r & 0xff000000) >> 24);
 }
 
+struct stl_binary_job {
+    const unsigned char *data;	/* first facet record */
+    size_t nfacets;
+    fastf_t scale;
+    fastf_t *facets;
+    int sem;
+    size_t curr;
+};
+
+
+static void
+stl_binary_worker(int UNUSED(cpu), void *data)
+{
+    struct stl_binary_job *job = (struct stl_binary_job *)data;
+
+    while (1) {
+	size_t start, end, f;
+
+	bu_semaphore_acquire(job->sem);
+	start = job->curr;
+	job->curr += FACET_CHUNK;
+	bu_semaphore_release(job->sem);
+	if (start >= job->nfacets)
+	    return;
+
+	end = (start + FACET_CHUNK < job->nfacets) ? start + FACET_CHUNK : job->nfacets;
+	for (f = start; f < end; f++) {
+	    unsigned char buf[48];
+	    float flts[12];
+	    fastf_t *v = &job->facets[9*f];
+	    int i;
+
+	    /* 12 floats (normal and three vertices), then an unused
+	     * attribute byte count */
+	    memcpy(buf, &job->data[50*f], 48);
+
+	    /* swap bytes to convert from Little-endian to network order (big-endian) */
+	    for (i=0; i<12; i++) {
+		stl_read_lswap((unsigned int *)&buf[i*4]);
+	    }
+
+	    /* now use our network to native host format conversion tools */
+	    bu_cv_ntohf((unsigned char *)flts, buf, 12);
+
+	    VSCALE(&v[0], &flts[3], job->scale);
+	    VSCALE(&v[3], &flts[6], job->scale);
+	    VSCALE(&v[6], &flts[9], job->scale);
+	}
+    }
+}
+
+
 static void
 Convert_part_binary(struct conversion_state *pstate)
 {
-    unsigned char buf[51];
+    unsigned char buf[4];
     unsigned long num_facets=0;
-    float flts[12];
-    vect_t normal;
-    int tmp_face[3];
+    struct stl_binary_job job;
+    struct bu_mapped_file *mp;
     struct wmember head;
     struct bu_vls solid_name = BU_VLS_INIT_ZERO;
     struct bu_vls region_name = BU_VLS_INIT_ZERO;
     int face_count=0;
     int degenerate_count=0;
+    size_t avail = 0;
     size_t ret;
 
     bu_vls_strcat(&solid_name, "s.stl");
@@ -390,59 +506,43 @@ Convert_part_binary(struct conversion_state *pstate)
     num_facets = ntohl(*(uint32_t *)buf);
 
     bu_log("\t%ld facets\n", num_facets);
-    while (fread(buf, 48, 1, pstate->fd_in)) {
-	int i;
-	double pt[3];
-
-	/* swap bytes to convert from Little-endian to network order (big-endian) */
-	for (i=0; i<12; i++) {
-	    stl_read_lswap((unsigned int *)&buf[i*4]);
-	}
-
-	/* now use our network to native host format conversion tools */
-	bu_cv_ntohf((unsigned char *)flts, buf, 12);
-
-	/* unused attribute byte count */
-	ret = fread(buf, 2, 1, pstate->fd_in);
-	if (ret != 1)
-	    perror("fread");
-
-	VMOVE(normal, flts);
-	VSCALE(pt, &flts[3], pstate->gcv_options->scale_factor);
-	tmp_face[0] = bg_vert_tree_add(pstate->tree, V3ARGS(pt), pstate->gcv_options->calculational_tolerance.dist_sq);
-	VSCALE(pt, &flts[6], pstate->gcv_options->scale_factor);
-	tmp_face[1] = bg_vert_tree_add(pstate->tree, V3ARGS(pt), pstate->gcv_options->calculational_tolerance.dist_sq);
-	VSCALE(pt, &flts[9], pstate->gcv_options->scale_factor);
-	tmp_face[2] = bg_vert_tree_add(pstate->tree, V3ARGS(pt), pstate->gcv_options->calculational_tolerance.dist_sq);
-
-	/* check for degenerate faces */
-	if (tmp_face[0] == tmp_face[1]) {
-	    degenerate_count++;
-	    continue;
-	}
-
-	if (tmp_face[0] == tmp_face[2]) {
-	    degenerate_count++;
-	    continue;
-	}
-
-	if (tmp_face[1] == tmp_face[2]) {
-	    degenerate_count++;
-	    continue;
-	}
-
-	if (pstate->gcv_options->debug_mode) {
-	    int n;
 
-	    bu_log("Making Face:\n");
-	    for (n=0; n<3; n++)
-		bu_log("\tvertex #%d: (%g %g %g)\n", tmp_face[n], V3ARGS(&pstate->tree->the_array[3*tmp_face[n]]));
-	    VPRINT(" normal", normal);
+    /* decode the facet records in parallel straight from the mapped
+     * file, which follow the 80 byte header and the 4 byte count.  the
+     * record count comes from the file size rather than the header,
+     * which is not always reliable */
+    mp = bu_open_mapped_file(pstate->input_file, NULL);
+    if (!mp) {
+	bu_log("\tunable to map %s\n", pstate->input_file);
+	return;
+    }
+    if (mp->buflen > STL_BINARY_HEADER_SIZE)
+	avail = mp->buflen - STL_BINARY_HEADER_SIZE;
+
+    memset(&job, 0, sizeof(struct stl_binary_job));
+    job.data = (const unsigned char *)mp->buf + STL_BINARY_HEADER_SIZE;
+    job.nfacets = avail / 50 + ((avail % 50 >= 48) ? 1 : 0);
+    job.scale = pstate->gcv_options->scale_factor;
+    job.sem = bu_semaphore_register("GCV_STL_READ_SEM");
+    if (avail % 50 && avail % 50 < 48)
+	bu_log("\tignoring incomplete facet record at end of file\n");
+
+    if (job.nfacets) {
+	if (job.nfacets > pstate->facet_max) {
+	    if (pstate->facets)
+		bu_free(pstate->facets, "facets");
+	    pstate->facets = (fastf_t *)bu_malloc(9 * job.nfacets * sizeof(fastf_t), "facets");
+	    pstate->facet_max = job.nfacets;
 	}
-
-	Add_face(pstate, tmp_face);
-	face_count++;
+	job.facets = pstate->facets;
+	bu_parallel(stl_binary_worker, 0, &job);
+	pstate->facet_cnt = job.nfacets;
     }
+    /* the file won't be read again, don't keep it mapped */
+    bu_close_mapped_file(mp);
+    bu_free_mapped_files(0);
+
+    face_count = Make_bot(pstate, bu_vls_cstr(&solid_name), &degenerate_count);
 
     /* Check if this part has any solid parts */
     if (face_count == 0) {
@@ -455,10 +555,6 @@ Convert_part_binary(struct conversion_state *pstate)
 	    bu_log("\t%d faces were degenerate\n", degenerate_count);
     }
 
-    mk_bot(pstate->fd_out, bu_vls_cstr(&solid_name), RT_BOT_SOLID, RT_BOT_UNORIENTED, 0,
-	   pstate->tree->curr_vert, pstate->bot_fcurr, pstate->tree->the_array, pstate->bot_faces, NULL, NULL);
-    bg_vert_tree_clean(pstate->tree);
-
     if (db5_update_attribute(bu_vls_cstr(&solid_name), "importer", "gcv-stl", pstate->fd_out->dbip))
         bu_bomb("db5_update_attribute() failed");
 
@@ -585,11 +681,11 @@ stl_read(struct gcv_context *context, const struct gcv_opts *gcv_options, const
 
     BU_LIST_INIT(&state.all_head.l);
 
-    /* create a tree structure to hold the input vertices */
-    state.tree = bg_vert_tree_create();
-
     Convert_input(&state);
 
+    if (state.facets)
+	bu_free(state.facets, "facets");
+
     /* make a top level group */
     mk_lcomb(wdbp, "all", &state.all_head, 0, (char *)NULL, (char *)NULL, (unsigned char *)NULL, 0);
 
@@ -276,6 +276,7 @@ class GED_EXPORT BViewState {
 #define GED_DBISTATE_VIEW_CHANGE 0x02
 
 struct ged_draw_cache;
+struct dbi_dp_info;
 
 class GED_EXPORT DbiState {
     public:
@@ -412,8 +413,17 @@ class GED_EXPORT DbiState {
 		std::vector<unsigned long long> &path_hashes
 		);
 
-	void populate_maps(struct directory *dp, unsigned long long phash, int reset);
-	unsigned long long update_dp(struct directory *dp, int reset);
+	void populate_maps(struct dbi_dp_info *info);
+	unsigned long long apply_dp(struct dbi_dp_info *info);
+	void update_dps(std::vector<struct directory *> &dps, std::vector<unsigned long long> *hashes = NULL);
+
+	// Reverse of p_c - for each object hash, the combs that have it as a
+	// child (instances map to their object).  Lets updates find the combs
+	// affected by a change without visiting all of them.
+	std::unordered_map<unsigned long long, std::unordered_set<unsigned long long>> c_parents;
+	// Numbered instances that may have gone out of use during an update
+	std::unordered_set<unsigned long long> gc_instances;
+
 	unsigned int color_int(struct bu_color *);
 	int int_color(struct bu_color *c, unsigned int);
 	struct resource *res = NULL;
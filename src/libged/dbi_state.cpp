@@ -80,7 +80,7 @@ extern "C" {
 
 struct ged_draw_cache {
     MDB_env *env;
-    MDB_txn *txn;
+    MDB_txn *txn;	// Open batch (write) transaction, if any
     MDB_dbi dbi;
     struct bu_vls *fname;
 };
@@ -180,6 +180,21 @@ dbi_cache_open(const char *name)
       if (mdb_env_open(c->env, dir, MDB_NOSYNC, 0664))
 	  goto ged_context_close_fail;
 
+      // Open the dbi handle once up front - mdb_dbi_open may not be called
+      // from concurrent transactions, and we read from multiple threads.
+      {
+	  MDB_txn *txn;
+	  if (mdb_txn_begin(c->env, NULL, 0, &txn))
+	      goto ged_context_close_fail;
+	  if (mdb_dbi_open(txn, NULL, 0, &c->dbi)) {
+	      mdb_txn_abort(txn);
+	      goto ged_context_close_fail;
+	  }
+	  if (mdb_txn_commit(txn))
+	      goto ged_context_close_fail;
+	  c->txn = NULL;
+      }
+
       // Success - return the context
       return c;
 
@@ -205,6 +220,28 @@ dbi_cache_close(struct ged_draw_cache *c)
     BU_PUT(c, struct ged_draw_cache);
 }
 
+/* Writes normally commit one at a time.  Bulk updates should bracket their
+ * writes with cache_batch_begin/cache_batch_end so they are committed in one
+ * transaction.  While a batch is open the cache may only be used from the
+ * thread that opened it. */
+static void
+cache_batch_begin(struct ged_draw_cache *c)
+{
+    if (!c || c->txn)
+	return;
+    if (mdb_txn_begin(c->env, NULL, 0, &c->txn))
+	c->txn = NULL;
+}
+
+static void
+cache_batch_end(struct ged_draw_cache *c)
+{
+    if (!c || !c->txn)
+	return;
+    mdb_txn_commit(c->txn);
+    c->txn = NULL;
+}
+
 static void
 cache_write(struct ged_draw_cache *c, unsigned long long hash, const char *component, std::stringstream &s)
 {
@@ -224,26 +261,29 @@ cache_write(struct ged_draw_cache *c, unsigned long long hash, const char *compo
 
     // Write out key/value to LMDB database, where the key is the hash
     // and the value is the serialized LoD data
-    char *keycstr = bu_strdup(keystr.c_str());
-    void *bdata = bu_calloc(buffer.length()+1, sizeof(char), "bdata");
-    memcpy(bdata, buffer.data(), buffer.length()*sizeof(char));
-    mdb_txn_begin(c->env, NULL, 0, &c->txn);
-    mdb_dbi_open(c->txn, NULL, 0, &c->dbi);
+    MDB_txn *txn = c->txn;
+    if (!txn && mdb_txn_begin(c->env, NULL, 0, &txn))
+	return;
     mdb_key.mv_size = keystr.length()*sizeof(char);
-    mdb_key.mv_data = (void *)keycstr;
+    mdb_key.mv_data = (void *)keystr.c_str();
     mdb_data[0].mv_size = buffer.length()*sizeof(char);
-    mdb_data[0].mv_data = bdata;
+    mdb_data[0].mv_data = (void *)buffer.data();
     mdb_data[1].mv_size = 0;
     mdb_data[1].mv_data = NULL;
-    mdb_put(c->txn, c->dbi, &mdb_key, mdb_data, 0);
-    mdb_txn_commit(c->txn);
-    bu_free(keycstr, "keycstr");
-    bu_free(bdata, "buffer data");
+    mdb_put(txn, c->dbi, &mdb_key, mdb_data, 0);
+    if (txn != c->txn)
+	mdb_txn_commit(txn);
 }
 
+/* The returned data is valid until cache_done is called with the returned
+ * txn.  Outside of a batch this uses a read only transaction, so it is safe
+ * to call from multiple threads at once. */
 static size_t
-cache_get(struct ged_draw_cache *c, void **data, unsigned long long hash, const char *component)
+cache_get(struct ged_draw_cache *c, MDB_txn **txn, void **data, unsigned long long hash, const char *component)
 {
+    if (!txn)
+	return 0;
+    (*txn) = NULL;
     if (!c || !data || hash == 0 || !component)
 	return 0;
 
@@ -256,18 +296,19 @@ cache_get(struct ged_draw_cache *c, void **data, unsigned long long hash, const
     // the default size limit (511)
     //if (keystr.length()*sizeof(char) > mdb_env_get_maxkeysize(c->env))
     //  return 0;
-    char *keycstr = bu_strdup(keystr.c_str());
-    mdb_txn_begin(c->env, NULL, 0, &c->txn);
-    mdb_dbi_open(c->txn, NULL, 0, &c->dbi);
+    MDB_txn *ctxn = c->txn;
+    if (!ctxn) {
+	if (mdb_txn_begin(c->env, NULL, MDB_RDONLY, &ctxn))
+	    return 0;
+	(*txn) = ctxn;
+    }
     mdb_key.mv_size = keystr.length()*sizeof(char);
-    mdb_key.mv_data = (void *)keycstr;
-    int rc = mdb_get(c->txn, c->dbi, &mdb_key, &mdb_data[0]);
+    mdb_key.mv_data = (void *)keystr.c_str();
+    int rc = mdb_get(ctxn, c->dbi, &mdb_key, &mdb_data[0]);
     if (rc) {
-	bu_free(keycstr, "keycstr");
 	(*data) = NULL;
 	return 0;
     }
-    bu_free(keycstr, "keycstr");
     (*data) = mdb_data[0].mv_data;
 
     return mdb_data[0].mv_size;
@@ -283,20 +324,21 @@ cache_del(struct ged_draw_cache *c, unsigned long long hash, const char *compone
     MDB_val mdb_key;
     std::string keystr = std::to_string(hash) + std::string(":") + std::string(component);
 
-    mdb_txn_begin(c->env, NULL, 0, &c->txn);
-    mdb_dbi_open(c->txn, NULL, 0, &c->dbi);
+    MDB_txn *txn = c->txn;
+    if (!txn && mdb_txn_begin(c->env, NULL, 0, &txn))
+	return;
     mdb_key.mv_size = keystr.length()*sizeof(char);
     mdb_key.mv_data = (void *)keystr.c_str();
-    mdb_del(c->txn, c->dbi, &mdb_key, NULL);
-    mdb_txn_commit(c->txn);
+    mdb_del(txn, c->dbi, &mdb_key, NULL);
+    if (txn != c->txn)
+	mdb_txn_commit(txn);
 }
 
 static void
-cache_done(struct ged_draw_cache *c)
+cache_done(struct ged_draw_cache *UNUSED(c), MDB_txn *txn)
 {
-    if (!c)
-	return;
-    mdb_txn_commit(c->txn);
+    if (txn)
+	mdb_txn_abort(txn);
 }
 
 
@@ -306,69 +348,75 @@ bool alphanum_cmp(const std::string &a, const std::string &b)
     return alphanum_impl(a.c_str(), b.c_str(), NULL) < 0;
 }
 
+// Per-object information read from the database.  Gathering this only reads
+// from the database and the cache, so it can be done for many objects in
+// parallel - the results are then merged into the DbiState maps serially.
+struct dbi_leaf {
+    unsigned long long chash = 0;	// hash of the child object name
+    unsigned long long ihash = 0;	// instance hash, if not the first instance
+    std::string iname;			// instance label (the name for the first instance)
+    bool valid = true;
+    bool have_mat = false;
+    mat_t mat;
+    int op = OP_UNION;
+};
+
+struct dbi_dp_info {
+    struct directory *dp = NULL;
+    unsigned long long hash = 0;
+    std::vector<dbi_leaf> leaves;
+
+    int region_flag = 0;
+    int attr_region_id = -1;
+    int color_inherit = 0;
+    unsigned int cval = INT_MAX;
+
+    // Values that weren't in the cache and need to be written back
+    bool write_region_flag = false;
+    bool write_region_id = false;
+    bool write_color_inherit = false;
+    bool write_cval = false;
+};
+
 struct walk_data {
-    DbiState *dbis = NULL;
+    struct db_i *dbip = NULL;
+    struct dbi_dp_info *info = NULL;
     std::unordered_map<unsigned long long, unsigned long long> i_count;
-    mat_t *curr_mat = NULL;
-    unsigned long long phash = 0;
 };
 
 static void
 populate_leaf(void *client_data, const char *name, matp_t c_m, int op)
 {
     struct walk_data *d = (struct walk_data *)client_data;
-    struct db_i *dbip = d->dbis->dbip;
+    struct db_i *dbip = d->dbip;
     RT_CHECK_DBI(dbip);
 
     std::unordered_map<unsigned long long, unsigned long long> &i_count = d->i_count;
-    struct directory *dp = db_lookup(dbip, name, LOOKUP_QUIET);
-    unsigned long long chash = bu_data_hash(name, strlen(name)*sizeof(char));
-    i_count[chash] += 1;
-    if (i_count[chash] > 1) {
+    dbi_leaf l;
+    l.chash = bu_data_hash(name, strlen(name)*sizeof(char));
+    l.valid = (db_lookup(dbip, name, LOOKUP_QUIET) != RT_DIR_NULL);
+    l.op = op;
+    i_count[l.chash] += 1;
+    if (i_count[l.chash] > 1) {
 	// If we've got multiple instances of the same object in the tree,
 	// hash the string labeling the instance and map it to the correct
 	// parent comb so we can associate it with the tree contents
 	struct bu_vls iname = BU_VLS_INIT_ZERO;
-	bu_vls_sprintf(&iname, "%s@%llu", name, i_count[chash] - 1);
-	unsigned long long ihash = bu_data_hash(bu_vls_cstr(&iname), bu_vls_strlen(&iname)*sizeof(char));
-	d->dbis->i_map[ihash] = chash;
-	d->dbis->i_str[ihash] = std::string(bu_vls_cstr(&iname));
-	d->dbis->p_c[d->phash].insert(ihash);
-	d->dbis->p_v[d->phash].push_back(ihash);
-	if (dp == RT_DIR_NULL) {
-	    // Invalid comb reference - goes into map
-	    d->dbis->invalid_entry_map[ihash] = std::string(bu_vls_cstr(&iname));
-	} else {
-	    // In case this was previously invalid, remove
-	    d->dbis->invalid_entry_map.erase(ihash);
-	}
+	bu_vls_sprintf(&iname, "%s@%llu", name, i_count[l.chash] - 1);
+	l.ihash = bu_data_hash(bu_vls_cstr(&iname), bu_vls_strlen(&iname)*sizeof(char));
+	l.iname = std::string(bu_vls_cstr(&iname));
 	bu_vls_free(&iname);
-
-	// For the next stages, if we have an ihash use it
-	chash = ihash;
-
     } else {
-
-	d->dbis->p_v[d->phash].push_back(chash);
-	d->dbis->p_c[d->phash].insert(chash);
-	if (dp == RT_DIR_NULL) {
-	    // Invalid comb reference - goes into map
-	    d->dbis->invalid_entry_map[chash] = std::string(name);
-	} else {
-	    // In case this was previously invalid, remove
-	    d->dbis->invalid_entry_map.erase(chash);
-	}
-
+	l.iname = std::string(name);
     }
 
     // If we have a non-IDN matrix, store it
     if (c_m) {
-	for (int i = 0; i < 16; i++)
-	    d->dbis->matrices[d->phash][chash].push_back(c_m[i]);
+	l.have_mat = true;
+	MAT_COPY(l.mat, c_m);
     }
 
-    // If we have a non-UNION op, store it
-    d->dbis->i_bool[d->phash][chash] = op;
+    d->info->leaves.push_back(l);
 }
 
 static void
@@ -417,6 +465,170 @@ populate_walk_tree(union tree *tp, void *d, int subtract_skip, int p_op,
 }
 
 
+static void
+gather_dp(struct dbi_dp_info *info, struct db_i *dbip, struct ged_draw_cache *dcache, struct resource *res)
+{
+    struct directory *dp = info->dp;
+    info->hash = bu_data_hash(dp->d_namep, strlen(dp->d_namep)*sizeof(char));
+
+    // Hierarchy info if this is a comb
+    if (dp->d_flags & RT_DIR_COMB) {
+	struct rt_db_internal in;
+	if (rt_db_get_internal(&in, dp, dbip, NULL, res) >= 0) {
+	    struct rt_comb_internal *comb = (struct rt_comb_internal *)in.idb_ptr;
+	    if (comb->tree) {
+		struct walk_data d;
+		d.dbip = dbip;
+		d.info = info;
+		populate_walk_tree(comb->tree, (void *)&d, 0, OP_UNION, populate_leaf);
+	    }
+	    rt_db_free_internal(&in);
+	}
+    }
+
+    // Check for various drawing related attributes
+    // Ideally, if we have enough info, we'd like to avoid loading
+    // the avs.  See if we can get away with it using dcache
+    struct bu_attribute_value_set c_avs = BU_AVS_INIT_ZERO;
+    bool loaded_avs = false;
+    unsigned long long hash = info->hash;
+
+    // First, check the dcache for all remaining needed values
+    const char *b = NULL;
+    size_t bsize = 0;
+    MDB_txn *txn = NULL;
+
+    bsize = cache_get(dcache, &txn, (void **)&b, hash, CACHE_REGION_ID);
+    if (bsize == sizeof(info->attr_region_id)) {
+	memcpy(&info->attr_region_id, b, sizeof(info->attr_region_id));
+    } else {
+	info->write_region_id = true;
+    }
+    cache_done(dcache, txn);
+
+    bsize = cache_get(dcache, &txn, (void **)&b, hash, CACHE_REGION_FLAG);
+    if (bsize == sizeof(info->region_flag)) {
+	memcpy(&info->region_flag, b, sizeof(info->region_flag));
+    } else {
+	info->write_region_flag = true;
+    }
+    cache_done(dcache, txn);
+
+    bsize = cache_get(dcache, &txn, (void **)&b, hash, CACHE_INHERIT_FLAG);
+    if (bsize == sizeof(info->color_inherit)) {
+	memcpy(&info->color_inherit, b, sizeof(info->color_inherit));
+    } else {
+	info->write_color_inherit = true;
+    }
+    cache_done(dcache, txn);
+
+    bsize = cache_get(dcache, &txn, (void **)&b, hash, CACHE_COLOR);
+    if (bsize == sizeof(info->cval)) {
+	memcpy(&info->cval, b, sizeof(info->cval));
+    } else {
+	info->write_cval = true;
+    }
+    cache_done(dcache, txn);
+
+
+    if (info->write_region_flag) {
+	if (!loaded_avs) {
+	    db5_get_attributes(dbip, &c_avs, dp);
+	    loaded_avs = true;
+	}
+	// Check for region flag.
+	const char *region_flag_str = bu_avs_get(&c_avs, "region");
+	if (region_flag_str && (BU_STR_EQUAL(region_flag_str, "R") || BU_STR_EQUAL(region_flag_str, "1"))) {
+	    info->region_flag = 1;
+	}
+    }
+
+    if (info->write_region_id) {
+	if (!loaded_avs) {
+	    db5_get_attributes(dbip, &c_avs, dp);
+	    loaded_avs = true;
+	}
+	// Check for region id.  For drawing purposes this needs to be a number.
+	const char *region_id_val = bu_avs_get(&c_avs, "region_id");
+	if (region_id_val)
+	    bu_opt_int(NULL, 1, &region_id_val, (void *)&info->attr_region_id);
+    }
+
+    if (info->write_color_inherit) {
+	if (!loaded_avs) {
+	    db5_get_attributes(dbip, &c_avs, dp);
+	    loaded_avs = true;
+	}
+	info->color_inherit = (BU_STR_EQUAL(bu_avs_get(&c_avs, "inherit"), "1")) ? 1 : 0;
+    }
+
+    if (info->write_cval) {
+	if (!loaded_avs) {
+	    db5_get_attributes(dbip, &c_avs, dp);
+	    loaded_avs = true;
+	}
+	// Color (note that the rt_material_head colors and a region_id may
+	// override this, as might a parent comb with color and the inherit
+	// flag both set.
+	struct bu_color c = BU_COLOR_INIT_ZERO;
+	const char *color_val = bu_avs_get(&c_avs, "color");
+	if (!color_val)
+	    color_val = bu_avs_get(&c_avs, "rgb");
+	if (color_val){
+	    int r, g, bl;
+	    bu_opt_color(NULL, 1, &color_val, (void *)&c);
+	    bu_color_to_rgb_ints(&c, &r, &g, &bl);
+	    info->cval = r + (g << 8) + (bl << 16);
+	    bu_log("have color: %u\n", info->cval);
+	}
+    }
+
+    // Done with attributes
+    if (loaded_avs) {
+	bu_log("Had to load avs\n");
+	bu_avs_free(&c_avs);
+    }
+}
+
+
+// Objects to update before it's worth firing up threads
+#define DBI_PARALLEL_MIN 256
+
+struct dbi_gather_data {
+    std::vector<dbi_dp_info> *infos;
+    struct db_i *dbip;
+    struct ged_draw_cache *dcache;
+    struct resource *res;	// one per cpu
+    int sem;
+    size_t curr;
+};
+
+// Objects handed to a thread at a time
+#define DBI_GATHER_CHUNK 64
+
+static void
+gather_worker(int cpu, void *data)
+{
+    struct dbi_gather_data *gd = (struct dbi_gather_data *)data;
+    std::vector<dbi_dp_info> &infos = *gd->infos;
+
+    while (1) {
+	size_t start, end;
+
+	bu_semaphore_acquire(gd->sem);
+	start = gd->curr;
+	gd->curr += DBI_GATHER_CHUNK;
+	bu_semaphore_release(gd->sem);
+	if (start >= infos.size())
+	    return;
+
+	end = (start + DBI_GATHER_CHUNK < infos.size()) ? start + DBI_GATHER_CHUNK : infos.size();
+	for (size_t i = start; i < end; i++)
+	    gather_dp(&infos[i], gd->dbip, gd->dcache, &gd->res[cpu]);
+    }
+}
+
+
 DbiState::DbiState(struct ged *ged_p)
 {
     bu_vls_init(&path_string);
@@ -436,12 +648,14 @@ DbiState::DbiState(struct ged *ged_p)
     // Set up cache
     dcache = dbi_cache_open(dbip->dbi_filename);
 
+    std::vector<struct directory *> dps;
     for (int i = 0; i < RT_DBNHASH; i++) {
 	struct directory *dp;
 	for (dp = dbip->dbi_Head[i]; dp != RT_DIR_NULL; dp = dp->d_forw) {
-	    update_dp(dp, 0);
+	    dps.push_back(dp);
 	}
     }
+    update_dps(dps);
 }
 
 
@@ -463,34 +677,64 @@ DbiState::~DbiState()
 
 
 void
-DbiState::populate_maps(struct directory *dp, unsigned long long phash, int reset)
+DbiState::populate_maps(struct dbi_dp_info *info)
 {
-    if (!(dp->d_flags & RT_DIR_COMB))
-	return;
-    std::unordered_map<unsigned long long, std::unordered_set<unsigned long long>>::iterator pc_it;
+    unsigned long long phash = info->hash;
+
+    // Clear out the old contents, noting any numbered instances that may no
+    // longer be used once we're done.
     std::unordered_map<unsigned long long, std::vector<unsigned long long>>::iterator pv_it;
-    pc_it = p_c.find(phash);
+    std::unordered_map<unsigned long long, std::unordered_set<unsigned long long>>::iterator pc_it;
     pv_it = p_v.find(phash);
-    if (pc_it == p_c.end() || pv_it != p_v.end() || reset) {
-	if (reset && pc_it != p_c.end()) {
-	    pc_it->second.clear();
+    if (pv_it != p_v.end()) {
+	for (size_t i = 0; i < pv_it->second.size(); i++) {
+	    unsigned long long chash = pv_it->second[i];
+	    std::unordered_map<unsigned long long, unsigned long long>::iterator im_it = i_map.find(chash);
+	    if (im_it != i_map.end()) {
+		gc_instances.insert(chash);
+		chash = im_it->second;
+	    }
+	    std::unordered_map<unsigned long long, std::unordered_set<unsigned long long>>::iterator cp_it = c_parents.find(chash);
+	    if (cp_it != c_parents.end())
+		cp_it->second.erase(phash);
 	}
-	if (reset && pv_it != p_v.end()) {
-	    pv_it->second.clear();
+	pv_it->second.clear();
+    }
+    pc_it = p_c.find(phash);
+    if (pc_it != p_c.end())
+	pc_it->second.clear();
+    matrices.erase(phash);
+    i_bool.erase(phash);
+
+    if (!info->leaves.size())
+	return;
+
+    std::vector<unsigned long long> &pv = p_v[phash];
+    std::unordered_set<unsigned long long> &pc = p_c[phash];
+    for (size_t i = 0; i < info->leaves.size(); i++) {
+	dbi_leaf &l = info->leaves[i];
+	unsigned long long chash = l.chash;
+	if (l.ihash) {
+	    i_map[l.ihash] = l.chash;
+	    i_str[l.ihash] = l.iname;
+	    chash = l.ihash;
+	}
+	pv.push_back(chash);
+	pc.insert(chash);
+	c_parents[l.chash].insert(phash);
+
+	if (!l.valid) {
+	    // Invalid comb reference - goes into map
+	    invalid_entry_map[chash] = l.iname;
+	} else {
+	    // In case this was previously invalid, remove
+	    invalid_entry_map.erase(chash);
 	}
-	struct rt_db_internal in;
-	if (rt_db_get_internal(&in, dp, dbip, NULL, res) < 0)
-	    return;
-	struct rt_comb_internal *comb = (struct rt_comb_internal *)in.idb_ptr;
-	if (!comb->tree)
-	    return;
 
-	std::unordered_map<unsigned long long, unsigned long long> i_count;
-	struct walk_data d;
-	d.dbis = this;
-	d.phash = phash;
-	populate_walk_tree(comb->tree, (void *)&d, 0, OP_UNION, populate_leaf);
-	rt_db_free_internal(&in);
+	if (l.have_mat)
+	    matrices[phash][chash].assign(l.mat, l.mat + 16);
+
+	i_bool[phash][chash] = l.op;
     }
 }
 
@@ -823,140 +1067,39 @@ DbiState::clear_cache(struct directory *dp)
 }
 
 unsigned long long
-DbiState::update_dp(struct directory *dp, int reset)
+DbiState::apply_dp(struct dbi_dp_info *info)
 {
-    if (dp->d_flags & DB_LS_HIDDEN)
-	return 0;
-
     // Set up to go from hash back to name
-    unsigned long long hash = bu_data_hash(dp->d_namep, strlen(dp->d_namep)*sizeof(char));
-    d_map[hash] = dp;
+    unsigned long long hash = info->hash;
+    d_map[hash] = info->dp;
 
     // Clear any (possibly) state bbox.  bbox calculation
     // can be expensive, so defer it until it's needed
     bboxes.erase(hash);
 
     // Encode hierarchy info if this is a comb
-    if (dp->d_flags & RT_DIR_COMB)
-	populate_maps(dp, hash, reset);
-
-    // Check for various drawing related attributes
-    // Ideally, if we have enough info, we'd like to avoid loading
-    // the avs.  See if we can get away with it using dcache
-    struct bu_attribute_value_set c_avs = BU_AVS_INIT_ZERO;
-    bool loaded_avs = false;
-    region_id.erase(hash);
-    c_inherit.erase(hash);
-    rgb.erase(hash);
-
-    // First, check the dcache for all remaining needed values
-    const char *b = NULL;
-    size_t bsize = 0;
-
-    bool need_region_id_avs = true;
-    bool need_region_flag_avs = true;
-    bool need_color_inherit_avs = true;
-    bool need_cval_avs = true;
-
-    int region_flag = 0;
-    int attr_region_id = -1;
-    int color_inherit = 0;
-    unsigned int cval = INT_MAX;
-
-    bsize = cache_get(dcache, (void **)&b, hash, CACHE_REGION_ID);
-    if (bsize == sizeof(attr_region_id)) {
-	memcpy(&attr_region_id, b, sizeof(attr_region_id));
-	need_region_id_avs = false;
-    }
-    cache_done(dcache);
-
-    bsize = cache_get(dcache, (void **)&b, hash, CACHE_REGION_FLAG);
-    if (bsize == sizeof(region_flag)) {
-	memcpy(&region_flag, b, sizeof(region_flag));
-	need_region_flag_avs = false;
-    }
-    cache_done(dcache);
-
-    bsize = cache_get(dcache, (void **)&b, hash, CACHE_INHERIT_FLAG);
-    if (bsize == sizeof(color_inherit)) {
-	memcpy(&color_inherit, b, sizeof(color_inherit));
-	need_color_inherit_avs = false;
-    }
-    cache_done(dcache);
-
-    bsize = cache_get(dcache, (void **)&b, hash, CACHE_COLOR);
-    if (bsize == sizeof(cval)) {
-	memcpy(&cval, b, sizeof(cval));
-	need_cval_avs = false;
-    }
-    cache_done(dcache);
-
-
-    if (need_region_flag_avs) {
-	if (!loaded_avs) {
-	    db5_get_attributes(dbip, &c_avs, dp);
-	    loaded_avs = true;
-	}
-	// Check for region flag.
-	const char *region_flag_str = bu_avs_get(&c_avs, "region");
-	if (region_flag_str && (BU_STR_EQUAL(region_flag_str, "R") || BU_STR_EQUAL(region_flag_str, "1"))) {
-	    region_flag = 1;
-	}
+    if (info->dp->d_flags & RT_DIR_COMB)
+	populate_maps(info);
 
+    // Stash anything we had to read from the attributes
+    if (info->write_region_flag) {
 	std::stringstream s;
-	s.write(reinterpret_cast<const char *>(&region_flag), sizeof(region_flag));
+	s.write(reinterpret_cast<const char *>(&info->region_flag), sizeof(info->region_flag));
 	cache_write(dcache, hash, CACHE_REGION_FLAG, s);
     }
-
-
-    if (need_region_id_avs) {
-	if (!loaded_avs) {
-	    db5_get_attributes(dbip, &c_avs, dp);
-	    loaded_avs = true;
-	}
-	// Check for region id.  For drawing purposes this needs to be a number.
-	const char *region_id_val = bu_avs_get(&c_avs, "region_id");
-	if (region_id_val)
-	    bu_opt_int(NULL, 1, &region_id_val, (void *)&attr_region_id);
-
+    if (info->write_region_id) {
 	std::stringstream s;
-	s.write(reinterpret_cast<const char *>(&attr_region_id), sizeof(attr_region_id));
+	s.write(reinterpret_cast<const char *>(&info->attr_region_id), sizeof(info->attr_region_id));
 	cache_write(dcache, hash, CACHE_REGION_ID, s);
     }
-
-    if (need_color_inherit_avs) {
-	if (!loaded_avs) {
-	    db5_get_attributes(dbip, &c_avs, dp);
-	    loaded_avs = true;
-	}
-	color_inherit = (BU_STR_EQUAL(bu_avs_get(&c_avs, "inherit"), "1")) ? 1 : 0;
-
+    if (info->write_color_inherit) {
 	std::stringstream s;
-	s.write(reinterpret_cast<const char *>(&color_inherit), sizeof(color_inherit));
+	s.write(reinterpret_cast<const char *>(&info->color_inherit), sizeof(info->color_inherit));
 	cache_write(dcache, hash, CACHE_INHERIT_FLAG, s);
     }
-
-    if (need_cval_avs) {
-	if (!loaded_avs) {
-	    db5_get_attributes(dbip, &c_avs, dp);
-	    loaded_avs = true;
-	}
-	// Color (note that the rt_material_head colors and a region_id may
-	// override this, as might a parent comb with color and the inherit
-	// flag both set.
-	rgb.erase(hash);
-	struct bu_color c = BU_COLOR_INIT_ZERO;
-	const char *color_val = bu_avs_get(&c_avs, "color");
-	if (!color_val)
-	    color_val = bu_avs_get(&c_avs, "rgb");
-	if (color_val){
-	    bu_opt_color(NULL, 1, &color_val, (void *)&c);
-	    cval = color_int(&c);
-	    bu_log("have color: %u\n", cval);
-	}
-
+    if (info->write_cval) {
 	std::stringstream s;
-	s.write(reinterpret_cast<const char *>(&cval), sizeof(cval));
+	s.write(reinterpret_cast<const char *>(&info->cval), sizeof(info->cval));
 	cache_write(dcache, hash, CACHE_COLOR, s);
     }
 
@@ -965,25 +1108,67 @@ DbiState::update_dp(struct directory *dp, int reset)
     // will always be true, but right now region table based coloring works
     // that way in existing BRL-CAD code (see the example m35.g model's
     // all.g/component/power.train/r75 for an instance of this)
-    if (region_flag && attr_region_id == -1)
+    int attr_region_id = info->attr_region_id;
+    if (info->region_flag && attr_region_id == -1)
 	attr_region_id = 0;
 
-
+    region_id.erase(hash);
+    c_inherit.erase(hash);
+    rgb.erase(hash);
     if (attr_region_id != -1)
 	region_id[hash] = attr_region_id;
-    if (color_inherit)
-	c_inherit[hash] = color_inherit;
-    if (cval != INT_MAX)
-	rgb[hash] = cval;
+    if (info->color_inherit)
+	c_inherit[hash] = info->color_inherit;
+    if (info->cval != INT_MAX)
+	rgb[hash] = info->cval;
 
-    // Done with attributes
-    if (loaded_avs) {
-	bu_log("Had to load avs\n");
-	bu_avs_free(&c_avs);
-    }
     return hash;
 }
 
+void
+DbiState::update_dps(std::vector<struct directory *> &dps, std::vector<unsigned long long> *hashes)
+{
+    std::vector<dbi_dp_info> infos;
+    for (size_t i = 0; i < dps.size(); i++) {
+	if (dps[i]->d_flags & DB_LS_HIDDEN)
+	    continue;
+	dbi_dp_info info;
+	info.dp = dps[i];
+	infos.push_back(info);
+    }
+
+    // Reading combs and attributes is the expensive part - with enough
+    // objects to make it worthwhile, do that in parallel.
+    if (infos.size() < DBI_PARALLEL_MIN) {
+	for (size_t i = 0; i < infos.size(); i++)
+	    gather_dp(&infos[i], dbip, dcache, res);
+    } else {
+	int ncpus = bu_avail_cpus();
+	struct dbi_gather_data gd;
+	gd.infos = &infos;
+	gd.dbip = dbip;
+	gd.dcache = dcache;
+	gd.res = (struct resource *)bu_calloc(ncpus, sizeof(struct resource), "gather resources");
+	for (int i = 0; i < ncpus; i++)
+	    rt_init_resource(&gd.res[i], i, NULL);
+	gd.sem = bu_semaphore_register("GED_DBI_GATHER_SEM");
+	gd.curr = 0;
+	bu_parallel(gather_worker, ncpus, &gd);
+	for (int i = 0; i < ncpus; i++)
+	    rt_clean_resource_basic(NULL, &gd.res[i]);
+	bu_free(gd.res, "gather resources");
+    }
+
+    // Merge the results, committing any new cache data in one transaction
+    cache_batch_begin(dcache);
+    for (size_t i = 0; i < infos.size(); i++) {
+	unsigned long long hash = apply_dp(&infos[i]);
+	if (hashes)
+	    hashes->push_back(hash);
+    }
+    cache_batch_end(dcache);
+}
+
 bool
 DbiState::path_color(struct bu_color *c, std::vector<unsigned long long> &elements)
 {
@@ -1255,7 +1440,8 @@ DbiState::get_bbox(point_t *bbmin, point_t *bbmax, matp_t curr_mat, unsigned lon
 
     // First, check the dcache
     const char *b = NULL;
-    size_t bsize = cache_get(dcache, (void **)&b, hash, CACHE_OBJ_BOUNDS);
+    MDB_txn *txn = NULL;
+    size_t bsize = cache_get(dcache, &txn, (void **)&b, hash, CACHE_OBJ_BOUNDS);
     if (bsize) {
 	if (bsize != (sizeof(bmin) + sizeof(bmax))) {
 	    bu_log("Incorrect data size found loading cached bounds data\n");
@@ -1267,7 +1453,7 @@ DbiState::get_bbox(point_t *bbmin, point_t *bbmax, matp_t curr_mat, unsigned lon
 	    have_bbox = true;
 	}
     }
-    cache_done(dcache);
+    cache_done(dcache, txn);
 
 
     // This calculation can be expensive.  If we've already
@@ -1554,22 +1740,51 @@ DbiState::update()
     }
 
     // Update the primary data structures
+    gc_instances.clear();
     for(s_it = removed.begin(); s_it != removed.end(); s_it++) {
 	bu_log("removed: %llu\n", *s_it);
 
 	// Combs with this key in their child set need to be updated to refer
-	// to it as an invalid entry.
-	std::unordered_map<unsigned long long, std::vector<unsigned long long>>::iterator pv_it;
-	for (pv_it = p_v.begin(); pv_it != p_v.end(); pv_it++) {
-	    for (size_t i = 0; i < pv_it->second.size(); i++) {
-		if (i_map.find(pv_it->second[i]) != i_map.end()) {
-		    invalid_entry_map[i_map[pv_it->second[i]]] = i_str[i_map[pv_it->second[i]]];
-		} else {
-		    invalid_entry_map[pv_it->second[i]] = old_names[*s_it];
+	// to it as an invalid entry.  c_parents tells us which combs those
+	// are, so we don't have to look at all of them.
+	std::unordered_map<unsigned long long, std::unordered_set<unsigned long long>>::iterator cp_it;
+	cp_it = c_parents.find(*s_it);
+	if (cp_it != c_parents.end()) {
+	    std::unordered_set<unsigned long long>::iterator p_it;
+	    for (p_it = cp_it->second.begin(); p_it != cp_it->second.end(); p_it++) {
+		std::unordered_map<unsigned long long, std::vector<unsigned long long>>::iterator pv_it = p_v.find(*p_it);
+		if (pv_it == p_v.end())
+		    continue;
+		for (size_t i = 0; i < pv_it->second.size(); i++) {
+		    unsigned long long chash = pv_it->second[i];
+		    std::unordered_map<unsigned long long, unsigned long long>::iterator im_it = i_map.find(chash);
+		    if (im_it != i_map.end()) {
+			if (im_it->second == *s_it)
+			    invalid_entry_map[chash] = i_str[chash];
+		    } else if (chash == *s_it) {
+			invalid_entry_map[chash] = old_names[*s_it];
+		    }
 		}
 	    }
 	}
 
+	// If the removed object was a comb, it is no longer a parent of its
+	// children.
+	std::unordered_map<unsigned long long, std::vector<unsigned long long>>::iterator rv_it = p_v.find(*s_it);
+	if (rv_it != p_v.end()) {
+	    for (size_t i = 0; i < rv_it->second.size(); i++) {
+		unsigned long long chash = rv_it->second[i];
+		std::unordered_map<unsigned long long, unsigned long long>::iterator im_it = i_map.find(chash);
+		if (im_it != i_map.end()) {
+		    gc_instances.insert(chash);
+		    chash = im_it->second;
+		}
+		cp_it = c_parents.find(chash);
+		if (cp_it != c_parents.end())
+		    cp_it->second.erase(*s_it);
+	    }
+	}
+
 	d_map.erase(*s_it);
 	bboxes.erase(*s_it);
 	c_inherit.erase(*s_it);
@@ -1578,50 +1793,62 @@ DbiState::update()
 	matrices.erase(*s_it);
 	i_bool.erase(*s_it);
 
-	// We do not clear the instance maps (i_map and i_str) since those containers do not
-	// guarantee uniqueness to one child object.  To remove entries no longer
-	// used anywhere in the database, we have to confirm they are no longer needed on a global
-	// basis in a subsequent garbage-collect operation.
+	// We do not clear the instance maps (i_map and i_str) here since those
+	// containers do not guarantee uniqueness to one child object.  Entries
+	// no longer used anywhere are cleaned up below.
 
 	// Entries with this hash as their key are erased.
 	p_c.erase(*s_it);
 	p_v.erase(*s_it);
     }
 
+    std::vector<struct directory *> dps;
+    std::vector<unsigned long long> hashes;
     for(g_it = added.begin(); g_it != added.end(); g_it++) {
-	struct directory *dp = *g_it;
-	bu_log("added: %s\n", dp->d_namep);
-	unsigned long long hash = update_dp(dp, 0);
-
+	bu_log("added: %s\n", (*g_it)->d_namep);
+	dps.push_back(*g_it);
+    }
+    update_dps(dps, &hashes);
+    for (size_t i = 0; i < hashes.size(); i++) {
 	// If this name was previously the source of an invalid reference,
 	// it is no longer.
-	invalid_entry_map.erase(hash);
+	invalid_entry_map.erase(hashes[i]);
     }
 
+    // Properties need to be updated - comb children, colors, matrices,
+    // bounding box for solids, etc.
+    dps.clear();
     for(g_it = changed.begin(); g_it != changed.end(); g_it++) {
-	struct directory *dp = *g_it;
-	bu_log("changed: %s\n", dp->d_namep);
-	// Properties need to be updated - comb children, colors, matrices,
-	// bounding box for solids, etc.
-	update_dp(dp, 1);
+	bu_log("changed: %s\n", (*g_it)->d_namep);
+	dps.push_back(*g_it);
     }
+    update_dps(dps);
 
-    // Garbage collect i_map and i_str
-    std::unordered_map<unsigned long long, std::vector<unsigned long long>>::iterator sk_it;
-    std::unordered_set<unsigned long long> used;
-    for (sk_it = p_v.begin(); sk_it != p_v.end(); sk_it++) {
-	used.insert(sk_it->second.begin(), sk_it->second.end());
-    }
-    std::vector<unsigned long long> unused;
-    std::unordered_map<unsigned long long, unsigned long long>::iterator im_it;
-    for (im_it = i_map.begin(); im_it != i_map.end(); im_it++) {
-	if (used.find(im_it->first) != used.end())
-	    unused.push_back(im_it->first);
-    }
-    for (size_t i = 0; i < unused.size(); i++) {
-	i_map.erase(unused[i]);
-	i_str.erase(unused[i]);
+    // Garbage collect i_map and i_str.  Only instances that were in combs we
+    // just repopulated or removed can have gone out of use, and the parents
+    // of their objects are the only combs that could still be using them.
+    for (s_it = gc_instances.begin(); s_it != gc_instances.end(); s_it++) {
+	std::unordered_map<unsigned long long, unsigned long long>::iterator im_it = i_map.find(*s_it);
+	if (im_it == i_map.end())
+	    continue;
+	bool used = false;
+	std::unordered_map<unsigned long long, std::unordered_set<unsigned long long>>::iterator cp_it = c_parents.find(im_it->second);
+	if (cp_it != c_parents.end()) {
+	    std::unordered_set<unsigned long long>::iterator p_it;
+	    for (p_it = cp_it->second.begin(); p_it != cp_it->second.end(); p_it++) {
+		std::unordered_map<unsigned long long, std::unordered_set<unsigned long long>>::iterator pc_it = p_c.find(*p_it);
+		if (pc_it != p_c.end() && pc_it->second.find(*s_it) != pc_it->second.end()) {
+		    used = true;
+		    break;
+		}
+	    }
+	}
+	if (!used) {
+	    i_map.erase(*s_it);
+	    i_str.erase(*s_it);
+	}
     }
+    gc_instances.clear();
 
     // For all associated view states, execute any necessary changes to
     // view objects and lists
@@ -28,6 +28,7 @@
 #include "common.h"
 
 #include <algorithm>
+#include <iostream>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -298,6 +299,137 @@ pnt_sampling_methods:
     return BRLCAD_ERROR;
 }
 
+static int
+tess_objs(struct ged *gedp, tess_opts *s, int argc, const char **argv)
+{
+    // Translate specified object names to directory pointers
+    struct bu_ptbl dps = BU_PTBL_INIT_ZERO;
+    for (int i = 0; i < argc; i++) {
+	struct directory *dp = db_lookup(gedp->dbip, argv[i], LOOKUP_NOISY);
+	if (!dp) {
+	    bu_ptbl_free(&dps);
+	    return BRLCAD_ERROR;
+	}
+	bu_ptbl_ins(&dps, (long *)dp);
+    }
+
+    // Tessellate each object.  Note that we're doing this in series rather
+    // than parallel because of the risks of high memory consumption and/or
+    // CPU utilization for individual object operations.
+    for (size_t i = 0; i < BU_PTBL_LEN(&dps); i++) {
+
+	// If this isn't a proper BRL-CAD object, tessellation is a no-op
+	struct directory *dp = (struct directory *)BU_PTBL_GET(&dps, i);
+	if (dp->d_major_type != DB5_MAJORTYPE_BRLCAD)
+	    continue;
+
+	// Trigger the core tessellation routines
+	struct rt_bot_internal *obot = NULL;
+	struct bu_vls method_flag = BU_VLS_INIT_ZERO;
+	if (dp_tessellate(&obot, &method_flag, gedp, dp, s) != BRLCAD_OK) {
+	    bu_vls_free(&method_flag);
+	    bu_ptbl_free(&dps);
+	    return BRLCAD_ERROR;
+	}
+
+	// If we used a BRep CSG tree, we're already done
+	if (BU_STR_EQUAL(bu_vls_cstr(&method_flag), "NMG_BREP_CSG")) {
+	    bu_vls_free(&method_flag);
+	    continue;
+	}
+
+	// If we didn't get anything and we had an OK code, just keep going
+	if (!obot) {
+	    bu_vls_free(&method_flag);
+	    continue;
+	}
+
+	// If we've got something to write, handle it
+	struct bu_vls obot_name = BU_VLS_INIT_ZERO;
+	if (s->overwrite_obj) {
+	    bu_vls_sprintf(&obot_name, "%s", dp->d_namep);
+	} else {
+	    bu_vls_sprintf(&obot_name, "%s_tess.bot", dp->d_namep);
+	}
+	// NOTE: _tess_facetize_write_bot frees obot
+	int ret = _tess_facetize_write_bot(gedp->dbip, obot, bu_vls_cstr(&obot_name), bu_vls_cstr(&method_flag));
+	bu_vls_free(&method_flag);
+	bu_vls_free(&obot_name);
+	if (ret != BRLCAD_OK) {
+	    bu_ptbl_free(&dps);
+	    return BRLCAD_ERROR;
+	}
+
+    }
+
+    bu_ptbl_free(&dps);
+
+    return BRLCAD_OK;
+}
+
+// Run one job received by tess_serve
+static int
+tess_job(struct ged *gedp, std::vector<std::string> &args)
+{
+    tess_opts s;
+    int max_time = 0;
+    int max_pnts = 0;
+    struct bu_vls cache_dir = BU_VLS_INIT_ZERO;
+
+    struct bu_opt_desc d[7];
+    BU_OPT(d[0],  "O",    "overwrite",                         "",                  NULL,    &(s.overwrite_obj), "Replace original object with BoT");
+    BU_OPT(d[1],   "",      "methods",                "m1 m2 ...", &_tess_active_methods,        &s.method_opts, "List of active methods to use for this tessellation attempt");
+    BU_OPT(d[2],   "",  "method-opts",  "M opt1=val opt2=val ...",    &_tess_method_opts,        &s.method_opts, "Set options for method M.");
+    BU_OPT(d[3],   "",     "max-time",                        "#",           &bu_opt_int,             &max_time, "Maximum number of seconds to allow for runtime (not supported by all methods).");
+    BU_OPT(d[4],   "",     "max-pnts",                        "#",           &bu_opt_int,             &max_pnts, "Maximum number of pnts to use when applying ray sampling methods.");
+    BU_OPT(d[5],   "",    "cache-dir",                      "dir",           &bu_opt_vls,            &cache_dir, "Directory to use for cached outputs (set when the server starts).");
+    BU_OPT_NULL(d[6]);
+
+    std::vector<const char *> av;
+    for (size_t i = 0; i < args.size(); i++)
+	av.push_back(args[i].c_str());
+    av.push_back(NULL);
+
+    struct bu_vls omsg = BU_VLS_INIT_ZERO;
+    int ac = bu_opt_parse(&omsg, args.size(), av.data(), d);
+    if (ac < 0) {
+	bu_log("Option parsing error: %s\n", bu_vls_cstr(&omsg));
+	bu_vls_free(&omsg);
+	bu_vls_free(&cache_dir);
+	return BRLCAD_ERROR;
+    }
+    bu_vls_free(&omsg);
+    bu_vls_free(&cache_dir);
+
+    method_setup(&s);
+
+    return tess_objs(gedp, &s, ac, av.data());
+}
+
+// Serve jobs from stdin until it is closed.  The parent kills us if a job
+// runs too long, and starts a new server if we die.
+static int
+tess_serve(struct ged *gedp)
+{
+    std::string line;
+    while (std::getline(std::cin, line)) {
+	std::vector<std::string> args;
+	int argc = atoi(line.c_str());
+	for (int i = 0; i < argc && std::getline(std::cin, line); i++)
+	    args.push_back(line);
+	if ((int)args.size() != argc)
+	    break;
+
+	int ret = tess_job(gedp, args);
+
+	// bu_log output goes to stderr, so stdout only carries this
+	fprintf(stdout, "%s %d\n", TESS_JOB_DONE, ret);
+	fflush(stdout);
+    }
+
+    return BRLCAD_OK;
+}
+
 void
 print_methods_info()
 {
@@ -331,16 +463,18 @@ facetize_process(int argc, const char **argv)
     // Done with prog name
     argc--; argv++;
 
-    static const char *usage = "Usage: ged_exec facetize_process [options] file.g input_obj [input_object_2 ...]\n";
+    static const char *usage = "Usage: ged_exec facetize_process [options] file.g input_obj [input_object_2 ...]\n"
+	"       ged_exec facetize_process --server [--cache-dir dir] file.g\n";
     int print_help = 0;
     struct bu_vls cache_dir = BU_VLS_INIT_ZERO;
     tess_opts s;
 
     int list_methods = 0;
+    int server = 0;
     int max_time = 0;
     int max_pnts = 0;
 
-    struct bu_opt_desc d[ 9];
+    struct bu_opt_desc d[10];
     BU_OPT(d[ 0],  "h",         "help",                         "",                  NULL,           &print_help, "Print help and exit");
     BU_OPT(d[ 1],   "", "list-methods",                         "",                  NULL,         &list_methods, "List available tessellation methods.  When used with -h, print an informational summary of each method.");
     BU_OPT(d[ 2],  "O",    "overwrite",                         "",                  NULL,    &(s.overwrite_obj), "Replace original object with BoT");
@@ -349,7 +483,8 @@ facetize_process(int argc, const char **argv)
     BU_OPT(d[ 5],   "",     "max-time",                        "#",           &bu_opt_int,             &max_time, "Maximum number of seconds to allow for runtime (not supported by all methods).");
     BU_OPT(d[ 6],   "",     "max-pnts",                        "#",           &bu_opt_int,             &max_pnts, "Maximum number of pnts to use when applying ray sampling methods.");
     BU_OPT(d[ 7],   "",     "cache-dir",                     "dir",           &bu_opt_vls,            &cache_dir, "Directory to use for cached outputs (default is libbu cache directory).");
-    BU_OPT_NULL(d[ 8]);
+    BU_OPT(d[ 8],   "",       "server",                         "",                  NULL,               &server, "Keep the database open and read jobs from stdin.");
+    BU_OPT_NULL(d[ 9]);
 
     /* parse options */
     struct bu_vls omsg = BU_VLS_INIT_ZERO;
@@ -395,6 +530,12 @@ facetize_process(int argc, const char **argv)
 	bu_setenv("BU_DIR_CACHE", bu_vls_cstr(&cache_dir), 1);
     }
 
+    if (argc < 1) {
+	bu_log("%s", usage);
+	bu_vls_free(&cache_dir);
+	return BRLCAD_ERROR;
+    }
+
     // Do the setup for the various methods
     method_setup(&s);
 
@@ -405,68 +546,18 @@ facetize_process(int argc, const char **argv)
 	return BRLCAD_ERROR;
     }
 
-    // Translate specified object names to directory pointers
-    struct bu_ptbl dps = BU_PTBL_INIT_ZERO;
-    for (int i = 1; i < argc; i++) {
-	struct directory *dp = db_lookup(gedp->dbip, argv[i], LOOKUP_NOISY);
-	if (!dp) {
-	    bu_vls_free(&cache_dir);
-	    return BRLCAD_ERROR;
-	}
-	bu_ptbl_ins(&dps, (long *)dp);
+    if (server) {
+	int sret = tess_serve(gedp);
+	ged_close(gedp);
+	bu_vls_free(&cache_dir);
+	return sret;
     }
 
-    // Tessellate each object.  Note that we're doing this in series rather
-    // than parallel because of the risks of high memory consumption and/or
-    // CPU utilization for individual object operations.
-    for (size_t i = 0; i < BU_PTBL_LEN(&dps); i++) {
-
-	// If this isn't a proper BRL-CAD object, tessellation is a no-op
-	struct directory *dp = (struct directory *)BU_PTBL_GET(&dps, i);
-	if (dp->d_major_type != DB5_MAJORTYPE_BRLCAD)
-	    continue;
-
-	// Trigger the core tessellation routines
-	struct rt_bot_internal *obot = NULL;
-	struct bu_vls method_flag = BU_VLS_INIT_ZERO;
-	if (dp_tessellate(&obot, &method_flag, gedp, dp, &s) != BRLCAD_OK) {
-	    bu_vls_free(&method_flag);
-	    return BRLCAD_ERROR;
-	}
-
-	// If we used a BRep CSG tree, we're already done
-	if (BU_STR_EQUAL(bu_vls_cstr(&method_flag), "NMG_BREP_CSG")) {
-	    bu_vls_free(&method_flag);
-	    continue;
-	}
-
-	// If we didn't get anything and we had an OK code, just keep going
-	if (!obot) {
-	    bu_vls_free(&method_flag);
-	    continue;
-	}
-
-	// If we've got something to write, handle it
-	struct bu_vls obot_name = BU_VLS_INIT_ZERO;
-	if (s.overwrite_obj) {
-	    bu_vls_sprintf(&obot_name, "%s", dp->d_namep);
-	} else {
-	    bu_vls_sprintf(&obot_name, "%s_tess.bot", dp->d_namep);
-	}
-	// NOTE: _tess_facetize_write_bot frees obot
-	int ret = _tess_facetize_write_bot(gedp->dbip, obot, bu_vls_cstr(&obot_name), bu_vls_cstr(&method_flag));
-	bu_vls_free(&method_flag);
-	bu_vls_free(&obot_name);
-	if (ret != BRLCAD_OK) {
-	    bu_vls_free(&cache_dir);
-	    return BRLCAD_ERROR;
-	}
-
-    }
+    int ret = tess_objs(gedp, &s, argc - 1, argv + 1);
 
     bu_vls_free(&cache_dir);
 
-    return BRLCAD_OK;
+    return ret;
 }
 
 #include "../../include/plugin.h"
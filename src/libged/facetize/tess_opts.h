@@ -41,6 +41,12 @@
 #include "bg/spsr.h"
 #include "raytrace.h"
 
+// When facetize_process is run with --server, it keeps the database open and
+// reads jobs from stdin: a line with the argument count, then one argument per
+// line.  Once a job finishes, a line with this marker and the job's return
+// code is written to stdout.
+#define TESS_JOB_DONE "TESS_JOB_DONE"
+
 class method_options_t {
     public:
 
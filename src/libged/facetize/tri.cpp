@@ -32,8 +32,19 @@
 #include <iostream>
 #include <fstream>
 #include <queue>
+#include <chrono>
+#include <thread>
 
 #include <string.h>
+#include <signal.h>
+#ifdef HAVE_POLL_H
+#  include <poll.h>
+#endif
+#ifdef HAVE_SYS_SELECT_H
+#  include <sys/select.h>
+#endif
+
+#include "bio.h"
 
 #include "manifold/manifold.h"
 
@@ -441,67 +452,298 @@ tess_avail_methods()
     return methods;
 }
 
-int
-tess_run(struct _ged_facetize_state *s, const char **tess_cmd, int tess_cmd_cnt, fastf_t max_time, int ocnt)
+// A long-lived facetize_process --server subprocess.  Starting ged_exec and
+// opening the working .g file for every attempt dominates the run time when
+// there are many small objects, so one server is kept running and fed jobs.
+// If a job crashes the server or runs past its time limit, the server is gone
+// and a new one is started for the next job - each job is still isolated from
+// the parent just as a one-off subprocess would be.
+//
+// Only one server is used - jobs all write to the same working file, and the
+// method fallback and bisection logic need each result before deciding what
+// to run next.
+//
+// A server that dies may leave the working file half written.  Copying the
+// whole file before every job costs more than most jobs do, so a snapshot is
+// only taken once the work done since the last one outweighs the copy.  The
+// jobs that succeeded since the snapshot are remembered, and if the server
+// dies the snapshot is restored and those jobs are run again.
+class TessWorker {
+    public:
+	TessWorker(const char *exec, const char *gfile, const char *cache_dir);
+	~TessWorker();
+
+	int run(struct _ged_facetize_state *s, std::vector<const char *> &args, fastf_t max_time, int *rc);
+	void stop();
+
+	bool checkpoint(struct _ged_facetize_state *s, bool force);
+	void completed(std::vector<const char *> &args, std::vector<std::string> &names, fastf_t max_time, int64_t elapsed);
+	bool recover(struct _ged_facetize_state *s);
+
+	// Objects whose results were lost and could not be redone
+	std::vector<std::string> lost;
+
+    private:
+	bool start();
+	void relay(struct _ged_facetize_state *s, int msg_level);
+	bool job_done(int *rc);
+	bool send(std::vector<const char *> &args);
+
+	std::string exec;
+	std::string gfile;
+	std::string cache_dir;
+	struct subprocess_s p;
+	bool alive = false;
+	std::string obuf;
+
+	struct tess_job {
+	    std::vector<std::string> args;
+	    std::vector<std::string> names;
+	    fastf_t max_time;
+	};
+	std::string snapshot;
+	bool have_snapshot = false;
+	int64_t copy_time = 0;
+	int64_t work_time = 0;
+	std::vector<tess_job> done;
+};
+
+// Take a new snapshot once the jobs run since the last one took this many
+// times as long as copying the working file did
+#define TESS_SNAPSHOT_RATIO 4
+
+// Number of bytes that can be read from the pipe f without blocking.  On
+// POSIX systems only readiness is known, so 1 is returned when a read (of
+// data or of EOF) won't block.  subprocess_read_stdout/stderr wait for
+// data on Windows, so they must only be called when this is non-zero.
+static unsigned
+pipe_pending(FILE *f)
 {
-    if (!s || !tess_cmd || !tess_cmd[3])
-	return BRLCAD_ERROR;
+    if (!f)
+	return 0;
+#if defined(_WIN32)
+    HANDLE h = (HANDLE)_get_osfhandle(_fileno(f));
+    DWORD avail = 0;
+    if (!PeekNamedPipe(h, NULL, 0, NULL, &avail, NULL))
+	return 0;
+    return (unsigned)avail;
+#elif defined(HAVE_POLL_H)
+    struct pollfd pfd;
+    pfd.fd = fileno(f);
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, 0) <= 0)
+	return 0;
+    return (pfd.revents & (POLLIN|POLLHUP)) ? 1 : 0;
+#else
+    fd_set read_set;
+    struct timeval tv = {0, 0};
+    FD_ZERO(&read_set);
+    FD_SET(fileno(f), &read_set);
+    return (select(fileno(f) + 1, &read_set, NULL, NULL, &tv) > 0) ? 1 : 0;
+#endif
+}
 
-    std::string wfile(tess_cmd[3]);
-    std::string wfilebak = wfile + std::string(".bak");
-    {
-	// Before the run, prepare a backup file
-	std::ifstream workfile(wfile, std::ios::binary);
-	std::ofstream bakfile(wfilebak, std::ios::binary);
-	if (!workfile.is_open() || !bakfile.is_open()) {
-	    bu_log("Unable to create backup file %s\n", wfilebak.c_str());
-	    return BRLCAD_ERROR;
+// Read what is pending on one of the server's output pipes without
+// blocking, up to size bytes.
+static unsigned
+pipe_read(struct subprocess_s *p, FILE *f, char *buf, unsigned size, int err)
+{
+    unsigned avail = pipe_pending(f);
+    if (!avail)
+	return 0;
+#if defined(_WIN32)
+    if (avail < size)
+	size = avail;
+#endif
+    return (err) ? subprocess_read_stderr(p, buf, size) : subprocess_read_stdout(p, buf, size);
+}
+
+static bool
+tess_file_copy(const std::string &src, const std::string &dest)
+{
+    std::ifstream sfile(src, std::ios::binary);
+    std::ofstream dfile(dest, std::ios::binary);
+    if (!sfile.is_open() || !dfile.is_open())
+	return false;
+    dfile << sfile.rdbuf();
+    sfile.close();
+    dfile.close();
+    return !dfile.fail();
+}
+
+TessWorker::TessWorker(const char *e, const char *g, const char *c)
+    : exec(e), gfile(g), cache_dir(c)
+{
+    memset(&p, 0, sizeof(struct subprocess_s));
+    snapshot = gfile + std::string(".bak");
+}
+
+TessWorker::~TessWorker()
+{
+    stop();
+    if (have_snapshot)
+	bu_file_delete(snapshot.c_str());
+}
+
+bool
+TessWorker::start()
+{
+    const char *cmd[7] = {NULL};
+    cmd[0] = exec.c_str();
+    cmd[1] = "facetize_process";
+    cmd[2] = "--server";
+    cmd[3] = "--cache-dir";
+    cmd[4] = cache_dir.c_str();
+    cmd[5] = gfile.c_str();
+    cmd[6] = NULL;
+
+    obuf.clear();
+    if (subprocess_create(cmd, subprocess_option_no_window|subprocess_option_enable_async|subprocess_option_inherit_environment, &p))
+	return false;
+
+    alive = true;
+    return true;
+}
+
+void
+TessWorker::stop()
+{
+    if (!alive)
+	return;
+
+    // The server exits when its input is closed
+    subprocess_close_stdin(&p);
+    subprocess_join(&p, NULL);
+    subprocess_destroy(&p);
+    alive = false;
+}
+
+// Pass along whatever the server has written since the last check.  stdout
+// is scanned for the job completion marker, so only complete lines are
+// logged from it.
+void
+TessWorker::relay(struct _ged_facetize_state *s, int msg_level)
+{
+    char curr_out[MAXPATHLEN*10];
+    unsigned ocnt = 0;
+    while ((ocnt = pipe_read(&p, p.stdout_file, curr_out, sizeof(curr_out) - 1, 0)) > 0)
+	obuf.append(curr_out, ocnt);
+
+    size_t lend;
+    while ((lend = obuf.find('\n')) != std::string::npos) {
+	std::string line = obuf.substr(0, lend + 1);
+	if (line.compare(0, strlen(TESS_JOB_DONE), TESS_JOB_DONE) != 0) {
+	    facetize_log(s, msg_level, "%s", line.c_str());
+	    obuf.erase(0, lend + 1);
+	    continue;
 	}
-	bakfile << workfile.rdbuf();
-	workfile.close();
-	bakfile.close();
+	break;
     }
 
-    // Record the actual command being use to trigger the subprocess
-    struct bu_vls cmd = BU_VLS_INIT_ZERO;
-    for (int i = 0; i < tess_cmd_cnt ; i++)
-	bu_vls_printf(&cmd, "%s ", tess_cmd[i]);
-    facetize_log(s, 2, "%s\n", bu_vls_cstr(&cmd));
-    bu_vls_free(&cmd);
+    char curr_err[MAXPATHLEN*10];
+    unsigned ecnt = 0;
+    while ((ecnt = pipe_read(&p, p.stderr_file, curr_err, sizeof(curr_err) - 1, 1)) > 0) {
+	curr_err[ecnt] = '\0';
+	facetize_log(s, msg_level, "%s", curr_err);
+    }
+}
 
-    // If we're not being verbose, just report how many objects we're working on
-    if (ocnt == 1)
-	facetize_log(s, 0, "Attempting to triangulate %s...", tess_cmd[tess_cmd_cnt-ocnt]);
-    if (ocnt > 1)
-	facetize_log(s, 0, "Attempting to triangulate %d solids...", ocnt);
+// Write a job to the server's stdin.  If the server has died the write
+// fails with EPIPE, which must not take down the parent with SIGPIPE, so
+// the signal is ignored for the duration of the write.  Returns false if
+// the job could not be written.
+bool
+TessWorker::send(std::vector<const char *> &args)
+{
+    if (!subprocess_alive(&p))
+	return false;
 
-    int64_t start = bu_gettime();
-    int64_t elapsed = 0;
-    fastf_t seconds = 0.0;
-    tess_cmd[tess_cmd_cnt] = NULL; // Make sure we're NULL terminated
-    struct subprocess_s p;
-    if (subprocess_create(tess_cmd, subprocess_option_no_window|subprocess_option_enable_async|subprocess_option_inherit_environment, &p)) {
-	// Unable to create subprocess??
+    FILE *pin = subprocess_stdin(&p);
+    if (!pin)
+	return false;
+
+#ifdef SIGPIPE
+    void (*opipe)(int) = signal(SIGPIPE, SIG_IGN);
+#endif
+
+    bool ok = (fprintf(pin, "%zu\n", args.size()) >= 0);
+    for (size_t i = 0; ok && i < args.size(); i++)
+	ok = (fprintf(pin, "%s\n", args[i]) >= 0);
+    if (fflush(pin) != 0)
+	ok = false;
+
+#ifdef SIGPIPE
+    if (opipe != SIG_ERR)
+	(void)signal(SIGPIPE, opipe);
+#endif
+
+    if (!ok)
+	clearerr(pin);
+
+    return ok;
+}
+
+bool
+TessWorker::job_done(int *rc)
+{
+    size_t lend = obuf.find('\n');
+    if (lend == std::string::npos || obuf.compare(0, strlen(TESS_JOB_DONE), TESS_JOB_DONE) != 0)
+	return false;
+
+    (*rc) = atoi(obuf.c_str() + strlen(TESS_JOB_DONE));
+    obuf.erase(0, lend + 1);
+    return true;
+}
+
+// Returns BRLCAD_OK if the job ran to completion (its own return code is in
+// rc), or BRLCAD_ERROR if the server could not be started, died, or was
+// killed after max_time seconds.
+int
+TessWorker::run(struct _ged_facetize_state *s, std::vector<const char *> &args, fastf_t max_time, int *rc)
+{
+    if (alive && !subprocess_alive(&p)) {
+	subprocess_destroy(&p);
+	alive = false;
+    }
+    if (!alive && !start()) {
 	facetize_log(s, 0, " FAILED.\n");
 	facetize_log(s, 0, "Unable to create subprocess\n");
-
 	return BRLCAD_ERROR;
     }
-    while (subprocess_alive(&p)) {
-	std::this_thread::sleep_for(std::chrono::milliseconds(100));
-	elapsed = bu_gettime() - start;
-	seconds = elapsed / 1000000.0;
 
-	// Check for and pass along intermediate output
-	char curr_out[MAXPATHLEN*10] = {'\0'};
-	subprocess_read_stdout(&p, curr_out, MAXPATHLEN*10);
-	if (strlen(curr_out))
-	    facetize_log(s, 1, "%s", curr_out);
-	char curr_err[MAXPATHLEN*10] = {'\0'};
-	subprocess_read_stderr(&p, curr_err, MAXPATHLEN*10);
-	if (strlen(curr_err))
-	    facetize_log(s, 1, "%s", curr_err);
+    if (!send(args)) {
+	// The server went away between jobs - start a fresh one and try
+	// once more before giving up
+	relay(s, (s->verbosity >= 0) ? 0 : 1);
+	subprocess_terminate(&p);
+	subprocess_join(&p, NULL);
+	subprocess_destroy(&p);
+	alive = false;
+	if (!start() || !send(args)) {
+	    facetize_log(s, 0, " FAILED.\n");
+	    facetize_log(s, 0, "Unable to send job to subprocess\n");
+	    if (alive) {
+		subprocess_terminate(&p);
+		subprocess_join(&p, NULL);
+		subprocess_destroy(&p);
+		alive = false;
+	    }
+	    return BRLCAD_ERROR;
+	}
+    }
 
+    int64_t start_time = bu_gettime();
+    int64_t elapsed = 0;
+    fastf_t seconds = 0.0;
+    int wait_ms = 1;
+    while (subprocess_alive(&p)) {
+	relay(s, 1);
+	if (job_done(rc))
+	    return BRLCAD_OK;
+
+	elapsed = bu_gettime() - start_time;
+	seconds = elapsed / 1000000.0;
 	if (seconds > max_time) {
 	    // if we timeout, cleanup and return error
 	    subprocess_terminate(&p);
@@ -509,70 +751,160 @@ tess_run(struct _ged_facetize_state *s, const char **tess_cmd, int tess_cmd_cnt,
 	    facetize_log(s, 0, " FAILED.\n");
 
 	    facetize_log(s, 0, "tess_run subprocess killed %g %g\n", seconds, max_time);
-	    if (s->verbosity >= 0) {
-		char mraw[MAXPATHLEN*10] = {'\0'};
-		subprocess_read_stdout(&p, mraw, MAXPATHLEN*10);
-		if (strlen(mraw))
-		    facetize_log(s, 0, "%s\n", mraw);
-		char mraw2[MAXPATHLEN*10] = {'\0'};
-		subprocess_read_stderr(&p, mraw2, MAXPATHLEN*10);
-		if (strlen(mraw2))
-		    facetize_log(s, 0, "%s\n", mraw2);
-	    }
+	    relay(s, (s->verbosity >= 0) ? 0 : 1);
+	    subprocess_join(&p, NULL);
 	    subprocess_destroy(&p);
+	    alive = false;
+	    return BRLCAD_ERROR;
+	}
 
-	    // Because we had to kill the process, there's no way of knowing
-	    // whether we interrupted I/O in a state that could result in a
-	    // corrupted .g file.  Restore the pre-run state of the .g file -
-	    // we may have to redo some work, but this at least ensures we
-	    // won't have strange garbage corrupting subsequent processing.
-	    std::ifstream bakfile(wfilebak, std::ios::binary);
-	    std::ofstream workfile(wfile, std::ios::binary);
-	    if (!workfile.is_open() || !bakfile.is_open())
-		return BRLCAD_ERROR;
-	    workfile << bakfile.rdbuf();
-	    workfile.close();
-	    bakfile.close();
+	// Most jobs finish quickly, so check back soon at first and only
+	// settle into the slower polling rate for long running ones
+	std::this_thread::sleep_for(std::chrono::milliseconds(wait_ms));
+	if (wait_ms < 100)
+	    wait_ms *= 2;
+    }
 
+    // The server exited - either it finished the job just before exiting,
+    // or (much more likely) the job crashed it
+    relay(s, (s->verbosity >= 0) ? 0 : 1);
+    subprocess_destroy(&p);
+    alive = false;
+    if (job_done(rc))
+	return BRLCAD_OK;
 
-	    return BRLCAD_ERROR;
-	}
+    facetize_log(s, 0, " FAILED.\n");
+    facetize_log(s, 0, "tess_run subprocess exited unexpectedly\n");
+    return BRLCAD_ERROR;
+}
+
+// Make sure there is a snapshot of the working file to go back to if the
+// next job takes the server down.  A new one is only taken when forced or
+// when redoing the jobs since the last one would cost more than the copy.
+bool
+TessWorker::checkpoint(struct _ged_facetize_state *s, bool force)
+{
+    if (have_snapshot && !force && work_time < TESS_SNAPSHOT_RATIO * copy_time)
+	return true;
+
+    int64_t start_time = bu_gettime();
+    if (!tess_file_copy(gfile, snapshot)) {
+	facetize_log(s, 0, "Unable to create backup file %s\n", snapshot.c_str());
+	return false;
     }
-    int w_rc;
-    if (subprocess_join(&p, &w_rc)) {
-	// Unable to join??
-	facetize_log(s, 0, " FAILED.\n");
-	facetize_log(s, 0, "tess_run subprocess unable to join\n");
-	if (s->verbosity >= 0) {
-	    char mraw[MAXPATHLEN*10] = {'\0'};
-	    subprocess_read_stdout(&p, mraw, MAXPATHLEN*10);
-	    if (strlen(mraw))
-		facetize_log(s, 0, "%s\n", mraw);
-	    char mraw2[MAXPATHLEN*10] = {'\0'};
-	    subprocess_read_stderr(&p, mraw2, MAXPATHLEN*10);
-	    if (strlen(mraw2))
-		facetize_log(s, 0, "%s\n", mraw2);
+    copy_time = bu_gettime() - start_time;
+    have_snapshot = true;
+    work_time = 0;
+    done.clear();
+    return true;
+}
+
+// Remember a job that succeeded, so it can be redone if the working file
+// has to be restored from the snapshot
+void
+TessWorker::completed(std::vector<const char *> &args, std::vector<std::string> &names, fastf_t max_time, int64_t elapsed)
+{
+    tess_job j;
+    for (size_t i = 0; i < args.size(); i++)
+	j.args.push_back(std::string(args[i]));
+    j.names = names;
+    j.max_time = max_time;
+    done.push_back(j);
+    work_time += elapsed;
+}
+
+// The server died, so there's no way of knowing whether we interrupted I/O
+// in a state that could result in a corrupted .g file.  Restore the snapshot
+// and redo the jobs that had succeeded since it was taken.  A job that fails
+// this time has its objects added to lost, and if it takes the server down
+// too we start over from the snapshot without it.
+bool
+TessWorker::recover(struct _ged_facetize_state *s)
+{
+    std::vector<tess_job> redo;
+    redo.swap(done);
+
+    bool restore = true;
+    while (restore) {
+	restore = false;
+	if (!have_snapshot || !tess_file_copy(snapshot, gfile)) {
+	    facetize_log(s, 0, "Unable to restore %s from %s\n", gfile.c_str(), snapshot.c_str());
+	    for (size_t i = 0; i < redo.size(); i++)
+		lost.insert(lost.end(), redo[i].names.begin(), redo[i].names.end());
+	    return false;
+	}
+	if (redo.size())
+	    facetize_log(s, 1, "Restored %s, redoing %zu jobs\n", gfile.c_str(), redo.size());
+
+	size_t i = 0;
+	while (i < redo.size()) {
+	    std::vector<const char *> args;
+	    for (size_t j = 0; j < redo[i].args.size(); j++)
+		args.push_back(redo[i].args[j].c_str());
+	    int rc = BRLCAD_ERROR;
+	    int ret = run(s, args, redo[i].max_time, &rc);
+	    if (ret == BRLCAD_OK && rc == BRLCAD_OK) {
+		i++;
+		continue;
+	    }
+	    lost.insert(lost.end(), redo[i].names.begin(), redo[i].names.end());
+	    redo.erase(redo.begin() + i);
+	    if (ret != BRLCAD_OK) {
+		restore = true;
+		break;
+	    }
 	}
-	return BRLCAD_ERROR;
     }
 
-    bu_file_delete(wfilebak.c_str());
-
-    if (s->verbosity >= 0) {
-	char mraw[MAXPATHLEN*10] = {'\0'};
-	subprocess_read_stdout(&p, mraw, MAXPATHLEN*10);
-	if (strlen(mraw))
-	    facetize_log(s, 0, "%s\n", mraw);
-	char mraw2[MAXPATHLEN*10] = {'\0'};
-	subprocess_read_stderr(&p, mraw2, MAXPATHLEN*10);
-	if (strlen(mraw2))
-	    facetize_log(s, 0, "%s\n", mraw2);
-    }
+    // Snapshot the redone work so a later failure doesn't repeat it
+    return checkpoint(s, true);
+}
 
-    // Needed to clean up file handles
-    subprocess_destroy(&p);
+// The first four tess_cmd entries are the ged_exec path, facetize_process,
+// -O and the working file.  The server is started with those, and everything
+// after them makes up the job.  The last ocnt entries are the objects the job
+// tessellates.
+int
+tess_run(struct _ged_facetize_state *s, TessWorker *w, const char **tess_cmd, int tess_cmd_cnt, fastf_t max_time, int ocnt)
+{
+    if (!s || !w || !tess_cmd || !tess_cmd[3])
+	return BRLCAD_ERROR;
+
+    if (!w->checkpoint(s, false))
+	return BRLCAD_ERROR;
+
+    // Record the actual command being use to trigger the subprocess
+    struct bu_vls cmd = BU_VLS_INIT_ZERO;
+    for (int i = 0; i < tess_cmd_cnt ; i++)
+	bu_vls_printf(&cmd, "%s ", tess_cmd[i]);
+    facetize_log(s, 2, "%s\n", bu_vls_cstr(&cmd));
+    bu_vls_free(&cmd);
+
+    // If we're not being verbose, just report how many objects we're working on
+    if (ocnt == 1)
+	facetize_log(s, 0, "Attempting to triangulate %s...", tess_cmd[tess_cmd_cnt-ocnt]);
+    if (ocnt > 1)
+	facetize_log(s, 0, "Attempting to triangulate %d solids...", ocnt);
+
+    std::vector<const char *> args;
+    args.push_back(tess_cmd[2]);
+    for (int i = 4; i < tess_cmd_cnt; i++)
+	args.push_back(tess_cmd[i]);
+
+    int64_t start_time = bu_gettime();
+    int w_rc = BRLCAD_ERROR;
+    if (w->run(s, args, max_time, &w_rc) != BRLCAD_OK) {
+	// We may have to redo some work, but this at least ensures we
+	// won't have strange garbage corrupting subsequent processing.
+	w->recover(s);
+	return BRLCAD_ERROR;
+    }
 
     if (w_rc == BRLCAD_OK) {
+	std::vector<std::string> names;
+	for (int i = tess_cmd_cnt - ocnt; i < tess_cmd_cnt; i++)
+	    names.push_back(std::string(tess_cmd[i]));
+	w->completed(args, names, max_time, bu_gettime() - start_time);
 	facetize_log(s, 0, " Success.\n");
     } else {
 	facetize_log(s, 0, " FAILED.\n");
@@ -582,10 +914,10 @@ tess_run(struct _ged_facetize_state *s, const char **tess_cmd, int tess_cmd_cnt,
 }
 
 int
-bisect_run(struct _ged_facetize_state *s, std::vector<struct directory *> &bad_dps, std::vector<struct directory *> &inputs, const char **orig_cmd, int cmd_cnt, fastf_t max_time, int ocnt);
+bisect_run(struct _ged_facetize_state *s, TessWorker *w, std::vector<struct directory *> &bad_dps, std::vector<struct directory *> &inputs, const char **orig_cmd, int cmd_cnt, fastf_t max_time, int ocnt);
 
 int
-bisect_failing_inputs(struct _ged_facetize_state *s, std::vector<struct directory *> &bad_dps, std::vector<struct directory *> &inputs, const char **orig_cmd, int cmd_cnt, fastf_t max_time)
+bisect_failing_inputs(struct _ged_facetize_state *s, TessWorker *w, std::vector<struct directory *> &bad_dps, std::vector<struct directory *> &inputs, const char **orig_cmd, int cmd_cnt, fastf_t max_time)
 {
     std::vector<struct directory *> left_inputs;
     std::vector<struct directory *> right_inputs;
@@ -594,13 +926,13 @@ bisect_failing_inputs(struct _ged_facetize_state *s, std::vector<struct director
     for (size_t i =  inputs.size()/2; i < inputs.size(); i++)
 	right_inputs.push_back(inputs[i]);
 
-    int lret = bisect_run(s, bad_dps, left_inputs, orig_cmd, cmd_cnt, max_time, left_inputs.size());
-    int rret = bisect_run(s, bad_dps, right_inputs, orig_cmd, cmd_cnt, max_time, right_inputs.size());
+    int lret = bisect_run(s, w, bad_dps, left_inputs, orig_cmd, cmd_cnt, max_time, left_inputs.size());
+    int rret = bisect_run(s, w, bad_dps, right_inputs, orig_cmd, cmd_cnt, max_time, right_inputs.size());
     return lret + rret;
 }
 
 int
-bisect_run(struct _ged_facetize_state *s, std::vector<struct directory *> &bad_dps, std::vector<struct directory *> &inputs, const char **orig_cmd, int cmd_cnt, fastf_t max_time, int ocnt)
+bisect_run(struct _ged_facetize_state *s, TessWorker *w, std::vector<struct directory *> &bad_dps, std::vector<struct directory *> &inputs, const char **orig_cmd, int cmd_cnt, fastf_t max_time, int ocnt)
 {
     const char *tess_cmd[MAXPATHLEN] = {NULL};
     // The initial part of the re-run is the same.
@@ -611,10 +943,10 @@ bisect_run(struct _ged_facetize_state *s, std::vector<struct directory *> &bad_d
 	tess_cmd[cmd_cnt+i] = inputs[i]->d_namep;
     }
 
-    int ret = tess_run(s, tess_cmd, cmd_cnt+inputs.size(), max_time, ocnt);
+    int ret = tess_run(s, w, tess_cmd, cmd_cnt+inputs.size(), max_time, ocnt);
     if (ret) {
 	if (inputs.size() > 1) {
-	    return bisect_failing_inputs(s, bad_dps, inputs, tess_cmd, cmd_cnt, max_time);
+	    return bisect_failing_inputs(s, w, bad_dps, inputs, tess_cmd, cmd_cnt, max_time);
 	}
 	bad_dps.push_back(inputs[0]);
 	return 1;
@@ -753,6 +1085,11 @@ _ged_facetize_leaves_tri(struct _ged_facetize_state *s, struct db_i *dbip, struc
     tess_cmd[ 8] = "--cache-dir";
     tess_cmd[ 9] = lcache;
     int cmd_fixed_cnt = 10;
+
+    // All the attempts below are run by one long-lived subprocess
+    TessWorker worker(tess_exec, bu_vls_cstr(s->wfile), lcache);
+    TessWorker *w = &worker;
+
     while (!pq.empty()) {
 	int obj_cnt = 0;
 
@@ -797,14 +1134,14 @@ _ged_facetize_leaves_tri(struct _ged_facetize_state *s, struct db_i *dbip, struc
 	int err_cnt = 0;
 	while (bu_vls_strlen(&method_str)) {
 	    if (BU_STR_EQUAL(bu_vls_cstr(&method_str), "NMG")) {
-		err_cnt = bisect_run(s, bad_dps, dps, tess_cmd, cmd_fixed_cnt, l_max_time, obj_cnt);
+		err_cnt = bisect_run(s, w, bad_dps, dps, tess_cmd, cmd_fixed_cnt, l_max_time, obj_cnt);
 	    } else {
 		// If we're in fallback territory, process individually rather
 		// than doing the bisect - at least for now, those methods are
 		// much more expensive and likely to fail as compared to NMG.
 		for (size_t i = 0; i < dps.size(); i++) {
 		    tess_cmd[cmd_fixed_cnt] = dps[i]->d_namep;
-		    int tess_ret = tess_run(s, tess_cmd, cmd_fixed_cnt + 1, l_max_time, 1);
+		    int tess_ret = tess_run(s, w, tess_cmd, cmd_fixed_cnt + 1, l_max_time, 1);
 		    if (tess_ret != BRLCAD_OK) {
 			bad_dps.push_back(dps[i]);
 			err_cnt++;
@@ -877,7 +1214,7 @@ _ged_facetize_leaves_tri(struct _ged_facetize_state *s, struct db_i *dbip, struc
 	// primitives
 	for (size_t i = 0; i < dps.size(); i++) {
 	    tess_cmd[cmd_fixed_cnt] = dps[i]->d_namep;
-	    int err_cnt = tess_run(s, tess_cmd, cmd_fixed_cnt + 1, l_max_time, 1);
+	    int err_cnt = tess_run(s, w, tess_cmd, cmd_fixed_cnt + 1, l_max_time, 1);
 	    if (err_cnt)
 		failed_dps.push_back(std::string(dps[i]->d_namep));
 	}
@@ -914,7 +1251,7 @@ _ged_facetize_leaves_tri(struct _ged_facetize_state *s, struct db_i *dbip, struc
 	bu_vls_free(&cmd);
 
 
-	int err_cnt = bisect_run(s, bad_dps, dps, tess_cmd, cmd_fixed_cnt, l_max_time * dps.size(), obj_cnt);
+	int err_cnt = bisect_run(s, w, bad_dps, dps, tess_cmd, cmd_fixed_cnt, l_max_time * dps.size(), obj_cnt);
 	if (err_cnt) {
 	    // If we couldn't handle the plate mode conversion, we can't do the
 	    // boolean evaluation
@@ -923,6 +1260,13 @@ _ged_facetize_leaves_tri(struct _ged_facetize_state *s, struct db_i *dbip, struc
 	}
     }
 
+    // Done with the subprocess - make sure it has released the working file
+    worker.stop();
+
+    // Anything whose results were lost to a server crash and couldn't be
+    // redone is a failure too
+    failed_dps.insert(failed_dps.end(), worker.lost.begin(), worker.lost.end());
+
     if (failed_dps.size()) {
 	// As the parent process, we can know when we've run out of options
        // to try.  If we get there, flag the solid in the working copy so
@@ -40,6 +40,10 @@
 #include <math.h>
 #include <limits.h>			/* home of INT_MAX aka MAXINT */
 
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "bu/parallel.h"
 #include "bu/getopt.h"
@@ -126,7 +130,7 @@ static int debug = 0;
  */
 #define A_LENDEN a_color[0]
 #define A_LEN a_color[1]
-#define A_STATE a_uptr
+#define A_WORKER a_uptr
 
 
 struct cstate {
@@ -198,6 +202,79 @@ static struct per_region_data {
 } *reg_tbl;
 
 
+/**
+ * A unique region pair seen by one worker, merged into one of the
+ * region_pair lists below with add_unique_pair() semantics.
+ */
+struct gqa_pair {
+    struct region *r1;
+    struct region *r2;
+    unsigned long count;
+    double max_dist;
+    point_t coord;
+};
+
+typedef std::pair<struct region *, struct region *> gqa_pair_key;
+
+struct gqa_pair_hash {
+    size_t operator()(const gqa_pair_key &k) const {
+	return std::hash<struct region *>()(k.first) ^ (std::hash<struct region *>()(k.second) << 1);
+    }
+};
+
+typedef std::unordered_map<gqa_pair_key, struct gqa_pair, gqa_pair_hash> gqa_pair_map;
+
+/**
+ * A line segment bound for a plot file (or for the overlap vlist when
+ * fp is NULL).
+ */
+struct gqa_plot_seg {
+    FILE *fp;
+    const int *color;
+    point_t p1;
+    point_t p2;
+};
+
+/**
+ * Per-region sums collected by one worker.
+ */
+struct gqa_region_sums {
+    unsigned long hits;
+    double lenDensity;
+    double len;
+};
+
+/**
+ * Everything a plane_worker() thread accumulates during one pass over
+ * a view.  Nothing in here is shared, so the ray callbacks run without
+ * taking locks; worker_merge() folds it into the shared tables once
+ * the thread runs out of rows.
+ */
+struct gqa_worker {
+    struct cstate *state;
+
+    std::unordered_map<struct region *, struct gqa_region_sums> regions;
+
+    /* per-object sums, indexed like obj_tbl */
+    std::vector<double> o_lenDensity;
+    std::vector<double> o_len;
+    std::vector<fastf_t> o_lenTorque; /* 3 per object */
+    std::vector<fastf_t> o_moi;
+    std::vector<fastf_t> o_poi;
+
+    vect_t m_lenTorque;
+    vect_t m_moi;
+    vect_t m_poi;
+
+    gqa_pair_map overlaps;
+    gqa_pair_map gaps;
+    gqa_pair_map adjAir;
+    gqa_pair_map exposedAir;
+
+    std::vector<struct gqa_plot_seg> plot;
+};
+
+
 /* Access to these lists should be in sections
  * of code protected by state->sem_lists
  */
@@ -750,6 +827,125 @@ parse_args(struct ged *gedp, int ac, char *av[])
     return bu_optind;
 }
 
+static void
+worker_add_pair(gqa_pair_map &pairs, struct region *r1, struct region *r2, double dist, point_t pt)
+{
+    /* pairs match in either order, like add_unique_pair() */
+    gqa_pair_key key = std::less<struct region *>()(r1, r2) ? gqa_pair_key(r1, r2) : gqa_pair_key(r2, r1);
+    gqa_pair_map::iterator it = pairs.find(key);
+
+    if (it == pairs.end()) {
+	struct gqa_pair &p = pairs[key];
+	p.r1 = r1;
+	p.r2 = r2;
+	p.count = 1;
+	p.max_dist = dist;
+	VMOVE(p.coord, pt);
+	return;
+    }
+
+    it->second.count++;
+    if (dist > it->second.max_dist) {
+	it->second.max_dist = dist;
+	VMOVE(it->second.coord, pt);
+    }
+}
+
+
+static void
+worker_plot(struct gqa_worker *w, FILE *fp, const int *color, const point_t p1, const point_t p2)
+{
+    struct gqa_plot_seg seg;
+    seg.fp = fp;
+    seg.color = color;
+    VMOVE(seg.p1, p1);
+    VMOVE(seg.p2, p2);
+    w->plot.push_back(seg);
+}
+
+
+static void
+worker_init(struct gqa_worker *w, struct cstate *state)
+{
+    w->state = state;
+    w->o_lenDensity.assign(num_objects, 0.0);
+    w->o_len.assign(num_objects, 0.0);
+    w->o_lenTorque.assign(num_objects * 3, 0.0);
+    w->o_moi.assign(num_objects * 3, 0.0);
+    w->o_poi.assign(num_objects * 3, 0.0);
+    VSETALL(w->m_lenTorque, 0.0);
+    VSETALL(w->m_moi, 0.0);
+    VSETALL(w->m_poi, 0.0);
+}
+
+
+static void
+merge_pairs(struct region_pair *list, gqa_pair_map &pairs)
+{
+    for (gqa_pair_map::iterator it = pairs.begin(); it != pairs.end(); ++it) {
+	struct gqa_pair *p = &it->second;
+	struct region_pair *rp = add_unique_pair(list, p->r1, p->r2, p->max_dist, p->coord);
+	rp->count += p->count - 1;
+    }
+}
+
+
+/**
+ * Fold one worker's sums, pairs and plot segments into the shared
+ * state.  Called once per thread per view pass.
+ */
+static void
+worker_merge(struct gqa_worker *w)
+{
+    struct cstate *state = w->state;
+    int view = state->curr_view;
+    int i;
+
+    bu_semaphore_acquire(state->sem_stats);
+    for (std::unordered_map<struct region *, struct gqa_region_sums>::iterator it = w->regions.begin(); it != w->regions.end(); ++it) {
+	struct per_region_data *prd = (struct per_region_data *)it->first->reg_udata;
+	prd->hits += it->second.hits;
+	prd->r_lenDensity[state->i_axis] += it->second.lenDensity;
+	prd->r_len[view] += it->second.len;
+    }
+    for (i = 0; i < num_objects; i++) {
+	obj_tbl[i].o_lenDensity[state->i_axis] += w->o_lenDensity[i];
+	obj_tbl[i].o_len[view] += w->o_len[i];
+	VADD2(&obj_tbl[i].o_lenTorque[state->i_axis*3], &obj_tbl[i].o_lenTorque[state->i_axis*3], &w->o_lenTorque[i*3]);
+	VADD2(&obj_tbl[i].o_moi[state->i_axis*3], &obj_tbl[i].o_moi[state->i_axis*3], &w->o_moi[i*3]);
+	VADD2(&obj_tbl[i].o_poi[state->i_axis*3], &obj_tbl[i].o_poi[state->i_axis*3], &w->o_poi[i*3]);
+    }
+    VADD2(&state->m_lenTorque[state->i_axis*3], &state->m_lenTorque[state->i_axis*3], w->m_lenTorque);
+    VADD2(&state->m_moi[state->i_axis*3], &state->m_moi[state->i_axis*3], w->m_moi);
+    VADD2(&state->m_poi[state->i_axis*3], &state->m_poi[state->i_axis*3], w->m_poi);
+    bu_semaphore_release(state->sem_stats);
+
+    if (!w->overlaps.empty() || !w->gaps.empty() || !w->adjAir.empty() || !w->exposedAir.empty()) {
+	bu_semaphore_acquire(state->sem_lists);
+	merge_pairs(&overlapList, w->overlaps);
+	merge_pairs(&gapList, w->gaps);
+	merge_pairs(&adjAirList, w->adjAir);
+	merge_pairs(&exposedAirList, w->exposedAir);
+	bu_semaphore_release(state->sem_lists);
+    }
+
+    if (!w->plot.empty()) {
+	bu_semaphore_acquire(state->sem_plot);
+	for (size_t j = 0; j < w->plot.size(); j++) {
+	    struct gqa_plot_seg *seg = &w->plot[j];
+	    if (seg->fp) {
+		pl_color(seg->fp, V3ARGS(seg->color));
+		pdv_3line(seg->fp, seg->p1, seg->p2);
+	    } else {
+		BV_ADD_VLIST(ged_gqa_plot.vbp->free_vlist_hd, ged_gqa_plot.vhead, seg->p1, BV_VLIST_LINE_MOVE);
+		BV_ADD_VLIST(ged_gqa_plot.vbp->free_vlist_hd, ged_gqa_plot.vhead, seg->p2, BV_VLIST_LINE_DRAW);
+	    }
+	}
+	bu_semaphore_release(state->sem_plot);
+    }
+}
+
+
 /**
  * Write end points of partition to the standard output.  If this
  * routine return !0, this partition will be dropped from the boolean
@@ -769,7 +965,8 @@ _gqa_overlap(struct application *ap,
 	     struct region *reg2,
 	     struct partition *hp)
 {
-    struct cstate *state = (struct cstate *)ap->A_STATE;
+    struct gqa_worker *w = (struct gqa_worker *)ap->A_WORKER;
+    struct cstate *state = w->state;
     struct ged *gedp = state->gedp;
     struct xray *rp = &ap->a_ray;
     struct hit *ihitp = pp->pt_inhit;
@@ -796,31 +993,17 @@ _gqa_overlap(struct application *ap,
     VJOIN1(ihit, rp->r_pt, ihitp->hit_dist, rp->r_dir);
     VJOIN1(ohit, rp->r_pt, ohitp->hit_dist, rp->r_dir);
 
-    if (plot_overlaps) {
-	bu_semaphore_acquire(state->sem_plot);
-	pl_color(plot_overlaps, V3ARGS(overlap_color));
-	pdv_3line(plot_overlaps, ihit, ohit);
-	bu_semaphore_release(state->sem_plot);
-    }
+    if (plot_overlaps)
+	worker_plot(w, plot_overlaps, overlap_color, ihit, ohit);
 
-    if (analysis_flags & ANALYSIS_PLOT_OVERLAPS) {
-	bu_semaphore_acquire(state->sem_worker);
-	BV_ADD_VLIST(ged_gqa_plot.vbp->free_vlist_hd, ged_gqa_plot.vhead, ihit, BV_VLIST_LINE_MOVE);
-	BV_ADD_VLIST(ged_gqa_plot.vbp->free_vlist_hd, ged_gqa_plot.vhead, ohit, BV_VLIST_LINE_DRAW);
-	bu_semaphore_release(state->sem_worker);
-    }
+    if (analysis_flags & ANALYSIS_PLOT_OVERLAPS)
+	worker_plot(w, NULL, NULL, ihit, ohit);
 
     if (analysis_flags & ANALYSIS_OVERLAPS) {
-	bu_semaphore_acquire(state->sem_lists);
-	add_unique_pair(&overlapList, reg1, reg2, depth, ihit);
-	bu_semaphore_release(state->sem_lists);
+	worker_add_pair(w->overlaps, reg1, reg2, depth, ihit);
 
-	if (plot_overlaps) {
-	    bu_semaphore_acquire(state->sem_plot);
-	    pl_color(plot_overlaps, V3ARGS(overlap_color));
-	    pdv_3line(plot_overlaps, ihit, ohit);
-	    bu_semaphore_release(state->sem_plot);
-	}
+	if (plot_overlaps)
+	    worker_plot(w, plot_overlaps, overlap_color, ihit, ohit);
     } else {
 	bu_semaphore_acquire(state->sem_worker);
 	bu_vls_printf(gedp->ged_result_str, "overlap %s %s\n", reg1->reg_name, reg2->reg_name);
@@ -861,24 +1044,18 @@ void _gqa_exposed_air(struct application *ap,
 		      point_t in_pt,
 		      point_t out_pt)
 {
-    struct cstate *state = (struct cstate *)ap->A_STATE;
+    struct gqa_worker *w = (struct gqa_worker *)ap->A_WORKER;
 
     /* this shouldn't be air */
 
-    bu_semaphore_acquire(state->sem_lists);
-    add_unique_pair(&exposedAirList,
+    worker_add_pair(w->exposedAir,
 		    pp->pt_regionp,
 		    (struct region *)NULL,
 		    DIST_PNT_PNT(in_pt, out_pt), /* thickness */
 		    last_out_point); /* location */
-    bu_semaphore_release(state->sem_lists);
 
-    if (plot_expair) {
-	bu_semaphore_acquire(state->sem_plot);
-	pl_color(plot_expair, V3ARGS(expAir_color));
-	pdv_3line(plot_expair, in_pt, out_pt);
-	bu_semaphore_release(state->sem_plot);
-    }
+    if (plot_expair)
+	worker_plot(w, plot_expair, expAir_color, in_pt, out_pt);
 }
 
 
@@ -901,7 +1078,8 @@ _gqa_hit(struct application *ap, struct partition *PartHeadp, struct seg *segs)
     double dist;       /* the thickness of the partition */
     double last_out_dist = -1.0;
     double val;
-    struct cstate *state = (struct cstate *)ap->A_STATE;
+    struct gqa_worker *w = (struct gqa_worker *)ap->A_WORKER;
+    struct cstate *state = w->state;
     struct ged *gedp = state->gedp;
 
     if (!segs) /* unexpected */
@@ -973,23 +1151,18 @@ _gqa_hit(struct application *ap, struct partition *PartHeadp, struct seg *segs)
 		if (gap_dist > overlap_tolerance) {
 
 		    /* like overlaps, we only want to report unique pairs */
-		    bu_semaphore_acquire(state->sem_lists);
-		    add_unique_pair(&gapList,
+		    worker_add_pair(w->gaps,
 				    pp->pt_regionp,
 				    pp->pt_back->pt_regionp,
 				    gap_dist,
 				    pt);
-		    bu_semaphore_release(state->sem_lists);
 
 		    /* like overlaps, let's plot */
 		    if (plot_gaps) {
 			vect_t gapEnd;
 			VJOIN1(gapEnd, pt, -gap_dist, ap->a_ray.r_dir);
 
-			bu_semaphore_acquire(state->sem_plot);
-			pl_color(plot_gaps, V3ARGS(gap_color));
-			pdv_3line(plot_gaps, pt, gapEnd);
-			bu_semaphore_release(state->sem_plot);
+			worker_plot(w, plot_gaps, gap_color, pt, gapEnd);
 		    }
 		}
 	    }
@@ -1084,11 +1257,11 @@ _gqa_hit(struct application *ap, struct partition *PartHeadp, struct seg *segs)
 		}
 
 		/* accumulate the per-region per-view weight values */
-		bu_semaphore_acquire(state->sem_stats);
-		prd->r_lenDensity[state->i_axis] += val;
+		size_t obj = (size_t)(prd->optr - obj_tbl);
+		w->regions[pp->pt_regionp].lenDensity += val;
 
 		/* accumulate the per-object per-view weight values */
-		prd->optr->o_lenDensity[state->i_axis] += val;
+		w->o_lenDensity[obj] += val;
 
 		if (analysis_flags & ANALYSIS_CENTROIDS) {
 		    /* calculate the center of mass for this partition */
@@ -1098,10 +1271,10 @@ _gqa_hit(struct application *ap, struct partition *PartHeadp, struct seg *segs)
 		    VSCALE(lenTorque, cmass, val);
 
 		    /* accumulate per-object per-view torque values */
-		    VADD2(&prd->optr->o_lenTorque[state->i_axis*3], &prd->optr->o_lenTorque[state->i_axis*3], lenTorque);
+		    VADD2(&w->o_lenTorque[obj*3], &w->o_lenTorque[obj*3], lenTorque);
 
 		    /* accumulate the total lenTorque */
-		    VADD2(&state->m_lenTorque[state->i_axis*3], &state->m_lenTorque[state->i_axis*3], lenTorque);
+		    VADD2(w->m_lenTorque, w->m_lenTorque, lenTorque);
 
 		    if (analysis_flags & ANALYSIS_MOMENTS) {
 			vectp_t moi = NULL;
@@ -1113,28 +1286,26 @@ _gqa_hit(struct application *ap, struct partition *PartHeadp, struct seg *segs)
 			static const fastf_t ONE_TWELFTH = 1.0 / 12.0;
 
 			/* Collect moments and products of inertia for the current object */
-			moi = &prd->optr->o_moi[state->i_axis*3];
+			moi = &w->o_moi[obj*3];
 			moi[X] += ONE_TWELFTH*mass*(Ly_sq + Lz_sq) + mass*(dy_sq + dz_sq);
 			moi[Y] += ONE_TWELFTH*mass*(Lx_sq + Lz_sq) + mass*(dx_sq + dz_sq);
 			moi[Z] += ONE_TWELFTH*mass*(Lx_sq + Ly_sq) + mass*(dx_sq + dy_sq);
-			poi = &prd->optr->o_poi[state->i_axis*3];
+			poi = &w->o_poi[obj*3];
 			poi[X] -= mass*cmass[X]*cmass[Y];
 			poi[Y] -= mass*cmass[X]*cmass[Z];
 			poi[Z] -= mass*cmass[Y]*cmass[Z];
 
 			/* Collect moments and products of inertia for all objects */
-			moi = &state->m_moi[state->i_axis*3];
+			moi = w->m_moi;
 			moi[X] += ONE_TWELFTH*mass*(Ly_sq + Lz_sq) + mass*(dy_sq + dz_sq);
 			moi[Y] += ONE_TWELFTH*mass*(Lx_sq + Lz_sq) + mass*(dx_sq + dz_sq);
 			moi[Z] += ONE_TWELFTH*mass*(Lx_sq + Ly_sq) + mass*(dx_sq + dy_sq);
-			poi = &state->m_poi[state->i_axis*3];
+			poi = w->m_poi;
 			poi[X] -= mass*cmass[X]*cmass[Y];
 			poi[Y] -= mass*cmass[X]*cmass[Z];
 			poi[Z] -= mass*cmass[Y]*cmass[Z];
 		    }
 		}
-
-		bu_semaphore_release(state->sem_stats);
 	    }
 	}
 
@@ -1155,35 +1326,27 @@ _gqa_hit(struct application *ap, struct partition *PartHeadp, struct seg *segs)
 		    continue;
 		}
 
-		bu_semaphore_acquire(state->sem_stats);
-
 		/* add to region volume */
-		prd->r_len[state->curr_view] += dist;
+		w->regions[pp->pt_regionp].len += dist;
 
 		/* add to object volume */
-		prd->optr->o_len[state->curr_view] += dist;
-
-		bu_semaphore_release(state->sem_stats);
+		w->o_len[prd->optr - obj_tbl] += dist;
 	    }
 	    if (debug) {
 		bu_semaphore_acquire(state->sem_worker);
 		bu_vls_printf(gedp->ged_result_str, "\t\tvol hit %s oDist:%g objVol:%g %s\n",
-			      pp->pt_regionp->reg_name, dist, prd->optr->o_len[state->curr_view], prd->optr->o_name);
+			      pp->pt_regionp->reg_name, dist, w->o_len[prd->optr - obj_tbl], prd->optr->o_name);
 		bu_semaphore_release(state->sem_worker);
 	    }
 
 	    if (plot_volume) {
 		VJOIN1(opt, ap->a_ray.r_pt, pp->pt_outhit->hit_dist, ap->a_ray.r_dir);
 
-		bu_semaphore_acquire(state->sem_plot);
 		if (ap->a_user & 1) {
-		    pl_color(plot_volume, V3ARGS(gap_color));
+		    worker_plot(w, plot_volume, gap_color, pt, opt);
 		} else {
-		    pl_color(plot_volume, V3ARGS(adjAir_color));
+		    worker_plot(w, plot_volume, adjAir_color, pt, opt);
 		}
-
-		pdv_3line(plot_volume, pt, opt);
-		bu_semaphore_release(state->sem_plot);
 	    }
 	}
 
@@ -1196,22 +1359,18 @@ _gqa_hit(struct application *ap, struct partition *PartHeadp, struct seg *segs)
 		double d = pp->pt_outhit->hit_dist - pp->pt_inhit->hit_dist;
 		point_t aapt;
 
-		bu_semaphore_acquire(state->sem_lists);
-		add_unique_pair(&adjAirList, pp->pt_back->pt_regionp, pp->pt_regionp, 0.0, pt);
-		bu_semaphore_release(state->sem_lists);
+		worker_add_pair(w->adjAir, pp->pt_back->pt_regionp, pp->pt_regionp, 0.0, pt);
 
 		d *= 0.25;
 		VJOIN1(aapt, pt, d, ap->a_ray.r_dir);
 
-		bu_semaphore_acquire(state->sem_plot);
-		pl_color(plot_adjair, V3ARGS(adjAir_color));
-		pdv_3line(plot_adjair, pt, aapt);
-		bu_semaphore_release(state->sem_plot);
+		if (plot_adjair)
+		    worker_plot(w, plot_adjair, adjAir_color, pt, aapt);
 	    }
 	}
 
 	/* note that this region has been seen */
-	((struct per_region_data *)pp->pt_regionp->reg_udata)->hits++;
+	w->regions[pp->pt_regionp].hits++;
 
 	last_air = pp->pt_regionp->reg_aircode;
 	last_out_dist = pp->pt_outhit->hit_dist;
@@ -1250,19 +1409,35 @@ _gqa_miss(struct application *ap)
 
 
 /**
+ * Hand out the next run of rows [v, *v_end) to work on.  Runs start
+ * large and shrink as the view nears completion, so threads take the
+ * lock rarely but still finish at about the same time.  Returns 0 when
+ * there are no rows left.
+ *
  * This routine must be prepared to run in parallel
  */
 int
-get_next_row(struct cstate *state)
+get_next_rows(struct cstate *state, int *v_end)
 {
     int v;
+    long remaining;
+    long chunk;
+
     /* look for more work */
     bu_semaphore_acquire(state->sem_worker);
 
-    if (state->v < state->steps[state->v_axis])
-	v = state->v++;	/* get a row to work on */
-    else
+    remaining = state->steps[state->v_axis] - state->v;
+    if (remaining > 0) {
+	chunk = remaining / (4 * (ncpu > 0 ? ncpu : 1));
+	if (chunk < 1)
+	    chunk = 1;
+	v = state->v;	/* get rows to work on */
+	state->v += (int)chunk;
+	*v_end = state->v;
+    } else {
 	v = 0; /* signal end of work */
+	*v_end = 0;
+    }
 
     bu_semaphore_release(state->sem_worker);
 
@@ -1277,15 +1452,18 @@ void
 plane_worker(int cpu, void *ptr)
 {
     struct application ap;
-    int u, v;
+    int u, v, v_end;
     double v_coord;
     struct cstate *state = (struct cstate *)ptr;
     unsigned long shot_cnt;
     struct ged *gedp = state->gedp;
+    struct gqa_worker w;
 
     if (aborted)
 	return;
 
+    worker_init(&w, state);
+
     RT_APPLICATION_INIT(&ap);
     ap.a_rt_i = (struct rt_i *)state->rtip;	/* application uses this instance */
     ap.a_hit = _gqa_hit;    /* where to go on a hit */
@@ -1300,11 +1478,11 @@ plane_worker(int cpu, void *ptr)
     ap.a_ray.r_dir[state->u_axis] = ap.a_ray.r_dir[state->v_axis] = 0.0;
     ap.a_ray.r_dir[state->i_axis] = 1.0;
 
-    ap.A_STATE = ptr; /* really copying the state ptr to the a_uptr */
+    ap.A_WORKER = &w; /* per-thread sums, merged below */
 
     u = -1;
 
-    v = get_next_row(state);
+    v = get_next_rows(state, &v_end);
 
     shot_cnt = 0;
     while (v) {
@@ -1374,7 +1552,8 @@ plane_worker(int cpu, void *ptr)
 	}
 
 	/* iterate */
-	v = get_next_row(state);
+	if (++v >= v_end)
+	    v = get_next_rows(state, &v_end);
     }
 
     if (debug && (u == -1)) {
@@ -1393,6 +1572,8 @@ plane_worker(int cpu, void *ptr)
     state->m_lenDensity[state->curr_view] += ap.A_LENDEN; /* add our length*density value */
     state->m_len[state->curr_view] += ap.A_LEN; /* add our volume value */
     bu_semaphore_release(state->sem_stats);
+
+    worker_merge(&w);
 }
 
 
@@ -0,0 +1,259 @@
+/*                  T E S T _ D B I _ S T A T E . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file test_dbi_state.cpp
+ *
+ * Edit, remove and re-add combs with repeated children and check that
+ * the incrementally updated DbiState comb maps match the ones a new
+ * DbiState builds from scratch.
+ *
+ */
+
+#include "common.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <bu.h>
+#include <ged.h>
+#include <wdb.h>
+
+#include "../dbi.h"
+
+// Feed database changes to the current DbiState, as the draw tests and
+// libqtcad do
+extern "C" void
+dbi_test_changed(struct db_i *UNUSED(dbip), struct directory *dp, int mode, void *u_data)
+{
+    struct ged *gedp = (struct ged *)u_data;
+    DbiState *ctx = (DbiState *)gedp->dbi_state;
+    unsigned long long hash;
+
+    ctx->clear_cache(dp);
+
+    switch (mode) {
+	case 0:
+	    ctx->changed.insert(dp);
+	    break;
+	case 1:
+	    ctx->added.insert(dp);
+	    break;
+	case 2:
+	    hash = bu_data_hash(dp->d_namep, strlen(dp->d_namep)*sizeof(char));
+	    ctx->removed.insert(hash);
+	    ctx->old_names[hash] = std::string(dp->d_namep);
+	    break;
+	default:
+	    bu_log("changed callback mode error: %d\n", mode);
+    }
+}
+
+
+static void
+mk_model(const char *fname)
+{
+    struct rt_wdb *wdbp;
+    struct wmember wm;
+    point_t c;
+
+    bu_file_delete(fname);
+    wdbp = wdb_fopen(fname);
+    if (!wdbp)
+	bu_exit(1, "unable to create %s\n", fname);
+
+    VSET(c, 0.0, 0.0, 0.0);
+    mk_sph(wdbp, "s1", c, 10.0);
+    VSET(c, 15.0, 0.0, 0.0);
+    mk_sph(wdbp, "s2", c, 10.0);
+    VSET(c, 0.0, 15.0, 0.0);
+    mk_sph(wdbp, "s3", c, 10.0);
+
+    BU_LIST_INIT(&wm.l);
+    (void)mk_addmember("s1", &wm.l, NULL, WMOP_UNION);
+    (void)mk_addmember("s1", &wm.l, NULL, WMOP_UNION);
+    (void)mk_addmember("s2", &wm.l, NULL, WMOP_UNION);
+    (void)mk_addmember("s1", &wm.l, NULL, WMOP_SUBTRACT);
+    mk_lfcomb(wdbp, "c1", &wm, 0);
+
+    BU_LIST_INIT(&wm.l);
+    (void)mk_addmember("c1", &wm.l, NULL, WMOP_UNION);
+    (void)mk_addmember("c1", &wm.l, NULL, WMOP_UNION);
+    (void)mk_addmember("s3", &wm.l, NULL, WMOP_UNION);
+    mk_lfcomb(wdbp, "c2", &wm, 0);
+
+    BU_LIST_INIT(&wm.l);
+    (void)mk_addmember("missing", &wm.l, NULL, WMOP_UNION);
+    (void)mk_addmember("missing", &wm.l, NULL, WMOP_UNION);
+    (void)mk_addmember("s1", &wm.l, NULL, WMOP_UNION);
+    mk_lfcomb(wdbp, "bad", &wm, 0);
+
+    BU_LIST_INIT(&wm.l);
+    (void)mk_addmember("c1", &wm.l, NULL, WMOP_UNION);
+    (void)mk_addmember("c2", &wm.l, NULL, WMOP_UNION);
+    (void)mk_addmember("bad", &wm.l, NULL, WMOP_UNION);
+    mk_lfcomb(wdbp, "top", &wm, 0);
+
+    wdb_close(wdbp);
+}
+
+
+static void
+run_cmd(struct ged *gedp, int ac, const char **av)
+{
+    if (ged_exec(gedp, ac, av) & BRLCAD_ERROR)
+	bu_exit(1, "%s failed: %s\n", av[0], bu_vls_cstr(gedp->ged_result_str));
+}
+
+
+template <class V>
+static int
+map_cmp(DbiState *dbis, const char *step, const char *mname,
+	std::unordered_map<unsigned long long, V> &inc,
+	std::unordered_map<unsigned long long, V> &ref)
+{
+    int bad = 0;
+    typename std::unordered_map<unsigned long long, V>::iterator m_it;
+    for (m_it = inc.begin(); m_it != inc.end(); m_it++) {
+	typename std::unordered_map<unsigned long long, V>::iterator r_it = ref.find(m_it->first);
+	if (r_it == ref.end()) {
+	    bu_log("%s: %s has an extra entry for %s\n", step, mname, dbis->hashstr(m_it->first));
+	    bad++;
+	} else if (!(r_it->second == m_it->second)) {
+	    bu_log("%s: %s entry for %s differs\n", step, mname, dbis->hashstr(m_it->first));
+	    bad++;
+	}
+    }
+    for (m_it = ref.begin(); m_it != ref.end(); m_it++) {
+	if (inc.find(m_it->first) == inc.end()) {
+	    bu_log("%s: %s is missing the entry for %s\n", step, mname, dbis->hashstr(m_it->first));
+	    bad++;
+	}
+    }
+    return bad;
+}
+
+
+/* Bring the current DbiState up to date, then compare its comb maps with
+ * those of a DbiState built from scratch.  Only one DbiState is kept open
+ * at a time, since each holds the drawing cache for the file, so the new
+ * one takes over for the next step. */
+static int
+check(struct ged *gedp, const char *step)
+{
+    DbiState *inc = (DbiState *)gedp->dbi_state;
+    inc->update();
+
+    std::unordered_map<unsigned long long, std::vector<unsigned long long>> p_v = inc->p_v;
+    std::unordered_map<unsigned long long, unsigned long long> i_map = inc->i_map;
+    std::unordered_map<unsigned long long, std::string> invalid_entry_map = inc->invalid_entry_map;
+    delete inc;
+
+    DbiState *ref = new DbiState(gedp);
+    gedp->dbi_state = ref;
+
+    int bad = 0;
+    bad += map_cmp(ref, step, "p_v", p_v, ref->p_v);
+    bad += map_cmp(ref, step, "i_map", i_map, ref->i_map);
+    bad += map_cmp(ref, step, "invalid_entry_map", invalid_entry_map, ref->invalid_entry_map);
+    return bad;
+}
+
+
+int
+main(int ac, const char *av[])
+{
+    struct ged *gedp;
+    int bad = 0;
+
+    bu_setprogname(av[0]);
+
+    if (ac != 2) {
+	printf("Usage: %s file.g\n", av[0]);
+	return 1;
+    }
+
+    mk_model(av[1]);
+
+    gedp = ged_open("db", av[1], 1);
+    if (!gedp)
+	bu_exit(1, "unable to open %s\n", av[1]);
+    gedp->dbi_state = new DbiState(gedp);
+    db_add_changed_clbk(gedp->dbip, &dbi_test_changed, (void *)gedp);
+
+    /* Another instance of an already repeated child */
+    const char *comb_av[] = {"comb", "c1", "u", "s1"};
+    run_cmd(gedp, 4, comb_av);
+    bad += check(gedp, "add repeated child");
+
+    /* Remove every instance of it */
+    const char *rm_av[] = {"rm", "c1", "s1"};
+    run_cmd(gedp, 3, rm_av);
+    bad += check(gedp, "remove repeated child");
+
+    /* Kill a comb that is itself a repeated child, leaving invalid
+     * entries in its parent */
+    const char *kill_av[] = {"kill", "c1"};
+    run_cmd(gedp, 2, kill_av);
+    bad += check(gedp, "kill repeated comb");
+
+    /* Re-add it with different repeated children */
+    const char *readd_av[] = {"comb", "c1", "u", "s2", "u", "s2", "u", "s3"};
+    run_cmd(gedp, 8, readd_av);
+    bad += check(gedp, "re-add repeated comb");
+
+    /* Rename it away and back, which invalidates and then revalidates
+     * the references to it */
+    const char *mv_av[] = {"mv", "c1", "c1b"};
+    run_cmd(gedp, 3, mv_av);
+    bad += check(gedp, "rename repeated comb");
+    const char *mvb_av[] = {"mv", "c1b", "c1"};
+    run_cmd(gedp, 3, mvb_av);
+    bad += check(gedp, "rename repeated comb back");
+
+    /* Create and then remove the object behind a repeated invalid entry */
+    const char *make_av[] = {"make", "missing", "sph"};
+    run_cmd(gedp, 3, make_av);
+    bad += check(gedp, "create missing child");
+    const char *killm_av[] = {"kill", "missing"};
+    run_cmd(gedp, 2, killm_av);
+    bad += check(gedp, "kill missing child");
+
+    delete (DbiState *)gedp->dbi_state;
+    gedp->dbi_state = NULL;
+    ged_close(gedp);
+    bu_file_delete(av[1]);
+
+    if (bad) {
+	bu_log("DbiState incremental comb updates: %d mismatches [FAIL]\n", bad);
+	return 1;
+    }
+
+    bu_log("DbiState incremental comb updates [PASS]\n");
+    return 0;
+}
+
+
+// Local Variables:
+// tab-width: 8
+// mode: C++
+// c-basic-offset: 4
+// indent-tabs-mode: t
+// c-file-style: "stroustrup"
+// End:
+// ex: shiftwidth=4 tabstop=8
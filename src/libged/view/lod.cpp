@@ -28,9 +28,12 @@
 #include <stdlib.h>
 #include <ctype.h>
 #include <string.h>
+#include <condition_variable>
+#include <mutex>
 
 #include "bu/cmd.h"
 #include "bu/hash.h"
+#include "bu/parallel.h"
 #include "bu/str.h"
 #include "bu/time.h"
 #include "bu/vls.h"
@@ -39,6 +42,33 @@
 #include "../ged_private.h"
 #include "./ged_view.h"
 
+// BoT LoD caches are generated by the LoD context's worker threads.  Each
+// queued BoT holds its internal until its job is done, so only a limited
+// number are queued at once to keep the memory use down.
+struct lod_cache_state {
+    std::mutex lock;
+    std::condition_variable cv;
+    int pending = 0;
+};
+
+struct lod_cache_job {
+    struct rt_db_internal intern;
+    struct lod_cache_state *st;
+};
+
+static void
+lod_cache_done(unsigned long long UNUSED(key), void *data)
+{
+    struct lod_cache_job *j = (struct lod_cache_job *)data;
+    struct lod_cache_state *st = j->st;
+    rt_db_free_internal(&j->intern);
+    delete j;
+
+    std::lock_guard<std::mutex> lk(st->lock);
+    st->pending--;
+    st->cv.notify_all();
+}
+
 int
 _view_cmd_lod(void *bs, int argc, const char **argv)
 {
@@ -189,6 +219,8 @@ _view_cmd_lod(void *bs, int argc, const char **argv)
 
 	    int done = 0;
 	    int total = 0;
+	    struct lod_cache_state cst;
+	    int max_pending = 2 * bu_avail_cpus();
 	    for (int i = 0; i < RT_DBNHASH; i++) {
 		struct directory *dp;
 		for (dp = gedp->dbip->dbi_Head[i]; dp != RT_DIR_NULL; dp = dp->d_forw) {
@@ -211,27 +243,41 @@ _view_cmd_lod(void *bs, int argc, const char **argv)
 
 		    // No need to open up the internal unless it's a BoT or a BRep
 		    if (dp->d_minor_type == DB5_MINORTYPE_BRLCAD_BOT) {
-			struct rt_db_internal dbintern;
-			RT_DB_INTERNAL_INIT(&dbintern);
-			struct rt_db_internal *ip = &dbintern;
+			struct lod_cache_job *j = new lod_cache_job;
+			j->st = &cst;
+			RT_DB_INTERNAL_INIT(&j->intern);
+			struct rt_db_internal *ip = &j->intern;
 			int ret = rt_db_get_internal(ip, dp, gedp->dbip, NULL, &rt_uniresource);
-			if (ret < 0)
+			if (ret < 0) {
+			    delete j;
 			    continue;
+			}
 
 			if (ip->idb_minor_type != DB5_MINORTYPE_BRLCAD_BOT) {
-			    rt_db_free_internal(&dbintern);
+			    rt_db_free_internal(ip);
+			    delete j;
 			    continue;
 			}
 			done++;
-			struct bu_vls pname = BU_VLS_INIT_ZERO;
 			bu_log("Caching BoT %s (%d of %d)\n", dp->d_namep, done, total);
-			bu_vls_free(&pname);
 			struct rt_bot_internal *bot = (struct rt_bot_internal *)ip->idb_ptr;
 			RT_BOT_CK_MAGIC(bot);
-			key = bv_mesh_lod_cache(gedp->ged_lod, (const point_t *)bot->vertices, bot->num_vertices, NULL, bot->faces, bot->num_faces, 0, 0.66);
-			if (key)
-			    bv_mesh_lod_key_put(gedp->ged_lod, dp->d_namep, key);
-			rt_db_free_internal(&dbintern);
+
+			{
+			    std::unique_lock<std::mutex> lk(cst.lock);
+			    cst.cv.wait(lk, [&cst, max_pending]{ return cst.pending < max_pending; });
+			    cst.pending++;
+			}
+			ret = bv_mesh_lod_cache_bg(gedp->ged_lod, dp->d_namep, (const point_t *)bot->vertices, bot->num_vertices, NULL, bot->faces, bot->num_faces, 0.66, 0, &lod_cache_done, (void *)j);
+			if (ret != 1) {
+			    // Not queued, so lod_cache_done won't be called
+			    if (ret < 0) {
+				key = bv_mesh_lod_cache(gedp->ged_lod, (const point_t *)bot->vertices, bot->num_vertices, NULL, bot->faces, bot->num_faces, 0, 0.66);
+				if (key)
+				    bv_mesh_lod_key_put(gedp->ged_lod, dp->d_namep, key);
+			    }
+			    lod_cache_done(0, (void *)j);
+			}
 		    }
 
 		    if (dp->d_minor_type == DB5_MINORTYPE_BRLCAD_BREP) {
@@ -295,6 +341,12 @@ _view_cmd_lod(void *bs, int argc, const char **argv)
 		}
 	    }
 
+	    // Wait for the workers to finish the BoTs
+	    {
+		std::unique_lock<std::mutex> lk(cst.lock);
+		cst.cv.wait(lk, [&cst]{ return cst.pending == 0; });
+	    }
+
 	    elapsedtime = bu_gettime() - elapsedtime;
 	    {
 		int seconds = elapsedtime / 1000000;
@@ -22,19 +22,47 @@
  * This file contains routines for image filtering. This is done
  * mainly using the convolution of images. Both Gray Scale and RGB
  * images are taken care.
+ *
+ * icv_filter() works on bands of rows in parallel and in place.
+ * Each band keeps a three row window of the original data, so the
+ * working memory is a few rows per band rather than a second copy
+ * of the image.
  */
 
+#include "common.h"
+
+#include <string.h>
+
 #include "bu/log.h"
 #include "bu/malloc.h"
+#include "bu/parallel.h"
 #include "icv.h"
 
 #include "vmath.h"
 
 #define KERN_DEFAULT 3
 
+/* rows in a band handed to a thread at a time */
+#define FILTER_BAND_ROWS 64
+
+
+struct filter_state {
+    double *data;
+    size_t height;
+    size_t channels;
+    size_t widthstep;
+    double kern[KERN_DEFAULT*KERN_DEFAULT];
+    double offset;
+    size_t nbands;
+    double *edges;	/* original rows above and below each band */
+    int sem;
+    size_t curr;
+};
+
+
 /* private functions */
 
-static void
+static int
 get_kernel(ICV_FILTER filter_type, double *kern, double *offset)
 {
     switch (filter_type) {
@@ -82,13 +110,12 @@ get_kernel(ICV_FILTER filter_type, double *kern, double *offset)
 	    break;
 	default :
 	    bu_log("Filter Type not Implemented.\n");
-	    bu_free(kern, "Freeing Kernel, Wrong filter");
-	    kern = NULL;
+	    return -1;
     }
-    return;
+    return 0;
 }
 
-static void
+static int
 get_kernel3(ICV_FILTER3 filter_type, double *kern, double *offset)
 {
     switch (filter_type) {
@@ -154,10 +181,102 @@ get_kernel3(ICV_FILTER3 filter_type, double *kern, double *offset)
 	    break;
 	default :
 	    bu_log("Filter Type not Implemented.\n");
-	    bu_free(kern, "Freeing Kernel, Wrong filter");
-	    kern = NULL;
+	    return -1;
+    }
+    return 0;
+}
+
+/* Add the contribution of one source row to an output row.  Pixels
+ * off the ends of the row are zero.
+ */
+static void
+filter_row_add(double *out, const double *in, const double *k, size_t widthstep, size_t channels)
+{
+    size_t x;
+    size_t inner = (widthstep > channels) ? widthstep - channels : 0;
+
+    for (x = 0; x < channels && x < widthstep; x++) {
+	out[x] += k[1]*in[x];
+	if (x + channels < widthstep)
+	    out[x] += k[2]*in[x+channels];
+    }
+    for (x = channels; x < inner; x++)
+	out[x] += k[0]*in[x-channels] + k[1]*in[x] + k[2]*in[x+channels];
+    for (x = (inner > channels) ? inner : channels; x < widthstep; x++)
+	out[x] += k[0]*in[x-channels] + k[1]*in[x];
+}
+
+
+static void
+filter_band(struct filter_state *s, size_t b, double *win)
+{
+    size_t ws = s->widthstep;
+    size_t first = b*FILTER_BAND_ROWS;
+    size_t last = first + FILTER_BAND_ROWS;
+    double *rows[3];	/* original rows y-1, y and y+1, NULL if outside the image */
+    size_t y, x, r;
+
+    if (last > s->height)
+	last = s->height;
+
+    rows[0] = (first > 0) ? s->edges + 2*b*ws : NULL;
+    rows[1] = win;
+    rows[2] = win + ws;
+    VMOVEN(rows[1], s->data + first*ws, ws);
+
+    for (y = first; y < last; y++) {
+	double *out = s->data + y*ws;
+
+	/* fetch row y+1 before row y is overwritten */
+	if (y + 1 < last)
+	    VMOVEN(rows[2], s->data + (y+1)*ws, ws);
+	else if (y + 1 < s->height)
+	    rows[2] = s->edges + (2*b+1)*ws;
+	else
+	    rows[2] = NULL;
+
+	for (x = 0; x < ws; x++)
+	    out[x] = s->offset;
+	for (r = 0; r < 3; r++) {
+	    if (rows[r])
+		filter_row_add(out, rows[r], s->kern + r*KERN_DEFAULT, ws, s->channels);
+	}
+
+	/* slide the window, the next row goes in whichever of the
+	 * three buffers is no longer in use */
+	rows[0] = rows[1];
+	rows[1] = rows[2];
+	for (r = 0; r < 3; r++) {
+	    rows[2] = win + r*ws;
+	    if (rows[2] != rows[0] && rows[2] != rows[1])
+		break;
+	}
+    }
+}
+
+
+static void
+filter_worker(int UNUSED(cpu), void *data)
+{
+    struct filter_state *s = (struct filter_state *)data;
+    double *win = NULL;
+
+    while (1) {
+	size_t b;
+
+	bu_semaphore_acquire(s->sem);
+	b = s->curr++;
+	bu_semaphore_release(s->sem);
+	if (b >= s->nbands)
+	    break;
+
+	if (!win)
+	    win = (double *)bu_malloc(3*s->widthstep*sizeof(double), "icv_filter : row window");
+	filter_band(s, b, win);
     }
-    return;
+
+    if (win)
+	bu_free(win, "icv_filter : row window");
 }
 
 /* end of private functions */
@@ -167,75 +286,44 @@ get_kernel3(ICV_FILTER3 filter_type, double *kern, double *offset)
 int
 icv_filter(icv_image_t *img, ICV_FILTER filter_type)
 {
-    double *kern = NULL, *kern_p = NULL;
-    double c_val;
-    double *out_data, *in_data, *data_p;
-    double offset = 0;
-    size_t k_dim = KERN_DEFAULT, k_dim_half, k_dim_half_ceil;
-    size_t size;
-    size_t h, w, k, i;
-    size_t widthstep;
-    size_t index, n_index; /**< index is the index of the pixel in
-			      * out image and n_index corresponds to
-			      * the nearby pixel in input image
-			      */
+    struct filter_state s;
+    size_t b;
+
+    ICV_IMAGE_VAL_INT(img);
 
     /* TODO A new Functionality. Update the get_kernel function to
      * accommodate the generalized kernel length. This can be based
      * upon a library of filters or closed form definitions.
      */
-
-    ICV_IMAGE_VAL_INT(img);
-
-    kern = (double *)bu_malloc(k_dim*k_dim*sizeof(double), "icv_filter : Kernel Allocation");
-    get_kernel(filter_type, kern, &offset);
-
-    if (!kern)
+    if (get_kernel(filter_type, s.kern, &s.offset) < 0)
 	return -1;
 
-    widthstep = img->width*img->channels;
+    s.data = img->data;
+    s.height = img->height;
+    s.channels = img->channels;
+    s.widthstep = img->width*img->channels;
+    if (!s.height || !s.widthstep)
+	return 0;
 
-    in_data = img->data;
-    size = img->height*img->width*img->channels;
-    /* Replaces data pointer in place */
-    img->data = out_data = (double*)bu_malloc(size*sizeof(double), "icv_filter : out_image_data");
-
-    /* Kernel Dimension is always considered to be odd*/
-    k_dim_half = k_dim/2*img->channels;
-    k_dim_half_ceil = (k_dim - k_dim/2)*img->channels;
-    index = 0;
-    for (h = 0; h < img->height; h++) {
-	VMOVEN(out_data, in_data+index, k_dim_half);
-	out_data+=k_dim_half;
-
-	for (w = 0; w < widthstep - k_dim*img->channels; w++) {
-	    c_val = 0;
-	    kern_p = kern;
-
-	    for (k = 0; k <= k_dim; k++) {
-		n_index = index + (k-(k_dim/2))*widthstep;
-		data_p = in_data + n_index;
-		for (i = 0; i<=k_dim; i++) {
-		    /* Ensures that the arguments are given a zero value for
-		     * out of bound pixels. Thus behaves similar to zero padding
-		     */
-		    if (n_index < size) {
-			c_val += (*kern_p++)*(*data_p);
-			data_p += img->channels;
-			/* Ensures out bound in image */
-			n_index += img->channels;
-		    }
-		}
-	    }
-	    *out_data = c_val + offset;
-	    out_data++;
-	    index++;
-	}
-	index = (h+1)*widthstep;
-	VMOVEN(out_data,in_data+index -k_dim_half_ceil*img->channels,k_dim_half_ceil*img->channels );
-	out_data+= k_dim_half_ceil;
+    /* Save the rows just outside each band before any of them are
+     * overwritten, so bands can be filtered in place independently.
+     */
+    s.nbands = (s.height + FILTER_BAND_ROWS - 1) / FILTER_BAND_ROWS;
+    s.edges = (double *)bu_malloc(2*s.nbands*s.widthstep*sizeof(double), "icv_filter : band edges");
+    for (b = 0; b < s.nbands; b++) {
+	size_t first = b*FILTER_BAND_ROWS;
+	size_t last = first + FILTER_BAND_ROWS;
+	if (first > 0)
+	    VMOVEN(s.edges + 2*b*s.widthstep, s.data + (first-1)*s.widthstep, s.widthstep);
+	if (last < s.height)
+	    VMOVEN(s.edges + (2*b+1)*s.widthstep, s.data + last*s.widthstep, s.widthstep);
     }
-    bu_free(in_data, "icv:filter Input Image Data");
+
+    s.sem = bu_semaphore_register("ICV_FILTER_SEM");
+    s.curr = 0;
+    bu_parallel(filter_worker, (s.nbands < bu_avail_cpus()) ? s.nbands : 0, &s);
+
+    bu_free(s.edges, "icv_filter : band edges");
     return 0;
 }
 
@@ -271,10 +359,10 @@ icv_filter3(icv_image_t *old_img, icv_image_t *curr_img, icv_image_t *new_img, I
     }
 
     kern = (double *)bu_malloc(k_dim*k_dim*3*sizeof(double), "icv_filter3 : Kernel Allocation");
-    get_kernel3(filter_type, kern, &offset);
-
-    if (!kern)
+    if (get_kernel3(filter_type, kern, &offset) < 0) {
+	bu_free(kern, "icv_filter3 : Kernel");
 	return NULL;
+    }
 
     widthstep = old_img->width*old_img->channels;
 
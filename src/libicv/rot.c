@@ -47,6 +47,7 @@
 #include "bu/log.h"
 #include "bu/getopt.h"
 #include "bu/malloc.h"
+#include "bu/parallel.h"
 #include "bn.h"
 
 /* TODO: Yuck... why are we using globals for all this?? */
@@ -196,13 +197,67 @@ reverse_buffer(unsigned char *buf)
 }
 
 
+struct arbrot_state {
+    const unsigned char *in;
+    unsigned char *out;
+    double sina, cosa;
+    double x_goop, y_goop;
+    int sem;
+    ssize_t curr;
+};
+
+/* output scanlines handed to a thread at a time */
+#define ARBROT_BAND_ROWS 32
+
+
+static void
+arbrot_worker(int UNUSED(cpu), void *data)
+{
+    struct arbrot_state *s = (struct arbrot_state *)data;
+    ssize_t first, last, x, y;
+
+    while (1) {
+	bu_semaphore_acquire(s->sem);
+	first = s->curr;
+	s->curr += ARBROT_BAND_ROWS;
+	bu_semaphore_release(s->sem);
+	if (first >= nyin)
+	    return;
+	last = (first + ARBROT_BAND_ROWS < nyin) ? first + ARBROT_BAND_ROWS : nyin;
+
+	for (y = first; y < last; y++) {
+	    double x0 = - y * s->sina + s->x_goop;
+	    double y0 = y * s->cosa + s->y_goop;
+	    unsigned char *obp_r = s->out + y * scanbytes;
+
+	    for (x = 0; x < nxin; x++) {
+		/* computed from the row start rather than "forward
+		 * differenced", so error doesn't build up along the row */
+		double x2 = x0 + x * s->cosa;
+		double y2 = y0 + x * s->sina;
+		ssize_t xi = (ssize_t)floor(x2);
+		ssize_t yi = (ssize_t)floor(y2);
+
+		/* check for in bounds */
+		if (xi >= 0 && xi < nxin && yi >= 0 && yi < nyin)
+		    memcpy(obp_r, &s->in[(yi * nxin + xi) * pixbytes], pixbytes);
+		else
+		    memset(obp_r, 0, pixbytes);	/* XXX - settable color? */
+		obp_r += pixbytes;
+	    }
+	}
+    }
+}
+
+
 /*
  * Arbitrary angle rotation.
  *
  * 'a' is rotation angle
  *
  * Currently this needs to be able to buffer the entire image
- * in memory at one time.
+ * in memory at one time.  Output scanlines are independent of each
+ * other and are computed in parallel.
  *
  * To rotate a point (x, y) CCW about the origin:
  * x' = x cos(a) - y sin(a)
@@ -219,16 +274,14 @@ reverse_buffer(unsigned char *buf)
  * dx' = -sin(a)
  * dy' = cos(a)
  */
-static void
-arbrot(double a, FILE *ifp, unsigned char *buf)
+static int
+arbrot(double a, FILE *ifp, FILE *ofp, unsigned char *buf)
 {
 #define DtoR(x)	((x)*DEG2RAD)
-    size_t x, y;				/* working coord */
-    double x2, y2;				/* its rotated position */
+    struct arbrot_state s;
     double xc, yc;				/* rotation origin */
-    size_t x_min, y_min, x_max, y_max;		/* area to rotate */
-    double x_goop, y_goop;
-    double sina, cosa;
+    size_t nbands;
+    ssize_t wrote;
 
     if (buflines != nyin) {
 	/* I won't all fit in the buffer */
@@ -245,42 +298,30 @@ arbrot(double a, FILE *ifp, unsigned char *buf)
      * to their standard ones, the sign of the rotation is reversed.
      */
     a = -DtoR(a);
-    sina = sin(a);
-    cosa = cos(a);
+    s.sina = sin(a);
+    s.cosa = cos(a);
 
     /* XXX - Let the user pick the rotation origin? */
     xc = nxin / 2.0;
     yc = nyin / 2.0;
 
-    x_goop = xc - xc * cosa + yc * sina;
-    y_goop = yc - yc * cosa - xc * sina;
-
-    x_min = 0;
-    y_min = 0;
-    x_max = nxin;
-    y_max = nyin;
-
-    for (y = y_min; y < y_max; y++) {
-	x2 = x_min * cosa - y * sina + x_goop;
-	y2 = x_min * sina + y * cosa + y_goop;
-	for (x = x_min; x < x_max; x++) {
-	    /* check for in bounds */
-	    if (x2 > 0.0
-		&& ZERO(x2)
-		&& x2 < (double)nxin
-		&& y2 > 0.0
-		&& ZERO(y2)
-		&& y2 < (double)nyin)
-	    {
-		putchar(buf[(int)y2*nyin + (int)x2]);
-	    } else {
-		putchar(0);	/* XXX - settable color? */
-	    }
-	    /* "forward difference" our coordinates */
-	    x2 += cosa;
-	    y2 += sina;
-	}
+    s.x_goop = xc - xc * s.cosa + yc * s.sina;
+    s.y_goop = yc - yc * s.cosa - xc * s.sina;
+
+    s.in = buf;
+    s.out = (unsigned char *)bu_malloc((size_t)nyin * scanbytes, "arbrot out");
+    s.sem = bu_semaphore_register("ICV_ROT_SEM");
+    s.curr = 0;
+    nbands = (nyin + ARBROT_BAND_ROWS - 1) / ARBROT_BAND_ROWS;
+    bu_parallel(arbrot_worker, (nbands < bu_avail_cpus()) ? nbands : 0, &s);
+
+    wrote = fwrite(s.out, scanbytes, (size_t)nyin, ofp);
+    bu_free(s.out, "arbrot out");
+    if (wrote != nyin) {
+	perror("fwrite");
+	return 4;
     }
+    return 0;
 }
 
 
@@ -321,7 +362,7 @@ icv_rot(size_t argc, const char *argv[])
      * Break out to added arbitrary angle routine
      */
     if (angle > 0.0) {
-	arbrot(angle, ifp, buffer);
+	ret = arbrot(angle, ifp, ofp, buffer);
 	goto done;
     }
 
@@ -441,6 +482,8 @@ icv_rot(size_t argc, const char *argv[])
 
 done:
     fclose(ifp);
+    if (ofp != stdout)
+	fclose(ofp);
     bu_free(buffer, "buffer");
     bu_free(obuf, "obuf");
 
@@ -36,6 +36,7 @@
 #include "bu/log.h"
 #include "bu/malloc.h"
 #include "bu/mime.h"
+#include "bu/parallel.h"
 #include "bu/str.h"
 #include "bu/units.h"
 
@@ -366,108 +367,155 @@ under_sample(icv_image_t* bif, size_t factor)
 }
 
 
-static int
-ninterp(icv_image_t* bif, size_t out_width, size_t out_height)
-{
-    double xstep, ystep;
-    size_t i, j;
-    size_t x, y;
-    size_t widthstep;
-    double *in_r, *in_c; /* Pointer to row and col of input buffers */
-    double *out_data, *out_p;
-    xstep = (double)(bif->width-1) / (double)(out_width) - 1.0e-06;
-    ystep = (double)(bif->height-1) / (double)(out_height) - 1.0e-06;
-
-    if ((xstep < 1.0 && ystep > 1.0) || (xstep > 1.0 && ystep < 1.0)) {
-	bu_log("Operation unsupported.  Cannot stretch one dimension while compressing the other.\n");
-	return -1;
-    }
+/* Interpolated resizes compute each output row from at most two input
+ * rows, so rows are handed out to threads in bands.  The column
+ * positions are the same for every row and are computed once.
+ */
+struct interp_state {
+    const double *in;
+    double *out;
+    size_t channels;
+    size_t widthstep;	/* input */
+    size_t out_width;
+    size_t out_height;
+    size_t last_row;	/* input */
+    double ystep;
+    size_t *col;	/* input offset of the left sample for each output column */
+    double *dx;		/* fraction towards the right sample */
+    size_t right;	/* offset from the left to the right sample */
+    int sem;
+    size_t curr;
+};
 
-    out_p = out_data = (double *)bu_malloc(out_width*out_height*bif->channels*sizeof(double), "ninterp : out_data");
+/* output rows handed to a thread at a time */
+#define INTERP_BAND_ROWS 32
 
-    widthstep= bif->width*bif->channels;
 
-    for (j = 0; j < out_height; j++) {
-	y = (int)(j*ystep);
-	in_r = bif->data + y*widthstep;
+static int
+interp_next_band(struct interp_state *s, size_t *first, size_t *last)
+{
+    bu_semaphore_acquire(s->sem);
+    *first = s->curr;
+    s->curr += INTERP_BAND_ROWS;
+    bu_semaphore_release(s->sem);
+    if (*first >= s->out_height)
+	return 0;
+    *last = (*first + INTERP_BAND_ROWS < s->out_height) ? *first + INTERP_BAND_ROWS : s->out_height;
+    return 1;
+}
+
 
-	for (i = 0; i < out_width; i++) {
-	    x = (int)(i*xstep);
+static void
+ninterp_worker(int UNUSED(cpu), void *data)
+{
+    struct interp_state *s = (struct interp_state *)data;
+    size_t first, last, i, j;
 
-	    in_c = in_r + x*bif->channels;
+    while (interp_next_band(s, &first, &last)) {
+	for (j = first; j < last; j++) {
+	    const double *in_r = s->in + (size_t)(j*s->ystep)*s->widthstep;
+	    double *out_p = s->out + j*s->out_width*s->channels;
 
-	    VMOVEN(out_p, in_c, bif->channels);
-	    out_p += bif->channels;
+	    for (i = 0; i < s->out_width; i++, out_p += s->channels)
+		VMOVEN(out_p, in_r + s->col[i], s->channels);
 	}
     }
+}
 
-    bu_free(bif->data, "ninterp : in_data");
-
-    bif->data = out_data;
-
-    bif->width = out_width;
-    bif->height = out_height;
-
-    return 0;
 
+static void
+binterp_worker(int UNUSED(cpu), void *data)
+{
+    struct interp_state *s = (struct interp_state *)data;
+    size_t nc = s->channels;
+    size_t first, last, i, j, c;
+
+    while (interp_next_band(s, &first, &last)) {
+	for (j = first; j < last; j++) {
+	    double y = j*s->ystep;
+	    size_t low = (size_t)y;
+	    size_t upp = (low < s->last_row) ? low + 1 : low;
+	    double dy = y - low;
+	    const double *low_r = s->in + s->widthstep*low;
+	    const double *upp_r = s->in + s->widthstep*upp;
+	    double *out_p = s->out + j*s->out_width*nc;
+
+	    for (i = 0; i < s->out_width; i++) {
+		const double *low_c = low_r + s->col[i];
+		const double *upp_c = upp_r + s->col[i];
+		double dx = s->dx[i];
+		size_t r = s->right;
+
+		for (c = 0; c < nc; c++) {
+		    double mid1 = low_c[c] + dx * (low_c[c+r] - low_c[c]);
+		    double mid2 = upp_c[c] + dx * (upp_c[c+r] - upp_c[c]);
+		    out_p[c] = mid1 + dy * (mid2 - mid1);
+		}
+		out_p += nc;
+	    }
+	}
+    }
 }
 
 
 static int
-binterp(icv_image_t *bif, size_t out_width, size_t out_height)
+interp(icv_image_t *bif, size_t out_width, size_t out_height, int bilinear)
 {
-    size_t i, j;
-    size_t c;
-    double x, y, dx, dy, mid1, mid2;
+    struct interp_state s;
     double xstep, ystep;
-    double *out_data, *out_p;
-    double *upp_r, *low_r; /* upper and lower row */
-    double *upp_c, *low_c;
-    size_t widthstep;
+    size_t i, nbands;
 
+    if (!out_width || !out_height) {
+	bu_log("Cannot interpolate to an empty image.\n");
+	return -1;
+    }
+
+    /* The small bias keeps the last sample inside the image.  A one
+     * pixel wide (or tall) input, or a big enough enlargement, would
+     * take the step below zero - there is only the one column (or
+     * row) to sample in that case.
+     */
     xstep = (double)(bif->width - 1) / (double)out_width - 1.0e-6;
-    ystep = (double)(bif->height -1) / (double)out_height - 1.0e-6;
+    ystep = (double)(bif->height - 1) / (double)out_height - 1.0e-6;
+    xstep = (xstep < 0.0) ? 0.0 : xstep;
+    ystep = (ystep < 0.0) ? 0.0 : ystep;
 
-    if ((xstep < 1.0 && ystep > 1.0) || (xstep > 1.0 && ystep < 1.0)) {
+    /* A single column or row can't be compressed, so only check images
+     * that have some extent in both directions */
+    if (bif->width > 1 && bif->height > 1 && ((xstep < 1.0 && ystep > 1.0) || (xstep > 1.0 && ystep < 1.0))) {
 	bu_log("Operation unsupported.  Cannot stretch one dimension while compressing the other.\n");
 	return -1;
     }
 
-    out_p = out_data = (double *)bu_malloc(out_width*out_height*bif->channels*sizeof(double), "binterp : out data");
-
-    widthstep = bif->width*bif->channels;
-
-    for (j = 0; j < out_height; j++) {
-	y = j*ystep;
-	dy = y - (int)y;
-
-	low_r = bif->data + widthstep* (int)y;
-	upp_r = bif->data + widthstep* (int)(y+1);
-
-	for (i = 0; i < out_width; i++) {
-	    x = i*xstep;
-	    dx = x - (int)x;
-
-	    upp_c = upp_r + (int)x*bif->channels;
-	    low_c = low_r + (int)x*bif->channels;
+    s.in = bif->data;
+    s.out = (double *)bu_malloc(out_width*out_height*bif->channels*sizeof(double), "interp : out data");
+    s.channels = bif->channels;
+    s.widthstep = bif->width*bif->channels;
+    s.out_width = out_width;
+    s.out_height = out_height;
+    s.last_row = bif->height - 1;
+    s.ystep = ystep;
+    s.right = (bif->width > 1) ? bif->channels : 0;
+    s.col = (size_t *)bu_malloc(out_width*sizeof(size_t), "interp : columns");
+    s.dx = (double *)bu_malloc(out_width*sizeof(double), "interp : column fractions");
+    for (i = 0; i < out_width; i++) {
+	double x = i*xstep;
+	s.col[i] = (size_t)x*bif->channels;
+	s.dx[i] = x - (size_t)x;
+    }
 
-	    for (c = 0; c < bif->channels; c++) {
-		mid1 = low_c[0] + dx * ((double)low_c[bif->channels] - (double)low_c[0]);
-		mid2 = upp_c[0] + dx * ((double)upp_c[bif->channels] - (double)upp_c[0]);
-		*out_p = mid1 + dy * (mid2 - mid1);
+    s.sem = bu_semaphore_register("ICV_INTERP_SEM");
+    s.curr = 0;
+    nbands = (out_height + INTERP_BAND_ROWS - 1) / INTERP_BAND_ROWS;
+    bu_parallel(bilinear ? binterp_worker : ninterp_worker, (nbands < bu_avail_cpus()) ? nbands : 0, &s);
 
-		out_p++;
-		upp_c++;
-		low_c++;
-	    }
-	}
-    }
-    bu_free(bif->data, "binterp : Input Data");
-    bif->data = out_data;
+    bu_free(s.dx, "interp : column fractions");
+    bu_free(s.col, "interp : columns");
+    bu_free(bif->data, "interp : in data");
+    bif->data = s.out;
     bif->width = out_width;
     bif->height = out_height;
     return 0;
-
 }
 
 
@@ -482,9 +530,9 @@ icv_resize(icv_image_t *bif, ICV_RESIZE_METHOD method, size_t out_width, size_t
 	case ICV_RESIZE_SHRINK :
 	    return shrink_image(bif, factor);
 	case ICV_RESIZE_NINTERP :
-	    return ninterp(bif, out_width, out_height);
+	    return interp(bif, out_width, out_height, 0);
 	case ICV_RESIZE_BINTERP :
-	    return binterp(bif, out_width, out_height);
+	    return interp(bif, out_width, out_height, 1);
 	default :
 	    bu_log("icv_resize : Invalid Option to resize");
 	    return -1;
@@ -0,0 +1,235 @@
+/*                        N A R R O W . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file narrow.c
+ *
+ * Filter, resize and rotate images that are a single pixel wide or
+ * tall, checking the results against what the one row or column of
+ * input allows.
+ *
+ */
+
+#include "common.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "bu/app.h"
+#include "bu/file.h"
+#include "bu/log.h"
+#include "bu/malloc.h"
+#include "vmath.h"
+#include "icv.h"
+
+
+#define NARROW_LEN 100
+#define ROT_IN "icv_narrow_in.bw"
+#define ROT_OUT "icv_narrow_out.bw"
+
+
+/* ICV_FILTER_LOW_PASS */
+static const double low_pass[9] = {
+    3.0/42.0, 5.0/42.0, 3.0/42.0,
+    5.0/42.0, 10.0/42.0, 5.0/42.0,
+    3.0/42.0, 5.0/42.0, 3.0/42.0
+};
+
+
+static icv_image_t *
+mk_image(size_t width, size_t height)
+{
+    icv_image_t *img = icv_create(width, height, ICV_COLOR_SPACE_RGB);
+    size_t i;
+
+    for (i = 0; i < width*height*img->channels; i++)
+	img->data[i] = (double)((i * 37) % 101) / 100.0;
+    return img;
+}
+
+
+/* Straightforward zero padded 3x3 convolution */
+static double
+ref_filter(const icv_image_t *img, size_t x, size_t y, size_t c)
+{
+    double v = 0.0;
+    int r, k;
+
+    for (r = -1; r <= 1; r++) {
+	for (k = -1; k <= 1; k++) {
+	    long xx = (long)x + k;
+	    long yy = (long)y + r;
+	    if (xx < 0 || yy < 0 || xx >= (long)img->width || yy >= (long)img->height)
+		continue;
+	    v += low_pass[3*(r+1) + (k+1)] * img->data[(yy*img->width + xx)*img->channels + c];
+	}
+    }
+    return v;
+}
+
+
+static int
+check_filter(size_t width, size_t height)
+{
+    icv_image_t *in = mk_image(width, height);
+    icv_image_t *out = mk_image(width, height);
+    size_t x, y, c;
+    int bad = 0;
+
+    if (icv_filter(out, ICV_FILTER_LOW_PASS) < 0) {
+	bu_log("filter %zux%zu: failed\n", width, height);
+	bad = 1;
+    }
+
+    for (y = 0; !bad && y < height; y++) {
+	for (x = 0; !bad && x < width; x++) {
+	    for (c = 0; c < in->channels; c++) {
+		double ref = ref_filter(in, x, y, c);
+		double v = out->data[(y*width + x)*out->channels + c];
+		if (!NEAR_EQUAL(v, ref, 1.0e-12)) {
+		    bu_log("filter %zux%zu: pixel %zu,%zu channel %zu is %g, expected %g\n", width, height, x, y, c, v, ref);
+		    bad = 1;
+		    break;
+		}
+	    }
+	}
+    }
+
+    icv_destroy(in);
+    icv_destroy(out);
+    return bad;
+}
+
+
+/* A single column (or row) of input can only produce output rows (or
+ * columns) that are copies of each other, with values from the input */
+static int
+check_resize(size_t width, size_t height, ICV_RESIZE_METHOD method, size_t out_width, size_t out_height)
+{
+    icv_image_t *img = mk_image(width, height);
+    size_t nc = img->channels;
+    size_t x, y, c;
+    int bad = 0;
+
+    if (icv_resize(img, method, out_width, out_height, 0) < 0) {
+	bu_log("resize %zux%zu -> %zux%zu: failed\n", width, height, out_width, out_height);
+	icv_destroy(img);
+	return 1;
+    }
+    if (img->width != out_width || img->height != out_height) {
+	bu_log("resize %zux%zu -> %zux%zu: got %zux%zu\n", width, height, out_width, out_height, img->width, img->height);
+	icv_destroy(img);
+	return 1;
+    }
+
+    for (y = 0; !bad && y < out_height; y++) {
+	for (x = 0; !bad && x < out_width; x++) {
+	    const double *p = &img->data[(y*out_width + x)*nc];
+	    const double *q = (width == 1) ? &img->data[y*out_width*nc] : &img->data[x*nc];
+	    for (c = 0; c < nc; c++) {
+		if (!(p[c] >= 0.0 && p[c] <= 1.0) || !EQUAL(p[c], q[c])) {
+		    bu_log("resize %zux%zu -> %zux%zu: pixel %zu,%zu channel %zu is %g\n", width, height, out_width, out_height, x, y, c, p[c]);
+		    bad = 1;
+		    break;
+		}
+	    }
+	}
+    }
+
+    icv_destroy(img);
+    return bad;
+}
+
+
+/* Rotating a line of pixels must still give an image of the same size */
+static int
+check_rot(size_t width, size_t height)
+{
+    unsigned char buf[NARROW_LEN];
+    char w[32], n[32];
+    const char *av[] = {"icv_rot", "-a", "30", "-w", w, "-n", n, "-o", ROT_OUT, ROT_IN};
+    FILE *fp;
+    size_t i;
+    int bad = 0;
+
+    for (i = 0; i < width*height; i++)
+	buf[i] = (unsigned char)(i + 1);
+    fp = fopen(ROT_IN, "wb");
+    if (!fp || fwrite(buf, 1, width*height, fp) != width*height)
+	bu_exit(1, "unable to write %s\n", ROT_IN);
+    fclose(fp);
+
+    snprintf(w, sizeof(w), "%zu", width);
+    snprintf(n, sizeof(n), "%zu", height);
+    if (icv_rot(sizeof(av)/sizeof(av[0]), av)) {
+	bu_log("rotate %zux%zu: failed\n", width, height);
+	bad = 1;
+    } else if (bu_file_size(ROT_OUT) != (int)(width*height)) {
+	bu_log("rotate %zux%zu: output is %d bytes\n", width, height, bu_file_size(ROT_OUT));
+	bad = 1;
+    }
+
+    bu_file_delete(ROT_IN);
+    bu_file_delete(ROT_OUT);
+    return bad;
+}
+
+
+int
+main(int UNUSED(argc), const char *argv[])
+{
+    int bad = 0;
+
+    bu_setprogname(argv[0]);
+
+    bad += check_filter(1, 1);
+    bad += check_filter(1, NARROW_LEN);
+    bad += check_filter(NARROW_LEN, 1);
+
+    bad += check_resize(1, NARROW_LEN, ICV_RESIZE_NINTERP, 3, 2*NARROW_LEN);
+    bad += check_resize(1, NARROW_LEN, ICV_RESIZE_BINTERP, 3, 2*NARROW_LEN);
+    bad += check_resize(1, NARROW_LEN, ICV_RESIZE_NINTERP, 1, NARROW_LEN/4);
+    bad += check_resize(1, NARROW_LEN, ICV_RESIZE_BINTERP, 1, NARROW_LEN/4);
+    bad += check_resize(NARROW_LEN, 1, ICV_RESIZE_NINTERP, 2*NARROW_LEN, 3);
+    bad += check_resize(NARROW_LEN, 1, ICV_RESIZE_BINTERP, 2*NARROW_LEN, 3);
+    bad += check_resize(NARROW_LEN, 1, ICV_RESIZE_NINTERP, NARROW_LEN/4, 1);
+    bad += check_resize(NARROW_LEN, 1, ICV_RESIZE_BINTERP, NARROW_LEN/4, 1);
+
+    bad += check_rot(1, NARROW_LEN);
+    bad += check_rot(NARROW_LEN, 1);
+
+    if (bad) {
+	bu_log("single pixel wide/tall images [FAIL]\n");
+	return 1;
+    }
+
+    bu_log("single pixel wide/tall images [PASS]\n");
+    return 0;
+}
+
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
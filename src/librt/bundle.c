@@ -31,6 +31,9 @@
 
 #include "librt_private.h"
 
+/* rays handed to rt_bot_shot_packet() at a time */
+#define BUNDLE_BOT_PACKET_SIZE 8
+
 
 /* book-keeping structure so rt_shootrays can keep track of which rays
  * have completed without without semaphore-locking.
@@ -41,6 +44,93 @@ struct shootrays_data {
 };
 
 
+/**
+ * Shoot the rays of a bundle at a BoT as ray packets.  Rays are pruned
+ * against the BoT's bounding RPP and the backing distance just as the
+ * per-ray loop in rt_shootray_bundle() does, and only the segments of
+ * the first ray (in bundle order) that hits are kept.  Returns 1 on a
+ * hit.
+ */
+static int
+bundle_shoot_bot(struct soltab *stp, struct rt_shootray_status *ssp, struct xray *rays, int nrays, struct seg *waiting_segs)
+{
+    struct application *ap = ssp->ap;
+    struct resource *resp = ssp->resp;
+    const int debug_shoot = RT_G_DEBUG & RT_DEBUG_SHOOT;
+    struct xray newrays[BUNDLE_BOT_PACKET_SIZE];
+    struct xray *rayp[BUNDLE_BOT_PACKET_SIZE];
+    struct seg seghead[BUNDLE_BOT_PACKET_SIZE];
+    int ray[BUNDLE_BOT_PACKET_SIZE];
+    int ret[BUNDLE_BOT_PACKET_SIZE];
+    int next = 0;
+    int i;
+
+    while (next < nrays) {
+	int n = 0;
+	int hit = -1;
+
+	/* gather the next packet of rays that reach the BoT */
+	for (; next < nrays && n < BUNDLE_BOT_PACKET_SIZE; next++) {
+	    struct xray *rp = &newrays[n];
+
+	    /* Be compatible with the ss backing distance stuff */
+	    *rp = rays[next]; /* struct copy */
+	    VJOIN1(rp->r_pt, rays[next].r_pt, ssp->dist_corr, rp->r_dir);
+
+	    if (!rt_in_rpp(rp, ssp->inv_dir, stp->st_min, stp->st_max)) {
+		if (debug_shoot)bu_log("rpp miss %s by ray %d\n", stp->st_name, next);
+		resp->re_prune_solrpp++;
+		continue;	/* MISS */
+	    }
+	    if (ssp->dist_corr + rp->r_max < BACKING_DIST) {
+		if (debug_shoot)bu_log("rpp skip %s, dist_corr=%g, r_max=%g, by ray %d\n", stp->st_name, ssp->dist_corr, rp->r_max, next);
+		resp->re_prune_solrpp++;
+		continue;	/* MISS */
+	    }
+
+	    rayp[n] = rp;
+	    ray[n] = next;
+	    BU_LIST_INIT(&(seghead[n].l));
+	    n++;
+	}
+	if (n == 0)
+	    break;
+
+	resp->re_shots += n;
+	rt_bot_shot_packet(stp, rayp, n, ap, seghead, ret);
+
+	for (i = 0; i < n; i++) {
+	    struct seg *s2;
+
+	    if (ret[i] <= 0 || hit >= 0) {
+		RT_FREE_SEG_LIST(&seghead[i], resp);
+		continue;
+	    }
+	    hit = i;
+
+	    /* Add seg chain to list awaiting rt_boolweave() */
+	    while (BU_LIST_WHILE(s2, seg, &(seghead[i].l))) {
+		BU_LIST_DEQUEUE(&(s2->l));
+		/* Restore to original distance */
+		s2->seg_in.hit_dist += ssp->dist_corr;
+		s2->seg_out.hit_dist += ssp->dist_corr;
+		s2->seg_in.hit_rayp = s2->seg_out.hit_rayp = &rays[ray[i]];
+		BU_LIST_INSERT(&(waiting_segs->l), &(s2->l));
+	    }
+	}
+
+	if (hit >= 0) {
+	    resp->re_shot_miss += hit;
+	    resp->re_shot_hit++;
+	    return 1;
+	}
+	resp->re_shot_miss += n;
+    }
+
+    return 0;
+}
+
+
 /**
  * Note that the direction vector r_dir must have unit length; this is
  * mandatory, and is not ordinarily checked, in the name of
@@ -307,6 +397,13 @@ rt_shootray_bundle(struct application *ap, struct xray *rays, int nrays)
 	    /* XXX open issue: entering neighboring cells too? */
 	    BU_BITSET(solidbits, stp->st_bit);
 
+	    if (stp->st_meth == &OBJ[ID_BOT]) {
+		/* BoTs traverse their BVH once per packet of rays */
+		if (debug_shoot)bu_log("shooting %s with %d ray packets\n", stp->st_name, nrays);
+		(void)bundle_shoot_bot(stp, &ss, rays, nrays, &waiting_segs);
+		continue;
+	    }
+
 	    for (ray=0; ray < nrays; ray++) {
 		struct xray ss2_newray;
 		int ret;
@@ -316,7 +413,7 @@ rt_shootray_bundle(struct application *ap, struct xray *rays, int nrays)
 		VJOIN1(ss2_newray.r_pt, rays[ray].r_pt, ss.dist_corr, ss2_newray.r_dir);
 
 		/* Check against bounding RPP, if desired by solid */
-		if (OBJ[stp->st_id].ft_use_rpp) {
+		if (stp->st_meth->ft_use_rpp) {
 		    if (!rt_in_rpp(&ss2_newray, ss.inv_dir,
 				   stp->st_min, stp->st_max)) {
 			if (debug_shoot)bu_log("rpp miss %s by ray %d\n", stp->st_name, ray);
@@ -336,8 +433,8 @@ rt_shootray_bundle(struct application *ap, struct xray *rays, int nrays)
 		BU_LIST_INIT(&(new_segs.l));
 
 		ret = -1;
-		if (OBJ[stp->st_id].ft_shot) {
-		    ret = OBJ[stp->st_id].ft_shot(stp, &ss2_newray, ap, &new_segs);
+		if (stp->st_meth->ft_shot) {
+		    ret = stp->st_meth->ft_shot(stp, &ss2_newray, ap, &new_segs);
 		}
 		if (ret <= 0) {
 		    resp->re_shot_miss++;
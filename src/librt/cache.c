@@ -221,19 +221,20 @@ cache_generate_name(char name[STATIC_ARRAY(37)], const struct soltab *stp)
     if (bu_uuid_create(namespace_uuid, sizeof(mat_buffer), mat_buffer, base_namespace_uuid) != 5)
 	return 0; /*bu_bomb("bu_uuid_create() failed");*/
 
-    if (db_get_external(&raw_external, stp->st_dp, stp->st_rtip->rti_dbip))
+    if (db_get_external_view(&raw_external, stp->st_dp, stp->st_rtip->rti_dbip))
 	return 0; /*bu_bomb("db_get_external() failed");*/
 
-    if (db5_get_raw_internal_ptr(&raw_internal, raw_external.ext_buf) == NULL)
-	return 0; /*bu_bomb("rt_db_external5_to_internal5() failed");*/
-
-    if (bu_uuid_create(uuid, raw_internal.body.ext_nbytes, raw_internal.body.ext_buf, namespace_uuid) != 5)
+    if (db5_get_raw_internal_ptr(&raw_internal, raw_external.ext_buf) == NULL
+	|| bu_uuid_create(uuid, raw_internal.body.ext_nbytes, raw_internal.body.ext_buf, namespace_uuid) != 5) {
+	db_free_external_view(&raw_external, stp->st_rtip->rti_dbip);
 	return 0; /*bu_bomb("bu_uuid_create() failed");*/
+    }
+
+    db_free_external_view(&raw_external, stp->st_rtip->rti_dbip);
 
     if (bu_uuid_encode(uuid, (uint8_t *)name))
 	return 0; /*bu_bomb("bu_uuid_encode() failed");*/
 
-    bu_free_external(&raw_external);
     return 1;
 }
 
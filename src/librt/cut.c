@@ -49,6 +49,8 @@
 #include "bg/plane.h"
 #include "bv/plot3.h"
 
+#include "./cut_hlbvh.h"
+
 
 static int rt_ck_overlap(const vect_t min, const vect_t max, const struct soltab *stp, const struct rt_i *rtip);
 static int rt_ct_box(struct rt_i *rtip, union cutter *cutp, int axis, double where, int force);
@@ -65,6 +67,9 @@ static int rt_ct_old_assess(register union cutter *, register int, double *, dou
 
 #define AXIS(depth)	((depth)%3)	/* cuts: X, Y, Z, repeat */
 
+/* max # of solids in a scene HLBVH leaf */
+#define RT_CUT_BVH_MAX_PRIMS_IN_NODE 4
+
 
 /**
  * Process all the nodes in the global array rtip->rti_cuts_waiting,
@@ -274,6 +279,15 @@ rt_cut_it(register struct rt_i *rtip, int UNUSED(ncpu))
 		bu_log("split_mostly_empty_cells(): split %zu cells\n", num_splits);
 	    }
 
+	    break; }
+	case RT_PART_HLBVH: {
+	    /* The cut tree is left as the single box holding every
+	     * solid, which keeps the backing distance search and the
+	     * reprep bookkeeping working unchanged.  rt_shootray()
+	     * walks the HLBVH instead of the box list.
+	     */
+	    rtip->rti_CutHead = *finp;	/* union copy */
+	    rt_cut_bvh(rtip);
 	    break; }
 	default:
 	    bu_bomb("rt_cut_it: unknown space partitioning method\n");
@@ -310,6 +324,256 @@ rt_cut_it(register struct rt_i *rtip, int UNUSED(ncpu))
 }
 
 
+void
+rt_cut_bvh_free(struct rt_i *rtip)
+{
+    RT_CK_RTI(rtip);
+
+    if (rtip->rti_bvh_nodes)
+	bu_free(rtip->rti_bvh_nodes, "bvh flat nodes");
+    if (rtip->rti_bvh_solids)
+	bu_free(rtip->rti_bvh_solids, "rti_bvh_solids");
+    rtip->rti_bvh_nodes = NULL;
+    rtip->rti_bvh_solids = NULL;
+    rtip->rti_bvh_nsolids = 0;
+    rtip->rti_bvh_nnodes = 0;
+    rtip->rti_bvh_nrefit = 0;
+}
+
+
+void
+rt_cut_bvh(struct rt_i *rtip)
+{
+    struct soltab *stp;
+    struct soltab **solids;
+    struct bu_pool *pool;
+    struct bvh_build_node *build_root;
+    fastf_t *centroids;
+    fastf_t *bounds;
+    long nodes_created = 0;
+    long *ordered_solids = NULL;
+    size_t nsol = 0;
+    size_t i;
+
+    RT_CK_RTI(rtip);
+
+    rt_cut_bvh_free(rtip);
+
+    if (rtip->rti_space_partition != RT_PART_HLBVH)
+	return;
+
+    /* Dead solids failed prep and infinite solids can not be bounded,
+     * those are shot from rti_inf_box instead.  Solids using pieces
+     * are shot from the piece list of rti_CutHead, so like the other
+     * cutters leave them out of the box list.
+     */
+    RT_VISIT_ALL_SOLTABS_START(stp, rtip) {
+	if (stp->st_aradius <= 0 || stp->st_aradius >= INFINITY) continue;
+	if (stp->st_npieces > 0) continue;
+	nsol++;
+    } RT_VISIT_ALL_SOLTABS_END;
+
+    if (nsol == 0)
+	return;
+
+    solids = (struct soltab **)bu_calloc(nsol, sizeof(struct soltab *), "rt_cut_bvh solids");
+    centroids = (fastf_t *)bu_malloc(nsol * sizeof(fastf_t) * 3, "rt_cut_bvh centroids");
+    bounds = (fastf_t *)bu_malloc(nsol * sizeof(fastf_t) * 6, "rt_cut_bvh bounds");
+
+    i = 0;
+    RT_VISIT_ALL_SOLTABS_START(stp, rtip) {
+	if (stp->st_aradius <= 0 || stp->st_aradius >= INFINITY) continue;
+	if (stp->st_npieces > 0) continue;
+	solids[i] = stp;
+	VMOVE(&bounds[i*6+0], stp->st_min);
+	VMOVE(&bounds[i*6+3], stp->st_max);
+	VADD2SCALE(&centroids[i*3], stp->st_min, stp->st_max, 0.5);
+	i++;
+    } RT_VISIT_ALL_SOLTABS_END;
+
+    pool = hlbvh_init_pool(nsol);
+    build_root = hlbvh_create(RT_CUT_BVH_MAX_PRIMS_IN_NODE, pool, centroids, bounds,
+			      &nodes_created, (long)nsol, &ordered_solids);
+    bu_free(centroids, "rt_cut_bvh centroids");
+    bu_free(bounds, "rt_cut_bvh bounds");
+
+    rtip->rti_bvh_nodes = hlbvh_flatten(build_root, nodes_created);
+    bu_pool_delete(pool);
+
+    /* Leaves reference runs of solids by offset, so store the
+     * soltabs in leaf order.
+     */
+    rtip->rti_bvh_solids = (struct soltab **)bu_calloc(nsol, sizeof(struct soltab *), "rti_bvh_solids");
+    for (i = 0; i < nsol; i++)
+	rtip->rti_bvh_solids[i] = solids[ordered_solids[i]];
+    rtip->rti_bvh_nsolids = nsol;
+    rtip->rti_bvh_nnodes = (size_t)nodes_created;
+
+    bu_free(ordered_solids, "ordered solids");
+    bu_free(solids, "rt_cut_bvh solids");
+
+    if (RT_G_DEBUG&RT_DEBUG_CUT) {
+	bu_log("HLBVH: %zu nodes over %zu solids (%.2f KB)\n",
+	       rtip->rti_bvh_nnodes, rtip->rti_bvh_nsolids,
+	       (double)(sizeof(struct bvh_flat_node) * rtip->rti_bvh_nnodes) / 1024.0);
+    }
+}
+
+
+void
+cut_bvh_remove(struct rt_i *rtip, const struct soltab *stp)
+{
+    size_t i;
+
+    for (i = 0; i < rtip->rti_bvh_nsolids; i++) {
+	if (rtip->rti_bvh_solids[i] == stp)
+	    rtip->rti_bvh_solids[i] = NULL;
+    }
+}
+
+
+/* Growth of the surface area of bounds if it is extended to hold
+ * [min, max].
+ */
+static fastf_t
+cut_bvh_area_growth(const fastf_t *bounds, const vect_t min, const vect_t max)
+{
+    vect_t lo, hi, d, e;
+
+    VMOVE(lo, &bounds[0]);
+    VMOVE(hi, &bounds[3]);
+    VSUB2(d, hi, lo);
+    VMIN(lo, min);
+    VMAX(hi, max);
+    VSUB2(e, hi, lo);
+
+    return (e[X]*e[Y] + e[Y]*e[Z] + e[Z]*e[X]) - (d[X]*d[Y] + d[Y]*d[Z] + d[Z]*d[X]);
+}
+
+
+/* Put stp in a freed slot of the leaf whose bounds grow the least.
+ * Returns 0 if there is no free slot.
+ */
+static int
+cut_bvh_insert(struct rt_i *rtip, struct soltab *stp)
+{
+    struct bvh_flat_node *node;
+    struct bvh_flat_node *best = NULL;
+    long best_slot = -1;
+    fastf_t best_growth = INFINITY;
+
+    for (node = rtip->rti_bvh_nodes; node < rtip->rti_bvh_nodes + rtip->rti_bvh_nnodes; node++) {
+	long i, slot = -1;
+	fastf_t growth;
+
+	if (node->n_primitives <= 0)
+	    continue;
+	for (i = 0; i < node->n_primitives && slot < 0; i++) {
+	    if (!rtip->rti_bvh_solids[node->data.first_prim_offset + i])
+		slot = node->data.first_prim_offset + i;
+	}
+	if (slot < 0)
+	    continue;
+	growth = cut_bvh_area_growth(node->bounds, stp->st_min, stp->st_max);
+	if (growth < best_growth) {
+	    best_growth = growth;
+	    best = node;
+	    best_slot = slot;
+	}
+    }
+    if (!best)
+	return 0;
+
+    rtip->rti_bvh_solids[best_slot] = stp;
+    return 1;
+}
+
+
+/* Recompute the bounds of the subtree at node from its solids.
+ * Returns 0 if no solid is left below node, whose bounds are then left
+ * as they were.
+ */
+static int
+cut_bvh_refit(struct rt_i *rtip, struct bvh_flat_node *node)
+{
+    vect_t min, max;
+    int found = 0;
+
+    VSETALL(min, INFINITY);
+    VSETALL(max, -INFINITY);
+
+    if (node->n_primitives > 0) {
+	long i;
+	for (i = 0; i < node->n_primitives; i++) {
+	    struct soltab *stp = rtip->rti_bvh_solids[node->data.first_prim_offset + i];
+	    if (!stp)
+		continue;
+	    VMIN(min, stp->st_min);
+	    VMAX(max, stp->st_max);
+	    found = 1;
+	}
+    } else {
+	struct bvh_flat_node *kids[2];
+	int k;
+	kids[0] = node + 1;
+	kids[1] = node->data.other_child;
+	for (k = 0; k < 2; k++) {
+	    if (!cut_bvh_refit(rtip, kids[k]))
+		continue;
+	    VMIN(min, &kids[k]->bounds[0]);
+	    VMAX(max, &kids[k]->bounds[3]);
+	    found = 1;
+	}
+    }
+
+    if (found) {
+	VMOVE(&node->bounds[0], min);
+	VMOVE(&node->bounds[3], max);
+    }
+    return found;
+}
+
+
+void
+cut_bvh_update(struct rt_i *rtip, const struct bu_ptbl *new_solids)
+{
+    size_t i;
+
+    RT_CK_RTI(rtip);
+
+    if (rtip->rti_space_partition != RT_PART_HLBVH)
+	return;
+    if (!rtip->rti_bvh_nodes) {
+	rt_cut_bvh(rtip);
+	return;
+    }
+
+    for (i = 0; i < BU_PTBL_LEN(new_solids); i++) {
+	struct soltab *stp = (struct soltab *)BU_PTBL_GET(new_solids, i);
+	if (stp->st_aradius <= 0 || stp->st_aradius >= INFINITY)
+	    continue;
+	if (stp->st_npieces > 0)
+	    continue;
+
+	/* Refitting keeps the tree shape, which gets worse the more
+	 * solids move.  Past a quarter of them, build it over.
+	 */
+	if ((rtip->rti_bvh_nrefit + 1) * 4 > rtip->rti_bvh_nsolids
+	    || !cut_bvh_insert(rtip, stp)) {
+	    rt_cut_bvh(rtip);
+	    return;
+	}
+	rtip->rti_bvh_nrefit++;
+    }
+
+    (void)cut_bvh_refit(rtip, rtip->rti_bvh_nodes);
+
+    if (RT_G_DEBUG&RT_DEBUG_CUT)
+	bu_log("HLBVH: refit, %zu of %zu solids reinserted since the last build\n",
+	       rtip->rti_bvh_nrefit, rtip->rti_bvh_nsolids);
+}
+
+
 void
 rt_cut_extend(register union cutter *cutp, struct soltab *stp, const struct rt_i *rtip)
 {
@@ -594,8 +858,8 @@ rt_ck_overlap(const vect_t min, const vect_t max, const struct soltab *stp, cons
     }
 
     /* RPP overlaps, invoke per-solid method for detailed check */
-    if (OBJ[stp->st_id].ft_classify &&
-	OBJ[stp->st_id].ft_classify(stp, min, max, &rtip->rti_tol) == BG_CLASSIFY_OUTSIDE)
+    if (stp->st_meth->ft_classify &&
+	stp->st_meth->ft_classify(stp, min, max, &rtip->rti_tol) == BG_CLASSIFY_OUTSIDE)
 	return 0;
 
     /* don't know, check it */
@@ -1122,6 +1386,8 @@ rt_cut_clean(struct rt_i *rtip)
     if (rtip->rti_cuts_waiting.l.magic)
 	bu_ptbl_free(&rtip->rti_cuts_waiting);
 
+    rt_cut_bvh_free(rtip);
+
     /* Abandon the linked list of diced-up structures */
     rtip->rti_CutFree = CUTTER_NULL;
 
@@ -1143,8 +1409,8 @@ rt_pr_cut_info(const struct rt_i *rtip, const char *str)
 
     bu_log("%s %s: %zu cut, %zu box (%zu empty)\n",
 	   str,
-	   rtip->rti_space_partition == RT_PART_NUBSPT ?
-	   "NUBSP" : "unknown",
+	   rtip->rti_space_partition == RT_PART_NUBSPT ? "NUBSP" :
+	   rtip->rti_space_partition == RT_PART_HLBVH ? "HLBVH" : "unknown",
 	   rtip->rti_ncut_by_type[CUT_CUTNODE],
 	   rtip->rti_ncut_by_type[CUT_BOXNODE],
 	   rtip->nempty_cells);
@@ -96,18 +96,26 @@ init_interior(struct bvh_build_node *node, uint8_t axis, struct bvh_build_node *
     node->n_primitives = 0;
 }
 
+/* largest pool chunk, in nodes */
+#define HLBVH_POOL_MAX_NODES (1024*1024)
+
 struct bu_pool *
 hlbvh_init_pool(size_t n_primatives) {
     /*
-     * This pool must have enough size to fit the whole tree or the
-     * algorithm will fail. It stores pointers to itself and a
-     * realloc would make the pointers invalid.
+     * Pool memory doesn't move, so this is only a chunk size hint.
+     * Sized to fit the whole tree in one chunk for small inputs:
      *
      * total_nodes = treelets_size + upper_sah_size,  where:
      *  treelets_size < 2*n_primitives
      *  upper_sah_size < 2*2^popcnt(0x3ffc0000)   i.e. 2*4096
+     *
+     * Large trees get more chunks rather than one huge allocation.
      */
-    return bu_pool_create(sizeof(struct bvh_build_node)*(2*n_primatives+2*4096));
+    size_t nnodes = 2*n_primatives+2*4096;
+
+    if (nnodes > HLBVH_POOL_MAX_NODES)
+	nnodes = HLBVH_POOL_MAX_NODES;
+    return bu_pool_create(sizeof(struct bvh_build_node)*nnodes);
 }
 
 /* utility functions */
@@ -1000,11 +1000,13 @@ rt_db_get_internal5(
 
     BU_ASSERT(dbip->dbi_version == 5);
 
-    if (db_get_external(&ext, dp, dbip) < 0)
+    /* importers copy out what they need, so a view into a mapped
+     * database saves copying the whole object first */
+    if (db_get_external_view(&ext, dp, dbip) < 0)
 	return -2;		/* FAIL */
 
     ret = rt_db_external5_to_internal5(ip, &ext, dp->d_namep, dbip, mat, resp);
-    bu_free_external(&ext);
+    db_free_external_view(&ext, dbip);
     return ret;
 }
 
@@ -1066,22 +1068,22 @@ db5_get_attributes(const struct db_i *dbip, struct bu_attribute_value_set *avs,
 
     BU_AVS_INIT(avs);
 
-    if (db_get_external(&ext, dp, dbip) < 0)
+    if (db_get_external_view(&ext, dp, dbip) < 0)
 	return -1;		/* FAIL */
 
     if (db5_get_raw_internal_ptr(&raw, ext.ext_buf) == NULL) {
-	bu_free_external(&ext);
+	db_free_external_view(&ext, dbip);
 	return -2;
     }
 
     if (raw.attributes.ext_buf) {
 	if (db5_import_attributes(avs, &raw.attributes) < 0) {
-	    bu_free_external(&ext);
+	    db_free_external_view(&ext, dbip);
 	    return -3;
 	}
     }
 
-    bu_free_external(&ext);
+    db_free_external_view(&ext, dbip);
     return 0;
 }
 
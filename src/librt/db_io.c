@@ -28,6 +28,7 @@
 #include "common.h"
 
 #include <string.h>
+#include <errno.h>
 #ifdef HAVE_SYS_TYPES_H
 #  include <sys/types.h>
 #endif
@@ -41,10 +42,42 @@
 #include "librt_private.h"
 
 
+#ifdef DB_USE_PREAD
+/*
+ * Positional read that leaves the stdio stream alone, so it does not
+ * need BU_SEM_SYSCALL.  db_write() flushes each write before it drops
+ * the database's write lock, so everything written so far is visible
+ * here.  Writes are not always appends, though: db_alloc() hands out
+ * freed slots and same-size objects are rewritten in place, so the
+ * caller holds the read lock to keep a write from landing halfway
+ * through the read.  Returns the bytes read.
+ */
+static size_t
+db_pread(int fd, void *addr, size_t count, b_off_t offset)
+{
+    size_t got = 0;
+
+    while (got < count) {
+	ssize_t n = pread(fd, (char *)addr + got, count - got, (off_t)(offset + got));
+	if (n < 0 && errno == EINTR)
+	    continue;
+	if (n <= 0)
+	    break;
+	got += (size_t)n;
+    }
+
+    return got;
+}
+#endif
+
+
 /**
  * Reads 'count' bytes at file offset 'offset' into buffer at 'addr'.
  * A wrapper for the UNIX read() sys-call that takes into account
  * syscall semaphores, stdio-only machines, and in-memory buffering.
+ * Where pread() and pthreads are available, files opened read-write are
+ * read without taking BU_SEM_SYSCALL, under a per-database reader/writer
+ * lock so concurrent reads only wait on db_write().
  *
  * Returns -
  * 0 OK
@@ -79,14 +112,23 @@ db_read(const struct db_i *dbip, void *addr, size_t count, b_off_t offset)
 	memcpy(addr, ((char *)dbip->dbi_inmem) + offset, count);
 	return 0;
     }
-    bu_semaphore_acquire(BU_SEM_SYSCALL);
+#ifdef DB_USE_PREAD
+    if (dbip->i && dbip->i->fd >= 0) {
+	pthread_rwlock_rdlock(&dbip->i->rw);
+	got = db_pread(dbip->i->fd, addr, count, offset);
+	pthread_rwlock_unlock(&dbip->i->rw);
+    } else
+#endif
+    {
+	bu_semaphore_acquire(BU_SEM_SYSCALL);
 
-    ret = bu_fseek(dbip->dbi_fp, offset, 0);
-    if (ret)
-	bu_bomb("db_read: fseek error\n");
-    got = (size_t)fread(addr, 1, count, dbip->dbi_fp);
+	ret = bu_fseek(dbip->dbi_fp, offset, 0);
+	if (ret)
+	    bu_bomb("db_read: fseek error\n");
+	got = (size_t)fread(addr, 1, count, dbip->dbi_fp);
 
-    bu_semaphore_release(BU_SEM_SYSCALL);
+	bu_semaphore_release(BU_SEM_SYSCALL);
+    }
 
     if (got != count) {
 	perror(dbip->dbi_filename);
@@ -196,6 +238,10 @@ db_write(struct db_i *dbip, const void *addr, size_t count, b_off_t offset)
 	bu_log("db_write() in memory?\n");
 	return -1;
     }
+#ifdef DB_USE_PREAD
+    if (dbip->i)
+	pthread_rwlock_wrlock(&dbip->i->rw);
+#endif
     bu_semaphore_acquire(BU_SEM_SYSCALL);
     bu_interrupt_suspend();
 
@@ -205,6 +251,10 @@ db_write(struct db_i *dbip, const void *addr, size_t count, b_off_t offset)
 
     bu_interrupt_restore();
     bu_semaphore_release(BU_SEM_SYSCALL);
+#ifdef DB_USE_PREAD
+    if (dbip->i)
+	pthread_rwlock_unlock(&dbip->i->rw);
+#endif
     if (got != count) {
 	perror("db_write");
 	bu_log("db_write(%s):  write error.  Wanted %zu, got %zu bytes.\nFile forced read-only.\n",
@@ -286,6 +336,56 @@ db_get_external(register struct bu_external *ep, const struct directory *dp, con
 }
 
 
+int
+db_get_external_view(struct bu_external *ep, const struct directory *dp, const struct db_i *dbip)
+{
+    RT_CK_DBI(dbip);
+    RT_CK_DIR(dp);
+
+    if (!dbip->dbi_inmem || (dp->d_flags & RT_DIR_INMEM))
+	return db_get_external(ep, dp, dbip);
+
+    if (dp->d_addr == RT_DIR_PHONY_ADDR)
+	return -1;		/* was dummy DB entry */
+
+    BU_EXTERNAL_INIT(ep);
+    if (db_version(dbip) < 5)
+	ep->ext_nbytes = dp->d_len * sizeof(union record);
+    else
+	ep->ext_nbytes = dp->d_len;
+
+    if (ep->ext_nbytes == 0 || dp->d_addr < 0 || dp->d_addr + ep->ext_nbytes > (size_t)dbip->dbi_eof) {
+	bu_log("db_get_external_view(%s) ERROR offset=%jd, count=%zu, dbi_eof=%jd\n",
+	       dp->d_namep, (intmax_t)dp->d_addr, ep->ext_nbytes, (intmax_t)dbip->dbi_eof);
+	ep->ext_nbytes = 0;
+	return -1;
+    }
+
+    /* the mapping is read-only and lives as long as dbip */
+    ep->ext_buf = (uint8_t *)dbip->dbi_inmem + dp->d_addr;
+    return 0;
+}
+
+
+void
+db_free_external_view(struct bu_external *ep, const struct db_i *dbip)
+{
+    const uint8_t *base;
+
+    BU_CK_EXTERNAL(ep);
+    RT_CK_DBI(dbip);
+
+    base = (const uint8_t *)dbip->dbi_inmem;
+    if (base && ep->ext_buf >= base && ep->ext_buf < base + dbip->dbi_eof) {
+	ep->ext_buf = NULL;
+	ep->ext_nbytes = 0;
+	return;
+    }
+
+    bu_free_external(ep);
+}
+
+
 int
 db_put_external(struct bu_external *ep, struct directory *dp, struct db_i *dbip)
 {
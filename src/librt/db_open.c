@@ -171,6 +171,9 @@ db_open(const char *name, const char *mode)
 	}
 
 	dbip->i = db_i_internal_create();
+#ifdef DB_USE_PREAD
+	dbip->i->fd = fileno(dbip->dbi_fp);
+#endif
 
 	dbip->dbi_use_comb_instance_ids = 0;
 	const char *need_comb_inst = getenv("LIBRT_USE_COMB_INSTANCE_SPECIFIERS");
@@ -454,6 +457,8 @@ db_close(register struct db_i *dbip)
     db_sync(dbip);
 
     if (dbip->dbi_fp) {
+	if (dbip->i)
+	    dbip->i->fd = -1;
 	fclose(dbip->dbi_fp);
     }
 
@@ -644,6 +649,10 @@ db_i_internal_create(void)
     struct db_i_internal *i;
     BU_GET(i, struct db_i_internal);
     i->dbi_magic = DBI_MAGIC;
+    i->fd = -1;
+#ifdef DB_USE_PREAD
+    pthread_rwlock_init(&i->rw, NULL);
+#endif
 
     return i;
 }
@@ -657,6 +666,10 @@ db_i_internal_destroy(struct db_i_internal *i)
     if (i->mesh_c)
 	bv_mesh_lod_context_destroy(i->mesh_c);
 
+#ifdef DB_USE_PREAD
+    pthread_rwlock_destroy(&i->rw);
+#endif
+
     BU_PUT(i, struct db_i_internal);
 }
 
@@ -0,0 +1,485 @@
+/*                    I N S T A N C E . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @addtogroup ray */
+/** @{ */
+/** @file librt/instance.cpp
+ *
+ * Share the prep of a solid between its transformed instances.
+ *
+ * _rt_find_identical_solid() only reuses a soltab when the matrix
+ * matches too, so a BoT placed 500 times under different matrices
+ * used to be prepped 500 times, each copy with its own acceleration
+ * structure.  For the solid types whose prep is expensive, an instance
+ * under a rigid transform (rotation, possibly with a reflection, plus
+ * translation) instead gets a lightweight soltab that refers to a
+ * single prep of the solid done in its own coordinates.  Rays are
+ * transformed into object space at shot time and the hits back out
+ * again.  Since the transform is rigid, hit distances are the same in
+ * both spaces.
+ *
+ * The instance soltabs are ordinary members of the solid lists with
+ * their own st_bit, bounding box and regions.  Only the shared "base"
+ * soltabs are kept out of those lists, in a per rt_i table keyed on
+ * the directory entry.
+ */
+
+#include "common.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <unordered_map>
+
+#include <math.h>
+
+#include "vmath.h"
+#include "bn/mat.h"
+#include "bu/malloc.h"
+#include "raytrace.h"
+
+#include "./librt_private.h"
+#include "./cache.h"
+
+
+#define INST_PREPPING 0
+#define INST_READY 1
+#define INST_FAILED 2
+
+
+struct rt_inst_base {
+    struct soltab *stp;		/* object space prep, NULL until ready */
+    int state;
+    long uses;			/* instance soltabs referring to it */
+};
+
+
+struct rt_inst_tbl {
+    std::mutex lock;
+    std::condition_variable ready;
+    std::unordered_map<const struct directory *, struct rt_inst_base *> bases;
+};
+
+
+struct inst_specific {
+    struct rt_inst_base *base;
+    mat_t model2obj;
+    mat_t obj2model;
+};
+
+
+static struct rt_functab inst_functab[ID_MAXIMUM+1];
+static std::once_flag inst_functab_once;
+
+
+/* Solid types whose prep is worth sharing.  Each must prep in object
+ * space when imported with an identity matrix.
+ */
+static int
+inst_eligible(int id)
+{
+    return id == ID_BOT || id == ID_BREP || id == ID_DSP;
+}
+
+
+/* Returns 1 if mat is a rotation (or reflection) plus translation,
+ * which leaves distances unchanged.
+ */
+static int
+inst_rigid(const mat_t mat, const struct bn_tol *tol)
+{
+    vect_t axis[3];
+    int i, j;
+
+    if (!ZERO(mat[12]) || !ZERO(mat[13]) || !ZERO(mat[14]) || ZERO(mat[15]))
+	return 0;
+
+    for (i = 0; i < 3; i++) {
+	vect_t v = VINIT_ZERO;
+	v[i] = 1.0;
+	MAT4X3VEC(axis[i], mat, v);
+    }
+    for (i = 0; i < 3; i++) {
+	for (j = i; j < 3; j++) {
+	    fastf_t d = VDOT(axis[i], axis[j]) - ((i == j) ? 1.0 : 0.0);
+	    if (!NEAR_ZERO(d, tol->perp))
+		return 0;
+	}
+    }
+    return 1;
+}
+
+
+static void
+inst_ray(struct xray *orp, const struct xray *rp, const mat_t m)
+{
+    *orp = *rp; /* struct copy */
+    MAT4X3PNT(orp->r_pt, m, rp->r_pt);
+    MAT4X3VEC(orp->r_dir, m, rp->r_dir);
+    VUNITIZE(orp->r_dir);
+}
+
+
+/* Move the point and normal of a hit into the other space */
+static void
+inst_hit(struct hit *hitp, const mat_t m, struct xray *rp)
+{
+    point_t p;
+    vect_t n;
+
+    MAT4X3PNT(p, m, hitp->hit_point);
+    MAT4X3VEC(n, m, hitp->hit_normal);
+    VMOVE(hitp->hit_point, p);
+    VMOVE(hitp->hit_normal, n);
+    hitp->hit_rayp = rp;
+}
+
+
+static int
+inst_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct seg *seghead)
+{
+    struct inst_specific *inst = (struct inst_specific *)stp->st_specific;
+    struct soltab *base = inst->base->stp;
+    struct xray orp;
+    struct seg segs;
+    struct seg *segp;
+    int ret;
+
+    inst_ray(&orp, rp, inst->model2obj);
+
+    BU_LIST_INIT(&segs.l);
+    ret = base->st_meth->ft_shot(base, &orp, ap, &segs);
+
+    /* the segments belong to the instance, in model space */
+    while (BU_LIST_WHILE(segp, seg, &segs.l)) {
+	BU_LIST_DEQUEUE(&segp->l);
+	segp->seg_stp = stp;
+	inst_hit(&segp->seg_in, inst->obj2model, rp);
+	inst_hit(&segp->seg_out, inst->obj2model, rp);
+	BU_LIST_INSERT(&seghead->l, &segp->l);
+    }
+
+    return ret;
+}
+
+
+static void
+inst_norm(struct hit *hitp, struct soltab *stp, struct xray *rp)
+{
+    struct inst_specific *inst = (struct inst_specific *)stp->st_specific;
+    struct soltab *base = inst->base->stp;
+    struct xray orp;
+
+    if (!base->st_meth->ft_norm)
+	return;
+
+    inst_ray(&orp, rp, inst->model2obj);
+    inst_hit(hitp, inst->model2obj, &orp);
+    base->st_meth->ft_norm(hitp, base, &orp);
+    inst_hit(hitp, inst->obj2model, rp);
+}
+
+
+static void
+inst_curve(struct curvature *cvp, struct hit *hitp, struct soltab *stp)
+{
+    struct inst_specific *inst = (struct inst_specific *)stp->st_specific;
+    struct soltab *base = inst->base->stp;
+    struct hit ohit = *hitp; /* struct copy */
+    struct xray orp;
+    vect_t pdir;
+
+    if (!base->st_meth->ft_curve)
+	return;
+
+    if (hitp->hit_rayp)
+	inst_ray(&orp, hitp->hit_rayp, inst->model2obj);
+    inst_hit(&ohit, inst->model2obj, hitp->hit_rayp ? &orp : NULL);
+    base->st_meth->ft_curve(cvp, &ohit, base);
+    MAT4X3VEC(pdir, inst->obj2model, cvp->crv_pdir);
+    VMOVE(cvp->crv_pdir, pdir);
+}
+
+
+static void
+inst_uv(struct application *ap, struct soltab *stp, struct hit *hitp, struct uvcoord *uvp)
+{
+    struct inst_specific *inst = (struct inst_specific *)stp->st_specific;
+    struct soltab *base = inst->base->stp;
+    struct hit ohit = *hitp; /* struct copy */
+    struct xray orp;
+
+    if (!base->st_meth->ft_uv)
+	return;
+
+    if (hitp->hit_rayp)
+	inst_ray(&orp, hitp->hit_rayp, inst->model2obj);
+    inst_hit(&ohit, inst->model2obj, hitp->hit_rayp ? &orp : NULL);
+    base->st_meth->ft_uv(ap, base, &ohit, uvp);
+}
+
+
+static void
+inst_print(const struct soltab *stp)
+{
+    const struct inst_specific *inst = (const struct inst_specific *)stp->st_specific;
+    struct soltab *base = inst->base->stp;
+
+    bu_log("instance of %s, shared by %ld\n", base->st_dp->d_namep, inst->base->uses);
+    bn_mat_print("model to object", inst->model2obj);
+    if (base->st_meth->ft_print)
+	base->st_meth->ft_print(base);
+}
+
+
+static int
+inst_classify(const struct soltab *UNUSED(stp), const vect_t UNUSED(min), const vect_t UNUSED(max), const struct bn_tol *UNUSED(tol))
+{
+    return BG_CLASSIFY_UNIMPLEMENTED;
+}
+
+
+static void
+inst_base_free(struct soltab *bstp)
+{
+    if (bstp->st_aradius > 0 && bstp->st_meth->ft_free)
+	bstp->st_meth->ft_free(bstp);
+    bu_ptbl_free(&bstp->st_regions);
+    bu_free(bstp, "instance base soltab");
+}
+
+
+static void
+inst_release(struct rt_inst_tbl *tbl, struct rt_inst_base *base, const struct directory *dp)
+{
+    {
+	std::lock_guard<std::mutex> guard(tbl->lock);
+	if (--base->uses > 0)
+	    return;
+	tbl->bases.erase(dp);
+    }
+
+    if (base->stp)
+	inst_base_free(base->stp);
+    delete base;
+}
+
+
+static void
+inst_free(struct soltab *stp)
+{
+    struct inst_specific *inst = (struct inst_specific *)stp->st_specific;
+
+    inst_release(stp->st_rtip->rti_inst_tbl, inst->base, stp->st_dp);
+    BU_PUT(inst, struct inst_specific);
+    stp->st_specific = NULL;
+}
+
+
+static void
+inst_functab_init(void)
+{
+    for (int id = 0; id <= ID_MAXIMUM; id++) {
+	if (!inst_eligible(id))
+	    continue;
+
+	/* keep the name, label and other type information */
+	inst_functab[id] = OBJ[id]; /* struct copy */
+	inst_functab[id].ft_shot = inst_shot;
+	inst_functab[id].ft_print = inst_print;
+	inst_functab[id].ft_norm = inst_norm;
+	inst_functab[id].ft_piece_shot = NULL;
+	inst_functab[id].ft_piece_hitsegs = NULL;
+	inst_functab[id].ft_uv = inst_uv;
+	inst_functab[id].ft_curve = inst_curve;
+	inst_functab[id].ft_classify = inst_classify;
+	inst_functab[id].ft_free = inst_free;
+	inst_functab[id].ft_vshot = rt_vstub;
+	inst_functab[id].ft_prep_serialize = NULL;
+    }
+}
+
+
+/* Prep dp in its own coordinates, outside of the solid lists */
+static struct soltab *
+inst_base_prep(const struct directory *dp, struct rt_i *rtip, struct rt_cache *cache, struct resource *resp)
+{
+    struct rt_db_internal intern;
+    struct soltab *bstp;
+
+    if (rt_db_get_internal(&intern, dp, rtip->rti_dbip, NULL, resp) < 0)
+	return NULL;
+
+    BU_ALLOC(bstp, struct soltab);
+    bstp->l.magic = RT_SOLTAB_MAGIC;
+    bstp->l2.magic = RT_SOLTAB2_MAGIC;
+    bstp->st_rtip = rtip;
+    bstp->st_dp = dp;
+    bstp->st_uses = 1;
+    bstp->st_matp = (matp_t)0;
+    bstp->st_bit = -1;
+    bstp->st_id = intern.idb_type;
+    bstp->st_meth = &OBJ[intern.idb_type];
+    bu_ptbl_init(&bstp->st_regions, 1, "st_regions ptbl");
+    VSETALL(bstp->st_max, -INFINITY);
+    VSETALL(bstp->st_min,  INFINITY);
+
+    if (rt_cache_prep(cache, bstp, &intern) || !inst_eligible(bstp->st_id)) {
+	rt_db_free_internal(&intern);
+	inst_base_free(bstp);
+	return NULL;
+    }
+
+    rt_db_free_internal(&intern);
+    return bstp;
+}
+
+
+/* Find or create the shared prep of dp.  If another thread is
+ * prepping it, wait for that to finish.  Returns NULL if the prep
+ * failed.
+ */
+static struct rt_inst_base *
+inst_base_get(struct rt_inst_tbl *tbl, const struct directory *dp, struct rt_i *rtip, struct rt_cache *cache, struct resource *resp)
+{
+    struct rt_inst_base *base;
+    std::unique_lock<std::mutex> lk(tbl->lock);
+
+    auto b_it = tbl->bases.find(dp);
+    if (b_it == tbl->bases.end()) {
+	struct soltab *bstp;
+
+	base = new rt_inst_base;
+	base->stp = NULL;
+	base->state = INST_PREPPING;
+	base->uses = 1;
+	tbl->bases[dp] = base;
+
+	lk.unlock();
+	bstp = inst_base_prep(dp, rtip, cache, resp);
+	lk.lock();
+
+	base->stp = bstp;
+	base->state = (bstp) ? INST_READY : INST_FAILED;
+	tbl->ready.notify_all();
+    } else {
+	base = b_it->second;
+	base->uses++;
+	tbl->ready.wait(lk, [base]{return base->state != INST_PREPPING;});
+    }
+
+    if (base->state == INST_FAILED) {
+	lk.unlock();
+	inst_release(tbl, base, dp);
+	return NULL;
+    }
+
+    return base;
+}
+
+
+int
+rt_inst_prep(struct soltab *stp, const struct rt_db_internal *ip, struct rt_cache *cache, struct resource *resp)
+{
+    struct rt_i *rtip = stp->st_rtip;
+    struct rt_inst_base *base;
+    struct inst_specific *inst;
+    struct soltab *bstp;
+    point_t corner;
+    int i;
+
+    RT_CK_SOLTAB(stp);
+    RT_CK_RTI(rtip);
+
+    if (!rtip->rti_inst_tbl || rtip->rti_dont_instance || !stp->st_matp)
+	return 1;
+    if (ip->idb_major_type != DB5_MAJORTYPE_BRLCAD || !inst_eligible(ip->idb_type))
+	return 1;
+    if (!inst_rigid(stp->st_matp, &rtip->rti_tol))
+	return 1;
+
+    std::call_once(inst_functab_once, inst_functab_init);
+
+    base = inst_base_get(rtip->rti_inst_tbl, stp->st_dp, rtip, cache, resp);
+    if (!base)
+	return -1;
+    bstp = base->stp;
+
+    BU_GET(inst, struct inst_specific);
+    inst->base = base;
+    MAT_COPY(inst->obj2model, stp->st_matp);
+    bn_mat_inverse(inst->model2obj, stp->st_matp);
+
+    stp->st_id = bstp->st_id;
+    stp->st_meth = &inst_functab[bstp->st_id];
+    stp->st_specific = (void *)inst;
+    stp->st_npieces = 0;
+
+    MAT4X3PNT(stp->st_center, stp->st_matp, bstp->st_center);
+    stp->st_aradius = bstp->st_aradius;
+    stp->st_bradius = bstp->st_bradius;
+
+    /* model space box around the transformed object space box */
+    VSETALL(stp->st_max, -INFINITY);
+    VSETALL(stp->st_min,  INFINITY);
+    for (i = 0; i < 8; i++) {
+	point_t p;
+	VSET(corner,
+	     (i & 1) ? bstp->st_max[X] : bstp->st_min[X],
+	     (i & 2) ? bstp->st_max[Y] : bstp->st_min[Y],
+	     (i & 4) ? bstp->st_max[Z] : bstp->st_min[Z]);
+	MAT4X3PNT(p, stp->st_matp, corner);
+	VMINMAX(stp->st_min, stp->st_max, p);
+    }
+
+    return 0;
+}
+
+
+struct rt_inst_tbl *
+rt_inst_tbl_create(void)
+{
+    return new rt_inst_tbl;
+}
+
+
+void
+rt_inst_tbl_destroy(struct rt_inst_tbl *tbl)
+{
+    if (!tbl)
+	return;
+
+    /* normally empty, rt_clean() frees the instances */
+    for (auto &b : tbl->bases) {
+	if (b.second->stp)
+	    inst_base_free(b.second->stp);
+	delete b.second;
+    }
+    delete tbl;
+}
+
+/** @} */
+
+// Local Variables:
+// tab-width: 8
+// mode: C++
+// c-basic-offset: 4
+// indent-tabs-mode: t
+// c-file-style: "stroustrup"
+// End:
+// ex: shiftwidth=4 tabstop=8
@@ -38,6 +38,13 @@
 #include "rt/db4.h"
 #include "raytrace.h"
 
+/* Writable databases are read with unlocked pread() calls, ordered
+ * against in-place rewrites by a per-database reader/writer lock */
+#if defined(HAVE_PREAD) && defined(HAVE_PTHREAD_H)
+#  include <pthread.h>
+#  define DB_USE_PREAD 1
+#endif
+
 /* approximation formula for the circumference of an ellipse */
 #define ELL_CIRCUMFERENCE(a, b) M_PI * ((a) + (b)) * \
     (1.0 + (3.0 * ((((a) - b))/((a) + (b))) * ((((a) - b))/((a) + (b))))) \
@@ -60,6 +67,13 @@
     } \
 } while (0)
 
+/* number of ray/solid pairs the vectorized ft_vshot routines gather
+ * into structure-of-arrays form and intersect together.  the inner
+ * loops over a block are branch-free so the compiler can map them
+ * onto SIMD lanes.
+ */
+#define RT_VSHOT_BLOCK 8
+
 
 __BEGIN_DECLS
 
@@ -71,6 +85,14 @@ __BEGIN_DECLS
 struct db_i_internal {
     uint32_t dbi_magic;
 
+    /* descriptor of dbi_fp for unlocked positional reads, -1 if none */
+    int fd;
+#ifdef DB_USE_PREAD
+    /* held shared by db_read() around each pread and exclusively by
+     * db_write(), so a read never sees a partially rewritten object */
+    pthread_rwlock_t rw;
+#endif
+
     /* BoT level of detail cached data for drawing */
     struct bv_mesh_lod_context *mesh_c;
     int mesh_c_completed;
@@ -139,12 +161,70 @@ extern fastf_t ell_angle(fastf_t *p1, fastf_t a, fastf_t b, fastf_t dtol, fastf_
  */
 extern const union cutter *rt_advance_to_next_cell(struct rt_shootray_status *ssp);
 
+/**
+ * Drop stp from the scene HLBVH, leaving its slot free.  Used by
+ * rt_unprep() before the soltab is released.
+ */
+extern void cut_bvh_remove(struct rt_i *rtip, const struct soltab *stp);
+
+/**
+ * Bring the scene HLBVH up to date after rt_reprep() adds new_solids.
+ * They go into slots freed by cut_bvh_remove() and the node bounds are
+ * refit, the tree is only rebuilt when that runs out of slots or too
+ * many solids have moved since the last build.
+ */
+extern void cut_bvh_update(struct rt_i *rtip, const struct bu_ptbl *new_solids);
+
 /**
  * used by rt_shootray_bundle()
  * FIXME: non-public API shouldn't be using rt_ prefix
  */
 extern void rt_plot_cell(const union cutter *cutp, struct rt_shootray_status *ssp, struct bu_list *waiting_segs_hd, struct rt_i *rtip);
 
+/**
+ * Intersect a packet of rays with a single BoT, traversing its BVH
+ * once for several rays.  Segments for rays[i] go to seghead[i] and
+ * the rt_bot_shot()-style return value to ret[i].
+ *
+ * used by rt_shootray_bundle()
+ */
+extern void rt_bot_shot_packet(struct soltab *stp, struct xray **rays, int nrays, struct application *ap, struct seg *seghead, int *ret);
+
+/**
+ * Release the BoT intersection buffers kept in resp->re_bot_scratch.
+ *
+ * used by rt_clean_resource_basic()
+ */
+extern void rt_bot_scratch_free(struct resource *resp);
+
+/* brep.cpp */
+
+/**
+ * Release the brep hit buffers kept in resp->re_brep_scratch.
+ *
+ * used by rt_clean_resource_basic()
+ */
+extern void rt_brep_scratch_free(struct resource *resp);
+
+/* instance.cpp */
+
+struct rt_cache;
+struct rt_inst_tbl;
+
+/**
+ * If stp is a rigidly transformed instance of a solid type whose prep
+ * is worth sharing, set it up to use a single object space prep of
+ * the solid, prepping that first if this is the first such instance.
+ * stp must have st_dp, st_rtip and st_matp set.  cache may be NULL.
+ *
+ * Returns 0 if stp was set up, 1 if stp is not eligible and needs an
+ * ordinary prep, and -1 if the shared prep failed.
+ */
+extern int rt_inst_prep(struct soltab *stp, const struct rt_db_internal *ip, struct rt_cache *cache, struct resource *resp);
+
+extern struct rt_inst_tbl *rt_inst_tbl_create(void);
+extern void rt_inst_tbl_destroy(struct rt_inst_tbl *tbl);
+
 /* db_fullpath.c */
 
 /**
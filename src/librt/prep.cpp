@@ -28,8 +28,10 @@
 
 #include "common.h"
 
+#include <set>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <stdlib.h>
 #include <stddef.h>
@@ -43,6 +45,7 @@
 #include "bn.h"
 #include "raytrace.h"
 #include "bv/plot3.h"
+#include "./librt_private.h"
 
 #include "optical.h"
 #include "optical/plastic.h"
@@ -100,6 +103,9 @@ rt_new_rti(struct db_i *dbip)
     /* list of invisible light regions to be deleted after light_init() */
     bu_ptbl_init(&rtip->delete_regs, 8, "rt_i delete regions list");
 
+    /* preps shared between transformed instances of a solid */
+    rtip->rti_inst_tbl = rt_inst_tbl_create();
+
     VSETALL(rtip->mdl_min,  INFINITY);
     VSETALL(rtip->mdl_max, -INFINITY);
     VSETALL(rtip->rti_inf_box.bn.bn_min, -0.1);
@@ -122,6 +128,9 @@ rt_new_rti(struct db_i *dbip)
      * non-uniform binary space partitioning tree.  If you change this
      * to anything else, you must also modify "rt_find_backing_dist()"
      * (in shoot.c), to handle the different algorithm -JRA
+     *
+     * RT_PART_HLBVH leaves rti_CutHead as a single box, which
+     * rt_find_backing_dist() already handles.
      */
     rtip->rti_space_partition = RT_PART_NUBSPT;
 
@@ -187,6 +196,9 @@ rt_free_rti(struct rt_i *rtip)
     bu_ptbl_free(&rtip->rti_resources);
     bu_ptbl_free(&rtip->delete_regs);
 
+    rt_inst_tbl_destroy(rtip->rti_inst_tbl);
+    rtip->rti_inst_tbl = NULL;
+
     bu_free((char *)rtip, "struct rt_i");
 }
 
@@ -897,6 +909,13 @@ rt_init_resource(struct resource *resp, int cpu_num, struct rt_i *rtip)
     resp->re_boolstack = NULL;
     resp->re_boolslen = 0;
 
+    /* A live resource keeps its BoT and brep buffers across re-init,
+     * they are only released by rt_clean_resource_basic() */
+    if (resp->re_magic != RESOURCE_MAGIC) {
+	resp->re_bot_scratch = NULL;
+	resp->re_brep_scratch = NULL;
+    }
+
     resp->re_cpu = cpu_num;
     resp->re_magic = RESOURCE_MAGIC;
 
@@ -1017,6 +1036,12 @@ rt_clean_resource_basic(struct rt_i *rtip, struct resource *resp)
     /* Release the state variables for 'solid pieces' */
     rt_res_pieces_clean(resp, rtip);
 
+    /* 're_bot_scratch' is owned by the BoT primitive */
+    rt_bot_scratch_free(resp);
+
+    /* 're_brep_scratch' is owned by the brep primitive */
+    rt_brep_scratch_free(resp);
+
     /* invalidate the resource */
     if (resp != &rt_uniresource)
 	resp->re_magic = 0;
@@ -1677,6 +1702,7 @@ unprep_leaf(struct db_tree_state *tsp,
 		    /* soltab structure will actually be freed */
 		    remove_from_bsp(stp, &rtip->rti_inf_box, &rtip->rti_tol);
 		    remove_from_bsp(stp, &rtip->rti_CutHead, &rtip->rti_tol);
+		    cut_bvh_remove(rtip, stp);
 		    rtip->rti_Solids[bit] = (struct soltab *)NULL;
 		}
 		rt_free_soltab(stp);
@@ -1987,6 +2013,9 @@ rt_reprep(struct rt_i *rtip, struct rt_reprep_obj_list *objs, struct resource *r
 	}
     }
 
+    /* no-op unless partitioning with RT_PART_HLBVH */
+    cut_bvh_update(rtip, &rtip->rti_new_solids);
+
     bu_ptbl_free(&rtip->rti_new_solids);
 
     if (!VNEAR_EQUAL(rtip->mdl_min, old_min, SMALL_FASTF)
@@ -2016,6 +2045,203 @@ rt_reprep(struct rt_i *rtip, struct rt_reprep_obj_list *objs, struct resource *r
 }
 
 
+struct rt_reprep_tracker {
+    struct rt_i *rtip;
+    std::vector<std::string> topobjs;
+    std::set<std::string> changed;	/* modified since the last update */
+    int full;				/* saw a change rt_unprep() can't handle */
+};
+
+
+/**
+ * Returns 1 if dp has a soltab prepped in rtip.
+ */
+static int
+reprep_dp_prepped(struct rt_i *rtip, struct directory *dp)
+{
+    struct bu_list *mid;
+
+    for (mid = BU_LIST_FIRST(bu_list, &dp->d_use_hd); mid != &dp->d_use_hd; mid = BU_LIST_PNEXT(bu_list, mid)) {
+	struct soltab *stp = BU_LIST_MAIN_PTR(soltab, mid, l2);
+	RT_CK_SOLTAB(stp);
+	if (stp->st_rtip == rtip)
+	    return 1;
+    }
+    return 0;
+}
+
+
+/**
+ * Returns 1 if the combination dp may be part of the tracked model.
+ * Region tops are not searched and are assumed to contain it.
+ */
+static int
+reprep_comb_in_model(struct rt_reprep_tracker *trk, struct directory *dp, struct resource *resp)
+{
+    struct db_i *dbip = trk->rtip->rti_dbip;
+    struct bu_ptbl paths;
+    int found = 0;
+
+    bu_ptbl_init(&paths, 8, "reprep paths");
+    for (size_t i = 0; i < trk->topobjs.size() && !found; i++) {
+	struct directory *start = db_lookup(dbip, trk->topobjs[i].c_str(), LOOKUP_QUIET);
+	if (start == RT_DIR_NULL)
+	    continue;
+	if (start == dp || (start->d_flags & RT_DIR_REGION)) {
+	    found = 1;
+	    break;
+	}
+	if (!(start->d_flags & RT_DIR_COMB))
+	    continue;
+	rt_find_paths(dbip, start, dp, &paths, resp);
+	found = (BU_PTBL_LEN(&paths) > 0);
+    }
+
+    for (size_t i = 0; i < BU_PTBL_LEN(&paths); i++) {
+	struct db_full_path *path = (struct db_full_path *)BU_PTBL_GET(&paths, i);
+	db_free_full_path(path);
+	bu_free((char *)path, "path");
+    }
+    bu_ptbl_free(&paths);
+
+    return found;
+}
+
+
+static void
+reprep_changed_clbk(struct db_i *dbip, struct directory *dp, int mode, void *u_data)
+{
+    struct rt_reprep_tracker *trk = (struct rt_reprep_tracker *)u_data;
+
+    if (!trk || !dp || dbip != trk->rtip->rti_dbip)
+	return;
+
+    switch (mode) {
+	case 0:
+	    trk->changed.insert(std::string(dp->d_namep));
+	    break;
+	case 2:
+	    /* dp is going away, so this can't wait for the update */
+	    if ((dp->d_flags & RT_DIR_COMB) || reprep_dp_prepped(trk->rtip, dp))
+		trk->full = 1;
+	    break;
+	default:
+	    /* new objects only matter once something references them,
+	     * which arrives as a modification of the referencing object.
+	     */
+	    break;
+    }
+}
+
+
+struct rt_reprep_tracker *
+rt_reprep_track(struct rt_i *rtip, size_t ntopobjs, const char **topobjs)
+{
+    if (!rtip || !ntopobjs || !topobjs)
+	return NULL;
+    RT_CK_RTI(rtip);
+    RT_CK_DBI(rtip->rti_dbip);
+
+    struct rt_reprep_tracker *trk = new rt_reprep_tracker;
+    trk->rtip = rtip;
+    trk->full = 0;
+    for (size_t i = 0; i < ntopobjs; i++)
+	trk->topobjs.push_back(std::string(topobjs[i]));
+
+    if (db_add_changed_clbk(rtip->rti_dbip, &reprep_changed_clbk, (void *)trk)) {
+	delete trk;
+	return NULL;
+    }
+
+    return trk;
+}
+
+
+int
+rt_reprep_changed(struct rt_reprep_tracker *trk, struct resource *resp)
+{
+    if (!trk)
+	return 1;
+
+    struct rt_i *rtip = trk->rtip;
+    RT_CK_RTI(rtip);
+
+    std::vector<std::string> prims;
+    int full = trk->full;
+
+    for (std::set<std::string>::iterator n_it = trk->changed.begin(); n_it != trk->changed.end() && !full; n_it++) {
+	struct directory *dp = db_lookup(rtip->rti_dbip, n_it->c_str(), LOOKUP_QUIET);
+	if (dp == RT_DIR_NULL)
+	    continue;
+
+	if (reprep_dp_prepped(rtip, dp)) {
+	    prims.push_back(*n_it);
+	} else if (dp->d_flags & RT_DIR_COMB) {
+	    /* the old tree is gone, so the soltabs it produced can't
+	     * be matched up for rt_unprep()
+	     */
+	    full = reprep_comb_in_model(trk, dp, resp);
+	} else if (dp->d_major_type == DB5_MAJORTYPE_BINARY_UNIF || (dp->d_major_type == DB5_MAJORTYPE_BRLCAD && dp->d_minor_type == ID_SKETCH)) {
+	    /* data some other primitive (dsp, extrude, ...) may refer
+	     * to by name, which d_nref doesn't count
+	     */
+	    full = 1;
+	}
+    }
+
+    trk->changed.clear();
+    trk->full = 0;
+
+    if (full)
+	return 1;
+    if (prims.empty())
+	return 0;
+
+    struct rt_reprep_obj_list objs;
+    memset(&objs, 0, sizeof(struct rt_reprep_obj_list));
+    objs.ntopobjs = trk->topobjs.size();
+    objs.topobjs = (char **)bu_calloc(objs.ntopobjs, sizeof(char *), "topobjs");
+    for (size_t i = 0; i < objs.ntopobjs; i++)
+	objs.topobjs[i] = (char *)trk->topobjs[i].c_str();
+    objs.nunprepped = prims.size();
+    objs.unprepped = (char **)bu_calloc(objs.nunprepped, sizeof(char *), "unprepped");
+    for (size_t i = 0; i < objs.nunprepped; i++)
+	objs.unprepped[i] = (char *)prims[i].c_str();
+
+    int ret = rt_unprep(rtip, &objs, resp);
+    if (!ret)
+	ret = rt_reprep(rtip, &objs, resp);
+
+    if (BU_PTBL_IS_INITIALIZED(&objs.paths)) {
+	for (size_t i = 0; i < BU_PTBL_LEN(&objs.paths); i++) {
+	    struct db_full_path *path = (struct db_full_path *)BU_PTBL_GET(&objs.paths, i);
+	    db_free_full_path(path);
+	    bu_free((char *)path, "path");
+	}
+	bu_ptbl_free(&objs.paths);
+    }
+    if (BU_PTBL_IS_INITIALIZED(&objs.unprep_regions))
+	bu_ptbl_free(&objs.unprep_regions);
+    if (objs.tsp)
+	bu_free(objs.tsp, "objs->tsp");
+    bu_free(objs.unprepped, "unprepped");
+    bu_free(objs.topobjs, "topobjs");
+
+    return (ret) ? 1 : 0;
+}
+
+
+void
+rt_reprep_untrack(struct rt_reprep_tracker *trk)
+{
+    if (!trk)
+	return;
+
+    db_rm_changed_clbk(trk->rtip->rti_dbip, &reprep_changed_clbk, (void *)trk);
+    delete trk;
+}
+
+
 /** @} */
 
 
@@ -1187,7 +1187,12 @@ rt_arb_shot(struct soltab *stp, register struct xray *rp, struct application *ap
 
 #define RT_ARB8_SEG_MISS(SEG)	(SEG).seg_stp=RT_SOLTAB_NULL
 /**
- * This is the Becker vector version
+ * Vectorized version.  Pairs are gathered RT_VSHOT_BLOCK at a time
+ * into structure-of-arrays form and clipped against one face of every
+ * pair at a time without branching.  Faces are visited in the same
+ * order as rt_arb_shot() so ties pick the same planes.  ARBs with
+ * fewer than six faces are padded with planes every ray lies inside
+ * of.
  */
 void
 rt_arb_vshot(struct soltab **stp, struct xray **rp, struct seg *segp, int n, struct application *ap)
@@ -1197,77 +1202,95 @@ rt_arb_vshot(struct soltab **stp, struct xray **rp, struct seg *segp, int n, str
 /* Number of ray/object pairs */
 
 {
-    register int j, i;
-    register struct arb_specific *arbp;
-    fastf_t dn;		/* Direction dot Normal */
-    fastf_t dxbdn;
-    fastf_t s;
+    int i;
 
     if (ap) RT_CK_APPLICATION(ap);
 
-    /* Initialize return values */
-    for (i = 0; i < n; i++) {
-	segp[i].seg_stp = stp[i];	/* Assume hit, if 0 then miss */
-	segp[i].seg_in.hit_dist = -INFINITY;    /* used as in */
-	segp[i].seg_in.hit_surfno = -1;		/* used as iplane */
-	segp[i].seg_out.hit_dist = INFINITY;    /* used as out */
-	segp[i].seg_out.hit_surfno = -1;	/* used as oplane */
-/* segp[i].seg_next = SEG_NULL;*/
-    }
+    for (i = 0; i < n; i += RT_VSHOT_BLOCK) {
+	const struct arb_specific *arbp[RT_VSHOT_BLOCK];
+	int pair[RT_VSHOT_BLOCK];
+	fastf_t pt[3][RT_VSHOT_BLOCK];
+	fastf_t dir[3][RT_VSHOT_BLOCK];
+	fastf_t in[RT_VSHOT_BLOCK], out[RT_VSHOT_BLOCK];	/* ray in/out distances */
+	int iplane[RT_VSHOT_BLOCK], oplane[RT_VSHOT_BLOCK];
+	int miss[RT_VSHOT_BLOCK];
+	int face, j, m = 0;
+
+	/* gather the pairs of this block, stp[i] == 0 signals skip ray */
+	for (j = i; j < i + RT_VSHOT_BLOCK && j < n; j++) {
+	    if (stp[j] == 0)
+		continue;
+
+	    arbp[m] = (const struct arb_specific *)stp[j]->st_specific;
+	    pair[m] = j;
+	    pt[X][m] = rp[j]->r_pt[X];
+	    pt[Y][m] = rp[j]->r_pt[Y];
+	    pt[Z][m] = rp[j]->r_pt[Z];
+	    dir[X][m] = rp[j]->r_dir[X];
+	    dir[Y][m] = rp[j]->r_dir[Y];
+	    dir[Z][m] = rp[j]->r_dir[Z];
+	    in[m] = -INFINITY;
+	    out[m] = INFINITY;
+	    iplane[m] = oplane[m] = -1;
+	    miss[m] = 0;
+	    m++;
+	}
 
-    /* consider each face */
-    for (j = 0; j < 6; j++) {
-	/* for each ray/arb_face pair */
-	for (i = 0; i < n; i++) {
-	    if (stp[i] == 0) continue;	/* skip this ray */
-	    if (segp[i].seg_stp == 0) continue;	/* miss */
-
-	    arbp= (struct arb_specific *) stp[i]->st_specific;
-	    if (arbp->arb_nmfaces <= j)
-		continue; /* faces of this ARB are done */
-
-	    dxbdn = VDOT(arbp->arb_face[j].peqn, rp[i]->r_pt) -
-		arbp->arb_face[j].peqn[W];
-	    if ((dn = -VDOT(arbp->arb_face[j].peqn, rp[i]->r_dir)) < -SQRT_SMALL_FASTF) {
-		/* exit point, when dir.N < 0.  out = min(out, s) */
-		if (segp[i].seg_out.hit_dist > (s = dxbdn/dn)) {
-		    segp[i].seg_out.hit_dist = s;
-		    segp[i].seg_out.hit_surfno = j;
-		}
-	    } else if (dn > SQRT_SMALL_FASTF) {
-		/* entry point, when dir.N > 0.  in = max(in, s) */
-		if (segp[i].seg_in.hit_dist < (s = dxbdn/dn)) {
-		    segp[i].seg_in.hit_dist = s;
-		    segp[i].seg_in.hit_surfno = j;
-		}
-	    } else {
-		/* ray is parallel to plane when dir.N == 0.
-		 * If it is outside the solid, stop now */
-		if (dxbdn > SQRT_SMALL_FASTF) {
-		    RT_ARB8_SEG_MISS(segp[i]);		/* MISS */
+	/* consider each face */
+	for (face = 5; face >= 0; face--) {
+	    fastf_t peqn[4][RT_VSHOT_BLOCK];
+
+	    for (j = 0; j < m; j++) {
+		if (face < arbp[j]->arb_nmfaces) {
+		    const fastf_t *eqn = arbp[j]->arb_face[face].peqn;
+		    peqn[X][j] = eqn[X];
+		    peqn[Y][j] = eqn[Y];
+		    peqn[Z][j] = eqn[Z];
+		    peqn[W][j] = eqn[W];
+		} else {
+		    peqn[X][j] = peqn[Y][j] = peqn[Z][j] = 0.0;
+		    peqn[W][j] = 1.0;
 		}
 	    }
-	    if (segp[i].seg_in.hit_dist > segp[i].seg_out.hit_dist) {
-		RT_ARB8_SEG_MISS(segp[i]);		/* MISS */
+
+	    for (j = 0; j < m; j++) {
+		fastf_t dxbdn = peqn[X][j]*pt[X][j] + peqn[Y][j]*pt[Y][j] + peqn[Z][j]*pt[Z][j] - peqn[W][j];
+		fastf_t dn = -(peqn[X][j]*dir[X][j] + peqn[Y][j]*dir[Y][j] + peqn[Z][j]*dir[Z][j]);	/* Direction dot Normal */
+		int exits = dn < -SQRT_SMALL_FASTF;
+		int enters = dn > SQRT_SMALL_FASTF;
+		fastf_t s = dxbdn / ((exits | enters) ? dn : 1.0);
+		int closer = exits & (out[j] > s);
+		int farther = enters & (in[j] < s);
+
+		/* exit point, when dir.N < 0.  out = min(out, s) */
+		out[j] = closer ? s : out[j];
+		oplane[j] = closer ? face : oplane[j];
+
+		/* entry point, when dir.N > 0.  in = max(in, s) */
+		in[j] = farther ? s : in[j];
+		iplane[j] = farther ? face : iplane[j];
+
+		/* ray is parallel to plane when dir.N == 0.  If it is
+		 * outside the solid, it misses.
+		 */
+		miss[j] |= !(exits | enters) & (dxbdn > SQRT_SMALL_FASTF);
 	    }
-	} /* for each ray/arb_face pair */
-    } /* for each arb_face */
+	}
 
-    /*
-     * Validate for each ray/arb_face pair
-     * Segment was initialized as "good" (seg_stp set valid);
-     * that is revoked here on misses.
-     */
-    for (i = 0; i < n; i++) {
-	if (stp[i] == 0) continue;		/* skip this ray */
-	if (segp[i].seg_stp == 0) continue;	/* missed */
-
-	if (segp[i].seg_in.hit_surfno == -1 ||
-	    segp[i].seg_out.hit_surfno == -1) {
-	    RT_ARB8_SEG_MISS(segp[i]);		/* MISS */
-	} else if (segp[i].seg_in.hit_dist >= segp[i].seg_out.hit_dist ||
-		   segp[i].seg_out.hit_dist >= INFINITY) {
-	    RT_ARB8_SEG_MISS(segp[i]);		/* MISS */
+	/* validate and scatter */
+	for (j = 0; j < m; j++) {
+	    struct seg *sp = &segp[pair[j]];
+
+	    if (miss[j] || iplane[j] == -1 || oplane[j] == -1
+		|| in[j] >= out[j] || out[j] >= INFINITY) {
+		RT_ARB8_SEG_MISS(*sp);		/* MISS */
+		continue;
+	    }
+	    sp->seg_stp = stp[pair[j]];
+	    sp->seg_in.hit_dist = in[j];
+	    sp->seg_in.hit_surfno = iplane[j];
+	    sp->seg_out.hit_dist = out[j];
+	    sp->seg_out.hit_surfno = oplane[j];
 	}
     }
 }
@@ -27,6 +27,7 @@
 
 #include "common.h"
 
+#include <limits.h> // needed for INT_MAX
 #include <string.h> // needed for memset, memcpy, and strlen
 #include <ctype.h> // needed for isdigit() and isspace() in rt_bot_adjust
 
@@ -45,6 +46,7 @@
 #define BOT_MIN_DN 1.0e-9
 #define HLBVH_STACK_SIZE 256
 #define RT_DEFAULT_MAX_PRIMS_IN_NODE 8
+#define BOT_PACKET_SIZE 8	/* rays per packet, at most 32 */
 
 #define BOT_UNORIENTED_NORM(_ap, _hitp, _norm, _out) {		    \
 	if (!(_ap)->a_bot_reverse_normal_disabled) {		    \
@@ -348,45 +350,43 @@ const struct hit zeroed_hit_s = RT_HIT_INIT_ZERO;
 	(da)->items[(da)->count++] = (item); /* struct copy */				\
     } while (0)
 
+/* Candidate intersections found while walking the BVH.  They are kept
+ * in structure-of-arrays form so that ordering them only touches the
+ * distances and a permutation; a struct hit is built for each one only
+ * once they are sorted, just before rt_bot_makesegs().
+ */
+typedef struct _cand_da {
+    size_t count;
+    size_t capacity;
+    fastf_t *dist;
+    fastf_t *vpriv;	/* 3 per candidate, see rt_bot_shot() */
+    triangle_s **tri;
+    size_t *order;	/* sorted permutation of [0, count) */
+    size_t *scratch;	/* merge buffer for order */
+} cand_da;
+
+/* runs shorter than this are insertion sorted before merging */
+#define BOT_SORT_RUN 16
+
 struct spatial_partition_s {
     struct bvh_flat_node *root;
     triangle_s *tris;
     fastf_t *vertex_normals; /* for deallocation, access normals
 				through triangle_s */
+    long nnodes;
+    size_t max_prims_in_node;
+    void *blob; /* when loaded from the prep cache, root, tris and
+		   vertex_normals all point into this one buffer */
 };
 
+
 /**
- * Given a pointer to a GED database record, and a transformation
- * matrix, determine if this is a valid BOT, and if so, precompute
- * various terms of the formula.
- *
- * Returns -
- * 0 BOT is OK
- * !0 Error in description
- *
- * Implicit return -
- * A struct bot_specific is created, and its address is stored in
- * stp->st_specific for use by bot_shot().
+ * Copy the settings the shot routines need from bot_ip into a new
+ * bot_specific hung off of stp.
  */
-int
-rt_bot_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
+static struct bot_specific *
+bot_specific_setup(struct soltab *stp, const struct rt_bot_internal *bot_ip)
 {
-    RT_CK_DB_INTERNAL(ip);
-    struct rt_bot_internal *bot_ip = (struct rt_bot_internal *)ip->idb_ptr;
-    RT_BOT_CK_MAGIC(bot_ip);
-
-    if (!bot_ip->num_faces || !bot_ip->num_vertices)
-	return -1;
-
-    struct bn_tol defaults = BN_TOL_INIT_TOL;
-    struct bn_tol *tolp;
-    if (rtip) {
-	tolp = &rtip->rti_tol;
-    } else {
-	rt_tol_default(&defaults);
-	tolp = &defaults;
-    }
-
     // Copy settings over to bot, because we won't have access to
     // bot_ip in the shot function
     struct bot_specific *bot;
@@ -414,11 +414,79 @@ rt_bot_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
     }
     bot->bot_facelist = NULL;
 
+    return bot;
+}
+
+
+/**
+ * Set the soltab bounding volume from the root of the BVH.
+ */
+static void
+bot_set_bounds(struct soltab *stp, const struct spatial_partition_s *sps, const struct bn_tol *tolp)
+{
+    // struct bvh_build_node and struct bvh_flat_node are puns for fastf_t[6] which are the bounds
+    fastf_t *min = (fastf_t *)sps->root;
+    fastf_t *max = &min[3];
+
+    VMOVE(stp->st_min, min);
+    VMOVE(stp->st_max, max);
+
+    /* zero thickness will get missed by the raytracer */
+    BBOX_NONDEGEN(stp->st_min, stp->st_max, tolp->dist);
+
+    VADD2SCALE(stp->st_center, min, max, 0.5);
+    point_t dist_vec;
+    VSUB2SCALE(dist_vec, max, min, 0.5);
+    stp->st_aradius = FMAX(dist_vec[0], FMAX(dist_vec[1], dist_vec[2]));
+    stp->st_bradius = MAGNITUDE(dist_vec);
+}
+
+
+static size_t
+bot_max_prims_in_node(void)
+{
     // look for a requested bundle size
-    size_t bot_max_prims_in_node = RT_DEFAULT_MAX_PRIMS_IN_NODE ;
+    size_t max_prims_in_node = RT_DEFAULT_MAX_PRIMS_IN_NODE;
     const char *bmintie = getenv("LIBRT_BOT_MINTIE");
     if (bmintie)
-	bot_max_prims_in_node = atoi(bmintie);
+	max_prims_in_node = atoi(bmintie);
+    return max_prims_in_node;
+}
+
+/**
+ * Given a pointer to a GED database record, and a transformation
+ * matrix, determine if this is a valid BOT, and if so, precompute
+ * various terms of the formula.
+ *
+ * Returns -
+ * 0 BOT is OK
+ * !0 Error in description
+ *
+ * Implicit return -
+ * A struct bot_specific is created, and its address is stored in
+ * stp->st_specific for use by bot_shot().
+ */
+int
+rt_bot_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
+{
+    RT_CK_DB_INTERNAL(ip);
+    struct rt_bot_internal *bot_ip = (struct rt_bot_internal *)ip->idb_ptr;
+    RT_BOT_CK_MAGIC(bot_ip);
+
+    if (!bot_ip->num_faces || !bot_ip->num_vertices)
+	return -1;
+
+    struct bn_tol defaults = BN_TOL_INIT_TOL;
+    struct bn_tol *tolp;
+    if (rtip) {
+	tolp = &rtip->rti_tol;
+    } else {
+	rt_tol_default(&defaults);
+	tolp = &defaults;
+    }
+
+    struct bot_specific *bot = bot_specific_setup(stp, bot_ip);
+    size_t max_prims_in_node = bot_max_prims_in_node();
 
     // set up centroids and bounds for hlbvh call
     fastf_t *centroids = (fastf_t*)bu_malloc(bot_ip->num_faces * sizeof(fastf_t)*3, "bot centroids");
@@ -441,7 +509,7 @@ rt_bot_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
     // implicit return values
     long nodes_created = 0;
     long *ordered_faces = NULL;
-    struct bvh_build_node *build_root = hlbvh_create(bot_max_prims_in_node, pool, centroids, bounds, &nodes_created,
+    struct bvh_build_node *build_root = hlbvh_create(max_prims_in_node, pool, centroids, bounds, &nodes_created,
 					       bot_ip->num_faces, &ordered_faces);
 
     bu_free(centroids, "bot centroids");
@@ -524,27 +592,193 @@ rt_bot_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
     sps->root = flat_root;
     sps->tris = tris;
     sps->vertex_normals = tri_norms;
+    sps->nnodes = nodes_created;
+    sps->max_prims_in_node = max_prims_in_node;
+    sps->blob = NULL;
 
     bot->tie = (void *)sps;
 
-    // struct bvh_build_node and struct bvh_flat_node are puns for fastf_t[6] which are the bounds
-    fastf_t *min = (fastf_t *)sps->root;
-    fastf_t *max = &min[3];
+    bot_set_bounds(stp, sps, tolp);
 
-    VMOVE(stp->st_min, min);
-    VMOVE(stp->st_max, max);
+#ifdef USE_OPENCL
+    clt_bot_prep(stp, bot_ip, rtip);
+#endif
+    return 0;
+}
 
-    /* zero thickness will get missed by the raytracer */
-    BBOX_NONDEGEN(stp->st_min, stp->st_max, tolp->dist);
 
-    VADD2SCALE(stp->st_center, min, max, 0.5);
-    point_t dist_vec;
-    VSUB2SCALE(dist_vec, max, min, 0.5);
-    stp->st_aradius = FMAX(dist_vec[0], FMAX(dist_vec[1], dist_vec[2]));
-    stp->st_bradius = MAGNITUDE(dist_vec);
+/* Prep cache layout.  The blob is native-endian and native-width
+ * (the magic and fastf_t size catch a mismatch) so that on load the
+ * decompressed buffer can be used in place: only the node child and
+ * triangle normal pointers, which are stored as indices, need to be
+ * fixed up.  Every section begins on an 8 byte boundary.
+ */
+#define BOT_CACHE_MAGIC 0x424f5448 /**< BOTH */
+#define BOT_CACHE_ALIGN(_n) (((_n) + 7) & ~((size_t)7))
+
+struct bot_cache_header {
+    uint32_t magic;
+    uint32_t fastf_size;
+    uint64_t ntri;
+    uint64_t nnodes;
+    uint64_t max_prims_in_node;
+    uint64_t nnorms;
+};
+
+
+int
+rt_bot_prep_serialize(struct soltab *stp, const struct rt_db_internal *ip, struct bu_external *external, size_t *version)
+{
+    const size_t current_version = 0;
+
+    RT_CK_SOLTAB(stp);
+    RT_CK_DB_INTERNAL(ip);
+    BU_CK_EXTERNAL(external);
+
+    if (stp->st_specific) {
+	/* export to external */
+	struct bot_specific *bot = (struct bot_specific *)stp->st_specific;
+	struct spatial_partition_s *sps = (struct spatial_partition_s *)bot->tie;
+	if (!sps)
+	    return 1;
+
+	struct bot_cache_header hdr;
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.magic = BOT_CACHE_MAGIC;
+	hdr.fastf_size = (uint32_t)sizeof(fastf_t);
+	hdr.ntri = bot->bot_ntri;
+	hdr.nnodes = sps->nnodes;
+	hdr.max_prims_in_node = sps->max_prims_in_node;
+	hdr.nnorms = (sps->vertex_normals) ? bot->bot_ntri * 9 : 0;
+
+	size_t hdr_size = BOT_CACHE_ALIGN(sizeof(hdr));
+	size_t node_size = BOT_CACHE_ALIGN(hdr.nnodes * sizeof(struct bvh_flat_node));
+	size_t tri_size = BOT_CACHE_ALIGN(hdr.ntri * sizeof(triangle_s));
+	size_t norm_size = hdr.nnorms * sizeof(fastf_t);
+
+	/* The cache compresses blobs with int sized calls, so BoTs past
+	 * roughly 16M triangles are prepped every time instead.
+	 */
+	if (hdr_size + node_size + tri_size + norm_size >= INT_MAX)
+	    return 1;
+
+	uint8_t *buf = (uint8_t *)bu_calloc(1, hdr_size + node_size + tri_size + norm_size, "bot prep cache blob");
+	memcpy(buf, &hdr, sizeof(hdr));
+
+	struct bvh_flat_node *nodes = (struct bvh_flat_node *)(buf + hdr_size);
+	memcpy(nodes, sps->root, hdr.nnodes * sizeof(struct bvh_flat_node));
+	for (size_t i = 0; i < hdr.nnodes; i++) {
+	    if (nodes[i].n_primitives > 0)
+		continue;
+	    nodes[i].data.first_prim_offset = nodes[i].data.other_child - sps->root;
+	}
+
+	triangle_s *tris = (triangle_s *)(buf + hdr_size + node_size);
+	memcpy(tris, sps->tris, hdr.ntri * sizeof(triangle_s));
+	for (size_t i = 0; i < hdr.ntri; i++) {
+	    /* index + 1 so that zero still means "no normals" */
+	    size_t nidx = (tris[i].norms) ? (size_t)(tris[i].norms - sps->vertex_normals) + 1 : 0;
+	    tris[i].norms = NULL;
+	    memcpy(&tris[i].norms, &nidx, sizeof(size_t));
+	}
+
+	if (norm_size)
+	    memcpy(buf + hdr_size + node_size + tri_size, sps->vertex_normals, norm_size);
+
+	external->ext_buf = buf;
+	external->ext_nbytes = hdr_size + node_size + tri_size + norm_size;
+	*version = current_version;
+	return 0;
+    }
+
+    /* load from external */
+
+    if (*version != current_version)
+	return 1;
+
+    struct rt_bot_internal *bot_ip = (struct rt_bot_internal *)ip->idb_ptr;
+    RT_BOT_CK_MAGIC(bot_ip);
+
+    if (!external->ext_buf || external->ext_nbytes < sizeof(struct bot_cache_header))
+	return 1;
+
+    struct bot_cache_header hdr;
+    memcpy(&hdr, external->ext_buf, sizeof(hdr));
+    if (hdr.magic != BOT_CACHE_MAGIC
+	|| hdr.fastf_size != sizeof(fastf_t)
+	|| hdr.ntri != bot_ip->num_faces
+	|| hdr.max_prims_in_node != bot_max_prims_in_node()
+	|| (hdr.nnorms && hdr.nnorms != hdr.ntri * 9))
+	return 1;
+
+    size_t hdr_size = BOT_CACHE_ALIGN(sizeof(hdr));
+    size_t node_size = BOT_CACHE_ALIGN(hdr.nnodes * sizeof(struct bvh_flat_node));
+    size_t tri_size = BOT_CACHE_ALIGN(hdr.ntri * sizeof(triangle_s));
+    size_t norm_size = hdr.nnorms * sizeof(fastf_t);
+    if (!hdr.nnodes || external->ext_nbytes != hdr_size + node_size + tri_size + norm_size)
+	return 1;
+
+    uint8_t *buf = external->ext_buf;
+    struct bvh_flat_node *nodes = (struct bvh_flat_node *)(buf + hdr_size);
+    triangle_s *tris = (triangle_s *)(buf + hdr_size + node_size);
+    fastf_t *norms = (norm_size) ? (fastf_t *)(buf + hdr_size + node_size + tri_size) : NULL;
+
+    /* validate every index before touching anything */
+    for (size_t i = 0; i < hdr.nnodes; i++) {
+	long off = nodes[i].data.first_prim_offset;
+	if (nodes[i].n_primitives > 0) {
+	    if (off < 0 || (uint64_t)(off + nodes[i].n_primitives) > hdr.ntri)
+		return 1;
+	} else if (off <= (long)i || (uint64_t)off >= hdr.nnodes) {
+	    return 1;
+	}
+    }
+    for (size_t i = 0; i < hdr.ntri; i++) {
+	size_t nidx;
+	memcpy(&nidx, &tris[i].norms, sizeof(size_t));
+	if (nidx && (!norms || nidx - 1 + 9 > hdr.nnorms))
+	    return 1;
+    }
+
+    /* fix up pointers in place */
+    for (size_t i = 0; i < hdr.nnodes; i++) {
+	if (nodes[i].n_primitives > 0)
+	    continue;
+	nodes[i].data.other_child = &nodes[nodes[i].data.first_prim_offset];
+    }
+    for (size_t i = 0; i < hdr.ntri; i++) {
+	size_t nidx;
+	memcpy(&nidx, &tris[i].norms, sizeof(size_t));
+	tris[i].norms = (nidx) ? &norms[nidx - 1] : NULL;
+    }
+
+    struct bot_specific *bot = bot_specific_setup(stp, bot_ip);
+
+    struct spatial_partition_s *sps;
+    BU_GET(sps, struct spatial_partition_s);
+    sps->root = nodes;
+    sps->tris = tris;
+    sps->vertex_normals = norms;
+    sps->nnodes = (long)hdr.nnodes;
+    sps->max_prims_in_node = hdr.max_prims_in_node;
+    /* take ownership of the buffer rather than copying it */
+    sps->blob = buf;
+    external->ext_buf = NULL;
+    external->ext_nbytes = 0;
+
+    bot->tie = (void *)sps;
+
+    struct bn_tol defaults = BN_TOL_INIT_TOL;
+    const struct bn_tol *tolp = &defaults;
+    if (stp->st_rtip) {
+	tolp = &stp->st_rtip->rti_tol;
+    } else {
+	rt_tol_default(&defaults);
+    }
+    bot_set_bounds(stp, sps, tolp);
 
 #ifdef USE_OPENCL
-    clt_bot_prep(stp, bot_ip, rtip);
+    clt_bot_prep(stp, bot_ip, stp->st_rtip);
 #endif
     return 0;
 }
@@ -566,8 +800,54 @@ rt_bot_makesegs(hit_da *hits,
 		struct rt_piecestate *psp);
 
 
+static void
+bot_cand_grow(cand_da *cands)
+{
+    size_t capacity = (cands->capacity) ? cands->capacity * 2 : DA_INIT_CAPACITY;
+
+    cands->dist = (fastf_t *)bu_realloc(cands->dist, capacity * sizeof(fastf_t), "bot cand dist");
+    cands->vpriv = (fastf_t *)bu_realloc(cands->vpriv, capacity * 3 * sizeof(fastf_t), "bot cand vpriv");
+    cands->tri = (triangle_s **)bu_realloc(cands->tri, capacity * sizeof(triangle_s *), "bot cand tri");
+    cands->order = (size_t *)bu_realloc(cands->order, capacity * sizeof(size_t), "bot cand order");
+    cands->scratch = (size_t *)bu_realloc(cands->scratch, capacity * sizeof(size_t), "bot cand scratch");
+    cands->capacity = capacity;
+}
+
+
+static inline void
+bot_cand_append(cand_da *cands, fastf_t dist, fastf_t dot, fastf_t gamma, fastf_t beta, triangle_s *tri)
+{
+    size_t n = cands->count;
+
+    if (UNLIKELY(n >= cands->capacity))
+	bot_cand_grow(cands);
+
+    cands->dist[n] = dist;
+    cands->vpriv[3*n+X] = dot;
+    cands->vpriv[3*n+Y] = gamma;
+    cands->vpriv[3*n+Z] = beta;
+    cands->tri[n] = tri;
+    cands->count = n + 1;
+}
+
+
+static void
+bot_cand_free(cand_da *cands)
+{
+    if (!cands->capacity)
+	return;
+
+    bu_free(cands->dist, "bot cand dist");
+    bu_free(cands->vpriv, "bot cand vpriv");
+    bu_free(cands->tri, "bot cand tri");
+    bu_free(cands->order, "bot cand order");
+    bu_free(cands->scratch, "bot cand scratch");
+    memset(cands, 0, sizeof(cand_da));
+}
+
+
 void
-bot_shot_hlbvh_flat(struct bvh_flat_node *root, struct xray* rp, triangle_s *tris, size_t ntris, hit_da* hits, fastf_t toldist)
+bot_shot_hlbvh_flat(struct bvh_flat_node *root, struct xray* rp, triangle_s *tris, size_t ntris, cand_da *cands, fastf_t toldist)
 {
     struct bvh_flat_node *stack_node[HLBVH_STACK_SIZE];
     unsigned char stack_child_index[HLBVH_STACK_SIZE];
@@ -656,17 +936,8 @@ bot_shot_hlbvh_flat(struct bvh_flat_node *root, struct xray* rp, triangle_s *tri
 
 		fastf_t dist = VDOT(wxb, wn) / dn;
 
-		// Fill out hitdata
-		struct hit cur_hit = {0};
-		cur_hit.hit_magic = RT_HIT_MAGIC;
-		cur_hit.hit_dist = dist;
-		cur_hit.hit_vpriv[X] = VDOT(tri->face_norm, rp->r_dir);
-		cur_hit.hit_vpriv[Y] = gamma / abs_dn;
-		cur_hit.hit_vpriv[Z] =  beta / abs_dn;
-		cur_hit.hit_private = tri;
-		cur_hit.hit_surfno = tri->face_id;
-		cur_hit.hit_rayp = rp;
-		DA_APPEND(hits, cur_hit, struct hit);
+		// Record the candidate, hitdata is filled out after sorting
+		bot_cand_append(cands, dist, VDOT(tri->face_norm, rp->r_dir), gamma / abs_dn, beta / abs_dn, tri);
 	    }
 	    stack_ind--;
 	    continue;
@@ -684,7 +955,267 @@ bot_shot_hlbvh_flat(struct bvh_flat_node *root, struct xray* rp, triangle_s *tri
 }
 
 
-THREADLOCAL hit_da hits_per_cpu = {0};
+/**
+ * Packet version of bot_shot_hlbvh_flat().  The BVH is walked once
+ * for up to BOT_PACKET_SIZE rays, descending into a node when any
+ * active ray of the packet enters its bounds.  Ray data is kept in
+ * structure-of-arrays form and the slab and triangle tests are
+ * branch-free loops over the packet lanes so that they vectorize.
+ * Candidates for rays[i] are appended to cands[i] exactly as the
+ * scalar traversal would produce them.
+ */
+static void
+bot_shot_hlbvh_flat_packet(struct bvh_flat_node *root, struct xray **rays, int nrays, triangle_s *tris, size_t ntris, cand_da *cands, fastf_t toldist)
+{
+    fastf_t org[3][BOT_PACKET_SIZE];
+    fastf_t dir[3][BOT_PACKET_SIZE];
+    fastf_t inv[3][BOT_PACKET_SIZE];
+    struct bvh_flat_node *stack_node[HLBVH_STACK_SIZE];
+    unsigned int stack_mask[HLBVH_STACK_SIZE];
+    int stack_ind = 0;
+    int i;
+
+    BU_ASSERT(nrays > 0 && nrays <= BOT_PACKET_SIZE);
+
+    // unused lanes replicate the first ray and are masked off
+    for (i = 0; i < BOT_PACKET_SIZE; i++) {
+	struct xray *rp = rays[(i < nrays) ? i : 0];
+	vect_t inverse_r_dir;
+	VINVDIR(inverse_r_dir, rp->r_dir);
+	for (int a = X; a <= Z; a++) {
+	    org[a][i] = rp->r_pt[a];
+	    dir[a][i] = rp->r_dir[a];
+	    inv[a][i] = inverse_r_dir[a];
+	}
+    }
+
+    stack_node[stack_ind] = root;
+    stack_mask[stack_ind] = (1u << nrays) - 1;
+    stack_ind++;
+
+    while (stack_ind > 0) {
+	stack_ind--;
+	struct bvh_flat_node *node = stack_node[stack_ind];
+	unsigned int mask = stack_mask[stack_ind];
+	int lane_hit[BOT_PACKET_SIZE];
+
+	// slab test of every lane against the node bounds
+	for (i = 0; i < BOT_PACKET_SIZE; i++) {
+	    fastf_t t0 = (node->bounds[0+X] - org[X][i]) * inv[X][i];
+	    fastf_t t1 = (node->bounds[3+X] - org[X][i]) * inv[X][i];
+	    fastf_t low_t = FMIN(t0, t1);
+	    fastf_t high_t = FMAX(t0, t1);
+	    t0 = (node->bounds[0+Y] - org[Y][i]) * inv[Y][i];
+	    t1 = (node->bounds[3+Y] - org[Y][i]) * inv[Y][i];
+	    low_t = FMAX(low_t, FMIN(t0, t1));
+	    high_t = FMIN(high_t, FMAX(t0, t1));
+	    t0 = (node->bounds[0+Z] - org[Z][i]) * inv[Z][i];
+	    t1 = (node->bounds[3+Z] - org[Z][i]) * inv[Z][i];
+	    low_t = FMAX(low_t, FMIN(t0, t1));
+	    high_t = FMIN(high_t, FMAX(t0, t1));
+	    lane_hit[i] = !((high_t < -1.0) | (low_t > high_t));
+	}
+	for (i = 0; i < BOT_PACKET_SIZE; i++) {
+	    if (!lane_hit[i])
+		mask &= ~(1u << i);
+	}
+	if (!mask)
+	    continue;
+
+	if (node->n_primitives > 0) {
+	    size_t end = node->data.first_prim_offset + node->n_primitives;
+	    BU_ASSERT(end <= ntris);
+	    for (size_t t = node->data.first_prim_offset; t < end; t++) {
+		triangle_s* tri = &tris[t];
+		fastf_t abs_dn[BOT_PACKET_SIZE], dot[BOT_PACKET_SIZE];
+		fastf_t beta[BOT_PACKET_SIZE], gamma[BOT_PACKET_SIZE];
+		fastf_t dist[BOT_PACKET_SIZE];
+		int pass[BOT_PACKET_SIZE];
+		vect_t wn;
+
+		// Calculate non-unitized face normal
+		VSCALE(wn, tri->face_norm, tri->face_norm_scalar);
+
+		// same test as bot_shot_hlbvh_flat(), one lane per ray
+		for (i = 0; i < BOT_PACKET_SIZE; i++) {
+		    fastf_t wxb[3], xp[3];
+		    fastf_t d = wn[X]*dir[X][i] + wn[Y]*dir[Y][i] + wn[Z]*dir[Z][i];
+		    fastf_t ad = (d >= 0.0) ? d : -d;
+		    fastf_t dn_plus_tol = ad + toldist * (1.0 / (1.0 + ad));
+		    fastf_t b, g;
+
+		    wxb[X] = tri->A[X] - org[X][i];
+		    wxb[Y] = tri->A[Y] - org[Y][i];
+		    wxb[Z] = tri->A[Z] - org[Z][i];
+		    xp[X] = wxb[Y]*dir[Z][i] - wxb[Z]*dir[Y][i];
+		    xp[Y] = wxb[Z]*dir[X][i] - wxb[X]*dir[Z][i];
+		    xp[Z] = wxb[X]*dir[Y][i] - wxb[Y]*dir[X][i];
+		    b = VDOT(tri->AB, xp);
+		    g = VDOT(tri->AC, xp);
+		    b = (d > 0.0) ? -b : b;
+		    g = (d < 0.0) ? -g : g;
+
+		    abs_dn[i] = ad;
+		    dot[i] = tri->face_norm[X]*dir[X][i] + tri->face_norm[Y]*dir[Y][i] + tri->face_norm[Z]*dir[Z][i];
+		    beta[i] = b;
+		    gamma[i] = g;
+		    dist[i] = VDOT(wxb, wn) / ((ad < BOT_MIN_DN) ? 1.0 : d);
+		    pass[i] = (ad >= BOT_MIN_DN)
+			& (b + g <= dn_plus_tol)
+			& (b >= -toldist)
+			& (g >= -toldist);
+		}
+
+		for (i = 0; i < nrays; i++) {
+		    if (!(mask & (1u << i)) || !pass[i])
+			continue;
+
+		    bot_cand_append(&cands[i], dist[i], dot[i], gamma[i] / abs_dn[i], beta[i] / abs_dn[i], tri);
+		}
+	    }
+	    continue;
+	}
+
+	if (UNLIKELY(stack_ind + 2 > HLBVH_STACK_SIZE))
+	    bu_bomb("Stack size exceeded in bot packet shot");
+
+	stack_node[stack_ind] = node->data.other_child;
+	stack_mask[stack_ind] = mask;
+	stack_ind++;
+	stack_node[stack_ind] = node + 1;
+	stack_mask[stack_ind] = mask;
+	stack_ind++;
+    }
+}
+
+
+/**
+ * Order the candidates by increasing distance along the ray.  Only the
+ * permutation in cands->order is sorted, with a bottom-up merge sort
+ * over insertion sorted runs, so dense meshes no longer pay the O(n^2)
+ * of sorting whole struct hit records in place.  A candidate is placed
+ * ahead of earlier candidates at the same distance, which is the order
+ * the previous insertion sort produced.
+ */
+static void
+bot_sort_cands(cand_da *cands)
+{
+    size_t n = cands->count;
+    const fastf_t *dist = cands->dist;
+    size_t *order = cands->order;
+    size_t *scratch = cands->scratch;
+    size_t i, lo, width;
+
+    for (i = 0; i < n; i++)
+	order[i] = i;
+
+    for (lo = 0; lo < n; lo += BOT_SORT_RUN) {
+	size_t hi = (n - lo > BOT_SORT_RUN) ? lo + BOT_SORT_RUN : n;
+	for (i = lo + 1; i < hi; i++) {
+	    size_t cur = order[i];
+	    size_t j = i;
+	    while (j > lo && !(dist[order[j-1]] < dist[cur])) {
+		order[j] = order[j-1];
+		j--;
+	    }
+	    order[j] = cur;
+	}
+    }
+
+    for (width = BOT_SORT_RUN; width < n; width *= 2) {
+	size_t *swap;
+	for (lo = 0; lo < n; lo += 2 * width) {
+	    size_t mid = (n - lo > width) ? lo + width : n;
+	    size_t hi = (n - mid > width) ? mid + width : n;
+	    size_t l = lo, r = mid, k = lo;
+	    while (l < mid && r < hi)
+		scratch[k++] = (dist[order[l]] < dist[order[r]]) ? order[l++] : order[r++];
+	    while (l < mid)
+		scratch[k++] = order[l++];
+	    while (r < hi)
+		scratch[k++] = order[r++];
+	}
+	swap = order;
+	order = scratch;
+	scratch = swap;
+    }
+
+    cands->order = order;
+    cands->scratch = scratch;
+}
+
+
+/**
+ * Build the struct hit array rt_bot_makesegs() consumes from sorted
+ * candidates.  The array is reused between rays.
+ */
+static void
+bot_cand_hits(hit_da *hits, const cand_da *cands, struct xray *rp)
+{
+    size_t i;
+
+    if (hits->capacity < cands->count) {
+	hits->items = (struct hit *)bu_realloc(hits->items, cands->capacity * sizeof(struct hit), "DA realloc hits");
+	hits->capacity = cands->capacity;
+    }
+
+    for (i = 0; i < cands->count; i++) {
+	size_t k = cands->order[i];
+	struct hit *hitp = &hits->items[i];
+
+	*hitp = zeroed_hit_s;
+	hitp->hit_dist = cands->dist[k];
+	VMOVE(hitp->hit_vpriv, &cands->vpriv[3*k]);
+	hitp->hit_private = cands->tri[k];
+	hitp->hit_surfno = cands->tri[k]->face_id;
+	hitp->hit_rayp = rp;
+    }
+    hits->count = cands->count;
+}
+
+
+/* Candidate and hit buffers reused from ray to ray.  They hang off
+ * the application's resource, so each processor has its own and
+ * rt_clean_resource() releases them with the rest of the resource.
+ */
+struct bot_scratch {
+    cand_da cands;
+    cand_da packet_cands[BOT_PACKET_SIZE];
+    hit_da hits;
+};
+
+
+static struct bot_scratch *
+bot_scratch_get(struct application *ap)
+{
+    struct resource *resp = ap->a_resource ? ap->a_resource : &rt_uniresource;
+
+    if (UNLIKELY(!resp->re_bot_scratch))
+	resp->re_bot_scratch = bu_calloc(1, sizeof(struct bot_scratch), "struct bot_scratch");
+
+    return (struct bot_scratch *)resp->re_bot_scratch;
+}
+
+
+void
+rt_bot_scratch_free(struct resource *resp)
+{
+    struct bot_scratch *scr;
+    int i;
+
+    if (!resp || !resp->re_bot_scratch)
+	return;
+
+    scr = (struct bot_scratch *)resp->re_bot_scratch;
+    if (scr->hits.capacity)
+	bu_free(scr->hits.items, "DA free");
+    bot_cand_free(&scr->cands);
+    for (i = 0; i < BOT_PACKET_SIZE; i++)
+	bot_cand_free(&scr->packet_cands[i]);
+
+    bu_free(scr, "struct bot_scratch");
+    resp->re_bot_scratch = NULL;
+}
 
 
 /**
@@ -715,7 +1246,8 @@ rt_bot_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct
     if (UNLIKELY(!sps))
 	return 0;
 
-    hits_per_cpu.count = 0; // New ray, new result count
+    struct bot_scratch *scr = bot_scratch_get(ap);
+    scr->cands.count = 0; // New ray, new result count
 
     fastf_t toldist = 0.0;
     if (bot->bot_orientation != RT_BOT_UNORIENTED && bot->bot_mode == RT_BOT_SOLID) {
@@ -725,32 +1257,121 @@ rt_bot_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct
 	toldist = (DBL_EPSILON * stp->st_aradius * 10);
     }
 
-    bot_shot_hlbvh_flat(sps->root, rp, sps->tris, bot->bot_ntri, &hits_per_cpu, toldist);
+    bot_shot_hlbvh_flat(sps->root, rp, sps->tris, bot->bot_ntri, &scr->cands, toldist);
 
-    if (hits_per_cpu.count == 0) {
+    if (scr->cands.count == 0) {
 	return 0;
     }
-    // sort the hits
-    // insertion sort
-    {
-	size_t nhits = hits_per_cpu.count;
-	struct hit *hits = hits_per_cpu.items;
-	for (size_t i = 1; i < nhits; i++) {
-	    fastf_t i_dist = hits[i].hit_dist;
-	    struct hit swap = hits[i];
-	    int j;
-	    for (j = i-1; j >= 0; j--) {
-		fastf_t j_dist = hits[j].hit_dist;
-		if (j_dist < i_dist) {
-		    break;
-		}
-		hits[j+1] = hits[j];
-	    }
-	    hits[j+1] = swap;
+    bot_sort_cands(&scr->cands);
+    bot_cand_hits(&scr->hits, &scr->cands, rp);
+
+    return rt_bot_makesegs(&scr->hits, stp, rp, ap, seghead, NULL);
+}
+
+
+/**
+ * Intersect a packet of rays with a bot.  The flattened BVH is walked
+ * once per BOT_PACKET_SIZE rays rather than once per ray, which pays
+ * off when the rays are coherent (e.g., neighboring primary rays).
+ * Segments for rays[i] are added to seghead[i] and the per-ray result
+ * rt_bot_shot() would have returned is stored in ret[i].
+ */
+void
+rt_bot_shot_packet(struct soltab *stp, struct xray **rays, int nrays, struct application *ap, struct seg *seghead, int *ret)
+{
+    int i;
+
+    for (i = 0; i < nrays; i++)
+	ret[i] = 0;
+
+    if (UNLIKELY(!stp || !ap || !seghead || nrays <= 0))
+	return;
+
+    struct bot_specific *bot = (struct bot_specific *)stp->st_specific;
+    if (UNLIKELY(!bot))
+	return;
+
+    struct spatial_partition_s *sps = (struct spatial_partition_s *)bot->tie;
+    if (UNLIKELY(!sps))
+	return;
+
+    struct bot_scratch *scr = bot_scratch_get(ap);
+    cand_da *cands = scr->packet_cands;
+
+    fastf_t toldist = 0.0;
+    if (bot->bot_orientation != RT_BOT_UNORIENTED && bot->bot_mode == RT_BOT_SOLID) {
+	// same tolerance as rt_bot_shot()
+	toldist = (DBL_EPSILON * stp->st_aradius * 10);
+    }
+
+    for (int start = 0; start < nrays; start += BOT_PACKET_SIZE) {
+	int n = nrays - start;
+	if (n > BOT_PACKET_SIZE)
+	    n = BOT_PACKET_SIZE;
+
+	for (i = 0; i < n; i++)
+	    cands[i].count = 0;
+
+	bot_shot_hlbvh_flat_packet(sps->root, &rays[start], n, sps->tris, bot->bot_ntri, cands, toldist);
+
+	for (i = 0; i < n; i++) {
+	    if (cands[i].count == 0)
+		continue;
+	    bot_sort_cands(&cands[i]);
+	    bot_cand_hits(&scr->hits, &cands[i], rays[start+i]);
+	    ret[start+i] = rt_bot_makesegs(&scr->hits, stp, rays[start+i], ap, &seghead[start+i], NULL);
 	}
     }
+}
+
+
+/**
+ * Vectorized bot shot.  Runs of consecutive pairs that share a solid
+ * are intersected as packets with rt_bot_shot_packet().  As with the
+ * other vshot routines, only the first segment of each ray is
+ * returned.
+ */
+void
+rt_bot_vshot(struct soltab **stp, struct xray **rp, struct seg *segp, int n, struct application *ap)
+{
+    struct seg seghead[BOT_PACKET_SIZE];
+    int ret[BOT_PACKET_SIZE];
+    int i = 0;
 
-    return rt_bot_makesegs(&hits_per_cpu, stp, rp, ap, seghead, NULL);
+    while (i < n) {
+	int run, j;
+
+	if (!stp[i]) {
+	    i++;
+	    continue;
+	}
+
+	for (run = 1; run < BOT_PACKET_SIZE && i + run < n; run++) {
+	    if (stp[i + run] != stp[i])
+		break;
+	}
+
+	for (j = 0; j < run; j++)
+	    BU_LIST_INIT(&(seghead[j].l));
+
+	rt_bot_shot_packet(stp[i], &rp[i], run, ap, seghead, ret);
+
+	for (j = 0; j < run; j++) {
+	    struct seg *first;
+
+	    if (ret[j] <= 0 || BU_LIST_IS_EMPTY(&(seghead[j].l))) {
+		segp[i+j].seg_stp = (struct soltab *)0;
+		continue;
+	    }
+	    first = BU_LIST_FIRST(seg, &(seghead[j].l));
+	    BU_LIST_DEQUEUE(&(first->l));
+	    segp[i+j] = *first; /* struct copy */
+	    RT_FREE_SEG(first, ap->a_resource);
+	    RT_FREE_SEG_LIST(&seghead[j], ap->a_resource);
+	}
+
+	i += run;
+    }
 }
 
 
@@ -879,19 +1500,17 @@ rt_bot_free(struct soltab *stp)
 
     if (bot && bot->tie) {
 	struct spatial_partition_s *sps = (struct spatial_partition_s*)bot->tie;
-	bu_free(sps->root, "bot bvh flat nodes");
-	bu_free(sps->tris, "bot triangles");
-	bu_free(sps->vertex_normals, "bot normals");
+	if (sps->blob) {
+	    bu_free(sps->blob, "bot prep cache blob");
+	} else {
+	    bu_free(sps->root, "bot bvh flat nodes");
+	    bu_free(sps->tris, "bot triangles");
+	    bu_free(sps->vertex_normals, "bot normals");
+	}
 	BU_PUT(sps, struct spatial_partition_s);
 	bot->tie = NULL;
     }
 
-    if (hits_per_cpu.capacity) {
-	bu_free(hits_per_cpu.items, "DA free");
-	hits_per_cpu.capacity = 0;
-	hits_per_cpu.items = NULL;
-    }
-
     if (bot) {
 	BU_PUT(bot, struct bot_specific);
 	stp->st_specific = NULL;
@@ -155,7 +155,7 @@ public:
 	LEAVING
     };
 
-    const ON_BrepFace& face;
+    const ON_BrepFace *face;
     fastf_t dist;
     point_t origin;
     point_t point;
@@ -172,7 +172,7 @@ public:
     int active;
 
     brep_hit(const ON_BrepFace& f, const ON_Ray& ray, const point_t p, const vect_t n, const pt2d_t _uv)
-	: face(f), trimmed(false), closeToEdge(false), oob(false), hit(CLEAN_HIT), direction(ENTERING), m_adj_face_index(0), sbv(NULL)
+	: face(&f), trimmed(false), closeToEdge(false), oob(false), hit(CLEAN_HIT), direction(ENTERING), m_adj_face_index(0), sbv(NULL)
     {
 	vect_t dir;
 	VMOVE(origin, ray.m_origin);
@@ -184,7 +184,7 @@ public:
     }
 
     brep_hit(const ON_BrepFace& f, fastf_t d, const ON_Ray& ray, const point_t p, const vect_t n, const pt2d_t _uv)
-	: face(f), dist(d), trimmed(false), closeToEdge(false), oob(false), hit(CLEAN_HIT), direction(ENTERING), m_adj_face_index(0), sbv(NULL)
+	: face(&f), dist(d), trimmed(false), closeToEdge(false), oob(false), hit(CLEAN_HIT), direction(ENTERING), m_adj_face_index(0), sbv(NULL)
     {
 	VMOVE(origin, ray.m_origin);
 	VMOVE(point, p);
@@ -192,35 +192,6 @@ public:
 	move(uv, _uv);
     }
 
-    brep_hit(const brep_hit& h)
-	: face(h.face), dist(h.dist), trimmed(h.trimmed), closeToEdge(h.closeToEdge), oob(h.oob), hit(h.hit), direction(h.direction), m_adj_face_index(h.m_adj_face_index), sbv(h.sbv)
-    {
-	VMOVE(origin, h.origin);
-	VMOVE(point, h.point);
-	VMOVE(normal, h.normal);
-	move(uv, h.uv);
-
-    }
-
-    brep_hit& operator=(const brep_hit& h)
-    {
-	const_cast<ON_BrepFace&>(face) = h.face;
-	dist = h.dist;
-	VMOVE(origin, h.origin);
-	VMOVE(point, h.point);
-	VMOVE(normal, h.normal);
-	move(uv, h.uv);
-	trimmed = h.trimmed;
-	closeToEdge = h.closeToEdge;
-	oob = h.oob;
-	sbv = h.sbv;
-	hit = h.hit;
-	direction = h.direction;
-	m_adj_face_index = h.m_adj_face_index;
-
-	return *this;
-    }
-
     bool operator==(const brep_hit& h) const
     {
 	return NEAR_ZERO(dist - h.dist, BREP_SAME_POINT_TOLERANCE);
@@ -270,11 +241,11 @@ log_key(struct bu_vls *logstr)
 
 
 static void
-log_hits(std::list<brep_hit> &hits, int UNUSED(verbosity))
+log_hits(std::vector<brep_hit> &hits, int UNUSED(verbosity))
 {
     struct bu_vls logstr = BU_VLS_INIT_ZERO;
     log_key(&logstr);
-    for (std::list<brep_hit>::iterator i = hits.begin(); i != hits.end(); ++i) {
+    for (std::vector<brep_hit>::iterator i = hits.begin(); i != hits.end(); ++i) {
 	point_t prev = VINIT_ZERO;
 
 	const brep_hit &out = *i;
@@ -283,7 +254,7 @@ log_hits(std::list<brep_hit> &hits, int UNUSED(verbosity))
 	    bu_vls_printf(&logstr, "<%g>", DIST_PNT_PNT(out.point, prev));
 	}
 	bu_vls_printf(&logstr, "{");
-	bu_vls_printf(&logstr, "%s(%d)", brep_hit_type_str((int)out.hit), out.face.m_face_index);
+	bu_vls_printf(&logstr, "%s(%d)", brep_hit_type_str((int)out.hit), out.face->m_face_index);
 	if (out.direction == brep_hit::ENTERING) bu_vls_printf(&logstr, "+");
 	if (out.direction == brep_hit::LEAVING) bu_vls_printf(&logstr, "-");
 	bu_vls_printf(&logstr, "[%d]", out.sbv->get_face().m_bRev);
@@ -306,7 +277,7 @@ log_subset(std::vector<brep_hit*> &hits, size_t min, size_t max, brep_hit *pprev
 	    bu_vls_printf(&logstr, "<%g>", DIST_PNT_PNT(hits[i]->point, prev->point));
 	}
 	bu_vls_printf(&logstr, "{");
-	bu_vls_printf(&logstr, "%s(%d)", brep_hit_type_str((int)hits[i]->hit), hits[i]->face.m_face_index);
+	bu_vls_printf(&logstr, "%s(%d)", brep_hit_type_str((int)hits[i]->hit), hits[i]->face->m_face_index);
 	if (hits[i]->direction == brep_hit::ENTERING) bu_vls_printf(&logstr, "+");
 	if (hits[i]->direction == brep_hit::LEAVING) bu_vls_printf(&logstr, "-");
 	bu_vls_printf(&logstr, "[%d]", hits[i]->sbv->get_face().m_bRev);
@@ -346,6 +317,8 @@ brep_specific_delete(struct brep_specific* bs)
     if (bs != NULL) {
 	delete bs->brep;
 	delete bs->bvh;
+	if (bs->flat)
+	    bu_free(bs->flat, "brep flat bvh");
 	bu_free(bs, "brep_specific_delete");
     }
 }
@@ -393,6 +366,52 @@ brep_build_bvh_surface_tree(int cpu, void *data)
 }
 
 
+static void
+brep_flatten_node(const BBNode *node, std::vector<struct brep_flat_node> &nodes)
+{
+    // Trimmed away leaves can never be hit, so leave them out
+    if (node->isLeaf() && node->m_trimmed)
+	return;
+
+    size_t ind = nodes.size();
+    struct brep_flat_node n;
+    VMOVE(n.min, node->m_node.m_min);
+    VMOVE(n.max, node->m_node.m_max);
+    n.leaf = (node->isLeaf()) ? node : NULL;
+    n.skip = 0;
+    nodes.push_back(n);
+
+    const std::vector<BBNode *> &children = node->get_children();
+    for (size_t i = 0; i < children.size(); i++) {
+	brep_flatten_node(children[i], nodes);
+    }
+    nodes[ind].skip = nodes.size();
+}
+
+
+/* Store the bvh as an array in depth-first order, so shooting walks
+ * contiguous memory instead of chasing child pointers.
+ */
+static void
+brep_flatten_bvh(struct brep_specific *bs)
+{
+    std::vector<struct brep_flat_node> nodes;
+
+    if (bs->flat)
+	bu_free(bs->flat, "brep flat bvh");
+    bs->flat = NULL;
+    bs->flat_cnt = 0;
+
+    brep_flatten_node(bs->bvh, nodes);
+    if (nodes.empty())
+	return;
+
+    bs->flat = (struct brep_flat_node *)bu_malloc(nodes.size() * sizeof(struct brep_flat_node), "brep flat bvh");
+    memcpy(bs->flat, &nodes[0], nodes.size() * sizeof(struct brep_flat_node));
+    bs->flat_cnt = nodes.size();
+}
+
+
 static int
 brep_build_bvh(struct brep_specific* bs)
 {
@@ -545,6 +564,7 @@ rt_brep_prep(struct soltab *stp, struct rt_db_internal* ip, struct rt_i* rtip)
     /* Once a proper SurfaceTree is built, finalize the bounding
      * volumes.  This takes no time. */
     bs->bvh->GetBBox(stp->st_min, stp->st_max);
+    brep_flatten_bvh(bs);
 
     // expand outer bounding box just a little bit
     point_t adjust;
@@ -846,7 +866,7 @@ utah_newton_4corner_solver(const BBNode* sbv, const ON_Surface* surf, const ON_R
 
 
 static int
-utah_brep_intersect(const BBNode* sbv, const ON_BrepFace* face, const ON_Surface* surf, pt2d_t& uv, const ON_Ray& ray, std::list<brep_hit>& hits)
+utah_brep_intersect(const BBNode* sbv, const ON_BrepFace* face, const ON_Surface* surf, pt2d_t& uv, const ON_Ray& ray, std::vector<brep_hit>& hits)
 {
 #define MAX_BREP_SUBDIVISION_INTERSECTS 5
     ON_3dVector N[MAX_BREP_SUBDIVISION_INTERSECTS];
@@ -952,9 +972,9 @@ sign(double val)
 
 
 static bool
-containsNearMiss(const std::list<brep_hit> *hits)
+containsNearMiss(const std::vector<brep_hit> *hits)
 {
-    for (std::list<brep_hit>::const_iterator i = hits->begin(); i != hits->end(); ++i) {
+    for (std::vector<brep_hit>::const_iterator i = hits->begin(); i != hits->end(); ++i) {
 	const brep_hit&out = *i;
 	if (out.hit == brep_hit::NEAR_MISS) {
 	    return true;
@@ -965,9 +985,9 @@ containsNearMiss(const std::list<brep_hit> *hits)
 
 
 static bool
-containsNearHit(const std::list<brep_hit> *hits)
+containsNearHit(const std::vector<brep_hit> *hits)
 {
-    for (std::list<brep_hit>::const_iterator i = hits->begin(); i != hits->end(); ++i) {
+    for (std::vector<brep_hit>::const_iterator i = hits->begin(); i != hits->end(); ++i) {
 	const brep_hit&out = *i;
 	if (out.hit == brep_hit::NEAR_HIT) {
 	    return true;
@@ -1003,8 +1023,8 @@ brep_platemode_thickness(const struct xray& ray, const brep_hit& hit, const stru
      * beyond the surface by calculating the proposed exit point's
      * distance to the surface.
      */
-    const ON_Surface* surf = hit.face.SurfaceOf();
-    const ON_BrepFace& face = hit.face;
+    const ON_Surface* surf = hit.face->SurfaceOf();
+    const ON_BrepFace& face = *hit.face;
 
 #if 0
     SurfaceTree* tree = NULL;
@@ -1044,6 +1064,85 @@ brep_platemode_thickness(const struct xray& ray, const brep_hit& hit, const stru
 }
 
 
+/* Per-processor scratch space for rt_brep_shot(), kept in
+ * resp->re_brep_scratch and reused from ray to ray so that shooting
+ * doesn't touch the allocator once it has grown to the largest hit
+ * count seen.
+ */
+struct brep_scratch {
+    std::vector<const BBNode *> leaves;
+    std::vector<brep_hit> hits;
+    std::vector<brep_hit> sort;
+};
+
+
+static struct brep_scratch *
+brep_scratch_get(struct resource *resp)
+{
+    if (UNLIKELY(!resp->re_brep_scratch))
+	resp->re_brep_scratch = (void *)new brep_scratch;
+    return (struct brep_scratch *)resp->re_brep_scratch;
+}
+
+
+void
+rt_brep_scratch_free(struct resource *resp)
+{
+    if (!resp || !resp->re_brep_scratch)
+	return;
+
+    delete (struct brep_scratch *)resp->re_brep_scratch;
+    resp->re_brep_scratch = NULL;
+}
+
+
+/* runs shorter than this are insertion sorted before merging */
+#define BREP_SORT_RUN 16
+
+/* Order hits by distance, keeping equal distances in the order found.
+ * Most rays only have a handful of hits, which are insertion sorted
+ * in place; longer lists are merged through the per-processor tmp
+ * buffer rather than std::stable_sort()'s temporary one, so sorting
+ * doesn't allocate once the buffer has grown.
+ */
+static void
+brep_sort_hits(std::vector<brep_hit> &hits, std::vector<brep_hit> &tmp)
+{
+    size_t n = hits.size();
+
+    for (size_t lo = 0; lo < n; lo += BREP_SORT_RUN) {
+	size_t hi = std::min(lo + BREP_SORT_RUN, n);
+	for (size_t i = lo + 1; i < hi; i++) {
+	    if (!(hits[i] < hits[i - 1]))
+		continue;
+	    brep_hit h = hits[i];
+	    size_t j = i;
+	    while (j > lo && h < hits[j - 1]) {
+		hits[j] = hits[j - 1];
+		j--;
+	    }
+	    hits[j] = h;
+	}
+    }
+    if (n <= BREP_SORT_RUN)
+	return;
+
+    tmp.assign(hits.begin(), hits.end());
+    std::vector<brep_hit> *src = &hits;
+    std::vector<brep_hit> *dst = &tmp;
+    for (size_t width = BREP_SORT_RUN; width < n; width *= 2) {
+	for (size_t lo = 0; lo < n; lo += 2 * width) {
+	    size_t mid = std::min(lo + width, n);
+	    size_t hi = std::min(lo + 2 * width, n);
+	    std::merge(src->begin() + lo, src->begin() + mid, src->begin() + mid, src->begin() + hi, dst->begin() + lo);
+	}
+	std::swap(src, dst);
+    }
+    if (src != &hits)
+	hits.swap(tmp);
+}
+
+
 /**
  * Intersect a ray with a brep.  If an intersection occurs, a struct
  * seg will be acquired and filled in.
@@ -1069,100 +1168,70 @@ rt_brep_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct
      * intersected, there is potentially a hit and more evaluation is
      * needed.  Otherwise, return a miss.
      */
-    std::list<const BBNode*> inters;
+    struct brep_scratch *scr = brep_scratch_get(ap->a_resource);
+    std::vector<const BBNode *> &inters = scr->leaves;
+    inters.clear();
     ON_Ray r = toXRay(rp);
-    bs->bvh->intersectsHierarchy(r, inters);
+    brep_flat_leaves(bs, r, inters);
     if (inters.empty())
 	return 0; // MISS
 
-    // find all the hits (XXX very inefficient right now!)
-    std::list<brep_hit> hits;
-    MissList misses;
-    for (std::list<const BBNode*>::const_iterator i = inters.begin(); i != inters.end(); i++) {
-	const BBNode* sbv = (*i);
+    // find all the hits
+    std::vector<brep_hit> &hits = scr->hits;
+    hits.clear();
+    for (size_t i = 0; i < inters.size(); i++) {
+	const BBNode* sbv = inters[i];
 	const ON_BrepFace* f = &sbv->get_face();
 	const ON_Surface* surf = f->SurfaceOf();
 	pt2d_t uv = {sbv->m_u.Mid(), sbv->m_v.Mid()};
 	utah_brep_intersect(sbv, f, surf, uv, r, hits);
     }
 
-    // sort the hits
-    hits.sort();
+    // sort the hits, keeping equal distances in the order found
+    brep_sort_hits(hits, scr->sort);
 
 #ifdef RT_DEBUG_HITS
-    std::list<brep_hit> orig = hits;
+    std::vector<brep_hit> orig = hits;
 #endif
 
     ////////////////////////
     if ((hits.size() > 1) && containsNearMiss(&hits)) { //&& ((hits.size() % 2) != 0)) {
 
-	std::list<brep_hit>::iterator prev;
-	std::list<brep_hit>::const_iterator next;
-	std::list<brep_hit>::iterator curr = hits.begin();
-
-	while (curr != hits.end()) {
-	    const brep_hit &curr_hit = *curr;
-	    if (curr_hit.hit == brep_hit::NEAR_MISS) {
-		if (curr != hits.begin()) {
-		    prev = curr;
-		    prev--;
-		    const brep_hit &prev_hit = (*prev);
-		    if ((prev_hit.hit != brep_hit::NEAR_MISS) && (prev_hit.direction == curr_hit.direction)) {
-			//remove current miss
-			curr = hits.erase(curr);
-			curr = hits.begin(); //rewind and start again
-			continue;
-		    }
-		}
-		next = curr;
-		next++;
-		if (next != hits.end()) {
-		    const brep_hit &next_hit = (*next);
-		    if ((next_hit.hit != brep_hit::NEAR_MISS) && (next_hit.direction == curr_hit.direction)) {
-			//remove current miss
-			curr = hits.erase(curr);
-			curr = hits.begin(); //rewind and start again
-			continue;
-		    }
-		}
-	    }
-	    curr++;
-	}
+	brep_prune_near_misses(hits);
 
 	// check for crack hits between adjacent faces
-	curr = hits.begin();
-	while (curr != hits.end()) {
-	    const brep_hit &curr_hit = *curr;
-	    if (curr != hits.begin()) {
+	size_t curr = 0;
+	while (curr < hits.size()) {
+	    const brep_hit &curr_hit = hits[curr];
+	    if (curr != 0) {
+		size_t prev = curr - 1;
 		if (curr_hit.hit == brep_hit::NEAR_MISS) {
-		    prev = curr;
-		    prev--;
-		    brep_hit &prev_hit = (*prev);
+		    brep_hit &prev_hit = hits[prev];
 		    if (prev_hit.hit == brep_hit::NEAR_MISS) { // two near misses in a row
-			if (prev_hit.m_adj_face_index == curr_hit.face.m_face_index) {
+			if (prev_hit.m_adj_face_index == curr_hit.face->m_face_index) {
 			    if (prev_hit.direction == curr_hit.direction) {
 				//remove current miss
 				prev_hit.hit = brep_hit::CRACK_HIT;
-				curr = hits.erase(curr);
+				hits.erase(hits.begin() + curr);
 				continue;
 			    } else {
 				//remove both edge near misses
-				(void)hits.erase(prev);
-				curr = hits.erase(curr);
+				hits.erase(hits.begin() + prev, hits.begin() + curr + 1);
+				curr = prev;
 				continue;
 			    }
 			} else {
 			    // not adjacent faces so remove first miss
-			    (void)hits.erase(prev);
+			    hits.erase(hits.begin() + prev);
+			    curr = prev;
 			}
 		    }
 		} else {
-		    prev = curr;
-		    prev--;
-		    brep_hit &prev_hit = (*prev);
+		    brep_hit &prev_hit = hits[prev];
 		    if ((curr_hit.hit == brep_hit::CLEAN_HIT || curr_hit.hit == brep_hit::NEAR_HIT) && prev_hit.hit == brep_hit::NEAR_MISS) {
 			if (curr_hit.direction == brep_hit::ENTERING) {
-			    (void)hits.erase(prev);
+			    hits.erase(hits.begin() + prev);
+			    curr = prev;
 			} else {
 			    prev_hit.hit = brep_hit::CRACK_HIT;
 			}
@@ -1174,28 +1243,27 @@ rt_brep_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct
 
 	// check for CH double enter or double leave between adjacent
 	// faces(represents overlapping faces)
-	curr = hits.begin();
-	while (curr != hits.end()) {
-	    const brep_hit &curr_hit = *curr;
+	curr = 0;
+	while (curr < hits.size()) {
+	    const brep_hit &curr_hit = hits[curr];
 	    if (curr_hit.hit == brep_hit::CLEAN_HIT) {
-		if (curr != hits.begin()) {
-		    prev = curr;
-		    prev--;
-		    const brep_hit &prev_hit = (*prev);
+		if (curr != 0) {
+		    size_t prev = curr - 1;
+		    const brep_hit &prev_hit = hits[prev];
 		    if ((prev_hit.hit == brep_hit::CLEAN_HIT) &&
 			(prev_hit.direction == curr_hit.direction) &&
-			(prev_hit.face.m_face_index == curr_hit.m_adj_face_index)) {
+			(prev_hit.face->m_face_index == curr_hit.m_adj_face_index)) {
 			// if "entering" remove first hit if
 			// "existing" remove second hit until we get
 			// good solids with known normal directions
 			// assume first hit direction is "entering"
 			// todo check solid status and normals
-			std::list<brep_hit>::const_iterator first = hits.begin();
-			const brep_hit &first_hit = *first;
+			const brep_hit &first_hit = hits.front();
 			if (first_hit.direction == curr_hit.direction) { // assume "entering"
-			    curr = hits.erase(prev);
+			    hits.erase(hits.begin() + prev);
+			    curr = prev;
 			} else { // assume "exiting"
-			    curr = hits.erase(curr);
+			    hits.erase(hits.begin() + curr);
 			}
 			continue;
 		    }
@@ -1214,7 +1282,7 @@ rt_brep_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct
 	if (!hits.empty() && ((hits.size() % 2) != 0)) {
 	    const brep_hit &curr_hit = hits.front();
 	    if (curr_hit.hit == brep_hit::NEAR_MISS) {
-		hits.pop_front();
+		hits.erase(hits.begin());
 	    }
 	}
 
@@ -1222,47 +1290,39 @@ rt_brep_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct
 
     ///////////// handle near hit
     if ((hits.size() > 1) && containsNearHit(&hits)) { //&& ((hits.size() % 2) != 0)) {
-	std::list<brep_hit>::iterator prev;
-	std::list<brep_hit>::const_iterator next;
-	std::list<brep_hit>::iterator curr = hits.begin();
-	while (curr != hits.end()) {
-	    const brep_hit &curr_hit = *curr;
+	size_t curr = 0;
+	while (curr < hits.size()) {
+	    const brep_hit &curr_hit = hits[curr];
 	    if (curr_hit.hit == brep_hit::NEAR_HIT) {
-		if (curr != hits.begin()) {
-		    prev = curr;
-		    prev--;
-		    const brep_hit &prev_hit = (*prev);
+		if (curr != 0) {
+		    const brep_hit &prev_hit = hits[curr - 1];
 		    if ((prev_hit.hit != brep_hit::NEAR_HIT) && (prev_hit.direction == curr_hit.direction)) {
 			//remove current miss
-			curr = hits.erase(curr);
+			hits.erase(hits.begin() + curr);
 			continue;
 		    }
 		}
-		next = curr;
-		next++;
-		if (next != hits.end()) {
-		    const brep_hit &next_hit = (*next);
+		if (curr + 1 < hits.size()) {
+		    const brep_hit &next_hit = hits[curr + 1];
 		    if ((next_hit.hit != brep_hit::NEAR_HIT) && (next_hit.direction == curr_hit.direction)) {
 			//remove current miss
-			curr = hits.erase(curr);
+			hits.erase(hits.begin() + curr);
 			continue;
 		    }
 		}
 	    }
 	    curr++;
 	}
-	curr = hits.begin();
-	while (curr != hits.end()) {
-	    const brep_hit &curr_hit = *curr;
+	curr = 0;
+	while (curr < hits.size()) {
+	    const brep_hit &curr_hit = hits[curr];
 	    if (curr_hit.hit == brep_hit::NEAR_HIT) {
-		if (curr != hits.begin()) {
-		    prev = curr;
-		    prev--;
-		    brep_hit &prev_hit = (*prev);
+		if (curr != 0) {
+		    brep_hit &prev_hit = hits[curr - 1];
 		    if ((prev_hit.hit == brep_hit::NEAR_HIT) && (prev_hit.direction == curr_hit.direction)) {
 			//remove current near hit
 			prev_hit.hit = brep_hit::CRACK_HIT;
-			curr = hits.erase(curr);
+			hits.erase(hits.begin() + curr);
 			continue;
 		    }
 		}
@@ -1275,49 +1335,41 @@ rt_brep_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct
 	// remove grazing hits with with normal to ray dot less than
 	// BREP_GRAZING_DOT_TOL (>= 89.999 degrees obliq)
 	TRACE("-- Remove grazing hits --");
-	//int num = 0;
-	for (std::list<brep_hit>::iterator i = hits.begin(); i != hits.end(); ++i) {
-	    const brep_hit &curr_hit = *i;
+	size_t w = 0;
+	for (size_t i = 0; i < hits.size(); i++) {
+	    const brep_hit &curr_hit = hits[i];
 	    if ((curr_hit.trimmed && !curr_hit.closeToEdge) || curr_hit.oob || NEAR_ZERO(VDOT(curr_hit.normal, rp->r_dir), BREP_GRAZING_DOT_TOL)) {
 		// remove what we were removing earlier
 		if (curr_hit.oob) {
-		    TRACE("\toob u: " << i->uv[0] << ", " << IVAL(i->sbv->m_u));
-		    TRACE("\toob v: " << i->uv[1] << ", " << IVAL(i->sbv->m_v));
+		    TRACE("\toob u: " << curr_hit.uv[0] << ", " << IVAL(curr_hit.sbv->m_u));
+		    TRACE("\toob v: " << curr_hit.uv[1] << ", " << IVAL(curr_hit.sbv->m_v));
 		}
-		i = hits.erase(i);
-
-		if (i != hits.begin())
-		    --i;
-
 		continue;
 	    }
-	    //TRACE("hit " << num << ": " << PT(i->point) << " [" << VDOT(i->normal, rp->r_dir) << "]");
-	    //++num;
+	    if (w != i)
+		hits[w] = hits[i];
+	    w++;
 	}
+	hits.erase(hits.begin() + w, hits.end());
     }
 
     if (!hits.empty()) {
 	// we should have "valid" points now, remove duplicates or
 	// grazes(same point with in/out sign change)
-	std::list<brep_hit>::iterator last = hits.begin();
-	std::list<brep_hit>::iterator i = hits.begin();
-	++i;
-	while (i != hits.end()) {
-	    if ((*i) == (*last)) {
-		double lastDot = VDOT(last->normal, rp->r_dir);
-		double iDot = VDOT(i->normal, rp->r_dir);
+	size_t last = 0;
+	size_t i = 1;
+	while (i < hits.size()) {
+	    if (hits[i] == hits[last]) {
+		double lastDot = VDOT(hits[last].normal, rp->r_dir);
+		double iDot = VDOT(hits[i].normal, rp->r_dir);
 
 		if (sign(lastDot) != sign(iDot)) {
 		    // delete them both
-		    i = hits.erase(last);
-		    i = hits.erase(i);
-		    last = i;
-
-		    if (i != hits.end())
-			++i;
+		    hits.erase(hits.begin() + last, hits.begin() + i + 1);
+		    i = last + 1;
 		} else {
 		    // just delete the second
-		    i = hits.erase(i);
+		    hits.erase(hits.begin() + i);
 		}
 	    } else {
 		last = i;
@@ -1334,15 +1386,14 @@ rt_brep_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct
     //if (!hits.empty() && ((hits.size() % 2) != 0)) {
     if (!hits.empty()) {
 	// we should have "valid" points now, remove duplicates or grazes
-	std::list<brep_hit>::iterator last = hits.begin();
-	std::list<brep_hit>::iterator i = hits.begin();
-	++i;
+	size_t last = 0;
+	size_t i = 1;
 	int entering = 1;
-	while (i != hits.end()) {
-	    double lastDot = VDOT(last->normal, rp->r_dir);
-	    double iDot = VDOT(i->normal, rp->r_dir);
+	while (i < hits.size()) {
+	    double lastDot = VDOT(hits[last].normal, rp->r_dir);
+	    double iDot = VDOT(hits[i].normal, rp->r_dir);
 
-	    if (i == hits.begin()) {
+	    if (i == 0) {
 		// take this as the entering sign for now, should be
 		// checking solid for inward or outward facing normals
 		// and make determination there but to much unsolid
@@ -1351,12 +1402,10 @@ rt_brep_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct
 	    }
 	    if (sign(lastDot) == sign(iDot)) {
 		if (sign(iDot) == entering) {
-		    i = hits.erase(last);
-		    last = i;
-		    if (i != hits.end())
-			++i;
+		    hits.erase(hits.begin() + last);
+		    i = last + 1;
 		} else { //exiting
-		    i = hits.erase(i);
+		    hits.erase(hits.begin() + i);
 		}
 
 	    } else {
@@ -1387,9 +1436,9 @@ rt_brep_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct
 	    /* PLATE MODE case */
 
 	    /* iterate over all hit points assuming a plate-mode shell */
-	    for (std::list<brep_hit>::const_iterator i = hits.begin(); i != hits.end(); ++i) {
-		const brep_hit& in = *i;
-		const brep_hit& out = *i;
+	    for (size_t i = 0; i < hits.size(); i++) {
+		const brep_hit& in = hits[i];
+		const brep_hit& out = hits[i];
 
 		double los = brep_platemode_thickness(*rp, in, *bs);
 
@@ -1400,7 +1449,7 @@ rt_brep_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct
 		/* set in hit */
 		segp->seg_in.hit_dist = in.dist - (los*0.5);
 		// segment is centered on the hit point
-		segp->seg_in.hit_surfno = in.face.m_face_index;
+		segp->seg_in.hit_surfno = in.face->m_face_index;
 		VSET(segp->seg_in.hit_vpriv, in.uv[0], in.uv[1], 0.0);
 		VMOVE(segp->seg_in.hit_normal, in.normal);
 		VJOIN1(segp->seg_in.hit_point, rp->r_pt, segp->seg_in.hit_dist, rp->r_dir);
@@ -1412,7 +1461,7 @@ rt_brep_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct
 
 		/* set out hit */
 		segp->seg_out.hit_dist = out.dist + (los*0.5); // centered
-		segp->seg_out.hit_surfno = out.face.m_face_index;
+		segp->seg_out.hit_surfno = out.face->m_face_index;
 		VSET(segp->seg_out.hit_vpriv, out.uv[0], out.uv[1], 0.0);
 		VREVERSE(segp->seg_out.hit_normal, out.normal);
 		segp->seg_out.hit_rayp = &ap->a_ray;
@@ -1450,10 +1499,9 @@ rt_brep_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct
 	    bool hit_it = hits.size() % 2 == 0;
 	    if (hit_it) {
 		// take each pair as a segment
-		for (std::list<brep_hit>::const_iterator i = hits.begin(); i != hits.end(); ++i) {
-		    const brep_hit& in = *i;
-		    i++;
-		    const brep_hit& out = *i;
+		for (size_t i = 0; i + 1 < hits.size(); i += 2) {
+		    const brep_hit& in = hits[i];
+		    const brep_hit& out = hits[i + 1];
 
 		    struct seg* segp;
 		    RT_GET_SEG(segp, ap->a_resource);
@@ -1462,13 +1510,13 @@ rt_brep_shot(struct soltab *stp, struct xray *rp, struct application *ap, struct
 		    VMOVE(segp->seg_in.hit_point, in.point);
 		    VMOVE(segp->seg_in.hit_normal, in.normal);
 		    segp->seg_in.hit_dist = in.dist;
-		    segp->seg_in.hit_surfno = in.face.m_face_index;
+		    segp->seg_in.hit_surfno = in.face->m_face_index;
 		    VSET(segp->seg_in.hit_vpriv, in.uv[0], in.uv[1], 0.0);
 
 		    VMOVE(segp->seg_out.hit_point, out.point);
 		    VMOVE(segp->seg_out.hit_normal, out.normal);
 		    segp->seg_out.hit_dist = out.dist;
-		    segp->seg_out.hit_surfno = out.face.m_face_index;
+		    segp->seg_out.hit_surfno = out.face->m_face_index;
 		    VSET(segp->seg_out.hit_vpriv, out.uv[0], out.uv[1], 0.0);
 
 		    BU_LIST_INSERT(&(seghead->l), &(segp->l));
@@ -3009,6 +3057,7 @@ rt_brep_prep_serialize(struct soltab *stp, const struct rt_db_internal *ip, stru
 	}
 
 	specific->bvh->BuildBBox();
+	brep_flatten_bvh(specific);
 
 	{
 	    /* Once a proper SurfaceTree is built, finalize the bounding
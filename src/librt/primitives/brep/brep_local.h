@@ -25,6 +25,26 @@
 #ifndef LIBRT_PRIMITIVES_BREP_BREP_LOCAL_H
 #define LIBRT_PRIMITIVES_BREP_BREP_LOCAL_H
 
+#include "common.h"
+
+#include <cfloat>
+#include <vector>
+
+#include "vmath.h"
+#include "brep.h"
+
+
+/**
+ * A node of the bounding volume hierarchy, flattened into depth-first
+ * order for ray traversal.  If a ray misses the node, traversal
+ * continues at skip; otherwise it continues with the next node.
+ */
+struct brep_flat_node {
+    double min[3];
+    double max[3];
+    const BrepBoundingVolume *leaf;	/**< @brief surface tree leaf, NULL for interior nodes */
+    size_t skip;			/**< @brief index of the node following this subtree */
+};
 
 /**
  * The b-rep specific data structure for caching the prepared
@@ -33,12 +53,123 @@
 struct brep_specific {
     ON_Brep* brep;
     BrepBoundingVolume* bvh;
+    struct brep_flat_node *flat;	/**< @brief bvh in traversal order */
+    size_t flat_cnt;
     int is_solid;
     int plate_mode;
     int plate_mode_nocos;
     double plate_mode_thickness;
 };
 
+
+/* Same slab test as BBNode::intersectedBy() against a flattened node */
+static inline bool
+brep_flat_node_hit(const struct brep_flat_node *n, const ON_Ray &ray)
+{
+    double tnear = -DBL_MAX;
+    double tfar = DBL_MAX;
+    for (int i = 0; i < 3; i++) {
+	if (UNLIKELY(ON_NearZero(ray.m_dir[i]))) {
+	    if (ray.m_origin[i] < n->min[i] || ray.m_origin[i] > n->max[i])
+		return false;
+	} else {
+	    double t1 = (n->min[i] - ray.m_origin[i]) / ray.m_dir[i];
+	    double t2 = (n->max[i] - ray.m_origin[i]) / ray.m_dir[i];
+	    if (t1 > t2) {
+		double tmp = t1;    /* swap */
+		t1 = t2;
+		t2 = tmp;
+	    }
+
+	    V_MAX(tnear, t1);
+	    V_MIN(tfar, t2);
+
+	    if (tnear > tfar) /* box is missed */
+		return false;
+	}
+    }
+    return true;
+}
+
+
+/* Collect the leaves of the flattened hierarchy intersected by the
+ * ray, in the same order BBNode::intersectsHierarchy() would.
+ */
+static inline void
+brep_flat_leaves(const struct brep_specific *bs, const ON_Ray &ray, std::vector<const BrepBoundingVolume *> &leaves)
+{
+    size_t i = 0;
+    while (i < bs->flat_cnt) {
+	const struct brep_flat_node *n = &bs->flat[i];
+	if (!brep_flat_node_hit(n, ray)) {
+	    i = n->skip;
+	    continue;
+	}
+	if (n->leaf)
+	    leaves.push_back(n->leaf);
+	i++;
+    }
+}
+
+
+/* Remove near misses that are next to a hit going the same direction.
+ *
+ * This used to erase one such miss at a time and start over from the
+ * first hit, since a removal can expose another miss to the same test.
+ * Within a run of consecutive near misses, that only ever strips the
+ * longest prefix matching the direction of the hit before the run and
+ * the longest suffix matching the direction of the hit after it, so
+ * each run is handled once as it is reached.
+ *
+ * Hit is rt_brep_shot()'s brep_hit, or anything else with the same
+ * hit and direction members.
+ */
+template <class Hit>
+static void
+brep_prune_near_misses(std::vector<Hit> &hits)
+{
+    size_t n = hits.size();
+    size_t w = 0;
+    size_t i = 0;
+    while (i < n) {
+	if (hits[i].hit != Hit::NEAR_MISS) {
+	    if (w != i)
+		hits[w] = hits[i];
+	    w++;
+	    i++;
+	    continue;
+	}
+
+	/* find the end of this run of near misses */
+	size_t j = i;
+	while (j < n && hits[j].hit == Hit::NEAR_MISS)
+	    j++;
+
+	size_t first = i;
+	if (w > 0) {
+	    /* everything before the run is kept, so hits[w-1] is the
+	     * hit immediately preceding it */
+	    typename Hit::hit_direction dir = hits[w-1].direction;
+	    while (first < j && hits[first].direction == dir)
+		first++;
+	}
+	size_t last = j;
+	if (j < n) {
+	    typename Hit::hit_direction dir = hits[j].direction;
+	    while (last > first && hits[last-1].direction == dir)
+		last--;
+	}
+	for (size_t k = first; k < last; k++) {
+	    if (w != k)
+		hits[w] = hits[k];
+	    w++;
+	}
+	i = j;
+    }
+    hits.erase(hits.begin() + w, hits.end());
+}
+
+
 #endif /* LIBRT_PRIMITIVES_BREP_BREP_LOCAL_H */
 /*
  * Local Variables:
@@ -55,8 +55,14 @@ struct rt_ebm_specific {
     vect_t ebm_origin;	/* local coords of grid origin (0, 0, 0) for now */
     vect_t ebm_large;	/* local coords of XYZ max */
     mat_t ebm_mat;	/* model to ideal space */
+    unsigned char *ebm_tiles;	/* nonzero where a tile has a set cell */
+    size_t ebm_tdim[2];	/* number of tiles along XY */
 };
 
+/* Cells along each side of the tiles used to step rays over empty
+ * parts of the bitmap.
+ */
+#define EBM_TILE 16
 
 #define RT_EBM_NULL ((struct rt_ebm_specific *)0)
 
@@ -322,6 +328,99 @@ rt_seg_planeclip(struct seg *out_hd, struct seg *in_hd, vect_t out_norm, fastf_t
 static int rt_ebm_normtab[3] = { NORM_XPOS, NORM_YPOS, NORM_ZPOS };
 
 
+static void
+ebm_tiles_build(struct rt_ebm_specific *ebmp)
+{
+    struct rt_ebm_internal *eip = &ebmp->ebm_i;
+    size_t x, y;
+
+    ebmp->ebm_tdim[X] = (eip->xdim + EBM_TILE - 1) / EBM_TILE;
+    ebmp->ebm_tdim[Y] = (eip->ydim + EBM_TILE - 1) / EBM_TILE;
+    ebmp->ebm_tiles = (unsigned char *)bu_calloc(ebmp->ebm_tdim[X] * ebmp->ebm_tdim[Y], 1, "ebm tiles");
+
+    for (y = 0; y < eip->ydim; y++) {
+	unsigned char *row = &ebmp->ebm_tiles[(y / EBM_TILE) * ebmp->ebm_tdim[X]];
+	const unsigned char *cp = bit(eip, 0, y);
+	for (x = 0; x < eip->xdim; x++) {
+	    if (cp[x] > 0)
+		row[x / EBM_TILE] = 1;
+	}
+    }
+}
+
+
+/* Returns truthfully if cell igrid lies in a tile with no set cells */
+static int
+ebm_tile_empty(const struct rt_ebm_specific *ebmp, const size_t igrid[3])
+{
+    size_t tx = igrid[X] / EBM_TILE;
+    size_t ty = igrid[Y] / EBM_TILE;
+
+    if (tx >= ebmp->ebm_tdim[X] || ty >= ebmp->ebm_tdim[Y])
+	return 0;
+
+    return !ebmp->ebm_tiles[ty * ebmp->ebm_tdim[X] + tx];
+}
+
+
+/* Advance the DDA state from cell igrid to the first cell past its
+ * tile, as if each cell in between had been stepped through.
+ * Returns the index the tile was left through, or -1 if the ray does
+ * not move in XY.
+ */
+static int
+ebm_tile_skip(const vect_t dir, size_t igrid[3], vect_t t, const vect_t delta, double *t0)
+{
+    double texit = INFINITY;
+    size_t n[2] = {0, 0};
+    int out_index = -1;
+    int i;
+
+    for (i = X; i <= Y; i++) {
+	size_t b;
+	double te;
+	if (ZERO(delta[i]))
+	    continue;
+	b = igrid[i] / EBM_TILE;
+	if (dir[i] > 0)
+	    n[i] = (b + 1) * EBM_TILE - igrid[i];
+	else
+	    n[i] = igrid[i] - b * EBM_TILE + 1;
+	te = t[i] + (n[i] - 1) * delta[i];
+	/* ties go to Y, as in the main loop */
+	if (te <= texit) {
+	    texit = te;
+	    out_index = i;
+	}
+    }
+    if (out_index < 0)
+	return -1;
+
+    for (i = X; i <= Y; i++) {
+	size_t k = 0;
+	if (i == out_index) {
+	    k = n[i];
+	} else if (n[i] && t[i] <= texit) {
+	    /* crossings of this axis the main loop would take before
+	     * the tile exit, including a Y crossing at the same t */
+	    k = (size_t)ceil((texit - t[i]) / delta[i]);
+	    if (i == Y && t[i] + k * delta[i] == texit)
+		k++;
+	    if (k > n[i])
+		k = n[i];
+	}
+	t[i] += k * delta[i];
+	if (dir[i] > 0)
+	    igrid[i] += k;
+	else
+	    igrid[i] -= k;
+    }
+    *t0 = texit;
+
+    return out_index;
+}
+
+
 /**
  * Step through the 2-D array, in local coordinates ("ideal space").
  */
@@ -471,6 +570,15 @@ rt_ebm_dda(register struct xray *rp, struct soltab *stp, struct application *ap,
 	int val;
 	struct seg *segp;
 
+	/* Step over tiles with nothing in them */
+	if (!inside && ebmp->ebm_tiles && ebm_tile_empty(ebmp, igrid)) {
+	    int skip_index = ebm_tile_skip(rp->r_dir, igrid, t, delta, &t0);
+	    if (skip_index >= 0) {
+		in_index = skip_index;
+		continue;
+	    }
+	}
+
 	/* find minimum exit t value */
 	out_index = t[X] < t[Y] ? X : Y;
 
@@ -1135,17 +1243,8 @@ rt_ebm_bbox(struct rt_db_internal *ip, point_t *min, point_t *max, const struct
 }
 
 
-/**
- * Returns -
- * 0 OK
- * !0 Failure
- *
- * Implicit return -
- * A struct rt_ebm_specific is created, and its address is stored
- * in stp->st_specific for use by rt_ebm_shot().
- */
-int
-rt_ebm_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
+static struct rt_ebm_specific *
+ebm_specific_setup(struct soltab *stp, struct rt_db_internal *ip)
 {
     struct rt_ebm_internal *eip;
     register struct rt_ebm_specific *ebmp;
@@ -1153,13 +1252,12 @@ rt_ebm_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
     vect_t radvec;
     vect_t diam;
 
-    if (rtip) RT_CK_RTI(rtip);
-
     eip = (struct rt_ebm_internal *)ip->idb_ptr;
     RT_EBM_CK_MAGIC(eip);
 
     BU_GET(ebmp, struct rt_ebm_specific);
     ebmp->ebm_i = *eip;		/* struct copy */
+    ebmp->ebm_tiles = NULL;
 
     /* "steal" the bitmap storage */
     eip->mp = (struct bu_mapped_file *)0;	/* "steal" the mapped file */
@@ -1178,7 +1276,7 @@ rt_ebm_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
     stp->st_specific = (void *)ebmp;
 
     /* Find bounding RPP of rotated local RPP */
-    rt_ebm_bbox(ip, &(stp->st_min), &(stp->st_max), &rtip->rti_tol);
+    rt_ebm_bbox(ip, &(stp->st_min), &(stp->st_max), NULL);
     VSET(ebmp->ebm_large, ebmp->ebm_i.xdim, ebmp->ebm_i.ydim, ebmp->ebm_i.tallness);
 
     /* for now, EBM origin in ideal coordinates is at origin */
@@ -1193,6 +1291,32 @@ rt_ebm_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
     VSCALE(radvec, diam, 0.5);
     stp->st_aradius = stp->st_bradius = MAGNITUDE(radvec);
 
+    return ebmp;
+}
+
+
+/**
+ * Returns -
+ * 0 OK
+ * !0 Failure
+ *
+ * Implicit return -
+ * A struct rt_ebm_specific is created, and its address is stored
+ * in stp->st_specific for use by rt_ebm_shot().
+ */
+int
+rt_ebm_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
+{
+    struct rt_ebm_specific *ebmp;
+
+    if (rtip) RT_CK_RTI(rtip);
+
+    ebmp = ebm_specific_setup(stp, ip);
+    /* A hasty prep leaves the tiles out, so rays step through
+     * every cell */
+    if (!rtip || !rtip->rti_hasty_prep)
+	ebm_tiles_build(ebmp);
+
     return 0;		/* OK */
 }
 
@@ -1330,6 +1454,8 @@ rt_ebm_free(struct soltab *stp)
 	(struct rt_ebm_specific *)stp->st_specific;
 
     bu_close_mapped_file(ebmp->ebm_i.mp);
+    if (ebmp->ebm_tiles)
+	bu_free(ebmp->ebm_tiles, "ebm tiles");
 
     BU_PUT(ebmp, struct rt_ebm_specific);
 }
@@ -457,7 +457,9 @@ rt_ell_shot(struct soltab *stp, register struct xray *rp, struct application *ap
 
 #define RT_ELL_SEG_MISS(SEG)	(SEG).seg_stp=RT_SOLTAB_NULL
 /**
- * This is the Becker vector version.
+ * Vectorized version.  Pairs are gathered RT_VSHOT_BLOCK at a time
+ * into structure-of-arrays form and intersected without branching,
+ * with the same results as rt_ell_shot().
  */
 void
 rt_ell_vshot(struct soltab **stp, struct xray **rp, struct seg *segp, int n, struct application *ap)
@@ -467,49 +469,92 @@ rt_ell_vshot(struct soltab **stp, struct xray **rp, struct seg *segp, int n, str
 /* Number of ray/object pairs */
 
 {
-    register int i;
-    register struct ell_specific *ell;
-
-    vect_t dprime;		/* D' */
-    vect_t pprime;		/* P' */
-    vect_t xlated;		/* translated vector */
-    fastf_t dp, dd;		/* D' dot P', D' dot D' */
-    fastf_t k1, k2;		/* distance constants of solution */
-    fastf_t root;		/* root of radical */
+    int i;
 
     if (ap) RT_CK_APPLICATION(ap);
 
-    /* for each ray/ellipse pair */
-    for (i = 0; i < n; i++) {
-	if (stp[i] == 0) continue; /* stp[i] == 0 signals skip ray */
-
-	ell = (struct ell_specific *)stp[i]->st_specific;
+    for (i = 0; i < n; i += RT_VSHOT_BLOCK) {
+	int pair[RT_VSHOT_BLOCK];
+	fastf_t m0[RT_VSHOT_BLOCK], m1[RT_VSHOT_BLOCK], m2[RT_VSHOT_BLOCK];
+	fastf_t m4[RT_VSHOT_BLOCK], m5[RT_VSHOT_BLOCK], m6[RT_VSHOT_BLOCK];
+	fastf_t m8[RT_VSHOT_BLOCK], m9[RT_VSHOT_BLOCK], m10[RT_VSHOT_BLOCK];
+	fastf_t xlated[3][RT_VSHOT_BLOCK];	/* translated vector */
+	fastf_t dir[3][RT_VSHOT_BLOCK];
+	fastf_t k1[RT_VSHOT_BLOCK], k2[RT_VSHOT_BLOCK];	/* distance constants of solution */
+	int hit[RT_VSHOT_BLOCK];
+	int j, m = 0;
+
+	/* gather the pairs of this block, stp[i] == 0 signals skip ray */
+	for (j = i; j < i + RT_VSHOT_BLOCK && j < n; j++) {
+	    const struct ell_specific *ell;
+
+	    if (stp[j] == 0)
+		continue;
+
+	    ell = (const struct ell_specific *)stp[j]->st_specific;
+	    pair[m] = j;
+	    m0[m] = ell->ell_SoR[0];
+	    m1[m] = ell->ell_SoR[1];
+	    m2[m] = ell->ell_SoR[2];
+	    m4[m] = ell->ell_SoR[4];
+	    m5[m] = ell->ell_SoR[5];
+	    m6[m] = ell->ell_SoR[6];
+	    m8[m] = ell->ell_SoR[8];
+	    m9[m] = ell->ell_SoR[9];
+	    m10[m] = ell->ell_SoR[10];
+	    xlated[X][m] = rp[j]->r_pt[X] - ell->ell_V[X];
+	    xlated[Y][m] = rp[j]->r_pt[Y] - ell->ell_V[Y];
+	    xlated[Z][m] = rp[j]->r_pt[Z] - ell->ell_V[Z];
+	    dir[X][m] = rp[j]->r_dir[X];
+	    dir[Y][m] = rp[j]->r_dir[Y];
+	    dir[Z][m] = rp[j]->r_dir[Z];
+	    m++;
+	}
 
-	MAT4X3VEC(dprime, ell->ell_SoR, rp[i]->r_dir);
-	VSUB2(xlated, rp[i]->r_pt, ell->ell_V);
-	MAT4X3VEC(pprime, ell->ell_SoR, xlated);
+	for (j = 0; j < m; j++) {
+	    fastf_t dprime[3];	/* D' */
+	    fastf_t pprime[3];	/* P' */
+	    fastf_t dp, dd;	/* D' dot P', D' dot D' */
+	    fastf_t disc, root;
+
+	    dprime[X] = m0[j]*dir[X][j] + m1[j]*dir[Y][j] + m2[j]*dir[Z][j];
+	    dprime[Y] = m4[j]*dir[X][j] + m5[j]*dir[Y][j] + m6[j]*dir[Z][j];
+	    dprime[Z] = m8[j]*dir[X][j] + m9[j]*dir[Y][j] + m10[j]*dir[Z][j];
+	    pprime[X] = m0[j]*xlated[X][j] + m1[j]*xlated[Y][j] + m2[j]*xlated[Z][j];
+	    pprime[Y] = m4[j]*xlated[X][j] + m5[j]*xlated[Y][j] + m6[j]*xlated[Z][j];
+	    pprime[Z] = m8[j]*xlated[X][j] + m9[j]*xlated[Y][j] + m10[j]*xlated[Z][j];
+
+	    dp = dprime[X]*pprime[X] + dprime[Y]*pprime[Y] + dprime[Z]*pprime[Z];
+	    dd = dprime[X]*dprime[X] + dprime[Y]*dprime[Y] + dprime[Z]*dprime[Z];
+
+	    disc = dp*dp - dd * (pprime[X]*pprime[X] + pprime[Y]*pprime[Y] + pprime[Z]*pprime[Z] - 1.0);
+	    hit[j] = !(disc < 0);
+	    root = sqrt(hit[j] ? disc : 0.0);
+	    k1[j] = (-dp+root)/dd;
+	    k2[j] = (-dp-root)/dd;
+	}
 
-	dp = VDOT(dprime, pprime);
-	dd = VDOT(dprime, dprime);
+	/* scatter */
+	for (j = 0; j < m; j++) {
+	    struct seg *sp = &segp[pair[j]];
 
-	if ((root = dp*dp - dd * (VDOT(pprime, pprime)-1.0)) < 0) {
-	    RT_ELL_SEG_MISS(segp[i]);		/* No hit */
-	} else {
-	    root = sqrt(root);
-
-	    segp[i].seg_stp = stp[i];
+	    if (!hit[j]) {
+		RT_ELL_SEG_MISS(*sp);		/* No hit */
+		continue;
+	    }
+	    sp->seg_stp = stp[pair[j]];
 
-	    if ((k1=(-dp+root)/dd) <= (k2=(-dp-root)/dd)) {
+	    if (k1[j] <= k2[j]) {
 		/* k1 is entry, k2 is exit */
-		segp[i].seg_in.hit_dist = k1;
-		segp[i].seg_out.hit_dist = k2;
+		sp->seg_in.hit_dist = k1[j];
+		sp->seg_out.hit_dist = k2[j];
 	    } else {
 		/* k2 is entry, k1 is exit */
-		segp[i].seg_in.hit_dist = k2;
-		segp[i].seg_out.hit_dist = k1;
+		sp->seg_in.hit_dist = k2[j];
+		sp->seg_out.hit_dist = k1[j];
 	    }
-	    segp[i].seg_in.hit_surfno = 0;
-	    segp[i].seg_out.hit_surfno = 0;
+	    sp->seg_in.hit_surfno = 0;
+	    sp->seg_out.hit_surfno = 0;
 	}
     }
 }
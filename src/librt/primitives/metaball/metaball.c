@@ -67,6 +67,43 @@
 
 #define PLOT_THE_BIG_BOUNDING_SPHERE 0
 
+/* Blob control points are ignored where their contribution is below
+ * this fraction of threshold/npoints, so the field used for shooting
+ * is off by less than this fraction of the threshold.
+ */
+#define METABALL_CULL_EPS 1.0e-6
+
+/* limit on grid cells along each axis */
+#define METABALL_GRID_MAX 64
+
+/* points reaching further than this many cells are checked everywhere */
+#define METABALL_GRID_REACH 4
+
+
+/* The prepped form.  The generic code treats st_specific as an
+ * rt_metaball_internal, so that stays first.
+ *
+ * For blobs, each control point is entered in the grid cells its
+ * influence sphere overlaps, and each cell keeps a bound on how fast
+ * the field of its points can change (a Lipschitz constant).  Shots
+ * only sum the points listed for the cell they are in and can step
+ * as far as the bound allows without crossing the threshold.
+ */
+struct metaball_specific {
+    struct rt_metaball_internal mb;
+    size_t dim[3];		/* grid cells along XYZ, 0 if no grid */
+    point_t min;
+    point_t max;
+    fastf_t cellsize;
+    size_t *cell_start;		/* dim[X]*dim[Y]*dim[Z]+1 offsets into cell_pts */
+    struct wdb_metaball_pnt **cell_pts;
+    fastf_t *cell_lip;
+    struct wdb_metaball_pnt **global_pts; /* points too large for the grid */
+    size_t nglobal;
+    fastf_t global_lip;
+    int march;			/* hasty prep: plain march, no grid or bounds */
+};
+
 const char *metaballnames[] =
 {
     "Metaball",
@@ -179,6 +216,328 @@ rt_metaball_bbox(struct rt_db_internal *ip, point_t *min, point_t *max, const st
 }
 
 
+static void
+metaball_grid_free(struct metaball_specific *mbs)
+{
+    if (mbs->cell_start)
+	bu_free(mbs->cell_start, "metaball cell_start");
+    if (mbs->cell_pts)
+	bu_free(mbs->cell_pts, "metaball cell_pts");
+    if (mbs->cell_lip)
+	bu_free(mbs->cell_lip, "metaball cell_lip");
+    if (mbs->global_pts)
+	bu_free(mbs->global_pts, "metaball global_pts");
+    mbs->cell_start = NULL;
+    mbs->cell_pts = NULL;
+    mbs->cell_lip = NULL;
+    mbs->global_pts = NULL;
+    mbs->nglobal = 0;
+    VSETALL(mbs->dim, 0);
+}
+
+
+/* Cell range covered by the box of radius r around pt. */
+static void
+metaball_grid_range(const struct metaball_specific *mbs, const point_t pt, fastf_t r, size_t lo[3], size_t hi[3])
+{
+    int i;
+    for (i = X; i <= Z; i++) {
+	fastf_t a = (pt[i] - r - mbs->min[i]) / mbs->cellsize;
+	fastf_t b = (pt[i] + r - mbs->min[i]) / mbs->cellsize;
+	lo[i] = (a > 0.0) ? (size_t)a : 0;
+	hi[i] = (b > 0.0) ? (size_t)b : 0;
+	if (lo[i] >= mbs->dim[i])
+	    lo[i] = mbs->dim[i] - 1;
+	if (hi[i] >= mbs->dim[i])
+	    hi[i] = mbs->dim[i] - 1;
+    }
+}
+
+
+/* Build the blob grid.  If some point's field does not fall off with
+ * distance, or the threshold is not positive, no grid is built and
+ * shots sum every point as before.
+ */
+static void
+metaball_grid_build(struct metaball_specific *mbs)
+{
+    struct rt_metaball_internal *mb = &mbs->mb;
+    struct wdb_metaball_pnt *mbpt;
+    fastf_t *reach, *lip;
+    fastf_t cutoff, sumreach = 0.0, extent = 0.0;
+    size_t npts = 0, ncells, i, n, x, y, z;
+    size_t lo[3], hi[3];
+
+    VSETALL(mbs->dim, 0);
+    if (!(mb->threshold > 0.0))
+	return;
+
+    for (BU_LIST_FOR(mbpt, wdb_metaball_pnt, &mb->metaball_ctrl_head)) {
+	if (!(mbpt->sweat > 0.0) || ZERO(mbpt->fldstr))
+	    return;
+	npts++;
+    }
+    if (!npts)
+	return;
+
+    /* contribution exp(sweat - (sweat/fldstr^2) r^2) reaches cutoff at r = reach */
+    cutoff = log(METABALL_CULL_EPS * mb->threshold / (fastf_t)npts);
+    reach = (fastf_t *)bu_malloc(npts * sizeof(fastf_t), "metaball reach");
+    lip = (fastf_t *)bu_malloc(npts * sizeof(fastf_t), "metaball lip");
+    VSETALL(mbs->min, INFINITY);
+    VSETALL(mbs->max, -INFINITY);
+    i = 0;
+    for (BU_LIST_FOR(mbpt, wdb_metaball_pnt, &mb->metaball_ctrl_head)) {
+	fastf_t a = mbpt->sweat / SQ(mbpt->fldstr);
+	fastf_t r2 = (mbpt->sweat - cutoff) / a;
+	reach[i] = (r2 > 0.0) ? sqrt(r2) : 0.0;
+	/* steepest slope of the contribution, at r = 1/sqrt(2a) */
+	lip[i] = sqrt(2.0 * a) * exp(mbpt->sweat - 0.5);
+	if (!isfinite(reach[i]) || !isfinite(lip[i])) {
+	    bu_free(reach, "metaball reach");
+	    bu_free(lip, "metaball lip");
+	    return;
+	}
+	VMIN(mbs->min, mbpt->coord);
+	VMAX(mbs->max, mbpt->coord);
+	sumreach += reach[i];
+	i++;
+    }
+
+    /* grow the bounds to cover every influence sphere */
+    i = 0;
+    for (BU_LIST_FOR(mbpt, wdb_metaball_pnt, &mb->metaball_ctrl_head)) {
+	point_t a, b;
+	VSETALL(a, -reach[i]);
+	VADD2(a, a, mbpt->coord);
+	VSETALL(b, reach[i]);
+	VADD2(b, b, mbpt->coord);
+	VMIN(mbs->min, a);
+	VMAX(mbs->max, b);
+	i++;
+    }
+    for (i = X; i <= Z; i++)
+	V_MAX(extent, mbs->max[i] - mbs->min[i]);
+
+    mbs->cellsize = sumreach / (fastf_t)npts;
+    V_MAX(mbs->cellsize, extent / METABALL_GRID_MAX);
+    if (!(mbs->cellsize > 0.0)) {
+	bu_free(reach, "metaball reach");
+	bu_free(lip, "metaball lip");
+	return;
+    }
+    for (i = X; i <= Z; i++) {
+	mbs->dim[i] = (size_t)((mbs->max[i] - mbs->min[i]) / mbs->cellsize) + 1;
+	if (mbs->dim[i] > METABALL_GRID_MAX)
+	    mbs->dim[i] = METABALL_GRID_MAX;
+    }
+    ncells = mbs->dim[X] * mbs->dim[Y] * mbs->dim[Z];
+
+    mbs->cell_start = (size_t *)bu_calloc(ncells + 1, sizeof(size_t), "metaball cell_start");
+    mbs->cell_lip = (fastf_t *)bu_calloc(ncells, sizeof(fastf_t), "metaball cell_lip");
+    mbs->global_pts = (struct wdb_metaball_pnt **)bu_malloc(npts * sizeof(struct wdb_metaball_pnt *), "metaball global_pts");
+    mbs->global_lip = 0.0;
+
+    /* count, then fill, the per-cell lists */
+    i = 0;
+    for (BU_LIST_FOR(mbpt, wdb_metaball_pnt, &mb->metaball_ctrl_head)) {
+	if (reach[i] > METABALL_GRID_REACH * mbs->cellsize) {
+	    mbs->global_pts[mbs->nglobal++] = mbpt;
+	    mbs->global_lip += lip[i];
+	    i++;
+	    continue;
+	}
+	metaball_grid_range(mbs, mbpt->coord, reach[i], lo, hi);
+	for (z = lo[Z]; z <= hi[Z]; z++)
+	    for (y = lo[Y]; y <= hi[Y]; y++)
+		for (x = lo[X]; x <= hi[X]; x++) {
+		    size_t c = (z * mbs->dim[Y] + y) * mbs->dim[X] + x;
+		    mbs->cell_start[c + 1]++;
+		    mbs->cell_lip[c] += lip[i];
+		}
+	i++;
+    }
+    for (n = 0; n < ncells; n++)
+	mbs->cell_start[n + 1] += mbs->cell_start[n];
+    mbs->cell_pts = (struct wdb_metaball_pnt **)bu_malloc((mbs->cell_start[ncells] + 1) * sizeof(struct wdb_metaball_pnt *), "metaball cell_pts");
+    {
+	size_t *fill = (size_t *)bu_malloc(ncells * sizeof(size_t), "metaball fill");
+	memcpy(fill, mbs->cell_start, ncells * sizeof(size_t));
+	i = 0;
+	for (BU_LIST_FOR(mbpt, wdb_metaball_pnt, &mb->metaball_ctrl_head)) {
+	    if (reach[i] <= METABALL_GRID_REACH * mbs->cellsize) {
+		metaball_grid_range(mbs, mbpt->coord, reach[i], lo, hi);
+		for (z = lo[Z]; z <= hi[Z]; z++)
+		    for (y = lo[Y]; y <= hi[Y]; y++)
+			for (x = lo[X]; x <= hi[X]; x++)
+			    mbs->cell_pts[fill[(z * mbs->dim[Y] + y) * mbs->dim[X] + x]++] = mbpt;
+	    }
+	    i++;
+	}
+	bu_free(fill, "metaball fill");
+    }
+
+    bu_free(reach, "metaball reach");
+    bu_free(lip, "metaball lip");
+}
+
+
+/* Blob field at p from the grid.  *safe is set to a distance along
+ * dir that the ray can advance without the field reaching the
+ * threshold, INFINITY if it never can.
+ */
+static fastf_t
+metaball_grid_value(const struct metaball_specific *mbs, const point_t p, const vect_t dir, fastf_t *safe)
+{
+    fastf_t ret = 0.0, lipschitz, texit = INFINITY;
+    size_t c[3], n, first, last;
+    vect_t v;
+    int i;
+
+    for (i = X; i <= Z; i++) {
+	fastf_t q = (p[i] - mbs->min[i]) / mbs->cellsize;
+	if (!(q >= 0.0) || q >= (fastf_t)mbs->dim[i])
+	    break;
+	c[i] = (size_t)q;
+    }
+    if (i <= Z) {
+	/* outside the grid, where nothing is within reach */
+	fastf_t tin = -INFINITY, tout = INFINITY;
+	for (i = X; i <= Z; i++) {
+	    fastf_t t1, t2;
+	    if (ZERO(dir[i])) {
+		if (p[i] < mbs->min[i] || p[i] > mbs->max[i])
+		    tout = -INFINITY;
+		continue;
+	    }
+	    t1 = (mbs->min[i] - p[i]) / dir[i];
+	    t2 = (mbs->max[i] - p[i]) / dir[i];
+	    V_MAX(tin, FMIN(t1, t2));
+	    V_MIN(tout, FMAX(t1, t2));
+	}
+	*safe = (tout < tin || tout <= 0.0) ? INFINITY : tin;
+	return 0.0;
+    }
+
+    n = (c[Z] * mbs->dim[Y] + c[Y]) * mbs->dim[X] + c[X];
+    first = mbs->cell_start[n];
+    last = mbs->cell_start[n + 1];
+    for (; first < last; first++) {
+	const struct wdb_metaball_pnt *mbpt = mbs->cell_pts[first];
+	VSUB2(v, mbpt->coord, p);
+	ret += 1.0 / exp((mbpt->sweat/(mbpt->fldstr*mbpt->fldstr)) * MAGSQ(v) - mbpt->sweat);
+    }
+    for (first = 0; first < mbs->nglobal; first++) {
+	const struct wdb_metaball_pnt *mbpt = mbs->global_pts[first];
+	VSUB2(v, mbpt->coord, p);
+	ret += 1.0 / exp((mbpt->sweat/(mbpt->fldstr*mbpt->fldstr)) * MAGSQ(v) - mbpt->sweat);
+    }
+
+    /* the cell's bound only holds until the ray leaves the cell */
+    for (i = X; i <= Z; i++) {
+	fastf_t t;
+	if (dir[i] > 0.0)
+	    t = (mbs->min[i] + (c[i] + 1) * mbs->cellsize - p[i]) / dir[i];
+	else if (dir[i] < 0.0)
+	    t = (mbs->min[i] + c[i] * mbs->cellsize - p[i]) / dir[i];
+	else
+	    continue;
+	V_MIN(texit, t);
+    }
+    texit += mbs->cellsize * SMALL_FASTF;
+
+    lipschitz = mbs->cell_lip[n] + mbs->global_lip;
+    if (ret >= mbs->mb.threshold)
+	*safe = 0.0;
+    else if (lipschitz > 0.0)
+	*safe = FMIN((mbs->mb.threshold - ret) / lipschitz, texit);
+    else
+	*safe = texit;
+
+    return ret;
+}
+
+
+/* Isopotential field at p.  Moving d toward a positive point at r
+ * scales its f/r^2 term by at most 1/(1 - d/rmin)^2, where rmin is
+ * the distance to the nearest positive point, and negative points
+ * only lower the field, which bounds the safe distance.
+ */
+static fastf_t
+metaball_iso_value(const struct rt_metaball_internal *mb, const point_t p, fastf_t *safe)
+{
+    struct wdb_metaball_pnt *mbpt;
+    fastf_t ret = 0.0, pos = 0.0, rmin = INFINITY;
+    point_t v;
+
+    for (BU_LIST_FOR(mbpt, wdb_metaball_pnt, &mb->metaball_ctrl_head)) {
+	fastf_t r2, f;
+	VSUB2(v, mbpt->coord, p);
+	r2 = MAGSQ(v);
+	f = fabs(mbpt->fldstr) * mbpt->fldstr / r2;	/* f/r^2 */
+	ret += f;
+	if (mbpt->fldstr > 0.0) {
+	    pos += f;
+	    V_MIN(rmin, r2);
+	}
+    }
+
+    if (mb->threshold > 0.0 && pos < mb->threshold)
+	*safe = (rmin < INFINITY) ? sqrt(rmin) * (1.0 - sqrt(pos / mb->threshold)) : INFINITY;
+    else
+	*safe = 0.0;
+
+    return ret;
+}
+
+
+/* Field value used for shooting, and how far along dir the ray can
+ * safely go before it could reach the threshold (0 if unknown).
+ */
+static fastf_t
+metaball_shot_value(const struct metaball_specific *mbs, const point_t p, const vect_t dir, fastf_t *safe)
+{
+    if (mbs->mb.method == METABALL_BLOB && mbs->dim[X])
+	return metaball_grid_value(mbs, p, dir, safe);
+    if (mbs->mb.method == METABALL_ISOPOTENTIAL && !mbs->march)
+	return metaball_iso_value(&mbs->mb, p, safe);
+
+    *safe = 0.0;
+    return rt_metaball_point_value((const point_t *)p, &mbs->mb);
+}
+
+
+/* rt_metaball_find_intersection() using the shooting field */
+static void
+metaball_shot_intersection(point_t intersect, const struct metaball_specific *mbs, const point_t a, const point_t b, fastf_t step, const fastf_t finalstep, const vect_t dir)
+{
+    point_t in, out, mid;
+    fastf_t safe;
+
+    if (metaball_shot_value(mbs, a, dir, &safe) >= mbs->mb.threshold) {
+	VMOVE(in, a);
+	VMOVE(out, b);
+    } else {
+	VMOVE(in, b);
+	VMOVE(out, a);
+    }
+
+    while (1) {
+	VADD2(mid, in, out);
+	VSCALE(mid, mid, 0.5);
+	if (finalstep > step || step < SMALL_FASTF)
+	    break;
+	if (metaball_shot_value(mbs, mid, dir, &safe) >= mbs->mb.threshold)
+	    VMOVE(in, mid);
+	else
+	    VMOVE(out, mid);
+	step *= 0.5;
+    }
+
+    VMOVE(intersect, mid);
+}
+
+
 /**
  * prep and build bounding volumes... unfortunately, generating the
  * bounding sphere is too 'loose' (I think) and O(n^2).
@@ -186,6 +545,7 @@ rt_metaball_bbox(struct rt_db_internal *ip, point_t *min, point_t *max, const st
 int
 rt_metaball_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
 {
+    struct metaball_specific *mbs;
     struct rt_metaball_internal *mb, *nmb;
     struct wdb_metaball_pnt *mbpt, *nmbpt;
     fastf_t minfstr = +INFINITY;
@@ -196,7 +556,8 @@ rt_metaball_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rti
     RT_METABALL_CK_MAGIC(mb);
 
     /* generate a copy of the metaball */
-    BU_ALLOC(nmb, struct rt_metaball_internal);
+    BU_ALLOC(mbs, struct metaball_specific);
+    nmb = &mbs->mb;
     nmb->magic = RT_METABALL_INTERNAL_MAGIC;
     BU_LIST_INIT(&nmb->metaball_ctrl_head);
     nmb->threshold = mb->threshold;
@@ -206,8 +567,8 @@ rt_metaball_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rti
     for (BU_LIST_FOR(mbpt, wdb_metaball_pnt, &mb->metaball_ctrl_head)) {
 	BU_ALLOC(nmbpt, struct wdb_metaball_pnt);
 	nmbpt->fldstr = mbpt->fldstr;
-	if (mbpt->fldstr < minfstr)
-	    minfstr = mbpt->fldstr;
+	if (fabs(mbpt->fldstr) < minfstr)
+	    minfstr = fabs(mbpt->fldstr);	/* negative points would make finalstep < 0 */
 	nmbpt->sweat = mbpt->sweat;
 	VMOVE(nmbpt->coord, mbpt->coord);
 	BU_LIST_INSERT(&nmb->metaball_ctrl_head, &nmbpt->l);
@@ -228,7 +589,14 @@ rt_metaball_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rti
     /* generate a bounding box around the sphere...
      * XXX this can be optimized greatly to reduce the BSP presence... */
     if (rt_metaball_bbox(ip, &(stp->st_min), &(stp->st_max), &rtip->rti_tol)) return 1;
-    stp->st_specific = (void *)nmb;
+
+    /* a hasty prep skips the grid, and shots sum every point at every
+     * step */
+    mbs->march = rtip->rti_hasty_prep;
+    if (nmb->method == METABALL_BLOB && !mbs->march)
+	metaball_grid_build(mbs);
+
+    stp->st_specific = (void *)mbs;
     return 0;
 }
 
@@ -361,19 +729,23 @@ rt_metaball_find_intersection(point_t *intersect, const struct rt_metaball_inter
 }
 
 
+/* switching behavior to retain old code for performance and correctness
+ * comparisons. */
+#define SHOOTALGO 3
+
 int
 rt_metaball_shot(struct soltab *stp, register struct xray *rp, struct application *ap, struct seg *seghead)
 {
-    struct rt_metaball_internal *mb = (struct rt_metaball_internal *)stp->st_specific;
+    struct metaball_specific *mbs = (struct metaball_specific *)stp->st_specific;
+    struct rt_metaball_internal *mb = &mbs->mb;
     struct seg *segp = NULL;
     int retval = 0;
-    fastf_t step, distleft;
+    fastf_t step, distleft, safe;
     point_t p, inc;
+#if SHOOTALGO == 2
     const point_t *cp = (const point_t *)&p;
+#endif
 
-    /* switching behavior to retain old code for performance and correctness
-     * comparisons. */
-#define SHOOTALGO 3
 
 #if SHOOTALGO == 2
     int fhin = 1;
@@ -386,7 +758,7 @@ rt_metaball_shot(struct soltab *stp, register struct xray *rp, struct applicatio
     VSCALE(inc, rp->r_dir, step); /* assume it's normalized and we want to creep at step */
 
     /* walk back out of the solid */
-    while (rt_metaball_point_value(cp, mb) >= mb->threshold) {
+    while (metaball_shot_value(mbs, p, rp->r_dir, &safe) >= mb->threshold) {
 #if SHOOTALGO == 2
 	fhin = -1;
 #endif
@@ -447,18 +819,27 @@ rt_metaball_shot(struct soltab *stp, register struct xray *rp, struct applicatio
     {
 	int mb_stat = 0, segsleft = abs(ap->a_onehit);
 	point_t lastpoint;
+	fastf_t adv, val;
 
 	while (distleft >= 0.0 || mb_stat == 1) {
+	    /* outside, skip the whole steps the field is known not to
+	     * reach so the samples stay where the plain march puts them */
+	    adv = step;
+	    if (mb_stat == 0 && safe > step) {
+		if (safe > distleft)
+		    break;
+		adv = floor(safe / step) * step;
+	    }
+
 	    /* advance to the next point */
-	    distleft -= step;
+	    distleft -= adv;
 	    VMOVE(lastpoint, p);
-	    VADD2(p, p, inc);
+	    VJOIN1(p, p, adv, rp->r_dir);
+	    val = metaball_shot_value(mbs, p, rp->r_dir, &safe);
 	    if (mb_stat == 1) {
-		if (rt_metaball_point_value(cp, mb) < mb->threshold) {
+		if (val < mb->threshold) {
 		    point_t intersect, delta;
-		    const point_t *pA = (const point_t *)&lastpoint;
-		    const point_t *pB = (const point_t *)&p;
-		    rt_metaball_find_intersection(&intersect, mb, pA, pB, step, mb->finalstep);
+		    metaball_shot_intersection(intersect, mbs, lastpoint, p, adv, mb->finalstep, rp->r_dir);
 		    VMOVE(segp->seg_out.hit_point, intersect);
 		    --segsleft;
 		    ++retval;
@@ -470,11 +851,9 @@ rt_metaball_shot(struct soltab *stp, register struct xray *rp, struct applicatio
 			return retval;
 		}
 	    } else {
-		if (rt_metaball_point_value(cp, mb) > mb->threshold) {
+		if (val > mb->threshold) {
 		    point_t intersect, delta;
-		    const point_t *pA = (const point_t *)&lastpoint;
-		    const point_t *pB = (const point_t *)&p;
-		    rt_metaball_find_intersection(&intersect, mb, pA, pB, step, mb->finalstep);
+		    metaball_shot_intersection(intersect, mbs, lastpoint, p, adv, mb->finalstep, rp->r_dir);
 		    RT_GET_SEG(segp, ap->a_resource);
 		    segp->seg_stp = stp;
 		    --segsleft;
@@ -611,9 +990,15 @@ rt_metaball_uv(struct application *ap, struct soltab *stp, struct hit *hitp, str
 void
 rt_metaball_free(register struct soltab *stp)
 {
-    struct rt_metaball_internal *metaball = (struct rt_metaball_internal *)stp->st_specific;
+    struct metaball_specific *mbs = (struct metaball_specific *)stp->st_specific;
+    struct wdb_metaball_pnt *mbpt;
 
-    bu_free((char *)metaball, "rt_metaball_internal");
+    metaball_grid_free(mbs);
+    while (BU_LIST_WHILE(mbpt, wdb_metaball_pnt, &mbs->mb.metaball_ctrl_head)) {
+	BU_LIST_DEQUEUE(&(mbpt->l));
+	bu_free(mbpt, "wdb_metaball_pnt");
+    }
+    bu_free((char *)mbs, "metaball_specific");
 }
 
 
@@ -752,17 +752,20 @@ clt_db_store(size_t count, struct soltab *solids[])
 
 	pool = bu_pool_create(1024 * 1024);
 	for (i=1; i <= count; i++) {
-	    size_t size;
             /*bu_log("#%d:\t %s:", i, OBJ[ids[i-1]].ft_name);*/
-	    size = clt_solid_pack(pool, solids[i-1]);
-            /*bu_log("\t(%ld bytes)\n",size);*/
-	    indexes[i] = indexes[i-1] + size;
+	    (void)clt_solid_pack(pool, solids[i-1]);
+	    /* pool offsets include alignment padding */
+	    indexes[i] = bu_pool_used(pool);
+            /*bu_log("\t(%ld bytes)\n",indexes[i]-indexes[i-1]);*/
 	}
         bu_log("OCLDB:\t%ld primitives\n\t%.2f KB indexes, %.2f KB ids, %.2f KB prims\n", count,
 		(sizeof(*indexes)*(count+1))/1024.0, (sizeof(*ids)*count)/1024.0, indexes[count]/1024.0);
 
 	if (indexes[count] != 0) {
-	    clt_db_prims = clCreateBuffer(clt_context, CL_MEM_READ_ONLY|CL_MEM_HOST_WRITE_ONLY|CL_MEM_COPY_HOST_PTR, indexes[count], pool->block, &error);
+	    uint8_t *prims = (uint8_t *)bu_malloc(indexes[count], "prims");
+	    bu_pool_copy(pool, prims);
+	    clt_db_prims = clCreateBuffer(clt_context, CL_MEM_READ_ONLY|CL_MEM_HOST_WRITE_ONLY|CL_MEM_COPY_HOST_PTR, indexes[count], prims, &error);
+	    bu_free(prims, "prims");
 	    if (error != CL_SUCCESS) bu_bomb("failed to create OpenCL indexes buffer");
 	}
         bu_pool_delete(pool);
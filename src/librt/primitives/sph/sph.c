@@ -279,7 +279,9 @@ rt_sph_shot(struct soltab *stp, register struct xray *rp, struct application *ap
 
 #define RT_SPH_SEG_MISS(SEG)		(SEG).seg_stp=(struct soltab *) 0;
 /**
- * This is the Becker vectorized version
+ * Vectorized version.  Pairs are gathered RT_VSHOT_BLOCK at a time
+ * into structure-of-arrays form and intersected without branching,
+ * with the same results as rt_sph_shot().
  */
 void
 rt_sph_vshot(struct soltab **stp, struct xray **rp, struct seg *segp, int n, struct application *ap)
@@ -289,50 +291,69 @@ rt_sph_vshot(struct soltab **stp, struct xray **rp, struct seg *segp, int n, str
     /* Number of ray/object pairs */
 
 {
-    register struct sph_specific *sph;
-    register int i;
-
-    vect_t ov;		/* ray origin to center (V - P) */
-    fastf_t magsq_ov;	/* length squared of ov */
-    fastf_t b;		/* second term of quadratic eqn */
-    fastf_t root;		/* root of radical */
+    int i;
 
     if (ap) RT_CK_APPLICATION(ap);
 
-    /* for each ray/sphere pair */
-    for (i = 0; i < n; i++) {
-	if (stp[i] == 0) continue; /* stp[i] == 0 signals skip ray */
+    for (i = 0; i < n; i += RT_VSHOT_BLOCK) {
+	int pair[RT_VSHOT_BLOCK];
+	fastf_t ov[3][RT_VSHOT_BLOCK];	/* ray origin to center (V - P) */
+	fastf_t dir[3][RT_VSHOT_BLOCK];
+	fastf_t radsq[RT_VSHOT_BLOCK];
+	fastf_t b[RT_VSHOT_BLOCK];	/* second term of quadratic eqn */
+	fastf_t root[RT_VSHOT_BLOCK];	/* root of radical */
+	int hit[RT_VSHOT_BLOCK];
+	int j, m = 0;
+
+	/* gather the pairs of this block, stp[i] == 0 signals skip ray */
+	for (j = i; j < i + RT_VSHOT_BLOCK && j < n; j++) {
+	    const struct sph_specific *sph;
+
+	    if (stp[j] == 0)
+		continue;
 
-	sph = (struct sph_specific *)stp[i]->st_specific;
-	VSUB2(ov, sph->sph_V, rp[i]->r_pt);
-	b = VDOT(rp[i]->r_dir, ov);
-	magsq_ov = MAGSQ(ov);
+	    sph = (const struct sph_specific *)stp[j]->st_specific;
+	    pair[m] = j;
+	    ov[X][m] = sph->sph_V[X] - rp[j]->r_pt[X];
+	    ov[Y][m] = sph->sph_V[Y] - rp[j]->r_pt[Y];
+	    ov[Z][m] = sph->sph_V[Z] - rp[j]->r_pt[Z];
+	    dir[X][m] = rp[j]->r_dir[X];
+	    dir[Y][m] = rp[j]->r_dir[Y];
+	    dir[Z][m] = rp[j]->r_dir[Z];
+	    radsq[m] = sph->sph_radsq;
+	    m++;
+	}
 
-	if (magsq_ov >= sph->sph_radsq) {
-	    /* ray origin is outside of sphere */
-	    if (b < 0) {
-		/* ray direction is away from sphere */
-		RT_SPH_SEG_MISS(segp[i]);		/* No hit */
-		continue;
-	    }
-	    root = b*b - magsq_ov + sph->sph_radsq;
-	    if (root <= 0) {
-		/* no real roots */
-		RT_SPH_SEG_MISS(segp[i]);		/* No hit */
-		continue;
-	    }
-	} else {
-	    root = b*b - magsq_ov + sph->sph_radsq;
+	for (j = 0; j < m; j++) {
+	    fastf_t magsq_ov = ov[X][j]*ov[X][j] + ov[Y][j]*ov[Y][j] + ov[Z][j]*ov[Z][j];
+	    fastf_t disc;
+
+	    b[j] = dir[X][j]*ov[X][j] + dir[Y][j]*ov[Y][j] + dir[Z][j]*ov[Z][j];
+	    disc = b[j]*b[j] - magsq_ov + radsq[j];
+
+	    /* from outside, the ray must head towards the center and
+	     * have real roots.  from inside, it always hits.
+	     */
+	    hit[j] = (magsq_ov < radsq[j]) | ((b[j] >= 0) & (disc > 0));
+	    root[j] = sqrt(hit[j] ? disc : 0.0);
 	}
-	root = sqrt(root);
 
-	segp[i].seg_stp = stp[i];
+	/* scatter */
+	for (j = 0; j < m; j++) {
+	    struct seg *sp = &segp[pair[j]];
 
-	/* we know root is positive, so we know the smaller t */
-	segp[i].seg_in.hit_dist = b - root;
-	segp[i].seg_out.hit_dist = b + root;
-	segp[i].seg_in.hit_surfno = 0;
-	segp[i].seg_out.hit_surfno = 0;
+	    if (!hit[j]) {
+		RT_SPH_SEG_MISS(*sp);		/* No hit */
+		continue;
+	    }
+	    sp->seg_stp = stp[pair[j]];
+
+	    /* we know root is positive, so we know the smaller t */
+	    sp->seg_in.hit_dist = b[j] - root[j];
+	    sp->seg_out.hit_dist = b[j] + root[j];
+	    sp->seg_in.hit_surfno = 0;
+	    sp->seg_out.hit_surfno = 0;
+	}
     }
 }
 
@@ -1716,7 +1716,7 @@ const struct rt_functab OBJ[] = {
 	RTFUNCTAB_FUNC_FREE_CAST(rt_bot_free),
 	RTFUNCTAB_FUNC_PLOT_CAST(rt_bot_plot),
 	RTFUNCTAB_FUNC_ADAPTIVE_PLOT_CAST(rt_bot_adaptive_plot),
-	NULL, /* vshot */
+	RTFUNCTAB_FUNC_VSHOT_CAST(rt_bot_vshot),
 	RTFUNCTAB_FUNC_TESS_CAST(rt_bot_tess),
 	NULL, /* tnurb */
 	RTFUNCTAB_FUNC_BREP_CAST(rt_bot_brep),
@@ -1743,7 +1743,7 @@ const struct rt_functab OBJ[] = {
 	NULL, /* find_selections */
 	NULL, /* evaluate_selection */
 	NULL, /* process_selection */
-	NULL, /* serialize */
+	RTFUNCTAB_FUNC_PREP_SERIALIZE_CAST(rt_bot_prep_serialize),
 	NULL, /* label */
 	RTFUNCTAB_FUNC_KEYPOINT_CAST(rt_bot_keypoint), /* keypoint */
 	RTFUNCTAB_FUNC_MAT_CAST(rt_bot_mat),
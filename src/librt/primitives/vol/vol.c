@@ -29,6 +29,7 @@
 
 #include "common.h"
 
+#include <stdlib.h>
 #include <stddef.h>
 #include <ctype.h>
 #include <math.h>
@@ -59,9 +60,22 @@ struct rt_vol_specific {
     mat_t vol_mat;	/* model to ideal space */
     vect_t vol_origin;	/* local coords of grid origin (0, 0, 0) for now */
     vect_t vol_large;	/* local coords of XYZ max */
+    unsigned char *vol_bricks;	/* nonzero where a brick has a voxel in lo..hi */
+    size_t vol_bdim[3];	/* number of bricks along XYZ */
 };
 #define VOL_NULL ((struct rt_vol_specific *)0)
 
+/* Voxels along each side of the bricks used to step rays over empty
+ * space.  Only bricks with no voxel in the lo..hi range are skipped.
+ */
+#define VOL_BRICK 8
+
+/* The main loop below breaks ties between cell exits in favor of Y,
+ * then X, then Z.  Brick skipping visits the axes in the reverse of
+ * that order so its ties come out the same way.
+ */
+static const int vol_tie_order[3] = {Z, X, Y};
+
 #define VOL_O(m) bu_offsetof(struct rt_vol_internal, m)
 
 const struct bu_structparse rt_vol_parse[] = {
@@ -118,6 +132,105 @@ extern int rt_binunif_describe(struct bu_vls  *str, const struct rt_db_internal
 
 static int rt_vol_normtab[3] = { NORM_XPOS, NORM_YPOS, NORM_ZPOS };
 
+
+static void
+vol_bricks_build(struct rt_vol_specific *volp)
+{
+    struct rt_vol_internal *vip = &volp->vol_i;
+    size_t x, y, z;
+
+    volp->vol_bdim[X] = (vip->xdim + VOL_BRICK - 1) / VOL_BRICK;
+    volp->vol_bdim[Y] = (vip->ydim + VOL_BRICK - 1) / VOL_BRICK;
+    volp->vol_bdim[Z] = (vip->zdim + VOL_BRICK - 1) / VOL_BRICK;
+    volp->vol_bricks = (unsigned char *)bu_calloc(volp->vol_bdim[X] * volp->vol_bdim[Y] * volp->vol_bdim[Z], 1, "vol bricks");
+
+    for (z = 0; z < vip->zdim; z++) {
+	for (y = 0; y < vip->ydim; y++) {
+	    unsigned char *row = &volp->vol_bricks[((z / VOL_BRICK) * volp->vol_bdim[Y] + y / VOL_BRICK) * volp->vol_bdim[X]];
+	    for (x = 0; x < vip->xdim; x++) {
+		if (OK(vip, (size_t)VOL(vip, x, y, z)))
+		    row[x / VOL_BRICK] = 1;
+	    }
+	}
+    }
+}
+
+
+/* Returns truthfully if cell igrid lies in a brick with no solid voxels */
+static int
+vol_brick_empty(const struct rt_vol_specific *volp, const int igrid[3])
+{
+    size_t bx, by, bz;
+
+    if (igrid[X] < 0 || igrid[Y] < 0 || igrid[Z] < 0)
+	return 0;
+    bx = (size_t)igrid[X] / VOL_BRICK;
+    by = (size_t)igrid[Y] / VOL_BRICK;
+    bz = (size_t)igrid[Z] / VOL_BRICK;
+    if (bx >= volp->vol_bdim[X] || by >= volp->vol_bdim[Y] || bz >= volp->vol_bdim[Z])
+	return 0;
+
+    return !volp->vol_bricks[(bz * volp->vol_bdim[Y] + by) * volp->vol_bdim[X] + bx];
+}
+
+
+/* Advance the DDA state from cell igrid to the first cell past its
+ * brick, as if each cell in between had been stepped through.
+ * Returns the axis the brick was left through, or -1 if the ray does
+ * not move.
+ */
+static int
+vol_brick_skip(const vect_t dir, int igrid[3], vect_t t, const vect_t delta, double *t0)
+{
+    double texit = INFINITY;
+    int n[3] = {0, 0, 0};
+    int rank[3] = {0, 0, 0};
+    int out_axis = -1;
+    int o, i;
+
+    for (o = 0; o < 3; o++) {
+	int b;
+	double te;
+	i = vol_tie_order[o];
+	rank[i] = o;
+	if (ZERO(delta[i]))
+	    continue;
+	b = igrid[i] / VOL_BRICK;
+	if (dir[i] > 0)
+	    n[i] = (b + 1) * VOL_BRICK - igrid[i];
+	else
+	    n[i] = igrid[i] - b * VOL_BRICK + 1;
+	te = t[i] + (n[i] - 1) * delta[i];
+	if (te <= texit) {
+	    texit = te;
+	    out_axis = i;
+	}
+    }
+    if (out_axis < 0)
+	return -1;
+
+    for (i = X; i <= Z; i++) {
+	int k = 0;
+	if (i == out_axis) {
+	    k = n[i];
+	} else if (n[i] && t[i] <= texit) {
+	    /* crossings of this axis the main loop would take before
+	     * the brick exit, including one at the same t if this axis
+	     * wins the tie */
+	    k = (int)ceil((texit - t[i]) / delta[i]);
+	    if (rank[i] > rank[out_axis] && t[i] + k * delta[i] == texit)
+		k++;
+	    if (k > n[i])
+		k = n[i];
+	}
+	t[i] += k * delta[i];
+	igrid[i] += (dir[i] > 0) ? k : -k;
+    }
+    *t0 = texit;
+
+    return out_axis;
+}
+
 /**
  * Transform the ray into local coordinates of the volume ("ideal space").
  * Step through the 3-D array, in local coordinates.
@@ -305,6 +418,15 @@ rt_vol_shot(struct soltab *stp, register struct xray *rp, struct application *ap
 	int val;
 	struct seg *segp;
 
+	/* Step over bricks with nothing in them */
+	if (!inside && volp->vol_bricks && vol_brick_empty(volp, igrid)) {
+	    int skip_axis = vol_brick_skip(rp->r_dir, igrid, t, delta, &t0);
+	    if (skip_axis >= 0) {
+		in_axis = skip_axis;
+		continue;
+	    }
+	}
+
 	/* find minimum exit t value */
 	if (t[X] < t[Y]) {
 	    if (t[Z] < t[X]) {
@@ -977,17 +1099,8 @@ rt_vol_bbox(struct rt_db_internal *ip, point_t *min, point_t *max, const struct
 }
 
 
-/**
- * Returns -
- * 0 OK
- * !0 Failure
- *
- * Implicit return -
- * A struct rt_vol_specific is created, and its address is stored
- * in stp->st_specific for use by rt_vol_shot().
- */
-int
-rt_vol_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
+static struct rt_vol_specific *
+vol_specific_setup(struct soltab *stp, struct rt_db_internal *ip)
 {
     struct rt_vol_internal *vip;
     register struct rt_vol_specific *volp;
@@ -995,16 +1108,17 @@ rt_vol_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
     vect_t radvec;
     vect_t diam;
 
-    RT_CK_SOLTAB(stp);
-    RT_CK_DB_INTERNAL(ip);
-    if (rtip) RT_CK_RTI(rtip);
-
     vip = (struct rt_vol_internal *)ip->idb_ptr;
     RT_VOL_CK_MAGIC(vip);
 
+    /* Find bounding RPP of rotated local RPP */
+    if (rt_vol_bbox(ip, &(stp->st_min), &(stp->st_max), NULL))
+	return VOL_NULL;
+
     BU_GET(volp, struct rt_vol_specific);
     volp->vol_i = *vip;		/* struct copy */
     vip->map = (unsigned char *)0;	/* "steal" the bitmap storage */
+    volp->vol_bricks = NULL;
 
     /* build Xform matrix from model(world) to ideal(local) space */
     bn_mat_inv(volp->vol_mat, vip->mat);
@@ -1019,8 +1133,6 @@ rt_vol_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
 
     stp->st_specific = (void *)volp;
 
-    /* Find bounding RPP of rotated local RPP */
-    if (rt_vol_bbox(ip, &(stp->st_min), &(stp->st_max), &rtip->rti_tol)) return 1;
     VSET(volp->vol_large,
 	 volp->vol_i.xdim*vip->cellsize[0], volp->vol_i.ydim*vip->cellsize[1], volp->vol_i.zdim*vip->cellsize[2]);/* type conversion */
 
@@ -1033,6 +1145,37 @@ rt_vol_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
     VSCALE(radvec, diam, 0.5);
     stp->st_aradius = stp->st_bradius = MAGNITUDE(radvec);
 
+    return volp;
+}
+
+
+/**
+ * Returns -
+ * 0 OK
+ * !0 Failure
+ *
+ * Implicit return -
+ * A struct rt_vol_specific is created, and its address is stored
+ * in stp->st_specific for use by rt_vol_shot().
+ */
+int
+rt_vol_prep(struct soltab *stp, struct rt_db_internal *ip, struct rt_i *rtip)
+{
+    struct rt_vol_specific *volp;
+
+    RT_CK_SOLTAB(stp);
+    RT_CK_DB_INTERNAL(ip);
+    if (rtip) RT_CK_RTI(rtip);
+
+    volp = vol_specific_setup(stp, ip);
+    if (!volp)
+	return 1;
+
+    /* A hasty prep leaves the bricks out, so rays step through
+     * every cell */
+    if (!rtip || !rtip->rti_hasty_prep)
+	vol_bricks_build(volp);
+
     return 0;		/* OK */
 }
 
@@ -1141,6 +1284,10 @@ rt_vol_free(struct soltab *stp)
 	bu_free((char *)volp->vol_i.map, "vol_map");
 	volp->vol_i.map = NULL; /* sanity */
     }
+    if (volp->vol_bricks) {
+	bu_free(volp->vol_bricks, "vol bricks");
+	volp->vol_bricks = NULL;
+    }
     BU_PUT(volp, struct rt_vol_specific);
 }
 
@@ -30,6 +30,9 @@
 #include "raytrace.h"
 #include "bv/plot3.h"
 
+#include "./cut_hlbvh.h"
+
+#define HLBVH_STACK_SIZE 256
 
 #define V3PT_DEPARTING_RPP(_step, _lo, _hi, _pt)			\
     PT_DEPARTING_RPP(_step, _lo, _hi, (_pt)[X], (_pt)[Y], (_pt)[Z])
@@ -640,11 +643,131 @@ rt_plot_cell(const union cutter *cutp, const struct rt_shootray_status *ssp, str
 }
 
 
+/**
+ * Fire the ray of the current cell at a single solid that does not
+ * use "pieces", adding any resulting segments to the list awaiting
+ * rt_boolweave().  Solids already fired at by this ray are skipped.
+ */
+static inline void
+shoot_solid(struct soltab *stp, struct rt_shootray_status *ssp, struct bu_bitv *solidbits, struct seg *waiting_segs)
+{
+    struct application *ap = ssp->ap;
+    struct resource *resp = ssp->resp;
+    const int debug_shoot = RT_G_DEBUG & RT_DEBUG_SHOOT;
+    struct seg new_segs;	/* from solid intersections */
+    struct seg *s2;
+    int ret;
+
+    if (BU_BITTEST(solidbits, stp->st_bit)) {
+	resp->re_ndup++;
+	return;	/* already shot */
+    }
+
+    /* Shoot a ray */
+    BU_BITSET(solidbits, stp->st_bit);
+
+    /* Check against bounding RPP, if desired by solid */
+    if (stp->st_meth->ft_use_rpp) {
+	if (!rt_in_rpp(&ssp->newray, ssp->inv_dir,
+		       stp->st_min, stp->st_max)) {
+	    if (debug_shoot)bu_log("rpp miss %s\n", stp->st_name);
+	    resp->re_prune_solrpp++;
+	    return;	/* MISS */
+	}
+	if (ssp->dist_corr + ssp->newray.r_max < BACKING_DIST) {
+	    if (debug_shoot)bu_log("rpp skip %s, dist_corr=%g, r_max=%g\n", stp->st_name, ssp->dist_corr, ssp->newray.r_max);
+	    resp->re_prune_solrpp++;
+	    return;	/* MISS */
+	}
+    }
+
+    if (debug_shoot)bu_log("shooting %s\n", stp->st_name);
+    resp->re_shots++;
+    BU_LIST_INIT(&(new_segs.l));
+
+    ret = -1;
+    if (stp->st_meth->ft_shot) {
+	ret = stp->st_meth->ft_shot(stp, &ssp->newray, ap, &new_segs);
+    }
+    if (ret <= 0) {
+	resp->re_shot_miss++;
+	return;	/* MISS */
+    }
+
+    /* Add seg chain to list awaiting rt_boolweave() */
+    while (BU_LIST_WHILE(s2, seg, &(new_segs.l))) {
+	BU_LIST_DEQUEUE(&(s2->l));
+	/* Restore to original distance */
+	s2->seg_in.hit_dist += ssp->dist_corr;
+	s2->seg_out.hit_dist += ssp->dist_corr;
+	s2->seg_in.hit_rayp = s2->seg_out.hit_rayp = &ap->a_ray;
+	BU_LIST_INSERT(&(waiting_segs->l), &(s2->l));
+    }
+    resp->re_shot_hit++;
+}
+
+
+/**
+ * Walk the scene HLBVH built by rt_cut_bvh() with the ray of the
+ * current cell, firing at the solids of every leaf whose bounds the
+ * ray passes through.  Subtrees lying entirely behind BACKING_DIST
+ * are culled like solids are in shoot_solid().
+ */
+static void
+shoot_bvh_solids(struct rt_shootray_status *ssp, struct bu_bitv *solidbits, struct seg *waiting_segs)
+{
+    const struct rt_i *rtip = ssp->ap->a_rt_i;
+    const struct bvh_flat_node *stack_node[HLBVH_STACK_SIZE];
+    const fastf_t min_t = BACKING_DIST - ssp->dist_corr;
+    int stack_ind = 0;
+
+    stack_node[stack_ind++] = rtip->rti_bvh_nodes;
+
+    while (stack_ind > 0) {
+	const struct bvh_flat_node *node = stack_node[--stack_ind];
+	point_t lows_t, highs_t, low_ts, high_ts;
+	fastf_t low_t, high_t;
+
+	VSUB2(lows_t, &node->bounds[0], ssp->newray.r_pt);
+	VSUB2(highs_t, &node->bounds[3], ssp->newray.r_pt);
+	VELMUL(lows_t, lows_t, ssp->inv_dir);
+	VELMUL(highs_t, highs_t, ssp->inv_dir);
+
+	VMOVE(low_ts, lows_t);
+	VMOVE(high_ts, lows_t);
+	VMINMAX(low_ts, high_ts, highs_t);
+
+	high_t = FMIN(high_ts[X], FMIN(high_ts[Y], high_ts[Z]));
+	low_t = FMAX(low_ts[X], FMAX(low_ts[Y], low_ts[Z]));
+	if (high_t < min_t || low_t > high_t) {
+	    ssp->resp->re_prune_solrpp++;
+	    continue;
+	}
+
+	if (node->n_primitives > 0) {
+	    long i;
+	    for (i = 0; i < node->n_primitives; i++) {
+		struct soltab *stp = rtip->rti_bvh_solids[node->data.first_prim_offset + i];
+		/* slots freed by rt_unprep() are NULL */
+		if (stp)
+		    shoot_solid(stp, ssp, solidbits, waiting_segs);
+	    }
+	    continue;
+	}
+
+	if (UNLIKELY(stack_ind + 2 > HLBVH_STACK_SIZE))
+	    bu_bomb("Stack size exceeded in scene hlbvh shot");
+
+	stack_node[stack_ind++] = node->data.other_child;
+	stack_node[stack_ind++] = node + 1;
+    }
+}
+
+
 _BU_ATTR_FLATTEN int
 rt_shootray(register struct application *ap)
 {
     struct rt_shootray_status ss;
-    struct seg new_segs;	/* from solid intersections */
     struct seg waiting_segs;	/* awaiting rt_boolweave() */
     struct seg finished_segs;	/* processed by rt_boolweave() */
     fastf_t last_bool_start;
@@ -711,7 +834,6 @@ rt_shootray(register struct application *ap)
     FinalPart.pt_magic = PT_HD_MAGIC;
     ap->a_Final_Part_hdp = &FinalPart;
 
-    BU_LIST_INIT(&new_segs.l);
     BU_LIST_INIT(&waiting_segs.l);
     BU_LIST_INIT(&finished_segs.l);
     ap->a_finished_segs_hdp = &finished_segs;
@@ -1064,60 +1186,19 @@ rt_shootray(register struct application *ap)
 
 	/* Consider all solids within the box */
 	if (cutp->bn.bn_len > 0 && ss.box_end >= BACKING_DIST) {
-	    stpp = &(cutp->bn.bn_list[cutp->bn.bn_len-1]);
-	    for (; stpp >= cutp->bn.bn_list; stpp--) {
-		register struct soltab *stp = *stpp;
-		int ret;
+	    const union cutter *listp = cutp;
 
-		if (BU_BITTEST(solidbits, stp->st_bit)) {
-		    resp->re_ndup++;
-		    continue;	/* already shot */
-		}
-
-		/* Shoot a ray */
-		BU_BITSET(solidbits, stp->st_bit);
-
-		/* Check against bounding RPP, if desired by solid */
-		if (stp->st_meth->ft_use_rpp) {
-		    if (!rt_in_rpp(&ss.newray, ss.inv_dir,
-				   stp->st_min, stp->st_max)) {
-			if (debug_shoot)bu_log("rpp miss %s\n", stp->st_name);
-			resp->re_prune_solrpp++;
-			continue;	/* MISS */
-		    }
-		    if (ss.dist_corr + ss.newray.r_max < BACKING_DIST) {
-			if (debug_shoot)bu_log("rpp skip %s, dist_corr=%g, r_max=%g\n", stp->st_name, ss.dist_corr, ss.newray.r_max);
-			resp->re_prune_solrpp++;
-			continue;	/* MISS */
-		    }
-		}
-
-		if (debug_shoot)bu_log("shooting %s\n", stp->st_name);
-		resp->re_shots++;
-		BU_LIST_INIT(&(new_segs.l));
-
-		ret = -1;
-		if (stp->st_meth->ft_shot) {
-		    ret = stp->st_meth->ft_shot(stp, &ss.newray, ap, &new_segs);
-		}
-		if (ret <= 0) {
-		    resp->re_shot_miss++;
-		    continue;	/* MISS */
-		}
-
-		/* Add seg chain to list awaiting rt_boolweave() */
-		{
-		    register struct seg *s2;
-		    while (BU_LIST_WHILE(s2, seg, &(new_segs.l))) {
-			BU_LIST_DEQUEUE(&(s2->l));
-			/* Restore to original distance */
-			s2->seg_in.hit_dist += ss.dist_corr;
-			s2->seg_out.hit_dist += ss.dist_corr;
-			s2->seg_in.hit_rayp = s2->seg_out.hit_rayp = &ap->a_ray;
-			BU_LIST_INSERT(&(waiting_segs.l), &(s2->l));
-		    }
-		}
-		resp->re_shot_hit++;
+	    if (rtip->rti_bvh_nodes && cutp == &rtip->rti_CutHead) {
+		/* finite solids come from the scene HLBVH, infinite
+		 * ones are only listed in rti_inf_box.
+		 */
+		shoot_bvh_solids(&ss, solidbits, &waiting_segs);
+		listp = &rtip->rti_inf_box;
+	    }
+	    if (listp->bn.bn_len > 0) {
+		stpp = &(listp->bn.bn_list[listp->bn.bn_len-1]);
+		for (; stpp >= listp->bn.bn_list; stpp--)
+		    shoot_solid(*stpp, &ss, solidbits, &waiting_segs);
 	    }
 	}
 	if (RT_G_DEBUG & RT_DEBUG_ADVANCE)
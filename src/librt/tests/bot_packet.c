@@ -0,0 +1,284 @@
+/*                    B O T _ P A C K E T . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file bot_packet.c
+ *
+ * Compare the hits the packet (vectorized) BoT shot finds with those
+ * of the per-ray BoT shot for the same rays, for solid, plate and
+ * surface mode BoTs.
+ *
+ */
+
+#include "common.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "bu/app.h"
+#include "bu/file.h"
+#include "bu/log.h"
+#include "bu/malloc.h"
+#include "vmath.h"
+#include "wdb.h"
+#include "raytrace.h"
+
+
+#define BOT_PACKET_DB "bot_packet.g"
+
+/* rays per side of each grid */
+#define BOT_PACKET_GRID 24
+
+/* sphere tessellation */
+#define NLAT 12
+#define NLON 24
+
+#define NVERTS (2 + (NLAT - 1) * NLON)
+#define NFACES (2 * NLON * (NLAT - 1))
+
+
+/* A tessellated sphere of radius r with outward (CCW) facing faces */
+static void
+mk_sphere_bot(struct rt_wdb *wdbp, const char *name, unsigned char mode, fastf_t r)
+{
+    fastf_t verts[NVERTS * 3];
+    int faces[NFACES * 3];
+    fastf_t thick[NFACES];
+    struct bu_bitv *face_mode = NULL;
+    int nf = 0;
+    int i, j, k;
+
+    VSET(&verts[0], 0.0, 0.0, r);
+    for (i = 1; i < NLAT; i++) {
+	fastf_t phi = M_PI * i / NLAT;
+	for (j = 0; j < NLON; j++) {
+	    fastf_t theta = M_2PI * j / NLON;
+	    VSET(&verts[3 * (1 + (i - 1) * NLON + j)], r * sin(phi) * cos(theta), r * sin(phi) * sin(theta), r * cos(phi));
+	}
+    }
+    VSET(&verts[3 * (NVERTS - 1)], 0.0, 0.0, -r);
+
+#define RING(_i, _j) (1 + ((_i) - 1) * NLON + ((_j) % NLON))
+    for (j = 0; j < NLON; j++) {
+	VSET(&faces[3 * nf], 0, RING(1, j), RING(1, j + 1));
+	nf++;
+	VSET(&faces[3 * nf], NVERTS - 1, RING(NLAT - 1, j + 1), RING(NLAT - 1, j));
+	nf++;
+    }
+    for (i = 1; i < NLAT - 1; i++) {
+	for (j = 0; j < NLON; j++) {
+	    VSET(&faces[3 * nf], RING(i, j), RING(i + 1, j), RING(i + 1, j + 1));
+	    nf++;
+	    VSET(&faces[3 * nf], RING(i, j), RING(i + 1, j + 1), RING(i, j + 1));
+	    nf++;
+	}
+    }
+#undef RING
+
+    /* make sure every face points away from the center */
+    for (k = 0; k < nf; k++) {
+	vect_t a, b, n;
+	point_t c;
+	VSUB2(a, &verts[3 * faces[3 * k + 1]], &verts[3 * faces[3 * k]]);
+	VSUB2(b, &verts[3 * faces[3 * k + 2]], &verts[3 * faces[3 * k]]);
+	VCROSS(n, a, b);
+	VADD3(c, &verts[3 * faces[3 * k]], &verts[3 * faces[3 * k + 1]], &verts[3 * faces[3 * k + 2]]);
+	if (VDOT(n, c) < 0.0) {
+	    int tmp = faces[3 * k + 1];
+	    faces[3 * k + 1] = faces[3 * k + 2];
+	    faces[3 * k + 2] = tmp;
+	}
+	thick[k] = 1.0;
+    }
+
+    if (mode == RT_BOT_PLATE) {
+	face_mode = bu_bitv_new(NFACES);
+	mk_bot(wdbp, name, mode, RT_BOT_CCW, 0, NVERTS, NFACES, verts, faces, thick, face_mode);
+	bu_bitv_free(face_mode);
+    } else {
+	mk_bot(wdbp, name, mode, RT_BOT_CCW, 0, NVERTS, NFACES, verts, faces, NULL, NULL);
+    }
+}
+
+
+static int
+hit_differs(const struct hit *a, const struct hit *b, fastf_t tol)
+{
+    return a->hit_surfno != b->hit_surfno
+	|| !NEAR_EQUAL(a->hit_dist, b->hit_dist, tol)
+	|| !VNEAR_EQUAL(a->hit_vpriv, b->hit_vpriv, tol);
+}
+
+
+/* Shoot a grid of parallel rays along dir at one BoT with its ft_vshot
+ * and its ft_shot, and compare the first segment of each ray.
+ * Returns the number of mismatched rays.
+ */
+static int
+check_bot(struct rt_i *rtip, struct soltab *stp, const vect_t dir)
+{
+    size_t nrays = BOT_PACKET_GRID * BOT_PACKET_GRID;
+    struct application ap;
+    struct soltab **stps;
+    struct xray *rays;
+    struct xray **rps;
+    struct seg *vsegs;
+    vect_t u, v;
+    point_t base;
+    fastf_t tol = rtip->rti_tol.dist * 1.0e-3;
+    size_t i, j;
+    int nhits = 0;
+    int bad = 0;
+
+    RT_APPLICATION_INIT(&ap);
+    ap.a_rt_i = rtip;
+    ap.a_resource = &rt_uniresource;
+
+    stps = (struct soltab **)bu_calloc(nrays, sizeof(struct soltab *), "stps");
+    rays = (struct xray *)bu_calloc(nrays, sizeof(struct xray), "rays");
+    rps = (struct xray **)bu_calloc(nrays, sizeof(struct xray *), "rps");
+    vsegs = (struct seg *)bu_calloc(nrays, sizeof(struct seg), "vsegs");
+
+    bn_vec_ortho(u, dir);
+    VCROSS(v, dir, u);
+    VJOIN1(base, stp->st_center, -2.0 * stp->st_bradius, dir);
+
+    /* the odd offsets keep rays off exact edges and vertices */
+    for (i = 0; i < BOT_PACKET_GRID; i++) {
+	for (j = 0; j < BOT_PACKET_GRID; j++) {
+	    size_t r = i * BOT_PACKET_GRID + j;
+	    fastf_t s = ((i + 0.37) / BOT_PACKET_GRID * 2.0 - 1.0) * stp->st_bradius;
+	    fastf_t t = ((j + 0.61) / BOT_PACKET_GRID * 2.0 - 1.0) * stp->st_bradius;
+
+	    rays[r].magic = RT_RAY_MAGIC;
+	    VJOIN2(rays[r].r_pt, base, s, u, t, v);
+	    VMOVE(rays[r].r_dir, dir);
+	    rays[r].index = (int)r;
+	    stps[r] = stp;
+	    rps[r] = &rays[r];
+	    BU_LIST_INIT(&(vsegs[r].l));
+	}
+    }
+
+    OBJ[ID_BOT].ft_vshot(stps, rps, vsegs, (int)nrays, &ap);
+
+    for (i = 0; i < nrays; i++) {
+	struct seg segs;
+	struct seg *first = NULL;
+	int ret;
+
+	BU_LIST_INIT(&(segs.l));
+	ret = OBJ[ID_BOT].ft_shot(stp, &rays[i], &ap, &segs);
+	if (ret > 0 && BU_LIST_NON_EMPTY(&(segs.l)))
+	    first = BU_LIST_FIRST(seg, &(segs.l));
+
+	if (!first != !vsegs[i].seg_stp) {
+	    bu_log("%s ray %zu: packet %s, scalar %s\n", stp->st_name, i,
+		   vsegs[i].seg_stp ? "hit" : "missed", first ? "hit" : "missed");
+	    bad++;
+	} else if (first) {
+	    nhits++;
+	    if (hit_differs(&first->seg_in, &vsegs[i].seg_in, tol)
+		|| hit_differs(&first->seg_out, &vsegs[i].seg_out, tol)) {
+		bu_log("%s ray %zu: packet %g(%d)..%g(%d), scalar %g(%d)..%g(%d)\n", stp->st_name, i,
+		       vsegs[i].seg_in.hit_dist, vsegs[i].seg_in.hit_surfno,
+		       vsegs[i].seg_out.hit_dist, vsegs[i].seg_out.hit_surfno,
+		       first->seg_in.hit_dist, first->seg_in.hit_surfno,
+		       first->seg_out.hit_dist, first->seg_out.hit_surfno);
+		bad++;
+	    }
+	}
+	RT_FREE_SEG_LIST(&segs, ap.a_resource);
+    }
+
+    if (nhits == 0) {
+	bu_log("%s: no hits along (%g %g %g)\n", stp->st_name, V3ARGS(dir));
+	bad++;
+    }
+
+    bu_free(stps, "stps");
+    bu_free(rays, "rays");
+    bu_free(rps, "rps");
+    bu_free(vsegs, "vsegs");
+
+    return bad;
+}
+
+
+int
+main(int UNUSED(argc), char *argv[])
+{
+    const char *names[] = {"solid.bot", "plate.bot", "surface.bot"};
+    unsigned char modes[] = {RT_BOT_SOLID, RT_BOT_PLATE, RT_BOT_SURFACE};
+    struct rt_wdb *wdbp;
+    struct rt_i *rtip;
+    vect_t dirs[3];
+    size_t i, j;
+    int bad = 0;
+
+    bu_setprogname(argv[0]);
+
+    bu_file_delete(BOT_PACKET_DB);
+    wdbp = wdb_fopen(BOT_PACKET_DB);
+    if (!wdbp)
+	bu_exit(1, "unable to create %s\n", BOT_PACKET_DB);
+
+    for (i = 0; i < 3; i++)
+	mk_sphere_bot(wdbp, names[i], modes[i], 10.0 * (i + 1));
+
+    rtip = rt_new_rti(wdbp->dbip);
+    if (rt_gettrees(rtip, 3, names, 1) < 0)
+	bu_exit(1, "rt_gettrees() failed\n");
+    rt_prep(rtip);
+
+    VSET(dirs[0], 1.0, 0.0, 0.0);
+    VSET(dirs[1], 0.0, 0.0, -1.0);
+    VSET(dirs[2], -0.3, 0.5, 0.8);
+    VUNITIZE(dirs[2]);
+
+    for (i = 0; i < 3; i++) {
+	struct soltab *stp = rt_find_solid(rtip, names[i]);
+	if (!stp)
+	    bu_exit(1, "%s was not prepped\n", names[i]);
+	for (j = 0; j < 3; j++)
+	    bad += check_bot(rtip, stp, dirs[j]);
+    }
+
+    rt_free_rti(rtip);
+    wdb_close(wdbp);
+    bu_file_delete(BOT_PACKET_DB);
+
+    if (bad) {
+	bu_log("BoT packet shot: %d mismatched rays [FAIL]\n", bad);
+	return 1;
+    }
+
+    bu_log("BoT packet shot [PASS]\n");
+    return 0;
+}
+
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
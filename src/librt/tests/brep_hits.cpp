@@ -0,0 +1,422 @@
+/*                   B R E P _ H I T S . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file brep_hits.cpp
+ *
+ * Check the pieces of rt_brep_shot() that replaced its list based
+ * code against that code:
+ *
+ * - the flattened hierarchy walk has to find the same surface tree
+ *   leaves, in the same order, as BBNode::intersectsHierarchy(), less
+ *   the leaves that are trimmed away entirely;
+ *
+ * - the single pass near-miss pruning has to leave the same hits as
+ *   erasing one miss at a time and starting over;
+ *
+ * - and shooting brep spheres, boxes and cylinders has to find the
+ *   same partitions as shooting the matching CSG solids.
+ *
+ */
+
+#include "common.h"
+
+#include <list>
+#include <vector>
+
+#include "bu/app.h"
+#include "bu/env.h"
+#include "bu/file.h"
+#include "bu/log.h"
+#include "vmath.h"
+#include "bn.h"
+#include "brep.h"
+#include "wdb.h"
+#include "raytrace.h"
+
+#include "../primitives/brep/brep_local.h"
+#include "./partcmp.h"
+
+
+#define BREP_HITS_DB "brep_hits.g"
+
+/* rays per side of each grid */
+#define BREP_HITS_GRID 40
+
+/* random hit lists fed to the near-miss pruning */
+#define BREP_HITS_LISTS 200000
+
+
+/* Just the members the near-miss pruning looks at, plus the order the
+ * hit was generated in so results can be compared.
+ */
+struct test_hit {
+    enum hit_type {
+	CLEAN_HIT,
+	CLEAN_MISS,
+	NEAR_HIT,
+	NEAR_MISS
+    };
+    enum hit_direction {
+	ENTERING,
+	LEAVING
+    };
+
+    enum hit_type hit;
+    enum hit_direction direction;
+    int id;
+};
+
+
+/* The pruning rt_brep_shot() used to do on its std::list of hits */
+static void
+prune_reference(std::list<test_hit> &hits)
+{
+    std::list<test_hit>::iterator prev;
+    std::list<test_hit>::const_iterator next;
+    std::list<test_hit>::iterator curr = hits.begin();
+
+    while (curr != hits.end()) {
+	const test_hit &curr_hit = *curr;
+	if (curr_hit.hit == test_hit::NEAR_MISS) {
+	    if (curr != hits.begin()) {
+		prev = curr;
+		prev--;
+		const test_hit &prev_hit = (*prev);
+		if ((prev_hit.hit != test_hit::NEAR_MISS) && (prev_hit.direction == curr_hit.direction)) {
+		    curr = hits.erase(curr);
+		    curr = hits.begin();
+		    continue;
+		}
+	    }
+	    next = curr;
+	    next++;
+	    if (next != hits.end()) {
+		const test_hit &next_hit = (*next);
+		if ((next_hit.hit != test_hit::NEAR_MISS) && (next_hit.direction == curr_hit.direction)) {
+		    curr = hits.erase(curr);
+		    curr = hits.begin();
+		    continue;
+		}
+	    }
+	}
+	curr++;
+    }
+}
+
+
+static int
+test_prune(void)
+{
+    unsigned int seed = 12345;
+    int bad = 0;
+
+    for (int l = 0; l < BREP_HITS_LISTS; l++) {
+	std::list<test_hit> ref;
+	std::vector<test_hit> hits;
+
+	/* short lists, mostly near misses, so long runs of them turn
+	 * up often */
+	seed = seed * 1103515245 + 12345;
+	int n = 2 + (int)((seed >> 16) % 14);
+	for (int i = 0; i < n; i++) {
+	    test_hit h;
+	    seed = seed * 1103515245 + 12345;
+	    unsigned int r = seed >> 16;
+	    h.hit = (r % 3) ? test_hit::NEAR_MISS : ((r / 3) % 2 ? test_hit::CLEAN_HIT : test_hit::NEAR_HIT);
+	    h.direction = ((r / 6) % 2) ? test_hit::ENTERING : test_hit::LEAVING;
+	    h.id = i;
+	    ref.push_back(h);
+	    hits.push_back(h);
+	}
+
+	prune_reference(ref);
+	brep_prune_near_misses(hits);
+
+	bool same = (ref.size() == hits.size());
+	size_t i = 0;
+	for (std::list<test_hit>::const_iterator it = ref.begin(); same && it != ref.end(); it++, i++)
+	    same = (it->id == hits[i].id);
+	if (!same) {
+	    if (!bad)
+		bu_log("near-miss pruning: list %d kept %zu hits, expected %zu\n", l, hits.size(), ref.size());
+	    bad++;
+	}
+    }
+
+    return bad;
+}
+
+
+static void
+mk_model(struct rt_wdb *wdbp)
+{
+    struct wmember reg;
+
+    /* sphere */
+    {
+	point_t c = {10.0, -5.0, 3.0};
+	ON_Sphere sph(ON_3dPoint(c), 12.0);
+	ON_Brep *b = ON_BrepSphere(sph);
+	mk_brep(wdbp, "sph.brep", (void *)b);
+	delete b;
+	mk_sph(wdbp, "sph.csg", c, 12.0);
+    }
+
+    /* box */
+    {
+	point_t min = {-20.0, -8.0, -15.0};
+	point_t max = {4.0, 11.0, 6.0};
+	ON_3dPoint corners[8] = {
+	    ON_3dPoint(min[X], min[Y], min[Z]),
+	    ON_3dPoint(max[X], min[Y], min[Z]),
+	    ON_3dPoint(max[X], max[Y], min[Z]),
+	    ON_3dPoint(min[X], max[Y], min[Z]),
+	    ON_3dPoint(min[X], min[Y], max[Z]),
+	    ON_3dPoint(max[X], min[Y], max[Z]),
+	    ON_3dPoint(max[X], max[Y], max[Z]),
+	    ON_3dPoint(min[X], max[Y], max[Z])
+	};
+	ON_Brep *b = ON_BrepBox(corners);
+	mk_brep(wdbp, "box.brep", (void *)b);
+	delete b;
+	mk_rpp(wdbp, "box.csg", min, max);
+    }
+
+    /* capped cylinder, whose caps are trimmed planes */
+    {
+	point_t base = {-3.0, 4.0, -10.0};
+	vect_t height = {0.0, 0.0, 25.0};
+	ON_Plane plane(ON_3dPoint(base), ON_3dVector(0.0, 0.0, 1.0));
+	ON_Cylinder cyl(ON_Circle(plane, 7.0), 25.0);
+	ON_Brep *b = ON_BrepCylinder(cyl, true, true);
+	mk_brep(wdbp, "cyl.brep", (void *)b);
+	delete b;
+	mk_rcc(wdbp, "cyl.csg", base, height, 7.0);
+    }
+
+    const char *names[] = {"sph", "box", "cyl", NULL};
+    for (int i = 0; names[i]; i++) {
+	struct bu_vls sname = BU_VLS_INIT_ZERO;
+	struct bu_vls rname = BU_VLS_INIT_ZERO;
+	const char *kind[] = {"brep", "csg"};
+	for (int k = 0; k < 2; k++) {
+	    bu_vls_sprintf(&sname, "%s.%s", names[i], kind[k]);
+	    bu_vls_sprintf(&rname, "%s.%s.r", names[i], kind[k]);
+	    BU_LIST_INIT(&reg.l);
+	    (void)mk_addmember(bu_vls_cstr(&sname), &reg.l, NULL, WMOP_UNION);
+	    mk_lcomb(wdbp, bu_vls_cstr(&rname), &reg, 1, NULL, NULL, NULL, 0);
+	}
+	bu_vls_free(&sname);
+	bu_vls_free(&rname);
+    }
+}
+
+
+static struct rt_i *
+load(struct db_i *dbip, const char *obj)
+{
+    struct rt_i *rtip = rt_new_rti(dbip);
+    if (rt_gettree(rtip, obj) < 0)
+	bu_exit(1, "rt_gettree(%s) failed\n", obj);
+    rt_prep(rtip);
+    return rtip;
+}
+
+
+/* Compare the flattened hierarchy walk with the recursive one over a
+ * grid of rays through the brep solid prepped in rtip.
+ */
+static int
+test_leaves(const char *name, struct rt_i *rtip, const vect_t dir, int *nleaves)
+{
+    struct soltab *s;
+    struct soltab *stp = NULL;
+    vect_t u, v;
+    point_t center, base;
+    fastf_t radius;
+    int bad = 0;
+
+    RT_VISIT_ALL_SOLTABS_START(s, rtip) {
+	if (s->st_id == ID_BREP)
+	    stp = s;
+    } RT_VISIT_ALL_SOLTABS_END;
+    if (!stp || !stp->st_specific) {
+	bu_log("%s: no brep solid was prepped\n", name);
+	return 1;
+    }
+    const struct brep_specific *bs = (const struct brep_specific *)stp->st_specific;
+
+    VADD2SCALE(center, rtip->mdl_min, rtip->mdl_max, 0.5);
+    radius = 0.5 * DIST_PNT_PNT(rtip->mdl_min, rtip->mdl_max);
+    bn_vec_ortho(u, dir);
+    VCROSS(v, dir, u);
+    VJOIN1(base, center, -2.0 * radius, dir);
+
+    for (int i = 0; i < BREP_HITS_GRID; i++) {
+	for (int j = 0; j < BREP_HITS_GRID; j++) {
+	    point_t pt;
+	    fastf_t s = ((i + 0.37) / BREP_HITS_GRID * 2.0 - 1.0) * radius;
+	    fastf_t t = ((j + 0.61) / BREP_HITS_GRID * 2.0 - 1.0) * radius;
+	    VJOIN2(pt, base, s, u, t, v);
+	    ON_Ray ray(ON_3dPoint(pt), ON_3dVector(dir));
+
+	    std::list<const BrepBoundingVolume *> ref;
+	    bs->bvh->intersectsHierarchy(ray, ref);
+	    std::vector<const BrepBoundingVolume *> leaves;
+	    brep_flat_leaves(bs, ray, leaves);
+
+	    /* trimmed away leaves are left out of the flattened
+	     * hierarchy on purpose */
+	    size_t k = 0;
+	    bool same = true;
+	    for (std::list<const BrepBoundingVolume *>::const_iterator it = ref.begin(); same && it != ref.end(); it++) {
+		if ((*it)->m_trimmed)
+		    continue;
+		same = (k < leaves.size() && leaves[k] == *it);
+		k++;
+	    }
+	    if (!same || k != leaves.size()) {
+		bu_log("%s: ray from (%g %g %g) along (%g %g %g): flattened walk found %zu leaves, expected %zu\n",
+		       name, V3ARGS(pt), V3ARGS(dir), leaves.size(), k);
+		bad++;
+	    }
+	    *nleaves += (int)leaves.size();
+	}
+    }
+
+    return bad;
+}
+
+
+/* Shoot the brep and CSG versions of a solid, which have to find the
+ * same number of partitions with the same in and out distances.
+ */
+static int
+test_shot(const char *name, struct rt_i *brep, struct rt_i *csg, const vect_t dir, int *nparts)
+{
+    vect_t u, v;
+    point_t center, base;
+    fastf_t radius;
+    fastf_t tol = csg->rti_tol.dist;
+    int bad = 0;
+
+    VADD2SCALE(center, csg->mdl_min, csg->mdl_max, 0.5);
+    radius = 0.5 * DIST_PNT_PNT(csg->mdl_min, csg->mdl_max);
+    bn_vec_ortho(u, dir);
+    VCROSS(v, dir, u);
+    VJOIN1(base, center, -2.0 * radius, dir);
+
+    for (int i = 0; i < BREP_HITS_GRID; i++) {
+	for (int j = 0; j < BREP_HITS_GRID; j++) {
+	    struct partcmp_ray a, b;
+	    point_t pt;
+	    fastf_t s = ((i + 0.37) / BREP_HITS_GRID * 2.0 - 1.0) * radius;
+	    fastf_t t = ((j + 0.61) / BREP_HITS_GRID * 2.0 - 1.0) * radius;
+	    VJOIN2(pt, base, s, u, t, v);
+
+	    partcmp_shoot(brep, pt, dir, &a);
+	    partcmp_shoot(csg, pt, dir, &b);
+	    bool same = (a.cnt == b.cnt);
+	    for (int k = 0; same && k < a.cnt; k++)
+		same = NEAR_EQUAL(a.in[k], b.in[k], tol) && NEAR_EQUAL(a.out[k], b.out[k], tol);
+	    if (!same) {
+		bu_log("%s: ray from (%g %g %g) along (%g %g %g): %d partitions starting at %g, expected %d starting at %g\n",
+		       name, V3ARGS(pt), V3ARGS(dir), a.cnt, a.cnt ? a.in[0] : 0.0, b.cnt, b.cnt ? b.in[0] : 0.0);
+		bad++;
+	    }
+	    *nparts += a.cnt;
+	}
+    }
+
+    return bad;
+}
+
+
+int
+main(int UNUSED(argc), char *argv[])
+{
+    struct rt_wdb *wdbp;
+    vect_t dirs[3];
+    int nleaves = 0;
+    int nparts = 0;
+    int bad = 0;
+
+    bu_setprogname(argv[0]);
+
+    /* The hierarchies have to be built here, not read back from a cache */
+    bu_setenv("LIBRT_CACHE", "0", 1);
+
+    bad += test_prune();
+
+    bu_file_delete(BREP_HITS_DB);
+    wdbp = wdb_fopen(BREP_HITS_DB);
+    if (!wdbp)
+	bu_exit(1, "unable to create %s\n", BREP_HITS_DB);
+    mk_model(wdbp);
+
+    VSET(dirs[0], 1.0, 0.0, 0.0);
+    VSET(dirs[1], 0.0, 0.0, -1.0);
+    VSET(dirs[2], 0.3, -0.5, 0.8);
+    VUNITIZE(dirs[2]);
+
+    const char *names[] = {"sph", "box", "cyl", NULL};
+    for (int i = 0; names[i]; i++) {
+	struct bu_vls rname = BU_VLS_INIT_ZERO;
+	bu_vls_sprintf(&rname, "%s.brep.r", names[i]);
+	struct rt_i *brep = load(wdbp->dbip, bu_vls_cstr(&rname));
+	bu_vls_sprintf(&rname, "%s.csg.r", names[i]);
+	struct rt_i *csg = load(wdbp->dbip, bu_vls_cstr(&rname));
+
+	for (int d = 0; d < 3; d++) {
+	    bad += test_leaves(names[i], brep, dirs[d], &nleaves);
+	    bad += test_shot(names[i], brep, csg, dirs[d], &nparts);
+	}
+
+	rt_free_rti(brep);
+	rt_free_rti(csg);
+	bu_vls_free(&rname);
+    }
+
+    wdb_close(wdbp);
+    bu_file_delete(BREP_HITS_DB);
+
+    if (!nleaves || !nparts) {
+	bu_log("no leaves or partitions found (%d leaves, %d partitions)\n", nleaves, nparts);
+	bad++;
+    }
+
+    if (bad) {
+	bu_log("brep hit gathering: %d mismatches [FAIL]\n", bad);
+	return 1;
+    }
+
+    bu_log("brep hit gathering: %d leaves, %d partitions match [PASS]\n", nleaves, nparts);
+    return 0;
+}
+
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -30,6 +30,9 @@
 #include "bu/process.h"
 #include "bu/str.h"
 #include "raytrace.h"
+#include "wdb.h"
+
+#include "./partcmp.h"
 
 const char *RTC_PREFIX = "rt_cache_test";
 
@@ -525,6 +528,136 @@ test_cache(char *rp, long int test_num, long int obj_cnt, int do_parallel, int d
 }
 
 
+/* A tessellated sphere BoT, big enough to get a real BVH */
+static void
+add_bot_sph(struct rt_wdb *wdbp, const char *name, double r)
+{
+    const int nlat = 32;
+    const int nlon = 64;
+    int nverts = 2 + (nlat - 1) * nlon;
+    int nfaces = 2 * nlon * (nlat - 1);
+    fastf_t *verts = (fastf_t *)bu_calloc(nverts * 3, sizeof(fastf_t), "verts");
+    int *faces = (int *)bu_calloc(nfaces * 3, sizeof(int), "faces");
+    int nf = 0;
+
+    VSET(&verts[0], 0.0, 0.0, r);
+    for (int i = 1; i < nlat; i++) {
+	fastf_t phi = M_PI * i / nlat;
+	for (int j = 0; j < nlon; j++) {
+	    fastf_t theta = M_2PI * j / nlon;
+	    VSET(&verts[3 * (1 + (i - 1) * nlon + j)], r * sin(phi) * cos(theta), r * sin(phi) * sin(theta), r * cos(phi));
+	}
+    }
+    VSET(&verts[3 * (nverts - 1)], 0.0, 0.0, -r);
+
+#define RING(_i, _j) (1 + ((_i) - 1) * nlon + ((_j) % nlon))
+    for (int j = 0; j < nlon; j++) {
+	VSET(&faces[3 * nf], 0, RING(1, j + 1), RING(1, j));
+	nf++;
+	VSET(&faces[3 * nf], nverts - 1, RING(nlat - 1, j), RING(nlat - 1, j + 1));
+	nf++;
+    }
+    for (int i = 1; i < nlat - 1; i++) {
+	for (int j = 0; j < nlon; j++) {
+	    VSET(&faces[3 * nf], RING(i, j), RING(i + 1, j + 1), RING(i + 1, j));
+	    nf++;
+	    VSET(&faces[3 * nf], RING(i, j), RING(i, j + 1), RING(i + 1, j + 1));
+	    nf++;
+	}
+    }
+#undef RING
+
+    /* make sure every face points away from the center */
+    for (int k = 0; k < nf; k++) {
+	vect_t a, b, n;
+	point_t c;
+	VSUB2(a, &verts[3 * faces[3 * k + 1]], &verts[3 * faces[3 * k]]);
+	VSUB2(b, &verts[3 * faces[3 * k + 2]], &verts[3 * faces[3 * k]]);
+	VCROSS(n, a, b);
+	VADD3(c, &verts[3 * faces[3 * k]], &verts[3 * faces[3 * k + 1]], &verts[3 * faces[3 * k + 2]]);
+	if (VDOT(n, c) < 0.0) {
+	    int tmp = faces[3 * k + 1];
+	    faces[3 * k + 1] = faces[3 * k + 2];
+	    faces[3 * k + 2] = tmp;
+	}
+    }
+
+    mk_bot(wdbp, name, RT_BOT_SOLID, RT_BOT_CCW, 0, nverts, nfaces, verts, faces, NULL, NULL);
+
+    bu_free(verts, "verts");
+    bu_free(faces, "faces");
+}
+
+/* Round trip a BoT through the cache: the first prep stores its BVH, the
+ * second loads it, and both must hit the same triangles at the same
+ * distances. */
+static int
+test_bot_cache(long int test_num)
+{
+    struct bu_vls cache_dir = BU_VLS_INIT_ZERO;
+    struct bu_vls gfile = BU_VLS_INIT_ZERO;
+    struct resource res;
+    struct rt_i *rtip_stage_1, *rtip_stage_2;
+    struct db_i *dbip;
+    struct rt_wdb *wdbp;
+    const char *bname = "bot_sph.s";
+    vect_t dirs[3];
+    int nparts = 0;
+    int bad = 0;
+
+    bu_vls_sprintf(&cache_dir, "%s_dir_%ld_bot", RTC_PREFIX, test_num);
+    bu_vls_sprintf(&gfile, "%s_%ld_bot.g", RTC_PREFIX, test_num);
+
+    bu_setenv("LIBRT_CACHE", bu_dir(NULL, 0, BU_DIR_CURR, bu_vls_cstr(&cache_dir), NULL), 1);
+
+    if (bu_file_exists(getenv("LIBRT_CACHE"), NULL)) {
+	bu_exit(1, "Test %ld: stale test cache directory %s exists\n", test_num, getenv("LIBRT_CACHE"));
+    }
+
+    dbip = create_test_g_file(test_num, bu_vls_cstr(&gfile));
+    wdbp = wdb_dbopen(dbip, RT_WDB_TYPE_DB_DISK);
+    add_bot_sph(wdbp, bname, 10.0);
+    wdb_close(wdbp);
+
+    rtip_stage_1 = build_rtip(test_num, bu_vls_cstr(&gfile), bname, 1, 0, 1, &res);
+    size_t cc = cache_count(bu_vls_cstr(&cache_dir), 0);
+    if (cc != 1) {
+	bu_exit(1, "Test %ld: expected 1 cache object, found %zu\n", test_num, cc);
+    }
+
+    rtip_stage_2 = build_rtip(test_num, bu_vls_cstr(&gfile), bname, 2, 0, 1, &res);
+
+    VSET(dirs[0], 1.0, 0.0, 0.0);
+    VSET(dirs[1], 0.0, 0.0, -1.0);
+    VSET(dirs[2], -0.3, 0.5, 0.8);
+    VUNITIZE(dirs[2]);
+    for (int i = 0; i < 3; i++)
+	bad += partcmp_grid("cached BoT", rtip_stage_2, rtip_stage_1, dirs[i], 32, &nparts);
+    if (!nparts) {
+	bu_log("Test %ld: no partitions found\n", test_num);
+	bad++;
+    }
+
+    rt_clean(rtip_stage_1);
+    rt_free_rti(rtip_stage_1);
+    rt_clean(rtip_stage_2);
+    rt_free_rti(rtip_stage_2);
+
+    cache_cleanup(&cache_dir);
+    bu_file_delete(bu_vls_cstr(&gfile));
+    bu_vls_free(&cache_dir);
+    bu_vls_free(&gfile);
+
+    if (bad) {
+	bu_log("Test %ld: %d rays differ between the cached and computed BoT prep\n", test_num, bad);
+	return 1;
+    }
+
+    bu_log("Test %ld: %d partitions match between the cached and computed BoT prep\n", test_num, nparts);
+    return 0;
+}
+
+
 const char *rt_cache_test_usage =
 "Usage: rt_cache 1             (Single object serial test)\n"
 "       rt_cache 2             (Single object parallel test)\n"
@@ -533,6 +666,7 @@ const char *rt_cache_test_usage =
 "       rt_cache 5 [obj_count] (Multiple distinct object serial test)\n"
 "       rt_cache 6 [obj_count] (Multiple distinct object parallel test)\n"
 "       rt_cache 7 [obj_count] (Multiple distinct objects, multiple instances in tree parallel test)\n"
+"       rt_cache 8             (BoT prep data round trip test)\n"
 "       rt_cache 20 [obj_count] [subprocess_count] (Multiple process identical objects test)\n"
 "       rt_cache 21 [obj_count] [subprocess_count] (Multiple process distinct objects test)\n";
 
@@ -612,6 +746,9 @@ main(int ac, char *av[])
 	case 7:
 	    /* Parallel prep API, multiple objects, non-unique content, multiple instances in tree */
 	    return test_cache(rp, test_num, obj_cnt, 1, 1, 0, 5);
+	case 8:
+	    /* Serial prep API, BoT loaded back from the cache */
+	    return test_bot_cache(test_num);
 	case 20:
 	    /* Multiple objects, same content, multi-process */
 	    return test_cache(rp, test_num, obj_cnt, 1, 0, subprocess_cnt, 0);
@@ -0,0 +1,234 @@
+/*                         H L B V H . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file hlbvh.c
+ *
+ * Shoot a model partitioned with RT_PART_HLBVH and with the default
+ * NUBSP tree and check they find the same partitions, before and after
+ * primitives are moved and incrementally re-prepped.
+ *
+ */
+
+#include "common.h"
+
+#include <stdio.h>
+
+#include "bu/app.h"
+#include "bu/file.h"
+#include "bu/log.h"
+#include "vmath.h"
+#include "wdb.h"
+#include "raytrace.h"
+
+#include "./partcmp.h"
+
+
+#define HLBVH_DB "hlbvh.g"
+
+/* rays per side of each grid */
+#define HLBVH_GRID 48
+
+/* solids per side of the model */
+#define HLBVH_SIDE 5
+
+
+/* A HLBVH_SIDE x HLBVH_SIDE x 2 block of alternating spheres and
+ * boxes, one sphere cut by a halfspace so there is an infinite solid
+ * too, all under top.
+ */
+static void
+mk_model(struct rt_wdb *wdbp)
+{
+    struct wmember all, wm;
+    int i, j, k;
+
+    BU_LIST_INIT(&all.l);
+    for (i = 0; i < HLBVH_SIDE; i++) {
+	for (j = 0; j < HLBVH_SIDE; j++) {
+	    for (k = 0; k < 2; k++) {
+		char sname[32], rname[32];
+		point_t c;
+		VSET(c, 30.0 * i, 30.0 * j, 30.0 * k);
+		snprintf(sname, sizeof(sname), "s%d_%d_%d", i, j, k);
+		if ((i + j + k) % 2) {
+		    point_t min, max;
+		    VSET(min, c[X] - 8.0, c[Y] - 5.0, c[Z] - 11.0);
+		    VSET(max, c[X] + 8.0, c[Y] + 5.0, c[Z] + 11.0);
+		    mk_rpp(wdbp, sname, min, max);
+		} else {
+		    mk_sph(wdbp, sname, c, 6.0 + i + k);
+		}
+		snprintf(rname, sizeof(rname), "%s.r", sname);
+		mk_comb1(wdbp, rname, sname, 1);
+		(void)mk_addmember(rname, &all.l, NULL, WMOP_UNION);
+	    }
+	}
+    }
+
+    {
+	vect_t n;
+	point_t c;
+	VSET(n, 0.3, 0.4, 1.0);
+	VUNITIZE(n);
+	mk_half(wdbp, "cut.half", n, 50.0);
+	VSET(c, 60.0, 60.0, 60.0);
+	mk_sph(wdbp, "cut.sph", c, 20.0);
+	BU_LIST_INIT(&wm.l);
+	(void)mk_addmember("cut.sph", &wm.l, NULL, WMOP_UNION);
+	(void)mk_addmember("cut.half", &wm.l, NULL, WMOP_INTERSECT);
+	mk_lfcomb(wdbp, "cut.r", &wm, 1);
+	(void)mk_addmember("cut.r", &all.l, NULL, WMOP_UNION);
+    }
+
+    mk_lfcomb(wdbp, "top", &all, 0);
+}
+
+
+static struct rt_i *
+load(struct db_i *dbip, int space_partition)
+{
+    struct rt_i *rtip = rt_new_rti(dbip);
+    rtip->rti_space_partition = space_partition;
+    if (rt_gettree(rtip, "top") < 0)
+	bu_exit(1, "rt_gettree() failed\n");
+    rt_prep(rtip);
+    return rtip;
+}
+
+
+static void
+move_sph(struct db_i *dbip, const char *name, const point_t c)
+{
+    struct rt_db_internal intern;
+    struct rt_ell_internal *ell;
+    struct directory *dp;
+
+    dp = db_lookup(dbip, name, LOOKUP_QUIET);
+    if (dp == RT_DIR_NULL || rt_db_get_internal(&intern, dp, dbip, NULL, &rt_uniresource) < 0)
+	bu_exit(1, "unable to read %s\n", name);
+    ell = (struct rt_ell_internal *)intern.idb_ptr;
+    RT_ELL_CK_MAGIC(ell);
+    VMOVE(ell->v, c);
+    if (rt_db_put_internal(dp, dbip, &intern, &rt_uniresource) < 0)
+	bu_exit(1, "unable to write %s\n", name);
+}
+
+
+static int
+compare(const char *label, struct rt_i *bvh, struct rt_i *bsp, int *nparts)
+{
+    vect_t dirs[4];
+    int bad = 0;
+    int i;
+
+    VSET(dirs[0], 1.0, 0.0, 0.0);
+    VSET(dirs[1], 0.0, -1.0, 0.0);
+    VSET(dirs[2], 0.0, 0.0, 1.0);
+    VSET(dirs[3], -0.3, 0.5, 0.8);
+    VUNITIZE(dirs[3]);
+
+    for (i = 0; i < 4; i++)
+	bad += partcmp_grid(label, bvh, bsp, dirs[i], HLBVH_GRID, nparts);
+
+    return bad;
+}
+
+
+int
+main(int UNUSED(argc), char *argv[])
+{
+    const char *top = "top";
+    struct rt_wdb *wdbp;
+    struct rt_i *bvh, *bsp;
+    struct rt_reprep_tracker *trk;
+    point_t c;
+    int nparts = 0;
+    int bad = 0;
+
+    bu_setprogname(argv[0]);
+
+    bu_file_delete(HLBVH_DB);
+    wdbp = wdb_fopen(HLBVH_DB);
+    if (!wdbp)
+	bu_exit(1, "unable to create %s\n", HLBVH_DB);
+    mk_model(wdbp);
+
+    bvh = load(wdbp->dbip, RT_PART_HLBVH);
+    bsp = load(wdbp->dbip, RT_PART_NUBSPT);
+    if (!bvh->rti_bvh_nodes) {
+	bu_log("no scene HLBVH was built\n");
+	bad++;
+    }
+
+    bad += compare("HLBVH", bvh, bsp, &nparts);
+    rt_free_rti(bsp);
+
+    /* Move one sphere inside the model and one well outside of it, and
+     * re-prep only those */
+    trk = rt_reprep_track(bvh, 1, &top);
+    if (!trk)
+	bu_exit(1, "rt_reprep_track() failed\n");
+    VSET(c, 45.0, 15.0, 15.0);
+    move_sph(wdbp->dbip, "s0_0_0", c);
+    VSET(c, 300.0, -40.0, 20.0);
+    move_sph(wdbp->dbip, "s2_2_0", c);
+    if (rt_reprep_changed(trk, &rt_uniresource) != 0) {
+	bu_log("rt_reprep_changed() asked for a full prep\n");
+	bad++;
+    }
+    rt_reprep_untrack(trk);
+
+    /* The hierarchy has to be refit in place, not rebuilt */
+    if (!bvh->rti_bvh_nodes || bvh->rti_bvh_nrefit != 2) {
+	bu_log("re-prep left %zu solids refit into the HLBVH, expected 2\n", bvh->rti_bvh_nrefit);
+	bad++;
+    }
+
+    bsp = load(wdbp->dbip, RT_PART_NUBSPT);
+    bad += compare("HLBVH after re-prep", bvh, bsp, &nparts);
+
+    rt_free_rti(bvh);
+    rt_free_rti(bsp);
+    wdb_close(wdbp);
+    bu_file_delete(HLBVH_DB);
+
+    if (!nparts) {
+	bu_log("no partitions found\n");
+	bad++;
+    }
+
+    if (bad) {
+	bu_log("HLBVH vs. NUBSP partitioning: %d mismatches [FAIL]\n", bad);
+	return 1;
+    }
+
+    bu_log("HLBVH vs. NUBSP partitioning: %d partitions match [PASS]\n", nparts);
+    return 0;
+}
+
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -0,0 +1,205 @@
+/*                      I N S T A N C E . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file instance.c
+ *
+ * Shoot a model with one BoT placed several times under rotated and
+ * translated matrices, once with the placements sharing a single prep
+ * and once with rti_dont_instance set, and check the two give the same
+ * partitions.
+ *
+ */
+
+#include "common.h"
+
+#include <stdio.h>
+
+#include "bu/app.h"
+#include "bu/file.h"
+#include "bu/log.h"
+#include "vmath.h"
+#include "bn.h"
+#include "wdb.h"
+#include "raytrace.h"
+
+#include "./partcmp.h"
+
+
+#define INSTANCE_DB "instance.g"
+
+/* rays per side of each grid */
+#define INSTANCE_GRID 32
+
+#define INSTANCE_CNT 4
+
+
+/* A closed 40x20x10 box, so any rotation of it is visible */
+static void
+mk_box_bot(struct rt_wdb *wdbp, const char *name)
+{
+    fastf_t verts[8*3];
+    int faces[12*3] = {
+	0, 2, 1,  0, 3, 2,	/* bottom */
+	4, 5, 6,  4, 6, 7,	/* top */
+	0, 1, 5,  0, 5, 4,
+	1, 2, 6,  1, 6, 5,
+	2, 3, 7,  2, 7, 6,
+	3, 0, 4,  3, 4, 7
+    };
+    int i;
+
+    for (i = 0; i < 8; i++) {
+	VSET(&verts[3*i],
+	     (i == 1 || i == 2 || i == 5 || i == 6) ? 20.0 : -20.0,
+	     (i == 2 || i == 3 || i == 6 || i == 7) ? 10.0 : -10.0,
+	     (i >= 4) ? 5.0 : -5.0);
+    }
+
+    mk_bot(wdbp, name, RT_BOT_SOLID, RT_BOT_CCW, 0, 8, 12, verts, faces, NULL, NULL);
+}
+
+
+/* Regions inst0.r .. inst3.r, each the box under its own rotation
+ * (none of them the identity, which isn't instanced) and spaced out
+ * along X, all under top */
+static void
+mk_model(struct rt_wdb *wdbp)
+{
+    struct wmember all;
+    int i;
+
+    mk_box_bot(wdbp, "box.bot");
+
+    BU_LIST_INIT(&all.l);
+    for (i = 0; i < INSTANCE_CNT; i++) {
+	struct wmember reg;
+	char rname[32];
+	mat_t mat;
+
+	bn_mat_angles(mat, 17.0 * (i + 1), 31.0 * (i + 1), 45.0 * (i + 1));
+	MAT_DELTAS(mat, 100.0 * i, 0.0, 0.0);
+
+	BU_LIST_INIT(&reg.l);
+	(void)mk_addmember("box.bot", &reg.l, mat, WMOP_UNION);
+	snprintf(rname, sizeof(rname), "inst%d.r", i);
+	mk_lcomb(wdbp, rname, &reg, 1, NULL, NULL, NULL, 0);
+	(void)mk_addmember(rname, &all.l, NULL, WMOP_UNION);
+    }
+    mk_lcomb(wdbp, "top", &all, 0, NULL, NULL, NULL, 0);
+}
+
+
+static struct rt_i *
+load(struct db_i *dbip, int dont_instance)
+{
+    struct rt_i *rtip = rt_new_rti(dbip);
+    rtip->rti_dont_instance = dont_instance;
+    if (rt_gettree(rtip, "top") < 0)
+	bu_exit(1, "rt_gettree() failed\n");
+    rt_prep(rtip);
+    return rtip;
+}
+
+
+/* Number of soltabs going through shared instance methods */
+static int
+instanced_cnt(struct rt_i *rtip)
+{
+    struct soltab *stp;
+    int cnt = 0;
+
+    RT_VISIT_ALL_SOLTABS_START(stp, rtip) {
+	if (stp->st_meth != &OBJ[stp->st_id])
+	    cnt++;
+    } RT_VISIT_ALL_SOLTABS_END
+
+    return cnt;
+}
+
+
+int
+main(int UNUSED(argc), char *argv[])
+{
+    struct rt_wdb *wdbp;
+    struct rt_i *inst, *flat;
+    struct soltab *stp;
+    vect_t dirs[3];
+    int nhits = 0;
+    int bad = 0;
+    int i;
+
+    bu_setprogname(argv[0]);
+
+    bu_file_delete(INSTANCE_DB);
+    wdbp = wdb_fopen(INSTANCE_DB);
+    if (!wdbp)
+	bu_exit(1, "unable to create %s\n", INSTANCE_DB);
+    mk_model(wdbp);
+
+    inst = load(wdbp->dbip, 0);
+    flat = load(wdbp->dbip, 1);
+
+    /* Make sure the two really are prepped differently */
+    if (instanced_cnt(inst) != INSTANCE_CNT || instanced_cnt(flat) != 0) {
+	bu_log("%d instanced soltabs with instancing on, %d with it off\n", instanced_cnt(inst), instanced_cnt(flat));
+	bad++;
+    }
+
+    /* Printing an instance soltab must use the instance methods */
+    RT_VISIT_ALL_SOLTABS_START(stp, inst) {
+	rt_pr_soltab(stp);
+    } RT_VISIT_ALL_SOLTABS_END
+
+    VSET(dirs[0], 1.0, 0.0, 0.0);
+    VSET(dirs[1], 0.0, 0.0, -1.0);
+    VSET(dirs[2], 0.8, -0.3, 0.5);
+    VUNITIZE(dirs[2]);
+
+    for (i = 0; i < 3; i++)
+	bad += partcmp_grid("instanced", inst, flat, dirs[i], INSTANCE_GRID, &nhits);
+
+    if (!nhits) {
+	bu_log("no partitions found\n");
+	bad++;
+    }
+
+    rt_free_rti(inst);
+    rt_free_rti(flat);
+    wdb_close(wdbp);
+    bu_file_delete(INSTANCE_DB);
+
+    if (bad) {
+	bu_log("instanced vs. non-instanced prep: %d mismatches [FAIL]\n", bad);
+	return 1;
+    }
+
+    bu_log("instanced vs. non-instanced prep: %d partitions match [PASS]\n", nhits);
+    return 0;
+}
+
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
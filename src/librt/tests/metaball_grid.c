@@ -0,0 +1,244 @@
+/*                 M E T A B A L L _ G R I D . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file metaball_grid.c
+ *
+ * Shoot blob and isopotential metaballs, some of whose control points
+ * have negative field strengths, once with the blob grid and step
+ * bounds and once with a hasty prep, which marches and sums every
+ * point at every step, and check the two give the same partitions.
+ *
+ */
+
+#include "common.h"
+
+#include <stdio.h>
+
+#include "bu/app.h"
+#include "bu/file.h"
+#include "bu/log.h"
+#include "vmath.h"
+#include "bn.h"
+#include "wdb.h"
+#include "raytrace.h"
+
+#include "./partcmp.h"
+
+
+#define MB_DB "metaball_grid.g"
+
+/* rays per side of each grid */
+#define MB_GRID 32
+
+/* The surfaces are only found to within the march's final step, and
+ * the grid drops points whose contribution is negligible, so hits can
+ * move by a few final steps and normals turn a little */
+#define MB_DIST_TOL 1.0e-3
+#define MB_NORM_TOL 1.0e-3
+
+
+/* X, Y, Z, field strength, "goo" */
+static const fastf_t blob_pts[][5] = {
+    {0.0, 0.0, 0.0, 5.0, 1.0},
+    {6.0, 0.0, 0.0, 4.0, 1.0},
+    {3.0, 4.0, 0.0, -3.0, 1.0},
+    {20.0, 0.0, 2.0, 2.0, 1.5},
+    {40.0, 30.0, 10.0, 3.0, 1.0},
+    {42.0, 31.0, 11.0, -2.5, 2.0}
+};
+
+static const fastf_t iso_pts[][5] = {
+    {0.0, 0.0, 0.0, 5.0, 1.0},
+    {8.0, 0.0, 0.0, 4.0, 1.0},
+    {4.0, 3.0, 0.0, -2.0, 1.0},
+    {25.0, 0.0, 0.0, 3.0, 1.0},
+    {25.0, 0.0, 2.0, -1.0, 1.0}
+};
+
+
+static void
+mk_mb(struct rt_wdb *wdbp, const char *name, int method, const fastf_t pts[][5], size_t npts)
+{
+    const fastf_t *verts[8];
+    char rname[32];
+    size_t i;
+
+    for (i = 0; i < npts; i++)
+	verts[i] = pts[i];
+    if (mk_metaball(wdbp, name, npts, method, 1.0, verts) < 0)
+	bu_exit(1, "unable to write %s\n", name);
+
+    snprintf(rname, sizeof(rname), "%s.r", name);
+    mk_comb1(wdbp, rname, name, 1);
+}
+
+
+static struct rt_i *
+load(struct db_i *dbip, const char *obj, int hasty)
+{
+    struct rt_i *rtip = rt_new_rti(dbip);
+    rtip->rti_hasty_prep = hasty;
+    if (rt_gettree(rtip, obj) < 0)
+	bu_exit(1, "rt_gettree(%s) failed\n", obj);
+    rt_prep(rtip);
+    return rtip;
+}
+
+
+static int
+ray_differ(const char *label, const point_t pt, const vect_t dir, const struct partcmp_ray *a, const struct partcmp_ray *b)
+{
+    int i;
+
+    if (a->cnt != b->cnt) {
+	bu_log("%s: ray from (%g %g %g) along (%g %g %g): %d partitions, expected %d\n",
+	       label, V3ARGS(pt), V3ARGS(dir), a->cnt, b->cnt);
+	return 1;
+    }
+
+    for (i = 0; i < a->cnt; i++) {
+	if (!NEAR_EQUAL(a->in[i], b->in[i], MB_DIST_TOL)
+	    || !NEAR_EQUAL(a->out[i], b->out[i], MB_DIST_TOL)
+	    || !VNEAR_EQUAL(a->in_norm[i], b->in_norm[i], MB_NORM_TOL)
+	    || !VNEAR_EQUAL(a->out_norm[i], b->out_norm[i], MB_NORM_TOL)) {
+	    bu_log("%s: ray from (%g %g %g) along (%g %g %g), partition %d: %g..%g, expected %g..%g\n",
+		   label, V3ARGS(pt), V3ARGS(dir), i, a->in[i], a->out[i], b->in[i], b->out[i]);
+	    return 1;
+	}
+    }
+
+    return 0;
+}
+
+
+/* Shoot an MB_GRID by MB_GRID grid of parallel rays along dir across
+ * the model at both rt_i's.  Returns the number of rays whose
+ * partitions differ. */
+static int
+compare(const char *label, struct rt_i *fast, struct rt_i *march, const vect_t dir, int *nparts)
+{
+    vect_t u, v;
+    point_t center, base;
+    fastf_t radius;
+    int i, j;
+    int bad = 0;
+
+    VADD2SCALE(center, march->mdl_min, march->mdl_max, 0.5);
+    radius = 0.5 * DIST_PNT_PNT(march->mdl_min, march->mdl_max);
+
+    bn_vec_ortho(u, dir);
+    VCROSS(v, dir, u);
+    VJOIN1(base, center, -2.0 * radius, dir);
+
+    for (i = 0; i < MB_GRID; i++) {
+	for (j = 0; j < MB_GRID; j++) {
+	    struct partcmp_ray a, b;
+	    point_t pt;
+	    fastf_t s = ((i + 0.37) / MB_GRID * 2.0 - 1.0) * radius;
+	    fastf_t t = ((j + 0.61) / MB_GRID * 2.0 - 1.0) * radius;
+
+	    VJOIN2(pt, base, s, u, t, v);
+	    partcmp_shoot(fast, pt, dir, &a);
+	    partcmp_shoot(march, pt, dir, &b);
+	    bad += ray_differ(label, pt, dir, &a, &b);
+	    *nparts += b.cnt;
+	}
+    }
+
+    return bad;
+}
+
+
+static int
+compare_all(const char *label, struct rt_i *fast, struct rt_i *march, int *nparts)
+{
+    vect_t dirs[4];
+    int bad = 0;
+    int i;
+
+    VSET(dirs[0], 1.0, 0.0, 0.0);
+    VSET(dirs[1], 0.0, -1.0, 0.0);
+    VSET(dirs[2], 0.0, 0.0, 1.0);
+    VSET(dirs[3], -0.3, 0.5, 0.8);
+    VUNITIZE(dirs[3]);
+
+    for (i = 0; i < 4; i++)
+	bad += compare(label, fast, march, dirs[i], nparts);
+
+    return bad;
+}
+
+
+int
+main(int UNUSED(argc), char *argv[])
+{
+    struct rt_wdb *wdbp;
+    struct rt_i *blob_fast, *blob_march, *iso_fast, *iso_march;
+    int blob_parts = 0;
+    int iso_parts = 0;
+    int bad = 0;
+
+    bu_setprogname(argv[0]);
+
+    bu_file_delete(MB_DB);
+    wdbp = wdb_fopen(MB_DB);
+    if (!wdbp)
+	bu_exit(1, "unable to create %s\n", MB_DB);
+    mk_mb(wdbp, "blob", METABALL_BLOB, blob_pts, sizeof(blob_pts) / sizeof(blob_pts[0]));
+    mk_mb(wdbp, "iso", METABALL_ISOPOTENTIAL, iso_pts, sizeof(iso_pts) / sizeof(iso_pts[0]));
+
+    blob_fast = load(wdbp->dbip, "blob.r", 0);
+    blob_march = load(wdbp->dbip, "blob.r", 1);
+    iso_fast = load(wdbp->dbip, "iso.r", 0);
+    iso_march = load(wdbp->dbip, "iso.r", 1);
+
+    bad += compare_all("blob", blob_fast, blob_march, &blob_parts);
+    bad += compare_all("isopotential", iso_fast, iso_march, &iso_parts);
+
+    if (!blob_parts || !iso_parts) {
+	bu_log("no partitions found (blob %d, isopotential %d)\n", blob_parts, iso_parts);
+	bad++;
+    }
+
+    rt_free_rti(blob_fast);
+    rt_free_rti(blob_march);
+    rt_free_rti(iso_fast);
+    rt_free_rti(iso_march);
+    wdb_close(wdbp);
+    bu_file_delete(MB_DB);
+
+    if (bad) {
+	bu_log("metaball grid and step bounds: %d mismatches [FAIL]\n", bad);
+	return 1;
+    }
+
+    bu_log("metaball grid and step bounds: %d blob, %d isopotential partitions match [PASS]\n", blob_parts, iso_parts);
+    return 0;
+}
+
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -0,0 +1,172 @@
+/*                       P A R T C M P . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file partcmp.c
+ *
+ * Partition recording and comparison shared by the librt tests.
+ *
+ */
+
+#include "common.h"
+
+#include <string.h>
+
+#include "bu/log.h"
+#include "bu/str.h"
+#include "bn.h"
+
+#include "./partcmp.h"
+
+
+/* normals are unit vectors, so this is close to the angle between them */
+#define PARTCMP_NORM_TOL 1.0e-6
+
+
+static int
+partcmp_hit(struct application *ap, struct partition *PartHeadp, struct seg *UNUSED(segs))
+{
+    struct partcmp_ray *rp = (struct partcmp_ray *)ap->a_uptr;
+    struct partition *pp;
+
+    for (pp = PartHeadp->pt_forw; pp != PartHeadp && rp->cnt < PARTCMP_MAX_PARTS; pp = pp->pt_forw) {
+	int i = rp->cnt++;
+	rp->reg[i] = pp->pt_regionp->reg_name;
+	rp->in[i] = pp->pt_inhit->hit_dist;
+	rp->out[i] = pp->pt_outhit->hit_dist;
+	RT_HIT_NORMAL(rp->in_norm[i], pp->pt_inhit, pp->pt_inseg->seg_stp, &ap->a_ray, pp->pt_inflip);
+	RT_HIT_NORMAL(rp->out_norm[i], pp->pt_outhit, pp->pt_outseg->seg_stp, &ap->a_ray, pp->pt_outflip);
+	rp->in_surfno[i] = pp->pt_inhit->hit_surfno;
+	rp->out_surfno[i] = pp->pt_outhit->hit_surfno;
+    }
+    return 1;
+}
+
+
+static int
+partcmp_miss(struct application *UNUSED(ap))
+{
+    return 0;
+}
+
+
+void
+partcmp_app(struct application *ap, struct rt_i *rtip, struct partcmp_ray *rp, const point_t pt, const vect_t dir)
+{
+    memset(rp, 0, sizeof(struct partcmp_ray));
+
+    RT_APPLICATION_INIT(ap);
+    ap->a_rt_i = rtip;
+    ap->a_resource = &rt_uniresource;
+    ap->a_hit = partcmp_hit;
+    ap->a_miss = partcmp_miss;
+    ap->a_onehit = 0;
+    ap->a_uptr = (void *)rp;
+    VMOVE(ap->a_ray.r_pt, pt);
+    VMOVE(ap->a_ray.r_dir, dir);
+}
+
+
+void
+partcmp_shoot(struct rt_i *rtip, const point_t pt, const vect_t dir, struct partcmp_ray *rp)
+{
+    struct application ap;
+
+    partcmp_app(&ap, rtip, rp, pt, dir);
+    (void)rt_shootray(&ap);
+}
+
+
+int
+partcmp_differ(const char *label, const point_t pt, const vect_t dir,
+	       const struct partcmp_ray *a, const struct partcmp_ray *b, fastf_t tol)
+{
+    int i;
+
+    if (a->cnt != b->cnt) {
+	bu_log("%s: ray from (%g %g %g) along (%g %g %g): %d partitions, expected %d\n",
+	       label, V3ARGS(pt), V3ARGS(dir), a->cnt, b->cnt);
+	return 1;
+    }
+
+    for (i = 0; i < a->cnt; i++) {
+	if (!BU_STR_EQUAL(a->reg[i], b->reg[i])
+	    || !NEAR_EQUAL(a->in[i], b->in[i], tol)
+	    || !NEAR_EQUAL(a->out[i], b->out[i], tol)
+	    || a->in_surfno[i] != b->in_surfno[i]
+	    || a->out_surfno[i] != b->out_surfno[i]
+	    || !VNEAR_EQUAL(a->in_norm[i], b->in_norm[i], PARTCMP_NORM_TOL)
+	    || !VNEAR_EQUAL(a->out_norm[i], b->out_norm[i], PARTCMP_NORM_TOL)) {
+	    bu_log("%s: ray from (%g %g %g) along (%g %g %g), partition %d: %s %g(%d)..%g(%d), expected %s %g(%d)..%g(%d)\n",
+		   label, V3ARGS(pt), V3ARGS(dir), i,
+		   a->reg[i], a->in[i], a->in_surfno[i], a->out[i], a->out_surfno[i],
+		   b->reg[i], b->in[i], b->in_surfno[i], b->out[i], b->out_surfno[i]);
+	    return 1;
+	}
+    }
+
+    return 0;
+}
+
+
+int
+partcmp_grid(const char *label, struct rt_i *a, struct rt_i *b, const vect_t dir, int n, int *nparts)
+{
+    vect_t u, v;
+    point_t center, base;
+    fastf_t radius;
+    fastf_t tol = a->rti_tol.dist * 1.0e-3;
+    int i, j;
+    int bad = 0;
+
+    VADD2SCALE(center, a->mdl_min, a->mdl_max, 0.5);
+    radius = 0.5 * DIST_PNT_PNT(a->mdl_min, a->mdl_max);
+
+    bn_vec_ortho(u, dir);
+    VCROSS(v, dir, u);
+    VJOIN1(base, center, -2.0 * radius, dir);
+
+    /* the odd offsets keep rays off exact edges and vertices */
+    for (i = 0; i < n; i++) {
+	for (j = 0; j < n; j++) {
+	    struct partcmp_ray ra, rb;
+	    point_t pt;
+	    fastf_t s = ((i + 0.37) / n * 2.0 - 1.0) * radius;
+	    fastf_t t = ((j + 0.61) / n * 2.0 - 1.0) * radius;
+
+	    VJOIN2(pt, base, s, u, t, v);
+	    partcmp_shoot(a, pt, dir, &ra);
+	    partcmp_shoot(b, pt, dir, &rb);
+	    bad += partcmp_differ(label, pt, dir, &ra, &rb, tol);
+	    *nparts += ra.cnt;
+	}
+    }
+
+    return bad;
+}
+
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -0,0 +1,91 @@
+/*                       P A R T C M P . H
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file partcmp.h
+ *
+ * Helpers for the librt tests that shoot the same rays at two preps of
+ * a model and check that they find the same partitions.
+ *
+ */
+
+#ifndef LIBRT_TESTS_PARTCMP_H
+#define LIBRT_TESTS_PARTCMP_H
+
+#include "common.h"
+
+#include "vmath.h"
+#include "raytrace.h"
+
+__BEGIN_DECLS
+
+/* most partitions recorded along one ray */
+#define PARTCMP_MAX_PARTS 64
+
+struct partcmp_ray {
+    int cnt;
+    const char *reg[PARTCMP_MAX_PARTS];
+    fastf_t in[PARTCMP_MAX_PARTS];
+    fastf_t out[PARTCMP_MAX_PARTS];
+    int in_surfno[PARTCMP_MAX_PARTS];
+    int out_surfno[PARTCMP_MAX_PARTS];
+    vect_t in_norm[PARTCMP_MAX_PARTS];
+    vect_t out_norm[PARTCMP_MAX_PARTS];
+};
+
+
+/**
+ * Set up ap to shoot the ray pt, dir at rtip, recording the
+ * partitions it finds in rp.
+ */
+extern void partcmp_app(struct application *ap, struct rt_i *rtip, struct partcmp_ray *rp, const point_t pt, const vect_t dir);
+
+/**
+ * Shoot the ray pt, dir at rtip and record its partitions in rp.
+ */
+extern void partcmp_shoot(struct rt_i *rtip, const point_t pt, const vect_t dir, struct partcmp_ray *rp);
+
+/**
+ * Returns 1 if a and b differ in their regions, surface numbers or
+ * normals, or in their distances by more than tol, after logging the
+ * first difference under label.
+ */
+extern int partcmp_differ(const char *label, const point_t pt, const vect_t dir,
+			  const struct partcmp_ray *a, const struct partcmp_ray *b, fastf_t tol);
+
+/**
+ * Shoot an n by n grid of parallel rays along dir covering the model
+ * of a at both a and b.  Returns the number of rays whose partitions
+ * differ, and adds the partitions found in a to *nparts.
+ */
+extern int partcmp_grid(const char *label, struct rt_i *a, struct rt_i *b, const vect_t dir, int n, int *nparts);
+
+__END_DECLS
+
+#endif /* LIBRT_TESTS_PARTCMP_H */
+
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
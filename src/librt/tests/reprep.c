@@ -0,0 +1,271 @@
+/*                      R E P R E P . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file reprep.c
+ *
+ * Test incremental re-prep of edited primitives with
+ * rt_reprep_track() and rt_reprep_changed().
+ *
+ */
+
+#include "common.h"
+
+#include <stdio.h>
+
+#include "bu/app.h"
+#include "bu/file.h"
+#include "bu/log.h"
+#include "vmath.h"
+#include "wdb.h"
+#include "raytrace.h"
+
+#include "./partcmp.h"
+
+
+#define REPREP_DB "reprep.g"
+
+
+/* a 20x20 square sketch in the XY plane at z=500 */
+static void
+mk_square_sketch(struct rt_wdb *wdbp, const char *name)
+{
+    struct rt_sketch_internal skt;
+    struct line_seg lsg[4];
+    void *segs[4];
+    int reverse[4] = {0, 0, 0, 0};
+    point2d_t verts[4];
+    int i;
+
+    V2SET(verts[0], -10.0, -10.0);
+    V2SET(verts[1], 10.0, -10.0);
+    V2SET(verts[2], 10.0, 10.0);
+    V2SET(verts[3], -10.0, 10.0);
+    for (i = 0; i < 4; i++) {
+	lsg[i].magic = CURVE_LSEG_MAGIC;
+	lsg[i].start = i;
+	lsg[i].end = (i + 1) % 4;
+	segs[i] = (void *)&lsg[i];
+    }
+
+    skt.magic = RT_SKETCH_INTERNAL_MAGIC;
+    VSET(skt.V, 0.0, 0.0, 500.0);
+    VSET(skt.u_vec, 1.0, 0.0, 0.0);
+    VSET(skt.v_vec, 0.0, 1.0, 0.0);
+    skt.vert_count = 4;
+    skt.verts = verts;
+    skt.curve.count = 4;
+    skt.curve.reverse = reverse;
+    skt.curve.segment = segs;
+
+    mk_sketch(wdbp, name, &skt);
+}
+
+
+/* distance to the first hit from pt along dir, or -1 on a miss */
+static fastf_t
+shoot(struct rt_i *rtip, const point_t pt, const vect_t dir)
+{
+    struct partcmp_ray rp;
+
+    partcmp_shoot(rtip, pt, dir, &rp);
+    return rp.cnt ? rp.in[0] : -1.0;
+}
+
+
+int
+main(int UNUSED(argc), char *argv[])
+{
+    const char *top = "all";
+    struct rt_wdb *wdbp;
+    struct wmember wm;
+    struct rt_i *rtip;
+    struct rt_reprep_tracker *trk;
+    struct rt_db_internal intern;
+    struct rt_ell_internal *ell;
+    struct rt_sketch_internal *skt;
+    const char *ext_top = "ext.r";
+    struct directory *dp;
+    point_t center, pt;
+    vect_t dir, h, u, v;
+    size_t i;
+    fastf_t dist;
+    int ret = 0;
+
+    bu_setprogname(argv[0]);
+
+    bu_file_delete(REPREP_DB);
+    wdbp = wdb_fopen(REPREP_DB);
+    if (!wdbp)
+	bu_exit(1, "unable to create %s\n", REPREP_DB);
+
+    VSETALL(center, 0.0);
+    mk_sph(wdbp, "s1.s", center, 10.0);
+    VSET(center, 100.0, 0.0, 0.0);
+    mk_sph(wdbp, "s2.s", center, 10.0);
+    mk_comb1(wdbp, "r1.r", "s1.s", 1);
+    mk_comb1(wdbp, "r2.r", "s2.s", 1);
+    BU_LIST_INIT(&wm.l);
+    mk_addmember("r1.r", &wm.l, NULL, WMOP_UNION);
+    mk_addmember("r2.r", &wm.l, NULL, WMOP_UNION);
+    mk_lfcomb(wdbp, top, &wm, 0);
+
+    mk_square_sketch(wdbp, "sk.s");
+    VSET(center, 0.0, 0.0, 500.0);
+    VSET(h, 0.0, 0.0, 10.0);
+    VSET(u, 1.0, 0.0, 0.0);
+    VSET(v, 0.0, 1.0, 0.0);
+    mk_extrusion(wdbp, "ext.s", "sk.s", center, h, u, v, 0);
+    mk_comb1(wdbp, ext_top, "ext.s", 1);
+
+    rtip = rt_new_rti(wdbp->dbip);
+    if (rt_gettree(rtip, top) < 0)
+	bu_exit(1, "rt_gettree(%s) failed\n", top);
+    rt_prep(rtip);
+
+    trk = rt_reprep_track(rtip, 1, &top);
+    if (!trk)
+	bu_exit(1, "rt_reprep_track() failed\n");
+
+    /* shoot back along -X from beyond where s2.s will be moved to */
+    VSET(pt, 300.0, 0.0, 0.0);
+    VSET(dir, -1.0, 0.0, 0.0);
+    dist = shoot(rtip, pt, dir);
+    if (!NEAR_EQUAL(dist, 190.0, VUNITIZE_TOL)) {
+	bu_log("initial hit at %g, expected 190 [FAIL]\n", dist);
+	ret = 1;
+    }
+
+    /* nothing changed yet */
+    if (rt_reprep_changed(trk, &rt_uniresource) != 0) {
+	bu_log("rt_reprep_changed() with no changes [FAIL]\n");
+	ret = 1;
+    }
+
+    /* move s2.s */
+    dp = db_lookup(wdbp->dbip, "s2.s", LOOKUP_QUIET);
+    if (dp == RT_DIR_NULL || rt_db_get_internal(&intern, dp, wdbp->dbip, NULL, &rt_uniresource) < 0)
+	bu_exit(1, "unable to read s2.s\n");
+    ell = (struct rt_ell_internal *)intern.idb_ptr;
+    RT_ELL_CK_MAGIC(ell);
+    VSET(ell->v, 200.0, 0.0, 0.0);
+    if (rt_db_put_internal(dp, wdbp->dbip, &intern, &rt_uniresource) < 0)
+	bu_exit(1, "unable to write s2.s\n");
+
+    if (rt_reprep_changed(trk, &rt_uniresource) != 0) {
+	bu_log("rt_reprep_changed() after a primitive edit [FAIL]\n");
+	ret = 1;
+    }
+    dist = shoot(rtip, pt, dir);
+    if (!NEAR_EQUAL(dist, 90.0, VUNITIZE_TOL)) {
+	bu_log("hit after moving s2.s at %g, expected 90 [FAIL]\n", dist);
+	ret = 1;
+    }
+
+    /* the unchanged sphere is still there */
+    VSET(pt, -100.0, 0.0, 0.0);
+    VSET(dir, 1.0, 0.0, 0.0);
+    dist = shoot(rtip, pt, dir);
+    if (!NEAR_EQUAL(dist, 90.0, VUNITIZE_TOL)) {
+	bu_log("hit on s1.s at %g, expected 90 [FAIL]\n", dist);
+	ret = 1;
+    }
+
+    /* a combination edit needs a full prep */
+    dp = db_lookup(wdbp->dbip, "r2.r", LOOKUP_QUIET);
+    if (dp == RT_DIR_NULL || rt_db_get_internal(&intern, dp, wdbp->dbip, NULL, &rt_uniresource) < 0)
+	bu_exit(1, "unable to read r2.r\n");
+    if (rt_db_put_internal(dp, wdbp->dbip, &intern, &rt_uniresource) < 0)
+	bu_exit(1, "unable to write r2.r\n");
+    if (rt_reprep_changed(trk, &rt_uniresource) != 1) {
+	bu_log("rt_reprep_changed() after a combination edit [FAIL]\n");
+	ret = 1;
+    }
+
+    rt_reprep_untrack(trk);
+    rt_free_rti(rtip);
+
+    /* an extrusion refers to its sketch by name, so editing the
+     * sketch has to force a full prep
+     */
+    rtip = rt_new_rti(wdbp->dbip);
+    if (rt_gettree(rtip, ext_top) < 0)
+	bu_exit(1, "rt_gettree(%s) failed\n", ext_top);
+    rt_prep(rtip);
+    trk = rt_reprep_track(rtip, 1, &ext_top);
+    if (!trk)
+	bu_exit(1, "rt_reprep_track() failed\n");
+
+    VSET(pt, 100.0, 0.0, 505.0);
+    VSET(dir, -1.0, 0.0, 0.0);
+    dist = shoot(rtip, pt, dir);
+    if (!NEAR_EQUAL(dist, 90.0, VUNITIZE_TOL)) {
+	bu_log("hit on ext.s at %g, expected 90 [FAIL]\n", dist);
+	ret = 1;
+    }
+
+    /* double the size of the sketch */
+    dp = db_lookup(wdbp->dbip, "sk.s", LOOKUP_QUIET);
+    if (dp == RT_DIR_NULL || rt_db_get_internal(&intern, dp, wdbp->dbip, NULL, &rt_uniresource) < 0)
+	bu_exit(1, "unable to read sk.s\n");
+    skt = (struct rt_sketch_internal *)intern.idb_ptr;
+    RT_SKETCH_CK_MAGIC(skt);
+    for (i = 0; i < skt->vert_count; i++)
+	V2SCALE(skt->verts[i], skt->verts[i], 2.0);
+    if (rt_db_put_internal(dp, wdbp->dbip, &intern, &rt_uniresource) < 0)
+	bu_exit(1, "unable to write sk.s\n");
+
+    if (rt_reprep_changed(trk, &rt_uniresource) != 1) {
+	bu_log("rt_reprep_changed() after a sketch edit [FAIL]\n");
+	ret = 1;
+    } else {
+	rt_reprep_untrack(trk);
+	rt_free_rti(rtip);
+	rtip = rt_new_rti(wdbp->dbip);
+	if (rt_gettree(rtip, ext_top) < 0)
+	    bu_exit(1, "rt_gettree(%s) failed\n", ext_top);
+	rt_prep(rtip);
+	trk = rt_reprep_track(rtip, 1, &ext_top);
+    }
+    dist = shoot(rtip, pt, dir);
+    if (!NEAR_EQUAL(dist, 80.0, VUNITIZE_TOL)) {
+	bu_log("hit after editing sk.s at %g, expected 80 [FAIL]\n", dist);
+	ret = 1;
+    }
+
+    rt_reprep_untrack(trk);
+    rt_free_rti(rtip);
+    wdb_close(wdbp);
+    bu_file_delete(REPREP_DB);
+
+    if (!ret)
+	bu_log("rt_reprep_changed [PASS]\n");
+
+    return ret;
+}
+
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -0,0 +1,260 @@
+/*                    V O X E L _ S K I P . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file voxel_skip.c
+ *
+ * Shoot sparse VOL and EBM solids once with empty bricks and tiles
+ * skipped and once with a hasty prep, which steps through every cell,
+ * and check the two give the same partitions.  Most of the rays run diagonally through cell
+ * corners so exits tie between axes.
+ *
+ */
+
+#include "common.h"
+
+#include <stdio.h>
+
+#include "bu/app.h"
+#include "bu/file.h"
+#include "bu/log.h"
+#include "bu/malloc.h"
+#include "vmath.h"
+#include "bn.h"
+#include "wdb.h"
+#include "raytrace.h"
+
+#include "./partcmp.h"
+
+
+#define SKIP_DB "voxel_skip.g"
+#define SKIP_VOL "voxel_skip.vol"
+#define SKIP_EBM "voxel_skip.ebm"
+
+/* a multiple of both the VOL brick and EBM tile sizes */
+#define SKIP_DIM 48
+
+/* rays in most families */
+#define SKIP_RAYS 200
+
+/* Solid cells only in every third brick or tile, and only some of the
+ * cells in those, so rays cross long runs of empty space */
+static int
+cell_set(int x, int y, int z, int block)
+{
+    if ((x / block + y / block + z / block) % 3)
+	return 0;
+    return (x * 7 + y * 3 + z * 5) % 4 == 0;
+}
+
+
+static void
+write_data(const char *file, int zdim, int block)
+{
+    unsigned char *buf = (unsigned char *)bu_calloc(SKIP_DIM * SKIP_DIM * zdim, 1, "voxel data");
+    FILE *fp;
+    int x, y, z;
+
+    for (z = 0; z < zdim; z++)
+	for (y = 0; y < SKIP_DIM; y++)
+	    for (x = 0; x < SKIP_DIM; x++)
+		buf[(z * SKIP_DIM + y) * SKIP_DIM + x] = cell_set(x, y, z, block) ? 200 : 0;
+
+    fp = fopen(file, "wb");
+    if (!fp || fwrite(buf, 1, SKIP_DIM * SKIP_DIM * zdim, fp) != (size_t)(SKIP_DIM * SKIP_DIM * zdim))
+	bu_exit(1, "unable to write %s\n", file);
+    fclose(fp);
+    bu_free(buf, "voxel data");
+}
+
+
+static void
+mk_model(struct rt_wdb *wdbp)
+{
+    struct wmember reg;
+    vect_t cellsize = {1.0, 1.0, 1.0};
+    mat_t mat;
+
+    MAT_IDN(mat);
+
+    write_data(SKIP_VOL, SKIP_DIM, 8);
+    mk_vol(wdbp, "vol.s", RT_VOL_SRC_FILE, SKIP_VOL, SKIP_DIM, SKIP_DIM, SKIP_DIM, 1, 255, cellsize, mat);
+    BU_LIST_INIT(&reg.l);
+    (void)mk_addmember("vol.s", &reg.l, NULL, WMOP_UNION);
+    mk_lcomb(wdbp, "vol.r", &reg, 1, NULL, NULL, NULL, 0);
+
+    write_data(SKIP_EBM, 1, 16);
+    mk_ebm(wdbp, "ebm.s", SKIP_EBM, SKIP_DIM, SKIP_DIM, 10.0, mat);
+    BU_LIST_INIT(&reg.l);
+    (void)mk_addmember("ebm.s", &reg.l, NULL, WMOP_UNION);
+    mk_lcomb(wdbp, "ebm.r", &reg, 1, NULL, NULL, NULL, 0);
+}
+
+
+static struct rt_i *
+load(struct db_i *dbip, const char *obj, int hasty)
+{
+    struct rt_i *rtip = rt_new_rti(dbip);
+    rtip->rti_hasty_prep = hasty;
+    if (rt_gettree(rtip, obj) < 0)
+	bu_exit(1, "rt_gettree(%s) failed\n", obj);
+    rt_prep(rtip);
+    return rtip;
+}
+
+
+/* Shoot cnt parallel rays along dir, starting at base and moving by
+ * step between rays, at both rt_i's.  Returns the number of rays
+ * whose partitions differ.
+ *
+ * Keeping base and step equal in the tied coordinates makes the cell
+ * plane crossings on those axes come out bit for bit the same, so the
+ * ties are exact and not at the mercy of rounding. */
+static int
+compare(const char *name, struct rt_i *skip, struct rt_i *walk, vect_t dir, const point_t base, const vect_t step, int cnt, int *nhits)
+{
+    fastf_t tol = walk->rti_tol.dist * 1.0e-3;
+    int i;
+    int bad = 0;
+
+    VUNITIZE(dir);
+
+    for (i = 0; i < cnt; i++) {
+	struct partcmp_ray a, b;
+	point_t pt;
+
+	VJOIN1(pt, base, (fastf_t)i, step);
+	partcmp_shoot(skip, pt, dir, &a);
+	partcmp_shoot(walk, pt, dir, &b);
+	bad += partcmp_differ(name, pt, dir, &a, &b, tol);
+	*nhits += a.cnt;
+    }
+
+    return bad;
+}
+
+
+int
+main(int UNUSED(argc), char *argv[])
+{
+    struct rt_wdb *wdbp;
+    struct rt_i *vol_skip, *vol_walk, *ebm_skip, *ebm_walk;
+    vect_t dir, step;
+    point_t base;
+    int vol_hits = 0;
+    int ebm_hits = 0;
+    int bad = 0;
+
+    bu_setprogname(argv[0]);
+
+    bu_file_delete(SKIP_DB);
+    wdbp = wdb_fopen(SKIP_DB);
+    if (!wdbp)
+	bu_exit(1, "unable to create %s\n", SKIP_DB);
+    mk_model(wdbp);
+
+    vol_skip = load(wdbp->dbip, "vol.r", 0);
+    ebm_skip = load(wdbp->dbip, "ebm.r", 0);
+    vol_walk = load(wdbp->dbip, "vol.r", 1);
+    ebm_walk = load(wdbp->dbip, "ebm.r", 1);
+
+    /* X/Y ties, both ways along the diagonal */
+    VSET(dir, 1.0, 1.0, 0.0);
+    VSET(base, -10.0, -10.0, -1.0);
+    VSET(step, 0.0, 0.0, 0.25);
+    bad += compare("vol", vol_skip, vol_walk, dir, base, step, SKIP_RAYS, &vol_hits);
+    VSET(dir, -1.0, -1.0, 0.0);
+    VSET(base, 60.0, 60.0, -1.0);
+    bad += compare("vol", vol_skip, vol_walk, dir, base, step, SKIP_RAYS, &vol_hits);
+
+    /* X/Z and Y/Z ties */
+    VSET(dir, 1.0, 0.0, 1.0);
+    VSET(base, -10.0, -1.0, -10.0);
+    VSET(step, 0.0, 0.25, 0.0);
+    bad += compare("vol", vol_skip, vol_walk, dir, base, step, SKIP_RAYS, &vol_hits);
+    VSET(dir, 0.0, -1.0, -1.0);
+    VSET(base, -1.0, 60.0, 60.0);
+    VSET(step, 0.25, 0.0, 0.0);
+    bad += compare("vol", vol_skip, vol_walk, dir, base, step, SKIP_RAYS, &vol_hits);
+
+    /* three way ties along the one main diagonal, then X/Y ties with Z
+     * off by a little */
+    VSET(dir, 1.0, 1.0, 1.0);
+    VSET(base, -10.0, -10.0, -10.0);
+    VSETALL(step, 0.0);
+    bad += compare("vol", vol_skip, vol_walk, dir, base, step, 1, &vol_hits);
+    VSET(base, -10.0, -10.0, -15.0);
+    VSET(step, 0.0, 0.0, 0.0625);
+    bad += compare("vol", vol_skip, vol_walk, dir, base, step, SKIP_RAYS, &vol_hits);
+
+    /* and a direction with no ties at all */
+    VSET(dir, 0.3, 0.5, 0.8);
+    VSET(base, -20.0, -10.0, -40.0);
+    VSET(step, 0.37, 0.0, 0.0);
+    bad += compare("vol", vol_skip, vol_walk, dir, base, step, SKIP_RAYS, &vol_hits);
+
+    /* The EBM steps in X and Y only */
+    VSET(dir, 1.0, 1.0, 0.0);
+    VSET(base, -10.0, -10.0, -0.5);
+    VSET(step, 0.0, 0.0, 0.0625);
+    bad += compare("ebm", ebm_skip, ebm_walk, dir, base, step, SKIP_RAYS, &ebm_hits);
+    VSET(dir, -1.0, -1.0, 0.0);
+    VSET(base, 60.0, 60.0, -0.5);
+    bad += compare("ebm", ebm_skip, ebm_walk, dir, base, step, SKIP_RAYS, &ebm_hits);
+    VSET(dir, 1.0, 1.0, 0.5);
+    VSET(base, -10.0, -10.0, -20.0);
+    VSET(step, 0.0, 0.0, 0.125);
+    bad += compare("ebm", ebm_skip, ebm_walk, dir, base, step, SKIP_RAYS, &ebm_hits);
+    VSET(dir, 0.6, 0.8, 0.1);
+    VSET(base, -20.0, -20.0, 1.0);
+    VSET(step, 0.37, 0.0, 0.0);
+    bad += compare("ebm", ebm_skip, ebm_walk, dir, base, step, SKIP_RAYS, &ebm_hits);
+
+    if (!vol_hits || !ebm_hits) {
+	bu_log("no partitions found (vol %d, ebm %d)\n", vol_hits, ebm_hits);
+	bad++;
+    }
+
+    rt_free_rti(vol_skip);
+    rt_free_rti(vol_walk);
+    rt_free_rti(ebm_skip);
+    rt_free_rti(ebm_walk);
+    wdb_close(wdbp);
+    bu_file_delete(SKIP_DB);
+    bu_file_delete(SKIP_VOL);
+    bu_file_delete(SKIP_EBM);
+
+    if (bad) {
+	bu_log("VOL/EBM empty space skipping: %d mismatches [FAIL]\n", bad);
+	return 1;
+    }
+
+    bu_log("VOL/EBM empty space skipping: %d vol, %d ebm partitions match [PASS]\n", vol_hits, ebm_hits);
+    return 0;
+}
+
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
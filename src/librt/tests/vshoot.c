@@ -0,0 +1,314 @@
+/*                      V S H O O T . C
+ * BRL-CAD
+ *
+ * Copyright (c) 2025 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file vshoot.c
+ *
+ * Compare the partitions rt_vshootray() finds for batches of rays
+ * with those of rt_shootray() for the same rays, one at a time.
+ *
+ */
+
+#include "common.h"
+
+#include <stdio.h>
+
+#include "bu/app.h"
+#include "bu/file.h"
+#include "bu/log.h"
+#include "bu/malloc.h"
+#include "vmath.h"
+#include "wdb.h"
+#include "raytrace.h"
+
+#include "./partcmp.h"
+
+
+#define VSHOOT_DB "vshoot.g"
+
+/* rays per side of each grid */
+#define VSHOOT_GRID 32
+
+/* Shoot a grid of parallel rays along dir that covers the model with
+ * rt_vshootray() and with rt_shootray(), and compare the partitions.
+ * Returns the number of mismatched rays.
+ */
+static int
+check_grid(struct rt_i *rtip, const vect_t dir)
+{
+    size_t nrays = VSHOOT_GRID * VSHOOT_GRID;
+    struct application *apps;
+    struct partcmp_ray *vres;
+    vect_t u, v, diag;
+    point_t center, base;
+    fastf_t radius;
+    size_t i, j;
+    int nhits = 0;
+    int bad = 0;
+
+    apps = (struct application *)bu_calloc(nrays, sizeof(struct application), "apps");
+    vres = (struct partcmp_ray *)bu_calloc(nrays, sizeof(struct partcmp_ray), "vres");
+
+    VADD2SCALE(center, rtip->mdl_min, rtip->mdl_max, 0.5);
+    VSUB2(diag, rtip->mdl_max, rtip->mdl_min);
+    radius = MAGNITUDE(diag) * 0.5;
+    bn_vec_ortho(u, dir);
+    VCROSS(v, dir, u);
+    VJOIN1(base, center, -2.0 * radius, dir);
+
+    /* the odd offsets keep rays off exact tangencies */
+    for (i = 0; i < VSHOOT_GRID; i++) {
+	for (j = 0; j < VSHOOT_GRID; j++) {
+	    fastf_t s = ((i + 0.37) / VSHOOT_GRID * 2.0 - 1.0) * radius;
+	    fastf_t t = ((j + 0.61) / VSHOOT_GRID * 2.0 - 1.0) * radius;
+	    point_t pt;
+	    VJOIN2(pt, base, s, u, t, v);
+	    partcmp_app(&apps[i * VSHOOT_GRID + j], rtip, &vres[i * VSHOOT_GRID + j], pt, dir);
+	}
+    }
+
+    nhits = rt_vshootray(apps, nrays);
+
+    for (i = 0; i < nrays; i++) {
+	struct partcmp_ray sres;
+	partcmp_shoot(rtip, apps[i].a_ray.r_pt, dir, &sres);
+	bad += partcmp_differ("rt_vshootray", apps[i].a_ray.r_pt, dir, &vres[i], &sres, rtip->rti_tol.dist);
+    }
+
+    if (nhits == 0) {
+	bu_log("no hits along (%g %g %g)\n", V3ARGS(dir));
+	bad++;
+    }
+
+    bu_free(apps, "apps");
+    bu_free(vres, "vres");
+
+    return bad;
+}
+
+
+/* Shoot rays parallel to X that start exactly on the Y and Z faces of
+ * the ARB8's and BoT's bounding boxes, where zero direction components
+ * meet zero distances to the slabs.
+ */
+static int
+check_flat(struct rt_i *rtip)
+{
+    size_t nrays = 0;
+    struct application apps[64];
+    struct partcmp_ray vres[64];
+    vect_t dir;
+    size_t i;
+    int j, k;
+    int bad = 0;
+
+    VSET(dir, 1.0, 0.0, 0.0);
+    for (j = 0; j < 2; j++) {
+	for (k = 0; k <= 8; k++) {
+	    point_t pt;
+	    VSET(pt, -100.0, j ? 10.0 : -10.0, -10.0 + 2.5 * k);
+	    partcmp_app(&apps[nrays], rtip, &vres[nrays], pt, dir);
+	    nrays++;
+	    VSET(pt, -100.0, -10.0 + 2.5 * k, j ? 10.0 : -10.0);
+	    partcmp_app(&apps[nrays], rtip, &vres[nrays], pt, dir);
+	    nrays++;
+	}
+    }
+
+    (void)rt_vshootray(apps, nrays);
+
+    for (i = 0; i < nrays; i++) {
+	struct partcmp_ray sres;
+	partcmp_shoot(rtip, apps[i].a_ray.r_pt, dir, &sres);
+	bad += partcmp_differ("rt_vshootray on RPP faces", apps[i].a_ray.r_pt, dir, &vres[i], &sres, rtip->rti_tol.dist);
+    }
+
+    return bad;
+}
+
+
+/* Shoot a grid along X whose a_ray_length ends between the sphere and
+ * the ARB8.  Everything up to there has to be found, and nothing
+ * past it.
+ */
+static int
+check_length(struct rt_i *rtip)
+{
+    size_t nrays = VSHOOT_GRID * VSHOOT_GRID;
+    struct application *apps;
+    struct partcmp_ray *vres;
+    vect_t dir;
+    fastf_t len;
+    size_t i, j;
+    int nparts = 0;
+    int bad = 0;
+
+    apps = (struct application *)bu_calloc(nrays, sizeof(struct application), "apps");
+    vres = (struct partcmp_ray *)bu_calloc(nrays, sizeof(struct partcmp_ray), "vres");
+
+    /* rays start at X = -100, the sphere ends at 15, the ARB8 starts
+     * at 40 */
+    VSET(dir, 1.0, 0.0, 0.0);
+    len = 125.0;
+    for (i = 0; i < VSHOOT_GRID; i++) {
+	for (j = 0; j < VSHOOT_GRID; j++) {
+	    point_t pt;
+	    VSET(pt, -100.0, ((i + 0.37) / VSHOOT_GRID * 2.0 - 1.0) * 60.0, ((j + 0.61) / VSHOOT_GRID * 2.0 - 1.0) * 20.0);
+	    partcmp_app(&apps[i * VSHOOT_GRID + j], rtip, &vres[i * VSHOOT_GRID + j], pt, dir);
+	    apps[i * VSHOOT_GRID + j].a_ray_length = len;
+	}
+    }
+
+    (void)rt_vshootray(apps, nrays);
+
+    for (i = 0; i < nrays; i++) {
+	struct partcmp_ray sres;
+	int n;
+
+	/* the full ray, cut back to what lies before len */
+	partcmp_shoot(rtip, apps[i].a_ray.r_pt, dir, &sres);
+	for (n = 0; n < sres.cnt && sres.in[n] < len; n++)
+	    ;
+	sres.cnt = n;
+	bad += partcmp_differ("rt_vshootray with a_ray_length", apps[i].a_ray.r_pt, dir, &vres[i], &sres, rtip->rti_tol.dist);
+	nparts += vres[i].cnt;
+    }
+
+    if (nparts == 0) {
+	bu_log("no partitions found with a_ray_length\n");
+	bad++;
+    }
+
+    bu_free(apps, "apps");
+    bu_free(vres, "vres");
+
+    return bad;
+}
+
+
+int
+main(int UNUSED(argc), char *argv[])
+{
+    const char *top = "all";
+    struct rt_wdb *wdbp;
+    struct wmember wm;
+    struct rt_i *rtip;
+    point_t center, min, max;
+    vect_t a, b, c, dir;
+    fastf_t arb[24] = {
+	40, -10, -10,  60, -10, -10,  60, 10, -10,  40, 10, -10,
+	40, -10,  10,  60, -10,  10,  60, 10,  10,  40, 10,  10
+    };
+    fastf_t bot_verts[24] = {
+	-60, -10, -10,  -40, -10, -10,  -40, 10, -10,  -60, 10, -10,
+	-60, -10,  10,  -40, -10,  10,  -40, 10,  10,  -60, 10,  10
+    };
+    int bot_faces[36] = {
+	0, 2, 1,  0, 3, 2,  4, 5, 6,  4, 6, 7,  0, 1, 5,  0, 5, 4,
+	3, 7, 6,  3, 6, 2,  0, 4, 7,  0, 7, 3,  1, 2, 6,  1, 6, 5
+    };
+    int bad = 0;
+
+    bu_setprogname(argv[0]);
+
+    bu_file_delete(VSHOOT_DB);
+    wdbp = wdb_fopen(VSHOOT_DB);
+    if (!wdbp)
+	bu_exit(1, "unable to create %s\n", VSHOOT_DB);
+
+    /* vectorized types */
+    VSET(center, 0.0, 0.0, 0.0);
+    mk_sph(wdbp, "sph.s", center, 15.0);
+    VSET(center, 0.0, 40.0, 0.0);
+    VSET(a, 20.0, 0.0, 0.0);
+    VSET(b, 0.0, 8.0, 0.0);
+    VSET(c, 0.0, 3.0, 6.0);
+    mk_ell(wdbp, "ell.s", center, a, b, c);
+    mk_arb8(wdbp, "arb.s", arb);
+
+    /* BoTs are packet shot */
+    mk_bot(wdbp, "bot.s", RT_BOT_SOLID, RT_BOT_CCW, 0, 8, 12, bot_verts, bot_faces, NULL, NULL);
+
+    /* a type without a vectorized shot */
+    VSET(center, 0.0, -40.0, 0.0);
+    VSET(a, 0.3, 0.2, 1.0);
+    VUNITIZE(a);
+    mk_tor(wdbp, "tor.s", center, a, 15.0, 4.0);
+
+    /* a subtraction through the sphere */
+    VSET(min, -5.0, -5.0, -30.0);
+    VSET(max, 5.0, 5.0, 30.0);
+    mk_rpp(wdbp, "hole.s", min, max);
+
+    BU_LIST_INIT(&wm.l);
+    mk_addmember("sph.s", &wm.l, NULL, WMOP_UNION);
+    mk_addmember("hole.s", &wm.l, NULL, WMOP_SUBTRACT);
+    mk_lfcomb(wdbp, "sph.r", &wm, 1);
+    mk_comb1(wdbp, "ell.r", "ell.s", 1);
+    mk_comb1(wdbp, "arb.r", "arb.s", 1);
+    mk_comb1(wdbp, "tor.r", "tor.s", 1);
+    mk_comb1(wdbp, "bot.r", "bot.s", 1);
+
+    BU_LIST_INIT(&wm.l);
+    mk_addmember("sph.r", &wm.l, NULL, WMOP_UNION);
+    mk_addmember("ell.r", &wm.l, NULL, WMOP_UNION);
+    mk_addmember("arb.r", &wm.l, NULL, WMOP_UNION);
+    mk_addmember("tor.r", &wm.l, NULL, WMOP_UNION);
+    mk_addmember("bot.r", &wm.l, NULL, WMOP_UNION);
+    mk_lfcomb(wdbp, top, &wm, 0);
+
+    rtip = rt_new_rti(wdbp->dbip);
+    if (rt_gettree(rtip, top) < 0)
+	bu_exit(1, "rt_gettree(%s) failed\n", top);
+    rt_prep(rtip);
+
+    VSET(dir, 1.0, 0.0, 0.0);
+    bad += check_grid(rtip, dir);
+    VSET(dir, 0.0, -1.0, 0.0);
+    bad += check_grid(rtip, dir);
+    VSET(dir, 0.0, 0.0, 1.0);
+    bad += check_grid(rtip, dir);
+    VSET(dir, -0.3, 0.5, 0.8);
+    VUNITIZE(dir);
+    bad += check_grid(rtip, dir);
+    bad += check_flat(rtip);
+    bad += check_length(rtip);
+
+    rt_free_rti(rtip);
+    wdb_close(wdbp);
+    bu_file_delete(VSHOOT_DB);
+
+    if (bad) {
+	bu_log("rt_vshootray: %d mismatched rays [FAIL]\n", bad);
+	return 1;
+    }
+
+    bu_log("rt_vshootray [PASS]\n");
+    return 0;
+}
+
+
+/*
+ * Local Variables:
+ * tab-width: 8
+ * mode: C
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -32,6 +32,7 @@
 #include "rt/db4.h"
 #include "raytrace.h"
 
+#include "./librt_private.h"
 #include "./cache.h"
 
 
@@ -497,14 +498,20 @@ _rt_gettree_leaf(struct db_tree_state *tsp, const struct db_full_path *pathp, st
     VSETALL(stp->st_min,  INFINITY);
 
     /*
-     * If prep wants to keep the internal structure, that is OK, as
-     * long as idb_ptr is set to null.  Note that the prep routine may
-     * have changed st_id.
+     * Rigidly transformed instances of solids with an expensive prep
+     * share a single prep done in object space, see instance.cpp.
+     *
+     * Otherwise, if prep wants to keep the internal structure, that
+     * is OK, as long as idb_ptr is set to null.  Note that the prep
+     * routine may have changed st_id.
      */
-    if (rtip->rti_dbip->dbi_version > 4) {
-	ret = rt_cache_prep(data->cache, stp, ip);
-    } else {
-	ret = rt_obj_prep(stp, ip, stp->st_rtip);
+    ret = rt_inst_prep(stp, ip, (rtip->rti_dbip->dbi_version > 4) ? data->cache : NULL, tsp->ts_resp);
+    if (ret > 0) {
+	if (rtip->rti_dbip->dbi_version > 4) {
+	    ret = rt_cache_prep(data->cache, stp, ip);
+	} else {
+	    ret = rt_obj_prep(stp, ip, stp->st_rtip);
+	}
     }
     if (ret) {
 	int hash;
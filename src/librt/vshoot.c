@@ -21,8 +21,18 @@
 /** @{ */
 /** @file librt/vshoot.c
  *
- * EXPERIMENTAL vector version of the Ray Tracing program shot
- * coordinator.
+ * Vector version of the Ray Tracing program shot coordinator.
+ *
+ * A batch of rays is intersected with the model a packet of
+ * consecutive rays at a time.  The solids a packet may hit are found
+ * by walking the space partitioning tree (or the scene HLBVH) with the
+ * box around the packet's rays, and are then taken one primitive type
+ * at a time.  Each solid is bounding-box tested against the rays of
+ * the packet, and the surviving ray/solid pairs are handed to the
+ * type's ft_vshot routine in groups, or to ft_shot one pair at a time
+ * for types without a complete vectorized routine.  The resulting
+ * segments are then woven and evaluated ray by ray exactly as in
+ * rt_shootray().
  *
  */
 
@@ -30,15 +40,82 @@
 
 #include <stdio.h>
 #include <math.h>
+#include <string.h>
 #include "vmath.h"
 #include "raytrace.h"
+#include "librt_private.h"
+#include "./cut_hlbvh.h"
+
+
+#define BACKING_DIST (-2.0)		/* mm to look behind start point */
+
+/* ray/solid pairs handed to a vshot routine at once */
+#define VSHOOT_NPAIRS 256
+
+/* rays handed to rt_bot_shot_packet() at once */
+#define VSHOOT_BOT_PACKET 8
+
+/* consecutive rays culled against the model together */
+#define VSHOOT_PACKET 64
+
+#define VSHOOT_STACK_SIZE 256
+
+
+struct vshoot_state {
+    struct application *ap;	/* array of nrays applications */
+    size_t nrays;
+    struct resource *resp;
+
+    /* rays as structure-of-arrays for bounding box tests */
+    fastf_t *pt[3];
+    fastf_t *inv_dir[3];
+    fastf_t *end;		/* a_ray_length, or INFINITY */
+    int *flat;			/* ray has a zero direction component */
+    int *inbox;			/* ray enters the model RPP before end */
+    int *live;			/* inbox, or there are infinite solids */
+    int *pass;			/* ray enters the current solid's RPP */
+
+    /* solids the current packet may hit */
+    struct bu_ptbl cands;
+    struct bu_bitv *marks;	/* by st_bit, solids in cands */
+
+    struct seg *waiting;	/* per-ray segs awaiting rt_boolweave() */
+
+    /* pending ray/solid pairs */
+    int npairs;
+    struct soltab *stp[VSHOOT_NPAIRS];
+    struct xray *rp[VSHOOT_NPAIRS];
+    struct seg *seg;
+    size_t ray[VSHOOT_NPAIRS];
+};
 
 
 /**
- * Stub function which will "simulate" a call to a vector shot routine
+ * Primitive types whose ft_vshot routine returns exactly what ft_shot
+ * does.  Vector routines can only return one segment per ray/solid
+ * pair, and several of the older ones lag behind fixes made to their
+ * scalar counterparts, so everything else goes through ft_shot.
  */
-static void
-vshot_stub(struct soltab **stp, struct xray **rp, struct seg *segp, int n, struct application *ap)
+static int
+vshot_complete(int id)
+{
+    switch (id) {
+	case ID_ARB8:
+	case ID_ELL:
+	case ID_SPH:
+	    return 1;
+	default:
+	    return 0;
+    }
+}
+
+
+/**
+ * Stub function which will "simulate" a call to a vector shot
+ * routine.  Only the first segment of each pair is returned.
+ */
+void
+rt_vstub(struct soltab *stp[], struct xray *rp[], struct seg segp[], int n, struct application *ap)
 /* An array of solid pointers */
 /* An array of ray pointers */
 /* array of segs (results returned) */
@@ -58,8 +135,8 @@ vshot_stub(struct soltab **stp, struct xray **rp, struct seg *segp, int n, struc
 	    /* skip call if solid table pointer is NULL */
 	    /* do scalar call, place results in segp array */
 	    ret = -1;
-	    if (OBJ[stp[i]->st_id].ft_shot) {
-		ret = OBJ[stp[i]->st_id].ft_shot(stp[i], rp[i], ap, &seghead);
+	    if (stp[i]->st_meth->ft_shot) {
+		ret = stp[i]->st_meth->ft_shot(stp[i], rp[i], ap, &seghead);
 	    }
 	    if (ret <= 0) {
 		segp[i].seg_stp=(struct soltab *) 0;
@@ -69,309 +146,611 @@ vshot_stub(struct soltab **stp, struct xray **rp, struct seg *segp, int n, struc
 		segp[i] = *tmp_seg; /* structure copy */
 		RT_FREE_SEG(tmp_seg, ap->a_resource);
 	    }
+	    RT_FREE_SEG_LIST(&seghead, ap->a_resource);
 	}
     }
 }
 
 
 /**
- * Given a ray, shoot it at all the relevant parts of the model,
- * (building the HeadSeg chain), and then call rt_boolregions() to
- * build and evaluate the partition chain.  If the ray actually hit
- * anything, call the application's a_hit() routine with a pointer to
- * the partition chain, otherwise, call the application's a_miss()
- * routine.
- *
- * It is important to note that rays extend infinitely only in the
- * positive direction.  The ray is composed of all points P, where
- *
- * P = r_pt + K * r_dir
- *
- * for K ranging from 0 to +infinity.  There is no looking backwards.
- *
- * It is also important to note that the direction vector r_dir must
- * have unit length; this is mandatory, and is not ordinarily checked,
- * in the name of efficiency.
- *
- * Input:  Pointer to an application structure, with these mandatory fields:
- * a_ray.r_pt Starting point of ray to be fired
- * a_ray.r_dir UNIT VECTOR with direction to fire in (dir cosines)
- * a_hit Routine to call when something is hit
- * a_miss Routine to call when ray misses everything
- *
- * Calls user's a_miss() or a_hit() routine as appropriate.  Passes
- * a_hit() routine list of partitions, with only hit_dist fields
- * valid.  Normal computation deferred to user code, to avoid needless
- * computation here.
- *
- * Returns: whatever the application function returns (an int).
- *
- * NOTE: The application functions may call rt_shootray() recursively.
- * Thus, none of the local variables may be static.
- *
- * An open issue for execution in a PARALLEL environment is locking of
- * the statistics variables.
+ * Intersect all pending ray/solid pairs, all sharing the same method
+ * table, and add the resulting segments to their rays' waiting lists.
  */
-int
-rt_vshootray(struct application *ap)
+static void
+vshoot_flush(struct vshoot_state *vs)
 {
-    struct seg *HeadSeg;
-    int ret;
-    vect_t inv_dir;	/* inverses of ap->a_ray.r_dir */
-    struct bu_bitv *solidbits;	/* bits for all solids shot so far */
-    struct bu_ptbl *regionbits;	/* bits for all involved regions */
-    char *status;
-    struct partition InitialPart;	/* Head of Initial Partitions */
-    struct partition FinalPart;	/* Head of Final Partitions */
-    int nrays = 1;			/* for now */
-    int vlen;
-    int id;
+    struct resource *resp = vs->resp;
+    const struct rt_functab *meth;
+    struct seg *s2;
     int i;
-    struct soltab **ary_stp;	/* array of pointers */
-    struct xray **ary_rp;	/* array of pointers */
-    struct seg *ary_seg;	/* array of structures */
-    struct rt_i *rtip;
-    int done;
 
-#define BACKING_DIST (-2.0)		/* mm to look behind start point */
-    rtip = ap->a_rt_i;
-    RT_AP_CHECK(ap);
-    if (!ap->a_resource) {
-	ap->a_resource = &rt_uniresource;
+    if (vs->npairs <= 0)
+	return;
+
+    resp->re_shots += vs->npairs;
+
+    /* Instanced solids carry their own method table and st_specific
+     * layout, so only solids using the type's own table can go to its
+     * ft_vshot.
+     */
+    meth = vs->stp[0]->st_meth;
+    if (meth == &OBJ[ID_BOT]) {
+	/* BoTs keep every segment, so go to the packet shot directly
+	 * rather than through the first-segment-only ft_vshot.  Pairs
+	 * for one solid are consecutive.
+	 */
+	struct xray *rays[VSHOOT_BOT_PACKET];
+	struct seg seghead[VSHOOT_BOT_PACKET];
+	int ret[VSHOOT_BOT_PACKET];
+	int run, j;
+
+	for (i = 0; i < vs->npairs; i += run) {
+	    for (run = 1; run < VSHOOT_BOT_PACKET && i + run < vs->npairs; run++) {
+		if (vs->stp[i + run] != vs->stp[i])
+		    break;
+	    }
+	    for (j = 0; j < run; j++) {
+		rays[j] = vs->rp[i + j];
+		BU_LIST_INIT(&(seghead[j].l));
+	    }
+
+	    rt_bot_shot_packet(vs->stp[i], rays, run, &vs->ap[vs->ray[i]], seghead, ret);
+
+	    for (j = 0; j < run; j++) {
+		struct application *ap = &vs->ap[vs->ray[i + j]];
+
+		if (ret[j] <= 0) {
+		    resp->re_shot_miss++;
+		    RT_FREE_SEG_LIST(&seghead[j], resp);
+		    continue;
+		}
+		while (BU_LIST_WHILE(s2, seg, &(seghead[j].l))) {
+		    BU_LIST_DEQUEUE(&(s2->l));
+		    s2->seg_in.hit_rayp = s2->seg_out.hit_rayp = &ap->a_ray;
+		    BU_LIST_INSERT(&(vs->waiting[vs->ray[i + j]].l), &(s2->l));
+		}
+		resp->re_shot_hit++;
+	    }
+	}
+    } else if (meth == &OBJ[vs->stp[0]->st_id] && meth->ft_vshot && vshot_complete(vs->stp[0]->st_id)) {
+	meth->ft_vshot(vs->stp, vs->rp, vs->seg, vs->npairs, vs->ap);
+
+	for (i = 0; i < vs->npairs; i++) {
+	    struct application *ap = &vs->ap[vs->ray[i]];
+
+	    if (vs->seg[i].seg_stp == SOLTAB_NULL) {
+		resp->re_shot_miss++;
+		continue;
+	    }
+	    RT_GET_SEG(s2, resp);
+	    s2->seg_stp = vs->seg[i].seg_stp;
+	    s2->seg_in = vs->seg[i].seg_in;
+	    s2->seg_out = vs->seg[i].seg_out;
+	    s2->seg_in.hit_magic = s2->seg_out.hit_magic = RT_HIT_MAGIC;
+	    s2->seg_in.hit_rayp = s2->seg_out.hit_rayp = &ap->a_ray;
+	    BU_LIST_INSERT(&(vs->waiting[vs->ray[i]].l), &(s2->l));
+	    resp->re_shot_hit++;
+	}
+    } else {
+	for (i = 0; i < vs->npairs; i++) {
+	    struct application *ap = &vs->ap[vs->ray[i]];
+	    struct seg new_segs;	/* from solid intersections */
+	    int ret = -1;
+
+	    BU_LIST_INIT(&(new_segs.l));
+	    if (vs->stp[i]->st_meth->ft_shot)
+		ret = vs->stp[i]->st_meth->ft_shot(vs->stp[i], vs->rp[i], ap, &new_segs);
+	    if (ret <= 0) {
+		resp->re_shot_miss++;
+		RT_FREE_SEG_LIST(&new_segs, resp);
+		continue;
+	    }
+	    while (BU_LIST_WHILE(s2, seg, &(new_segs.l))) {
+		BU_LIST_DEQUEUE(&(s2->l));
+		s2->seg_in.hit_rayp = s2->seg_out.hit_rayp = &ap->a_ray;
+		BU_LIST_INSERT(&(vs->waiting[vs->ray[i]].l), &(s2->l));
+	    }
+	    resp->re_shot_hit++;
+	}
     }
-    RT_CK_RESOURCE(ap->a_resource);
 
-    if (RT_G_DEBUG&(RT_DEBUG_ALLRAYS|RT_DEBUG_SHOOT|RT_DEBUG_PARTITION)) {
-	bu_log("\n**********mshootray cpu=%d  %d, %d lvl=%d (%s)\n",
-	       ap->a_resource->re_cpu,
-	       ap->a_x, ap->a_y,
-	       ap->a_level,
-	       ap->a_purpose != (char *)0 ? ap->a_purpose : "?");
-	VPRINT("Pnt", ap->a_ray.r_pt);
-	VPRINT("Dir", ap->a_ray.r_dir);
+    vs->npairs = 0;
+}
+
+
+/**
+ * Slab test of ray r against an RPP for rays parallel to one or more
+ * axes, where the branch-free test in vshoot_solid() would multiply
+ * zero by the infinite inverse direction.  Parallel axes are handled
+ * as in rt_in_rpp().
+ */
+static int
+vshoot_flat_rpp(const struct vshoot_state *vs, size_t r, const fastf_t *min, const fastf_t *max)
+{
+    fastf_t t_near = -INFINITY;
+    fastf_t t_far = INFINITY;
+    int axis;
+
+    for (axis = X; axis <= Z; axis++) {
+	fastf_t lo, hi;
+
+	if (ZERO(vs->ap[r].a_ray.r_dir[axis])) {
+	    if (vs->pt[axis][r] < min[axis] || vs->pt[axis][r] > max[axis])
+		return 0;
+	    continue;
+	}
+	lo = (min[axis] - vs->pt[axis][r]) * vs->inv_dir[axis][r];
+	hi = (max[axis] - vs->pt[axis][r]) * vs->inv_dir[axis][r];
+	t_near = FMAX(t_near, FMIN(lo, hi));
+	t_far = FMIN(t_far, FMAX(lo, hi));
     }
 
-    rtip->rti_nrays++;
-    if (rtip->needprep)
-	rt_prep(rtip);
+    return t_near <= t_far && t_far >= BACKING_DIST && t_near <= vs->end[r];
+}
 
-    /* Allocate dynamic memory */
-    vlen = nrays * rtip->rti_maxsol_by_type;
-    ary_stp = (struct soltab **)bu_calloc(vlen, sizeof(struct soltab *),
-					  "*ary_stp[]");
-    ary_rp = (struct xray **)bu_calloc(vlen, sizeof(struct xray *),
-				       "*ary_rp[]");
-    ary_seg = (struct seg *)bu_calloc(vlen, sizeof(struct seg),
-				      "ary_seg[]");
 
-    /**** for each ray, do this ****/
+/**
+ * Pair a solid with every live ray of the packet r0..r1 that passes
+ * through its bounding RPP before the end of the ray.
+ */
+static void
+vshoot_solid(struct vshoot_state *vs, struct soltab *stp, size_t r0, size_t r1)
+{
+    size_t r;
 
-    InitialPart.pt_forw = InitialPart.pt_back = &InitialPart;
-    FinalPart.pt_forw = FinalPart.pt_back = &FinalPart;
+    if (stp->st_meth->ft_use_rpp) {
+	const fastf_t min[3] = {stp->st_min[X], stp->st_min[Y], stp->st_min[Z]};
+	const fastf_t max[3] = {stp->st_max[X], stp->st_max[Y], stp->st_max[Z]};
 
-    HeadSeg = RT_SEG_NULL;
+	/* slab test against all rays, branch-free */
+	for (r = r0; r < r1; r++) {
+	    fastf_t lo, hi, t_near, t_far;
 
-    solidbits = rt_get_solidbitv(rtip->nsolids, ap->a_resource);
+	    lo = (min[X] - vs->pt[X][r]) * vs->inv_dir[X][r];
+	    hi = (max[X] - vs->pt[X][r]) * vs->inv_dir[X][r];
+	    t_near = FMIN(lo, hi);
+	    t_far = FMAX(lo, hi);
 
-    if (BU_LIST_IS_EMPTY(&ap->a_resource->re_region_ptbl)) {
-	BU_ALLOC(regionbits, struct bu_ptbl);
-	bu_ptbl_init(regionbits, 7, "rt_shootray() regionbits ptbl");
-    } else {
-	regionbits = BU_LIST_FIRST(bu_ptbl, &ap->a_resource->re_region_ptbl);
-	BU_LIST_DEQUEUE(&regionbits->l);
-	BU_CK_PTBL(regionbits);
-    }
+	    lo = (min[Y] - vs->pt[Y][r]) * vs->inv_dir[Y][r];
+	    hi = (max[Y] - vs->pt[Y][r]) * vs->inv_dir[Y][r];
+	    t_near = FMAX(t_near, FMIN(lo, hi));
+	    t_far = FMIN(t_far, FMAX(lo, hi));
 
-    /* Compute the inverse of the direction cosines */
-    if (!ZERO(ap->a_ray.r_dir[X])) {
-	inv_dir[X]=1.0/ap->a_ray.r_dir[X];
-    } else {
-	inv_dir[X] = INFINITY;
-	ap->a_ray.r_dir[X] = 0.0;
-    }
-    if (!ZERO(ap->a_ray.r_dir[Y])) {
-	inv_dir[Y]=1.0/ap->a_ray.r_dir[Y];
+	    lo = (min[Z] - vs->pt[Z][r]) * vs->inv_dir[Z][r];
+	    hi = (max[Z] - vs->pt[Z][r]) * vs->inv_dir[Z][r];
+	    t_near = FMAX(t_near, FMIN(lo, hi));
+	    t_far = FMIN(t_far, FMAX(lo, hi));
+
+	    vs->pass[r] = vs->live[r] & (t_near <= t_far) & (t_far >= BACKING_DIST) & (t_near <= vs->end[r]);
+	}
+
+	/* redo the rays where that could have been NaN */
+	for (r = r0; r < r1; r++) {
+	    if (UNLIKELY(vs->flat[r]))
+		vs->pass[r] = vs->live[r] && vshoot_flat_rpp(vs, r, min, max);
+	}
     } else {
-	inv_dir[Y] = INFINITY;
-	ap->a_ray.r_dir[Y] = 0.0;
+	for (r = r0; r < r1; r++)
+	    vs->pass[r] = vs->live[r];
     }
-    if (!ZERO(ap->a_ray.r_dir[Z])) {
-	inv_dir[Z]=1.0/ap->a_ray.r_dir[Z];
-    } else {
-	inv_dir[Z] = INFINITY;
-	ap->a_ray.r_dir[Z] = 0.0;
+
+    for (r = r0; r < r1; r++) {
+	if (!vs->pass[r]) {
+	    if (vs->live[r])
+		vs->resp->re_prune_solrpp++;
+	    continue;
+	}
+	if (vs->npairs >= VSHOOT_NPAIRS || (vs->npairs > 0 && vs->stp[0]->st_meth != stp->st_meth))
+	    vshoot_flush(vs);
+
+	vs->stp[vs->npairs] = stp;
+	vs->rp[vs->npairs] = &vs->ap[r].a_ray;
+	vs->ray[vs->npairs] = r;
+	/* vshot routines only fill in some of the hit fields */
+	memset(&vs->seg[vs->npairs], 0, sizeof(struct seg));
+	BU_LIST_INIT(&(vs->seg[vs->npairs].l));
+	vs->seg[vs->npairs].seg_stp = SOLTAB_NULL;
+	vs->npairs++;
     }
+}
 
-    /*
-     * XXX handle infinite solids here, later.
-     */
 
-    /*
-     * If ray does not enter the model RPP, skip on.
-     * If ray ends exactly at the model RPP, trace it.
-     */
-    if (!rt_in_rpp(&ap->a_ray, inv_dir, rtip->mdl_min, rtip->mdl_max)  ||
-	ap->a_ray.r_max < 0.0) {
-	rtip->nmiss_model++;
-	if (ap->a_miss)
-	    ret = ap->a_miss(ap);
-	else
-	    ret = 0;
-	status = "MISS model";
-	goto out;
-    }
+static void
+vshoot_cand(struct vshoot_state *vs, struct soltab *stp)
+{
+    if (BU_BITTEST(vs->marks, stp->st_bit))
+	return;
+    BU_BITSET(vs->marks, stp->st_bit);
+    bu_ptbl_ins(&vs->cands, (long *)stp);
+}
 
-    /* For each type of solid to be shot at, assemble the vectors */
-    for (id = 1; id <= ID_MAX_SOLID; id++) {
-	register int nsol;
 
-	if ((nsol = rtip->rti_nsol_by_type[id]) <= 0) continue;
+/**
+ * Add the solids of every cell of the space partitioning tree that
+ * overlaps the box min, max to the candidates.
+ */
+static void
+vshoot_cut_cands(struct vshoot_state *vs, const union cutter *cutp, const fastf_t *min, const fastf_t *max)
+{
+    size_t i;
 
-	/* For each instance of this solid type */
-	for (i = nsol-1; i >= 0; i--) {
-	    ary_stp[i] = rtip->rti_sol_by_type[id][i];
-	    ary_rp[i] = &(ap->a_ray);	/* XXX, sb [ray] */
-	    ary_seg[i].seg_stp = SOLTAB_NULL;
-	    BU_LIST_INIT(&ary_seg[i].l);
-	}
-	/* bounding box check */
-	/* bit vector per ray check */
-	/* mark elements to be skipped with ary_stp[] = SOLTAB_NULL */
-	ap->a_rt_i->nshots += nsol;	/* later: skipped ones */
-	if (OBJ[id].ft_vshot) {
-	    OBJ[id].ft_vshot(ary_stp, ary_rp, ary_seg, nsol, ap);
+    while (cutp->cut_type == CUT_CUTNODE) {
+	if (min[cutp->cn.cn_axis] < cutp->cn.cn_point) {
+	    if (max[cutp->cn.cn_axis] >= cutp->cn.cn_point)
+		vshoot_cut_cands(vs, cutp->cn.cn_r, min, max);
+	    cutp = cutp->cn.cn_l;
 	} else {
-	    vshot_stub(ary_stp, ary_rp, ary_seg, nsol, ap);
+	    cutp = cutp->cn.cn_r;
 	}
+    }
 
+    if (cutp->cut_type != CUT_BOXNODE)
+	bu_bomb("vshoot_cut_cands: unknown cut node type\n");
 
-	/* set bits for all solids shot at for each ray */
+    for (i = 0; i < cutp->bn.bn_len; i++)
+	vshoot_cand(vs, cutp->bn.bn_list[i]);
+    for (i = 0; i < cutp->bn.bn_piecelen; i++)
+	vshoot_cand(vs, cutp->bn.bn_piecelist[i].stp);
+}
 
-	/* append resulting seg list to input for boolweave */
-	for (i = nsol-1; i >= 0; i--) {
-	    register struct seg *seg2;
 
-	    if (ary_seg[i].seg_stp == SOLTAB_NULL) {
-		/* MISS */
-		ap->a_rt_i->nmiss++;
-		continue;
+/**
+ * Add the solids of every scene HLBVH leaf that overlaps the box
+ * min, max to the candidates.
+ */
+static void
+vshoot_bvh_cands(struct vshoot_state *vs, const struct rt_i *rtip, const fastf_t *min, const fastf_t *max)
+{
+    const struct bvh_flat_node *stack_node[VSHOOT_STACK_SIZE];
+    int stack_ind = 0;
+
+    stack_node[stack_ind++] = rtip->rti_bvh_nodes;
+
+    while (stack_ind > 0) {
+	const struct bvh_flat_node *node = stack_node[--stack_ind];
+
+	if (V3RPP_DISJOINT(min, max, &node->bounds[0], &node->bounds[3]))
+	    continue;
+
+	if (node->n_primitives > 0) {
+	    long i;
+	    for (i = 0; i < node->n_primitives; i++) {
+		struct soltab *stp = rtip->rti_bvh_solids[node->data.first_prim_offset + i];
+		/* slots freed by rt_unprep() are NULL */
+		if (stp)
+		    vshoot_cand(vs, stp);
 	    }
-	    ap->a_rt_i->nhits++;
-
-	    /* For now, do it the slow way.  sb [ray] */
-	    /* MUST dup it -- all segs have to live till after a_hit() */
-	    RT_GET_SEG(seg2, ap->a_resource);
-	    *seg2 = ary_seg[i];	/* struct copy */
-	    /* rt_boolweave(seg2, &InitialPart, ap); */
-	    bu_bomb("FIXME: need to call boolweave here");
-
-	    /* Add seg chain to list of used segs awaiting reclaim */
-
-#if 0
-	    /* FIXME: need to use waiting_segs/finished_segs here in
-	     * conjunction with rt_boolweave()
-	     {
-	     register struct seg *seg3 = seg2;
-	     while (seg3->seg_next != RT_SEG_NULL)
-	     seg3 = seg3->seg_next;
-	     seg3->seg_next = HeadSeg;
-	     HeadSeg = seg2;
-	     }
-	    */
-#endif
+	    continue;
 	}
+
+	if (UNLIKELY(stack_ind + 2 > VSHOOT_STACK_SIZE))
+	    bu_bomb("Stack size exceeded in vshoot hlbvh walk");
+
+	stack_node[stack_ind++] = node->data.other_child;
+	stack_node[stack_ind++] = node + 1;
     }
+}
 
-    /*
-     * Ray has finally left known space.
-     */
-    if (InitialPart.pt_forw == &InitialPart) {
+
+static int
+vshoot_cand_cmp(const void *a, const void *b)
+{
+    const struct soltab *sa = *(const struct soltab * const *)a;
+    const struct soltab *sb = *(const struct soltab * const *)b;
+
+    if (sa->st_id != sb->st_id)
+	return (sa->st_id < sb->st_id) ? -1 : 1;
+    if (sa->st_bit != sb->st_bit)
+	return (sa->st_bit < sb->st_bit) ? -1 : 1;
+    return 0;
+}
+
+
+/**
+ * Intersect the rays r0..r1 with the solids in the cells their
+ * segments inside the model RPP pass through, one primitive type at a
+ * time.
+ */
+static void
+vshoot_packet(struct vshoot_state *vs, struct rt_i *rtip, size_t r0, size_t r1)
+{
+    point_t min, max;
+    struct soltab **stpp;
+    size_t r;
+    int inbox = 0;
+
+    bu_ptbl_reset(&vs->cands);
+
+    /* box around the part of each ray that can hit a finite solid */
+    VSETALL(min, INFINITY);
+    VSETALL(max, -INFINITY);
+    for (r = r0; r < r1; r++) {
+	const struct xray *rp = &vs->ap[r].a_ray;
+	fastf_t lo, hi;
+	point_t p;
+
+	if (!vs->inbox[r])
+	    continue;
+	lo = FMAX(rp->r_min, BACKING_DIST);
+	hi = FMIN(rp->r_max, vs->end[r]);
+	VJOIN1(p, rp->r_pt, lo, rp->r_dir);
+	VMINMAX(min, max, p);
+	VJOIN1(p, rp->r_pt, hi, rp->r_dir);
+	VMINMAX(min, max, p);
+	inbox = 1;
+    }
+
+    if (inbox) {
+	/* cells touching the box only on a face still count */
+	vect_t tol;
+	VSETALL(tol, rtip->rti_tol.dist);
+	VSUB2(min, min, tol);
+	VADD2(max, max, tol);
+	if (rtip->rti_bvh_nodes)
+	    vshoot_bvh_cands(vs, rtip, min, max);
+	else
+	    vshoot_cut_cands(vs, &rtip->rti_CutHead, min, max);
+    }
+
+    for (r = 0; r < rtip->rti_inf_box.bn.bn_len; r++)
+	vshoot_cand(vs, rtip->rti_inf_box.bn.bn_list[r]);
+
+    if (BU_PTBL_LEN(&vs->cands) > 1)
+	qsort(vs->cands.buffer, BU_PTBL_LEN(&vs->cands), sizeof(long *), vshoot_cand_cmp);
+
+    for (BU_PTBL_FOR(stpp, (struct soltab **), &vs->cands)) {
+	vshoot_solid(vs, *stpp, r0, r1);
+	BU_BITCLR(vs->marks, (*stpp)->st_bit);
+    }
+    vshoot_flush(vs);
+}
+
+
+/**
+ * Weave and evaluate the segments of one ray of the batch, then call
+ * its a_hit() or a_miss() routine.  Returns 1 on a hit.
+ */
+static int
+vshoot_finish(struct vshoot_state *vs, size_t r, struct bu_ptbl *regionbits, struct bu_bitv *solidbits)
+{
+    struct application *ap = &vs->ap[r];
+    struct resource *resp = vs->resp;
+    struct seg finished_segs;	/* processed by rt_boolweave() */
+    struct partition InitialPart;	/* Head of Initial Partitions */
+    struct partition FinalPart;	/* Head of Final Partitions */
+    const char *status;
+    int hit = 0;
+
+    InitialPart.pt_forw = InitialPart.pt_back = &InitialPart;
+    InitialPart.pt_magic = PT_HD_MAGIC;
+    FinalPart.pt_forw = FinalPart.pt_back = &FinalPart;
+    FinalPart.pt_magic = PT_HD_MAGIC;
+    ap->a_Final_Part_hdp = &FinalPart;
+
+    BU_LIST_INIT(&finished_segs.l);
+    ap->a_finished_segs_hdp = &finished_segs;
+
+    bu_ptbl_reset(regionbits);
+
+    if (BU_LIST_NON_EMPTY(&(vs->waiting[r].l)))
+	rt_boolweave(&finished_segs, &vs->waiting[r], &InitialPart, ap);
+
+    if (BU_LIST_IS_EMPTY(&(finished_segs.l))) {
+	if (!vs->live[r])
+	    resp->re_nmiss_model++;
 	if (ap->a_miss)
-	    ret = ap->a_miss(ap);
+	    ap->a_return = ap->a_miss(ap);
 	else
-	    ret = 0;
-	status = "MISSed all primitives";
-	goto freeup;
+	    ap->a_return = 0;
+	status = "MISS primitives";
+	goto out;
     }
 
     /*
      * All intersections of the ray with the model have been computed.
      * Evaluate the boolean trees over each partition.
      */
-    done = rt_boolfinal(&InitialPart, &FinalPart, BACKING_DIST, INFINITY, regionbits, ap, solidbits);
-
-    if (done > 0) goto hitit;
+    (void)rt_boolfinal(&InitialPart, &FinalPart, BACKING_DIST, INFINITY,
+		       regionbits, ap, solidbits);
 
     if (FinalPart.pt_forw == &FinalPart) {
 	if (ap->a_miss)
-	    ret = ap->a_miss(ap);
+	    ap->a_return = ap->a_miss(ap);
 	else
-	    ret = 0;
+	    ap->a_return = 0;
 	status = "MISS bool";
-	goto freeup;
+	RT_FREE_PT_LIST(&InitialPart, resp);
+	RT_FREE_SEG_LIST(&finished_segs, resp);
+	goto out;
     }
 
-    /*
-     * Ray/model intersections exist.  Pass the list to the user's
-     * a_hit() routine.  Note that only the hit_dist elements of
-     * pt_inhit and pt_outhit have been computed yet.  To compute both
-     * hit_point and hit_normal, use the
-     *
-     * RT_HIT_NORMAL(NULL, hitp, stp, rayp, 0);
-     *
-     * macro.  To compute just hit_point, use
-     *
-     * VJOIN1(hitp->hit_point, rp->r_pt, hitp->hit_dist, rp->r_dir);
-     */
-hitit:
-    if (RT_G_DEBUG&RT_DEBUG_SHOOT) rt_pr_partitions(rtip, &FinalPart, "a_hit()");
+    /* Ray/model intersections exist */
+    if (RT_G_DEBUG&RT_DEBUG_SHOOT) rt_pr_partitions(ap->a_rt_i, &FinalPart, "a_hit()");
 
-    if (ap->a_hit)
-	ret = ap->a_hit(ap, &FinalPart, HeadSeg/* &finished_segs */);
-    else
-	ret = 0;
-    status = "HIT";
+    RT_FREE_PT_LIST(&InitialPart, resp);
 
-    /*
-     * Processing of this ray is complete.  Free dynamic resources.
-     */
-freeup:
-    {
-	register struct partition *pp;
-
-	/* Free up initial partition list */
-	for (pp = InitialPart.pt_forw; pp != &InitialPart;) {
-	    register struct partition *newpp;
-	    newpp = pp;
-	    pp = pp->pt_forw;
-	    FREE_PT(newpp, ap->a_resource);
-	}
-	/* Free up final partition list */
-	for (pp = FinalPart.pt_forw; pp != &FinalPart;) {
-	    register struct partition *newpp;
-	    newpp = pp;
-	    pp = pp->pt_forw;
-	    FREE_PT(newpp, ap->a_resource);
-	}
+    if (ap->a_hit) {
+	ap->a_return = ap->a_hit(ap, &FinalPart, &finished_segs);
+	status = "HIT";
+    } else {
+	ap->a_return = 0;
+	status = "MISS (unexpected)";
     }
+    hit = 1;
 
-out:
-    bu_free((char *)ary_stp, "*ary_stp[]");
-    bu_free((char *)ary_rp, "*ary_rp[]");
-    bu_free((char *)ary_seg, "ary_seg[]");
+    RT_FREE_SEG_LIST(&finished_segs, resp);
+    RT_FREE_PT_LIST(&FinalPart, resp);
 
-    if (solidbits != NULL) {
-	bu_bitv_free(solidbits);
-    }
+out:
     if (RT_G_DEBUG&(RT_DEBUG_ALLRAYS|RT_DEBUG_SHOOT|RT_DEBUG_PARTITION)) {
-	bu_log("----------mshootray cpu=%d  %d, %d lvl=%d (%s) %s ret=%d\n",
-	       ap->a_resource->re_cpu,
+	bu_log("----------vshootray cpu=%d  %d, %d lvl=%d (%s) %s ret=%d\n",
+	       resp->re_cpu,
 	       ap->a_x, ap->a_y,
 	       ap->a_level,
 	       ap->a_purpose != (char *)0 ? ap->a_purpose : "?",
-	       status, ret);
+	       status, ap->a_return);
+    }
+    return hit;
+}
+
+
+int
+rt_vshootray(struct application *ap, size_t nrays)
+{
+    struct vshoot_state vs;
+    struct rt_i *rtip;
+    struct resource *resp;
+    struct bu_bitv *solidbits;	/* bits for all solids shot so far */
+    struct bu_ptbl *regionbits;	/* table of all involved regions */
+    int has_infinite;
+    int nhits = 0;
+    size_t r;
+    int axis;
+
+    if (nrays == 0)
+	return 0;
+
+    RT_AP_CHECK(ap);
+    rtip = ap->a_rt_i;
+    RT_CK_RTI(rtip);
+    if (ap->a_resource == RESOURCE_NULL)
+	ap->a_resource = &rt_uniresource;
+    resp = ap->a_resource;
+    RT_CK_RESOURCE(resp);
+
+    if (rtip->needprep)
+	rt_prep_parallel(rtip, 1);	/* Stay on our CPU */
+
+    memset(&vs, 0, sizeof(vs));
+    vs.ap = ap;
+    vs.nrays = nrays;
+    vs.resp = resp;
+    for (axis = X; axis <= Z; axis++) {
+	vs.pt[axis] = (fastf_t *)bu_malloc(nrays * sizeof(fastf_t), "vshoot pt");
+	vs.inv_dir[axis] = (fastf_t *)bu_malloc(nrays * sizeof(fastf_t), "vshoot inv_dir");
+    }
+    vs.end = (fastf_t *)bu_malloc(nrays * sizeof(fastf_t), "vshoot end");
+    vs.flat = (int *)bu_malloc(nrays * sizeof(int), "vshoot flat");
+    vs.inbox = (int *)bu_malloc(nrays * sizeof(int), "vshoot inbox");
+    vs.live = (int *)bu_malloc(nrays * sizeof(int), "vshoot live");
+    vs.pass = (int *)bu_malloc(nrays * sizeof(int), "vshoot pass");
+    vs.waiting = (struct seg *)bu_malloc(nrays * sizeof(struct seg), "vshoot waiting");
+    vs.seg = (struct seg *)bu_calloc(VSHOOT_NPAIRS, sizeof(struct seg), "vshoot seg");
+    bu_ptbl_init(&vs.cands, 64, "vshoot cands");
+    vs.marks = bu_bitv_new(rtip->nsolids);
+
+    /* rays that miss the model RPP may still hit infinite solids */
+    has_infinite = rtip->rti_inf_box.bn.bn_len > 0;
+
+    for (r = 0; r < nrays; r++) {
+	struct application *rap = &ap[r];
+
+	RT_AP_CHECK(rap);
+	if (rap->a_magic) {
+	    RT_CK_AP(rap);
+	} else {
+	    rap->a_magic = RT_AP_MAGIC;
+	}
+	if (rap->a_ray.magic) {
+	    RT_CK_RAY(&(rap->a_ray));
+	} else {
+	    rap->a_ray.magic = RT_RAY_MAGIC;
+	}
+	if (rap->a_rt_i != rtip)
+	    bu_bomb("rt_vshootray: applications of a batch must share a_rt_i\n");
+	if (rap->a_resource == RESOURCE_NULL)
+	    rap->a_resource = resp;
+	if (rap->a_resource != resp)
+	    bu_bomb("rt_vshootray: applications of a batch must share a_resource\n");
+
+	if (RT_G_DEBUG&(RT_DEBUG_ALLRAYS|RT_DEBUG_SHOOT|RT_DEBUG_PARTITION)) {
+	    bu_log("\n**********vshootray cpu=%d  %d, %d lvl=%d (%s)\n",
+		   resp->re_cpu,
+		   rap->a_x, rap->a_y,
+		   rap->a_level,
+		   rap->a_purpose != (char *)0 ? rap->a_purpose : "?");
+	    VPRINT("Pnt", rap->a_ray.r_pt);
+	    VPRINT("Dir", rap->a_ray.r_dir);
+	}
+
+	resp->re_nshootray++;
+
+	/* Compute the inverse of the direction cosines */
+	vs.flat[r] = 0;
+	for (axis = X; axis <= Z; axis++) {
+	    if (rap->a_ray.r_dir[axis] < -SQRT_SMALL_FASTF || rap->a_ray.r_dir[axis] > SQRT_SMALL_FASTF) {
+		rap->a_inv_dir[axis] = 1.0/rap->a_ray.r_dir[axis];
+	    } else {
+		rap->a_ray.r_dir[axis] = 0.0;
+		rap->a_inv_dir[axis] = INFINITY;
+		vs.flat[r] = 1;
+	    }
+	    vs.pt[axis][r] = rap->a_ray.r_pt[axis];
+	    vs.inv_dir[axis][r] = rap->a_inv_dir[axis];
+	}
+
+	/* Solids starting beyond a_ray_length are not shot, as
+	 * rt_shootray() stops advancing through cells there */
+	vs.end[r] = (rap->a_ray_length > 0.0) ? rap->a_ray_length : INFINITY;
+
+	/*
+	 * If ray does not enter the model RPP, skip on.
+	 * If ray ends exactly at the model RPP, trace it.
+	 */
+	vs.inbox[r] = rt_in_rpp(&rap->a_ray, rap->a_inv_dir, rtip->mdl_min, rtip->mdl_max)
+	    && rap->a_ray.r_max >= 0.0
+	    && FMAX(rap->a_ray.r_min, BACKING_DIST) <= vs.end[r];
+	vs.live[r] = vs.inbox[r] || has_infinite;
+
+	BU_LIST_INIT(&(vs.waiting[r].l));
+    }
+
+    /* Cull and shoot the batch a packet at a time */
+    for (r = 0; r < nrays; r += VSHOOT_PACKET)
+	vshoot_packet(&vs, rtip, r, (r + VSHOOT_PACKET < nrays) ? r + VSHOOT_PACKET : nrays);
+
+    /*
+     * Every solid has been considered for every ray, either shot or
+     * culled as out of its way, so all of them count as shot during
+     * boolean evaluation.
+     */
+    solidbits = rt_get_solidbitv(rtip->nsolids, resp);
+    for (r = 0; r < rtip->nsolids; r++)
+	BU_BITSET(solidbits, r);
+
+    if (BU_LIST_IS_EMPTY(&resp->re_region_ptbl)) {
+	BU_ALLOC(regionbits, struct bu_ptbl);
+	bu_ptbl_init(regionbits, 7, "rt_vshootray() regionbits ptbl");
+    } else {
+	regionbits = BU_LIST_FIRST(bu_ptbl, &resp->re_region_ptbl);
+	BU_LIST_DEQUEUE(&regionbits->l);
+	BU_CK_PTBL(regionbits);
+    }
+
+    for (r = 0; r < nrays; r++)
+	nhits += vshoot_finish(&vs, r, regionbits, solidbits);
+
+    /* Return dynamic resources to their freelists.  */
+    BU_CK_BITV(solidbits);
+    BU_LIST_APPEND(&resp->re_solid_bitv, &solidbits->l);
+    BU_CK_PTBL(regionbits);
+    BU_LIST_APPEND(&resp->re_region_ptbl, &regionbits->l);
+
+    for (axis = X; axis <= Z; axis++) {
+	bu_free(vs.pt[axis], "vshoot pt");
+	bu_free(vs.inv_dir[axis], "vshoot inv_dir");
     }
-    return ret;
+    bu_free(vs.end, "vshoot end");
+    bu_free(vs.flat, "vshoot flat");
+    bu_free(vs.inbox, "vshoot inbox");
+    bu_free(vs.live, "vshoot live");
+    bu_free(vs.pass, "vshoot pass");
+    bu_free(vs.waiting, "vshoot waiting");
+    bu_free(vs.seg, "vshoot seg");
+    bu_ptbl_free(&vs.cands);
+    bu_bitv_free(vs.marks);
+
+    return nhits;
 }
 
 
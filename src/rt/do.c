@@ -510,6 +510,7 @@ struct bu_structparse set_parse[] = {
     {"%f",	1, "angle",			bu_byteoffset(rt_perspective),		BU_STRUCTPARSE_FUNC_NULL, NULL, NULL },
     {"%d",	1, "rt_bot_minpieces", bu_byteoffset(rt_bot_minpieces_deprecated),	parse_deprecated, NULL, NULL },
     {"%f",	1, "rt_cline_radius", 0 /* must be set manually since from lib */, 	BU_STRUCTPARSE_FUNC_NULL, NULL, NULL },
+    {"%d",	1, "vshoot",			bu_byteoffset(vshoot_batch),		BU_STRUCTPARSE_FUNC_NULL, NULL, NULL },
     /* daisy-chain to additional app-specific parameters */
     {"%p",	1, "Application-Specific Parameters", bu_byteoffset(view_parse[0]),	BU_STRUCTPARSE_FUNC_NULL, NULL, NULL },
     {"",	0, (char *)0,		0,						BU_STRUCTPARSE_FUNC_NULL, NULL, NULL }
@@ -775,8 +776,8 @@ do_prep(struct rt_i *rtip)
     memory_summary();
     if (rt_verbosity & VERBOSE_STATS) {
 	bu_log("%s: %zu cut, %zu box (%zu empty)\n",
-	       rtip->rti_space_partition == RT_PART_NUBSPT ?
-	       "NUBSP" : "unknown",
+	       rtip->rti_space_partition == RT_PART_NUBSPT ? "NUBSP" :
+	       rtip->rti_space_partition == RT_PART_HLBVH ? "HLBVH" : "unknown",
 	       rtip->rti_ncut_by_type[CUT_CUTNODE],
 	       rtip->rti_ncut_by_type[CUT_BOXNODE],
 	       rtip->nempty_cells);
@@ -1076,6 +1077,7 @@ do_frame(int framenumber)
      * Compute the image
      * It may prove desirable to do this in chunks
      */
+    worker_stats_reset();
     rt_prep_timer();
 
 #ifdef USE_OPENCL
@@ -1174,6 +1176,8 @@ do_frame(int framenumber)
 	       framenumber,
 	       rtip->rti_nrays,
 	       wallclock, ((double)(rtip->rti_nrays))/wallclock);
+	if ((size_t)npsw > 1 && !random_mode)
+	    worker_stats_print(framenumber);
     }
     if (bif != NULL) {
 	icv_write(bif, framename, BU_MIME_IMAGE_AUTO);
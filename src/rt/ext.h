@@ -183,6 +183,11 @@ extern void clt_run(int cur_pixel, int last_pixel);
 #endif
 
 
+/* worker.c */
+extern int vshoot_batch;		/* primary rays per rt_vshootray() call */
+extern void worker_stats_reset(void);
+extern void worker_stats_print(int framenumber);
+
 /* opt.c */
 extern int get_args(int argc, const char *argv[]);
 extern void color_hook(const struct bu_structparse *sp, const char *name, void *base, const char *value, void *data);
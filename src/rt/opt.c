@@ -169,8 +169,9 @@ char *framebuffer = NULL;       /* desired framebuffer */
 
 /**
  * space partitioning algorithm to use.  previously had experimental
- * grid support, but now only uses a Non-uniform Binary Spatial
- * Partitioning (BSP) tree.
+ * grid support, but now uses either a Non-uniform Binary Spatial
+ * Partitioning (BSP) tree (RT_PART_NUBSPT, the default) or a
+ * bounding volume hierarchy over all primitives (RT_PART_HLBVH).
  */
 int space_partition = RT_PART_NUBSPT;
 
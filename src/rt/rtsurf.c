@@ -38,6 +38,17 @@
  * or solid segments to estimate volume.  Here, we're using the first
  * and last hit points to estimate exterior surface area.
  *
+ * With -q, the sphere points come from a 4D Sobol sequence instead
+ * (one pair of sphere points per sequence entry), shifted by a set of
+ * independent random offsets.  Each shifted copy is a separate
+ * quasi-Monte Carlo estimate, so the spread between them gives an
+ * honest error bound that shrinks faster than random sampling does.
+ * Iterations continue the sequence rather than start over, so every
+ * ray shot so far stays in the estimate, and the next iteration is
+ * sized from the current error instead of a fixed growth factor.  The
+ * threshold is then the 95% confidence error in percent, and with -r
+ * every region over 1% of the total area must meet it as well.
+ *
  * = Examples =
  *
  * # Calculate area within 0.1% convergence (after 3+ iterations):
@@ -53,6 +64,9 @@
  * rtsurf -n 1000 -o file.g object > file.mged
  * mged -c file.g source file.mged
  *
+ * # Quasi-Monte Carlo sampling to within 0.1% error (95% confidence):
+ * rtsurf -q -t 0.1 file.g object
+ *
  * # Areas per exterior material encountered, output saved to file:
  * rtsurf -m density.txt file.g object
  *
@@ -105,6 +119,7 @@
 #include "bu/getopt.h"
 #include "bu/assert.h"
 #include "bu/parallel.h"
+#include "bn/sobol.h"
 #include "raytrace.h"
 #include "analyze.h"
 
@@ -120,6 +135,7 @@ struct options
     int makeGeometry; /** whether to write out geometry script to stdout */
     int printRegions; /** whether to print the full list of regions */
     int printGroups;  /** whether to print the full list of regions */
+    int qmc;          /** whether to sample with a Sobol sequence */
 };
 
 
@@ -135,6 +151,28 @@ struct region_callback_data {
 };
 
 
+/* randomly shifted copies of the Sobol sequence used with -q.  their
+ * spread is our error estimate, so we want enough of them for a
+ * usable standard deviation.
+ */
+#define RTSURF_QMC_SETS 16
+
+/* regions smaller than this fraction of the total area are reported
+ * but not required to converge.
+ */
+#define RTSURF_QMC_MIN_REGION 0.01
+
+/* 95% confidence */
+#define RTSURF_QMC_Z 1.96
+
+
+struct qmc_state {
+    struct bn_soboldata *sobol;
+    double shift[RTSURF_QMC_SETS][4];
+    size_t sethits[RTSURF_QMC_SETS];  /** hit pairs per set */
+};
+
+
 struct material_callback_data {
     struct analyze_densities *densities;
     double samples;
@@ -165,7 +203,7 @@ hit(struct application *ap, struct partition *PartHeadp, struct seg *UNUSED(segs
 
     /* in hit point */
     struct partition *pp=PartHeadp->pt_forw;
-    rtsurf_register_hit(context, pp->pt_regionp->reg_name, pp->pt_regionp->reg_gmater); // in-hit
+    rtsurf_register_set_hit(context, pp->pt_regionp->reg_name, pp->pt_regionp->reg_gmater, (size_t)ap->a_x); // in-hit
     hitp = pp->pt_inhit;
     VJOIN1(pt, ap->a_ray.r_pt, hitp->hit_dist, ap->a_ray.r_dir);
     stp = pp->pt_inseg->seg_stp;
@@ -185,7 +223,7 @@ hit(struct application *ap, struct partition *PartHeadp, struct seg *UNUSED(segs
 
     /* out hit point */
     struct partition *pprev=PartHeadp->pt_back;
-    rtsurf_register_hit(context, pprev->pt_regionp->reg_name, pprev->pt_regionp->reg_gmater); // out-hit
+    rtsurf_register_set_hit(context, pprev->pt_regionp->reg_name, pprev->pt_regionp->reg_gmater, (size_t)ap->a_x); // out-hit
 
     hitp = pprev->pt_outhit;
     VJOIN1(pt, ap->a_ray.r_pt, hitp->hit_dist, ap->a_ray.r_dir);
@@ -308,16 +346,23 @@ random_double(void) {
 }
 
 
+/* map (u, v) in [0, 1) x [0, 1) uniformly onto the sphere */
 static void
-random_point_on_sphere(double radius, point_t point) {
-    double theta = 2 * M_PI * random_double();
-    double phi = acos(2 * random_double() - 1);
+point_on_sphere(double radius, double u, double v, point_t point) {
+    double theta = 2 * M_PI * u;
+    double phi = acos(2 * v - 1);
     point[0] = radius * sin(phi) * cos(theta);
     point[1] = radius * sin(phi) * sin(theta);
     point[2] = radius * cos(phi);
 }
 
 
+static void
+random_point_on_sphere(double radius, point_t point) {
+    point_on_sphere(radius, random_double(), random_double(), point);
+}
+
+
 static void
 points_on_sphere(size_t count, point_t pnts[], double radius, point_t center)
 {
@@ -378,6 +423,79 @@ rays_through_point_pairs(struct ray *rays, size_t count, point_t pnts[])
 }
 
 
+static void
+qmc_init(struct qmc_state *qmc)
+{
+    qmc->sobol = bn_sobol_create(4, 0);
+    if (!qmc->sobol)
+	bu_exit(EXIT_FAILURE, "ERROR: unable to initialize Sobol sequence\n");
+
+    for (size_t j = 0; j < RTSURF_QMC_SETS; ++j) {
+	for (size_t d = 0; d < 4; ++d)
+	    qmc->shift[j][d] = random_double();
+	qmc->sethits[j] = 0;
+    }
+}
+
+
+/* generate count rays for every set from the next count entries of
+ * the Sobol sequence.  rays are interleaved so ray i is in set i %
+ * RTSURF_QMC_SETS.
+ */
+static void
+qmc_rays(struct qmc_state *qmc, struct ray *rays, size_t count, double radius, point_t center)
+{
+    for (size_t i = 0; i < count; ++i) {
+	const double *s = bn_sobol_next(qmc->sobol, NULL, NULL);
+
+	for (size_t j = 0; j < RTSURF_QMC_SETS; ++j) {
+	    double u[4];
+	    point_t p1, p2;
+	    struct ray *r = &rays[i * RTSURF_QMC_SETS + j];
+
+	    /* Cranley-Patterson rotation, keeps the sequence's spacing */
+	    for (size_t d = 0; d < 4; ++d) {
+		u[d] = s[d] + qmc->shift[j][d];
+		if (u[d] >= 1.0)
+		    u[d] -= 1.0;
+	    }
+
+	    point_on_sphere(radius, u[0], u[1], p1);
+	    point_on_sphere(radius, u[2], u[3], p2);
+	    VADD2(r->r_pt, p1, center);
+	    VSUB2(r->r_dir, p2, p1);
+	}
+    }
+}
+
+
+/* relative error (in percent, at 95% confidence) of the mean of the
+ * per-set estimates.  all sets have shot the same number of rays, so
+ * their hit counts are proportional to their area estimates.
+ */
+static double
+qmc_error(const size_t *sethits, size_t sets)
+{
+    double mean = 0.0;
+    double var = 0.0;
+
+    if (sets < 2)
+	return INFINITY;
+
+    for (size_t j = 0; j < sets; ++j)
+	mean += (double)sethits[j];
+    mean /= (double)sets;
+    if (mean <= 0.0)
+	return INFINITY;
+
+    for (size_t j = 0; j < sets; ++j)
+	var += ((double)sethits[j] - mean) * ((double)sethits[j] - mean);
+    var /= (double)(sets - 1);
+
+    return RTSURF_QMC_Z * sqrt(var / (double)sets) / mean * 100.0;
+}
+
+
 // Function to compute surface area using the Cauchy-Crofton formula
 static double
 compute_surface_area(int intersections, int lines, double radius)
@@ -409,6 +527,7 @@ struct rtsurf_shootray_data {
     double hitrad;
     int makeGeometry;
     size_t *hitpairs;
+    size_t *sethits;
 };
 
 
@@ -421,9 +540,13 @@ sample_in_parallel(int id, void *data)
     double hitrad = pdata->hitrad;
     int makeGeometry = pdata->makeGeometry;
     size_t *hitpairs = pdata->hitpairs;
+    size_t *sethits = pdata->sethits;
 
     // keep track of this iteration
     for (size_t i = pdata->start; i < pdata->end; ++i) {
+	/* tell hit() which sample set this ray belongs to */
+	ap->a_x = sethits ? (int)(i % RTSURF_QMC_SETS) : 0;
+
 	/* can't struct copy because our ray is smaller than xray */
 	VMOVE(ap->a_ray.r_pt, rays[i].r_pt);
 	VMOVE(ap->a_ray.r_dir, rays[i].r_dir);
@@ -443,13 +566,15 @@ sample_in_parallel(int id, void *data)
 
 	bu_semaphore_acquire(BU_SEM_GENERAL);
 	*hitpairs += hitit;
+	if (sethits)
+	    sethits[i % RTSURF_QMC_SETS] += hitit;
 	bu_semaphore_release(BU_SEM_GENERAL);
     }
 }
 
 
 static void
-do_samples_in_parallel(struct application *ap, size_t samples, struct ray *rays, double radius, struct options *opts, size_t *hitpairs)
+do_samples_in_parallel(struct application *ap, size_t samples, struct ray *rays, double radius, struct options *opts, size_t *hitpairs, size_t *sethits)
 {
     double hitrad = ((radius / 256.0) > 1.0) ? radius / 256.0 : 1.0;
     int makeGeometry = opts->makeGeometry;
@@ -471,6 +596,7 @@ do_samples_in_parallel(struct application *ap, size_t samples, struct ray *rays,
         pdata[i].hitrad = hitrad;
         pdata[i].makeGeometry = makeGeometry;
         pdata[i].hitpairs = hitpairs;
+        pdata[i].sethits = sethits;
     }
 
     // Execute in parallel
@@ -484,23 +610,30 @@ do_samples_in_parallel(struct application *ap, size_t samples, struct ray *rays,
 }
 
 
+/* shoot one set of samples.  with qmc, samples must be a multiple of
+ * RTSURF_QMC_SETS and rays continue the qmc sequence.
+ */
 static size_t
-do_one_iteration(struct application *ap, size_t samples, point_t center, double radius, struct options *opts)
+do_one_iteration(struct application *ap, size_t samples, point_t center, double radius, struct options *opts, struct qmc_state *qmc)
 {
     int makeGeometry = opts->makeGeometry;
 
-    /* get sample points */
-    point_t *points = (point_t *)bu_calloc(samples, sizeof(point_t), "points");
-    points_on_sphere(samples, points, radius, center);
-
     struct ray *rays = (struct ray *)bu_calloc(samples, sizeof(struct ray), "rays");
 
-    /* use the sample points twice to generate our set of sample rays */
-    rays_through_point_pairs(rays, samples, points);
-    rays_through_point_pairs(rays+(samples/2), samples, points);
+    if (qmc) {
+	qmc_rays(qmc, rays, samples / RTSURF_QMC_SETS, radius, center);
+    } else {
+	/* get sample points */
+	point_t *points = (point_t *)bu_calloc(samples, sizeof(point_t), "points");
+	points_on_sphere(samples, points, radius, center);
 
-    /* done with points, loaded into rays */
-    bu_free(points, "points");
+	/* use the sample points twice to generate our set of sample rays */
+	rays_through_point_pairs(rays, samples, points);
+	rays_through_point_pairs(rays+(samples/2), samples, points);
+
+	/* done with points, loaded into rays */
+	bu_free(points, "points");
+    }
 
     // FIXME: for uniquely naming our hit spheres, but makes this not
     // threadsafe or isolated.
@@ -508,7 +641,7 @@ do_one_iteration(struct application *ap, size_t samples, point_t center, double
 
     // DO IT.
     size_t hitpairs = 0;
-    do_samples_in_parallel(ap, samples, rays, radius, opts, &hitpairs);
+    do_samples_in_parallel(ap, samples, rays, radius, opts, &hitpairs, qmc ? qmc->sethits : NULL);
     total_hitpairs += hitpairs;
 
     /* group them all for performance */
@@ -545,6 +678,50 @@ do_one_iteration(struct application *ap, size_t samples, point_t center, double
 }
 
 
+/* group the per-iteration geometry groups */
+static void
+print_iteration_groups(size_t iterations)
+{
+    struct bu_vls pntvp = BU_VLS_INIT_ZERO;
+    struct bu_vls dirvp = BU_VLS_INIT_ZERO;
+    struct bu_vls hitvp = BU_VLS_INIT_ZERO;
+    bu_vls_printf(&pntvp, "g pnts");
+    bu_vls_printf(&dirvp, "g dirs");
+    bu_vls_printf(&hitvp, "g hits");
+    for (size_t i = 0; i < iterations; ++i) {
+	bu_vls_printf(&pntvp, " pnts.%zu", i);
+	bu_vls_printf(&dirvp, " dirs.%zu", i);
+	bu_vls_printf(&hitvp, " hits.%zu", i);
+    }
+    printf("%s\nZ\n", bu_vls_cstr(&pntvp));
+    printf("%s\nZ\n", bu_vls_cstr(&dirvp));
+    printf("%s\nZ\n", bu_vls_cstr(&hitvp));
+    bu_vls_printf(&pntvp, "r pnts.r u pnts");
+    bu_vls_printf(&dirvp, "r dirs.r u dirs");
+    bu_vls_printf(&hitvp, "r hits.r u hits");
+    bu_vls_free(&pntvp);
+    bu_vls_free(&dirvp);
+    bu_vls_free(&hitvp);
+}
+
+
+static void
+print_geometry_preamble(point_t center, double radius, struct options *opts)
+{
+    /* set to mm so working units match */
+    if (opts->makeGeometry)
+	printf("units mm\n");
+
+    bu_log("Radius: %g\n", radius);
+    //VPRINT("Center:", center);
+
+    if (opts->makeGeometry) {
+	printf("in center.sph sph %lf %lf %lf %lf\nZ\n", V3ARGS(center), 5.0);
+	printf("in bounding.sph sph %lf %lf %lf %lf\nZ\n", V3ARGS(center), radius);
+    }
+}
+
+
 static double
 do_iterations(struct application *ap, point_t center, double radius, struct options *opts)
 {
@@ -562,17 +739,7 @@ do_iterations(struct application *ap, point_t center, double radius, struct opti
     /* do exact count requested or start at 1000 and iterate */
     size_t curr_samples = (opts->samples > 0) ? (size_t)opts->samples : 1000;
 
-    /* set to mm so working units match */
-    if (opts->makeGeometry)
-	printf("units mm\n");
-
-    bu_log("Radius: %g\n", radius);
-    //VPRINT("Center:", center);
-
-    if (opts->makeGeometry) {
-	printf("in center.sph sph %lf %lf %lf %lf\nZ\n", V3ARGS(center), 5.0);
-	printf("in bounding.sph sph %lf %lf %lf %lf\nZ\n", V3ARGS(center), radius);
-    }
+    print_geometry_preamble(center, radius, opts);
 
     /* run the loop assessment */
     do {
@@ -589,7 +756,7 @@ do_iterations(struct application *ap, point_t center, double radius, struct opti
 	 * count includes both the in-hit and the out-hit separately.
 	 */
 	ap->a_dist = (fastf_t)iteration;
-	size_t hits = do_one_iteration(ap, curr_samples, center, radius, opts);
+	size_t hits = do_one_iteration(ap, curr_samples, center, radius, opts, NULL);
 	total_samples += curr_samples;
 	total_hits += hits;
 
@@ -610,29 +777,105 @@ do_iterations(struct application *ap, point_t center, double radius, struct opti
     } while (threshold > 0 && (curr_percent > threshold || prev_percent > threshold));
 
     /* if we're printing, group all iterations too */
-    if (opts->makeGeometry) {
-	struct bu_vls pntvp = BU_VLS_INIT_ZERO;
-	struct bu_vls dirvp = BU_VLS_INIT_ZERO;
-	struct bu_vls hitvp = BU_VLS_INIT_ZERO;
-	bu_vls_printf(&pntvp, "g pnts");
-	bu_vls_printf(&dirvp, "g dirs");
-	bu_vls_printf(&hitvp, "g hits");
-	for (size_t i = 0; i < iteration; ++i) {
-	    bu_vls_printf(&pntvp, " pnts.%zu", i);
-	    bu_vls_printf(&dirvp, " dirs.%zu", i);
-	    bu_vls_printf(&hitvp, " hits.%zu", i);
+    if (opts->makeGeometry)
+	print_iteration_groups(iteration);
+
+    return curr_estimate;
+}
+
+
+struct region_error_data {
+    size_t total_hits;  /** in + out hits over all regions */
+    double worst;       /** largest error of a region required to converge */
+};
+
+
+static void
+region_error_callback(const char *UNUSED(name), const size_t *sethits, size_t sets, size_t UNUSED(lines), void *data)
+{
+    struct region_error_data *edata = (struct region_error_data *)data;
+    size_t hits = 0;
+
+    for (size_t j = 0; j < sets; ++j)
+	hits += sethits[j];
+
+    if ((double)hits < RTSURF_QMC_MIN_REGION * (double)edata->total_hits)
+	return;
+
+    double err = qmc_error(sethits, sets);
+    if (err > edata->worst)
+	edata->worst = err;
+}
+
+
+static double
+do_qmc_iterations(struct application *ap, point_t center, double radius, struct options *opts)
+{
+    struct qmc_state qmc;
+    double curr_estimate = 0.0;
+    double threshold = opts->threshold; // convergence threshold (% error)
+    size_t iteration = 0;
+
+    size_t total_samples = 0;
+    size_t total_hits = 0;
+
+    /* do exact count requested or start at 1000, rounded up so every set shoots the same rays */
+    size_t curr_samples = (opts->samples > 0) ? (size_t)opts->samples : 1000;
+    size_t curr_points = (curr_samples + RTSURF_QMC_SETS - 1) / RTSURF_QMC_SETS;
+
+    qmc_init(&qmc);
+    rtsurf_context_sets(ap->a_uptr, RTSURF_QMC_SETS);
+
+    print_geometry_preamble(center, radius, opts);
+
+    while (1) {
+	curr_samples = curr_points * RTSURF_QMC_SETS;
+
+	ap->a_dist = (fastf_t)iteration;
+	size_t hits = do_one_iteration(ap, curr_samples, center, radius, opts, &qmc);
+	total_samples += curr_samples;
+	total_hits += hits;
+	iteration++;
+
+	curr_estimate = compute_surface_area(total_hits, (double)total_samples, radius);
+	double error = qmc_error(qmc.sethits, RTSURF_QMC_SETS);
+	bu_log("Cauchy-Crofton Surface Area Estimate: (%zu hits / %zu lines) = %g mm^2 (+/- %g%%)\n", total_hits, total_samples, curr_estimate, error);
+
+	if (threshold <= 0 || total_hits == 0)
+	    break;
+
+	/* with -r, regions must converge too */
+	double worst = error;
+	if (opts->printRegions) {
+	    struct region_error_data edata = {total_hits, 0.0};
+	    rtsurf_iterate_region_sets(ap->a_uptr, &region_error_callback, &edata);
+	    if (edata.worst > worst)
+		worst = edata.worst;
 	}
-	printf("%s\nZ\n", bu_vls_cstr(&pntvp));
-	printf("%s\nZ\n", bu_vls_cstr(&dirvp));
-	printf("%s\nZ\n", bu_vls_cstr(&hitvp));
-	bu_vls_printf(&pntvp, "r pnts.r u pnts");
-	bu_vls_printf(&dirvp, "r dirs.r u dirs");
-	bu_vls_printf(&hitvp, "r hits.r u hits");
-	bu_vls_free(&pntvp);
-	bu_vls_free(&dirvp);
-	bu_vls_free(&hitvp);
+
+	/* need two iterations so the first error estimate gets a check */
+	if (iteration > 1 && worst <= threshold)
+	    break;
+
+	if (opts->samples > 0)
+	    continue; // do what we're told
+
+	/* error falls at least as 1/sqrt(n), so size the next
+	 * iteration to reach the threshold, but within reason.
+	 */
+	double growth = (worst / threshold) * (worst / threshold);
+	if (!(growth <= 4.0))
+	    growth = 4.0;
+	if (growth < 1.25)
+	    growth = 1.25;
+	curr_points = (size_t)((double)(total_samples / RTSURF_QMC_SETS) * (growth - 1.0)) + 1;
     }
 
+    if (opts->makeGeometry)
+	print_iteration_groups(iteration);
+
+    bn_sobol_destroy(qmc.sobol);
+
     return curr_estimate;
 }
 
@@ -649,6 +892,22 @@ regions_callback(const char *name, size_t hits, size_t lines, void* data)
 }
 
 
+static void
+region_sets_callback(const char *name, const size_t *sethits, size_t sets, size_t lines, void* data)
+{
+    struct region_callback_data *rdata = (struct region_callback_data *)data;
+    BU_ASSERT(rdata);
+
+    size_t hits = 0;
+    for (size_t j = 0; j < sets; ++j)
+	hits += sethits[j];
+
+    double area = compute_surface_area(hits, lines, rdata->radius);
+
+    bu_log("\t%s\t(%zu hits / %zu lines) = %.1lf mm^2 (+/- %.2g%%)\n", name, hits, lines, area, qmc_error(sethits, sets));
+}
+
+
 static void
 materials_callback(int id, size_t hits, size_t lines, void* data)
 {
@@ -691,13 +950,20 @@ estimate_surface_area(const char *db, const char *obj[], struct options *opts)
     VADD2SCALE(center, ap.a_rt_i->mdl_max, ap.a_rt_i->mdl_min, 0.5);
 
     /* iterate until we converge on a solution */
-    double area = do_iterations(&ap, center, radius, opts);
+    double area;
+    if (opts->qmc)
+	area = do_qmc_iterations(&ap, center, radius, opts);
+    else
+	area = do_iterations(&ap, center, radius, opts);
 
     if (opts->printRegions) {
 	/* print out all regions */
 	bu_log("Area Estimate By Region:\n");
 	struct region_callback_data rdata = {opts->samples, radius};
-	rtsurf_iterate_regions(context, &regions_callback, &rdata);
+	if (opts->qmc)
+	    rtsurf_iterate_region_sets(context, &region_sets_callback, &rdata);
+	else
+	    rtsurf_iterate_regions(context, &regions_callback, &rdata);
     }
 
     if (opts->printGroups) {
@@ -740,7 +1006,7 @@ estimate_surface_area(const char *db, const char *obj[], struct options *opts)
 static void
 get_options(int argc, char *argv[], struct options *opts)
 {
-    static const char *usage = "Usage: %s [-g] [-r] [-n #samples] [-t %%threshold] [-m density.txt] [-o] model.g objects...\n";
+    static const char *usage = "Usage: %s [-g] [-r] [-q] [-n #samples] [-t %%threshold] [-m density.txt] [-o] model.g objects...\n";
 
     const char *argv0 = argv[0];
     const char *db = NULL;
@@ -756,7 +1022,7 @@ get_options(int argc, char *argv[], struct options *opts)
     bu_optind = 1;
 
     int c;
-    while ((c = bu_getopt(argc, (char * const *)argv, "grcn:t:m:oh?")) != -1) {
+    while ((c = bu_getopt(argc, (char * const *)argv, "grcqn:t:m:oh?")) != -1) {
 	if (bu_optopt == '?')
 	    c = 'h';
 
@@ -773,6 +1039,10 @@ get_options(int argc, char *argv[], struct options *opts)
 		if (opts)
 		    opts->printRegions = 1;
 		break;
+	    case 'q':
+		if (opts)
+		    opts->qmc = 1;
+		break;
 	    case 't':
 		if (opts)
 		    opts->threshold = (double)strtod(bu_optarg, NULL);
@@ -804,6 +1074,8 @@ get_options(int argc, char *argv[], struct options *opts)
 
     bu_log("Samples: %zd %s\n", opts->samples, opts->samples>0?"rays":"(until converges)");
     bu_log("Threshold: %g %s\n", opts->threshold, opts->threshold>0.0?"%":"(one iteration)");
+    if (opts->qmc)
+	bu_log("Sampling: quasi-Monte Carlo (%d Sobol sets)\n", RTSURF_QMC_SETS);
 
     argv += bu_optind;
 
@@ -830,6 +1102,7 @@ main(int argc, char *argv[])
     opts.makeGeometry = 0;
     opts.printRegions = 0;
     opts.printGroups = 0;
+    opts.qmc = 0;
     opts.radius = 0.0;
 
     char *db = NULL;
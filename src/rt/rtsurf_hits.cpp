@@ -39,6 +39,8 @@ class HitCounterContext
 public:
     std::map<std::string, size_t> regionHitCounters;
     std::map<int, size_t> materialHitCounters;
+    std::map<std::string, std::vector<size_t>> regionSetHitCounters;
+    size_t setCount;
     size_t lineCount;
     std::mutex hitCounterMutex;
 };
@@ -65,10 +67,21 @@ rtsurf_context_reset(void* context)
     std::lock_guard<std::mutex> lock(ctx->hitCounterMutex);
     ctx->regionHitCounters.clear();
     ctx->materialHitCounters.clear();
+    ctx->regionSetHitCounters.clear();
     ctx->lineCount = 0;
 }
 
 
+void
+rtsurf_context_sets(void* context, size_t sets)
+{
+    auto* ctx = static_cast<HitCounterContext*>(context);
+    std::lock_guard<std::mutex> lock(ctx->hitCounterMutex);
+    ctx->regionSetHitCounters.clear();
+    ctx->setCount = sets;
+}
+
+
 void
 rtsurf_register_hit(void* context, const char *region, int materialId)
 {
@@ -79,6 +92,22 @@ rtsurf_register_hit(void* context, const char *region, int materialId)
 }
 
 
+void
+rtsurf_register_set_hit(void* context, const char *region, int materialId, size_t set)
+{
+    auto* ctx = static_cast<HitCounterContext*>(context);
+    std::lock_guard<std::mutex> lock(ctx->hitCounterMutex);
+    ctx->regionHitCounters[region]++;
+    ctx->materialHitCounters[materialId]++;
+    if (set < ctx->setCount) {
+	std::vector<size_t> &setHits = ctx->regionSetHitCounters[region];
+	if (setHits.empty())
+	    setHits.resize(ctx->setCount, 0);
+	setHits[set]++;
+    }
+}
+
+
 void
 rtsurf_register_line(void* context) {
     auto* ctx = static_cast<HitCounterContext*>(context);
@@ -116,6 +145,17 @@ rtsurf_iterate_regions(void* context, void (*callback)(const char *region, size_
 }
 
 
+void
+rtsurf_iterate_region_sets(void* context, void (*callback)(const char *region, const size_t *setHits, size_t sets, size_t lines, void* data), void* data)
+{
+    auto* ctx = static_cast<HitCounterContext*>(context);
+    std::lock_guard<std::mutex> lock(ctx->hitCounterMutex);
+    for (const auto& pair : ctx->regionSetHitCounters) {
+        callback(pair.first.c_str(), pair.second.data(), pair.second.size(), ctx->lineCount, data);
+    }
+}
+
+
 void
 rtsurf_iterate_materials(void* context, void (*callback)(int materialId, size_t hits, size_t lines, void* data), void* data)
 {
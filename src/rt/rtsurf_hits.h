@@ -63,6 +63,22 @@ void
 rtsurf_register_hit(void* context, const char *region, int materialId);
 
 
+/**
+ * track region hits separately for each of 'sets' independent sample
+ * sets, in addition to the overall counters.  0 disables tracking.
+ */
+void
+rtsurf_context_sets(void* context, size_t sets);
+
+
+/**
+ * count a hit on a given region of a specified material, made by a
+ * shotline from sample set 'set'.
+ */
+void
+rtsurf_register_set_hit(void* context, const char *region, int materialId, size_t set);
+
+
 /**
  * count a shotline sampled
  */
@@ -88,6 +104,14 @@ void
 rtsurf_iterate_regions(void* context, void (*callback)(const char *region, size_t hits, size_t lines, void* data), void* data);
 
 
+/**
+ * iterate over all registered region IDs, with the hit counts from
+ * each sample set.  lines is the shotline count over all sets.
+ */
+void
+rtsurf_iterate_region_sets(void* context, void (*callback)(const char *region, const size_t *setHits, size_t sets, size_t lines, void* data), void* data);
+
+
 /**
  * iterate over all registered material IDs
  */
@@ -1408,18 +1408,22 @@ reproject_worker(int UNUSED(cpu), void *UNUSED(arg))
     int pixelnum;
     struct floatpixel *ip;
     int count = 0;
+    int chunk = per_processor_chunk;
 
-    /* The more CPUs at work, the bigger the bites we take */
-    if (per_processor_chunk <= 0) per_processor_chunk = npsw;
+    /* The more CPUs at work, the bigger the bites we take.  Don't
+     * store this back into per_processor_chunk, worker() would then
+     * treat it as a request for fixed pixel spans.
+     */
+    if (chunk <= 0) chunk = npsw;
 
     while (1) {
 
 	bu_semaphore_acquire(RT_SEM_WORKER);
 	pixel_start = cur_pixel;
-	cur_pixel += per_processor_chunk;
+	cur_pixel += chunk;
 	bu_semaphore_release(RT_SEM_WORKER);
 
-	for (pixelnum = pixel_start; pixelnum < pixel_start+per_processor_chunk; pixelnum++) {
+	for (pixelnum = pixel_start; pixelnum < pixel_start+chunk; pixelnum++) {
 	    point_t new_view_pt;
 	    size_t ix, iy;
 
@@ -1553,15 +1557,13 @@ view_2init(struct application *ap, char *UNUSED(framename))
 	buf_mode = BUFMODE_ACC;
     } else if (width <= 96 || random_mode) {
 	buf_mode = BUFMODE_UNBUF;
-    } else if ((size_t)npsw <= (size_t)height/4) {
-	/* Have each CPU do a whole scanline.  Saves lots of semaphore
-	 * overhead.  For load balancing make sure each CPU has
-	 * several lines to do.
+    } else {
+	/* Scanlines are shared between the tiles worker() hands out
+	 * and steals, so stores into them have to be interlocked.
+	 * BUFMODE_SCANLINE, which needs whole scanlines per CPU via
+	 * per_processor_chunk, would turn the tiling and the stealing
+	 * off and leave the last few CPUs with all the expensive lines.
 	 */
-	per_processor_chunk = width;
-	buf_mode = BUFMODE_SCANLINE;
-    }
-    else {
 	buf_mode = BUFMODE_DYNAMIC;
     }
 #endif
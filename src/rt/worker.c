@@ -31,6 +31,7 @@
 #include <math.h>
 
 #include "bu/log.h"
+#include "bu/time.h"
 #include "vmath.h"
 #include "bn.h"
 #include "raytrace.h"
@@ -65,6 +66,10 @@ extern int query_debug;
 extern unsigned char *pixmap;	/* pixmap for rerendering of black pixels */
 
 int per_processor_chunk = 0;	/* how many pixels to do at once */
+int vshoot_batch = 0;		/* primary rays per rt_vshootray() call, 0 = off */
+
+/* upper limit on vshoot_batch */
+#define VSHOOT_BATCH_MAX 1024
 
 int fullfloat_mode = 0;
 int reproject_mode = 0;
@@ -451,65 +456,425 @@ do_pixel(int cpu, int pat_num, int pixelnum)
 }
 
 
+/**
+ * Batched primary rays are only used when do_pixel() would fire
+ * exactly one ray per pixel and has nothing else to do for it.
+ */
+static int
+pixel_batch_ok(void)
+{
+    return vshoot_batch > 1
+	&& !hypersample && !stereo
+	&& !incr_mode && !fullfloat_mode && !sub_grid_mode
+	&& !Query_one_pixel && !pixmap && lightmodel != 8
+	&& !APP.a_rt_i->rti_prismtrace;
+}
+
+
+/**
+ * Batched version of do_pixel() for the plain one ray per pixel case.
+ * The primary rays of the given pixels are shot together with
+ * rt_vshootray(), which calls a_hit()/a_miss() for each of them in
+ * order, and the pixels are then handed to view_pixel() in order.
+ */
+static void
+do_pixel_batch(int cpu, struct application *apps, const int *pixelnum, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+	struct application *a = &apps[i];
+	vect_t point;
+
+	*a = APP;			/* struct copy */
+	a->a_resource = &resource[cpu];
+	a->a_y = (int)(pixelnum[i]/width);
+	a->a_x = (int)(pixelnum[i] - (a->a_y * width));
+	a->a_pixelext = (struct pixel_ext *)NULL;
+
+	VJOIN2(point, viewbase_model, a->a_x, dx_model, a->a_y, dy_model);
+	if (jitter & JITTER_CELL)
+	    jitter_start_pnt(point, a, 0, -1);
+
+	if (rt_perspective > 0.0) {
+	    VSUB2(a->a_ray.r_dir, point, eye_model);
+	    VUNITIZE(a->a_ray.r_dir);
+	    VMOVE(a->a_ray.r_pt, eye_model);
+	} else {
+	    VMOVE(a->a_ray.r_pt, point);
+	    VMOVE(a->a_ray.r_dir, APP.a_ray.r_dir);
+	}
+
+	a->a_level = 0;		/* recursion level */
+	a->a_purpose = "main ray";
+    }
+
+    if (report_progress) {
+	report_progress = 0;
+	bu_log("\tframe %d, xy=%d, %d on cpu %d, samp=0\n", curframe, apps[0].a_x, apps[0].a_y, cpu);
+    }
+
+    (void)rt_vshootray(apps, (size_t)n);
+
+    for (i = 0; i < n; i++) {
+	view_pixel(&apps[i]);
+	if ((size_t)apps[i].a_x == width-1) {
+	    view_eol(&apps[i]);		/* End of scan line */
+	}
+    }
+}
+
+
+/**
+ * Work is handed out to the workers as rectangular tiles.  Pixels of
+ * a tile are (y * row_width + x) for x0 <= x < x1, y0 <= y < y1,
+ * clipped to the cur_pixel..last_pixel run.  When a view module asks
+ * for fixed pixel spans via per_processor_chunk, each span is stored
+ * as a single-row tile in linear pixel numbers (y0 = 0, y1 = 1) and
+ * spans are never split.
+ */
+struct tile {
+    int x0, y0;
+    int x1, y1;
+};
+
+
+/**
+ * Per-worker double-ended queue of tiles.  The owner takes tiles from
+ * the tail and thieves take them from the head, so an owner works
+ * through its region in order while thieves take the work farthest
+ * from it.
+ */
+struct tile_deque {
+    struct tile *tiles;
+    size_t head;
+    size_t tail;
+    size_t capacity;
+};
+
+
+/**
+ * Per-worker statistics, reported by worker_stats_print()
+ */
+struct worker_stat {
+    size_t pixels;
+    size_t tiles;
+    size_t steals;
+    size_t splits;
+    int64_t busy;	/* microseconds spent computing tiles */
+};
+
+
+/* tiles are not split any smaller than this many pixels on a side */
+#define TILE_MIN_SIDE 4
+
+/* the deques are protected by a striped set of semaphores */
+#define TILE_NSEM 64
+
+static struct tile_deque tile_deques[MAX_PSW];
+static struct worker_stat worker_stats[MAX_PSW];
+static int tile_sem[TILE_NSEM] = {0};
+static char tile_sem_name[TILE_NSEM][32];
+static int tile_nslots = 0;		/* number of deques in use */
+static int tile_next_slot = 0;		/* next deque to hand to a worker */
+static int tile_row_width = 0;		/* pixel number stride of one tile row */
+static int tile_splittable = 0;		/* !0 when tiles may be split */
+
+#define TILE_SEM(slot) tile_sem[(slot) % TILE_NSEM]
+
+
+static void
+tile_push(int slot, const struct tile *t)
+{
+    struct tile_deque *dq = &tile_deques[slot];
+
+    bu_semaphore_acquire(TILE_SEM(slot));
+    if (dq->tail >= dq->capacity) {
+	/* compact out the stolen head before growing */
+	if (dq->head > 0) {
+	    memmove(dq->tiles, dq->tiles + dq->head, (dq->tail - dq->head) * sizeof(struct tile));
+	    dq->tail -= dq->head;
+	    dq->head = 0;
+	}
+	if (dq->tail >= dq->capacity) {
+	    dq->capacity = (dq->capacity) ? dq->capacity * 2 : 64;
+	    dq->tiles = (struct tile *)bu_realloc(dq->tiles, dq->capacity * sizeof(struct tile), "tile deque");
+	}
+    }
+    dq->tiles[dq->tail++] = *t;
+    bu_semaphore_release(TILE_SEM(slot));
+}
+
+
+/**
+ * Take the next tile off the tail of our own deque.  Returns 0 if the
+ * deque is empty.  *last is set when the tile taken was the last one.
+ */
+static int
+tile_pop(int slot, struct tile *t, int *last)
+{
+    struct tile_deque *dq = &tile_deques[slot];
+    int found = 0;
+
+    bu_semaphore_acquire(TILE_SEM(slot));
+    if (dq->tail > dq->head) {
+	*t = dq->tiles[--dq->tail];
+	*last = (dq->tail == dq->head);
+	found = 1;
+    }
+    bu_semaphore_release(TILE_SEM(slot));
+
+    return found;
+}
+
+
+/**
+ * Take a tile off the head of some other worker's deque.  Returns 0
+ * if there is no work left anywhere.
+ */
+static int
+tile_steal(int slot, struct tile *t)
+{
+    int i;
+
+    for (i = 1; i < tile_nslots; i++) {
+	int victim = (slot + i) % tile_nslots;
+	struct tile_deque *dq = &tile_deques[victim];
+	int found = 0;
+
+	/* unlocked peek, rechecked below */
+	if (dq->tail <= dq->head)
+	    continue;
+
+	bu_semaphore_acquire(TILE_SEM(victim));
+	if (dq->tail > dq->head) {
+	    *t = dq->tiles[dq->head++];
+	    found = 1;
+	}
+	bu_semaphore_release(TILE_SEM(victim));
+
+	if (found)
+	    return 1;
+    }
+
+    return 0;
+}
+
+
+/**
+ * Repeatedly halve a tile along its longer side down to the minimum
+ * tile size, pushing the halves we don't keep onto our own deque for
+ * idle workers to steal.  The largest pieces end up at the head of
+ * the deque where thieves look first.
+ */
+static void
+tile_split(int slot, struct tile *t)
+{
+    while (t->x1 - t->x0 > TILE_MIN_SIDE || t->y1 - t->y0 > TILE_MIN_SIDE) {
+	struct tile keep = *t;
+	struct tile give = *t;
+
+	if (t->x1 - t->x0 >= t->y1 - t->y0) {
+	    int mid = t->x0 + (t->x1 - t->x0) / 2;
+	    keep.x1 = give.x0 = mid;
+	} else {
+	    int mid = t->y0 + (t->y1 - t->y0) / 2;
+	    keep.y1 = give.y0 = mid;
+	}
+
+	if (top_down) {
+	    struct tile tmp = keep;
+	    keep = give;
+	    give = tmp;
+	}
+
+	tile_push(slot, &give);
+	worker_stats[slot].splits++;
+	*t = keep;
+    }
+}
+
+
+/**
+ * Break the cur_pixel..last_pixel run into tiles and deal contiguous
+ * runs of them out to the worker deques.
+ */
+static void
+tile_setup(int nworkers)
+{
+    struct tile *tiles;
+    size_t ntiles = 0;
+    size_t maxtiles;
+    size_t i;
+    int slot;
+    int side;
+
+    if (!tile_sem[0]) {
+	for (i = 0; i < TILE_NSEM; i++) {
+	    snprintf(tile_sem_name[i], sizeof(tile_sem_name[i]), "RT_SEM_TILE_%zu", i);
+	    tile_sem[i] = bu_semaphore_register(tile_sem_name[i]);
+	}
+    }
+
+    tile_nslots = nworkers;
+    tile_next_slot = 0;
+
+    if (incr_mode)
+	tile_row_width = 1 << incr_level;
+    else
+	tile_row_width = (int)width;
+    if (tile_row_width < 1)
+	tile_row_width = 1;
+
+    if (per_processor_chunk > 0) {
+	/* fixed spans requested (e.g., whole scanlines) */
+	tile_splittable = 0;
+	maxtiles = (last_pixel - cur_pixel) / per_processor_chunk + 1;
+	tiles = (struct tile *)bu_calloc(maxtiles, sizeof(struct tile), "tiles");
+	for (i = 0; i < maxtiles; i++) {
+	    tiles[ntiles].x0 = cur_pixel + i * per_processor_chunk;
+	    tiles[ntiles].x1 = tiles[ntiles].x0 + per_processor_chunk;
+	    tiles[ntiles].y0 = 0;
+	    tiles[ntiles].y1 = 1;
+	    ntiles++;
+	}
+    } else {
+	/* Figure out a reasonable starting tile size that should keep
+	 * most workers busy all the way to the end.  Tiles range from
+	 * 512x512 down to one pixel, sized so that each worker starts
+	 * out with at least 8 tiles.  Tiles are split further as the
+	 * deques run dry, so this mostly sets the locality and the
+	 * locking traffic early on.
+	 */
+	size_t one_eighth = (last_pixel - cur_pixel) * (hypersample + 1) / 8;
+	if (UNLIKELY(one_eighth < 1))
+	    one_eighth = 1;
+
+	side = 512;
+	while (side > 1 && one_eighth <= (size_t)nworkers * side * side)
+	    side /= 2;
+
+	int ymin = cur_pixel / tile_row_width;
+	int ymax = last_pixel / tile_row_width;
+	int ntx = (tile_row_width + side - 1) / side;
+	int nty = (ymax - ymin + 1 + side - 1) / side;
+	int tx, ty;
+
+	tile_splittable = 1;
+	maxtiles = (size_t)ntx * nty;
+	tiles = (struct tile *)bu_calloc(maxtiles, sizeof(struct tile), "tiles");
+	for (ty = 0; ty < nty; ty++) {
+	    for (tx = 0; tx < ntx; tx++) {
+		struct tile *t = &tiles[ntiles++];
+		t->x0 = tx * side;
+		t->x1 = (t->x0 + side < tile_row_width) ? t->x0 + side : tile_row_width;
+		t->y0 = ymin + ty * side;
+		t->y1 = (t->y0 + side < ymax + 1) ? t->y0 + side : ymax + 1;
+	    }
+	}
+    }
+
+    /* hand out contiguous runs, ordered so each owner pops its first
+     * tile first.  top_down simply walks the whole list backwards.
+     */
+    for (slot = 0; slot < nworkers; slot++) {
+	struct tile_deque *dq = &tile_deques[slot];
+	size_t first = ntiles * slot / nworkers;
+	size_t last = ntiles * (slot + 1) / nworkers;
+	size_t n = last - first;
+
+	dq->head = dq->tail = 0;
+	if (dq->capacity < n + 64) {
+	    dq->capacity = n + 64;
+	    dq->tiles = (struct tile *)bu_realloc(dq->tiles, dq->capacity * sizeof(struct tile), "tile deque");
+	}
+	for (i = 0; i < n; i++) {
+	    if (top_down)
+		dq->tiles[dq->tail++] = tiles[ntiles - 1 - (first + n - 1 - i)];
+	    else
+		dq->tiles[dq->tail++] = tiles[first + n - 1 - i];
+	}
+    }
+
+    bu_free(tiles, "tiles");
+}
+
+
+static void
+tile_render(int cpu, int slot, int pat_num, const struct tile *t)
+{
+    int x, y;
+    int64_t start = bu_gettime();
+    size_t npix = 0;
+    struct application *apps = NULL;
+    int *pending = NULL;
+    int npending = 0;
+    int batch = 0;
+
+    if (pixel_batch_ok()) {
+	batch = (vshoot_batch > VSHOOT_BATCH_MAX) ? VSHOOT_BATCH_MAX : vshoot_batch;
+	apps = (struct application *)bu_malloc(batch * sizeof(struct application), "batch apps");
+	pending = (int *)bu_malloc(batch * sizeof(int), "batch pixels");
+    }
+
+    for (y = (top_down) ? t->y1 - 1 : t->y0; (top_down) ? y >= t->y0 : y < t->y1; (top_down) ? y-- : y++) {
+	for (x = (top_down) ? t->x1 - 1 : t->x0; (top_down) ? x >= t->x0 : x < t->x1; (top_down) ? x-- : x++) {
+	    int pixelnum = y * tile_row_width + x;
+
+	    if (pixelnum < cur_pixel || pixelnum > last_pixel)
+		continue;
+
+	    npix++;
+	    if (batch) {
+		pending[npending++] = pixelnum;
+		if (npending == batch) {
+		    do_pixel_batch(cpu, apps, pending, npending);
+		    npending = 0;
+		}
+		continue;
+	    }
+
+	    /* bu_log("    PIXEL[%d]\n", pixelnum); */
+	    do_pixel(cpu, pat_num, pixelnum);
+	}
+
+	/* batches stay within a row of the tile for ray coherence */
+	if (npending) {
+	    do_pixel_batch(cpu, apps, pending, npending);
+	    npending = 0;
+	}
+    }
+
+    if (batch) {
+	bu_free(apps, "batch apps");
+	bu_free(pending, "batch pixels");
+    }
+
+    worker_stats[slot].pixels += npix;
+    worker_stats[slot].tiles++;
+    worker_stats[slot].busy += bu_gettime() - start;
+}
+
+
 /**
  * Compute some pixels, and store them.
  *
  * This uses a "self-dispatching" parallel algorithm.  Executes until
  * there is no more work to be done, or is told to stop.
  *
- * In order to reduce the traffic through the res_worker critical
- * section, a multiple pixel block may be removed from the work queue
- * at once.
+ * The image is cut into tiles which do_run() deals out to per-worker
+ * deques.  Each worker renders its own tiles in order and, once out
+ * of work, steals tiles from the other workers.  A worker that takes
+ * its last tile splits it first so that others can help with it,
+ * which keeps the tail end of a frame busy even when pixel costs are
+ * very uneven.
  */
 void
 worker(int cpu, void *UNUSED(arg))
 {
-    int pixel_start;
     int pixelnum;
     int pat_num = -1;
 
-    /* Figure out a reasonable chunk size that should keep most
-     * workers busy all the way to the end.  We divide up the image
-     * into chunks equating to tiles 1x1, 2x2, 4x4, 8x8 ... in size.
-     * Work is distributed so that all CPUs work on at least 8 chunks
-     * with the chunking adjusted from a maximum chunk size (512x512)
-     * all the way down to 1 pixel at a time, depending on the number
-     * of cores and the size of our rendering.
-     *
-     * TODO: actually work on image tiles instead of pixel spans.
-     */
-    if (per_processor_chunk <= 0) {
-	size_t chunk_size;
-	size_t one_eighth = (last_pixel - cur_pixel) * (hypersample + 1) / 8;
-	if (UNLIKELY(one_eighth < 1))
-	    one_eighth = 1;
-
-	if (one_eighth > (size_t)npsw * 262144)
-	    chunk_size = 262144; /* 512x512 */
-	else if (one_eighth > (size_t)npsw * 65536)
-	    chunk_size = 65536; /* 256x256 */
-	else if (one_eighth > (size_t)npsw * 16384)
-	    chunk_size = 16384; /* 128x128 */
-	else if (one_eighth > (size_t)npsw * 4096)
-	    chunk_size = 4096; /* 64x64 */
-	else if (one_eighth > (size_t)npsw * 1024)
-	    chunk_size = 1024; /* 32x32 */
-	else if (one_eighth > (size_t)npsw * 256)
-	    chunk_size = 256; /* 16x16 */
-	else if (one_eighth > (size_t)npsw * 64)
-	    chunk_size = 64; /* 8x8 */
-	else if (one_eighth > (size_t)npsw * 16)
-	    chunk_size = 16; /* 4x4 */
-	else if (one_eighth > (size_t)npsw * 4)
-	    chunk_size = 4; /* 2x2 */
-	else
-	    chunk_size = 1; /* one pixel at a time */
-
-	bu_semaphore_acquire(RT_SEM_WORKER);
-	per_processor_chunk = chunk_size;
-	bu_semaphore_release(RT_SEM_WORKER);
-    }
-
     if (cpu >= MAX_PSW) {
 	bu_log("rt/worker() cpu %d > MAX_PSW %d, array overrun\n", cpu, MAX_PSW);
 	bu_exit(EXIT_FAILURE, "rt/worker() cpu > MAX_PSW, array overrun\n");
@@ -549,39 +914,79 @@ pat_found:
 	}
 
     } else {
-	int from;
-	int to;
+	struct tile t;
+	int last;
+	int slot;
+
+	/* bu_parallel() cpu numbers aren't necessarily 0..npsw-1, so
+	 * each worker claims its own deque.
+	 */
+	bu_semaphore_acquire(RT_SEM_WORKER);
+	slot = tile_next_slot++;
+	bu_semaphore_release(RT_SEM_WORKER);
+	if (slot >= tile_nslots)
+	    return;
 
 	while (1) {
 	    if (stop_worker)
 		return;
 
-	    bu_semaphore_acquire(RT_SEM_WORKER);
-	    pixel_start = cur_pixel;
-	    cur_pixel += per_processor_chunk;
-	    bu_semaphore_release(RT_SEM_WORKER);
-
-	    if (top_down) {
-		from = last_pixel - pixel_start;
-		to = from - per_processor_chunk;
-	    } else {
-		from = pixel_start;
-		to = pixel_start + per_processor_chunk;
+	    if (!tile_pop(slot, &t, &last)) {
+		if (!tile_steal(slot, &t))
+		    return;
+		worker_stats[slot].steals++;
+		last = 1;
 	    }
 
-	    /* bu_log("SPAN[%d -> %d] for %d pixels\n", pixel_start, pixel_start+per_processor_chunk, per_processor_chunk); */
-	    for (pixelnum = from; pixelnum != to; (from < to) ? pixelnum++ : pixelnum--) {
-		if (pixelnum > last_pixel || pixelnum < 0)
-		    return;
+	    if (last && tile_splittable)
+		tile_split(slot, &t);
 
-		/* bu_log("    PIXEL[%d]\n", pixelnum); */
-		do_pixel(cpu, pat_num, pixelnum);
-	    }
+	    /* bu_log("TILE[%d,%d -> %d,%d]\n", t.x0, t.y0, t.x1, t.y1); */
+	    tile_render(cpu, slot, pat_num, &t);
 	}
     }
 }
 
 
+void
+worker_stats_reset(void)
+{
+    memset(worker_stats, 0, sizeof(worker_stats));
+}
+
+
+void
+worker_stats_print(int framenumber)
+{
+    int cpu;
+    double busy_min = INFINITY;
+    double busy_max = 0.0;
+    double busy_sum = 0.0;
+    size_t steals = 0;
+    size_t splits = 0;
+
+    for (cpu = 0; cpu < tile_nslots; cpu++) {
+	const struct worker_stat *ws = &worker_stats[cpu];
+	double busy = (double)ws->busy / 1000000.0;
+
+	bu_log("Frame %2d: CPU %3d %10zu pixels in %9.2f sec, %zu tiles (%zu stolen, %zu split)\n",
+	       framenumber, cpu, ws->pixels, busy, ws->tiles, ws->steals, ws->splits);
+
+	busy_min = FMIN(busy_min, busy);
+	busy_max = FMAX(busy_max, busy);
+	busy_sum += busy;
+	steals += ws->steals;
+	splits += ws->splits;
+    }
+
+    if (cpu > 0 && busy_max > 0.0) {
+	double busy_avg = busy_sum / cpu;
+	bu_log("Frame %2d: per-CPU busy min %.2f / avg %.2f / max %.2f sec (%.1f%% efficiency), %zu steals, %zu splits\n",
+	       framenumber, busy_min, busy_avg, busy_max, 100.0 * busy_avg / busy_max, steals, splits);
+    }
+}
+
+
 /**
  * Compute a run of pixels, in parallel if the hardware permits it.
  */
@@ -596,11 +1001,15 @@ do_run(int a, int b)
 	 * SERIAL case -- one CPU does all the work.
 	 */
 	npsw = 1;
+	if (!random_mode)
+	    tile_setup(1);
 	worker(0, NULL);
     } else {
 	/*
 	 * Parallel case.
 	 */
+	if (!random_mode)
+	    tile_setup(npsw);
 	bu_parallel(worker, (size_t)npsw, NULL);
     }
 